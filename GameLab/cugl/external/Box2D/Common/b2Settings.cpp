@@ -20,18 +20,20 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <new>
 
 b2Version b2_version = {2, 3, 2};
 
 // Memory allocators. Modify these to use your own allocator.
+// CUGL routes these through operator new so that memory tracking sees them.
 void* b2Alloc(int32 size)
 {
-	return malloc(size);
+	return ::operator new((size_t)size);
 }
 
 void b2Free(void* mem)
 {
-	free(mem);
+	::operator delete(mem);
 }
 
 // You can modify this to use your logging facility.
@@ -24,11 +24,249 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
 
+#include <string.h>
+
 // Solver debugging is normally disabled because the block solver sometimes has to deal with a poorly conditioned effective mass matrix.
 #define B2_DEBUG_SOLVER 0
 
 bool g_blockSolve = true;
 
+// The number of constraints solved together by the batched solver
+#define b2_simdWidth	4
+
+// The maximum number of colors for the batched solver (one bit each)
+#define b2_maxColors	32
+
+// The batched solver packs contacts into SIMD lanes. SSE2 and NEON both
+// have four float lanes. Other platforms use a scalar emulation that has
+// the same semantics. Masks are all ones or all zeros in each lane, except
+// in the scalar emulation where they are 1 or 0.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define B2_SIMD_SSE2 1
+typedef __m128 b2FloatW;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define B2_SIMD_NEON 1
+typedef float32x4_t b2FloatW;
+#else
+struct b2FloatW { float32 v[b2_simdWidth]; };
+#endif
+
+inline b2FloatW b2LoadW(const float32* p)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_loadu_ps(p);
+#elif defined(B2_SIMD_NEON)
+	return vld1q_f32(p);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = p[i];
+	return r;
+#endif
+}
+
+inline void b2StoreW(float32* p, b2FloatW a)
+{
+#if defined(B2_SIMD_SSE2)
+	_mm_storeu_ps(p, a);
+#elif defined(B2_SIMD_NEON)
+	vst1q_f32(p, a);
+#else
+	for (int32 i = 0; i < b2_simdWidth; ++i) p[i] = a.v[i];
+#endif
+}
+
+inline b2FloatW b2SplatW(float32 s)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_set1_ps(s);
+#elif defined(B2_SIMD_NEON)
+	return vdupq_n_f32(s);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = s;
+	return r;
+#endif
+}
+
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_add_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vaddq_f32(a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] + b.v[i];
+	return r;
+#endif
+}
+
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_sub_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vsubq_f32(a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] - b.v[i];
+	return r;
+#endif
+}
+
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_mul_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vmulq_f32(a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] * b.v[i];
+	return r;
+#endif
+}
+
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_div_ps(a, b);
+#elif defined(B2_SIMD_NEON) && defined(__aarch64__)
+	return vdivq_f32(a, b);
+#else
+	// ARMv7 NEON has no division
+	float32 x[b2_simdWidth], y[b2_simdWidth];
+	b2StoreW(x, a);
+	b2StoreW(y, b);
+	for (int32 i = 0; i < b2_simdWidth; ++i) x[i] /= y[i];
+	return b2LoadW(x);
+#endif
+}
+
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_min_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vminq_f32(a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = b2Min(a.v[i], b.v[i]);
+	return r;
+#endif
+}
+
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_max_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vmaxq_f32(a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = b2Max(a.v[i], b.v[i]);
+	return r;
+#endif
+}
+
+// Returns a mask of the lanes where a >= b
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_cmpge_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vreinterpretq_f32_u32(vcgeq_f32(a, b));
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] >= b.v[i] ? 1.0f : 0.0f;
+	return r;
+#endif
+}
+
+// Returns a mask of the lanes where a > b
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_cmpgt_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vreinterpretq_f32_u32(vcgtq_f32(a, b));
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] > b.v[i] ? 1.0f : 0.0f;
+	return r;
+#endif
+}
+
+// Returns the intersection of two masks
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_and_ps(a, b);
+#elif defined(B2_SIMD_NEON)
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = a.v[i] * b.v[i];
+	return r;
+#endif
+}
+
+// Returns a where the mask is set and b elsewhere
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+#if defined(B2_SIMD_SSE2)
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#elif defined(B2_SIMD_NEON)
+	return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#else
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) r.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+	return r;
+#endif
+}
+
+// A bundle of contact velocity constraints that share no dynamic bodies.
+// The layout is SoA: one float per lane for each value. Single point contacts
+// use a dummy second point that the block solver can never activate.
+struct b2ContactVelocityBatch
+{
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraint[b2_simdWidth];
+	float32 invMassA[b2_simdWidth], invMassB[b2_simdWidth];
+	float32 invIA[b2_simdWidth], invIB[b2_simdWidth];
+	float32 normalX[b2_simdWidth], normalY[b2_simdWidth];
+	float32 friction[b2_simdWidth];
+	float32 tangentSpeed[b2_simdWidth];
+	float32 rA1X[b2_simdWidth], rA1Y[b2_simdWidth], rB1X[b2_simdWidth], rB1Y[b2_simdWidth];
+	float32 rA2X[b2_simdWidth], rA2Y[b2_simdWidth], rB2X[b2_simdWidth], rB2Y[b2_simdWidth];
+	float32 normalMass1[b2_simdWidth], normalMass2[b2_simdWidth];
+	float32 tangentMass1[b2_simdWidth], tangentMass2[b2_simdWidth];
+	float32 velocityBias1[b2_simdWidth], velocityBias2[b2_simdWidth];
+	float32 normalImpulse1[b2_simdWidth], normalImpulse2[b2_simdWidth];
+	float32 tangentImpulse1[b2_simdWidth], tangentImpulse2[b2_simdWidth];
+	float32 K11[b2_simdWidth], K12[b2_simdWidth], K22[b2_simdWidth];
+	float32 M11[b2_simdWidth], M12[b2_simdWidth], M22[b2_simdWidth];
+};
+
+// The position constraints for the same contacts as a velocity batch.
+// The manifold is evaluated per lane, and the impulses are solved in SIMD.
+struct b2ContactPositionBatch
+{
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraint[b2_simdWidth];
+	float32 invMassA[b2_simdWidth], invMassB[b2_simdWidth];
+	float32 invIA[b2_simdWidth], invIB[b2_simdWidth];
+};
+
+// The velocity bias of a dummy contact point. It keeps the point separating
+// so that the block solver always leaves its impulse at zero.
+#define b2_dummyVelocityBias	-1.0e30f
+
+
 struct b2ContactPositionConstraint
 {
 	b2Vec2 localPoints[b2_maxManifoldPoints];
@@ -54,6 +292,11 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_positions = def->positions;
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
+	m_velocityBatches = NULL;
+	m_positionBatches = NULL;
+	m_batchCount = 0;
+	m_remainder = NULL;
+	m_remainderCount = 0;
 
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
@@ -133,6 +376,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_remainder != NULL)
+	{
+		m_allocator->Free(m_remainder);
+		m_allocator->Free(m_positionBatches);
+		m_allocator->Free(m_velocityBatches);
+	}
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -247,6 +496,11 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+	if (m_step.batchedContacts && g_blockSolve && m_remainder == NULL)
+	{
+		BuildBatches();
+	}
 }
 
 void b2ContactSolver::WarmStart()
@@ -291,31 +545,79 @@ void b2ContactSolver::WarmStart()
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
+	if (m_remainder != NULL)
+	{
+		for (int32 i = 0; i < m_batchCount; ++i)
+		{
+			SolveVelocityBatch(m_velocityBatches + i);
+		}
+
+		for (int32 i = 0; i < m_remainderCount; ++i)
+		{
+			SolveVelocityConstraint(m_velocityConstraints + m_remainder[i]);
+		}
+		return;
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
-		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		SolveVelocityConstraint(m_velocityConstraints + i);
+	}
+}
 
-		int32 indexA = vc->indexA;
-		int32 indexB = vc->indexB;
-		float32 mA = vc->invMassA;
-		float32 iA = vc->invIA;
-		float32 mB = vc->invMassB;
-		float32 iB = vc->invIB;
-		int32 pointCount = vc->pointCount;
+void b2ContactSolver::SolveVelocityConstraint(b2ContactVelocityConstraint* vc)
+{
+	int32 indexA = vc->indexA;
+	int32 indexB = vc->indexB;
+	float32 mA = vc->invMassA;
+	float32 iA = vc->invIA;
+	float32 mB = vc->invMassB;
+	float32 iB = vc->invIB;
+	int32 pointCount = vc->pointCount;
+
+	b2Vec2 vA = m_velocities[indexA].v;
+	float32 wA = m_velocities[indexA].w;
+	b2Vec2 vB = m_velocities[indexB].v;
+	float32 wB = m_velocities[indexB].w;
+
+	b2Vec2 normal = vc->normal;
+	b2Vec2 tangent = b2Cross(normal, 1.0f);
+	float32 friction = vc->friction;
+
+	b2Assert(pointCount == 1 || pointCount == 2);
+
+	// Solve tangent constraints first because non-penetration is more important
+	// than friction.
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2VelocityConstraintPoint* vcp = vc->points + j;
 
-		b2Vec2 vA = m_velocities[indexA].v;
-		float32 wA = m_velocities[indexA].w;
-		b2Vec2 vB = m_velocities[indexB].v;
-		float32 wB = m_velocities[indexB].w;
+		// Relative velocity at contact
+		b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
 
-		b2Vec2 normal = vc->normal;
-		b2Vec2 tangent = b2Cross(normal, 1.0f);
-		float32 friction = vc->friction;
+		// Compute tangent force
+		float32 vt = b2Dot(dv, tangent) - vc->tangentSpeed;
+		float32 lambda = vcp->tangentMass * (-vt);
 
-		b2Assert(pointCount == 1 || pointCount == 2);
+		// b2Clamp the accumulated force
+		float32 maxFriction = friction * vcp->normalImpulse;
+		float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
+		lambda = newImpulse - vcp->tangentImpulse;
+		vcp->tangentImpulse = newImpulse;
 
-		// Solve tangent constraints first because non-penetration is more important
-		// than friction.
+		// Apply contact impulse
+		b2Vec2 P = lambda * tangent;
+
+		vA -= mA * P;
+		wA -= iA * b2Cross(vcp->rA, P);
+
+		vB += mB * P;
+		wB += iB * b2Cross(vcp->rB, P);
+	}
+
+	// Solve normal constraints
+	if (pointCount == 1 || g_blockSolve == false)
+	{
 		for (int32 j = 0; j < pointCount; ++j)
 		{
 			b2VelocityConstraintPoint* vcp = vc->points + j;
@@ -323,286 +625,272 @@ void b2ContactSolver::SolveVelocityConstraints()
 			// Relative velocity at contact
 			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
 
-			// Compute tangent force
-			float32 vt = b2Dot(dv, tangent) - vc->tangentSpeed;
-			float32 lambda = vcp->tangentMass * (-vt);
+			// Compute normal impulse
+			float32 vn = b2Dot(dv, normal);
+			float32 lambda = -vcp->normalMass * (vn - vcp->velocityBias);
 
-			// b2Clamp the accumulated force
-			float32 maxFriction = friction * vcp->normalImpulse;
-			float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
-			lambda = newImpulse - vcp->tangentImpulse;
-			vcp->tangentImpulse = newImpulse;
+			// b2Clamp the accumulated impulse
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
 
 			// Apply contact impulse
-			b2Vec2 P = lambda * tangent;
-
+			b2Vec2 P = lambda * normal;
 			vA -= mA * P;
 			wA -= iA * b2Cross(vcp->rA, P);
 
 			vB += mB * P;
 			wB += iB * b2Cross(vcp->rB, P);
 		}
-
-		// Solve normal constraints
-		if (pointCount == 1 || g_blockSolve == false)
+	}
+	else
+	{
+		// Block solver developed in collaboration with Dirk Gregorius (back in 01/07 on Box2D_Lite).
+		// Build the mini LCP for this contact patch
+		//
+		// vn = A * x + b, vn >= 0, x >= 0 and vn_i * x_i = 0 with i = 1..2
+		//
+		// A = J * W * JT and J = ( -n, -r1 x n, n, r2 x n )
+		// b = vn0 - velocityBias
+		//
+		// The system is solved using the "Total enumeration method" (s. Murty). The complementary constraint vn_i * x_i
+		// implies that we must have in any solution either vn_i = 0 or x_i = 0. So for the 2D contact problem the cases
+		// vn1 = 0 and vn2 = 0, x1 = 0 and x2 = 0, x1 = 0 and vn2 = 0, x2 = 0 and vn1 = 0 need to be tested. The first valid
+		// solution that satisfies the problem is chosen.
+		// 
+		// In order to account of the accumulated impulse 'a' (because of the iterative nature of the solver which only requires
+		// that the accumulated impulse is clamped and not the incremental impulse) we change the impulse variable (x_i).
+		//
+		// Substitute:
+		// 
+		// x = a + d
+		// 
+		// a := old total impulse
+		// x := new total impulse
+		// d := incremental impulse 
+		//
+		// For the current iteration we extend the formula for the incremental impulse
+		// to compute the new total impulse:
+		//
+		// vn = A * d + b
+		//    = A * (x - a) + b
+		//    = A * x + b - A * a
+		//    = A * x + b'
+		// b' = b - A * a;
+
+		b2VelocityConstraintPoint* cp1 = vc->points + 0;
+		b2VelocityConstraintPoint* cp2 = vc->points + 1;
+
+		b2Vec2 a(cp1->normalImpulse, cp2->normalImpulse);
+		b2Assert(a.x >= 0.0f && a.y >= 0.0f);
+
+		// Relative velocity at contact
+		b2Vec2 dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+		b2Vec2 dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+
+		// Compute normal velocity
+		float32 vn1 = b2Dot(dv1, normal);
+		float32 vn2 = b2Dot(dv2, normal);
+
+		b2Vec2 b;
+		b.x = vn1 - cp1->velocityBias;
+		b.y = vn2 - cp2->velocityBias;
+
+		// Compute b'
+		b -= b2Mul(vc->K, a);
+
+		const float32 k_errorTol = 1e-3f;
+		B2_NOT_USED(k_errorTol);
+
+		for (;;)
 		{
-			for (int32 j = 0; j < pointCount; ++j)
+			//
+			// Case 1: vn = 0
+			//
+			// 0 = A * x + b'
+			//
+			// Solve for x:
+			//
+			// x = - inv(A) * b'
+			//
+			b2Vec2 x = - b2Mul(vc->normalMass, b);
+
+			if (x.x >= 0.0f && x.y >= 0.0f)
 			{
-				b2VelocityConstraintPoint* vcp = vc->points + j;
+				// Get the incremental impulse
+				b2Vec2 d = x - a;
 
-				// Relative velocity at contact
-				b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-				// Compute normal impulse
-				float32 vn = b2Dot(dv, normal);
-				float32 lambda = -vcp->normalMass * (vn - vcp->velocityBias);
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-				// b2Clamp the accumulated impulse
-				float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
-				lambda = newImpulse - vcp->normalImpulse;
-				vcp->normalImpulse = newImpulse;
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
-				// Apply contact impulse
-				b2Vec2 P = lambda * normal;
-				vA -= mA * P;
-				wA -= iA * b2Cross(vcp->rA, P);
+#if B2_DEBUG_SOLVER == 1
+				// Postconditions
+				dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+				dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
 
-				vB += mB * P;
-				wB += iB * b2Cross(vcp->rB, P);
+				// Compute normal velocity
+				vn1 = b2Dot(dv1, normal);
+				vn2 = b2Dot(dv2, normal);
+
+				b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
+				b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
+#endif
+				break;
 			}
-		}
-		else
-		{
-			// Block solver developed in collaboration with Dirk Gregorius (back in 01/07 on Box2D_Lite).
-			// Build the mini LCP for this contact patch
-			//
-			// vn = A * x + b, vn >= 0, x >= 0 and vn_i * x_i = 0 with i = 1..2
-			//
-			// A = J * W * JT and J = ( -n, -r1 x n, n, r2 x n )
-			// b = vn0 - velocityBias
-			//
-			// The system is solved using the "Total enumeration method" (s. Murty). The complementary constraint vn_i * x_i
-			// implies that we must have in any solution either vn_i = 0 or x_i = 0. So for the 2D contact problem the cases
-			// vn1 = 0 and vn2 = 0, x1 = 0 and x2 = 0, x1 = 0 and vn2 = 0, x2 = 0 and vn1 = 0 need to be tested. The first valid
-			// solution that satisfies the problem is chosen.
-			// 
-			// In order to account of the accumulated impulse 'a' (because of the iterative nature of the solver which only requires
-			// that the accumulated impulse is clamped and not the incremental impulse) we change the impulse variable (x_i).
+
 			//
-			// Substitute:
-			// 
-			// x = a + d
-			// 
-			// a := old total impulse
-			// x := new total impulse
-			// d := incremental impulse 
+			// Case 2: vn1 = 0 and x2 = 0
 			//
-			// For the current iteration we extend the formula for the incremental impulse
-			// to compute the new total impulse:
+			//   0 = a11 * x1 + a12 * 0 + b1' 
+			// vn2 = a21 * x1 + a22 * 0 + b2'
 			//
-			// vn = A * d + b
-			//    = A * (x - a) + b
-			//    = A * x + b - A * a
-			//    = A * x + b'
-			// b' = b - A * a;
+			x.x = - cp1->normalMass * b.x;
+			x.y = 0.0f;
+			vn1 = 0.0f;
+			vn2 = vc->K.ex.y * x.x + b.y;
+			if (x.x >= 0.0f && vn2 >= 0.0f)
+			{
+				// Get the incremental impulse
+				b2Vec2 d = x - a;
 
-			b2VelocityConstraintPoint* cp1 = vc->points + 0;
-			b2VelocityConstraintPoint* cp2 = vc->points + 1;
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-			b2Vec2 a(cp1->normalImpulse, cp2->normalImpulse);
-			b2Assert(a.x >= 0.0f && a.y >= 0.0f);
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-			// Relative velocity at contact
-			b2Vec2 dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
-			b2Vec2 dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
+
+#if B2_DEBUG_SOLVER == 1
+				// Postconditions
+				dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
 
-			// Compute normal velocity
-			float32 vn1 = b2Dot(dv1, normal);
-			float32 vn2 = b2Dot(dv2, normal);
+				// Compute normal velocity
+				vn1 = b2Dot(dv1, normal);
 
-			b2Vec2 b;
-			b.x = vn1 - cp1->velocityBias;
-			b.y = vn2 - cp2->velocityBias;
+				b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
+#endif
+				break;
+			}
 
-			// Compute b'
-			b -= b2Mul(vc->K, a);
 
-			const float32 k_errorTol = 1e-3f;
-			B2_NOT_USED(k_errorTol);
+			//
+			// Case 3: vn2 = 0 and x1 = 0
+			//
+			// vn1 = a11 * 0 + a12 * x2 + b1' 
+			//   0 = a21 * 0 + a22 * x2 + b2'
+			//
+			x.x = 0.0f;
+			x.y = - cp2->normalMass * b.y;
+			vn1 = vc->K.ey.x * x.y + b.x;
+			vn2 = 0.0f;
 
-			for (;;)
+			if (x.y >= 0.0f && vn1 >= 0.0f)
 			{
-				//
-				// Case 1: vn = 0
-				//
-				// 0 = A * x + b'
-				//
-				// Solve for x:
-				//
-				// x = - inv(A) * b'
-				//
-				b2Vec2 x = - b2Mul(vc->normalMass, b);
-
-				if (x.x >= 0.0f && x.y >= 0.0f)
-				{
-					// Get the incremental impulse
-					b2Vec2 d = x - a;
-
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
-
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
-
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				// Resubstitute for the incremental impulse
+				b2Vec2 d = x - a;
 
-#if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
-					dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
 
-					// Compute normal velocity
-					vn1 = b2Dot(dv1, normal);
-					vn2 = b2Dot(dv2, normal);
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
 
-					b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
-					b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
-#endif
-					break;
-				}
-
-				//
-				// Case 2: vn1 = 0 and x2 = 0
-				//
-				//   0 = a11 * x1 + a12 * 0 + b1' 
-				// vn2 = a21 * x1 + a22 * 0 + b2'
-				//
-				x.x = - cp1->normalMass * b.x;
-				x.y = 0.0f;
-				vn1 = 0.0f;
-				vn2 = vc->K.ex.y * x.x + b.y;
-				if (x.x >= 0.0f && vn2 >= 0.0f)
-				{
-					// Get the incremental impulse
-					b2Vec2 d = x - a;
-
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
-
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
-
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
 #if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+				// Postconditions
+				dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
 
-					// Compute normal velocity
-					vn1 = b2Dot(dv1, normal);
+				// Compute normal velocity
+				vn2 = b2Dot(dv2, normal);
 
-					b2Assert(b2Abs(vn1 - cp1->velocityBias) < k_errorTol);
+				b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
 #endif
-					break;
-				}
-
-
-				//
-				// Case 3: vn2 = 0 and x1 = 0
-				//
-				// vn1 = a11 * 0 + a12 * x2 + b1' 
-				//   0 = a21 * 0 + a22 * x2 + b2'
-				//
-				x.x = 0.0f;
-				x.y = - cp2->normalMass * b.y;
-				vn1 = vc->K.ey.x * x.y + b.x;
-				vn2 = 0.0f;
-
-				if (x.y >= 0.0f && vn1 >= 0.0f)
-				{
-					// Resubstitute for the incremental impulse
-					b2Vec2 d = x - a;
-
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
-
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
-
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
+				break;
+			}
 
-#if B2_DEBUG_SOLVER == 1
-					// Postconditions
-					dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+			//
+			// Case 4: x1 = 0 and x2 = 0
+			// 
+			// vn1 = b1
+			// vn2 = b2;
+			x.x = 0.0f;
+			x.y = 0.0f;
+			vn1 = b.x;
+			vn2 = b.y;
+
+			if (vn1 >= 0.0f && vn2 >= 0.0f )
+			{
+				// Resubstitute for the incremental impulse
+				b2Vec2 d = x - a;
 
-					// Compute normal velocity
-					vn2 = b2Dot(dv2, normal);
+				// Apply incremental impulse
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= mA * (P1 + P2);
+				wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+
+				vB += mB * (P1 + P2);
+				wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+
+				// Accumulate
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
 
-					b2Assert(b2Abs(vn2 - cp2->velocityBias) < k_errorTol);
-#endif
-					break;
-				}
-
-				//
-				// Case 4: x1 = 0 and x2 = 0
-				// 
-				// vn1 = b1
-				// vn2 = b2;
-				x.x = 0.0f;
-				x.y = 0.0f;
-				vn1 = b.x;
-				vn2 = b.y;
-
-				if (vn1 >= 0.0f && vn2 >= 0.0f )
-				{
-					// Resubstitute for the incremental impulse
-					b2Vec2 d = x - a;
-
-					// Apply incremental impulse
-					b2Vec2 P1 = d.x * normal;
-					b2Vec2 P2 = d.y * normal;
-					vA -= mA * (P1 + P2);
-					wA -= iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
-
-					vB += mB * (P1 + P2);
-					wB += iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
-
-					// Accumulate
-					cp1->normalImpulse = x.x;
-					cp2->normalImpulse = x.y;
-
-					break;
-				}
-
-				// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
 				break;
 			}
-		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+			// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
+			break;
+		}
 	}
+
+	m_velocities[indexA].v = vA;
+	m_velocities[indexA].w = wA;
+	m_velocities[indexB].v = vB;
+	m_velocities[indexB].w = wB;
 }
 
 void b2ContactSolver::StoreImpulses()
 {
+	// Copy the batched impulses back to the constraints
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactVelocityBatch* vb = m_velocityBatches + i;
+		for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+		{
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + vb->constraint[lane];
+			vc->points[0].normalImpulse = vb->normalImpulse1[lane];
+			vc->points[0].tangentImpulse = vb->tangentImpulse1[lane];
+			if (vc->pointCount == 2)
+			{
+				vc->points[1].normalImpulse = vb->normalImpulse2[lane];
+				vc->points[1].tangentImpulse = vb->tangentImpulse2[lane];
+			}
+		}
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -667,78 +955,490 @@ struct b2PositionSolverManifold
 	float32 separation;
 };
 
-// Sequential solver.
-bool b2ContactSolver::SolvePositionConstraints()
+// Groups the constraints into SIMD batches with greedy graph coloring.
+// Two constraints have the same color only if they share no dynamic body,
+// so the lanes of a batch can be solved at the same time. Bodies with no
+// inverse mass or inertia (static or kinematic) are never written by the
+// solver, and so they may be shared. Contacts that do not fill a batch
+// are solved by the scalar solver afterwards.
+void b2ContactSolver::BuildBatches()
 {
-	float32 minSeparation = 0.0f;
+	int32 capacity = m_count / b2_simdWidth;
+	if (capacity == 0)
+	{
+		return;
+	}
 
+	// These are freed in the destructor, so they are allocated first
+	m_velocityBatches = (b2ContactVelocityBatch*)m_allocator->Allocate(capacity * sizeof(b2ContactVelocityBatch));
+	m_positionBatches = (b2ContactPositionBatch*)m_allocator->Allocate(capacity * sizeof(b2ContactPositionBatch));
+	m_remainder = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+
+	int32 bodyCount = 0;
 	for (int32 i = 0; i < m_count; ++i)
 	{
-		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
 
-		int32 indexA = pc->indexA;
-		int32 indexB = pc->indexB;
-		b2Vec2 localCenterA = pc->localCenterA;
-		float32 mA = pc->invMassA;
-		float32 iA = pc->invIA;
-		b2Vec2 localCenterB = pc->localCenterB;
-		float32 mB = pc->invMassB;
-		float32 iB = pc->invIB;
-		int32 pointCount = pc->pointCount;
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	int32* colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	int32* order = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
 
-		b2Vec2 cA = m_positions[indexA].c;
-		float32 aA = m_positions[indexA].a;
+	int32 colorCounts[b2_maxColors + 1];
+	memset(colorCounts, 0, sizeof(colorCounts));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bool staticA = vc->invMassA == 0.0f && vc->invIA == 0.0f;
+		bool staticB = vc->invMassB == 0.0f && vc->invIB == 0.0f;
+		uint32 used = (staticA ? 0 : bodyColors[vc->indexA]) | (staticB ? 0 : bodyColors[vc->indexB]);
 
-		b2Vec2 cB = m_positions[indexB].c;
-		float32 aB = m_positions[indexB].a;
+		int32 color = 0;
+		while (color < b2_maxColors && (used & (1u << color)) != 0)
+		{
+			++color;
+		}
 
-		// Solve normal constraints
-		for (int32 j = 0; j < pointCount; ++j)
+		// Overflow contacts get the last (scalar) color
+		if (color < b2_maxColors)
 		{
-			b2Transform xfA, xfB;
-			xfA.q.Set(aA);
-			xfB.q.Set(aB);
-			xfA.p = cA - b2Mul(xfA.q, localCenterA);
-			xfB.p = cB - b2Mul(xfB.q, localCenterB);
+			if (staticA == false)
+			{
+				bodyColors[vc->indexA] |= 1u << color;
+			}
+			if (staticB == false)
+			{
+				bodyColors[vc->indexB] |= 1u << color;
+			}
+		}
+		colors[i] = color;
+		colorCounts[color]++;
+	}
 
-			b2PositionSolverManifold psm;
-			psm.Initialize(pc, xfA, xfB, j);
-			b2Vec2 normal = psm.normal;
+	// Counting sort by color, preserving the original order in each color
+	int32 offset = 0;
+	for (int32 c = 0; c <= b2_maxColors; ++c)
+	{
+		int32 count = colorCounts[c];
+		colorCounts[c] = offset;
+		offset += count;
+	}
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		order[colorCounts[colors[i]]++] = i;
+	}
 
-			b2Vec2 point = psm.point;
-			float32 separation = psm.separation;
+	m_batchCount = 0;
+	m_remainderCount = 0;
+	int32 start = 0;
+	for (int32 c = 0; c <= b2_maxColors; ++c)
+	{
+		int32 end = colorCounts[c];
+		int32 lanes = (c < b2_maxColors ? end - start : 0);
+		int32 full = start + (lanes / b2_simdWidth) * b2_simdWidth;
+		for (int32 i = start; i < full; i += b2_simdWidth)
+		{
+			b2ContactVelocityBatch* vb = m_velocityBatches + m_batchCount;
+			b2ContactPositionBatch* pb = m_positionBatches + m_batchCount;
+			for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+			{
+				PackConstraint(vb, pb, lane, order[i + lane]);
+			}
+			++m_batchCount;
+		}
+		for (int32 i = full; i < end; ++i)
+		{
+			m_remainder[m_remainderCount++] = order[i];
+		}
+		start = end;
+	}
 
-			b2Vec2 rA = point - cA;
-			b2Vec2 rB = point - cB;
+	m_allocator->Free(order);
+	m_allocator->Free(colors);
+	m_allocator->Free(bodyColors);
+}
 
-			// Track max constraint error.
-			minSeparation = b2Min(minSeparation, separation);
+// Copies a single constraint into a lane of the batches.
+void b2ContactSolver::PackConstraint(b2ContactVelocityBatch* vb, b2ContactPositionBatch* pb, int32 lane, int32 index)
+{
+	b2ContactVelocityConstraint* vc = m_velocityConstraints + index;
+	vb->indexA[lane] = vc->indexA;
+	vb->indexB[lane] = vc->indexB;
+	vb->constraint[lane] = index;
+	vb->invMassA[lane] = vc->invMassA;
+	vb->invMassB[lane] = vc->invMassB;
+	vb->invIA[lane] = vc->invIA;
+	vb->invIB[lane] = vc->invIB;
+	vb->normalX[lane] = vc->normal.x;
+	vb->normalY[lane] = vc->normal.y;
+	vb->friction[lane] = vc->friction;
+	vb->tangentSpeed[lane] = vc->tangentSpeed;
+
+	const b2VelocityConstraintPoint* cp1 = vc->points + 0;
+	vb->rA1X[lane] = cp1->rA.x;
+	vb->rA1Y[lane] = cp1->rA.y;
+	vb->rB1X[lane] = cp1->rB.x;
+	vb->rB1Y[lane] = cp1->rB.y;
+	vb->normalMass1[lane] = cp1->normalMass;
+	vb->tangentMass1[lane] = cp1->tangentMass;
+	vb->velocityBias1[lane] = cp1->velocityBias;
+	vb->normalImpulse1[lane] = cp1->normalImpulse;
+	vb->tangentImpulse1[lane] = cp1->tangentImpulse;
+
+	if (vc->pointCount == 2)
+	{
+		const b2VelocityConstraintPoint* cp2 = vc->points + 1;
+		vb->rA2X[lane] = cp2->rA.x;
+		vb->rA2Y[lane] = cp2->rA.y;
+		vb->rB2X[lane] = cp2->rB.x;
+		vb->rB2Y[lane] = cp2->rB.y;
+		vb->normalMass2[lane] = cp2->normalMass;
+		vb->tangentMass2[lane] = cp2->tangentMass;
+		vb->velocityBias2[lane] = cp2->velocityBias;
+		vb->normalImpulse2[lane] = cp2->normalImpulse;
+		vb->tangentImpulse2[lane] = cp2->tangentImpulse;
+		vb->K11[lane] = vc->K.ex.x;
+		vb->K12[lane] = vc->K.ex.y;
+		vb->K22[lane] = vc->K.ey.y;
+		vb->M11[lane] = vc->normalMass.ex.x;
+		vb->M12[lane] = vc->normalMass.ex.y;
+		vb->M22[lane] = vc->normalMass.ey.y;
+	}
+	else
+	{
+		// A decoupled dummy point reduces the block solver to the
+		// sequential solver for the first point.
+		float32 k11 = cp1->normalMass > 0.0f ? 1.0f / cp1->normalMass : 0.0f;
+		vb->rA2X[lane] = 0.0f;
+		vb->rA2Y[lane] = 0.0f;
+		vb->rB2X[lane] = 0.0f;
+		vb->rB2Y[lane] = 0.0f;
+		vb->normalMass2[lane] = 1.0f;
+		vb->tangentMass2[lane] = 0.0f;
+		vb->velocityBias2[lane] = b2_dummyVelocityBias;
+		vb->normalImpulse2[lane] = 0.0f;
+		vb->tangentImpulse2[lane] = 0.0f;
+		vb->K11[lane] = k11;
+		vb->K12[lane] = 0.0f;
+		vb->K22[lane] = 1.0f;
+		vb->M11[lane] = cp1->normalMass;
+		vb->M12[lane] = 0.0f;
+		vb->M22[lane] = 1.0f;
+	}
 
-			// Prevent large corrections and allow slop.
-			float32 C = b2Clamp(b2_baumgarte * (separation + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
+	b2ContactPositionConstraint* pc = m_positionConstraints + index;
+	pb->indexA[lane] = pc->indexA;
+	pb->indexB[lane] = pc->indexB;
+	pb->constraint[lane] = index;
+	pb->invMassA[lane] = pc->invMassA;
+	pb->invMassB[lane] = pc->invMassB;
+	pb->invIA[lane] = pc->invIA;
+	pb->invIB[lane] = pc->invIB;
+}
 
-			// Compute the effective mass.
-			float32 rnA = b2Cross(rA, normal);
-			float32 rnB = b2Cross(rB, normal);
-			float32 K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+// Solves a batch of velocity constraints. This is the same computation as
+// SolveVelocityConstraint, with the four cases of the block solver evaluated
+// in every lane and then selected.
+void b2ContactSolver::SolveVelocityBatch(b2ContactVelocityBatch* vb)
+{
+	float32 vAx[b2_simdWidth], vAy[b2_simdWidth], wA[b2_simdWidth];
+	float32 vBx[b2_simdWidth], vBy[b2_simdWidth], wB[b2_simdWidth];
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		const b2Velocity& velA = m_velocities[vb->indexA[lane]];
+		const b2Velocity& velB = m_velocities[vb->indexB[lane]];
+		vAx[lane] = velA.v.x;
+		vAy[lane] = velA.v.y;
+		wA[lane] = velA.w;
+		vBx[lane] = velB.v.x;
+		vBy[lane] = velB.v.y;
+		wB[lane] = velB.w;
+	}
 
-			// Compute normal impulse
-			float32 impulse = K > 0.0f ? - C / K : 0.0f;
+	b2FloatW vax = b2LoadW(vAx), vay = b2LoadW(vAy), wa = b2LoadW(wA);
+	b2FloatW vbx = b2LoadW(vBx), vby = b2LoadW(vBy), wb = b2LoadW(wB);
+	b2FloatW mA = b2LoadW(vb->invMassA), iA = b2LoadW(vb->invIA);
+	b2FloatW mB = b2LoadW(vb->invMassB), iB = b2LoadW(vb->invIB);
+	b2FloatW nx = b2LoadW(vb->normalX), ny = b2LoadW(vb->normalY);
+	b2FloatW zero = b2SplatW(0.0f);
+
+	// tangent = b2Cross(normal, 1.0f)
+	b2FloatW tx = ny;
+	b2FloatW ty = b2SubW(zero, nx);
+	b2FloatW friction = b2LoadW(vb->friction);
+	b2FloatW tangentSpeed = b2LoadW(vb->tangentSpeed);
+
+	b2FloatW ra1x = b2LoadW(vb->rA1X), ra1y = b2LoadW(vb->rA1Y);
+	b2FloatW rb1x = b2LoadW(vb->rB1X), rb1y = b2LoadW(vb->rB1Y);
+	b2FloatW ra2x = b2LoadW(vb->rA2X), ra2y = b2LoadW(vb->rA2Y);
+	b2FloatW rb2x = b2LoadW(vb->rB2X), rb2y = b2LoadW(vb->rB2Y);
+	b2FloatW ni1 = b2LoadW(vb->normalImpulse1), ni2 = b2LoadW(vb->normalImpulse2);
+
+	// Solve tangent constraints first, one point at a time
+	for (int32 j = 0; j < 2; ++j)
+	{
+		b2FloatW rax = j == 0 ? ra1x : ra2x, ray = j == 0 ? ra1y : ra2y;
+		b2FloatW rbx = j == 0 ? rb1x : rb2x, rby = j == 0 ? rb1y : rb2y;
+		float32* impulse = j == 0 ? vb->tangentImpulse1 : vb->tangentImpulse2;
+		b2FloatW tangentMass = b2LoadW(j == 0 ? vb->tangentMass1 : vb->tangentMass2);
+		b2FloatW normalImpulse = j == 0 ? ni1 : ni2;
+		b2FloatW tangentImpulse = b2LoadW(impulse);
+
+		// Relative velocity at contact
+		b2FloatW dvx = b2SubW(b2SubW(vbx, b2MulW(wb, rby)), b2SubW(vax, b2MulW(wa, ray)));
+		b2FloatW dvy = b2SubW(b2AddW(vby, b2MulW(wb, rbx)), b2AddW(vay, b2MulW(wa, rax)));
+
+		// Compute tangent force
+		b2FloatW vt = b2SubW(b2AddW(b2MulW(dvx, tx), b2MulW(dvy, ty)), tangentSpeed);
+		b2FloatW lambda = b2SubW(zero, b2MulW(tangentMass, vt));
+
+		// Clamp the accumulated force
+		b2FloatW maxFriction = b2MulW(friction, normalImpulse);
+		b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxFriction), b2MinW(b2AddW(tangentImpulse, lambda), maxFriction));
+		lambda = b2SubW(newImpulse, tangentImpulse);
+		b2StoreW(impulse, newImpulse);
+
+		// Apply contact impulse
+		b2FloatW px = b2MulW(lambda, tx);
+		b2FloatW py = b2MulW(lambda, ty);
+		vax = b2SubW(vax, b2MulW(mA, px));
+		vay = b2SubW(vay, b2MulW(mA, py));
+		wa = b2SubW(wa, b2MulW(iA, b2SubW(b2MulW(rax, py), b2MulW(ray, px))));
+		vbx = b2AddW(vbx, b2MulW(mB, px));
+		vby = b2AddW(vby, b2MulW(mB, py));
+		wb = b2AddW(wb, b2MulW(iB, b2SubW(b2MulW(rbx, py), b2MulW(rby, px))));
+	}
 
-			b2Vec2 P = impulse * normal;
+	// Solve the normal constraints with the block solver
+	{
+		b2FloatW dv1x = b2SubW(b2SubW(vbx, b2MulW(wb, rb1y)), b2SubW(vax, b2MulW(wa, ra1y)));
+		b2FloatW dv1y = b2SubW(b2AddW(vby, b2MulW(wb, rb1x)), b2AddW(vay, b2MulW(wa, ra1x)));
+		b2FloatW dv2x = b2SubW(b2SubW(vbx, b2MulW(wb, rb2y)), b2SubW(vax, b2MulW(wa, ra2y)));
+		b2FloatW dv2y = b2SubW(b2AddW(vby, b2MulW(wb, rb2x)), b2AddW(vay, b2MulW(wa, ra2x)));
+
+		// Compute normal velocity
+		b2FloatW vn1 = b2AddW(b2MulW(dv1x, nx), b2MulW(dv1y, ny));
+		b2FloatW vn2 = b2AddW(b2MulW(dv2x, nx), b2MulW(dv2y, ny));
+
+		// Compute b' = vn - velocityBias - K * a
+		b2FloatW k11 = b2LoadW(vb->K11), k12 = b2LoadW(vb->K12), k22 = b2LoadW(vb->K22);
+		b2FloatW bx = b2SubW(b2SubW(vn1, b2LoadW(vb->velocityBias1)), b2AddW(b2MulW(k11, ni1), b2MulW(k12, ni2)));
+		b2FloatW by = b2SubW(b2SubW(vn2, b2LoadW(vb->velocityBias2)), b2AddW(b2MulW(k12, ni1), b2MulW(k22, ni2)));
+
+		// Case 1: vn = 0
+		b2FloatW m11 = b2LoadW(vb->M11), m12 = b2LoadW(vb->M12), m22 = b2LoadW(vb->M22);
+		b2FloatW x1 = b2SubW(zero, b2AddW(b2MulW(m11, bx), b2MulW(m12, by)));
+		b2FloatW y1 = b2SubW(zero, b2AddW(b2MulW(m12, bx), b2MulW(m22, by)));
+		b2FloatW case1 = b2AndW(b2GreaterEqualW(x1, zero), b2GreaterEqualW(y1, zero));
+
+		// Case 2: vn1 = 0 and x2 = 0
+		b2FloatW x2 = b2SubW(zero, b2MulW(b2LoadW(vb->normalMass1), bx));
+		b2FloatW case2 = b2AndW(b2GreaterEqualW(x2, zero), b2GreaterEqualW(b2AddW(b2MulW(k12, x2), by), zero));
+
+		// Case 3: vn2 = 0 and x1 = 0
+		b2FloatW y3 = b2SubW(zero, b2MulW(b2LoadW(vb->normalMass2), by));
+		b2FloatW case3 = b2AndW(b2GreaterEqualW(y3, zero), b2GreaterEqualW(b2AddW(b2MulW(k12, y3), bx), zero));
+
+		// Case 4: x1 = 0 and x2 = 0
+		b2FloatW case4 = b2AndW(b2GreaterEqualW(bx, zero), b2GreaterEqualW(by, zero));
+
+		// The first valid case wins. If there is none, the impulse is unchanged.
+		b2FloatW xx = b2SelectW(case4, zero, ni1);
+		b2FloatW xy = b2SelectW(case4, zero, ni2);
+		xx = b2SelectW(case3, zero, xx);
+		xy = b2SelectW(case3, y3, xy);
+		xx = b2SelectW(case2, x2, xx);
+		xy = b2SelectW(case2, zero, xy);
+		xx = b2SelectW(case1, x1, xx);
+		xy = b2SelectW(case1, y1, xy);
+
+		// Apply incremental impulse
+		b2FloatW dx = b2SubW(xx, ni1);
+		b2FloatW dy = b2SubW(xy, ni2);
+		b2FloatW p1x = b2MulW(dx, nx), p1y = b2MulW(dx, ny);
+		b2FloatW p2x = b2MulW(dy, nx), p2y = b2MulW(dy, ny);
+		b2FloatW px = b2AddW(p1x, p2x);
+		b2FloatW py = b2AddW(p1y, p2y);
+
+		vax = b2SubW(vax, b2MulW(mA, px));
+		vay = b2SubW(vay, b2MulW(mA, py));
+		wa = b2SubW(wa, b2MulW(iA, b2AddW(b2SubW(b2MulW(ra1x, p1y), b2MulW(ra1y, p1x)),
+		                                  b2SubW(b2MulW(ra2x, p2y), b2MulW(ra2y, p2x)))));
+		vbx = b2AddW(vbx, b2MulW(mB, px));
+		vby = b2AddW(vby, b2MulW(mB, py));
+		wb = b2AddW(wb, b2MulW(iB, b2AddW(b2SubW(b2MulW(rb1x, p1y), b2MulW(rb1y, p1x)),
+		                                  b2SubW(b2MulW(rb2x, p2y), b2MulW(rb2y, p2x)))));
+
+		// Accumulate
+		b2StoreW(vb->normalImpulse1, xx);
+		b2StoreW(vb->normalImpulse2, xy);
+	}
 
-			cA -= mA * P;
-			aA -= iA * b2Cross(rA, P);
+	b2StoreW(vAx, vax);
+	b2StoreW(vAy, vay);
+	b2StoreW(wA, wa);
+	b2StoreW(vBx, vbx);
+	b2StoreW(vBy, vby);
+	b2StoreW(wB, wb);
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		b2Velocity& velA = m_velocities[vb->indexA[lane]];
+		b2Velocity& velB = m_velocities[vb->indexB[lane]];
+		velA.v.Set(vAx[lane], vAy[lane]);
+		velA.w = wA[lane];
+		velB.v.Set(vBx[lane], vBy[lane]);
+		velB.w = wB[lane];
+	}
+}
 
-			cB += mB * P;
-			aB += iB * b2Cross(rB, P);
+// Solves a batch of position constraints. The manifold of each lane is
+// evaluated in scalar (it needs the sine and cosine of each angle), but
+// the impulses are computed and applied in SIMD.
+float32 b2ContactSolver::SolvePositionBatch(b2ContactPositionBatch* pb)
+{
+	float32 cAx[b2_simdWidth], cAy[b2_simdWidth], aA[b2_simdWidth];
+	float32 cBx[b2_simdWidth], cBy[b2_simdWidth], aB[b2_simdWidth];
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		const b2Position& posA = m_positions[pb->indexA[lane]];
+		const b2Position& posB = m_positions[pb->indexB[lane]];
+		cAx[lane] = posA.c.x;
+		cAy[lane] = posA.c.y;
+		aA[lane] = posA.a;
+		cBx[lane] = posB.c.x;
+		cBy[lane] = posB.c.y;
+		aB[lane] = posB.a;
+	}
+
+	b2FloatW mA = b2LoadW(pb->invMassA), iA = b2LoadW(pb->invIA);
+	b2FloatW mB = b2LoadW(pb->invMassB), iB = b2LoadW(pb->invIB);
+	b2FloatW zero = b2SplatW(0.0f);
+	b2FloatW minSeparation = zero;
+
+	for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+	{
+		float32 normalX[b2_simdWidth], normalY[b2_simdWidth];
+		float32 pointX[b2_simdWidth], pointY[b2_simdWidth];
+		float32 separation[b2_simdWidth], active[b2_simdWidth];
+		for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+		{
+			b2ContactPositionConstraint* pc = m_positionConstraints + pb->constraint[lane];
+			if (j < pc->pointCount)
+			{
+				b2Transform xfA, xfB;
+				xfA.q.Set(aA[lane]);
+				xfB.q.Set(aB[lane]);
+				xfA.p = b2Vec2(cAx[lane], cAy[lane]) - b2Mul(xfA.q, pc->localCenterA);
+				xfB.p = b2Vec2(cBx[lane], cBy[lane]) - b2Mul(xfB.q, pc->localCenterB);
+
+				b2PositionSolverManifold psm;
+				psm.Initialize(pc, xfA, xfB, j);
+				normalX[lane] = psm.normal.x;
+				normalY[lane] = psm.normal.y;
+				pointX[lane] = psm.point.x;
+				pointY[lane] = psm.point.y;
+				separation[lane] = psm.separation;
+				active[lane] = 1.0f;
+			}
+			else
+			{
+				normalX[lane] = normalY[lane] = 0.0f;
+				pointX[lane] = cAx[lane];
+				pointY[lane] = cAy[lane];
+				separation[lane] = 0.0f;
+				active[lane] = 0.0f;
+			}
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
+		b2FloatW cax = b2LoadW(cAx), cay = b2LoadW(cAy), aa = b2LoadW(aA);
+		b2FloatW cbx = b2LoadW(cBx), cby = b2LoadW(cBy), ab = b2LoadW(aB);
+		b2FloatW nx = b2LoadW(normalX), ny = b2LoadW(normalY);
+		b2FloatW px = b2LoadW(pointX), py = b2LoadW(pointY);
+		b2FloatW sep = b2LoadW(separation);
+
+		b2FloatW rax = b2SubW(px, cax), ray = b2SubW(py, cay);
+		b2FloatW rbx = b2SubW(px, cbx), rby = b2SubW(py, cby);
+
+		// Track max constraint error (inactive lanes have separation 0)
+		minSeparation = b2MinW(minSeparation, sep);
+
+		// Prevent large corrections and allow slop.
+		b2FloatW C = b2MulW(b2SplatW(b2_baumgarte), b2AddW(sep, b2SplatW(b2_linearSlop)));
+		C = b2MaxW(b2SplatW(-b2_maxLinearCorrection), b2MinW(C, zero));
+
+		// Compute the effective mass.
+		b2FloatW rnA = b2SubW(b2MulW(rax, ny), b2MulW(ray, nx));
+		b2FloatW rnB = b2SubW(b2MulW(rbx, ny), b2MulW(rby, nx));
+		b2FloatW K = b2AddW(b2AddW(mA, mB), b2AddW(b2MulW(iA, b2MulW(rnA, rnA)), b2MulW(iB, b2MulW(rnB, rnB))));
+
+		// Compute normal impulse
+		b2FloatW valid = b2AndW(b2GreaterW(K, zero), b2GreaterW(b2LoadW(active), zero));
+		b2FloatW impulse = b2DivW(b2SubW(zero, C), b2SelectW(valid, K, b2SplatW(1.0f)));
+		impulse = b2SelectW(valid, impulse, zero);
+
+		b2FloatW Px = b2MulW(impulse, nx);
+		b2FloatW Py = b2MulW(impulse, ny);
+
+		cax = b2SubW(cax, b2MulW(mA, Px));
+		cay = b2SubW(cay, b2MulW(mA, Py));
+		aa = b2SubW(aa, b2MulW(iA, b2SubW(b2MulW(rax, Py), b2MulW(ray, Px))));
+		cbx = b2AddW(cbx, b2MulW(mB, Px));
+		cby = b2AddW(cby, b2MulW(mB, Py));
+		ab = b2AddW(ab, b2MulW(iB, b2SubW(b2MulW(rbx, Py), b2MulW(rby, Px))));
+
+		b2StoreW(cAx, cax);
+		b2StoreW(cAy, cay);
+		b2StoreW(aA, aa);
+		b2StoreW(cBx, cbx);
+		b2StoreW(cBy, cby);
+		b2StoreW(aB, ab);
+	}
 
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		b2Position& posA = m_positions[pb->indexA[lane]];
+		b2Position& posB = m_positions[pb->indexB[lane]];
+		posA.c.Set(cAx[lane], cAy[lane]);
+		posA.a = aA[lane];
+		posB.c.Set(cBx[lane], cBy[lane]);
+		posB.a = aB[lane];
+	}
+
+	float32 result[b2_simdWidth];
+	b2StoreW(result, minSeparation);
+	float32 minimum = result[0];
+	for (int32 lane = 1; lane < b2_simdWidth; ++lane)
+	{
+		minimum = b2Min(minimum, result[lane]);
+	}
+	return minimum;
+}
+
+// Sequential solver.
+bool b2ContactSolver::SolvePositionConstraints()
+{
+	float32 minSeparation = 0.0f;
+
+	if (m_remainder != NULL)
+	{
+		for (int32 i = 0; i < m_batchCount; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolvePositionBatch(m_positionBatches + i));
+		}
+
+		for (int32 i = 0; i < m_remainderCount; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolvePositionConstraint(m_positionConstraints + m_remainder[i]));
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			minSeparation = b2Min(minSeparation, SolvePositionConstraint(m_positionConstraints + i));
+		}
 	}
 
 	// We can't expect minSpeparation >= -b2_linearSlop because we don't
@@ -746,6 +1446,78 @@ bool b2ContactSolver::SolvePositionConstraints()
 	return minSeparation >= -3.0f * b2_linearSlop;
 }
 
+// Solves a single position constraint, returning the minimum separation.
+float32 b2ContactSolver::SolvePositionConstraint(b2ContactPositionConstraint* pc)
+{
+	float32 minSeparation = 0.0f;
+
+	int32 indexA = pc->indexA;
+	int32 indexB = pc->indexB;
+	b2Vec2 localCenterA = pc->localCenterA;
+	float32 mA = pc->invMassA;
+	float32 iA = pc->invIA;
+	b2Vec2 localCenterB = pc->localCenterB;
+	float32 mB = pc->invMassB;
+	float32 iB = pc->invIB;
+	int32 pointCount = pc->pointCount;
+
+	b2Vec2 cA = m_positions[indexA].c;
+	float32 aA = m_positions[indexA].a;
+
+	b2Vec2 cB = m_positions[indexB].c;
+	float32 aB = m_positions[indexB].a;
+
+	// Solve normal constraints
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2Transform xfA, xfB;
+		xfA.q.Set(aA);
+		xfB.q.Set(aB);
+		xfA.p = cA - b2Mul(xfA.q, localCenterA);
+		xfB.p = cB - b2Mul(xfB.q, localCenterB);
+
+		b2PositionSolverManifold psm;
+		psm.Initialize(pc, xfA, xfB, j);
+		b2Vec2 normal = psm.normal;
+
+		b2Vec2 point = psm.point;
+		float32 separation = psm.separation;
+
+		b2Vec2 rA = point - cA;
+		b2Vec2 rB = point - cB;
+
+		// Track max constraint error.
+		minSeparation = b2Min(minSeparation, separation);
+
+		// Prevent large corrections and allow slop.
+		float32 C = b2Clamp(b2_baumgarte * (separation + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
+
+		// Compute the effective mass.
+		float32 rnA = b2Cross(rA, normal);
+		float32 rnB = b2Cross(rB, normal);
+		float32 K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+
+		// Compute normal impulse
+		float32 impulse = K > 0.0f ? - C / K : 0.0f;
+
+		b2Vec2 P = impulse * normal;
+
+		cA -= mA * P;
+		aA -= iA * b2Cross(rA, P);
+
+		cB += mB * P;
+		aB += iB * b2Cross(rB, P);
+	}
+
+	m_positions[indexA].c = cA;
+	m_positions[indexA].a = aA;
+
+	m_positions[indexB].c = cB;
+	m_positions[indexB].a = aB;
+
+	return minSeparation;
+}
+
 // Sequential position solver for position constraints.
 bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB)
 {
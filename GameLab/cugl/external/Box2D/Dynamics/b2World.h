@@ -149,6 +149,12 @@ public:
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
 
+	/// Enable/disable the batched (SIMD) contact solver. This solves groups of
+	/// contacts that share no dynamic bodies together. The results differ from
+	/// the sequential solver only in the order that contacts are solved.
+	void SetBatchedContacts(bool flag) { m_batchedContacts = flag; }
+	bool GetBatchedContacts() const { return m_batchedContacts; }
+
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
@@ -255,6 +261,7 @@ private:
 
 	// These are for debugging the solver.
 	bool m_warmStarting;
+	bool m_batchedContacts;
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
@@ -27,6 +27,8 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2ContactVelocityBatch;
+struct b2ContactPositionBatch;
 
 struct b2VelocityConstraintPoint
 {
@@ -81,6 +83,13 @@ public:
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	void BuildBatches();
+	void PackConstraint(b2ContactVelocityBatch* vb, b2ContactPositionBatch* pb, int32 lane, int32 index);
+	void SolveVelocityConstraint(b2ContactVelocityConstraint* vc);
+	void SolveVelocityBatch(b2ContactVelocityBatch* vb);
+	float32 SolvePositionConstraint(b2ContactPositionConstraint* pc);
+	float32 SolvePositionBatch(b2ContactPositionBatch* pb);
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -89,6 +98,11 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+	b2ContactVelocityBatch* m_velocityBatches;
+	b2ContactPositionBatch* m_positionBatches;
+	int32 m_batchCount;
+	int32* m_remainder;
+	int32 m_remainderCount;
 };
 
 #endif
@@ -22,6 +22,10 @@
 //  3. All allocation takes place via static constructors which return a shared
 //     pointer.
 //
+//  Asynchronous directory loads are prioritized.  Each asset in a directory may
+//  specify a "priority" (higher loads first) and whether it is "critical". This
+//  allows a game to start as soon as the critical assets are ready while the
+//  rest stream in.  Progress is weighted by the estimated size of each asset.
 //
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -52,6 +56,7 @@
 #include <cugl/assets/CULoader.h>
 #include <typeinfo>
 #include <atomic>
+#include <unordered_map>
 
 
 namespace cugl {
@@ -97,6 +102,23 @@ protected:
     
     /** Wait variable to create a load barrier for directories. */
     std::atomic<bool> _wait;
+    
+    /** The number of assets not yet handed to their loader */
+    std::atomic<size_t> _pending;
+    /** The number of entries in {@link waitCount} that are directory assets */
+    std::atomic<size_t> _directoryWait;
+    /** The estimated bytes of all assets queued by asynchronous directories */
+    std::atomic<size_t> _totalBytes;
+    /** The estimated bytes of all directory assets that have finished loading */
+    std::atomic<size_t> _loadedBytes;
+    /** The estimated bytes of all critical assets queued by directories */
+    std::atomic<size_t> _criticalBytes;
+    /** The estimated bytes of all critical assets that have finished loading */
+    std::atomic<size_t> _criticalLoaded;
+    /** The number of critical assets that have not finished loading */
+    std::atomic<size_t> _criticalWait;
+    /** The cancellation flags for each directory loading asynchronously */
+    std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> _cancels;
 
     /**
      * Synchronously reads an asset category from a JSON file
@@ -151,12 +173,63 @@ protected:
      * to load, the callback function will be given the asset category name 
      * (e.g. "soundfx") as the asset key.
      *
+     * Each asset is queued with the priority specified in its JSON entry.
+     * Assets still in the queue are skipped if the cancel flag is set.
+     *
      * @param hash      The hash of the asset type
      * @param json      The child of asset directory with these assets
      * @param callback  An optional callback after each asset is loaded
+     * @param cancel    The cancellation flag for this directory
      */
     void readCategory(size_t hash, const std::shared_ptr<JsonValue>& json,
-                      LoaderCallback callback);
+                      LoaderCallback callback,
+                      const std::shared_ptr<std::atomic<bool>>& cancel);
+    
+    /**
+     * Queues a single asset from an asset directory in the thread pool.
+     *
+     * The asset is not given to its loader until its turn in the thread pool.
+     * Until then, it may be cancelled by setting the cancel flag.  The size
+     * of the asset is estimated when it is queued, and is used to weight
+     * the loading progress.
+     *
+     * @param loader    The loader for this asset
+     * @param json      The JSON entry for this asset
+     * @param callback  An optional callback after the asset is loaded
+     * @param cancel    The cancellation flag for this directory
+     * @param priority  The thread pool priority of this asset
+     */
+    void queueAsset(const std::shared_ptr<BaseLoader>& loader,
+                    const std::shared_ptr<JsonValue>& json,
+                    LoaderCallback callback,
+                    const std::shared_ptr<std::atomic<bool>>& cancel,
+                    int priority);
+    
+    /**
+     * Records that a directory asset is no longer waiting to load.
+     *
+     * If the asset was loaded, its bytes are added to the loaded total.
+     * Otherwise (e.g. it was cancelled), its bytes are removed from the
+     * total estimate.
+     *
+     * @param bytes     The estimated size of the asset in bytes
+     * @param critical  Whether the asset is critical
+     * @param loaded    Whether the asset was loaded
+     */
+    void finishAsset(size_t bytes, bool critical, bool loaded);
+    
+    /**
+     * Asynchronously loads all assets in the given directory.
+     *
+     * This method is the implementation of {@link loadDirectoryAsync}. The 
+     * cancel flag is shared by all of the assets in the directory.
+     *
+     * @param json      The JSON asset directory
+     * @param callback  An optional callback after each asset is loaded
+     * @param cancel    The cancellation flag for this directory
+     */
+    void readDirectory(const std::shared_ptr<JsonValue>& json, LoaderCallback callback,
+                       const std::shared_ptr<std::atomic<bool>>& cancel);
     
     /**
      * Immediately removes an asset category previously loaded from the JSON file
@@ -179,8 +252,13 @@ protected:
      * previously loaded assets (e.g. scene graphs).  In the current architecture,
      * this method is only correct if the asset manager loads assets in a
      * single thread.
+     *
+     * The barrier is queued at the given thread pool priority.  Therefore it
+     * only waits for those assets with a higher priority.
+     *
+     * @param priority  The thread pool priority of the barrier
      */
-    void sync();
+    void sync(int priority);
     
     /**
      * Blocks the asset manager until the next animation frame.
@@ -210,7 +288,9 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an asset 
      * manager on the heap, use one of the static constructors instead.
      */
-    AssetManager() : _preload(false), _wait(false) {}
+    AssetManager() : _preload(false), _wait(false), _pending(0), _directoryWait(0),
+    _totalBytes(0), _loadedBytes(0),
+    _criticalBytes(0), _criticalLoaded(0), _criticalWait(0) {}
     
     /**
      * Deletes this asset manager, disposing of all resources.
@@ -444,12 +524,50 @@ public:
      * loaded asynchronously and have not completed loading. It is not safe to 
      * use asynchronously loaded assets until all loading is complete.
      *
+     * Assets queued by an asset directory are weighted by their estimated
+     * size in bytes.  If no directory is loading asynchronously, this method
+     * counts each asset equally.  It also counts each asset equally while an
+     * asset loaded outside of a directory is waiting, as that asset has no
+     * size estimate.
+     *
      * @return the loader progress as a percentage.
      */
-    float progress() const  {
-        size_t size = loadCount()+waitCount();
-        return (size == 0 ? 0.0f : ((float)loadCount())/size);
+    float progress() const;
+    
+    /**
+     * Returns the number of critical assets waiting to load.
+     *
+     * An asset is critical if it is marked as such in an asset directory.
+     * The game may safely start once all critical assets are loaded, even
+     * if other assets are still streaming in.
+     *
+     * @return the number of critical assets waiting to load.
+     */
+    size_t criticalWaitCount() const {
+        return _preload ? _criticalWait+1 : _criticalWait.load();
     }
+    
+    /**
+     * Returns true if all critical assets have finished loading.
+     *
+     * An asset is critical if it is marked as such in an asset directory.
+     * The game may safely start once all critical assets are loaded, even
+     * if other assets are still streaming in.
+     *
+     * @return true if all critical assets have finished loading.
+     */
+    bool criticalComplete() const { return criticalWaitCount() == 0; }
+    
+    /**
+     * Returns the progress of the critical assets as a percentage.
+     *
+     * This method returns a value between 0 and 1, weighted by the estimated
+     * size of each critical asset.  A value of 1 means that all critical
+     * assets have been loaded (or that there are none).
+     *
+     * @return the progress of the critical assets as a percentage.
+     */
+    float criticalProgress() const;
 
     
 #pragma mark -
@@ -634,6 +752,49 @@ public:
         CUAssertLog(false, "No loader assigned for given type");
     }
 
+    /**
+     * Adds a new asset to the loading queue with the given priority.
+     *
+     * The type of the asset is specified by the template parameter T. Because
+     * the method is parameterized by the type, it is safe to reuse keys for
+     * different types.  However, this is not recommended.
+     *
+     * This method essentially calls {@link BaseLoader#loadAsync} in the
+     * appropriate loader. If there is no loader for the given type, the
+     * method will fail.
+     *
+     * The asset will be loaded asynchronously, but it will not be given to
+     * the loader until all queued assets of higher priority have started.
+     * When it is finished loading, it will be added to this loader, and 
+     * accessible under the given key. It is not safe to access the loaded 
+     * asset until it is complete.
+     *
+     * The optional callback function will be called with the asset status when
+     * the loading either completes or fails.
+     *
+     * @param key       The key to access the asset after loading
+     * @param source    The pathname to the asset source
+     * @param callback  An optional callback for when the asset is loaded.
+     * @param priority  The load priority (higher loads first)
+     */
+    template<typename T>
+    void loadAsync(const std::string& key, const std::string& source,
+                   LoaderCallback callback, int priority) {
+        size_t hash = typeid(T).hash_code();
+        auto it = _handlers.find(hash);
+        if (it != _handlers.end()) {
+            std::shared_ptr<BaseLoader> loader = it->second;
+            _pending++;
+            _workers->addTask([=](void) {
+                loader->loadAsync(key,source,callback);
+                this->_pending--;
+            },2*priority);
+            return;
+        }
+        
+        CUAssertLog(false, "No loader assigned for given type");
+    }
+
     /**
      * Adds a new asset to the loading queue.
      *
@@ -894,6 +1055,13 @@ public:
      * to load, the callback function will be given the asset category name
      * (e.g. "soundfx") as the asset key.
      *
+     * Each asset may specify an integer "priority" (default 0), and assets of
+     * higher priority are loaded first.  An asset may also be marked "critical"
+     * (in which case its default priority is 1). See {@link criticalComplete}.
+     * Scene graphs are loaded after all assets of the same or higher priority.
+     * Finally, an asset may specify its size in "bytes" to override the size
+     * estimate used by {@link progress}.
+     *
      * @param json      The JSON asset directory
      * @param callback  An optional callback after each asset is loaded
      */
@@ -928,6 +1096,13 @@ public:
      * to load, the callback function will be given the asset category name
      * (e.g. "soundfx") as the asset key.
      *
+     * Each asset may specify an integer "priority" (default 0), and assets of
+     * higher priority are loaded first.  An asset may also be marked "critical"
+     * (in which case its default priority is 1). See {@link criticalComplete}.
+     * Scene graphs are loaded after all assets of the same or higher priority.
+     * Finally, an asset may specify its size in "bytes" to override the size
+     * estimate used by {@link progress}.
+     *
      * @param directory The path to the JSON asset directory
      * @param callback  An optional callback after each asset is loaded
      */
@@ -962,6 +1137,13 @@ public:
      * to load, the callback function will be given the asset category name
      * (e.g. "soundfx") as the asset key.
      *
+     * Each asset may specify an integer "priority" (default 0), and assets of
+     * higher priority are loaded first.  An asset may also be marked "critical"
+     * (in which case its default priority is 1). See {@link criticalComplete}.
+     * Scene graphs are loaded after all assets of the same or higher priority.
+     * Finally, an asset may specify its size in "bytes" to override the size
+     * estimate used by {@link progress}.
+     *
      * @param directory The path to the JSON asset directory
      * @param callback  An optional callback after each asset is loaded
      */
@@ -1006,6 +1188,44 @@ public:
     bool unloadDirectory(const char* directory) {
         return unloadDirectory(std::string(directory));
     }
+    
+    /**
+     * Cancels all pending asynchronous loads for the given directory.
+     *
+     * Any asset in the directory that has not yet been handed to its loader
+     * will be skipped.  Assets that have already loaded (or are in the middle
+     * of loading) are unaffected; use {@link unloadDirectory} to remove them.
+     * Cancelled assets are removed from the progress estimates, and their
+     * callbacks are called with success set to false.
+     *
+     * @param directory The path to the JSON asset directory
+     */
+    void cancelDirectory(const std::string& directory);
+    
+    /**
+     * Cancels all pending asynchronous loads for the given directory.
+     *
+     * Any asset in the directory that has not yet been handed to its loader
+     * will be skipped.  Assets that have already loaded (or are in the middle
+     * of loading) are unaffected; use {@link unloadDirectory} to remove them.
+     * Cancelled assets are removed from the progress estimates, and their
+     * callbacks are called with success set to false.
+     *
+     * @param directory The path to the JSON asset directory
+     */
+    void cancelDirectory(const char* directory) {
+        cancelDirectory(std::string(directory));
+    }
+    
+    /**
+     * Cancels all pending asynchronous directory loads.
+     *
+     * This includes directories loaded from a {@link JsonValue}.  Assets that
+     * have already loaded (or are in the middle of loading) are unaffected.
+     * Cancelled assets are removed from the progress estimates, and their
+     * callbacks are called with success set to false.
+     */
+    void cancelAll();
 
 };
 
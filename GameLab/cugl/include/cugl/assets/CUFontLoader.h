@@ -80,6 +80,8 @@ protected:
     int _fontsize;
     /** The default atlas character set ("" for ASCII) */
     std::string _charset;
+    /** Whether atlases are signed distance fields by default */
+    bool _distance;
     
 #pragma mark Asset Loading
     /**
@@ -93,10 +95,12 @@ protected:
      * @param source    The pathname to the asset
      * @param charset   The atlas character set
      * @param size      The font size
+     * @param distance  Whether the atlas is a signed distance field
      *
      * @return the font asset with no generated atlas
      */
-    std::shared_ptr<Font> preload(const std::string& source, const std::string& charset, int size);
+    std::shared_ptr<Font> preload(const std::string& source, const std::string& charset,
+                                  int size, bool distance);
     
     /**
      * Creates an atlas for the font asset, and assigns it the given key.
@@ -179,6 +183,7 @@ protected:
      *      "file":         The path to the asset
      *      "size":         This font size (int)
      *      "charset":      The set of characters for the font atlas (string)
+     *      "sdf":          Whether the atlas is a signed distance field (bool)
      *
      * @param json      The directory entry for the asset
      * @param callback  An optional callback for asynchronous loading
@@ -487,6 +492,30 @@ public:
      * @param charset   The default atlas character set
      */
     void setCharacterSet(const std::string& charset) { _charset = charset; }
+    
+    /**
+     * Returns true if font atlases are signed distance fields by default
+     *
+     * A distance field font can be drawn crisply at any scale, so a single
+     * distance field font can replace several sizes of the same font. Once
+     * set, any font processed by this loader will use a distance field atlas
+     * unless otherwise specified. The default is false.
+     *
+     * @return true if font atlases are signed distance fields by default
+     */
+    bool usesDistanceField() const { return _distance; }
+    
+    /**
+     * Sets whether font atlases are signed distance fields by default
+     *
+     * A distance field font can be drawn crisply at any scale, so a single
+     * distance field font can replace several sizes of the same font. Once
+     * set, any font processed by this loader will use a distance field atlas
+     * unless otherwise specified. The default is false.
+     *
+     * @param distance  Whether font atlases are signed distance fields
+     */
+    void setDistanceField(bool distance) { _distance = distance; }
 };
 
 }
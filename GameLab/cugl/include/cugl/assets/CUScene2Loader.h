@@ -112,6 +112,10 @@ protected:
         SLIDER,
         /** A single-line text field type */
         TEXTFIELD,
+        /** A virtualized scroll list type */
+        SCROLLLIST,
+        /** A multiline label type */
+        MULTILINE,
 		/** A Node implied by an imported file */
 		EXTERNAL_IMPORT,
         /** An unsupported type */
@@ -39,7 +39,7 @@
 #define __CU_AUDIO_FADER_H__
 #include <SDL/SDL.h>
 #include "CUAudioNode.h"
-#include <mutex>
+#include <atomic>
 
 namespace cugl {
 
@@ -69,17 +69,81 @@ namespace cugl {
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
+ * The fade methods never block the audio thread.  Each one posts a command to
+ * a fixed-size queue, and the audio thread applies all pending commands at the
+ * start of the next {@link read}.  The state of each fade is published back to
+ * the main thread as a set of atomic flags.  As the commands are applied at
+ * the next read, a fade may start as much as one read buffer after the call.
+ *
  * This audio node supports the callback functions in {@link AudioNode#setCallback}.
  * This function function is called whenever a fade-in or fade-out has completed
  * successfully (without interruption).
  */
 class AudioFader : public AudioNode {
+public:
+    /** The maximum number of fade commands pending for the audio thread */
+    static const Uint32 COMMAND_CAPACITY = 32;
+
 protected:
+    /**
+     * The types of fade commands posted to the audio thread
+     */
+    enum class CommandType : Uint8 {
+        /** Starts (or cancels) a fade-in */
+        FADE_IN,
+        /** Starts (or cancels) a fade-out */
+        FADE_OUT,
+        /** Starts (or cancels) a fade-dip */
+        FADE_DIP,
+        /** Cancels the first half of a fade-dip */
+        RESUME,
+        /** Cancels all fades (except a persistent fade-out on a reset) */
+        CLEAR
+    };
+    
+    /**
+     * A fade command posted to the audio thread
+     */
+    struct Command {
+        /** The command type */
+        CommandType type;
+        /** The first duration in frames (-1 to cancel) */
+        Sint64 first;
+        /** The second duration in frames (fade-dip only) */
+        Sint64 second;
+        /** The command flag (wrap on a fade-out; keep on a clear) */
+        bool flag;
+    };
+    
+    /**
+     * The flags published by the audio thread to describe the fade state
+     */
+    enum Status : Uint32 {
+        /** There is an active fade-in */
+        FADING_IN  = 1,
+        /** There is an active fade-out */
+        FADING_OUT = 2,
+        /** There is an active fade-dip */
+        DIPPING    = 4,
+        /** The fade-dip has completed its first half */
+        DIP_HALF   = 8,
+        /** The node has completed due to a fade-out */
+        OUT_DONE   = 16,
+        /** The fade-out persists on a reset */
+        OUT_KEEP   = 32
+    };
+    
     /** The audio input node */
     std::shared_ptr<AudioNode> _input;
 
-    /** This class needs a proper lock guard; too many race conditions */
-    std::mutex _mutex;
+    /** The ring buffer of pending commands */
+    Command _commands[COMMAND_CAPACITY];
+    /** The index of the next command to apply (written only by the audio thread) */
+    std::atomic<Uint32> _cmdhead;
+    /** The index of the next command to post (written only by the main thread) */
+    std::atomic<Uint32> _cmdtail;
+    /** The fade state flags */
+    std::atomic<Uint32> _status;
     
     // Fade-in: For softer starts
     /** The final frame of the current fade-in; -1 if no active fade-in */
@@ -106,10 +170,55 @@ protected:
     Uint64 _dipstop;
     /** Whether we have completed the first half of a fade-dip */
     bool   _diphalf;
-    /** To prevent a race condition on pausing */
-    bool   _dipstart;
 
     
+    /**
+     * Posts a command to the audio thread.
+     *
+     * This method returns false if the command queue is full.
+     *
+     * @param type      The command type
+     * @param first     The first duration in frames (-1 to cancel)
+     * @param second    The second duration in frames (fade-dip only)
+     * @param flag      The command flag
+     *
+     * @return true if the command was posted
+     */
+    bool post(CommandType type, Sint64 first, Sint64 second=0, bool flag=false);
+    
+    /**
+     * Applies all commands posted since the last read.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     * The only exception is when the user needs to create a custom subclass
+     * of this AudioNode.
+     */
+    void apply();
+    
+    /**
+     * Cancels all active fades.
+     *
+     * The fade-out is not cancelled if keep is true and the fade-out was
+     * created with the wrap option.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     * The only exception is when the user needs to create a custom subclass
+     * of this AudioNode.
+     *
+     * @param keep  Whether to keep a wrapped fade-out
+     */
+    void cancel(bool keep);
+    
+    /**
+     * Cancels all active fades from the main thread.
+     *
+     * This method posts a command for {@link cancel} and updates the fade
+     * state flags immediately.
+     *
+     * @param keep  Whether to keep a wrapped fade-out
+     */
+    void interrupt(bool keep);
+    
     /**
      * Performs a fade-in.
      *
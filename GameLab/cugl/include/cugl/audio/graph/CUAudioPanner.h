@@ -61,6 +61,12 @@ namespace cugl {
  * output channel (or is dropped if that output channel does not exist).
  * The values of this matrix may be changed at any time.
  *
+ * The panning matrix is triple buffered so that neither thread blocks the
+ * other.  The main thread edits a master copy, and publishes it with an
+ * atomic swap.  The audio thread picks up the latest matrix at the start of
+ * each read, and uses it for the whole read.  A third buffer guarantees
+ * that the main thread never writes to the matrix being read.
+ *
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
@@ -78,8 +84,14 @@ private:
     
     /** The audio input node */
     std::shared_ptr<AudioNode> _input;
-    /** The panning matrix */
-    std::atomic<float>* _mapper;
+    /** The panning matrices (the master copy followed by three buffers) */
+    float* _matrix;
+    /** The buffer index shared by the two threads (with a dirty bit) */
+    std::atomic<Uint32> _shared;
+    /** The buffer index written by the main thread */
+    Uint32 _back;
+    /** The buffer index read by the audio thread */
+    Uint32 _front;
 
 #pragma mark -
 #pragma mark Constructors
@@ -274,6 +286,9 @@ public:
      * that is sent to the given output channel.  Technically, this value
      * can be more than 1, but it cannot be negative.
      *
+     * The change is copied to a fresh matrix and published to the audio
+     * thread, which uses it at the start of its next read.
+     *
      * @param field     The input channel
      * @param channel   The output channel
      * @param value     The percentage gain
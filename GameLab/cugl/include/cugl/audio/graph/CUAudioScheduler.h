@@ -36,6 +36,7 @@
 #include "CUAudioNode.h"
 #include "CUAudioPlayer.h"
 #include <functional>
+#include <vector>
 #include <deque>
 
 namespace cugl {
@@ -54,61 +55,79 @@ namespace cugl {
  * This class provides is a lock free producer-consumer queue,
  *
  * This queue allows us to add buffers to the source node without interrupting
- * playback.  Its implementation is taken from
- *
- * http://www.drdobbs.com/parallel/writing-lock-free-code-a-corrected-queue/210604448
+ * playback.  It is a fixed-capacity ring buffer, so that neither thread ever
+ * allocates memory to add or remove an entry.  The capacity is always a power
+ * of two, and is set when the queue is created.
  *
  * This queue is only designed to support two threads. The producer is the main
- * thread, while the consumer is the audio thread.
+ * thread, while the consumer is the audio thread.  The consumer never releases
+ * an entry.  Removed entries are released by the producer on its next call to
+ * {@link push}, so the last reference to an audio node is never dropped in
+ * the audio thread.  The two most recently removed entries are retained even
+ * longer, as they are typically still playing in the consumer.
  *
  * This queue does not have a lot of bells and whistles because it is only
  * intended for thread synchronization.  We expect the user to maintain what
  * has and has not been appended to the queue.
  */
 class AudioNodeQueue {
-private:
+public:
     /**
      * An entry in the queue for this player.
      *
-     * Queued entries remember their gain and loop status
+     * Queued entries remember their loop status and their start time
      */
     struct Entry {
         /** The audio source for this entry */
         std::shared_ptr<AudioNode> value;
-        /** Whether to loop this audio node */
+        /** The number of times to loop this audio node */
         Sint32 loops;
-        /** THe next entry in the queue (or null if at end) */
-        Entry* next;
+        /** The frame at which to start this audio node (-1 if untimed) */
+        Sint64 start;
         
         /**
-         * Appends an entry for the given audio node
-         *
-         * The loop value is an integer.  If it is 0, the audio node will not
-         * be looped.  If it is positive, it will loop the audio that many
-         * (additional) times.  If it is negative, the audio node will be
-         * looped indefinitely until it is stopped.
-         *
-         * @param node  The audio node
-         * @param loop  The number of times to loop the audio
+         * Creates an empty entry
          */
-        Entry(const std::shared_ptr<AudioNode>& node, Sint32 loop) :
-            value(node), loops(loop), next(nullptr) { }
+        Entry() : value(nullptr), loops(0), start(-1) { }
     };
     
-    /** THe first element int the queue */
-    Entry* _first;
-    /** Pointer to the front of the queue (to remove elements) */
-    std::atomic<Entry*> _divide;
-     /** Pointer to the end of the queue (to add elements) */
-    std::atomic<Entry*> _last;
+    /** The default capacity of a queue */
+    static const Uint32 QUEUE_CAPACITY = 64;
+
+private:
+    /** The ring buffer of entries */
+    std::vector<Entry> _entries;
+    /** The bit mask for a ring buffer index */
+    Uint32 _mask;
+    /** The index of the front of the queue (written only by the consumer) */
+    std::atomic<Uint32> _head;
+    /** The index of the end of the queue (written only by the producer) */
+    std::atomic<Uint32> _tail;
+    /** The index of the first entry not purged by the producer */
+    std::atomic<Uint32> _purge;
+    /** The index of the first unreleased entry (producer only) */
+    Uint32 _reclaim;
     
+    /**
+     * Returns the index of the front of the queue, applying any purge.
+     *
+     * This is a consumer method.
+     *
+     * @return the index of the front of the queue, applying any purge.
+     */
+    Uint32 front() const;
     
 public:
 #pragma mark Constructors
     /**
-     * Creates an empty player queue
+     * Creates an empty player queue with the given capacity
+     *
+     * The capacity is rounded up to the nearest power of two.  All of the
+     * memory for the queue is allocated at this time.
+     *
+     * @param capacity  The maximum number of entries in the queue
      */
-    AudioNodeQueue();
+    AudioNodeQueue(Uint32 capacity=QUEUE_CAPACITY);
     
     /**
      * Disposes of the player queue, releasing all resources
@@ -124,7 +143,24 @@ public:
      *
      * @return true if the queue is empty.
      */
-    bool empty() const { return _divide == _last; }
+    bool empty() const { return size() == 0; }
+    
+    /**
+     * Returns the number of entries in this queue.
+     *
+     * This method is atomic and thread-safe.  However, the value is only a
+     * snapshot, and may be out of date if the other thread is active.
+     *
+     * @return the number of entries in this queue.
+     */
+    Uint32 size() const;
+    
+    /**
+     * Returns the maximum number of entries in this queue.
+     *
+     * @return the maximum number of entries in this queue.
+     */
+    Uint32 capacity() const { return _mask-1; }
     
     /**
      * Adds an entry to the end of this queue.
@@ -134,12 +170,20 @@ public:
      * (additional) times.  If it is negative, the audio node will be
      * looped indefinitely until it is stopped.
      *
-     * This method is thread-safe
+     * The start value is the frame at which the consumer should start the
+     * audio node.  It is -1 if the audio node should start as soon as the
+     * previous one has completed.
+     *
+     * This method is thread-safe, but it is a producer method.  It returns
+     * false if the queue is full.
      *
      * @param node  The node to be scheduled
-     * @param loops	The number of times to loop the audio
+     * @param loops The number of times to loop the audio
+     * @param start The frame at which to start the audio
+     *
+     * @return true if the entry was added
      */
-    void push(const std::shared_ptr<AudioNode>& node, Sint32 loops=0);
+    bool push(const std::shared_ptr<AudioNode>& node, Sint32 loops=0, Sint64 start=-1);
 
     /**
      * Looks at the front element this queue.
@@ -148,7 +192,7 @@ public:
      * is nothing to see, the pointer will store null and the method will
      * return false.
      *
-     * This method is thread-safe
+     * This method is thread-safe, but it is a consumer method.
      *
      * @param node  the pointer to store the audio node
      * @param loop  the pointer to store the number of loops
@@ -157,6 +201,20 @@ public:
      */
     bool peek(std::shared_ptr<AudioNode>& node, Sint32& loop) const;
     
+    /**
+     * Looks at the front element this queue.
+     *
+     * The element will be copied into the given entry.  If there is nothing
+     * to see, the entry is not altered and the method will return false.
+     *
+     * This method is thread-safe, but it is a consumer method.
+     *
+     * @param entry the entry to store the result
+     *
+     * @return true if the operation was successful
+     */
+    bool peek(Entry& entry) const;
+    
     /**
      * Removes an entry from the front of this queue.
      *
@@ -164,7 +222,7 @@ public:
      * is nothing to remove, the pointer will store null and the method will
      * return false.
      *
-     * This method is thread-safe
+     * This method is thread-safe, but it is a consumer method.
      *
      * @param node  the pointer to store the audio node
      * @param loop  the pointer to store the number of loops
@@ -173,14 +231,27 @@ public:
      */
     bool pop(std::shared_ptr<AudioNode>& node, Sint32& loop);
     
+    /**
+     * Removes an entry from the front of this queue.
+     *
+     * The element will be copied into the given entry.  If there is nothing
+     * to remove, the entry is not altered and the method will return false.
+     *
+     * This method is thread-safe, but it is a consumer method.
+     *
+     * @param entry the entry to store the result
+     *
+     * @return true if the operation was successful
+     */
+    bool pop(Entry& entry);
+    
     /**
      * Stores all values in the provided dequeue.
      *
      * This method only stores the values, not the loop settings. If the queue is
      * empty, the deque is not altered and this method returns false.
      *
-     * This method is thread-safe ASSUMING that {@link push} is only ever called in
-     * the same thread (e.g. this is a producer method).
+     * This method is thread-safe, but it is a producer method.
      *
      * @param container the container to store the values
      *
@@ -188,12 +259,24 @@ public:
      */
     bool fill(std::deque<std::shared_ptr<AudioNode>>& container) const;
     
+    /**
+     * Removes all but the last size elements of this queue.
+     *
+     * The removed elements are only flagged.  They are skipped by the next
+     * consumer method, and released by a later call to {@link push}.
+     *
+     * This method is thread-safe, but it is a producer method.
+     *
+     * @param size  The number of elements to keep
+     */
+    void trim(Uint32 size);
+    
     /**
      * Clears all elements in this queue.
      *
-     * This method is thread-safe
+     * This method is thread-safe, but it is a producer method.
      */
-    void clear();
+    void clear() { trim(0); }
 };
     
     
@@ -215,6 +298,13 @@ public:
  * user to look at the contents of the queue.  The user can only look at
  * the currently playing node.
  *
+ * Nodes may either be appended, in which case they start as soon as the
+ * previous node completes, or scheduled at an absolute frame of the scheduler
+ * clock with {@link #schedule}.  Scheduled nodes start on exactly that frame,
+ * with silence filling any gap.  If the current node is still playing at
+ * that frame, it is cut off, cross-fading over the {@link #getOverlap}
+ * time.  This allows stems to be queued bar-by-bar without any gaps.
+ *
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
@@ -224,7 +314,35 @@ public:
  * {@link AudioScheduler#read()} result that returns 0) or it was interrupted.
  */
 class AudioScheduler : public AudioNode {
+public:
+    /** The maximum number of nodes retained by a mark */
+    static const Uint32 MEMORY_CAPACITY = 32;
+
 private:
+    /**
+     * A node retained by a mark, for replay on a reset.
+     */
+    struct Retained {
+        /** The retained audio node */
+        std::shared_ptr<AudioNode> node;
+        /** The number of times to loop the audio node */
+        Sint32 loops;
+        /** The frame at which to start the audio node (-1 if untimed) */
+        Sint64 start;
+    };
+
+    /**
+     * The commands processed by the audio thread at the next read
+     */
+    enum Command : Uint32 {
+        /** Mark the current position */
+        MARK   = 1,
+        /** Clear the current mark */
+        UNMARK = 2,
+        /** Return to the current mark */
+        RESET  = 4
+    };
+    
     /** The currently active audio node */
     std::shared_ptr<AudioNode> _current;
     /** The previously active audio node  (for overlaps) */
@@ -235,17 +353,33 @@ private:
     std::atomic<Uint32> _overlap;
     /** A buffer to handle the overlap (as necessary) */
     float* _buffer;
+    /** The size of the overlap buffer in frames */
+    Uint32 _bufsize;
+    /** The number of frames remaining in the current cross-fade */
+    Uint32 _fade;
+    /** The length of the current cross-fade in frames */
+    Uint32 _fadelen;
+    /** The action to report when the previous node finishes fading */
+    Action _fadeact;
 
     /** The queue of all sources waiting to be played next */
     AudioNodeQueue _queue;
-    
-    /** Counter to track queue size */
-    std::atomic<Uint32> _qsize;
     /** Counter to track queue skips (for clearing or advancement) */
     std::atomic<Uint32> _qskip;
+    
+    /** The number of frames read since initialization (or the last reset) */
+    std::atomic<Sint64> _clock;
+    /** The pending commands for the audio thread */
+    std::atomic<Uint32> _command;
+    /** Whether this scheduler currently has a mark */
+    std::atomic<bool> _marked;
+    /** The clock value at the current mark */
+    std::atomic<Sint64> _markclock;
 
     /** Stored results after a mark is set */
-    std::deque<std::shared_ptr<AudioNode>> _memory;
+    std::vector<Retained> _memory;
+    /** The number of stored results after a mark */
+    Uint32 _memsize;
     /** The current position in the mark memory; -1 if inactive */
     Sint64 _mempos;
     
@@ -373,6 +507,51 @@ public:
      */
     void append(const std::shared_ptr<AudioNode>& node, Sint32 loop = 0);
     
+    /**
+     * Schedules a new audio node to start at the given frame.
+     *
+     * This method appends to the node to the playback queue.  Unlike
+     * {@link #append}, the node does not start when the previous node has
+     * completed.  Instead, it starts on exactly the given frame of the
+     * scheduler clock (see {@link #getClock}).  If the previous node
+     * completes early, the scheduler is silent until that frame.  If the
+     * previous node is still playing, it is interrupted, cross-fading with
+     * the new node over the {@link #getOverlap} time.
+     *
+     * Scheduled nodes must be added in increasing order of their start
+     * frame.  A node scheduled for a frame that has already passed starts
+     * immediately once it reaches the front of the queue.
+     *
+     * The loop value is an integer.  If it is 0, the audio node will not
+     * be looped.  If it is positive, it will loop the audio that many
+     * (additional) times.  If it is negative, the audio node will be
+     * looped indefinitely until it is stopped or the next node starts.
+     *
+     * If the user has provided an optional callback function, this will be
+     * called when the node is removed, either because it completed (defined
+     * by {@link AudioNode#completed()}) or is interrupted.
+     *
+     * @param node  The audio node for playback
+     * @param frame The clock frame at which to start the node
+     * @param loop  The number of times to loop the audio
+     */
+    void schedule(const std::shared_ptr<AudioNode>& node, Uint64 frame, Sint32 loop = 0);
+    
+    /**
+     * Returns the current frame of the scheduler clock.
+     *
+     * The clock is the number of frames read from this scheduler since it
+     * was initialized.  It does not advance while the scheduler is paused,
+     * and it returns to the marked frame on a call to {@link #reset}.  It is
+     * the time line for {@link #schedule}.
+     *
+     * This method is thread safe, but the value may be out of date by as
+     * much as one read buffer.
+     *
+     * @return the current frame of the scheduler clock.
+     */
+    Uint64 getClock() const;
+    
     /**
      * Returns the audio node currently being played.
      *
@@ -423,7 +602,10 @@ public:
      * Empties the queue without stopping the current playback.
      *
      * This method is useful when we want to clear the queue, but to smoothly
-     * fade-out the current playback.
+     * fade-out the current playback.  If size is non-negative, this method
+     * only removes the oldest entries, keeping the last size entries.
+     *
+     * @param size    The number of entries to keep (-1 for none)
      */
     void trim(Sint32 size = -1);
     
@@ -524,8 +706,6 @@ public:
      * @param loop  The number of times to loop the audio
      */
     void setLoops(Sint32 loop);
-    
-    // TODO: Add cross-fade support
 
 
 #pragma mark Overriden Methods
@@ -553,19 +733,23 @@ public:
      * Marks the current read position in the audio steam.
      *
      * DELEGATED METHOD: This method delegates its call to the current audio
-     * node.  It returns false if there is no active node or if this method is
-     * unsupported.
+     * node.  It returns false if the scheduler is not initialized.
      *
      * Once this method is called, the scheduler will mark the current audio
      * node and buffer all subsequent audio nodes. It will create a secondary
      * queue to prevent these nodes from being released. A call to the method
      * {@link reset()} will return to the marked position of the current audio
      * node and replay all subsequent audio nodes before returning to the audio
-     * queue.
+     * queue.  The scheduler clock also returns to the marked frame, so that
+     * scheduled nodes replay on the same frames.
      *
      * This secondary queue will continue accumulating audio nodes until
-     * {@link unmark()} is called.  It is not recommended for a marks to
-     * remain indefinitely.
+     * {@link unmark()} is called, or until it holds {@link MEMORY_CAPACITY}
+     * nodes.  The secondary queue is allocated ahead of time, so the audio
+     * thread never allocates memory to retain a node.
+     *
+     * The mark is applied by the audio thread at the start of the next read,
+     * and so it may be as much as one read buffer after this call.
      *
      * @return true if the read position was marked.
      */
@@ -588,12 +772,16 @@ public:
      * Resets the read position to the marked position of the audio stream.
      *
      * DELEGATED METHOD: This method delegates its call to the current audio
-     * node.  It returns false if there is no active node or if this method is
-     * unsupported.
+     * node.  It returns false if there is no current mark.
      *
      * This method returns the playback to the audio node and position set
-     * by a call to {@link mark()}.  If mark has not been called, this method
-     * has no effect.
+     * by a call to {@link mark()}.  All nodes played since the mark are
+     * replayed, with the same loops and start frames, before returning to
+     * the audio queue.  If mark has not been called, this method has no
+     * effect.
+     *
+     * The reset is applied by the audio thread at the start of the next read.
+     * Any cross-fade in progress is cut short.
      *
      * @return true if the read position was moved.
      */
@@ -629,9 +817,8 @@ public:
     /**
      * Returns the current frame position of this audio node.
      *
-     * DELEGATED METHOD: This method delegates its call to the current audio
-     * node.  It returns -1 if there is no active node or if this method is
-     * unsupported.
+     * This method returns -1 unless {@link mark()} is called.  All frame
+     * positions are the frames read since the marked position.
      *
      * This method is thread safe, and may be called outside the audio thread.
      * However, the accuracy of the result on a non-paused audio source is
@@ -674,11 +861,7 @@ public:
     /**
      * Returns the elapsed time in seconds.
      *
-     * DELEGATED METHOD: This method delegates its call to the current audio
-     * node.  It returns -1 if there is no active node or if this method is
-     * unsupported.
-     *
-     * This method has no effect unless {@link mark()} is called.  All time
+     * This method returns -1 unless {@link mark()} is called.  All time
      * is relative from the marked position.
      *
      * This method is thread safe, and may be called outside the audio thread.
@@ -740,6 +923,98 @@ private:
      * @return the next audio instance for playback
      */
     std::shared_ptr<AudioNode> acquire(Sint32& loop, Uint32 skip=0, Action action=Action::COMPLETE);
+    
+    /**
+     * Returns true if there is an audio node waiting to be played.
+     *
+     * Nodes waiting in the mark memory (during a replay) come before the
+     * nodes in the queue.  If there is a node, its start frame is stored in
+     * the reference variable.  This is -1 if the node is not scheduled.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param start     Reference variable to store the start frame
+     *
+     * @return true if there is an audio node waiting to be played.
+     */
+    bool pending(Sint64& start);
+    
+    /**
+     * Returns the next audio node waiting to be played.
+     *
+     * Nodes waiting in the mark memory (during a replay) come before the
+     * nodes in the queue.  A node taken from the queue while there is a mark
+     * is retained in the mark memory.  If there is no node, this method
+     * returns nullptr.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param loop      Reference variable to store the number of loops
+     *
+     * @return the next audio node waiting to be played.
+     */
+    std::shared_ptr<AudioNode> next(Sint32& loop);
+    
+    /**
+     * Starts the next scheduled node, interrupting the current one.
+     *
+     * If the overlap is positive, the current node becomes the previous node,
+     * and fades out over the overlap.  Any fade in progress is cut short.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param current   Reference variable for the current node
+     * @param loop      Reference variable for the number of loops
+     * @param overlap   The overlap in frames
+     */
+    void cue(std::shared_ptr<AudioNode>& current, Sint32& loop, Uint32 overlap);
+    
+    /**
+     * Handles the completion of the current node.
+     *
+     * If the node has loops remaining, it is reset.  Otherwise, it is
+     * replaced by the next node, provided that node is not scheduled.  If
+     * the next node is scheduled, the current node is set to nullptr until
+     * the start frame.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param current   Reference variable for the current node
+     * @param loop      Reference variable for the number of loops
+     * @param looped    Whether the current node just looped back
+     */
+    void finish(std::shared_ptr<AudioNode>& current, Sint32& loop, bool& looped);
+    
+    /**
+     * Mixes the previous node into the output for a cross-fade.
+     *
+     * The previous node must have been read into the overlap buffer.  The
+     * output is the current node faded in, mixed with the previous node
+     * faded out.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param output    The output buffer with the current node
+     * @param frames    The number of frames to mix
+     */
+    void blend(float* output, Uint32 frames);
+    
+    /**
+     * Processes the commands from {@link mark}, {@link unmark}, and {@link reset}.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     *
+     * @param current   Reference variable for the current node
+     * @param loop      Reference variable for the number of loops
+     */
+    void command(std::shared_ptr<AudioNode>& current, Sint32& loop);
+    
+    /**
+     * Releases all of the nodes in the mark memory.
+     *
+     * AUDIO THREAD ONLY: This is an internal method for queue management.
+     */
+    void forget();
 };
     }
 }
@@ -176,6 +176,12 @@ private:
     Timestamp _start;
     /** The timestamp for the end of an animation frame */
     Timestamp _finish;
+    /** The timestamp for the call to init() */
+    Timestamp _launch;
+    /** The microseconds from init() to the first presented frame (0 if none yet) */
+    Uint64 _firstframe;
+    /** Whether to skip presenting the current animation frame */
+    bool _skipframe;
     
     /** Counter to assign unique keys to callbacks */
     Uint32 _funcid;
@@ -372,6 +378,20 @@ public:
      */
     void quit();
     
+    /**
+     * Skips presenting the current animation frame.
+     *
+     * This method should be called in {@link draw()}.  The display will not
+     * be refreshed at the end of this animation frame, so the previously
+     * presented frame stays on screen.  This is useful for static screens,
+     * where the application can call this method whenever
+     * {@link scene2::Scene2#hasDamage} is false, saving both the draw and
+     * the buffer swap.
+     *
+     * This flag is reset at the start of every animation frame.
+     */
+    void skipFrame() { _skipframe = true; }
+    
     /**
      * Schedules a reoccuring callback function time milliseconds in the future.
      *
@@ -745,6 +765,20 @@ public:
      */
     float getAverageFPS() const;
     
+    /**
+     * Returns the number of microseconds from init() to the first frame.
+     *
+     * This is the time-to-first-frame of the application: the time from the
+     * creation of the OpenGL context until the first call to draw() has been
+     * presented to the display.  It includes all of onStartup(). It is useful
+     * for profiling start-up, such as any {@link Bootstrap} graph.
+     *
+     * This value is 0 if no frame has been presented yet.
+     *
+     * @return the number of microseconds from init() to the first frame.
+     */
+    Uint64 getTimeToFirstFrame() const { return _firstframe; }
+    
     /**
      * Sets the clear color of this application
      *
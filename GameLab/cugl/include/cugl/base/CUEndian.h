@@ -9,6 +9,9 @@
 //  All of the functions in this header are idempotent. To decode a previously
 //  encoded piece of data, use the function again.
 //
+//  The array functions encode an entire array in place.  They are not inline,
+//  as they use vector byte shuffles when vectorization is enabled.
+//
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
 //      warranty.  In no event will the authors be held liable for any damages
@@ -34,6 +37,7 @@
 #ifndef __CU_SENDIAN_H__
 #define __CU_SENDIAN_H__
 #include <SDL/SDL.h>
+#include <cstddef>
 
 namespace cugl {
 
@@ -219,5 +223,127 @@ SDL_FORCE_INLINE double marshall(double value) {
 #endif
 }
 
+#pragma mark -
+#pragma mark Array Encoding
+/**
+ * Encodes the given array of 16 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Sint16* array, size_t length);
+
+/**
+ * Encodes the given array of 16 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Uint16* array, size_t length);
+
+/**
+ * Encodes the given array of 32 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Sint32* array, size_t length);
+
+/**
+ * Encodes the given array of 32 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Uint32* array, size_t length);
+
+/**
+ * Encodes the given array of 64 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Sint64* array, size_t length);
+
+/**
+ * Encodes the given array of 64 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(Uint64* array, size_t length);
+
+/**
+ * Encodes the given array of floats in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(float* array, size_t length);
+
+/**
+ * Encodes the given array of doubles in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void marshall(double* array, size_t length);
+
 }
 #endif /* __CU_ENDIAN_H__ */
@@ -17,6 +17,9 @@
 //  have proper file systems.  You should confine all files to either the asset
 //  or the save directory.
 //
+//  This reader recognizes the compressed files of BinaryWriter, and decodes
+//  them automatically.  Each block is verified against its CRC32 checksum.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -75,6 +78,11 @@ namespace cugl {
  * for the file name.  Keep in mind that absolute paths are very dangerous on
  * mobile devices, because they do not have proper file systems.  You should
  * confine all files to either the asset or the save directory.
+ *
+ * This reader recognizes files written by a compressed {@link BinaryWriter}.
+ * It decodes such files a block at a time, and verifies each block against
+ * its checksum.  If a block is corrupt, the reader logs an error and treats
+ * the block as the end of the file.
  */
 class BinaryReader {
 protected:
@@ -96,13 +104,60 @@ protected:
     /** The current offset in the read buffer */
     Sint32      _bufoff;
     
+    /** Whether the file is compressed */
+    bool        _compressed;
+    /** The maximum size of a decoded block (0 if not compressed) */
+    Uint32      _blocksize;
+    /** The buffer for reading a compressed block */
+    Uint8*      _packed;
+    
 #pragma mark -
 #pragma mark Internal Methods
+    /**
+     * Returns true if the file stream is opened successfully.
+     *
+     * This method opens the file at the stored path and allocates the
+     * buffers.  It also reads the header of a compressed file.
+     *
+     * @return true if the file stream is opened successfully.
+     */
+    bool open();
+    
+    /**
+     * Reads a sequence of elements of the given size from the stream.
+     *
+     * The function will attempt to read up to maximum number of elements.
+     * It will return the actual number of elements read (which may be 0).
+     * Elements of more than one byte are marshalled from network order
+     * with a single pass over the array.
+     *
+     * @param buffer    The array to store the data when read
+     * @param maximum   The maximum number of elements to read from the stream
+     * @param bytes     The size of each element in bytes
+     *
+     * @return the number of elements read from the stream
+     */
+    size_t readArray(void* buffer, size_t maximum, unsigned int bytes);
+    
+    /**
+     * Returns true if the next block of a compressed file was decoded.
+     *
+     * The block is appended to the storage buffer, which must have room
+     * for a full block.  If the block is corrupt, this method logs an error
+     * and returns false.
+     *
+     * @return true if the next block of a compressed file was decoded.
+     */
+    bool readBlock();
+    
     /**
      * Fills the storage buffer to capacity
      *
      * This cuts down on the number of reads to the file by allowing us
-     * to read from the file in predefined chunks.
+     * to read from the file in predefined chunks.  It does nothing if the
+     * buffer already holds the given number of bytes.  Otherwise, it reads
+     * (or decodes whole blocks) until the buffer holds at least that many
+     * bytes, or the stream ends.
      *
      * @param bytes The minimum number of bytes to ensure in the stream
      */
@@ -119,7 +174,8 @@ public:
      * the heap, use one of the static constructors instead.
      */
     BinaryReader() : _name(""), _stream(nullptr), _ssize(-1), _scursor(-1),
-                     _buffer(nullptr), _capacity(0), _bufoff(-1), _bufsize(0) {}
+                     _buffer(nullptr), _capacity(0), _bufsize(0), _bufoff(-1),
+                     _compressed(false), _blocksize(0), _packed(nullptr) {}
     
     /**
      * Deletes this reader and all of its resources.
@@ -271,6 +327,13 @@ public:
     
 #pragma mark -
 #pragma mark Stream Management
+    /**
+     * Returns true if the file was written by a compressed writer.
+     *
+     * @return true if the file was written by a compressed writer.
+     */
+    bool isCompressed() const { return _compressed; }
+    
     /**
      * Resets the stream back to the beginning
      *
@@ -293,6 +356,9 @@ public:
      * This method will return false if the stream is closed, or if there are
      * too few bytes remaining.
      *
+     * For a compressed file, the size of the blocks that are not yet decoded
+     * is read from their headers.  This requires a seek, but no decoding.
+     *
      * @param bytes The number of bytes required
      *
      * @return true if there is enough data left to read
@@ -17,6 +17,11 @@
 //  have proper file systems.  You should confine all files to either the asset
 //  or the save directory.
 //
+//  A writer may optionally compress its output.  A compressed file is a
+//  sequence of independently compressed blocks, each with a CRC32 checksum.
+//  The block compression and file writes may also run on a worker thread,
+//  so that large save and replay files do not stall the main thread.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -55,6 +60,13 @@
 #include <cugl/base/CUBase.h>
 #include <SDL/SDL.h>
 #include <string>
+#include <atomic>
+#include <functional>
+
+namespace cugl {
+    /** Forward reference to the worker thread */
+    class ThreadPool;
+}
 
 namespace cugl {
     
@@ -75,6 +87,19 @@ namespace cugl {
  * for the file name.  Keep in mind that absolute paths are very dangerous on
  * mobile devices, because they do not have proper file systems.  You should
  * confine all files to either the asset or the save directory.
+ *
+ * A compressed writer splits its output into blocks of the buffer capacity.
+ * Each block is compressed on its own and stored with a CRC32 checksum of
+ * its contents.  A {@link BinaryReader} recognizes compressed files and
+ * decodes them automatically.  Compression works best with a large buffer
+ * capacity, such as 64 KB.
+ *
+ * An asynchronous writer hands each full buffer to a worker thread, which
+ * compresses and writes it to the file.  The write methods never wait on
+ * the file, unless the worker falls several blocks behind.  Use the method
+ * {@link #closeAsync} to be notified when the file is complete.  While the
+ * write methods may be called from any thread, they may only be called from
+ * one thread at a time.
  */
 class BinaryWriter {
 protected:
@@ -89,6 +114,53 @@ protected:
     Uint32      _capacity;
     /** The current offset in the writer buffer */
     Sint32      _bufoff;
+    
+    /** Whether the blocks are compressed and checksummed */
+    bool        _compressed;
+    /** The buffer for compressing a block (used by the thread writing blocks) */
+    Uint8*      _packed;
+    /** The worker thread for asynchronous writes (nullptr if synchronous) */
+    std::shared_ptr<ThreadPool> _worker;
+    /** The number of blocks waiting for the worker thread */
+    std::atomic<Uint32> _pending;
+    /** Whether any block failed to write */
+    std::atomic<bool>   _failed;
+
+#pragma mark -
+#pragma mark Internal Methods
+    /**
+     * Writes an array of elements of the given size to the binary file.
+     *
+     * Elements of more than one byte are marshalled to network order with
+     * a single pass over each buffered chunk.
+     *
+     * @param array     the array of elements to write
+     * @param length    the number of elements to write
+     * @param bytes     the size of each element in bytes
+     */
+    void writeArray(const void* array, size_t length, unsigned int bytes);
+    
+    /**
+     * Returns true if the given block was written to the file.
+     *
+     * If the writer is compressed, this method compresses the block and
+     * writes it with its header.  Otherwise, it writes the raw bytes.  For
+     * an asynchronous writer, this method is only called by the worker.
+     *
+     * @param stream    the file stream to write to
+     * @param data      the block to write
+     * @param length    the number of bytes in the block
+     *
+     * @return true if the given block was written to the file.
+     */
+    bool writeBlock(SDL_RWops* stream, const char* data, size_t length);
+    
+    /**
+     * Blocks until the worker thread has written every queued block.
+     *
+     * This method does nothing for a synchronous writer.
+     */
+    void drain();
 
     
 #pragma mark -
@@ -100,7 +172,8 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    BinaryWriter() : _name(""), _stream(nullptr), _cbuffer(nullptr), _bufoff(-1) {}
+    BinaryWriter() : _name(""), _stream(nullptr), _cbuffer(nullptr), _capacity(0), _bufoff(-1),
+                     _compressed(false), _packed(nullptr), _pending(0), _failed(false) {}
     
     /**
      * Deletes this writer and all of its resources.
@@ -143,6 +216,28 @@ public:
      */
     bool init(const std::string file, unsigned int capacity);
     
+    /**
+     * Initializes a writer for the given file with the specified options.
+     *
+     * If compress is true, the file is written as a sequence of compressed
+     * blocks, each of the given capacity.  If async is true, the blocks are
+     * compressed and written on a worker thread.
+     *
+     * If the file is a relative path, this reader will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to write a file in any other directory, you must provide
+     * an absolute path. Be warned, however, that write priviledges are
+     * heavily restricted on mobile platforms.
+     *
+     * @param file      the path (absolute or relative) to the file
+     * @param capacity  the buffer capacity for writing chunks
+     * @param compress  whether to compress and checksum the file
+     * @param async     whether to write the file on a worker thread
+     *
+     * @return true if the writer is initialized properly, false otherwise.
+     */
+    bool init(const std::string file, unsigned int capacity, bool compress, bool async=false);
+    
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -186,9 +281,49 @@ public:
         return (result->init(file,capacity) ? result : nullptr);
     }
     
+    /**
+     * Returns a newly allocated writer for the given file with the specified options.
+     *
+     * If compress is true, the file is written as a sequence of compressed
+     * blocks, each of the given capacity.  If async is true, the blocks are
+     * compressed and written on a worker thread.
+     *
+     * If the file is a relative path, this reader will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to write a file in any other directory, you must provide
+     * an absolute path. Be warned, however, that write priviledges are
+     * heavily restricted on mobile platforms.
+     *
+     * @param file      the path (absolute or relative) to the file
+     * @param capacity  the buffer capacity for writing chunks
+     * @param compress  whether to compress and checksum the file
+     * @param async     whether to write the file on a worker thread
+     *
+     * @return a newly allocated writer for the given file with the specified options.
+     */
+    static std::shared_ptr<BinaryWriter> alloc(const std::string file, unsigned int capacity,
+                                               bool compress, bool async=false) {
+        std::shared_ptr<BinaryWriter> result = std::make_shared<BinaryWriter>();
+        return (result->init(file,capacity,compress,async) ? result : nullptr);
+    }
+    
     
 #pragma mark -
 #pragma mark Stream Management
+    /**
+     * Returns true if this writer compresses and checksums its blocks.
+     *
+     * @return true if this writer compresses and checksums its blocks.
+     */
+    bool isCompressed() const { return _compressed; }
+    
+    /**
+     * Returns true if this writer writes its blocks on a worker thread.
+     *
+     * @return true if this writer writes its blocks on a worker thread.
+     */
+    bool isAsync() const { return _worker != nullptr; }
+    
     /**
      * Flushes the contents of the write buffer to the file.
      *
@@ -203,8 +338,30 @@ public:
      * The contents of the buffer are flushed before the file is closed.  Any
      * attempts to write to a closed stream will fail.  Calling this method
      * on a previously closed stream has no effect.
+     *
+     * For an asynchronous writer, this method blocks until the worker has
+     * written every block.
      */
     void close();
+    
+    /**
+     * Closes the stream, calling the callback when the file is complete.
+     *
+     * The contents of the buffer are flushed before the file is closed.  Any
+     * attempts to write to a closed stream will fail.  For an asynchronous
+     * writer, this method returns immediately.  The callback is called on
+     * the main thread once the worker has written every block, with the
+     * argument true if every write succeeded.
+     *
+     * For a synchronous writer, this method is the same as {@link #close},
+     * except that it calls the callback immediately afterwards.
+     *
+     * The writer blocks on deletion until the file is complete.  Therefore,
+     * it should remain alive until the callback is called.
+     *
+     * @param callback  the callback to call when the file is complete
+     */
+    void closeAsync(std::function<void(bool success)> callback);
 
 
 #pragma mark -
@@ -1047,6 +1047,8 @@ public:
      * The vector is array is treated as a list of 2 element vectors (@see Vec2).
      * The transform is applied in order and written to the output array.
      *
+     * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+     *
      * @param aff       The transform matrix.
      * @param input     The array of vectors to transform.
      * @param output    The array to store the transformed vectors.
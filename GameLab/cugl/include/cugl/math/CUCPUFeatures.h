@@ -0,0 +1,173 @@
+//
+//  CUCPUFeatures.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides runtime detection of the vector instruction sets
+//  supported by the current processor.  The vectorization flags in
+//  CUMathBase.h are chosen at compile time, and only select 128-bit words
+//  (SSE or Neon 64).  A binary built for a baseline processor would never
+//  use the wider words of a newer one.  The hot math and DSP kernels use
+//  this module to pick the best implementation at runtime instead.
+//
+//  The wider implementations are compiled with function-level target
+//  attributes, so they are only available on x86 processors with GCC or
+//  Clang.  On other platforms the best level is 128-bit vectorization.
+//
+//  This class is a static class, as the processor does not change.  The
+//  active level may be overridden to test each implementation.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_CPU_FEATURES_H__
+#define __CU_CPU_FEATURES_H__
+#include "CUMathBase.h"
+
+// Wide vectorization requires function-level target attributes
+#if defined (CU_MATH_VECTOR_SSE) && (defined (__GNUC__) || defined (__clang__)) && \
+    (defined (__x86_64__) || defined (__i386__))
+    #define CU_MATH_VECTOR_AVX
+    /** Compiles a function for AVX2 with fused multiply-add */
+    #define CU_TARGET_AVX2   __attribute__((target("avx2,fma")))
+    /** Compiles a function for the AVX-512 foundation instructions */
+    #define CU_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace cugl {
+
+/**
+ * This class is a collection of static methods for querying the processor.
+ *
+ * The vectorized kernels in the math and DSP classes query this class for
+ * the active {@link Level} on each call.  The active level is the best one
+ * supported by both the processor and this build.  It may be lowered with
+ * {@link #setLevel} to test or time a specific implementation.
+ *
+ * Detection happens on first use, and is thread safe.  The level override
+ * is atomic, so it may be changed while the audio thread is running.
+ * However, it is intended for testing, and changing it mid-stream may
+ * change the rounding of a filter between two blocks.
+ */
+class CPUFeatures {
+public:
+    /**
+     * The vectorization levels, from weakest to strongest.
+     *
+     * A level implies all of the weaker ones.
+     */
+    enum class Level : int {
+        /** Plain C++ without any explicit vectorization */
+        SCALAR  = 0,
+        /** 128-bit words (SSE on x86, Neon on ARM) */
+        SIMD128 = 1,
+        /** 256-bit words with fused multiply-add (x86 only) */
+        AVX2    = 2,
+        /** 512-bit words (x86 only) */
+        AVX512  = 3
+    };
+
+private:
+    /**
+     * Default constructor (does nothing)
+     */
+    CPUFeatures() {}
+
+    /**
+     * Default destructor (does nothing)
+     */
+    ~CPUFeatures() {}
+
+public:
+#pragma mark Detection
+    /**
+     * Returns the best level supported by this processor and build.
+     *
+     * This value ignores any override.  A level is only supported if the
+     * build contains an implementation for it.  So a build without the
+     * CU_VECTORIZE flag always returns SCALAR.
+     *
+     * @return the best level supported by this processor and build.
+     */
+    static Level getDetected();
+
+    /**
+     * Returns true if the given level is supported by this processor and build.
+     *
+     * @param level The level to query
+     *
+     * @return true if the given level is supported by this processor and build.
+     */
+    static bool isSupported(Level level) {
+        return (int)level <= (int)getDetected();
+    }
+
+    /**
+     * Returns a string representation of the given level.
+     *
+     * @param level The level to name
+     *
+     * @return a string representation of the given level.
+     */
+    static const char* getName(Level level);
+
+#pragma mark Dispatch
+    /**
+     * Returns the level used by the vectorized kernels.
+     *
+     * This is the detected level, unless it has been lowered with
+     * {@link #setLevel}.
+     *
+     * @return the level used by the vectorized kernels.
+     */
+    static Level getLevel();
+
+    /**
+     * Returns true if the vectorized kernels may use 128-bit words.
+     *
+     * @return true if the vectorized kernels may use 128-bit words.
+     */
+    static bool hasSIMD() {
+        return getLevel() != Level::SCALAR;
+    }
+
+    /**
+     * Overrides the level used by the vectorized kernels.
+     *
+     * This method is intended for testing each implementation.  If the
+     * level is not supported, the override is not changed and this method
+     * returns false.
+     *
+     * @param level The level to use
+     *
+     * @return true if the override was applied
+     */
+    static bool setLevel(Level level);
+
+    /**
+     * Restores the level used by the vectorized kernels to the detected one.
+     */
+    static void resetLevel();
+};
+
+}
+
+#endif /* __CU_CPU_FEATURES_H__ */
@@ -1614,6 +1614,8 @@ public:
      * The vector is array is treated as a list of 4 element vectors (@see Vec4).
      * The transform is applied in order and written to the output array.
      *
+     * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+     *
      * @param mat   	The transform matrix.
      * @param input   	The array of vectors to transform.
      * @param output	The array to store the transformed vectors.
@@ -1630,6 +1632,8 @@ public:
      * The transform is applied in order and written to the output array. The
      * float array for the matrix should be in column major order
      *
+     * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+     *
      * @param mat       The transform matrix in column major order
      * @param input     The array of vectors to transform.
      * @param output    The array to store the transformed vectors.
@@ -30,6 +30,7 @@
 
 // The base data classes
 #include "CUMathBase.h"
+#include "CUCPUFeatures.h"
 #include "CUVec2.h"
 #include "CUVec3.h"
 #include "CUVec4.h"
@@ -5,9 +5,9 @@
 //  This class is represents a class of static methods for performing basic
 //  DSP calculations, like addition and multiplication.  As with the DSP
 //  filters, this class supports vector optimizations for SSE and Neon 64.
-//  Our implementation is limited to 128-bit words.  While 256-bit (e.g. AVX)
-//  are more performant, they are not better for DSP filters and so we keep
-//  the optimizations at the same level.
+//  Unlike the filters, these methods are not recursive, and so they also
+//  support 256-bit (AVX2) and 512-bit (AVX-512) words.  The word size is
+//  chosen at runtime with CPUFeatures.
 //
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -34,6 +34,7 @@
 #ifndef __CU_DSP_MATH_H__
 #define __CU_DSP_MATH_H__
 #include "../CUMathBase.h"
+#include "../CUCPUFeatures.h"
 
 namespace cugl {
     namespace dsp {
@@ -42,9 +43,10 @@ namespace cugl {
  * This class is a collection of static methods for basic DSP calculations
  *
  * As with the DSP filters, this class supports vector optimizations for SSE
- * and Neon 64. Our implementation is limited to 128-bit words.  While 256-bit
- * (e.g. AVX) are more performant, they are not better for DSP filters and so
- * we keep the optimizations at the same level.
+ * and Neon 64.  The arithmetic and clamp methods also support 256-bit (AVX2)
+ * and 512-bit (AVX-512) words.  The implementation is chosen on each call,
+ * using the level reported by {@link CPUFeatures#getLevel}.  Setting
+ * {@link #VECTORIZE} to false always chooses the scalar implementation.
  *
  * This class is not thread safe.  External locking may be required when
  * the filter is shared between multiple threads (such as between an audio
@@ -164,6 +166,30 @@ public:
      * @return the number of elements successfully processed
      */
     static size_t slide_add(float* input1, float* input2, float start, float end, float* output, size_t size);
+    
+    /**
+     * Scales an interleaved signal by a linear ramp, storing the result in output
+     *
+     * The gain is constant across the channels of each frame.  It is start for
+     * the first frame, and increases by step for each subsequent frame.  Unlike
+     * {@link #slide}, the gain of each frame is computed directly from its
+     * index, so there is no accumulated rounding error and no branching within
+     * a vector word.  The vectorized implementations require that the number of
+     * channels divide the vector width (e.g. mono, stereo, or quadrophonic).
+     * Other channel layouts fall back to a narrower implementation.
+     *
+     * It is safe for output to be the same as the input buffer.
+     *
+     * @param input     The input buffer
+     * @param start     The gain of the first frame
+     * @param step      The change in gain per frame
+     * @param channels  The number of interleaved channels
+     * @param output    The output buffer
+     * @param frames    The number of frames to scale
+     *
+     * @return the number of frames successfully scaled
+     */
+    static size_t ramp(float* input, float start, float step, Uint32 channels, float* output, size_t frames);
 
 #pragma mark Clamp Methods
     /**
@@ -74,6 +74,10 @@ namespace cugl {
  * This division allows us to support multithreaded calculation if the data
  * generation takes too long.  However, note that this factory is not thread
  * safe in that you cannot access data while it is still in mid-calculation.
+ *
+ * Alternatively, this factory can simplify a path as it is being drawn.
+ * In streaming mode, points are added one at a time, and the vertices of
+ * the simplified path are available as soon as they can no longer change.
  */
 class PathSmoother {
 #pragma mark Values
@@ -86,6 +90,12 @@ private:
     float _epsilon;
     /** Whether or not the calculation has been run */
     bool _calculated;
+    /** The points since the last stable vertex (streaming only) */
+    std::vector<Vec2> _pending;
+    /** The maximum number of unstable points when streaming */
+    size_t _window;
+    /** Whether or not this smoother is in streaming mode */
+    bool _streaming;
 
 #pragma mark -
 #pragma mark Constructors
@@ -179,9 +189,96 @@ public:
     
     /**
      * Performs a triangulation of the current vertex data.
+     *
+     * This calculation uses an explicit stack (not recursion), and so it is
+     * safe to use on paths with hundreds of thousands of points.
      */
     void calculate();
     
+#pragma mark -
+#pragma mark Streaming
+    /**
+     * Returns the maximum number of unstable points when streaming.
+     *
+     * Each point added in streaming mode is compared against all of the
+     * points since the last stable vertex.  If there are this many such
+     * points, the next point forces a new stable vertex.  This bounds the
+     * cost of {@link addPoint} for long, nearly straight paths.
+     *
+     * @return the maximum number of unstable points when streaming.
+     */
+    size_t getStreamWindow() const { return _window; }
+    
+    /**
+     * Sets the maximum number of unstable points when streaming.
+     *
+     * Each point added in streaming mode is compared against all of the
+     * points since the last stable vertex.  If there are this many such
+     * points, the next point forces a new stable vertex.  This bounds the
+     * cost of {@link addPoint} for long, nearly straight paths.
+     *
+     * @param window    The maximum number of unstable points when streaming.
+     */
+    void setStreamWindow(size_t window) { _window = window; }
+    
+    /**
+     * Starts a streaming simplification, clearing all data.
+     *
+     * In streaming mode, points are added one at a time with {@link addPoint}.
+     * As soon as a vertex of the simplified path can no longer change, it is
+     * appended to the path returned by {@link getStablePath}.  This allows a
+     * game to simplify a stroke while it is being drawn, without storing every
+     * point of the stroke.
+     *
+     * Streaming uses a greedy variation of Douglas-Peucker.  Every input point
+     * is within epsilon of the simplified path, but the result may have a few
+     * more vertices than {@link calculate} would produce on the same input.
+     */
+    void beginStream();
+    
+    /**
+     * Adds a point to a streaming simplification.
+     *
+     * This method returns the number of vertices that became stable as a
+     * result of this point (typically 0 or 1).  Those vertices are at the end
+     * of {@link getStablePath}.  The last point added is never stable until
+     * {@link endStream} is called.
+     *
+     * @param point The point to add
+     *
+     * @return the number of vertices that became stable
+     */
+    size_t addPoint(const Vec2 point);
+    
+    /**
+     * Completes a streaming simplification.
+     *
+     * The last point added becomes stable, and the path may be accessed by
+     * any of the materialization methods.  This method returns the number of
+     * vertices that became stable (0 or 1).
+     *
+     * @return the number of vertices that became stable
+     */
+    size_t endStream();
+    
+    /**
+     * Returns true if this smoother is in streaming mode.
+     *
+     * @return true if this smoother is in streaming mode.
+     */
+    bool isStreaming() const { return _streaming; }
+    
+    /**
+     * Returns the stable vertices of a streaming simplification.
+     *
+     * These vertices will not change as more points are added.  A renderer
+     * can draw these, followed by the last point added, to show the stroke
+     * while it is being drawn.  The smoother retains ownership of this list.
+     *
+     * @return the stable vertices of a streaming simplification.
+     */
+    const std::vector<Vec2>& getStablePath() const { return _output; }
+    
 #pragma mark -
 #pragma mark Materialization
     /**
@@ -250,9 +347,12 @@ public:
 #pragma mark Internal Data Generation
 private:
     /**
-     * Recursively performs Douglas-Peuker on the given input segment
+     * Performs Douglas-Peuker on the given input segment
      *
-     * The results will be pulled from _input and placed in _output.
+     * The results will be pulled from _input and placed in _output. This
+     * method uses an explicit stack, and so it is safe to use on very long
+     * paths. Each split point is only added once, as it is shared by the two
+     * halves of the split.
      *
      * @param start The first position in _input to process
      * @param end   The last position in _input to process
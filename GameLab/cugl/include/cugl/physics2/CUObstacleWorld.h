@@ -46,6 +46,7 @@
 #define __CU_PHYSICS_WORLD_H__
 
 #include <vector>
+#include <unordered_map>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <cugl/math/cu_math.h>
 class b2World;
@@ -71,6 +72,86 @@ class Obstacle;
 #define DEFAULT_WORLD_POSIT 2
 
 
+#pragma mark -
+#pragma mark Contact Events
+/**
+ * The type of a buffered contact event.
+ */
+enum class ContactEventType : Uint8 {
+    /** Two fixtures began to touch */
+    BEGIN = 0,
+    /** Two fixtures ceased to touch */
+    END   = 1,
+    /** The solver resolved a touching contact */
+    SOLVE = 2
+};
+
+/**
+ * A buffer of the contact events for a single physics step.
+ *
+ * The events are stored as parallel arrays (structure of arrays), so that
+ * game code can process them in bulk, touching only the attributes that it
+ * needs.  Event ii is the ii-th entry of every array.  All of the arrays
+ * have the same length, which is {@link size}.
+ *
+ * The obstacles are those attached to the bodies of the two fixtures, and
+ * may be nullptr if a body was not created by an obstacle.  The point is the
+ * average of the world manifold points, and the normal points from fixture A
+ * to fixture B.  Both are zero if the contact has no manifold points (e.g. a
+ * sensor).  The impulse is the total normal impulse, and is only nonzero for
+ * {@link ContactEventType#SOLVE} events.
+ *
+ * The arrays keep their capacity when cleared.  Therefore, once the buffer
+ * has grown to the peak number of contacts, recording events does not
+ * allocate memory.
+ */
+class ContactBuffer {
+public:
+    /** The type of each event */
+    std::vector<ContactEventType> type;
+    /** The obstacle owning the first fixture of each event */
+    std::vector<Obstacle*> obstacleA;
+    /** The obstacle owning the second fixture of each event */
+    std::vector<Obstacle*> obstacleB;
+    /** The first fixture of each event */
+    std::vector<b2Fixture*> fixtureA;
+    /** The second fixture of each event */
+    std::vector<b2Fixture*> fixtureB;
+    /** The contact point of each event */
+    std::vector<Vec2> point;
+    /** The contact normal of each event */
+    std::vector<Vec2> normal;
+    /** The normal impulse of each event */
+    std::vector<float> impulse;
+    
+    /**
+     * Returns the number of events in this buffer.
+     *
+     * @return the number of events in this buffer.
+     */
+    size_t size() const { return type.size(); }
+    
+    /**
+     * Returns true if this buffer has no events.
+     *
+     * @return true if this buffer has no events.
+     */
+    bool empty() const { return type.empty(); }
+    
+    /**
+     * Removes all events from this buffer, preserving its capacity.
+     */
+    void clear();
+    
+    /**
+     * Reserves space for the given number of events.
+     *
+     * @param capacity  The number of events to reserve
+     */
+    void reserve(size_t capacity);
+};
+
+
 #pragma mark -
 #pragma mark World Controller
 /**
@@ -97,6 +178,8 @@ protected:
     int _itvelocity;
     /** The number of position iterations for the constrain solvers */
     int _itposition;
+    /** Whether to solve contacts in SIMD batches */
+    bool _batched;
     /** The current gravitational value of the world */
     Vec2 _gravity;
     
@@ -112,6 +195,90 @@ protected:
     bool _filters;
     /** Whether or not to activate the destruction listener */
     bool _destroy;
+    /** Whether or not to buffer the contact events */
+    bool _buffered;
+    /** The category bits of the fixtures whose contacts are buffered */
+    Uint16 _eventMask;
+    /** The contact events of the last physics step */
+    ContactBuffer _events;
+    
+    /**
+     * Records a contact event in the buffer.
+     *
+     * The event is only recorded if the category bits of either fixture
+     * intersect the event mask.
+     *
+     * @param  type     the event type
+     * @param  contact  the contact information
+     * @param  impulse  the impulse produced by the solver (may be nullptr)
+     */
+    void recordContact(ContactEventType type, b2Contact* contact, const b2ContactImpulse* impulse);
+
+    /** Whether or not to freeze obstacles far from the focus points */
+    bool _lod;
+    /** The width and height of a level of detail cell */
+    float _cellSize;
+    /** The number of cells around a focus point that are simulated */
+    Uint32 _lodRange;
+    /** The maximum number of obstacles to thaw in a single update */
+    Uint32 _thawBudget;
+    /** The maximum number of obstacles to test for freezing in a single update */
+    Uint32 _freezeBudget;
+    /** The position of the round-robin freezing scan */
+    size_t _lodCursor;
+    /** The points (typically the player or camera) to simulate around */
+    std::vector<Vec2> _focus;
+    /** The frozen obstacles, grouped by cell */
+    std::unordered_map<Uint64, std::vector<Obstacle*>> _cells;
+    /** The cell of each frozen obstacle */
+    std::unordered_map<Obstacle*, Uint64> _frozen;
+    
+    /**
+     * Returns the key of the cell containing the given position.
+     *
+     * @param  pos  the position in Box2d coordinates
+     *
+     * @return the key of the cell containing the given position.
+     */
+    Uint64 getCellKey(const Vec2 pos) const;
+    
+    /**
+     * Returns true if the given cell is out of range of every focus point.
+     *
+     * The distance is measured in cells, using the maximum of the horizontal
+     * and vertical distance.  The slack is added to the active range, and is
+     * used to keep obstacles on the boundary from toggling every frame.
+     *
+     * @param  key      the cell key
+     * @param  slack    the number of cells to add to the active range
+     *
+     * @return true if the given cell is out of range of every focus point.
+     */
+    bool isDistantCell(Uint64 key, Uint32 slack) const;
+    
+    /**
+     * Freezes and thaws obstacles according to the current focus points.
+     *
+     * This method is called at the start of every {@link update}.  It tests
+     * at most {@link getFreezeBudget} obstacles for freezing, and thaws at
+     * most {@link getThawBudget} obstacles near the focus points.
+     */
+    void updateLevelOfDetail();
+    
+    /**
+     * Removes the given obstacle from the level of detail bookkeeping.
+     *
+     * This method does not change whether the obstacle is active.  It is
+     * called whenever an obstacle is removed from the world.
+     *
+     * @param  obj  the obstacle to forget
+     */
+    void forgetObstacle(Obstacle* obj);
+    
+    /**
+     * Immediately thaws all of the frozen obstacles.
+     */
+    void thawAll();
     
     
 #pragma mark -
@@ -296,6 +463,36 @@ public:
      */
     void setPositionIterations(int position) { _itposition = position; }
     
+    /**
+     * Returns true if the contact solver uses SIMD batches.
+     *
+     * The batched solver groups contacts that share no dynamic bodies, and
+     * solves four of them at once (using SSE2 or NEON where available). The
+     * results differ from the sequential solver only in the order that the
+     * contacts are solved, so simulations are equivalent but not identical.
+     * It is most effective for large stacks and piles.  This is false by
+     * default.
+     *
+     * @return true if the contact solver uses SIMD batches.
+     */
+    bool isBatchedSolver() const { return _batched; }
+    
+    /**
+     * Sets whether the contact solver uses SIMD batches.
+     *
+     * The batched solver groups contacts that share no dynamic bodies, and
+     * solves four of them at once (using SSE2 or NEON where available). The
+     * results differ from the sequential solver only in the order that the
+     * contacts are solved, so simulations are equivalent but not identical.
+     * It is most effective for large stacks and piles.  This is false by
+     * default.
+     *
+     * Any change will take effect at the time of the next call to update.
+     *
+     * @param  flag whether the contact solver uses SIMD batches.
+     */
+    void setBatchedSolver(bool flag);
+    
     /**
      * Returns the global gravity vector.
      *
@@ -504,7 +701,9 @@ public:
      * @param  contact  the contact information
      */
     void BeginContact(b2Contact* contact) override {
-        if (onBeginContact != nullptr) {
+        if (_buffered) {
+            recordContact(ContactEventType::BEGIN, contact, nullptr);
+        } else if (onBeginContact != nullptr) {
             onBeginContact(contact);
         }
     }
@@ -518,7 +717,9 @@ public:
      * @param  contact  the contact information
      */
     void EndContact(b2Contact* contact) override {
-        if (onEndContact != nullptr) {
+        if (_buffered) {
+            recordContact(ContactEventType::END, contact, nullptr);
+        } else if (onEndContact != nullptr) {
             onEndContact(contact);
         }
     }
@@ -545,7 +746,7 @@ public:
      * @param  oldManifold  the contact manifold last iteration
      */
     void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override {
-        if (beforeSolve != nullptr) {
+        if (_collide && beforeSolve != nullptr) {
             beforeSolve(contact,oldManifold);
         }
     }
@@ -568,12 +769,258 @@ public:
      * @param  impulse  the impulse produced by the solver
      */
     void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override {
-        if (afterSolve != nullptr) {
+        if (_buffered) {
+            recordContact(ContactEventType::SOLVE, contact, impulse);
+        } else if (afterSolve != nullptr) {
             afterSolve(contact,impulse);
         }
     }
 
     
+#pragma mark -
+#pragma mark Buffered Contact Events
+    /**
+     * Activates the contact event buffer.
+     *
+     * When the buffer is active, the begin contact, end contact, and post
+     * solve events are recorded in a {@link ContactBuffer} instead of calling
+     * {@link onBeginContact}, {@link onEndContact}, and {@link afterSolve}.
+     * This keeps the indirect calls out of the solver, and allows game code
+     * to safely modify the world while processing the events.  The events of
+     * the most recent call to {@link update} are available via
+     * {@link getContactEvents}.
+     *
+     * The {@link beforeSolve} callback is not buffered, as it is used to
+     * modify contacts before they are solved.  It is still called if the
+     * collision callbacks are active.
+     *
+     * @param  flag whether to activate the contact event buffer.
+     */
+    void activateContactBuffer(bool flag);
+    
+    /**
+     * Returns true if the contact event buffer is active
+     *
+     * @return true if the contact event buffer is active
+     */
+    bool enabledContactBuffer() const { return _buffered; }
+    
+    /**
+     * Returns the category bits of the fixtures whose contacts are buffered.
+     *
+     * A contact is only recorded if the category bits of either fixture
+     * intersect this mask.  By default, all contacts are recorded.
+     *
+     * @return the category bits of the fixtures whose contacts are buffered.
+     */
+    Uint16 getContactBufferMask() const { return _eventMask; }
+    
+    /**
+     * Sets the category bits of the fixtures whose contacts are buffered.
+     *
+     * A contact is only recorded if the category bits of either fixture
+     * intersect this mask.  By default, all contacts are recorded.  Filtering
+     * the contacts here is much cheaper than filtering them afterwards.
+     *
+     * @param  mask the category bits of the fixtures whose contacts are buffered.
+     */
+    void setContactBufferMask(Uint16 mask) { _eventMask = mask; }
+    
+    /**
+     * Returns the contact events recorded by the last call to {@link update}.
+     *
+     * The buffer is cleared at the start of every call to {@link update}.
+     * It is always empty if the contact event buffer is not active.
+     *
+     * @return the contact events recorded by the last call to {@link update}.
+     */
+    const ContactBuffer& getContactEvents() const { return _events; }
+    
+    /**
+     * Reserves space for the given number of contact events per step.
+     *
+     * The buffer grows as necessary, but reserving the peak number of events
+     * in advance prevents any allocation during the physics step.
+     *
+     * @param  capacity the number of contact events to reserve
+     */
+    void reserveContactEvents(size_t capacity) { _events.reserve(capacity); }
+
+
+#pragma mark -
+#pragma mark Simulation Level of Detail
+    /**
+     * Activates the simulation level of detail.
+     *
+     * When active, the world is partitioned into square cells, and dynamic
+     * obstacles that are far from every focus point are frozen.  A frozen
+     * obstacle is deactivated in Box2d, so it costs nothing to simulate, but
+     * it keeps its position, velocity, and all other state.  As the focus
+     * points move, frozen obstacles in range are thawed incrementally, with
+     * at most {@link getThawBudget} obstacles thawed per {@link update}.
+     *
+     * Only obstacles that are active when they are tested are frozen, so
+     * obstacles deactivated by the game are never thawed by this world.
+     * Disabling the level of detail thaws every frozen obstacle.
+     *
+     * @param  flag whether to activate the simulation level of detail.
+     */
+    void activateLevelOfDetail(bool flag);
+    
+    /**
+     * Returns true if the simulation level of detail is active
+     *
+     * @return true if the simulation level of detail is active
+     */
+    bool enabledLevelOfDetail() const { return _lod; }
+    
+    /**
+     * Returns the width and height of a level of detail cell.
+     *
+     * This value is in Box2d coordinates.
+     *
+     * @return the width and height of a level of detail cell.
+     */
+    float getCellSize() const { return _cellSize; }
+    
+    /**
+     * Sets the width and height of a level of detail cell.
+     *
+     * This value is in Box2d coordinates.  Changing the cell size thaws every
+     * frozen obstacle, and so should be done before the level is populated.
+     *
+     * @param  size the width and height of a level of detail cell.
+     */
+    void setCellSize(float size);
+    
+    /**
+     * Returns the number of cells around a focus point that are simulated.
+     *
+     * Obstacles within this many cells of a focus point (horizontally or
+     * vertically) are always thawed.  Obstacles are not frozen until they are
+     * one cell further away than this, so that obstacles on the boundary do
+     * not toggle every frame.
+     *
+     * @return the number of cells around a focus point that are simulated.
+     */
+    Uint32 getActiveRange() const { return _lodRange; }
+    
+    /**
+     * Sets the number of cells around a focus point that are simulated.
+     *
+     * Obstacles within this many cells of a focus point (horizontally or
+     * vertically) are always thawed.  Obstacles are not frozen until they are
+     * one cell further away than this, so that obstacles on the boundary do
+     * not toggle every frame.
+     *
+     * @param  range    the number of cells around a focus point that are simulated.
+     */
+    void setActiveRange(Uint32 range) { _lodRange = range; }
+    
+    /**
+     * Returns the maximum number of obstacles to thaw in a single update.
+     *
+     * Thawing an obstacle adds its fixtures back to the broad-phase, which
+     * is not free.  This budget spreads that cost over several frames.
+     *
+     * @return the maximum number of obstacles to thaw in a single update.
+     */
+    Uint32 getThawBudget() const { return _thawBudget; }
+    
+    /**
+     * Sets the maximum number of obstacles to thaw in a single update.
+     *
+     * Thawing an obstacle adds its fixtures back to the broad-phase, which
+     * is not free.  This budget spreads that cost over several frames.
+     *
+     * @param  budget   the maximum number of obstacles to thaw in a single update.
+     */
+    void setThawBudget(Uint32 budget) { _thawBudget = budget; }
+    
+    /**
+     * Returns the maximum number of obstacles to test for freezing in a single update.
+     *
+     * The obstacles are tested round-robin, so an obstacle that leaves the
+     * active range is frozen within (number of obstacles)/(budget) updates.
+     *
+     * @return the maximum number of obstacles to test for freezing in a single update.
+     */
+    Uint32 getFreezeBudget() const { return _freezeBudget; }
+    
+    /**
+     * Sets the maximum number of obstacles to test for freezing in a single update.
+     *
+     * The obstacles are tested round-robin, so an obstacle that leaves the
+     * active range is frozen within (number of obstacles)/(budget) updates.
+     *
+     * @param  budget   the maximum number of obstacles to test for freezing in a single update.
+     */
+    void setFreezeBudget(Uint32 budget) { _freezeBudget = budget; }
+    
+    /**
+     * Returns the points to simulate around.
+     *
+     * @return the points to simulate around.
+     */
+    const std::vector<Vec2>& getFocus() const { return _focus; }
+    
+    /**
+     * Sets the single point to simulate around.
+     *
+     * This point is typically the player or the camera position, in Box2d
+     * coordinates.  It should be set before every call to {@link update}.
+     *
+     * @param  point    the point to simulate around.
+     */
+    void setFocus(const Vec2 point) {
+        _focus.clear();
+        _focus.push_back(point);
+    }
+    
+    /**
+     * Adds a point to simulate around.
+     *
+     * This is useful for split-screen or networked games, where more than
+     * one region of the world must be simulated.
+     *
+     * @param  point    the point to simulate around.
+     */
+    void addFocus(const Vec2 point) { _focus.push_back(point); }
+    
+    /**
+     * Removes all of the points to simulate around.
+     *
+     * If there are no focus points, nothing is frozen, and all frozen
+     * obstacles thaw incrementally.
+     */
+    void clearFocus() { _focus.clear(); }
+    
+    /**
+     * Returns true if the given obstacle is frozen by the level of detail.
+     *
+     * @param  obj  the obstacle to test
+     *
+     * @return true if the given obstacle is frozen by the level of detail.
+     */
+    bool isFrozen(Obstacle* obj) const { return _frozen.find(obj) != _frozen.end(); }
+    
+    /**
+     * Returns the number of obstacles frozen by the level of detail.
+     *
+     * @return the number of obstacles frozen by the level of detail.
+     */
+    size_t getFrozenCount() const { return _frozen.size(); }
+    
+    /**
+     * Returns the number of obstacles not frozen by the level of detail.
+     *
+     * This includes static obstacles, and obstacles deactivated by the game.
+     *
+     * @return the number of obstacles not frozen by the level of detail.
+     */
+    size_t getActiveCount() const { return _objects.size()-_frozen.size(); }
+
+    
 #pragma mark -
 #pragma mark Filter Callback Functions
     /**
@@ -0,0 +1,335 @@
+//
+//  CUProjectileSystem.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a simulator for large numbers of fast projectiles.
+//  A bullet in Box2D must be a body with continuous collision detection, and
+//  every such body is handled separately by the time of impact solver.  That
+//  does not scale to thousands of bullets.  Instead, the projectiles in this
+//  module are plain data records.  Each step, every projectile is advanced
+//  with a ray cast (against the broadphase of an ObstacleWorld) that sweeps
+//  the path it travels.  Projectiles never become bodies, but they can still
+//  push the bodies that they hit.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/8/21
+//
+#ifndef __CU_PROJECTILE_SYSTEM_H__
+#define __CU_PROJECTILE_SYSTEM_H__
+
+#include <vector>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <cugl/math/cu_math.h>
+
+/** The default mass of a projectile */
+#define DEFAULT_PROJECTILE_MASS  0.1f
+/** The default lifespan of a projectile in seconds */
+#define DEFAULT_PROJECTILE_LIFE  5.0f
+
+namespace cugl {
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add a 3-d physics engine as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace physics2 {
+
+// Forward references
+class ObstacleWorld;
+class Obstacle;
+
+#pragma mark -
+#pragma mark Projectile Data
+/**
+ * A single projectile in a {@link ProjectileSystem}.
+ *
+ * This is a plain data record.  It has no body in the physics world, and is
+ * copied freely.  All values are in Box2D coordinates.
+ */
+class Projectile {
+public:
+    /** The current position */
+    Vec2 position;
+    /** The current velocity */
+    Vec2 velocity;
+    /** The mass (used to compute the impulse on a hit) */
+    float mass;
+    /** The remaining time in seconds before this projectile expires */
+    float life;
+    /** The category bits of the fixtures that this projectile can hit */
+    Uint16 mask;
+    /** A user-defined value to identify this projectile */
+    Uint32 tag;
+};
+
+/**
+ * A collision between a projectile and a fixture.
+ *
+ * A projectile is removed from the system when it hits a fixture, so there is
+ * at most one hit for each projectile.  The obstacle is the one attached to
+ * the body of the fixture, and may be nullptr if the body was not created by
+ * an obstacle.
+ */
+class ProjectileHit {
+public:
+    /** The tag of the projectile */
+    Uint32 tag;
+    /** The obstacle that was hit */
+    Obstacle* obstacle;
+    /** The fixture that was hit */
+    b2Fixture* fixture;
+    /** The point of impact */
+    Vec2 point;
+    /** The surface normal at the point of impact */
+    Vec2 normal;
+    /** The momentum of the projectile at the point of impact */
+    Vec2 impulse;
+};
+
+#pragma mark -
+#pragma mark Projectile System
+/**
+ * A simulator for a large number of fast projectiles.
+ *
+ * Projectiles are advanced in a batch by {@link update}, which should be
+ * called immediately after the {@link ObstacleWorld} is updated.  Each
+ * projectile moves in a straight line over a single step, and this line is
+ * ray cast against the world.  If it strikes a (non-sensor) fixture whose
+ * category bits match the projectile mask, the projectile is removed and a
+ * hit is recorded.  By default, the momentum of the projectile is applied
+ * as an impulse to the body that was struck.
+ *
+ * Projectiles may optionally be affected by the world gravity (scaled) and
+ * by linear drag.  They are also removed when their lifespan expires or when
+ * they leave the bounds of the world.
+ *
+ * Like {@link ObstacleSelector}, this system is attached to an ObstacleWorld
+ * on creation, and this world can never change.
+ */
+class ProjectileSystem {
+protected:
+    /** The ObstacleWorld associated with this system */
+    std::shared_ptr<ObstacleWorld> _controller;
+    
+    /** The active projectiles */
+    std::vector<Projectile> _projectiles;
+    /** The hits of the last call to update */
+    std::vector<ProjectileHit> _hits;
+    
+    /** The amount to scale the world gravity for projectiles */
+    float _gravityScale;
+    /** The linear drag coefficient of the projectiles */
+    float _drag;
+    /** Whether to apply an impulse to the bodies that are hit */
+    bool _impulses;
+    
+public:
+#pragma mark Constructors
+    /**
+     * Creates a new degenerate projectile system.
+     *
+     * The system created is not usable.  This constructor only initializes
+     * default values.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    ProjectileSystem() : _controller(nullptr), _gravityScale(0.0f), _drag(0.0f), _impulses(true) {}
+    
+    /**
+     * Disposes of this projectile system, releasing all resources.
+     */
+    ~ProjectileSystem() { dispose(); }
+    
+    /**
+     * Disposes all of the resources used by this projectile system.
+     *
+     * A disposed system can be safely reinitialized.
+     */
+    void dispose();
+    
+    /**
+     * Initializes a new projectile system for the given ObstacleWorld
+     *
+     * This world can never change.  If you want projectiles for a different
+     * ObstacleWorld, make a new instance.
+     *
+     * @param world     the physics controller
+     * @param capacity  the number of projectiles to reserve space for
+     *
+     * @return  true if the system is initialized properly, false otherwise.
+     */
+    bool init(const std::shared_ptr<ObstacleWorld>& world, size_t capacity = 0);
+    
+    /**
+     * Returns a newly allocated projectile system for the given ObstacleWorld
+     *
+     * This world can never change.  If you want projectiles for a different
+     * ObstacleWorld, make a new instance.
+     *
+     * @param world     the physics controller
+     * @param capacity  the number of projectiles to reserve space for
+     *
+     * @return a newly allocated projectile system for the given ObstacleWorld
+     */
+    static std::shared_ptr<ProjectileSystem> alloc(const std::shared_ptr<ObstacleWorld>& world,
+                                                   size_t capacity = 0) {
+        std::shared_ptr<ProjectileSystem> result = std::make_shared<ProjectileSystem>();
+        return (result->init(world,capacity) ? result : nullptr);
+    }
+    
+#pragma mark Projectile Management
+    /**
+     * Adds a projectile to this system.
+     *
+     * The projectile will first move at the next call to {@link update}.
+     *
+     * @param projectile    The projectile to add
+     */
+    void fire(const Projectile& projectile) { _projectiles.push_back(projectile); }
+    
+    /**
+     * Adds a projectile to this system.
+     *
+     * The projectile will first move at the next call to {@link update}. It
+     * has the default mass and lifespan, and hits all fixtures.
+     *
+     * @param position  The initial position
+     * @param velocity  The initial velocity
+     * @param tag       A user-defined value to identify the projectile
+     */
+    void fire(const Vec2 position, const Vec2 velocity, Uint32 tag = 0);
+    
+    /**
+     * Returns a read-only reference to the active projectiles.
+     *
+     * @return a read-only reference to the active projectiles.
+     */
+    const std::vector<Projectile>& getProjectiles() const { return _projectiles; }
+    
+    /**
+     * Returns the number of active projectiles.
+     *
+     * @return the number of active projectiles.
+     */
+    size_t size() const { return _projectiles.size(); }
+    
+    /**
+     * Removes all projectiles from this system.
+     */
+    void clear();
+    
+#pragma mark Simulation
+    /**
+     * Advances all projectiles by a single step.
+     *
+     * This method should be called immediately after {@link ObstacleWorld#update},
+     * with the same time step.  Each projectile sweeps a ray from its current
+     * position to its next position.  Projectiles that hit a fixture are removed
+     * and recorded as hits.  All impulses are applied after every projectile
+     * has moved, so the order of the projectiles does not matter.
+     *
+     * @param dt    Number of seconds since last step
+     */
+    void update(float dt);
+    
+    /**
+     * Returns the hits from the last call to {@link update}.
+     *
+     * @return the hits from the last call to {@link update}.
+     */
+    const std::vector<ProjectileHit>& getHits() const { return _hits; }
+    
+#pragma mark Attributes
+    /**
+     * Returns the amount to scale the world gravity for projectiles.
+     *
+     * By default this value is 0, so projectiles travel in a straight line.
+     *
+     * @return the amount to scale the world gravity for projectiles.
+     */
+    float getGravityScale() const { return _gravityScale; }
+    
+    /**
+     * Sets the amount to scale the world gravity for projectiles.
+     *
+     * By default this value is 0, so projectiles travel in a straight line.
+     *
+     * @param scale the amount to scale the world gravity for projectiles.
+     */
+    void setGravityScale(float scale) { _gravityScale = scale; }
+    
+    /**
+     * Returns the linear drag coefficient of the projectiles.
+     *
+     * Each second, a projectile loses this fraction of its velocity. By
+     * default this value is 0.
+     *
+     * @return the linear drag coefficient of the projectiles.
+     */
+    float getDrag() const { return _drag; }
+    
+    /**
+     * Sets the linear drag coefficient of the projectiles.
+     *
+     * Each second, a projectile loses this fraction of its velocity. By
+     * default this value is 0.
+     *
+     * @param drag  the linear drag coefficient of the projectiles.
+     */
+    void setDrag(float drag) { _drag = drag; }
+    
+    /**
+     * Returns true if hits apply an impulse to the body that was struck.
+     *
+     * The impulse is the momentum of the projectile at impact.
+     *
+     * @return true if hits apply an impulse to the body that was struck.
+     */
+    bool appliesImpulses() const { return _impulses; }
+    
+    /**
+     * Sets whether hits apply an impulse to the body that was struck.
+     *
+     * The impulse is the momentum of the projectile at impact.
+     *
+     * @param flag  whether hits apply an impulse to the body that was struck.
+     */
+    void setAppliesImpulses(bool flag) { _impulses = flag; }
+};
+
+    }
+}
+#endif /* __CU_PROJECTILE_SYSTEM_H__ */
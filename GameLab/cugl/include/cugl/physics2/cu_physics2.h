@@ -37,5 +37,6 @@
 #include "CUPolygonObstacle.h"
 #include "CUCapsuleObstacle.h"
 #include "CUObstacleSelector.h"
+#include "CUProjectileSystem.h"
 
 #endif /* __CU_PHYSICS_2_PKG_H__ */
@@ -96,6 +96,13 @@ namespace cugl {
  * that you explicitly specify a character set for the atlas.  Indeed, a 
  * character set is the only way to get unicode support; the basic atlas only 
  * includes ASCII characters.
+ *
+ * Finally, an atlas may store a signed distance field instead of the glyph
+ * coverage (see {@link setDistanceField}).  A distance field atlas is
+ * rasterized once at the font size, but can be drawn crisply at any scale
+ * with a {@link SpriteBatch} in distance field mode.  Hence one distance
+ * field font at a large reference size can replace several fixed-size fonts,
+ * and supports outline and glow effects for free.
  */
 class Font {
 #pragma mark Inner Classes
@@ -223,10 +230,62 @@ public:
 #pragma mark -
 #pragma mark Values
 protected:
+    /**
+     * A range of glyphs to rasterize in a single thread.
+     */
+    class GlyphJob {
+    public:
+        /** The font building the atlas */
+        Font* font;
+        /** The font handle owned by this job */
+        TTF_Font* handle;
+        /** The index of the first glyph in the glyph set */
+        size_t begin;
+        /** The index after the last glyph in the glyph set */
+        size_t end;
+    };
+    
+    /**
+     * A glyph in the atlas.
+     *
+     * This record keeps the metrics and atlas position of a glyph together,
+     * so that measuring or drawing a character needs only one lookup.  It
+     * fits in a single cache line.
+     */
+    class Glyph {
+    public:
+        /** The metrics of this glyph */
+        Metrics metrics;
+        /** The location of this glyph in the atlas texture */
+        Rect bounds;
+        /** The (Unicode) character of this glyph */
+        Uint32 code;
+        /** Whether this glyph is in the atlas */
+        bool valid;
+        
+        /**
+         * Creates a glyph that is not in the atlas.
+         */
+        Glyph() : code(0), valid(false) {}
+    };
+    
+    /**
+     * A cached kerning pair.
+     */
+    class KernPair {
+    public:
+        /** The pair of characters (first character in the high word) */
+        Uint64 pair;
+        /** The kerning between the two characters */
+        int kern;
+    };
+    
     /** The name of this font (typically the family name if known) */
     std::string _name;
     /** The name of this font style */
     std::string _stylename;
+    /** The path to the font file (for opening additional handles) */
+    std::string _source;
     /** The font size in points */
     int _size;
     
@@ -254,18 +313,24 @@ protected:
     Hinting _hints;
     /** The rendering resolution (when there is no atlas) */
     Resolution _render;
+    /** Whether the atlas stores a signed distance field */
+    bool _distanceField;
+    /** The spread of the distance field in pixels */
+    unsigned int _spread;
     
     // Altas support
     /** Whether this font has an active atlas */
     bool _hasAtlas;
     /** The set of (unicode) glyphs supported by this atlas */
     std::vector<Uint32> _glyphset;
-    /** The location of each glyph in the atlas texture */
-    std::unordered_map<Uint32, Rect> _glyphmap;
-    /** The cached metrics for each font glyph */
-    std::unordered_map<Uint32, Metrics> _glyphsize;
-    /** The kerning for each pair of characters */
-    std::unordered_map<Uint32, std::unordered_map<Uint32, Uint32> > _kernmap;
+    /** The atlas glyphs in the Latin-1 range, indexed by character */
+    std::vector<Glyph> _latin;
+    /** The atlas glyphs outside of the Latin-1 range, sorted by character */
+    std::vector<Glyph> _extended;
+    /** The kerning for each pair of characters (an open hash table computed on demand) */
+    mutable std::vector<KernPair> _kerning;
+    /** The number of pairs in the kerning table */
+    mutable size_t _kernsize;
     /** The OpenGL texture representing this atlas */
     std::shared_ptr<Texture> _texture;
     /** A (temporary) SDL surface for computing the atlas texture */
@@ -558,6 +623,67 @@ public:
      */
     void setResolution(Resolution resolution) { clearAtlas(); _render = resolution; }
 
+    /**
+     * Returns true if the atlas for this font is a signed distance field.
+     *
+     * A distance field atlas stores the distance to the nearest glyph edge
+     * (rather than the glyph coverage) in the alpha channel, with 0.5 on the
+     * edge itself. When drawn by a {@link SpriteBatch} in distance field mode,
+     * the glyphs remain crisp at any scale, and may have an outline or glow.
+     *
+     * This setting only applies to the atlas.  Fonts with no atlas render
+     * normally. This value is false by default.
+     *
+     * @return true if the atlas for this font is a signed distance field.
+     */
+    bool isDistanceField() const { return _distanceField; }
+    
+    /**
+     * Sets whether the atlas for this font is a signed distance field.
+     *
+     * Changing this value will delete any atlas that is present.  The atlas
+     * must be regenerated.
+     *
+     * A distance field atlas stores the distance to the nearest glyph edge
+     * (rather than the glyph coverage) in the alpha channel, with 0.5 on the
+     * edge itself. When drawn by a {@link SpriteBatch} in distance field mode,
+     * the glyphs remain crisp at any scale, and may have an outline or glow.
+     * A distance field atlas ignores the resolution setting.
+     *
+     * This setting only applies to the atlas.  Fonts with no atlas render
+     * normally. This value is false by default.
+     *
+     * @param field Whether the atlas for this font is a signed distance field
+     */
+    void setDistanceField(bool field) { clearAtlas(); _distanceField = field; }
+    
+    /**
+     * Returns the spread of the distance field in pixels.
+     *
+     * The spread is the maximum distance from a glyph edge recorded in the
+     * distance field. It bounds the width of any outline or glow effect, and
+     * how far the glyphs may be scaled down before they alias. Each glyph in
+     * the atlas is padded by this amount.  The default is 4 pixels.
+     *
+     * @return the spread of the distance field in pixels.
+     */
+    unsigned int getDistanceSpread() const { return _spread; }
+    
+    /**
+     * Sets the spread of the distance field in pixels.
+     *
+     * Changing this value will delete any atlas that is present.  The atlas
+     * must be regenerated.
+     *
+     * The spread is the maximum distance from a glyph edge recorded in the
+     * distance field. It bounds the width of any outline or glow effect, and
+     * how far the glyphs may be scaled down before they alias. Each glyph in
+     * the atlas is padded by this amount.  The default is 4 pixels.
+     *
+     * @param spread    The spread of the distance field in pixels.
+     */
+    void setDistanceSpread(unsigned int spread) { clearAtlas(); _spread = spread; }
+
 
     
 #pragma mark -
@@ -1358,6 +1484,16 @@ protected:
     
 #pragma mark -
 #pragma mark Atlas Preparation
+    /**
+     * Returns the amount of padding around each glyph in the atlas.
+     *
+     * The padding prevents bleeding between neighboring glyphs. A distance
+     * field atlas also needs room for the field outside of each glyph.
+     *
+     * @return the amount of padding around each glyph in the atlas.
+     */
+    int getGlyphBorder() const;
+    
     /**
      * Prepares an atlas of all of the ASCII glyphs in this font
      *
@@ -1381,9 +1517,67 @@ protected:
     int prepareAtlas(std::string charset);
     
     /**
-     * Gathers the kerning information for the atlas.
+     * Returns the atlas glyph for the given character.
+     *
+     * Characters in the Latin-1 range are found by direct index.  All other
+     * characters are found by binary search.  This method returns nullptr
+     * if the character is not in the atlas.
+     *
+     * @param thechar   The Unicode character to find
+     *
+     * @return the atlas glyph for the given character.
      */
-    void prepareAtlasKerning();
+    const Glyph* findGlyph(Uint32 thechar) const;
+    
+    /**
+     * Returns the atlas glyph for the given character.
+     *
+     * Characters in the Latin-1 range are found by direct index.  All other
+     * characters are found by binary search.  This method returns nullptr
+     * if the character is not in the atlas.
+     *
+     * @param thechar   The Unicode character to find
+     *
+     * @return the atlas glyph for the given character.
+     */
+    Glyph* findGlyph(Uint32 thechar) {
+        return const_cast<Glyph*>(static_cast<const Font*>(this)->findGlyph(thechar));
+    }
+    
+    /**
+     * Adds a glyph to the atlas tables, returning the new record.
+     *
+     * The bounding rectangle of the glyph is sized (but not positioned) to
+     * include the glyph border.  Adding glyphs in increasing order is fast,
+     * as they are appended to the end of the tables.
+     *
+     * @param thechar   The Unicode character to add
+     * @param metrics   The metrics of the character
+     *
+     * @return the new glyph record
+     */
+    Glyph* addGlyph(Uint32 thechar, const Metrics& metrics);
+    
+    /**
+     * Doubles the capacity of the kerning table, rehashing all of the pairs.
+     */
+    void growKerning() const;
+    
+    /**
+     * Returns the kerning between two characters in the atlas.
+     *
+     * Kerning pairs are computed on demand and cached.  A text only uses a
+     * tiny fraction of the pairs in a large character set, so this is much
+     * faster than computing every pair when the atlas is built.  As this
+     * method updates the cache, it should only be called by the thread
+     * using the font.
+     *
+     * @param a     The first Unicode character in the pair
+     * @param b     The second Unicode character in the pair
+     *
+     * @return the kerning between two characters in the atlas.
+     */
+    int lookupKerning(Uint32 a, Uint32 b) const;
 
     /**
      * Returns the metrics for the given character if available.
@@ -1414,7 +1608,8 @@ protected:
      *
      * The dimensions are store in the provided pointers.  The width should
      * be a value > 1.  For best results, the width should be the size of the
-     * maximum character width.
+     * maximum character width.  As a side effect, this method packs the glyphs
+     * with {@link planAtlas}, so the glyph positions are ready for layout.
      *
      * @param width     Integer to store the width in
      * @param height    Integer to store the height in
@@ -1422,24 +1617,63 @@ protected:
     void computeAtlasSize(int* width, int* height);
     
     /**
-     * Returns a plan for the atlas as a rectangular array of characters.
+     * Returns true if the glyphs were packed in a bounding box of this size.
      *
-     * These characters are organized to fit in the size predicted by
-     * computeSize.
+     * This method uses a bottom-left skyline packer, placing each glyph (widest
+     * first) at the lowest position along the skyline where it fits.  Unlike
+     * a shelf packer, this reclaims the space left at the end of each row. The
+     * glyph positions are stored in the glyph map.  If this method returns
+     * false, those positions are incomplete and should be ignored.
      *
      * @param width     The width of the bounding box
      * @param height    The height of the bounding box
      *
-     * @return a plan for the atlas as a rectangular array of characters.
+     * @return true if the glyphs were packed in a bounding box of this size.
+     */
+    bool planAtlas(int width, int height);
+    
+    /**
+     * Returns a new handle to the font file with the current settings.
+     *
+     * SDL_ttf is not thread safe, so every rasterization thread needs its own
+     * handle.  This handle has the same size, style, hinting and kerning as
+     * this font.  The caller is responsible for closing it.  Handles should
+     * only be opened and closed on the thread building the atlas.
+     *
+     * @return a new handle to the font file with the current settings.
+     */
+    TTF_Font* openHandle() const;
+    
+    /**
+     * Rasterizes a range of glyphs into their positions in the SDL surface.
+     *
+     * Each glyph is rendered to its own cell, and the cell rows are copied
+     * into the atlas.  As glyph positions never overlap, several threads may
+     * call this method at once on disjoint ranges, provided that each has its
+     * own font handle.
+     *
+     * @param handle    The font handle to render with
+     * @param begin     The index of the first glyph in the glyph set
+     * @param end       The index after the last glyph in the glyph set
+     */
+    void rasterizeGlyphs(TTF_Font* handle, size_t begin, size_t end);
+    
+    /**
+     * Executes a rasterization job in its own thread.
+     *
+     * @param data  The {@link GlyphJob} to execute
+     *
+     * @return 0 when the job is complete
      */
-    std::vector< std::vector<Uint32> > planAtlas(int width, int height);
+    static int SDLCALL rasterizeJob(void* data);
     
     /**
-     * Takes the rectangular plan and arranges the glyphs in the SDL surface.
+     * Arranges the glyphs in the SDL surface, using the planned positions.
      *
-     * @param rectangle A plan for the atlas as a rectangular array of characters.
+     * The glyphs are divided among several threads, each rasterizing with its
+     * own font handle.  Small atlases are rasterized on the calling thread.
      */
-    void layoutAtlas(const std::vector< std::vector<Uint32> >& rectangle);
+    void layoutAtlas();
     
     /**
      * Generates an SDL surface for the font atlas.
@@ -1453,6 +1687,15 @@ protected:
      */
     bool generateSurface(int width, int height);
     
+    /**
+     * Converts the glyph coverage in the atlas surface to a distance field.
+     *
+     * Every pixel is assigned its signed distance to the nearest glyph edge,
+     * clamped to the spread and remapped so that the edge is at alpha 0.5.
+     * The color channels are set to white.
+     */
+    void generateDistanceField();
+    
     /**
      * Allocates a blank surface of the given size.
      *
@@ -0,0 +1,425 @@
+//
+//  CUGLState.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a shadow copy of the OpenGL state that the render
+//  classes touch.  OpenGL drivers do not filter redundant state changes, and
+//  on many mobile drivers even a no-op bind is a measurable cost.  All of the
+//  render classes (textures, shaders, buffers, render targets, and the sprite
+//  batch) route their state changes through this module, which skips any
+//  change to a value that is already current.
+//
+//  The shadow assumes that all state changes go through this module.  Code
+//  that calls OpenGL directly should either use these functions too, or call
+//  invalidate() afterwards so that the shadow is reloaded.  The verify mode
+//  checks the shadow against the driver on every call, which is useful for
+//  finding such code.
+//
+//  This class is a static class, as there is only one OpenGL context.  It
+//  may only be used on the main thread.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_GL_STATE_H__
+#define __CU_GL_STATE_H__
+#include <cugl/base/CUBase.h>
+
+namespace cugl {
+
+/**
+ * This class is a shadow of the OpenGL state used by the render classes.
+ *
+ * Each method of this class mirrors an OpenGL function of the same name.
+ * If the requested value is already current, the method does nothing.
+ * Otherwise it calls OpenGL and records the new value.  Initially all of
+ * the state is unknown, so the first call to each method always reaches
+ * the driver.
+ *
+ * The tracked state is the program, the active texture unit and the 2d
+ * texture of each unit, the vertex array and the array, element, and
+ * uniform buffers (including the indexed uniform bindings), the
+ * framebuffer and the viewport, the blend, depth test, cull face, and
+ * scissor capabilities, the blend function and equation, the depth
+ * function and mask, and the clear color.  Any other state (such as
+ * other texture targets or capabilities) is passed directly to OpenGL.
+ *
+ * Objects must be deleted with the delete methods of this class, so that
+ * the shadow forgets their bindings.  If code outside of this class
+ * changes the tracked state, it must call {@link #invalidate}.
+ *
+ * This class also counts the calls that it passes to OpenGL, and the calls
+ * it skips as redundant.  In verify mode, every call compares the shadow
+ * to the actual OpenGL state, logging any difference.  Verify mode is very
+ * slow and should only be used for debugging.
+ */
+class GLState {
+#pragma mark Attributes
+public:
+    /**
+     * Forgets all of the tracked state.
+     *
+     * The next call to each method will reach the driver.  This method
+     * should be called after any code outside of this class changes the
+     * tracked state, or after the OpenGL context is recreated.
+     */
+    static void invalidate();
+
+    /**
+     * Returns true if this class checks the shadow against OpenGL.
+     *
+     * In verify mode, every call compares the shadow to the actual OpenGL
+     * state before deciding whether to skip it.  Any difference is logged
+     * and the call is passed to OpenGL.
+     *
+     * @return true if this class checks the shadow against OpenGL.
+     */
+    static bool isVerify();
+
+    /**
+     * Sets whether this class checks the shadow against OpenGL.
+     *
+     * In verify mode, every call compares the shadow to the actual OpenGL
+     * state before deciding whether to skip it.  Any difference is logged
+     * and the call is passed to OpenGL.  This mode is very slow, as every
+     * call stalls on a query, and should only be used for debugging.
+     *
+     * @param flag  Whether to check the shadow against OpenGL.
+     */
+    static void setVerify(bool flag);
+
+    /**
+     * Returns true if the shadow agrees with all known OpenGL state.
+     *
+     * This method queries OpenGL for every value in the shadow, and logs
+     * each difference.  Unknown values are ignored.  It can be called
+     * whether or not verify mode is active.
+     *
+     * @return true if the shadow agrees with all known OpenGL state.
+     */
+    static bool verify();
+
+    /**
+     * Returns the number of state changes passed to OpenGL.
+     *
+     * This value is the total since the last call to {@link #resetCounters}.
+     *
+     * @return the number of state changes passed to OpenGL.
+     */
+    static Uint64 getIssuedCount();
+
+    /**
+     * Returns the number of redundant state changes skipped.
+     *
+     * This value is the total since the last call to {@link #resetCounters}.
+     *
+     * @return the number of redundant state changes skipped.
+     */
+    static Uint64 getSkippedCount();
+
+    /**
+     * Resets the counts of issued and skipped state changes to 0.
+     */
+    static void resetCounters();
+
+#pragma mark -
+#pragma mark Programs and Textures
+    /**
+     * Makes the given program current (glUseProgram).
+     *
+     * @param program   The program name, or 0 for none
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * Returns the current program.
+     *
+     * @return the current program.
+     */
+    static GLuint getProgram();
+
+    /**
+     * Deletes the given program (glDeleteProgram).
+     *
+     * If the program is current, it remains so until another program is
+     * used, as in OpenGL.
+     *
+     * @param program   The program name
+     */
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Sets the active texture unit (glActiveTexture).
+     *
+     * @param unit  The texture unit (e.g. GL_TEXTURE0)
+     */
+    static void activeTexture(GLenum unit);
+
+    /**
+     * Returns the active texture unit (e.g. GL_TEXTURE0).
+     *
+     * @return the active texture unit (e.g. GL_TEXTURE0).
+     */
+    static GLenum getActiveTexture();
+
+    /**
+     * Binds a texture to the active unit (glBindTexture).
+     *
+     * Only GL_TEXTURE_2D is tracked.  Other targets are passed directly to
+     * OpenGL.
+     *
+     * @param target    The texture target
+     * @param texture   The texture name, or 0 for none
+     */
+    static void bindTexture(GLenum target, GLuint texture);
+
+    /**
+     * Returns the 2d texture bound to the given unit.
+     *
+     * @param unit  The texture unit (e.g. GL_TEXTURE0)
+     *
+     * @return the 2d texture bound to the given unit.
+     */
+    static GLuint getBoundTexture(GLenum unit);
+
+    /**
+     * Deletes the given texture (glDeleteTextures).
+     *
+     * The texture is removed from every unit it is bound to.
+     *
+     * @param texture   The texture name
+     */
+    static void deleteTexture(GLuint texture);
+
+#pragma mark -
+#pragma mark Buffers
+    /**
+     * Binds the given vertex array (glBindVertexArray).
+     *
+     * The element buffer binding is part of the vertex array, so changing
+     * the vertex array forgets the element buffer.
+     *
+     * @param array The vertex array name, or 0 for none
+     */
+    static void bindVertexArray(GLuint array);
+
+    /**
+     * Returns the bound vertex array.
+     *
+     * @return the bound vertex array.
+     */
+    static GLuint getVertexArray();
+
+    /**
+     * Deletes the given vertex array (glDeleteVertexArrays).
+     *
+     * @param array The vertex array name
+     */
+    static void deleteVertexArray(GLuint array);
+
+    /**
+     * Binds a buffer to the given target (glBindBuffer).
+     *
+     * Only GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, and GL_UNIFORM_BUFFER
+     * are tracked.  Other targets are passed directly to OpenGL.
+     *
+     * @param target    The buffer target
+     * @param buffer    The buffer name, or 0 for none
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Returns the buffer bound to the given target.
+     *
+     * @param target    The buffer target
+     *
+     * @return the buffer bound to the given target.
+     */
+    static GLuint getBoundBuffer(GLenum target);
+
+    /**
+     * Binds a buffer to an indexed binding point (glBindBufferBase).
+     *
+     * Only GL_UNIFORM_BUFFER is tracked.  As in OpenGL, this also binds the
+     * buffer to the generic target.
+     *
+     * @param target    The buffer target
+     * @param index     The binding point
+     * @param buffer    The buffer name, or 0 for none
+     */
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    /**
+     * Binds a buffer range to an indexed binding point (glBindBufferRange).
+     *
+     * Only GL_UNIFORM_BUFFER is tracked.  As in OpenGL, this also binds the
+     * buffer to the generic target.
+     *
+     * @param target    The buffer target
+     * @param index     The binding point
+     * @param buffer    The buffer name
+     * @param offset    The offset of the range in bytes
+     * @param size      The size of the range in bytes
+     */
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                                GLintptr offset, GLsizeiptr size);
+
+    /**
+     * Returns the buffer bound to the given uniform binding point.
+     *
+     * @param index     The binding point
+     *
+     * @return the buffer bound to the given uniform binding point.
+     */
+    static GLuint getUniformBinding(GLuint index);
+
+    /**
+     * Deletes the given buffer (glDeleteBuffers).
+     *
+     * The buffer is removed from every target it is bound to.
+     *
+     * @param buffer    The buffer name
+     */
+    static void deleteBuffer(GLuint buffer);
+
+    /**
+     * Binds the given framebuffer (glBindFramebuffer).
+     *
+     * Only GL_FRAMEBUFFER is tracked.  Binding the draw or read framebuffer
+     * separately is passed directly to OpenGL, and forgets the shadow.
+     *
+     * @param target    The framebuffer target
+     * @param buffer    The framebuffer name
+     */
+    static void bindFramebuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Returns the bound framebuffer.
+     *
+     * @return the bound framebuffer.
+     */
+    static GLuint getFramebuffer();
+
+    /**
+     * Deletes the given framebuffer (glDeleteFramebuffers).
+     *
+     * @param buffer    The framebuffer name
+     */
+    static void deleteFramebuffer(GLuint buffer);
+
+    /**
+     * Sets the viewport (glViewport).
+     *
+     * @param x         The viewport x-coordinate
+     * @param y         The viewport y-coordinate
+     * @param width     The viewport width
+     * @param height    The viewport height
+     */
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Stores the current viewport in the given array.
+     *
+     * The array must have four elements: x, y, width, and height.
+     *
+     * @param viewport  The array to store the viewport
+     */
+    static void getViewport(GLint* viewport);
+
+#pragma mark -
+#pragma mark Fragment Operations
+    /**
+     * Enables the given capability (glEnable).
+     *
+     * Only GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, and GL_SCISSOR_TEST are
+     * tracked.  Other capabilities are passed directly to OpenGL.
+     *
+     * @param cap   The capability to enable
+     */
+    static void enable(GLenum cap);
+
+    /**
+     * Disables the given capability (glDisable).
+     *
+     * Only GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, and GL_SCISSOR_TEST are
+     * tracked.  Other capabilities are passed directly to OpenGL.
+     *
+     * @param cap   The capability to disable
+     */
+    static void disable(GLenum cap);
+
+    /**
+     * Sets the blend function (glBlendFunc).
+     *
+     * @param srcFactor The source blend factor
+     * @param dstFactor The destination blend factor
+     */
+    static void blendFunc(GLenum srcFactor, GLenum dstFactor);
+
+    /**
+     * Sets the blend function with separate alpha factors (glBlendFuncSeparate).
+     *
+     * If the alpha factors are the same as the color factors, this issues
+     * glBlendFunc instead.
+     *
+     * @param srcFactor The source blend factor for color
+     * @param dstFactor The destination blend factor for color
+     * @param srcAlpha  The source blend factor for alpha
+     * @param dstAlpha  The destination blend factor for alpha
+     */
+    static void blendFuncSeparate(GLenum srcFactor, GLenum dstFactor, GLenum srcAlpha, GLenum dstAlpha);
+
+    /**
+     * Sets the blend equation (glBlendEquation).
+     *
+     * @param equation  The blend equation
+     */
+    static void blendEquation(GLenum equation);
+
+    /**
+     * Sets the depth function (glDepthFunc).
+     *
+     * @param function  The depth function
+     */
+    static void depthFunc(GLenum function);
+
+    /**
+     * Sets whether to write to the depth buffer (glDepthMask).
+     *
+     * @param flag  Whether to write to the depth buffer
+     */
+    static void depthMask(GLboolean flag);
+
+    /**
+     * Sets the clear color (glClearColor).
+     *
+     * @param red   The red component
+     * @param green The green component
+     * @param blue  The blue component
+     * @param alpha The alpha component
+     */
+    static void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+};
+
+}
+
+#endif /* __CU_GL_STATE_H__ */
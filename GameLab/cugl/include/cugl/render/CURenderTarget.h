@@ -521,6 +521,19 @@ public:
      */
     void begin();
     
+    /**
+     * Resumes sending draw commands to this render target.
+     *
+     * This method is the same as {@link #begin}, except that it does not
+     * clear the output textures.  It is used to draw on top of the previous
+     * contents of this render target, such as when redrawing part of a frame.
+     *
+     * It is NOT safe to call a resume/end pair of a render target inside of
+     * another render target.  Render targets do not keep a stack.  They alway
+     * return control to the default render target (the screen) when done.
+     */
+    void resume();
+    
     /**
      * Stops sendinging draw commands to this render target.
      *
@@ -161,6 +161,9 @@ private:
      * as well.
      *
      * If compilation fails, it will display error messages on the log.
+     * If the {@link ShaderCache} is active, this method will first attempt to
+     * restore the program from the cache, and will store the program in the
+     * cache if it has to compile it.
      *
      * @return true if compilation was successful.
      */
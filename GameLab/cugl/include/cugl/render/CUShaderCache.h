@@ -0,0 +1,319 @@
+//
+//  CUShaderCache.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an on-disk cache of linked shader programs.  Compiling
+//  and linking GLSL is a large part of the start-up time on low-end devices.
+//  When the driver supports program binaries, this cache saves each linked
+//  program to the save directory, and restores it on the next launch instead
+//  of recompiling it.
+//
+//  Cache entries are keyed by a hash of the shader source together with the
+//  driver vendor, renderer, and version.  Therefore a driver update simply
+//  invalidates the cache.  If a cached binary is rejected for any reason, the
+//  shader falls back to ordinary compilation and the entry is replaced.
+//
+//  This class is a singleton, in the same way as the other CUGL subsystems.
+//  It must be started (after the OpenGL context exists) to be used. Once it
+//  is started, every call to Shader#init will use it automatically, and the
+//  built-in shaders of the engine are precompiled in the background.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/2/21
+#ifndef __CU_SHADER_CACHE_H__
+#define __CU_SHADER_CACHE_H__
+#include <cugl/base/CUBase.h>
+#include <cugl/util/CUThreadPool.h>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <mutex>
+
+namespace cugl {
+
+/**
+ * This class is a singleton cache of linked shader programs.
+ *
+ * When started, this cache checks whether the driver supports program
+ * binaries (via glGetProgramBinary).  If so, every shader compiled by
+ * {@link Shader} is saved to disk after linking, and restored with
+ * glProgramBinary the next time the same source is used on the same driver.
+ * If the driver does not support program binaries, the cache quietly does
+ * nothing, and shaders compile as they always have.
+ *
+ * The cache can also precompile shaders.  Registered shaders have their cache
+ * files read in a background thread at start-up.  Shaders with no cache entry
+ * are compiled on the main thread, one per animation frame, so that they are
+ * ready (and cached) by the time they are first needed.  The shaders of
+ * {@link SpriteBatch} are registered when the cache starts.
+ *
+ * All of the methods that touch OpenGL must be called on the main thread.
+ */
+class ShaderCache : public std::enable_shared_from_this<ShaderCache> {
+private:
+    /** The singleton shader cache (shared with any precompilation in flight) */
+    static std::shared_ptr<ShaderCache> _gCache;
+
+    /**
+     * A program binary in memory
+     */
+    class Entry {
+    public:
+        /** The driver-specific binary format */
+        GLenum format;
+        /** The binary program data */
+        std::vector<Uint8> data;
+    };
+
+    /** The directory storing the cache files */
+    std::string _directory;
+    /** The hash of the driver vendor, renderer and version */
+    Uint64 _driver;
+    /** Whether this driver supports program binaries */
+    bool _supported;
+
+    /** The binaries read in advance by the precompiler */
+    std::unordered_map<Uint64, Entry> _entries;
+    /** A mutex for accessing the precompiled binaries */
+    std::mutex _mutex;
+    /** The thread for reading cache files in the background */
+    std::shared_ptr<ThreadPool> _loader;
+
+    /** The number of cache hits (for profiling) */
+    Uint32 _hits;
+    /** The number of cache misses (for profiling) */
+    Uint32 _misses;
+
+#pragma mark Constructors
+    /**
+     * Creates a new, uninitialized shader cache.
+     *
+     * The cache is not usable until it is initialized.
+     */
+    ShaderCache();
+
+    /**
+     * Deletes this shader cache, disposing all resources.
+     */
+    ~ShaderCache() { dispose(); }
+
+    /**
+     * Initializes this shader cache with the given directory.
+     *
+     * This method queries the driver for program binary support.  It must be
+     * called on the main thread after the OpenGL context is created.
+     *
+     * @param directory The directory to store the cache files
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const std::string& directory);
+
+    /**
+     * Disposes all of the resources used by this cache.
+     *
+     * This does not delete any cache files on disk.
+     */
+    void dispose();
+
+#pragma mark Internal Helpers
+    /**
+     * Returns the cache key for the given shader sources.
+     *
+     * The key combines the source text with the driver identity.
+     *
+     * @param vsource   The source string for the vertex shader
+     * @param fsource   The source string for the fragment shader
+     *
+     * @return the cache key for the given shader sources.
+     */
+    Uint64 hash(const std::string& vsource, const std::string& fsource) const;
+
+    /**
+     * Returns the path of the cache file for the given key.
+     *
+     * @param key   The cache key
+     *
+     * @return the path of the cache file for the given key.
+     */
+    std::string getPath(Uint64 key) const;
+
+    /**
+     * Returns true if the cache file for the given key was read successfully.
+     *
+     * This method performs no OpenGL calls, and so it is safe to call from
+     * any thread.
+     *
+     * @param key   The cache key
+     * @param entry The entry to store the binary
+     *
+     * @return true if the cache file for the given key was read successfully.
+     */
+    bool readEntry(Uint64 key, Entry& entry) const;
+
+    /**
+     * Returns true if the binary was written to the cache file for the key.
+     *
+     * This method performs no OpenGL calls, and so it is safe to call from
+     * any thread.
+     *
+     * @param key   The cache key
+     * @param entry The binary to write
+     *
+     * @return true if the binary was written to the cache file for the key.
+     */
+    bool writeEntry(Uint64 key, const Entry& entry) const;
+
+public:
+#pragma mark Static Accessors
+    /**
+     * Returns the singleton instance of the shader cache.
+     *
+     * If the shader cache has not been started, then this method will return
+     * nullptr.
+     *
+     * @return the singleton instance of the shader cache.
+     */
+    static ShaderCache* get() { return _gCache.get(); }
+
+    /**
+     * Starts the singleton shader cache, storing files in the given directory.
+     *
+     * Once this method is called, the method get() will no longer return
+     * nullptr, and all shaders will use the cache.  Calling the method
+     * multiple times (without calling stop) will have no effect. The directory
+     * is typically the {@link Application#getSaveDirectory}.
+     *
+     * This method must be called on the main thread after the OpenGL context
+     * has been created.  If the driver does not support program binaries, the
+     * cache will start, but will have no effect.  Otherwise, the built-in
+     * shaders of {@link SpriteBatch} are registered for precompilation.
+     *
+     * @param directory The directory to store the cache files
+     *
+     * @return true if the cache was successfully started
+     */
+    static bool start(const std::string& directory);
+
+    /**
+     * Shuts down the singleton shader cache, releasing all resources.
+     *
+     * Once this method is called, the method get() will return nullptr.
+     * Calling the method multiple times (without calling start) will have
+     * no effect.  Cache files on disk are not removed.
+     *
+     * Any precompilation that is still queued is abandoned.
+     */
+    static void stop();
+
+#pragma mark Cache Access
+    /**
+     * Returns true if this driver supports program binaries.
+     *
+     * If this method returns false, the cache will have no effect.
+     *
+     * @return true if this driver supports program binaries.
+     */
+    bool isSupported() const { return _supported; }
+
+    /**
+     * Returns true if the program was restored from the cache.
+     *
+     * The program should be freshly created by glCreateProgram, with no
+     * attached shaders.  If this method succeeds, the program is linked and
+     * ready to use.  Otherwise, the program is unchanged and the shader
+     * should be compiled normally.
+     *
+     * @param vsource   The source string for the vertex shader
+     * @param fsource   The source string for the fragment shader
+     * @param program   The program to restore
+     *
+     * @return true if the program was restored from the cache.
+     */
+    bool load(const std::string& vsource, const std::string& fsource, GLuint program);
+
+    /**
+     * Prepares a program to be stored in the cache.
+     *
+     * This method must be called before the program is linked. It tells the
+     * driver that the binary will be retrieved after linking.
+     *
+     * @param program   The program to prepare
+     */
+    void prepare(GLuint program);
+
+    /**
+     * Returns true if the linked program was stored in the cache.
+     *
+     * The program must have been prepared before linking.
+     *
+     * @param vsource   The source string for the vertex shader
+     * @param fsource   The source string for the fragment shader
+     * @param program   The linked program to store
+     *
+     * @return true if the linked program was stored in the cache.
+     */
+    bool store(const std::string& vsource, const std::string& fsource, GLuint program);
+
+    /**
+     * Registers the given shader for asynchronous precompilation.
+     *
+     * The cache file for this shader is read in a background thread.  If
+     * there is no valid cache file, the shader is compiled on the main thread
+     * at the next animation frame and stored in the cache.  Either way, the
+     * next {@link Shader} with this source will be restored from memory.
+     *
+     * The queued work holds a reference to this cache, so it is safe to stop
+     * the cache before it completes.  This method has no effect if the driver
+     * does not support program binaries.
+     *
+     * @param vsource   The source string for the vertex shader
+     * @param fsource   The source string for the fragment shader
+     */
+    void precompile(const std::string& vsource, const std::string& fsource);
+
+    /**
+     * Deletes all files in this shader cache.
+     *
+     * This is useful for comparing cold and warm start-up times.
+     */
+    void clear();
+
+    /**
+     * Returns the number of programs restored from the cache.
+     *
+     * @return the number of programs restored from the cache.
+     */
+    Uint32 getHits() const { return _hits; }
+
+    /**
+     * Returns the number of programs that had to be compiled.
+     *
+     * @return the number of programs that had to be compiled.
+     */
+    Uint32 getMisses() const { return _misses; }
+
+};
+
+}
+
+#endif /* __CU_SHADER_CACHE_H__ */
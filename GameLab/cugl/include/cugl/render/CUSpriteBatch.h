@@ -53,6 +53,7 @@
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
 #include <cugl/math/CUColor4.h>
+#include <cugl/math/polygon/CUPolyEnums.h>
 
 // Default memory sizes
 #define DEFAULT_CAPACITY  8192
@@ -156,8 +157,12 @@ private:
         GLenum srcFactor;
         /** The stored destination factor */
         GLenum dstFactor;
+        /** Whether the alpha channel accumulates coverage */
+        bool coverage;
         /** The stored depth testing support */
         GLenum depthFunc;
+        /** Whether to write to the depth buffer */
+        bool depthWrite;
         /** The stored perspective matrix */
         std::shared_ptr<Mat4> perspective;
         /** The stored texture */
@@ -166,6 +171,14 @@ private:
         GLsizei blockptr;
         /** The pixel step for our blur function */
         GLuint  blurstep;
+        /** The outline width for distance field textures */
+        float outline;
+        /** The glow width for distance field textures */
+        float glow;
+        /** The outline color for distance field textures */
+        Color4f outlineColor;
+        /** The glow color for distance field textures */
+        Color4f glowColor;
         /** The dirty bits relative to the previous set of uniforms */
         GLuint dirty;
     };
@@ -219,6 +232,11 @@ private:
     /** The number of OpenGL calls in this pass (so far) */
     unsigned int _callTotal;
     
+    /** The shader for GPU strokes (allocated on first use) */
+    std::shared_ptr<Shader> _strokeShader;
+    /** The instance buffer for GPU strokes (allocated on first use) */
+    std::shared_ptr<VertexBuffer> _strokebuff;
+    
 
 #pragma mark -
 #pragma mark Constructors
@@ -445,6 +463,16 @@ public:
         return (result->init(capacity,shader) ? result : nullptr);
     }
 
+    /**
+     * Registers the built-in sprite batch shaders with the {@link ShaderCache}.
+     *
+     * This registers both the default shader and the stroke shader, so that
+     * they are restored (or compiled) before the first sprite batch needs
+     * them.  It is called by {@link ShaderCache#start}, and does nothing if
+     * the shader cache is not running.
+     */
+    static void precompileShaders();
+
 #pragma mark -
 #pragma mark Attributes
     /**
@@ -687,6 +715,33 @@ public:
      */
     GLenum getDestinationBlendFactor() const { return _context->dstFactor; }
     
+    /**
+     * Sets whether the alpha channel accumulates coverage.
+     *
+     * Normally the alpha channel is blended with the same factors as the
+     * color channels.  With the default blend function, that squares the
+     * alpha of anything drawn to a clear render target.  If this value is
+     * true, the alpha channel is blended with GL_ONE and
+     * GL_ONE_MINUS_SRC_ALPHA instead, whatever the blend function.  A render
+     * target drawn this way holds the premultiplied image of what was drawn,
+     * and can be composited with GL_ONE and GL_ONE_MINUS_SRC_ALPHA.  The
+     * initial value is false.
+     *
+     * @param flag  Whether the alpha channel accumulates coverage
+     */
+    void setAlphaCoverage(bool flag);
+    
+    /**
+     * Returns true if the alpha channel accumulates coverage.
+     *
+     * If this value is true, the alpha channel is blended with GL_ONE and
+     * GL_ONE_MINUS_SRC_ALPHA, whatever the blend function.  The initial
+     * value is false.
+     *
+     * @return true if the alpha channel accumulates coverage.
+     */
+    bool getAlphaCoverage() const { return _context->coverage; }
+    
     /**
      * Sets the blending equation for this sprite batch
      *
@@ -741,6 +796,30 @@ public:
      */
     GLenum getDepthFunc() const { return _context->depthFunc; }
     
+    /**
+     * Sets whether this sprite batch writes to the depth buffer.
+     *
+     * This value only matters if depth testing is enabled (see
+     * {@link #setDepthFunc}), as OpenGL never writes depth without a depth
+     * test.  Disabling writes allows transparent shapes to be depth tested
+     * against opaque ones without occluding each other.  The initial value
+     * is true.
+     *
+     * @param write Whether to write to the depth buffer
+     */
+    void setDepthWrite(bool write);
+    
+    /**
+     * Returns true if this sprite batch writes to the depth buffer.
+     *
+     * This value only matters if depth testing is enabled (see
+     * {@link #setDepthFunc}), as OpenGL never writes depth without a depth
+     * test.  The initial value is true.
+     *
+     * @return true if this sprite batch writes to the depth buffer.
+     */
+    bool getDepthWrite() const { return _context->depthWrite; }
+    
     /**
      * Sets the current depth of this sprite batch.
      *
@@ -805,6 +884,91 @@ public:
      */
     GLuint getBlurStep() const { return _context->blurstep; }
     
+    /**
+     * Sets whether the active texture is a signed distance field.
+     *
+     * A distance field texture (such as the atlas of a {@link Font} with
+     * distance field support) stores the distance to the nearest glyph edge
+     * in its alpha channel, with 0.5 on the edge itself.  When this value is
+     * true, the alpha channel is thresholded in the shader rather than used
+     * directly.  This produces crisp edges at any scale, and allows for the
+     * outline and glow effects.
+     *
+     * This value should be false for all other textures.  It is false by
+     * default.
+     *
+     * @param field Whether the active texture is a signed distance field
+     */
+    void setDistanceField(bool field);
+    
+    /**
+     * Returns true if the active texture is a signed distance field.
+     *
+     * A distance field texture (such as the atlas of a {@link Font} with
+     * distance field support) stores the distance to the nearest glyph edge
+     * in its alpha channel, with 0.5 on the edge itself.  When this value is
+     * true, the alpha channel is thresholded in the shader rather than used
+     * directly.  This produces crisp edges at any scale, and allows for the
+     * outline and glow effects.
+     *
+     * This value should be false for all other textures.  It is false by
+     * default.
+     *
+     * @return true if the active texture is a signed distance field.
+     */
+    bool isDistanceField() const;
+    
+    /**
+     * Sets the outline for distance field textures.
+     *
+     * The outline is drawn just outside of the edge of the distance field.
+     * The width is measured in distance field units, where 0.5 is the full
+     * spread of the field (see {@link Font#getDistanceSpread}). So a width
+     * of 0.25 is an outline half the spread in pixels (at reference scale).
+     * A width of 0 disables the outline.
+     *
+     * This setting has no effect unless {@link #setDistanceField} is true.
+     *
+     * @param width The outline width in distance field units
+     * @param color The outline color
+     */
+    void setDistanceOutline(float width, const Color4f color);
+    
+    /**
+     * Returns the outline width for distance field textures.
+     *
+     * The width is measured in distance field units, where 0.5 is the full
+     * spread of the field.  A width of 0 means there is no outline.
+     *
+     * @return the outline width for distance field textures.
+     */
+    float getDistanceOutline() const { return _context->outline; }
+    
+    /**
+     * Sets the glow for distance field textures.
+     *
+     * The glow fades out from the edge of the distance field (or the outline
+     * if there is one).  The width is measured in distance field units, where
+     * 0.5 is the full spread of the field (see {@link Font#getDistanceSpread}).
+     * A width of 0 disables the glow.
+     *
+     * This setting has no effect unless {@link #setDistanceField} is true.
+     *
+     * @param width The glow width in distance field units
+     * @param color The glow color
+     */
+    void setDistanceGlow(float width, const Color4f color);
+    
+    /**
+     * Returns the glow width for distance field textures.
+     *
+     * The width is measured in distance field units, where 0.5 is the full
+     * spread of the field.  A width of 0 means there is no glow.
+     *
+     * @return the glow width for distance field textures.
+     */
+    float getDistanceGlow() const { return _context->glow; }
+    
 
 #pragma mark -
 #pragma mark Rendering
@@ -1863,9 +2027,129 @@ public:
               const Poly2& poly, const Vec2 origin, const Mat4& transform);
 
 
+#pragma mark -
+#pragma mark GPU Strokes
+    /**
+     * Draws the given stroke segments with the current color and texture.
+     *
+     * Each segment is expanded by a dedicated shader into a quad, together
+     * with its joint to the next segment (or its end caps). This is the GPU
+     * equivalent of a mesh from {@link SimpleExtruder}. Because the CPU only
+     * uploads one record per segment, it is much faster for long or animated
+     * paths. Use {@link #makeStroke} to create the segments.
+     *
+     * The segments are drawn immediately, using the current perspective,
+     * color, texture, blend settings, depth and scissor mask. Any shapes
+     * batched so far are flushed first, so draw order is preserved. This
+     * method does not support gradients.
+     *
+     * The segments are transformed by the given matrix. The texture map
+     * converts (untransformed) segment positions into texture coordinates.
+     *
+     * @param segments  The stroke segments
+     * @param count     The number of segments
+     * @param transform The coordinate transform
+     * @param texmap    The texture coordinate map
+     */
+    void stroke(const StrokeSegment* segments, size_t count, const Mat4& transform,
+                const Affine2& texmap);
+
+    /**
+     * Draws the given stroke segments with the current color and texture.
+     *
+     * Each segment is expanded by a dedicated shader into a quad, together
+     * with its joint to the next segment (or its end caps). This is the GPU
+     * equivalent of a mesh from {@link SimpleExtruder}. Because the CPU only
+     * uploads one record per segment, it is much faster for long or animated
+     * paths. Use {@link #makeStroke} to create the segments.
+     *
+     * The segments are drawn immediately, using the current perspective,
+     * color, texture, blend settings, depth and scissor mask. Any shapes
+     * batched so far are flushed first, so draw order is preserved. This
+     * method does not support gradients.
+     *
+     * The segments are transformed by the given matrix. The texture map
+     * converts (untransformed) segment positions into texture coordinates.
+     *
+     * @param segments  The stroke segments
+     * @param transform The coordinate transform
+     * @param texmap    The texture coordinate map
+     */
+    void stroke(const std::vector<StrokeSegment>& segments, const Mat4& transform,
+                const Affine2& texmap) {
+        stroke(segments.data(), segments.size(), transform, texmap);
+    }
+    
+    /**
+     * Appends the stroke segments for the given path to the vector.
+     *
+     * The path is a sequence of vertices, as in {@link SimpleExtruder#set}.
+     * A closed path with more than two vertices has no caps, and has a joint
+     * at every vertex. The stroke width is the distance from the path to
+     * either edge, as in {@link SimpleExtruder#calculate}.
+     *
+     * @param path      The path vertices
+     * @param closed    Whether the path is closed
+     * @param stroke    The stroke width
+     * @param joint     The joint type
+     * @param cap       The end cap type
+     * @param segments  The vector to store the segments
+     *
+     * @return the number of segments appended
+     */
+    static size_t makeStroke(const std::vector<Vec2>& path, bool closed, float stroke,
+                             poly2::Joint joint, poly2::EndCap cap,
+                             std::vector<StrokeSegment>& segments);
+    
+    /**
+     * Appends the stroke segments for the given path to the vector.
+     *
+     * The path indices are treated as a list of line segments (so the
+     * geometry should be PATH or IMPLICIT). Consecutive segments that share
+     * a vertex are connected by a joint.  A connected run that returns to
+     * its start (with more than two segments) is closed and has no caps.
+     * The stroke width is the distance from the path to either edge, as in
+     * {@link SimpleExtruder#calculate}.
+     *
+     * @param path      The path polygon
+     * @param stroke    The stroke width
+     * @param joint     The joint type
+     * @param cap       The end cap type
+     * @param segments  The vector to store the segments
+     *
+     * @return the number of segments appended
+     */
+    static size_t makeStroke(const Poly2& path, float stroke,
+                             poly2::Joint joint, poly2::EndCap cap,
+                             std::vector<StrokeSegment>& segments);
+    
+    /**
+     * Returns the bounding box of the given stroke segments.
+     *
+     * The box covers everything the stroke shader draws for these segments,
+     * including square caps and the tips of mitre joints.  It is empty if
+     * there are no segments.
+     *
+     * @param segments  The stroke segments
+     *
+     * @return the bounding box of the given stroke segments.
+     */
+    static Rect getStrokeBounds(const std::vector<StrokeSegment>& segments);
+
+    
 #pragma mark -
 #pragma mark Internal Helpers
 private:
+    /**
+     * Allocates the shader and instance buffer for GPU strokes.
+     *
+     * This method is called the first time that a stroke is drawn, so that
+     * sprite batches that never draw strokes pay nothing for them.
+     *
+     * @return true if the stroke pipeline was successfully allocated
+     */
+    bool initStroke();
+    
     /**
      * Sets the current drawing command.
      *
@@ -1900,6 +2184,15 @@ private:
      */
     void unwind();
     
+    /**
+     * Sets the OpenGL blend function to agree with the given context.
+     *
+     * This method is called upon flushing.
+     *
+     * @param context   The uniform context to apply
+     */
+    void applyBlendFunc(Context* context);
+    
     /**
      * Sets the active uniform block to agree with the gradient and stroke.
      *
@@ -97,6 +97,54 @@ public:
     static const GLvoid* texcoordOffset()   { return (GLvoid*)offsetof(SpriteVertex2, texcoord);  }
 };
 
+/**
+ * This class/struct is a single segment of a stroke for a sprite batch.
+ *
+ * The class is intended to be used as a struct.  Unlike the vertex types,
+ * a segment is not drawn directly.  It is an instance record that is
+ * expanded by the stroke shader of {@link SpriteBatch} into the segment
+ * quad, together with the joint to the next segment (or the cap on either
+ * end if there is no neighbor).  This is the GPU equivalent of the
+ * extrusion performed by {@link SimpleExtruder}.
+ *
+ * The neighbor points are only used if the appropriate flag is set. The
+ * flags also store the joint and cap type, so that one buffer can hold
+ * paths of several different styles.  The flags are a bit vector stored
+ * as a float, as integer attributes are not supported by {@link VertexBuffer}.
+ * Use {@link SpriteBatch#makeStroke} to create segments from a path.
+ */
+class StrokeSegment {
+public:
+    /** The flag indicating that the segment has a predecessor */
+    static const int PREVIOUS = 1;
+    /** The flag indicating that the segment has a successor */
+    static const int NEXT = 2;
+    /** The bit shift of the {@link poly2::Joint} in the flags */
+    static const int JOINT_SHIFT = 2;
+    /** The bit shift of the {@link poly2::EndCap} in the flags */
+    static const int CAP_SHIFT = 4;
+    
+    /** The start of the segment */
+    cugl::Vec2 p0;
+    /** The end of the segment */
+    cugl::Vec2 p1;
+    /** The start of the previous segment (if the PREVIOUS flag is set) */
+    cugl::Vec2 prev;
+    /** The end of the next segment (if the NEXT flag is set) */
+    cugl::Vec2 next;
+    /** The stroke width (the distance from the path to either edge) */
+    float stroke;
+    /** The neighbor, joint and cap flags */
+    float flags;
+    
+    /** The memory offset of the segment end points */
+    static const GLvoid* segmentOffset()    { return (GLvoid*)offsetof(StrokeSegment, p0);     }
+    /** The memory offset of the segment neighbors */
+    static const GLvoid* neighborOffset()   { return (GLvoid*)offsetof(StrokeSegment, prev);   }
+    /** The memory offset of the stroke width and flags */
+    static const GLvoid* strokeOffset()     { return (GLvoid*)offsetof(StrokeSegment, stroke); }
+};
+
 }
 
 #endif /* __CU_VERTEX_H__ */
@@ -174,6 +174,9 @@ private:
 
     /** Whether or not the texture has mip maps */
     bool _hasMipmaps;
+    
+    /** Whether every pixel of this texture has full alpha */
+    bool _opaque;
 
     /** An all purpose blank texture for coloring */
     static std::shared_ptr<Texture> _blank;
@@ -463,6 +466,18 @@ public:
      * @return the number of bytes in a single pixel of this texture.
      */
     unsigned int getByteSize() const;
+    
+    /**
+     * Returns the estimated size of this texture in GPU memory.
+     *
+     * This is the size of the pixel data, plus a third for the mipmaps if
+     * they are built.  The driver may pad the data or store it in another
+     * format, so this is only an estimate.  A subtexture returns the size
+     * of its parent.
+     *
+     * @return the estimated size of this texture in GPU memory.
+     */
+    size_t getGPUSize() const;
      
     /** 
      * Returns the data format of this texture.
@@ -485,6 +500,39 @@ public:
     bool hasMipMaps() const {
         return (_parent != nullptr ? _parent->hasMipMaps() : _hasMipmaps);
     }
+    
+    /**
+     * Returns true if every pixel of this texture has full alpha.
+     *
+     * A format without an alpha channel is always opaque.  For an RGBA
+     * texture, this is determined from the data when the texture is
+     * initialized or set.  A texture with no initial data (such as the
+     * output of a render target) is assumed to be transparent.
+     *
+     * Opaque textures can be drawn without blending, which allows
+     * {@link scene2::Scene2} to reject hidden pixels with the depth buffer.
+     * If this texture is a subtexture, this is the value of its parent.
+     *
+     * @return true if every pixel of this texture has full alpha.
+     */
+    bool isOpaque() const {
+        return (_parent != nullptr ? _parent->isOpaque() : _opaque);
+    }
+    
+    /**
+     * Sets whether every pixel of this texture has full alpha.
+     *
+     * This value is normally determined from the texture data.  This
+     * setter allows an application to override it, such as for a render
+     * target that is known to be opaque.  Marking a texture with partial
+     * alpha as opaque will produce rendering artifacts.
+     *
+     * This method will fail if this texture is a subtexture.  Only the
+     * parent can be marked opaque.
+     *
+     * @param opaque    Whether every pixel of this texture has full alpha
+     */
+    void setOpaque(bool opaque);
 
     /**
      * Builds mipmaps for the current texture.
@@ -97,6 +97,8 @@ private:
         GLboolean norm;
         /** The offset of the attribute in the vertex buffer */
         GLsizeiptr offset;
+        /** The number of instances sharing each value (0 for per vertex) */
+        GLuint divisor;
     };
     
     /** The data stride of this buffer (0 if there is only one attribute) */
@@ -108,6 +110,10 @@ private:
     GLuint _vertBuffer;
     /** The index buffer for drawing a shape */
     GLuint _indxBuffer;
+    /** The number of bytes last loaded into the vertex buffer */
+    GLsizeiptr _vertBytes;
+    /** The number of bytes last loaded into the index buffer */
+    GLsizeiptr _indxBytes;
     
     /** The shader currently attached to this vertex buffer */
     std::shared_ptr<Shader> _shader;
@@ -421,6 +427,27 @@ public:
      */
     void disableAttribute(const std::string name);
     
+    /**
+     * Sets the instance divisor of the given attribute
+     *
+     * By default, every attribute is a vertex attribute, advancing once per
+     * vertex.  An attribute with a positive divisor instead advances once
+     * every divisor instances in a call to {@link #drawInstanced}.  This
+     * allows a vertex buffer to store one record per instance (such as a
+     * line segment), which is then expanded by the vertex shader.
+     *
+     * A shader using only instanced attributes may use gl_VertexID to
+     * identify the vertex of each instance, with the index buffer providing
+     * the template.
+     *
+     * Like {@link #setupAttribute}, this value is cached and applied when a
+     * shader is attached. The attribute must be set up first.
+     *
+     * @param name      The attribute name
+     * @param divisor   The number of instances sharing each value
+     */
+    void setAttributeDivisor(const std::string name, GLuint divisor);
+    
 
 };
 
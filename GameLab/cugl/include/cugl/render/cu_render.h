@@ -29,12 +29,14 @@
 #define __CU_RENDER_PKG_H__
 
 #include "CUSpriteVertex.h"
+#include "CUGLState.h"
 #include "CUTexture.h"
 #include "CUFont.h"
 #include "CUMesh.h"
 #include "CUScissor.h"
 #include "CUGradient.h"
 #include "CUShader.h"
+#include "CUShaderCache.h"
 #include "CUUniformBuffer.h"
 #include "CURenderTarget.h"
 #include "CUSpriteBatch.h"
@@ -45,7 +45,10 @@
 
 #include <cugl/math/cu_math.h>
 #include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/scene2/CUScene2Cache.h>
 #include <cugl/render/CUOrthographicCamera.h>
+#include <cugl/render/CURenderTarget.h>
+#include <vector>
 
 namespace cugl {
     
@@ -91,6 +94,33 @@ protected:
 
     /** Whether or note this scene is still active */
     bool _active;
+    
+    /** The render targets for the cached subtrees of this scene */
+    std::shared_ptr<Scene2Cache> _cache;
+    
+    /** The previous frame, when only damaged regions are redrawn */
+    std::shared_ptr<RenderTarget> _frame;
+    /** Whether to only redraw the damaged regions of this scene */
+    bool _damageTracking;
+    /** Whether to outline the redrawn regions on the screen */
+    bool _damageOverlay;
+    /** Whether the entire scene must be redrawn */
+    bool _damageFull;
+    /** The damaged regions reported since the last render */
+    std::vector<Rect> _damage;
+    /** The regions redrawn in the last render */
+    std::vector<Rect> _redrawn;
+    /** The camera matrix of the previous frame */
+    Mat4 _damageCamera;
+    /** The region being redrawn; subtrees outside of it are skipped */
+    Rect _damageCull;
+    
+    /** Whether to draw opaque nodes first, front to back */
+    bool _opaquePass;
+    /** The flattened scene graph for the opaque pass (reused each frame) */
+    std::vector<scene2::SceneNode::DrawItem> _drawlist;
+    /** The number of nodes drawn in the last opaque pass */
+    size_t _opaqueCount;
 
 #pragma mark -
 #pragma mark Constructors
@@ -327,7 +357,7 @@ public:
      *
      * @param color  The tint color for this scene.
      */
-    void setColor(Color4 color) { _color = color; }
+    void setColor(Color4 color) { _color = color; _damageFull = true; }
     
     /**
      * Returns a string representation of this scene for debugging purposes.
@@ -343,6 +373,177 @@ public:
     
     /** Cast from a Scene to a string. */
     operator std::string() const { return toString(); }
+    
+    /**
+     * Returns the render cache pool for this scene.
+     *
+     * This pool owns the textures of every node in this scene for which
+     * {@link scene2::SceneNode#isRenderCached} is true.
+     *
+     * @return the render cache pool for this scene.
+     */
+    std::shared_ptr<Scene2Cache> getRenderCache() const { return _cache; }
+    
+    /**
+     * Returns the memory limit (in bytes) for the render caches of this scene.
+     *
+     * When this limit is exceeded, the least recently drawn caches are
+     * released.  Those nodes are rendered normally for a frame, and then
+     * request a new cache.
+     *
+     * @return the memory limit (in bytes) for the render caches of this scene.
+     */
+    size_t getRenderCacheLimit() const {
+        return _cache == nullptr ? 0 : _cache->getLimit();
+    }
+    
+    /**
+     * Sets the memory limit (in bytes) for the render caches of this scene.
+     *
+     * When this limit is exceeded, the least recently drawn caches are
+     * released.  Those nodes are rendered normally for a frame, and then
+     * request a new cache.
+     *
+     * @param limit The memory limit (in bytes) for the render caches of this scene.
+     */
+    void setRenderCacheLimit(size_t limit) {
+        if (_cache != nullptr) { _cache->setLimit(limit); }
+    }
+
+#pragma mark -
+#pragma mark Damage Tracking
+    /**
+     * Returns true if this scene only redraws its damaged regions.
+     *
+     * See {@link setDamageTracking} for details.
+     *
+     * @return true if this scene only redraws its damaged regions.
+     */
+    bool isDamageTracking() const { return _damageTracking; }
+    
+    /**
+     * Sets whether this scene only redraws its damaged regions.
+     *
+     * When damage tracking is active, the scene keeps the previous frame in
+     * a render target the size of the viewport.  Each {@link render} only
+     * redraws the regions of that frame that were damaged by a change to a
+     * node (its transform, content, or visibility), and then copies the
+     * frame to the screen.  If nothing changed, {@link hasDamage} is false,
+     * and the application may skip the frame entirely with
+     * {@link Application#skipFrame}.
+     *
+     * The damaged regions are redrawn with a scissor, so the result is the
+     * same as a full redraw.  However, nodes must call
+     * {@link scene2::SceneNode#invalidateRenderCache} whenever they change
+     * something that affects their appearance, as with render caching.  A
+     * node that draws outside of its content bounds must also override
+     * {@link scene2::SceneNode#getDrawBounds}.  The copy to the screen
+     * replaces the screen contents, so this mode is intended for a scene
+     * that covers the entire display.
+     *
+     * @param flag  Whether to only redraw the damaged regions of this scene
+     */
+    void setDamageTracking(bool flag);
+    
+    /**
+     * Returns true if the next render would change the frame.
+     *
+     * This is always true if damage tracking is not active.
+     *
+     * @return true if the next render would change the frame.
+     */
+    bool hasDamage() const;
+    
+    /**
+     * Marks the given region (in scene coordinates) as damaged.
+     *
+     * The nodes of a scene report their own damage.  This method is for
+     * changes that the scene graph cannot see, such as a custom shader
+     * uniform.  It does nothing if the rectangle is empty.
+     *
+     * @param rect  The damaged region in scene coordinates
+     */
+    void addDamage(const Rect rect);
+    
+    /**
+     * Returns the regions (in scene coordinates) redrawn by the last render.
+     *
+     * This list is empty if the last render did not change the frame, or if
+     * damage tracking is not active.
+     *
+     * @return the regions (in scene coordinates) redrawn by the last render.
+     */
+    const std::vector<Rect>& getRedrawnRegions() const { return _redrawn; }
+    
+    /**
+     * Returns true if the redrawn regions are outlined on the screen.
+     *
+     * This is a debugging tool for damage tracking.  The outlines are not
+     * part of the saved frame.
+     *
+     * @return true if the redrawn regions are outlined on the screen.
+     */
+    bool isDamageOverlay() const { return _damageOverlay; }
+    
+    /**
+     * Sets whether the redrawn regions are outlined on the screen.
+     *
+     * This is a debugging tool for damage tracking.  The outlines are not
+     * part of the saved frame.
+     *
+     * @param flag  Whether the redrawn regions are outlined on the screen.
+     */
+    void setDamageOverlay(bool flag) { _damageOverlay = flag; }
+
+#pragma mark -
+#pragma mark Opaque Pass
+    /**
+     * Returns true if this scene draws opaque nodes first, front to back.
+     *
+     * See {@link setOpaquePass} for details.
+     *
+     * @return true if this scene draws opaque nodes first, front to back.
+     */
+    bool isOpaquePass() const { return _opaquePass; }
+    
+    /**
+     * Sets whether this scene draws opaque nodes first, front to back.
+     *
+     * By default, a scene draws every node back to front with blending.
+     * Layered backgrounds therefore touch every pixel several times. With
+     * an opaque pass, the scene assigns each node a depth from its order
+     * in the scene graph. Nodes that are opaque (see
+     * {@link scene2::SceneNode#isOpaque}) with a fully opaque tint are
+     * drawn first, front to back, writing the depth buffer.  The remaining
+     * nodes are then drawn back to front, tested against (but not writing)
+     * the depth buffer.  Any pixel hidden by an opaque node is rejected
+     * before it is shaded.
+     *
+     * The result is the same as the default render, provided that the
+     * opaque nodes really are opaque.  Nodes with a render cache or a
+     * scissor are never opaque.  The scene clears the depth buffer when it
+     * renders, so the display (or render target) must have one.
+     *
+     * @param flag  Whether to draw opaque nodes first, front to back
+     */
+    void setOpaquePass(bool flag) {
+        _opaquePass = flag;
+        _opaqueCount = 0;
+        if (!flag) {
+            _drawlist.clear();
+            _drawlist.shrink_to_fit();
+        }
+    }
+    
+    /**
+     * Returns the number of nodes drawn in the last opaque pass.
+     *
+     * This is a profiling tool for {@link setOpaquePass}.  It is 0 if there
+     * is no opaque pass.
+     *
+     * @return the number of nodes drawn in the last opaque pass.
+     */
+    size_t getOpaqueCount() const { return _opaqueCount; }
 
 #pragma mark -
 #pragma mark View Size
@@ -636,6 +837,38 @@ public:
     inline std::shared_ptr<T> getChildByName(const std::string name) const {
         return std::dynamic_pointer_cast<T>(getChildByName(name));
     }
+
+    /**
+     * Returns the descendant at the given path.
+     *
+     * A path is a sequence of node names separated by periods, such as
+     * "hud.panel.score".  The first name is a child of this scene, and the
+     * rest of the path is resolved by {@link scene2::SceneNode#getChildByPath}
+     * on that child (which caches the result).  This method returns nullptr
+     * if there is no descendant at the given path.
+     *
+     * @param path  The period-separated path to the descendant
+     *
+     * @return the descendant at the given path.
+     */
+    std::shared_ptr<scene2::SceneNode> getChildByPath(const std::string& path) const;
+    
+    /**
+     * Returns the descendant at the given path, typecast to a shared T pointer.
+     *
+     * This method is provided to simplify the polymorphism of a scene graph.
+     * While all children are a subclass of type Node, you may want to access
+     * them by their specific subclass.  If the descendant is not an instance
+     * of type T (or a subclass), this method returns nullptr.
+     *
+     * @param path  The period-separated path to the descendant
+     *
+     * @return the descendant at the given path, typecast to a shared T pointer.
+     */
+    template <typename T>
+    inline std::shared_ptr<T> getChildByPath(const std::string& path) const {
+        return std::dynamic_pointer_cast<T>(getChildByPath(path));
+    }
     
     /**
      * Returns the list of the scene's immediate children.
@@ -927,6 +1160,46 @@ public:
      */
     virtual void render(const std::shared_ptr<SpriteBatch>& batch);
     
+protected:
+    /**
+     * Redraws any out of date render caches in this scene.
+     *
+     * This method must be called before the sprite batch begins drawing (and
+     * before any render target is active), as render targets do not nest.
+     * It is very cheap if no cached subtree has changed.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     */
+    void refreshRenderCache(const std::shared_ptr<SpriteBatch>& batch);
+    
+    /**
+     * Draws the damaged regions of this scene with the given SpriteBatch.
+     *
+     * The damaged regions are redrawn into the saved frame, which is then
+     * copied to the screen.  This method assumes that the sprite batch is
+     * not actively drawing.
+     *
+     * If the saved frame cannot be allocated, this method turns off damage
+     * tracking and returns false, so that the scene falls back to a full
+     * redraw.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     *
+     * @return true if the scene was drawn
+     */
+    bool renderDamage(const std::shared_ptr<SpriteBatch>& batch);
+    
+    /**
+     * Draws the children of this scene with an active SpriteBatch.
+     *
+     * This method sets the blend state of the scene and draws the children,
+     * using an opaque pass if it is enabled.  The sprite batch must already
+     * be drawing with the scene camera.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     */
+    void renderNodes(const std::shared_ptr<SpriteBatch>& batch);
+    
 private:
 #pragma mark -
 #pragma mark Internal Helpers
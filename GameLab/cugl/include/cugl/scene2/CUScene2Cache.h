@@ -0,0 +1,248 @@
+//
+//  CUScene2Cache.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a pool of offscreen render targets for caching the
+//  output of scene graph subtrees.  A static but complex subtree (such as an
+//  ornate UI frame or a label with many glyphs) can be rendered once to a
+//  texture and then drawn as a single quad until it changes.  This pool owns
+//  those textures.  It enforces a memory limit, releasing the least recently
+//  drawn caches when the limit is exceeded.
+//
+//  Each Scene2 has its own cache pool.  You should never need to use this
+//  class directly.  Instead, call SceneNode#setRenderCached on the root of
+//  the static subtree.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/8/21
+//
+#ifndef __CU_SCENE_2_CACHE_H__
+#define __CU_SCENE_2_CACHE_H__
+#include <cugl/render/CURenderTarget.h>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <list>
+
+/** The default memory limit (in bytes) of a render cache pool */
+#define DEFAULT_RENDER_CACHE_LIMIT  33554432
+
+namespace cugl {
+
+    namespace scene2 {
+        /** Forward reference to a scene graph node */
+        class SceneNode;
+    }
+
+/**
+ * This class is a pool of render targets for caching scene graph subtrees.
+ *
+ * Every cache belongs to a single {@link scene2::SceneNode}.  The pool tracks
+ * when each cache was last drawn.  If the total size of the caches exceeds
+ * the memory limit, the least recently drawn caches are released.  A node
+ * whose cache was released simply renders normally for a frame, and then
+ * requests a new cache.
+ *
+ * Released caches are kept as spares (as long as there is room under the
+ * limit), and reused by any later request of the same size. This prevents
+ * the allocation of a new framebuffer every time a subtree is resized back
+ * and forth.
+ *
+ * Memory usage is estimated as four bytes per pixel.  All of the methods
+ * that allocate a cache must be called on the main thread.
+ */
+class Scene2Cache {
+private:
+    /**
+     * A single cache in this pool
+     */
+    class Entry {
+    public:
+        /** The node owning this cache (nullptr for a spare) */
+        const scene2::SceneNode* node;
+        /** The offscreen buffer for this cache */
+        std::shared_ptr<RenderTarget> target;
+        /** The estimated memory usage of this cache */
+        size_t bytes;
+    };
+
+    /** The caches in use, from most to least recently drawn */
+    std::list<Entry> _entries;
+    /** The spare caches, from most to least recently released */
+    std::list<Entry> _spares;
+    /** The position of each cache by owner */
+    std::unordered_map<const scene2::SceneNode*, std::list<Entry>::iterator> _index;
+    /** The memory limit of this pool in bytes */
+    size_t _limit;
+    /** The estimated memory usage of this pool in bytes */
+    size_t _usage;
+
+#pragma mark Internal Helpers
+    /**
+     * Releases caches until the memory usage is at most the given amount.
+     *
+     * Spare caches are released first, followed by the least recently drawn
+     * caches in use.
+     *
+     * @param bytes The target memory usage
+     */
+    void evict(size_t bytes);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized cache pool.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    Scene2Cache() : _limit(0), _usage(0) {}
+
+    /**
+     * Deletes this cache pool, disposing all resources.
+     */
+    ~Scene2Cache() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this cache pool.
+     *
+     * A disposed pool can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a cache pool with the given memory limit.
+     *
+     * @param limit The memory limit in bytes
+     *
+     * @return true if the pool is initialized properly, false otherwise.
+     */
+    bool init(size_t limit = DEFAULT_RENDER_CACHE_LIMIT);
+
+    /**
+     * Returns a newly allocated cache pool with the given memory limit.
+     *
+     * @param limit The memory limit in bytes
+     *
+     * @return a newly allocated cache pool with the given memory limit.
+     */
+    static std::shared_ptr<Scene2Cache> alloc(size_t limit = DEFAULT_RENDER_CACHE_LIMIT) {
+        std::shared_ptr<Scene2Cache> result = std::make_shared<Scene2Cache>();
+        return (result->init(limit) ? result : nullptr);
+    }
+
+#pragma mark Attributes
+    /**
+     * Returns the memory limit of this pool in bytes.
+     *
+     * @return the memory limit of this pool in bytes.
+     */
+    size_t getLimit() const { return _limit; }
+
+    /**
+     * Sets the memory limit of this pool in bytes.
+     *
+     * If the current usage exceeds the new limit, the least recently drawn
+     * caches are released immediately.
+     *
+     * @param limit The memory limit in bytes
+     */
+    void setLimit(size_t limit);
+
+    /**
+     * Returns the estimated memory usage of this pool in bytes.
+     *
+     * This includes the spare caches.
+     *
+     * @return the estimated memory usage of this pool in bytes.
+     */
+    size_t getUsage() const { return _usage; }
+
+    /**
+     * Returns the number of caches in use.
+     *
+     * @return the number of caches in use.
+     */
+    size_t size() const { return _entries.size(); }
+
+#pragma mark Cache Access
+    /**
+     * Returns a render target of the given size for the given node.
+     *
+     * If the node already has a cache of this size, it is returned. Otherwise
+     * the node's old cache (if any) becomes a spare, and the node is given a
+     * spare of the right size or a newly allocated one.  The result is the
+     * most recently drawn cache.
+     *
+     * This method returns nullptr if the cache would exceed the memory limit
+     * on its own, or if the render target could not be allocated.
+     *
+     * @param node      The node owning the cache
+     * @param width     The cache width in pixels
+     * @param height    The cache height in pixels
+     *
+     * @return a render target of the given size for the given node.
+     */
+    std::shared_ptr<RenderTarget> acquire(const scene2::SceneNode* node, Uint32 width, Uint32 height);
+
+    /**
+     * Returns the render target for the given node, marking it as drawn.
+     *
+     * This method returns nullptr if the node has no cache, or if its cache
+     * was released to stay under the memory limit.
+     *
+     * @param node  The node owning the cache
+     *
+     * @return the render target for the given node, marking it as drawn.
+     */
+    std::shared_ptr<RenderTarget> get(const scene2::SceneNode* node);
+
+    /**
+     * Releases the cache for the given node.
+     *
+     * The cache becomes a spare, and may be reused by another node.
+     *
+     * @param node  The node owning the cache
+     */
+    void release(const scene2::SceneNode* node);
+
+    /**
+     * Releases all caches in this pool, including the spares.
+     */
+    void clear();
+
+};
+
+}
+
+#endif /* __CU_SCENE_2_CACHE_H__ */
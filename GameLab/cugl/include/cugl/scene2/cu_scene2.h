@@ -30,6 +30,7 @@
 
 #include "CUScene2.h"
 #include "CUScene2Texture.h"
+#include "CUScene2Cache.h"
 #include "graph/CUSceneNode.h"
 #include "graph/CUTexturedNode.h"
 #include "graph/CUPolygonNode.h"
@@ -43,6 +44,10 @@
 #include "ui/CUSlider.h"
 #include "ui/CUNinePatch.h"
 #include "ui/CUTextField.h"
+#include "ui/CUScrollList.h"
+#include "ui/CUMultilineLabel.h"
+#include "ui/CUUITheme.h"
+#include "ui/CUImmediateUI.h"
 
 // And sublibraries
 #include "layout/cu_layout.h"
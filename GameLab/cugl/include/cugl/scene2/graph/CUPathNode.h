@@ -130,6 +130,11 @@ protected:
     poly2::Joint  _joint;
     /** The shape of the two end caps of the path. */
     poly2::EndCap _endcap;
+    
+    /** Whether the stroke is expanded on the GPU */
+    bool _hardware;
+    /** The stroke segments, when the stroke is expanded on the GPU */
+    std::vector<StrokeSegment> _segments;
 
 public:
 #pragma mark -
@@ -223,6 +228,7 @@ public:
      *      'joint':    One of 'mitre', 'bevel', or 'round'.
      *      'cap':      One of 'square' or 'round'.
      *      'closed':   A boolean specifying if the path is closed.
+     *      'hardware': A boolean specifying if the stroke is expanded on the GPU.
      *
      * All attributes are optional.  However, it is generally a good idea to
      * specify EITHER the texture or the polygon.
@@ -339,6 +345,7 @@ public:
      *      'joint':    One of 'mitre', 'bevel', or 'round'.
      *      'cap':      One of 'square' or 'round'.
      *      'closed':   A boolean specifying if the path is closed.
+     *      'hardware': A boolean specifying if the stroke is expanded on the GPU.
      *
      * All attributes are optional.  However, it is generally a good idea to
      * specify EITHER the texture or the polygon.
@@ -433,6 +440,38 @@ public:
      */
     poly2::EndCap getCap() const { return _endcap; }
     
+    /**
+     * Sets whether the stroke is expanded on the GPU.
+     *
+     * By default, a path with a positive stroke is extruded on the CPU with
+     * {@link SimpleExtruder}. This must be redone every time the path, the
+     * stroke width, the joint or the cap changes. A hardware stroke instead
+     * uploads one small record per segment, which is expanded in a shader by
+     * {@link SpriteBatch#stroke}. This is much faster for long or animated
+     * paths, and the result is comparable to the extruded one.
+     *
+     * Hardware strokes do not support gradients. A path with a gradient is
+     * always extruded on the CPU. As there is no extruded polygon, the
+     * extruded bounds are an estimate (exact except for sharp mitre joints).
+     *
+     * @param hardware  Whether the stroke is expanded on the GPU
+     */
+    void setHardwareStroke(bool hardware);
+    
+    /**
+     * Returns true if the stroke is expanded on the GPU.
+     *
+     * By default, a path with a positive stroke is extruded on the CPU with
+     * {@link SimpleExtruder}. This must be redone every time the path, the
+     * stroke width, the joint or the cap changes. A hardware stroke instead
+     * uploads one small record per segment, which is expanded in a shader by
+     * {@link SpriteBatch#stroke}. This is much faster for long or animated
+     * paths, and the result is comparable to the extruded one.
+     *
+     * @return true if the stroke is expanded on the GPU.
+     */
+    bool isHardwareStroke() const { return _hardware; }
+    
 #pragma mark -
 #pragma mark Polygons
     /**
@@ -558,6 +597,15 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) override;
     
+    /**
+     * Returns the region (in node space) that {@link draw} may touch.
+     *
+     * A path with a positive stroke draws its extruded path, which reaches
+     * past the content bounds.
+     *
+     * @return the region (in node space) that {@link draw} may touch.
+     */
+    virtual Rect getDrawBounds() const override;
 
     
 #pragma mark Internal Helpers
@@ -571,10 +619,22 @@ private:
      * Updates the extrusion polygon, based on the current settings.
      *
      * This method uses {@link SimpleExtruder}, as it is safe for framerate
-     * calculation.
+     * calculation. For a hardware stroke, it computes the stroke segments
+     * instead.
      */
     void updateExtrusion();
     
+    /**
+     * Draws the hardware stroke of this node via the given SpriteBatch.
+     *
+     * This method computes the texture coordinate map on the fly, so that
+     * it agrees with the one from {@link #generateRenderData}.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     */
+    void drawHardwareStroke(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform);
+    
     /**
      * Normalizes the source so that it is a closed curve with no gaps
      */
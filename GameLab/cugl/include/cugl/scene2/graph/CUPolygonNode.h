@@ -399,6 +399,17 @@ public:
      * @param tint      The tint to blend with the Node color.
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) override;
+    
+    /**
+     * Returns true if {@link draw} covers every pixel it touches at full alpha.
+     *
+     * A polygon is opaque if its texture is opaque (or it has no texture),
+     * it has no gradient, and its blend function ignores the destination
+     * at full alpha.  The polygon tint is checked separately.
+     *
+     * @return true if {@link draw} covers every pixel it touches at full alpha.
+     */
+    virtual bool isOpaque() const override;
 
     
 #pragma mark -
@@ -47,6 +47,7 @@
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUScissor.h>
 #include <cugl/assets/CUJsonValue.h>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -214,6 +215,15 @@ protected:
      */
     size_t _hashOfName;
     
+    /** Whether to index the children of this node by name and tag */
+    bool _childIndexed;
+    /** The children of this node by name (if indexed) */
+    std::unordered_multimap<std::string, SceneNode*> _nameIndex;
+    /** The children of this node by tag (if indexed) */
+    std::unordered_multimap<unsigned int, SceneNode*> _tagIndex;
+    /** The previously resolved descendants of this node by path */
+    mutable std::unordered_map<std::string, std::shared_ptr<SceneNode>> _pathCache;
+    
     /** The z-order of this node */
     int  _zOrder;
     /** Indicates whether or not the z-order is currently violated */
@@ -222,6 +232,22 @@ protected:
     /** The defining JSON data for this node (if any) */
     std::shared_ptr<JsonValue> _json;
     
+    /** Whether to render this subtree to a cached texture */
+    bool _cacheEnabled;
+    /** Whether the render cache must be redrawn */
+    bool _cacheDirty;
+    /** Whether this node or a descendant has a render cache to redraw */
+    bool _cachePending;
+    /** The region of node space covered by the render cache */
+    Rect _cacheBounds;
+    
+    /** Whether this subtree changed since the last damaged frame */
+    bool _damaged;
+    /** Whether this node or a descendant changed since the last damaged frame */
+    bool _damagePending;
+    /** The scene bounds of this subtree as of the last damaged frame */
+    Rect _damageBounds;
+    
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -570,9 +596,11 @@ public:
      * may change. To work properly, a tag should be unique within a scene
      * graph.  It is 0 if undefined.
      *
+     * If the parent of this node indexes its children, the index is updated.
+     *
      * @param tag   A tag that is used to identify the node easily.
      */
-    void setTag(unsigned int tag) { _tag = tag; }
+    void setTag(unsigned int tag);
     
     /**
      * Returns a string that is used to identify the node.
@@ -592,12 +620,12 @@ public:
      * change. In addition, the name is useful for debugging. To work properly,
      * a name should be unique within a scene graph. It is empty if undefined.
      *
+     * If the parent of this node indexes its children, the index is updated.
+     * Any cached paths through this node are invalidated.
+     *
      * @param name  A string that is used to identify the node.
      */
-    void setName(const std::string& name) {
-        _name = name;
-        _hashOfName = std::hash<std::string>()(_name);
-    }
+    void setName(const std::string& name);
 
     /**
      * Returns a string representation of this node for debugging purposes.
@@ -967,7 +995,7 @@ public:
      *
      * @param color the color tinting this node.
      */
-    virtual void setColor(Color4 color) { _tintColor = color; }
+    virtual void setColor(Color4 color) { _tintColor = color; invalidateRenderCache(); }
 
     /**
      * Returns the absolute color tinting this node.
@@ -1000,7 +1028,7 @@ public:
      *
      * @param visible   true if the node is visible.
      */
-    void setVisible(bool visible) { _isVisible = visible; }
+    void setVisible(bool visible) { _isVisible = visible; invalidateRenderCache(); }
     
     /**
      * Returns true if this node is tinted by its parent.
@@ -1022,7 +1050,7 @@ public:
      *
      * @param flag  Whether this node is tinted by its parent.
      */
-    void setRelativeColor(bool flag) { _hasParentColor = flag; }
+    void setRelativeColor(bool flag) { _hasParentColor = flag; invalidateRenderCache(); }
     
     /**
      * Returns the scissor associated with this node.
@@ -1078,7 +1106,9 @@ public:
      *
      * @param scissor   The scissor associated with this node.
      */
-    void setScissor(const std::shared_ptr<Scissor>& scissor) { _scissor = scissor;}
+    void setScissor(const std::shared_ptr<Scissor>& scissor) {
+        _scissor = scissor; invalidateRenderCache();
+    }
 
     /**
      * Sets a content-bounded scissor associated with this node.
@@ -1102,7 +1132,9 @@ public:
      * of the same orientation. The rule for this intersection will
      * be the same as {@link Scissor#intersect}.
      */
-    void setScissor() { _scissor = Scissor::alloc(getContentSize());}
+    void setScissor() {
+        _scissor = Scissor::alloc(getContentSize()); invalidateRenderCache();
+    }
 
     
 #pragma mark -
@@ -1640,6 +1672,77 @@ public:
         return std::dynamic_pointer_cast<T>(getChildByName(name));
     }
 
+    /**
+     * Returns the descendant at the given path.
+     *
+     * A path is a sequence of node names separated by periods, such as
+     * "hud.panel.score".  The first name is a child of this node, the second
+     * name is a child of that node, and so on.  If any name along the path is
+     * shared by more than one sibling, this method follows the first one (as
+     * in {@link getChildByName}).  Hence names containing a period cannot be
+     * reached by this method.
+     *
+     * Resolved paths are cached, so repeated look-ups are a single hash.  The
+     * cache is invalidated whenever a child is added, removed, or renamed
+     * anywhere below this node.  This method returns nullptr if there is no
+     * descendant at the given path, or if the path has an empty name (such as
+     * "hud." or "hud..score").
+     *
+     * @param path  The period-separated path to the descendant
+     *
+     * @return the descendant at the given path.
+     */
+    std::shared_ptr<SceneNode> getChildByPath(const std::string& path) const;
+    
+    /**
+     * Returns the descendant at the given path, typecast to a shared T pointer.
+     *
+     * This method is provided to simplify the polymorphism of a scene graph.
+     * While all children are a subclass of type Node, you may want to access
+     * them by their specific subclass.  If the descendant is not an instance
+     * of type T (or a subclass), this method returns nullptr.
+     *
+     * A path is a sequence of node names separated by periods, such as
+     * "hud.panel.score".  See {@link getChildByPath} for the details.
+     *
+     * @param path  The period-separated path to the descendant
+     *
+     * @return the descendant at the given path, typecast to a shared T pointer.
+     */
+    template <typename T>
+    inline std::shared_ptr<T> getChildByPath(const std::string& path) const {
+        return std::dynamic_pointer_cast<T>(getChildByPath(path));
+    }
+    
+    /**
+     * Returns true if this node indexes its children by name and tag.
+     *
+     * By default, {@link getChildByName} and {@link getChildByTag} are a
+     * linear search of the children.  That is fine for most nodes, but it is
+     * slow for wide nodes (such as a list with hundreds of entries) that are
+     * searched every frame.  An indexed node keeps a hash table of its
+     * children instead, making these look-ups constant time.
+     *
+     * @return true if this node indexes its children by name and tag.
+     */
+    bool isChildIndexed() const { return _childIndexed; }
+    
+    /**
+     * Sets whether this node indexes its children by name and tag.
+     *
+     * By default, {@link getChildByName} and {@link getChildByTag} are a
+     * linear search of the children.  That is fine for most nodes, but it is
+     * slow for wide nodes (such as a list with hundreds of entries) that are
+     * searched every frame.  An indexed node keeps a hash table of its
+     * children instead, making these look-ups constant time.
+     *
+     * The index is maintained by all of the methods that add or remove
+     * children, and by {@link setName} and {@link setTag} on the children.
+     *
+     * @param flag  Whether this node indexes its children by name and tag.
+     */
+    void setChildIndexed(bool flag);
+
     /**
      * Returns the list of the node's children.
      *
@@ -1863,6 +1966,54 @@ public:
     virtual void removeAllChildren();
     
     
+#pragma mark -
+#pragma mark Render Caching
+    /**
+     * Returns true if this subtree is rendered to a cached texture.
+     *
+     * See {@link setRenderCached} for details.
+     *
+     * @return true if this subtree is rendered to a cached texture.
+     */
+    bool isRenderCached() const { return _cacheEnabled; }
+    
+    /**
+     * Sets whether this subtree is rendered to a cached texture.
+     *
+     * A cached subtree is rendered once to an offscreen texture, and is then
+     * drawn as a single quad.  It is only rendered again when this node or one
+     * of its descendants changes its transform, color, visibility, children,
+     * or content.  This is ideal for static but complex subtrees, such as
+     * ornate UI frames or labels with many glyphs.  It is a poor choice for
+     * subtrees that animate every frame.
+     *
+     * The cache is rendered in node space at one pixel per unit, so it should
+     * not be used for nodes that are scaled up significantly on screen. In
+     * addition, the cache is composited as a premultiplied image, so
+     * overlapping translucent children may blend slightly differently.
+     *
+     * Caches are only used for nodes in a {@link Scene2}, which owns the
+     * textures. The scene releases the least recently drawn caches when its
+     * memory limit is exceeded (see {@link Scene2#setRenderCacheLimit}).
+     *
+     * @param flag  whether this subtree is rendered to a cached texture.
+     */
+    void setRenderCached(bool flag);
+    
+    /**
+     * Marks the render cache of this node and its ancestors as out of date.
+     *
+     * This method also marks this subtree as damaged, so that a scene that
+     * tracks damage (see {@link Scene2#setDamageTracking}) redraws it.
+     *
+     * All of the built-in nodes call this method whenever their content
+     * changes.  A custom node should call this method whenever it changes
+     * something that affects {@link draw}.  It is safe to call this method
+     * if there is no cache; it is very cheap.
+     */
+    void invalidateRenderCache();
+    
+    
 #pragma mark -
 #pragma mark Rendering
     /**
@@ -1916,6 +2067,36 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) {}
     
+    /**
+     * Returns true if {@link draw} covers every pixel it touches at full alpha.
+     *
+     * This method ignores the tint, which is checked separately. A scene
+     * with an opaque pass (see {@link Scene2#setOpaquePass}) draws the
+     * opaque nodes first, front to back, so that the depth buffer can
+     * reject the pixels they hide.  A node should only return true if it
+     * draws no antialiased edges, has an opaque texture, and uses a blend
+     * function that ignores the destination at full alpha.
+     *
+     * The base node draws nothing, and so is not opaque.
+     *
+     * @return true if {@link draw} covers every pixel it touches at full alpha.
+     */
+    virtual bool isOpaque() const { return false; }
+    
+    /**
+     * Returns the region (in node space) that {@link draw} may touch.
+     *
+     * Damage tracking (see {@link Scene2#setDamageTracking}) and render
+     * caching use this region to decide what to redraw.  A node that draws
+     * outside of its content bounds, such as a path with a wide stroke,
+     * must override this method.
+     *
+     * The base node draws within its content bounds.
+     *
+     * @return the region (in node space) that {@link draw} may touch.
+     */
+    virtual Rect getDrawBounds() const { return Rect(Vec2::ZERO,getContentSize()); }
+    
     
 #pragma mark -
 #pragma mark Layout Automation
@@ -2009,6 +2190,32 @@ private:
      */
     void pushScene(Scene2* scene);
 
+    /**
+     * Adds the given child to the name and tag indices of this node.
+     *
+     * This method does nothing if this node does not index its children.
+     *
+     * @param child The child to index
+     */
+    void indexChild(SceneNode* child);
+    
+    /**
+     * Removes the given child from the name and tag indices of this node.
+     *
+     * This method does nothing if this node does not index its children.
+     *
+     * @param child The child to remove from the index
+     */
+    void unindexChild(SceneNode* child);
+    
+    /**
+     * Clears the path cache of this node and all of its ancestors.
+     *
+     * This method should be called whenever the structure of the scene graph
+     * changes below this node, as any cached path could now be stale.
+     */
+    void invalidatePathCache();
+
     /**
      * Returns true if sibling a is less than b in sorted z-order.
      *
@@ -2028,6 +2235,160 @@ private:
      * transform, and positional translation, in that order.
      */
     virtual void updateTransform();
+    
+    /**
+     * Draws this Node and all of its children, ignoring any render cache.
+     *
+     * Unlike {@link render}, the transform and tint are those of this node,
+     * and not its parent.  This method is used both by render and to redraw
+     * the render cache.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param matrix    The transform of this node.
+     * @param color     The color of this node.
+     */
+    void renderSubtree(const std::shared_ptr<SpriteBatch>& batch, const Mat4& matrix, Color4 color);
+    
+    /**
+     * Returns the bounding box of this subtree in node space.
+     *
+     * This box includes the drawn bounds of this node and every visible
+     * descendant.  If this node has a scissor, it is limited to the content
+     * bounds of this node.
+     *
+     * @return the bounding box of this subtree in node space.
+     */
+    Rect getSubtreeBounds() const;
+    
+    /**
+     * Redraws any out of date render caches in this subtree.
+     *
+     * This method is called by {@link Scene2} before it begins drawing. It
+     * only visits the nodes that have a pending cache, and so is very cheap
+     * when nothing has changed.  The sprite batch must not be drawing.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     */
+    void refreshRenderCache(const std::shared_ptr<SpriteBatch>& batch);
+    
+    /**
+     * Returns true if this node was drawn from its render cache.
+     *
+     * If the cache is out of date, or was released by the scene, this method
+     * does nothing and returns false.  The node should then be rendered
+     * normally.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param matrix    The transform of this node.
+     * @param tint      The tint of the parent of this node.
+     *
+     * @return true if this node was drawn from its render cache.
+     */
+    bool drawRenderCache(const std::shared_ptr<SpriteBatch>& batch, const Mat4& matrix, Color4 tint);
+    
+    /**
+     * Marks the render caches of this node and its ancestors as out of date.
+     *
+     * Unlike {@link invalidateRenderCache}, this method does not damage this
+     * node. It only marks the path to the root as having a damaged descendant.
+     * It is used when a child is added or removed, as the child tracks its
+     * own damage.
+     */
+    void markPending();
+    
+    /**
+     * Marks this subtree as damaged after a change to its placement.
+     *
+     * A change to the transform or z-order of a node damages the node, but
+     * not its parent.  However, it does invalidate the render cache of the
+     * parent, as that cache is in the coordinate space of the parent.
+     */
+    void invalidatePlacement();
+    
+    /**
+     * Returns the drawn bounds of a node under the given transform.
+     *
+     * A node with degenerate bounds has empty bounds, so that a grouping node
+     * does not stretch the bounds of its subtree to its origin.
+     *
+     * @param matrix    The transform of the node
+     *
+     * @return the drawn bounds of a node under the given transform.
+     */
+    Rect getContentBounds(const Mat4& matrix) const;
+    
+    /**
+     * Merges the given bounds into the accumulated bounds.
+     *
+     * Empty rectangles are ignored, rather than stretching the bounds to
+     * their origin.
+     *
+     * @param bounds    The accumulated bounds
+     * @param rect      The bounds to merge
+     */
+    static void mergeBounds(Rect& bounds, const Rect& rect);
+    
+    /**
+     * Adds the damaged regions of this subtree to the given list.
+     *
+     * A damaged subtree contributes both its bounds as of the last damaged
+     * frame and its current bounds.  This method only visits the nodes that
+     * have pending damage, and so is very cheap when nothing has changed.
+     *
+     * @param transform The transform of the parent of this node.
+     * @param damage    The list to store the damaged regions.
+     */
+    void collectDamage(const Mat4& transform, std::vector<Rect>& damage);
+    
+    /**
+     * Returns the scene bounds of this subtree, recording it for all nodes.
+     *
+     * This method clears the damage of the entire subtree.  The bounds of a
+     * hidden node are empty.
+     *
+     * @param transform The transform of the parent of this node.
+     *
+     * @return the scene bounds of this subtree.
+     */
+    Rect updateDamageBounds(const Mat4& transform);
+    
+    /**
+     * A single draw in a flattened scene graph.
+     *
+     * A scene with an opaque pass flattens its graph into a list of these
+     * items, in the order that {@link render} would draw them.
+     */
+    struct DrawItem {
+        /** The node to draw */
+        SceneNode* node;
+        /** The transform of the node (or of its parent, if a subtree) */
+        Mat4 matrix;
+        /** The color of the node (or the tint of its parent, if a subtree) */
+        Color4 color;
+        /** Whether to render the entire subtree, rather than just the node */
+        bool subtree;
+        /** Whether the node is drawn in the opaque pass */
+        bool opaque;
+        /** The blend equation left by an opaque draw */
+        GLenum blendEquation;
+        /** The source blend factor left by an opaque draw */
+        GLenum srcFactor;
+        /** The destination blend factor left by an opaque draw */
+        GLenum dstFactor;
+    };
+    
+    /**
+     * Appends the draws of this subtree to the given list.
+     *
+     * The draws are in the order that {@link render} would make them. A
+     * subtree with a render cache or a scissor is added as a single item,
+     * and is never opaque, as both have soft edges.
+     *
+     * @param transform The transform of the parent of this node.
+     * @param tint      The tint of the parent of this node.
+     * @param items     The list to store the draws.
+     */
+    void flatten(const Mat4& transform, Color4 tint, std::vector<DrawItem>& items);
 
     // Copying is only allowed via shared pointer.
     CU_DISALLOW_COPY_AND_ASSIGN(SceneNode);
@@ -81,6 +81,12 @@ namespace cugl {
  *
  * The default is traversal is CLOSED.
  *
+ * By default, a wireframe is drawn with lines, which have no width. If the
+ * stroke width is positive, the wireframe is instead drawn as a stroke that
+ * is expanded on the GPU (see {@link SpriteBatch#stroke}). This stroke uses
+ * the same joints and caps as {@link PathNode}, but it does not support
+ * gradients. A wireframe with a gradient is always drawn with lines.
+ *
  * The polygon is specified in image coordinates. Image coordinates are different
  * from texture coordinates. Their origin is at the bottom-left corner of the file,
  * and each pixel is one unit. This makes specifying to polygon more natural for
@@ -120,6 +126,15 @@ protected:
     
     /** The current (known) traversal of this wireframe */
     poly2::Traversal _traversal;
+    
+    /** The stroke width of this wireframe (0 for lines) */
+    float _stroke;
+    /** The joint between segments of the wireframe */
+    poly2::Joint  _joint;
+    /** The shape of the end caps of the wireframe */
+    poly2::EndCap _endcap;
+    /** The stroke segments, when the stroke width is positive */
+    std::vector<StrokeSegment> _segments;
 
 public:
 #pragma mark -
@@ -132,7 +147,8 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    WireNode() : TexturedNode(), _traversal(poly2::Traversal::CLOSED) {
+    WireNode() : TexturedNode(), _traversal(poly2::Traversal::CLOSED),
+    _stroke(0), _joint(poly2::Joint::NONE), _endcap(poly2::EndCap::NONE) {
         _classname = "WireNode";
         _name = "WireNode";
     }
@@ -197,6 +213,9 @@ public:
      *      "traveral": One of 'open', 'closed', or 'interior'
      *      "indices":  An array of unsigned ints defining triangles from the
      *                  the vertices. The array size should be a multiple of 3.
+     *      'stroke':   A number specifying the stroke width (0 for lines).
+     *      'joint':    One of 'mitre', 'bevel', or 'round'.
+     *      'cap':      One of 'square' or 'round'.
      *
      * All attributes are optional.  However, it is generally a good idea to
      * specify EITHER the texture or the polygon.  If you specify the indices,
@@ -320,6 +339,9 @@ public:
      *      "traveral": One of 'open', 'closed', or 'interior'
      *      "indices":  An array of unsigned ints defining triangles from the
      *                  the vertices. The array size should be a multiple of 3.
+     *      'stroke':   A number specifying the stroke width (0 for lines).
+     *      'joint':    One of 'mitre', 'bevel', or 'round'.
+     *      'cap':      One of 'square' or 'round'.
      *
      * All attributes are optional.  However, it is generally a good idea to
      * specify EITHER the texture or the polygon.  If you specify the indices,
@@ -359,6 +381,59 @@ public:
      * @return the current traversal of this path.
      */
     poly2::Traversal getTraversal() const { return _traversal; }
+    
+    /**
+     * Sets the stroke width of the wireframe.
+     *
+     * If the stroke width is 0, the wireframe is drawn with lines. Otherwise
+     * it is drawn as a stroke expanded on the GPU. As with {@link PathNode},
+     * the stroke width is the distance from the wireframe to either edge.
+     *
+     * @param stroke    The stroke width of the wireframe
+     */
+    void setStroke(float stroke);
+    
+    /**
+     * Returns the stroke width of the wireframe.
+     *
+     * If the stroke width is 0, the wireframe is drawn with lines. Otherwise
+     * it is drawn as a stroke expanded on the GPU.
+     *
+     * @return the stroke width of the wireframe.
+     */
+    float getStroke() const { return _stroke; }
+    
+    /**
+     * Sets the joint type between wireframe segments.
+     *
+     * This value has no effect if the stroke width is 0.
+     *
+     * @param joint The joint type between wireframe segments
+     */
+    void setJoint(poly2::Joint joint);
+    
+    /**
+     * Returns the joint type between wireframe segments.
+     *
+     * @return the joint type between wireframe segments.
+     */
+    poly2::Joint getJoint() const { return _joint; }
+    
+    /**
+     * Sets the cap shape at the ends of the wireframe.
+     *
+     * This value has no effect if the stroke width is 0.
+     *
+     * @param cap   The cap shape at the ends of the wireframe.
+     */
+    void setCap(poly2::EndCap cap);
+    
+    /**
+     * Returns the cap shape at the ends of the wireframe.
+     *
+     * @return the cap shape at the ends of the wireframe.
+     */
+    poly2::EndCap getCap() const { return _endcap; }
 
     /**
      * Sets the wireframe polgon to the vertices expressed in texture space.
@@ -421,8 +496,33 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) override;
     
+    /**
+     * Returns the region (in node space) that {@link draw} may touch.
+     *
+     * A wireframe with a positive stroke reaches past the content bounds.
+     *
+     * @return the region (in node space) that {@link draw} may touch.
+     */
+    virtual Rect getDrawBounds() const override;
 
 private:
+    /**
+     * Returns the transform from the stroke segments to node space.
+     *
+     * This is the same shift as generateRenderData, but on the GPU.
+     *
+     * @return the transform from the stroke segments to node space.
+     */
+    Mat4 getStrokeTransform() const;
+    
+    /**
+     * Updates the stroke segments, based on the current settings.
+     *
+     * This method does nothing if the stroke width is 0.
+     */
+    void updateStroke();
+    
+
     /** This macro disables the copy constructor (not allowed on scene graphs) */
     CU_DISALLOW_COPY_AND_ASSIGN(WireNode);
 };
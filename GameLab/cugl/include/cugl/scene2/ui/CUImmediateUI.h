@@ -0,0 +1,418 @@
+//
+//  CUImmediateUI.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a lightweight immediate-mode UI layer.  Unlike the
+//  widgets in the scene graph, these widgets are not objects.  They are
+//  declared every frame by calling a method (e.g. button), which draws the
+//  widget and returns its interaction in a single step.  The only state kept
+//  between frames is which widget is under the pointer and which is pressed,
+//  and this is keyed by a widget identifier.
+//
+//  All widgets are drawn with a UITheme, and their geometry is emitted into
+//  reusable meshes that are drawn in a single sprite batch pass at the end of
+//  the frame.  No heap objects are created for a widget.  This makes this
+//  layer ideal for debug panels, editors, and dense HUDs, where the retained
+//  overhead of a scene graph subtree per widget would dominate.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_IMMEDIATE_UI_H__
+#define __CU_IMMEDIATE_UI_H__
+
+#include <cugl/scene2/ui/CUUITheme.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/render/CUMesh.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <cugl/math/CUMat4.h>
+#include <vector>
+
+namespace cugl {
+
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+#pragma mark -
+#pragma mark ImmediateUI
+/**
+ * This class is a lightweight immediate-mode UI layer.
+ *
+ * Widgets in this layer are declared each frame, between calls to
+ * {@link begin} and {@link end}.  Each widget method emits the geometry for
+ * the widget and returns the result of any interaction (e.g. a button
+ * returns true when clicked).  There are no widget objects, no listeners,
+ * and no layout managers.  The application owns all widget values, such as
+ * the value of a slider, and passes them in every frame.
+ *
+ * Interactive widgets are identified by a string key, which is hashed with
+ * the current key scope.  Use {@link pushKey} and {@link popKey} to give
+ * widgets with the same key (such as the rows of a list) distinct keys.
+ *
+ * Hit testing is performed against the rectangles emitted in the previous
+ * frame.  The widget under the pointer is the last one emitted whose bounds
+ * contain the pointer.  Panels also take part in hit testing, so a panel
+ * blocks the widgets drawn beneath it.  As a result, a widget that first
+ * appears in a frame responds to the pointer one frame later.
+ *
+ * All coordinates (including the pointer) are in the same coordinate space,
+ * which is transformed by the matrix passed to {@link end}.  All geometry is
+ * drawn in order, except for text, which is drawn on top of all other parts.
+ */
+class ImmediateUI {
+public:
+    /** The type of a hashed widget key */
+    typedef Uint64 Key;
+
+protected:
+    /**
+     * A rectangle emitted for hit testing.
+     */
+    class Hit {
+    public:
+        /** The widget bounds */
+        Rect bounds;
+        /** The widget key (0 for a non-interactive widget) */
+        Key key;
+    };
+
+    /** The theme to draw the widgets */
+    std::shared_ptr<UITheme> _theme;
+    /** The geometry for all widget parts in the current frame */
+    Mesh<SpriteVertex2> _mesh;
+    /** The geometry for solid parts when the atlas has no blank texel */
+    Mesh<SpriteVertex2> _solid;
+    /** The geometry for all widget text in the current frame */
+    Mesh<SpriteVertex2> _text;
+    /** The rectangles emitted in the current frame (kept for the next hover test) */
+    std::vector<Hit> _hits;
+    /** The stack of key scopes */
+    std::vector<Key> _scopes;
+
+    /** The widget under the pointer (in the layout of the previous frame) */
+    Key _hover;
+    /** The widget currently pressed by the pointer */
+    Key _active;
+    /** Whether the active widget was emitted in the current frame */
+    bool _activeSeen;
+    /** Whether the pointer is over an emitted rectangle */
+    bool _capture;
+
+    /** The pointer position in the current frame */
+    Vec2 _pointer;
+    /** Whether the pointer is down in the current frame */
+    bool _down;
+    /** Whether the pointer was pressed in the current frame */
+    bool _pressed;
+    /** Whether the pointer was released in the current frame */
+    bool _released;
+    /** Whether we are between calls to begin and end */
+    bool _inframe;
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized UI layer.
+     *
+     * You must initialize this layer before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    ImmediateUI();
+
+    /**
+     * Deletes this UI layer, disposing all resources
+     */
+    ~ImmediateUI() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this UI layer.
+     *
+     * A disposed layer can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a UI layer with the given theme.
+     *
+     * If the theme font does not have an atlas, this method will build one.
+     * Widget text is only drawn with a font atlas.
+     *
+     * @param theme The theme to draw the widgets
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::shared_ptr<UITheme>& theme);
+
+    /**
+     * Returns a newly allocated UI layer with the given theme.
+     *
+     * If the theme font does not have an atlas, this method will build one.
+     * Widget text is only drawn with a font atlas.
+     *
+     * @param theme The theme to draw the widgets
+     *
+     * @return a newly allocated UI layer with the given theme.
+     */
+    static std::shared_ptr<ImmediateUI> alloc(const std::shared_ptr<UITheme>& theme) {
+        std::shared_ptr<ImmediateUI> result = std::make_shared<ImmediateUI>();
+        return (result->init(theme) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the theme to draw the widgets
+     *
+     * @return the theme to draw the widgets
+     */
+    const std::shared_ptr<UITheme>& getTheme() const { return _theme; }
+
+    /**
+     * Returns true if the pointer is over the UI.
+     *
+     * This value is determined by the rectangles emitted in the last frame.
+     * It is useful for deciding whether pointer input should pass through
+     * to the game.
+     *
+     * @return true if the pointer is over the UI.
+     */
+    bool isCapturing() const { return _capture; }
+
+    /**
+     * Returns true if any widget is currently pressed.
+     *
+     * @return true if any widget is currently pressed.
+     */
+    bool isActive() const { return _active != 0; }
+
+#pragma mark -
+#pragma mark Frame
+    /**
+     * Starts a new UI frame with the given pointer state.
+     *
+     * The pointer position should be in the same coordinate space as the
+     * widget bounds.  Presses and releases are detected by comparing the
+     * pointer state to that of the previous frame.  The widget under the
+     * pointer is found in the layout of the previous frame, so a touch that
+     * lands on a widget presses it in the same frame.
+     *
+     * @param pointer   The pointer position
+     * @param down      Whether the pointer (button or touch) is down
+     */
+    void begin(const Vec2 pointer, bool down);
+
+    /**
+     * Ends the UI frame, drawing all of the widgets to the sprite batch.
+     *
+     * The sprite batch must be active (e.g. between calls to begin and end).
+     * The widgets are drawn with at most three textures: the theme atlas
+     * (plus the blank texture if the atlas has no blank texel) and the
+     * font atlas.
+     *
+     * @param batch     The sprite batch to draw with
+     * @param transform The transform from UI coordinates to the batch
+     */
+    void end(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform = Mat4::IDENTITY);
+
+    /**
+     * Pushes a key scope onto the scope stack.
+     *
+     * All widget keys declared until the matching {@link popKey} are hashed
+     * with this scope.  This allows repeated widgets, such as the rows of a
+     * list, to reuse the same key strings.
+     *
+     * @param scope The scope name
+     */
+    void pushKey(const std::string& scope);
+
+    /**
+     * Pushes a numbered key scope onto the scope stack.
+     *
+     * All widget keys declared until the matching {@link popKey} are hashed
+     * with this scope.  This allows repeated widgets, such as the rows of a
+     * list, to reuse the same key strings.
+     *
+     * @param index The scope number
+     */
+    void pushKey(Uint64 index);
+
+    /**
+     * Pops the last key scope from the scope stack.
+     */
+    void popKey();
+
+#pragma mark -
+#pragma mark Widgets
+    /**
+     * Draws a panel with the given bounds.
+     *
+     * A panel is not interactive, but it does block the pointer from any
+     * widgets drawn beneath it.
+     *
+     * @param bounds    The panel bounds
+     */
+    void panel(const Rect bounds);
+
+    /**
+     * Draws a text label in the given bounds.
+     *
+     * The text is vertically centered and clipped to the bounds.  A label
+     * is not interactive and does not block the pointer.
+     *
+     * @param bounds    The label bounds
+     * @param text      The label text
+     * @param centered  Whether to center the text horizontally
+     */
+    void label(const Rect bounds, const std::string& text, bool centered=false);
+
+    /**
+     * Draws a button, returning true if it was clicked.
+     *
+     * A button is clicked when the pointer is pressed and released over
+     * the button.
+     *
+     * @param key       The widget key
+     * @param bounds    The button bounds
+     * @param text      The button text
+     *
+     * @return true if the button was clicked.
+     */
+    bool button(const std::string& key, const Rect bounds, const std::string& text);
+
+    /**
+     * Draws a checkbox, returning true if it changed value.
+     *
+     * The box is a square on the left of the bounds, and the text is drawn
+     * to its right.  The value is toggled when the checkbox is clicked.
+     *
+     * @param key       The widget key
+     * @param bounds    The checkbox bounds
+     * @param text      The checkbox text
+     * @param value     The checkbox value
+     *
+     * @return true if the checkbox changed value.
+     */
+    bool checkbox(const std::string& key, const Rect bounds, const std::string& text, bool& value);
+
+    /**
+     * Draws a horizontal slider, returning true if it changed value.
+     *
+     * While the slider is pressed, the value tracks the pointer.  The
+     * value is clamped to the range [min,max].
+     *
+     * @param key       The widget key
+     * @param bounds    The slider bounds
+     * @param value     The slider value
+     * @param min       The minimum slider value
+     * @param max       The maximum slider value
+     *
+     * @return true if the slider changed value.
+     */
+    bool slider(const std::string& key, const Rect bounds, float& value, float min=0, float max=1);
+
+    /**
+     * Draws a progress bar with the given progress.
+     *
+     * The progress is clamped to [0,1].  A progress bar is not interactive
+     * and does not block the pointer.
+     *
+     * @param bounds    The progress bar bounds
+     * @param progress  The progress value in [0,1]
+     */
+    void progress(const Rect bounds, float progress);
+
+#pragma mark -
+#pragma mark Internal Helpers
+protected:
+    /**
+     * Returns the hashed key for the given string in the current scope.
+     *
+     * @param key   The widget key string
+     *
+     * @return the hashed key for the given string in the current scope.
+     */
+    Key makeKey(const std::string& key) const;
+
+    /**
+     * Registers a widget for hit testing, returning true if it is hovered.
+     *
+     * If the pointer is pressed over this widget, it becomes active.
+     *
+     * @param key       The widget key (0 for a non-interactive widget)
+     * @param bounds    The widget bounds
+     *
+     * @return true if the widget is under the pointer.
+     */
+    bool interact(Key key, const Rect bounds);
+
+    /**
+     * Emits the geometry for a theme part in the given bounds.
+     *
+     * @param part      The theme part
+     * @param bounds    The bounds to draw the part
+     */
+    void addPart(UITheme::Part part, const Rect bounds);
+
+    /**
+     * Emits a single quad with the given texture coordinates and color.
+     *
+     * @param mesh  The mesh to store the quad
+     * @param dst   The quad bounds
+     * @param src   The texture coordinates (as a rectangle in [0,1])
+     * @param color The quad color
+     */
+    void addQuad(Mesh<SpriteVertex2>& mesh, const Rect dst, const Rect src, const Vec4& color);
+
+    /**
+     * Emits the geometry for the text in the given bounds.
+     *
+     * The text is vertically centered and clipped to the bounds.
+     *
+     * @param bounds    The text bounds
+     * @param text      The text to draw
+     * @param centered  Whether to center the text horizontally
+     */
+    void addText(const Rect bounds, const std::string& text, bool centered);
+};
+    }
+}
+
+#endif /* __CU_IMMEDIATE_UI_H__ */
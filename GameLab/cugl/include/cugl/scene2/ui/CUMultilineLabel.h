@@ -0,0 +1,661 @@
+//
+//  CUMultilineLabel.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node that displays a paragraph of text.
+//  The text is broken into lines that fit the width of the node, using a
+//  greedy line breaking over cached glyph advances.  Unlike a single-line
+//  Label, this node is designed for text that grows or changes over time,
+//  such as a chat log.  Edits only reflow the lines from the first changed
+//  line, and the glyph mesh of each line is kept until that line changes.
+//  Only the lines that are visible are rendered.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_MULTILINE_LABEL_H__
+#define __CU_MULTILINE_LABEL_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/render/CUFont.h>
+
+namespace cugl {
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+/**
+ * This class is a node the represents a paragraph of text.
+ *
+ * The text is broken into lines that fit inside the width of the content
+ * size (minus the padding).  Lines are broken at spaces whenever possible.
+ * A word that is too long for a line on its own is broken at the last
+ * character that fits.  Newlines in the text always start a new line.  All
+ * other unprintable characters are replaced by spaces.
+ *
+ * Lines are placed from the top of the node downwards, separated by the line
+ * skip of the font (scaled by the line spacing).  Lines that are outside
+ * of the content bounds are not drawn.  Neither are lines that are outside
+ * of the active scissor.  Hence this node may be made as tall as its text and
+ * placed inside of a scissored parent to create a scrolling text view.  The
+ * cost of drawing is then proportional to the number of visible lines, not
+ * the length of the text.
+ *
+ * This class is optimized for text that changes incrementally.  The glyph
+ * advances of the text are measured once, when the text is added.  When the
+ * text is edited with {@link appendText} or {@link replaceText}, only the
+ * lines from the first changed line onward are reflowed, stopping as soon
+ * as the line breaks match the previous layout.  The glyph mesh of each line
+ * is kept until the text of that line changes.
+ *
+ * To display the text, you need a {@link Font}.  As with {@link Label}, we
+ * highly recommend a font with an atlas.  Without an atlas, every line will
+ * allocate its own texture.
+ */
+class MultilineLabel : public SceneNode {
+#pragma mark Values
+public:
+    /**
+     * This enumeration represents the justification of lines in a {@link MultilineLabel}.
+     *
+     * Justification is the relationship of the lines to each other.  Each
+     * line is placed relative to the padded content bounds of the node.
+     */
+    enum class HAlign : int {
+        /** Each line starts at the left edge of the label */
+        LEFT = 0,
+        /** Each line is centered in the label */
+        CENTER = 1,
+        /** Each line ends at the right edge of the label */
+        RIGHT = 2
+    };
+
+protected:
+    /**
+     * This class represents a single line of text in the label.
+     *
+     * All indices are positions in the decoded text, not byte offsets.
+     */
+    class Line {
+    public:
+        /** The index of the first character of this line */
+        size_t begin;
+        /** The index after the last character displayed on this line */
+        size_t end;
+        /** The index of the first character of the next line */
+        size_t next;
+        /** The width of this line (including natural spacing) */
+        float width;
+        /** Whether this line ends in a newline */
+        bool hard;
+        /** Whether the glyph mesh has been generated */
+        bool rendered;
+        /** The glyph vertices, with the line origin at (0,0) */
+        Mesh<SpriteVertex2> mesh;
+        /** The texture for the glyph mesh */
+        std::shared_ptr<Texture> texture;
+
+        /**
+         * Creates an empty line with no glyph mesh.
+         */
+        Line() : begin(0), end(0), next(0), width(0), hard(false), rendered(false) {}
+    };
+
+    /** The font (with or without an atlas) */
+    std::shared_ptr<Font> _font;
+
+    /** The label text (sanitized UTF8) */
+    std::string _text;
+    /** The decoded characters of the text */
+    std::vector<Uint32> _codes;
+    /** The byte offset of each character in the text (plus one past the end) */
+    std::vector<size_t> _bytes;
+    /** The advance of each character */
+    std::vector<float> _advances;
+    /** The kerning of each character against the previous one */
+    std::vector<float> _kernings;
+    /** The cached glyph advances of the font */
+    std::unordered_map<Uint32, float> _glyphs;
+    /** The lines of text, in order */
+    std::vector<Line> _lines;
+
+    /** The padding offset */
+    Vec2 _padding;
+    /** The justification of the lines */
+    HAlign _halign;
+    /** The line spacing, as a multiple of the font line skip */
+    float _spacing;
+
+    /** The color of the text (default is BLACK) */
+    Color4 _foreground;
+    /** The color of the background panel (default is CLEAR) */
+    Color4 _background;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized label with no text or font information.
+     *
+     * You must initialize this label before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+     * heap, use one of the static constructors instead.
+     */
+    MultilineLabel();
+
+    /**
+     * Deletes this label, disposing all resources
+     */
+    ~MultilineLabel() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this label.
+     *
+     * A disposed label can be safely reinitialized. Any children owned by this
+     * node will be released.  They will be deleted if no other object owns them.
+     *
+     * It is unsafe to call this on a label that is still currently inside of
+     * a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Deactivates the default initializer.
+     *
+     * This initializer may not be used for a label.  A label needs a font.
+     *
+     * @return false
+     */
+    virtual bool init() override {
+        CUAssertLog(false,"This node does not support the empty initializer");
+        return false;
+    }
+
+    /**
+     * Initializes a label with the given size and font
+     *
+     * The width of the size is the width at which lines are broken.  The
+     * text is empty and may be set later with {@link setText}.
+     *
+     * @param size  The size of the label to display
+     * @param font  The font for this label
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const Size size, const std::shared_ptr<Font>& font);
+
+    /**
+     * Initializes a label with the given text, size and font
+     *
+     * The width of the size is the width at which lines are broken.  The
+     * string must be in either ASCII or UTF8 format.
+     *
+     * @param text  The text to display in the label
+     * @param size  The size of the label to display
+     * @param font  The font for this label
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithText(const std::string& text, const Size size, const std::shared_ptr<Font>& font);
+
+    /**
+     * Initializes a node with the given JSON specificaton.
+     *
+     * This initializer is designed to receive the "data" object from the
+     * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+     * of the attribute values of its parent class.  In addition, it supports
+     * the following additional attributes:
+     *
+     *      "font":         The name of a previously loaded font asset
+     *      "text":         The initial label text
+     *      "foreground":   A four-element integer array. Values should be 0..255
+     *      "background":   A four-element integer array. Values should be 0..255
+     *      "padding":      A two-element float array.
+     *      "halign":       One of 'left', 'center', and 'right'
+     *      "spacing":      A number representing the line spacing
+     *
+     * The attribute 'font' is REQUIRED.  All other attributes are optional.
+     *
+     * @param loader    The scene loader passing this JSON file
+     * @param data      The JSON object specifying the node
+     *
+     * @return true if initialization was successful.
+     */
+    virtual bool initWithData(const Scene2Loader* loader, const std::shared_ptr<JsonValue>& data) override;
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated label with the given size and font
+     *
+     * The width of the size is the width at which lines are broken.  The
+     * text is empty and may be set later with {@link setText}.
+     *
+     * @param size  The size of the label to display
+     * @param font  The font for this label
+     *
+     * @return a newly allocated label with the given size and font
+     */
+    static std::shared_ptr<MultilineLabel> alloc(const Size size, const std::shared_ptr<Font>& font) {
+        std::shared_ptr<MultilineLabel> node = std::make_shared<MultilineLabel>();
+        return (node->init(size,font) ? node : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated label with the given text, size and font
+     *
+     * The width of the size is the width at which lines are broken.  The
+     * string must be in either ASCII or UTF8 format.
+     *
+     * @param text  The text to display in the label
+     * @param size  The size of the label to display
+     * @param font  The font for this label
+     *
+     * @return a newly allocated label with the given text, size and font
+     */
+    static std::shared_ptr<MultilineLabel> alloc(const std::string& text, const Size size,
+                                                 const std::shared_ptr<Font>& font) {
+        std::shared_ptr<MultilineLabel> node = std::make_shared<MultilineLabel>();
+        return (node->initWithText(text,size,font) ? node : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given JSON specificaton.
+     *
+     * This initializer is designed to receive the "data" object from the
+     * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+     * of the attribute values of its parent class.  In addition, it supports
+     * the following additional attributes:
+     *
+     *      "font":         The name of a previously loaded font asset
+     *      "text":         The initial label text
+     *      "foreground":   A four-element integer array. Values should be 0..255
+     *      "background":   A four-element integer array. Values should be 0..255
+     *      "padding":      A two-element float array.
+     *      "halign":       One of 'left', 'center', and 'right'
+     *      "spacing":      A number representing the line spacing
+     *
+     * The attribute 'font' is REQUIRED.  All other attributes are optional.
+     *
+     * @param loader    The scene loader passing this JSON file
+     * @param data      The JSON object specifying the node
+     *
+     * @return a newly allocated node with the given JSON specificaton.
+     */
+    static std::shared_ptr<SceneNode> allocWithData(const Scene2Loader* loader,
+                                                    const std::shared_ptr<JsonValue>& data) {
+        std::shared_ptr<MultilineLabel> node = std::make_shared<MultilineLabel>();
+        return (node->initWithData(loader,data) ? node : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Text Editing
+    /**
+     * Returns the text for this label.
+     *
+     * The string will be in UTF8 format.  Any unprintable characters other
+     * than newlines will have been replaced by spaces.
+     *
+     * @return the text for this label.
+     */
+    const std::string& getText() const { return _text; }
+
+    /**
+     * Returns the number of characters in this label.
+     *
+     * This is the number of decoded characters, not the number of bytes.
+     * This is the length used by {@link replaceText}.
+     *
+     * @return the number of characters in this label.
+     */
+    size_t getLength() const { return _codes.size(); }
+
+    /**
+     * Sets the text for this label.
+     *
+     * The string must be in either ASCII or UTF8 format.  Newlines start a
+     * new line, but all other unprintable characters will be replaced by
+     * spaces.
+     *
+     * This method reflows the entire text and discards all of the line
+     * meshes.  To add to the text, use {@link appendText} instead.
+     *
+     * @param text  The text for this label.
+     */
+    void setText(const std::string& text);
+
+    /**
+     * Appends the given text to this label.
+     *
+     * The string must be in either ASCII or UTF8 format.  Newlines start a
+     * new line, but all other unprintable characters will be replaced by
+     * spaces.
+     *
+     * Only the last line (or two) of the existing text is reflowed.  Hence
+     * the cost of this method is proportional to the appended text, and not
+     * to the length of the label.
+     *
+     * @param text  The text to append.
+     */
+    void appendText(const std::string& text) {
+        replaceText(_codes.size(),0,text);
+    }
+
+    /**
+     * Replaces a range of characters in this label with the given text.
+     *
+     * The position and length are measured in decoded characters, not in
+     * bytes.  A length of 0 inserts the text, while an empty string erases
+     * the range.  The string must be in either ASCII or UTF8 format.
+     *
+     * The lines are reflowed from the first changed line, and reflow stops
+     * as soon as the line breaks match the previous layout.  Lines after
+     * the edit keep their glyph meshes.
+     *
+     * @param pos   The position of the first character to replace
+     * @param len   The number of characters to replace
+     * @param text  The replacement text
+     */
+    void replaceText(size_t pos, size_t len, const std::string& text);
+
+#pragma mark -
+#pragma mark Text Layout
+    /**
+     * Returns the number of lines of text in this label.
+     *
+     * This value includes lines that do not fit in the content size.
+     *
+     * @return the number of lines of text in this label.
+     */
+    size_t getLineCount() const { return _lines.size(); }
+
+    /**
+     * Returns the text of the given line.
+     *
+     * This text does not include any newline or the spaces at which the
+     * line was broken.
+     *
+     * @param line  The line index
+     *
+     * @return the text of the given line.
+     */
+    std::string getLine(size_t line) const;
+
+    /**
+     * Returns the height necessary to display all of the lines.
+     *
+     * This value does not include the padding.
+     *
+     * @return the height necessary to display all of the lines.
+     */
+    float getTextHeight() const;
+
+    /**
+     * Returns the padding of the rendered text.
+     *
+     * The x value is the padding on the left and right of the lines, while
+     * the y value is the padding on the top and bottom.
+     *
+     * @return the padding of the rendered text.
+     */
+    const Vec2 getPadding() const { return _padding; }
+
+    /**
+     * Sets the padding of the rendered text.
+     *
+     * The x value is the padding on the left and right of the lines, while
+     * the y value is the padding on the top and bottom.  Changing the x
+     * padding reflows the entire text.
+     *
+     * @param padding   The padding of the rendered text.
+     */
+    void setPadding(const Vec2 padding);
+
+    /**
+     * Returns the justification of the lines.
+     *
+     * @return the justification of the lines.
+     */
+    HAlign getHorizontalAlignment() const { return _halign; }
+
+    /**
+     * Sets the justification of the lines.
+     *
+     * Changing this value does not reflow the text or regenerate any
+     * line meshes.
+     *
+     * @param halign    The justification of the lines.
+     */
+    void setHorizontalAlignment(HAlign halign) {
+        _halign = halign; invalidateRenderCache();
+    }
+
+    /**
+     * Returns the line spacing, as a multiple of the font line skip.
+     *
+     * @return the line spacing, as a multiple of the font line skip.
+     */
+    float getSpacing() const { return _spacing; }
+
+    /**
+     * Sets the line spacing, as a multiple of the font line skip.
+     *
+     * Changing this value does not reflow the text or regenerate any
+     * line meshes.
+     *
+     * @param spacing   The line spacing, as a multiple of the font line skip.
+     */
+    void setSpacing(float spacing);
+
+    /**
+     * Sets the untransformed size of the node.
+     *
+     * The width of the content size is the width at which lines are broken.
+     * Hence changing the width reflows the entire text.  Changing only the
+     * height does not reflow anything.
+     *
+     * @param size  The untransformed size of the node.
+     */
+    virtual void setContentSize(const Size size) override;
+
+    /**
+     * Sets the untransformed size of the node.
+     *
+     * The width of the content size is the width at which lines are broken.
+     * Hence changing the width reflows the entire text.  Changing only the
+     * height does not reflow anything.
+     *
+     * @param width     The untransformed width of the node.
+     * @param height    The untransformed height of the node.
+     */
+    virtual void setContentSize(float width, float height) override {
+        setContentSize(Size(width, height));
+    }
+
+#pragma mark -
+#pragma mark Other Attributes
+    /**
+     * Returns the foreground color of this label.
+     *
+     * This color will be applied to the glyphs.  The default color is black.
+     *
+     * @return the foreground color of this label.
+     */
+    Color4 getForeground() const { return _foreground; }
+
+    /**
+     * Sets the foreground color of this label.
+     *
+     * This color will be applied to the glyphs.  The default color is black.
+     *
+     * @param color The foreground color of this label.
+     */
+    void setForeground(Color4 color) { _foreground = color; invalidateRenderCache(); }
+
+    /**
+     * Returns the background color of this label.
+     *
+     * If this color is not CLEAR (the default color), then the label will have
+     * a colored backing rectangle.  The rectangle will extended from the origin
+     * to the content size in Node space.
+     *
+     * @return the background color of this label.
+     */
+    Color4 getBackground() const { return _background; }
+
+    /**
+     * Sets the background color of this label.
+     *
+     * If this color is not CLEAR (the default color), then the label will have
+     * a colored backing rectangle.  The rectangle will extended from the origin
+     * to the content size in Node space.
+     *
+     * @param color The background color of this label.
+     */
+    void setBackground(Color4 color) { _background = color; invalidateRenderCache(); }
+
+    /**
+     * Returns the font to use for this label
+     *
+     * @return the font to use for this label
+     */
+    std::shared_ptr<Font> getFont() const { return _font; }
+
+    /**
+     * Sets the font to use this label
+     *
+     * Changing this value will remeasure the text and reflow all of the
+     * lines.  All of the line meshes are discarded.
+     *
+     * @param font  The font to use for this label
+     */
+    void setFont(const std::shared_ptr<Font>& font);
+
+#pragma mark -
+#pragma mark Rendering
+    /**
+     * Draws this Node via the given SpriteBatch.
+     *
+     * This method only worries about drawing the current node.  It does not
+     * attempt to render the children.
+     *
+     * Only the lines that are inside both the content bounds and the active
+     * scissor of the sprite batch are drawn.  The glyph mesh of a line is
+     * generated the first time it is drawn, and kept until it changes.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) override;
+
+#pragma mark -
+#pragma mark Internal Helpers
+protected:
+    /**
+     * Returns the advance of the given character.
+     *
+     * The advance is cached, so the font is only queried once for each
+     * character.  Characters missing from the font have an advance of 0.
+     *
+     * @param code  The Unicode character
+     *
+     * @return the advance of the given character.
+     */
+    float getAdvance(Uint32 code);
+
+    /**
+     * Measures the characters starting at the given position.
+     *
+     * This method computes the advance and kerning of each character
+     * from pos to the end of the text.  The kerning of the character at
+     * pos is recomputed, as the previous character may have changed.
+     *
+     * @param pos   The position of the first character to measure
+     * @param len   The number of characters to measure
+     */
+    void measure(size_t pos, size_t len);
+
+    /**
+     * Computes the greedy line break for the line starting at the given position.
+     *
+     * @param start The position of the first character of the line
+     * @param line  The line to store the result
+     */
+    void breakLine(size_t start, Line& line) const;
+
+    /**
+     * Reflows the lines after an edit.
+     *
+     * The edit replaced the given number of characters at pos (with respect
+     * to the old text) with the given number of characters.  Lines before
+     * the edit are kept.  Reflow stops as soon as a line break matches
+     * a line break of the old layout, and the remaining lines are kept
+     * with their glyph meshes.
+     *
+     * @param pos       The position of the edit
+     * @param removed   The number of characters removed
+     * @param added     The number of characters added
+     */
+    void reflow(size_t pos, size_t removed, size_t added);
+
+    /**
+     * Returns the width at which lines are broken.
+     *
+     * @return the width at which lines are broken.
+     */
+    float getWrapWidth() const {
+        return getContentWidth()-2*_padding.x;
+    }
+
+    /**
+     * Generates the glyph mesh for the given line.
+     *
+     * @param line  The line to render
+     */
+    void generateLine(Line& line);
+};
+
+    }
+}
+
+#endif /* __CU_MULTILINE_LABEL_H__ */
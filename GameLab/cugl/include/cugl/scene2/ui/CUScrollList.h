@@ -0,0 +1,714 @@
+//
+//  CUScrollList.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for a virtualized scroll list.  A scroll list
+//  displays a vertical list of items, each drawn by a row subtree.  However,
+//  it only instantiates the rows that are visible (plus a small margin). As
+//  the list scrolls, rows that leave the view are recycled for the items that
+//  enter it.  The data for each item is bound to its row by a callback.  This
+//  allows a list with millions of items to be built and drawn in the same
+//  time as a list with a dozen.
+//
+//  The scroll list can track its own state, scrolling (with inertia) in
+//  response to pan gestures. However, it can only do this when the list is
+//  part of a scene graph, as the scene graph maps screen coordinates to node
+//  coordinates.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_SCROLL_LIST_H__
+#define __CU_SCROLL_LIST_H__
+
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/util/CUTimestamp.h>
+#include <functional>
+#include <vector>
+#include <deque>
+
+namespace cugl {
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+/** The default number of extra rows to keep above and below the view */
+#define DEFAULT_LIST_MARGIN     2
+/** The default fraction of the scroll velocity retained after one second */
+#define DEFAULT_LIST_FRICTION   0.05f
+
+#pragma mark -
+#pragma mark ScrollList
+
+/**
+ * This class represents a virtualized, vertically scrolling list.
+ *
+ * A scroll list displays a number of items, each of which is drawn by a row.
+ * A row is an arbitrary scene graph subtree, and every row has the same
+ * height.  However, the list does not have a row for every item.  It only
+ * has rows for the items that are visible, plus a margin of extra rows above
+ * and below the view.  As the list scrolls, rows that leave the view are
+ * recycled for the items that enter it.  Hence the cost of building, drawing
+ * and scrolling the list is independent of the number of items.
+ *
+ * Rows are created by a {@link RowFactory}, and the data for an item is
+ * assigned to a row by a {@link RowBinder}.  The binder is called whenever a
+ * row is (re)assigned to an item, so it should be fast.  Rows are anchored at
+ * their top left corner, and placed so that item 0 is at the top of the list.
+ *
+ * The list clips its rows with a scissor matching its content size.  If you
+ * replace this scissor, the rows may draw outside of the list.
+ *
+ * The list can track its own state, via the {@link activate()} method,
+ * relieving you of having to manually scroll it.  When active, it responds
+ * to {@link PanInput} gestures that start inside the list.  The list keeps
+ * scrolling with inertia after the gesture ends, but this motion is only
+ * applied by the {@link update} method.  You must call this method every
+ * animation frame for inertia to work.
+ */
+class ScrollList : public SceneNode {
+public:
+#pragma mark Callbacks
+    /**
+     * @typedef RowFactory
+     *
+     * This type represents a function to create a new row for a {@link ScrollList}.
+     *
+     * The row may be any scene graph subtree.  The list will change the anchor
+     * and position of the row, but it will not modify anything else.  The row
+     * does not need to hold any data, as that is assigned by {@link RowBinder}.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<std::shared_ptr<SceneNode>()>
+     */
+    typedef std::function<std::shared_ptr<SceneNode>()> RowFactory;
+
+    /**
+     * @typedef RowBinder
+     *
+     * This type represents a function to assign an item to a row.
+     *
+     * This function is called whenever a row is assigned to a new item, or
+     * when the items are invalidated.  The row is one created by the
+     * {@link RowFactory} of the list, and may have previously displayed
+     * another item.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<void(const std::shared_ptr<SceneNode>& row, size_t index)>
+     *
+     * @param row   The row to display the item
+     * @param index The item index
+     */
+    typedef std::function<void(const std::shared_ptr<SceneNode>& row, size_t index)> RowBinder;
+
+protected:
+#pragma mark -
+#pragma mark Values
+    /** The number of items in this list */
+    size_t _count;
+    /** The height of each row */
+    float _rowHeight;
+    /** The number of extra rows to keep above and below the view */
+    Uint32 _margin;
+    /** The distance from the top of the list to the top of the view */
+    double _offset;
+
+    /** The function to create a new row */
+    RowFactory _factory;
+    /** The function to assign an item to a row */
+    RowBinder _binder;
+
+    /** The rows assigned to items, in item order */
+    std::deque<std::shared_ptr<SceneNode>> _rows;
+    /** The index of the item assigned to the first row */
+    size_t _first;
+    /** The unassigned rows, available for reuse */
+    std::vector<std::shared_ptr<SceneNode>> _spares;
+
+    /** The current scroll velocity (in points per second) */
+    double _velocity;
+    /** The fraction of the scroll velocity retained after one second */
+    float _friction;
+    /** Whether the list is actively checking input */
+    bool _active;
+    /** Whether a pan gesture is currently scrolling the list */
+    bool _dragging;
+    /** The time of the last pan motion */
+    Timestamp _lastpan;
+    /** The listener key when the list is checking for events */
+    Uint32 _inputkey;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized scroll list. You must initialize it before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+     * heap, use one of the static constructors instead.
+     */
+    ScrollList();
+
+    /**
+     * Deletes this scroll list, disposing all resources
+     *
+     * It is unsafe to call this on a scroll list that is still currently
+     * inside of a scene graph.
+     */
+    ~ScrollList() { dispose(); }
+
+    /**
+     * Disposes all of the resources used.
+     *
+     * A disposed scroll list can be safely reinitialized. All rows will be
+     * released. They will be deleted if no other object owns them.
+     *
+     * It is unsafe to call this on a scroll list that is still currently
+     * inside of a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Deactivates the default initializer.
+     *
+     * This initializer may not be used for a scroll list. A scroll list
+     * needs a size and a row height.
+     *
+     * @return false
+     */
+    virtual bool init() override {
+        CUAssertLog(false,"This node does not support the empty initializer");
+        return false;
+    }
+
+    /**
+     * Initializes a scroll list with the given size and row height.
+     *
+     * The list will have no items, and no row factory or binder.  You must
+     * set these before the list will display anything.
+     *
+     * @param size      The size of the visible region of the list
+     * @param height    The height of each row
+     *
+     * @return true if the scroll list is initialized properly, false otherwise.
+     */
+    bool init(const Size size, float height);
+
+    /**
+     * Initializes a scroll list with the given size, rows and items.
+     *
+     * The list will immediately create (and bind) the rows needed to fill
+     * the visible region.
+     *
+     * @param size      The size of the visible region of the list
+     * @param height    The height of each row
+     * @param count     The number of items in the list
+     * @param factory   The function to create a new row
+     * @param binder    The function to assign an item to a row
+     *
+     * @return true if the scroll list is initialized properly, false otherwise.
+     */
+    bool init(const Size size, float height, size_t count,
+              RowFactory factory, RowBinder binder);
+
+    /**
+     * Initializes a node with the given JSON specificaton.
+     *
+     * This initializer is designed to receive the "data" object from the
+     * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+     * of the attribute values of its parent class.  In addition, it supports
+     * the following additional attributes:
+     *
+     *      "row_height":   A number greater than 0, representing the row height
+     *      "count":        An integer representing the number of items
+     *      "margin":       An integer representing the extra rows on each side
+     *      "friction":     A number between 0 and 1 for the inertia decay
+     *      "row":          A JSON object defining the row prefab
+     *
+     * The attribute 'row_height' is REQUIRED.  All other attributes are
+     * optional. The row prefab is instantiated by the loader when the list
+     * is built, enough to fill the visible region.  These rows are recycled
+     * as the list scrolls. If the list is made larger afterwards, you must
+     * set a {@link RowFactory} to create the additional rows.  The items are
+     * not bound to rows until you set a {@link RowBinder}.
+     *
+     * @param loader    The scene loader passing this JSON file
+     * @param data      The JSON object specifying the node
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithData(const Scene2Loader* loader, const std::shared_ptr<JsonValue>& data) override;
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated scroll list with the given size and row height.
+     *
+     * The list will have no items, and no row factory or binder.  You must
+     * set these before the list will display anything.
+     *
+     * @param size      The size of the visible region of the list
+     * @param height    The height of each row
+     *
+     * @return a newly allocated scroll list with the given size and row height.
+     */
+    static std::shared_ptr<ScrollList> alloc(const Size size, float height) {
+        std::shared_ptr<ScrollList> node = std::make_shared<ScrollList>();
+        return (node->init(size,height) ? node : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated scroll list with the given size, rows and items.
+     *
+     * The list will immediately create (and bind) the rows needed to fill
+     * the visible region.
+     *
+     * @param size      The size of the visible region of the list
+     * @param height    The height of each row
+     * @param count     The number of items in the list
+     * @param factory   The function to create a new row
+     * @param binder    The function to assign an item to a row
+     *
+     * @return a newly allocated scroll list with the given size, rows and items.
+     */
+    static std::shared_ptr<ScrollList> alloc(const Size size, float height, size_t count,
+                                             RowFactory factory, RowBinder binder) {
+        std::shared_ptr<ScrollList> node = std::make_shared<ScrollList>();
+        return (node->init(size,height,count,factory,binder) ? node : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated node with the given JSON specificaton.
+     *
+     * This initializer is designed to receive the "data" object from the
+     * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+     * of the attribute values of its parent class.  In addition, it supports
+     * the following additional attributes:
+     *
+     *      "row_height":   A number greater than 0, representing the row height
+     *      "count":        An integer representing the number of items
+     *      "margin":       An integer representing the extra rows on each side
+     *      "friction":     A number between 0 and 1 for the inertia decay
+     *      "row":          A JSON object defining the row prefab
+     *
+     * The attribute 'row_height' is REQUIRED.  All other attributes are
+     * optional. The row prefab is instantiated by the loader when the list
+     * is built, enough to fill the visible region.  These rows are recycled
+     * as the list scrolls. If the list is made larger afterwards, you must
+     * set a {@link RowFactory} to create the additional rows.  The items are
+     * not bound to rows until you set a {@link RowBinder}.
+     *
+     * @param loader    The scene loader passing this JSON file
+     * @param data      The JSON object specifying the node
+     *
+     * @return a newly allocated node with the given JSON specificaton.
+     */
+    static std::shared_ptr<SceneNode> allocWithData(const Scene2Loader* loader,
+                                                    const std::shared_ptr<JsonValue>& data) {
+        std::shared_ptr<ScrollList> node = std::make_shared<ScrollList>();
+        return (node->initWithData(loader,data) ? node : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Items
+    /**
+     * Returns the number of items in this list.
+     *
+     * @return the number of items in this list.
+     */
+    size_t getItemCount() const { return _count; }
+
+    /**
+     * Sets the number of items in this list.
+     *
+     * This method is constant time, regardless of the number of items. The
+     * scroll offset is clamped to the new list length, and all of the rows
+     * are rebound to their items.
+     *
+     * @param count The number of items in this list.
+     */
+    void setItemCount(size_t count);
+
+    /**
+     * Reassigns all of the visible items to their rows.
+     *
+     * This method should be called whenever the item data changes.  It calls
+     * the {@link RowBinder} on every row currently assigned to an item.
+     */
+    void invalidateItems();
+
+    /**
+     * Returns the row currently assigned to the given item.
+     *
+     * This method returns nullptr if the item is not visible (or in the
+     * margin about the view).
+     *
+     * @param index The item index
+     *
+     * @return the row currently assigned to the given item.
+     */
+    std::shared_ptr<SceneNode> getRow(size_t index) const;
+
+    /**
+     * Returns the index of the first item with an assigned row.
+     *
+     * Together with {@link getRowCount}, this defines the range of items
+     * currently assigned to rows.
+     *
+     * @return the index of the first item with an assigned row.
+     */
+    size_t getFirstRow() const { return _first; }
+
+    /**
+     * Returns the number of rows currently assigned to items.
+     *
+     * This value is independent of the number of items.  It only depends
+     * on the size of the list, the row height and the margin.
+     *
+     * @return the number of rows currently assigned to items.
+     */
+    size_t getRowCount() const { return _rows.size(); }
+
+#pragma mark -
+#pragma mark Rows
+    /**
+     * Returns the height of each row.
+     *
+     * @return the height of each row.
+     */
+    float getRowHeight() const { return _rowHeight; }
+
+    /**
+     * Sets the height of each row.
+     *
+     * All rows are repositioned, and the scroll offset is clamped to the new
+     * list length.  The rows themselves are not resized.
+     *
+     * @param height    The height of each row.
+     */
+    void setRowHeight(float height);
+
+    /**
+     * Returns the number of extra rows to keep above and below the view.
+     *
+     * These rows are assigned to items even though they are not visible.
+     * This prevents popping at the edge of the list, and hides the cost of
+     * binding rows when scrolling slowly.
+     *
+     * @return the number of extra rows to keep above and below the view.
+     */
+    Uint32 getMargin() const { return _margin; }
+
+    /**
+     * Sets the number of extra rows to keep above and below the view.
+     *
+     * These rows are assigned to items even though they are not visible.
+     * This prevents popping at the edge of the list, and hides the cost of
+     * binding rows when scrolling slowly.
+     *
+     * @param margin    The number of extra rows to keep above and below the view.
+     */
+    void setMargin(Uint32 margin);
+
+    /**
+     * Returns the function to create a new row.
+     *
+     * @return the function to create a new row.
+     */
+    const RowFactory& getRowFactory() const { return _factory; }
+
+    /**
+     * Sets the function to create a new row.
+     *
+     * Existing rows are kept, and are still recycled. The factory is only
+     * used when the list needs more rows than it has.  To replace the
+     * existing rows, call {@link clearRows} after setting the factory.
+     *
+     * @param factory   The function to create a new row.
+     */
+    void setRowFactory(RowFactory factory);
+
+    /**
+     * Returns the function to assign an item to a row.
+     *
+     * @return the function to assign an item to a row.
+     */
+    const RowBinder& getRowBinder() const { return _binder; }
+
+    /**
+     * Sets the function to assign an item to a row.
+     *
+     * All of the rows are immediately rebound with the new function.
+     *
+     * @param binder    The function to assign an item to a row.
+     */
+    void setRowBinder(RowBinder binder);
+
+    /**
+     * Releases all of the rows of this list, creating new ones.
+     *
+     * The new rows are created with the current {@link RowFactory}. If there
+     * is no factory, the list will be empty.
+     */
+    void clearRows();
+
+    /**
+     * Sets the untransformed size of the node.
+     *
+     * The content size is the size of the visible region of the list.  The
+     * scissor is resized to match, and rows are added or released to fill
+     * the new region.
+     *
+     * @param size  The untransformed size of the node.
+     */
+    virtual void setContentSize(const Size size) override;
+
+    /**
+     * Sets the untransformed size of the node.
+     *
+     * The content size is the size of the visible region of the list.  The
+     * scissor is resized to match, and rows are added or released to fill
+     * the new region.
+     *
+     * @param width     The untransformed width of the node.
+     * @param height    The untransformed height of the node.
+     */
+    virtual void setContentSize(float width, float height) override {
+        setContentSize(Size(width, height));
+    }
+
+#pragma mark -
+#pragma mark Scrolling
+    /**
+     * Returns the distance from the top of the list to the top of the view.
+     *
+     * This value is a double, as a list with millions of items can be longer
+     * than a float can position to the nearest point.
+     *
+     * @return the distance from the top of the list to the top of the view.
+     */
+    double getScrollOffset() const { return _offset; }
+
+    /**
+     * Sets the distance from the top of the list to the top of the view.
+     *
+     * The value is clamped to the range [0,{@link getMaxScrollOffset}].
+     * This method does not affect the scroll velocity.
+     *
+     * @param offset    The distance from the top of the list to the top of the view.
+     */
+    void setScrollOffset(double offset);
+
+    /**
+     * Returns the largest possible scroll offset.
+     *
+     * This is the offset at which the last item is at the bottom of the view.
+     * It is 0 if all of the items fit in the view.
+     *
+     * @return the largest possible scroll offset.
+     */
+    double getMaxScrollOffset() const;
+
+    /**
+     * Scrolls the list by the given amount.
+     *
+     * A positive amount moves the view down the list (so the rows move up).
+     * The resulting offset is clamped to the length of the list.
+     *
+     * @param amount    The distance to scroll
+     */
+    void scrollBy(double amount) { setScrollOffset(_offset+amount); }
+
+    /**
+     * Scrolls the list so that the given item is at the top of the view.
+     *
+     * The resulting offset is clamped to the length of the list, so the item
+     * may not be at the top if it is near the end of the list.  This method
+     * stops any inertial scrolling.
+     *
+     * @param index The item index
+     */
+    void scrollToItem(size_t index);
+
+    /**
+     * Returns the current scroll velocity in points per second.
+     *
+     * A positive velocity moves the view down the list.
+     *
+     * @return the current scroll velocity in points per second.
+     */
+    double getVelocity() const { return _velocity; }
+
+    /**
+     * Sets the current scroll velocity in points per second.
+     *
+     * A positive velocity moves the view down the list.  The velocity is
+     * applied (and decays) in {@link update}.
+     *
+     * @param velocity  The current scroll velocity in points per second.
+     */
+    void setVelocity(double velocity) { _velocity = velocity; }
+
+    /**
+     * Returns the fraction of the scroll velocity retained after one second.
+     *
+     * This value determines how quickly the list comes to rest after a pan
+     * gesture. A value of 0 means the list stops immediately, while a value
+     * of 1 means the list never stops.
+     *
+     * @return the fraction of the scroll velocity retained after one second.
+     */
+    float getFriction() const { return _friction; }
+
+    /**
+     * Sets the fraction of the scroll velocity retained after one second.
+     *
+     * This value determines how quickly the list comes to rest after a pan
+     * gesture. A value of 0 means the list stops immediately, while a value
+     * of 1 means the list never stops.
+     *
+     * @param friction  The fraction of the scroll velocity retained after one second.
+     */
+    void setFriction(float friction);
+
+    /**
+     * Applies the inertial scrolling of this list.
+     *
+     * This method should be called every animation frame.  It has no effect
+     * while a pan gesture is scrolling the list, or if the list is at rest.
+     *
+     * @param timestep  The time elapsed since the last frame (in seconds)
+     */
+    void update(float timestep);
+
+#pragma mark -
+#pragma mark Listeners
+    /**
+     * Activates this scroll list to respond to pan gestures.
+     *
+     * The list will scroll in response to any pan that starts inside of it.
+     * If the pan input is a touch screen, the list follows the fingers
+     * exactly.  Otherwise (such as a trackpad), a pan across the whole
+     * device scrolls the list by its height.
+     *
+     * The {@link PanInput} device must be active before this method is called.
+     *
+     * @return true if the scroll list was successfully activated
+     */
+    bool activate();
+
+    /**
+     * Deactivates this scroll list, ignoring pan gestures from then on.
+     *
+     * The list can still be scrolled with {@link setScrollOffset}, and any
+     * inertial scrolling will continue in {@link update}.
+     *
+     * @return true if the scroll list was successfully deactivated
+     */
+    bool deactivate();
+
+    /**
+     * Returns true if this scroll list has been activated.
+     *
+     * @return true if this scroll list has been activated.
+     */
+    bool isActive() const { return _active; }
+
+#pragma mark -
+#pragma mark Internal Helpers
+protected:
+    /**
+     * Reassigns the rows to the items in (or near) the view.
+     *
+     * Rows that are still assigned to the same items are left alone, unless
+     * rebind is true.  Rows that are no longer needed are made invisible and
+     * kept as spares.
+     *
+     * @param rebind    Whether to rebind all of the rows to their items
+     */
+    void refreshRows(bool rebind);
+
+    /**
+     * Returns a row assigned to the given item.
+     *
+     * The row is a spare, if one is available.  Otherwise it is created
+     * with the {@link RowFactory} and added as a child of this list.  This
+     * method returns nullptr if there are no spares and no factory.
+     *
+     * @param index The item index
+     *
+     * @return a row assigned to the given item.
+     */
+    std::shared_ptr<SceneNode> acquireRow(size_t index);
+
+    /**
+     * Releases the given row, making it a spare.
+     *
+     * The row is made invisible, but remains a child of this list.
+     *
+     * @param row   The row to release
+     */
+    void releaseRow(const std::shared_ptr<SceneNode>& row);
+
+    /**
+     * Adds the given row to this list as a spare.
+     *
+     * @param row   The row to add
+     */
+    void addRow(const std::shared_ptr<SceneNode>& row);
+
+    /**
+     * Positions the assigned rows according to the scroll offset.
+     */
+    void positionRows();
+
+    /**
+     * Scrolls the list by the given pan delta, tracking the pan velocity.
+     *
+     * @param delta The scroll distance in node coordinates
+     * @param stamp The time of the pan motion
+     */
+    void dragList(float delta, const Timestamp& stamp);
+};
+
+    }
+}
+
+#endif /* __CU_SCROLL_LIST_H__ */
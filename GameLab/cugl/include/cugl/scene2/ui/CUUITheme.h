@@ -0,0 +1,417 @@
+//
+//  CUUITheme.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the visual theme for the immediate-mode UI layer.
+//  A theme maps each widget part (button, slider knob, panel, and so on) to a
+//  region of a single texture atlas, together with a nine-patch interior and
+//  a color.  Because every part comes from the same texture, an entire UI
+//  frame can be drawn in a single sprite batch pass.
+//
+//  A theme does not need a texture.  If there is no atlas, every part is
+//  drawn as a solid rectangle of its color.  This is useful for debug panels.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_UI_THEME_H__
+#define __CU_UI_THEME_H__
+
+#include <cugl/math/CURect.h>
+#include <cugl/math/CUColor4.h>
+#include <cugl/render/CUTexture.h>
+#include <cugl/render/CUFont.h>
+#include <cugl/assets/CUJsonValue.h>
+#include <memory>
+#include <string>
+
+namespace cugl {
+
+/** Forward reference to the asset manager */
+class AssetManager;
+
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+#pragma mark -
+#pragma mark UITheme
+/**
+ * This class is the visual theme for an {@link ImmediateUI}.
+ *
+ * A theme assigns each widget {@link Part} a region of a single texture
+ * atlas. The region may have a nine-patch interior, specified exactly as in
+ * {@link NinePatch}: the corners outside of the interior are drawn unscaled,
+ * while the interior is stretched to fit the widget.  Each part also has a
+ * color, which tints the region.
+ *
+ * If the theme has no atlas, or a part has no region, that part is drawn as
+ * a solid rectangle in its color.  Therefore, a theme with only a font is
+ * enough for debug panels.  If a theme has an atlas, it should also specify
+ * a {@link setBlank} pixel of solid white.  Otherwise solid parts cannot share
+ * the atlas, and they are drawn in a separate pass beneath the atlas parts.
+ *
+ * Region coordinates are in pixels, and (as with {@link PolygonNode}) we
+ * assume that the pixel origin is the bottom-left corner of the atlas.
+ */
+class UITheme {
+public:
+    /**
+     * An enumeration of the widget parts that a theme can draw.
+     */
+    enum class Part : int {
+        /** The background of a panel */
+        PANEL = 0,
+        /** A button in its normal state */
+        BUTTON,
+        /** A button under the pointer */
+        BUTTON_HOVER,
+        /** A button that is pressed */
+        BUTTON_DOWN,
+        /** The box of a checkbox */
+        CHECKBOX,
+        /** The mark of a checked checkbox */
+        CHECKMARK,
+        /** The track of a slider */
+        SLIDER_TRACK,
+        /** The knob of a slider */
+        SLIDER_KNOB,
+        /** The background of a progress bar */
+        PROGRESS_BACK,
+        /** The filled portion of a progress bar */
+        PROGRESS_FILL,
+        /** The number of parts (not a valid part) */
+        COUNT
+    };
+
+    /**
+     * The atlas region for a single widget part.
+     */
+    class Region {
+    public:
+        /** The region bounds in the atlas, in pixels */
+        Rect bounds;
+        /** The nine-patch interior, relative to the region origin */
+        Rect interior;
+        /** The color to tint this region */
+        Color4 color;
+        /** Whether this part uses the atlas (otherwise it is a solid color) */
+        bool textured;
+
+        /**
+         * Creates an untextured white region.
+         */
+        Region() : color(Color4::WHITE), textured(false) {}
+    };
+
+protected:
+    /** The texture atlas for all of the parts */
+    std::shared_ptr<Texture> _texture;
+    /** The font for all widget text */
+    std::shared_ptr<Font> _font;
+    /** The regions of each part */
+    Region _regions[(int)Part::COUNT];
+    /** The pixel position of a solid white texel in the atlas */
+    Vec2 _blank;
+    /** Whether the atlas has a solid white texel */
+    bool _hasBlank;
+    /** The color of widget text */
+    Color4 _textColor;
+    /** The padding between a widget edge and its text */
+    float _padding;
+    /** Whether this theme has been initialized */
+    bool _initialized;
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized theme.
+     *
+     * You must initialize this theme before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    UITheme();
+
+    /**
+     * Deletes this theme, disposing all resources
+     */
+    ~UITheme() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this theme.
+     *
+     * A disposed theme can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes an untextured theme with the given font.
+     *
+     * Every part will be drawn as a solid rectangle with a default color.
+     * These colors can be changed with {@link setRegion}.
+     *
+     * @param font      The font for all widget text
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::shared_ptr<Font>& font) {
+        return init(nullptr,font);
+    }
+
+    /**
+     * Initializes a theme with the given atlas and font.
+     *
+     * Until a region is assigned to a part, that part will be drawn as a
+     * solid rectangle with a default color.  The atlas may be nullptr.
+     *
+     * @param texture   The texture atlas for all of the parts
+     * @param font      The font for all widget text
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::shared_ptr<Texture>& texture, const std::shared_ptr<Font>& font);
+
+    /**
+     * Initializes a theme with the given JSON specificaton.
+     *
+     * This JSON format supports the following attributes:
+     *
+     *      "texture":  The name of a previously loaded texture asset
+     *      "font":     The name of a previously loaded font asset
+     *      "color":    A four-element integer array for the text color
+     *      "blank":    A two-element number array for a solid white pixel
+     *      "padding":  A number for the padding between widget edges and text
+     *      "parts":    An object mapping part names to regions
+     *
+     * Each region is an object with the following attributes:
+     *
+     *      "bounds":   A four-element number array (x,y,width,height)
+     *      "interior": A four-element number array (x,y,width,height)
+     *      "color":    A four-element integer array. Values should be 0..255
+     *
+     * The part names are the lower case names of {@link Part}, such as
+     * "button_hover" or "slider_knob".  The attribute 'font' is REQUIRED.
+     * All other attributes are optional.
+     *
+     * @param assets    The asset manager with the texture and font
+     * @param data      The JSON object specifying the theme
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithData(const AssetManager* assets, const std::shared_ptr<JsonValue>& data);
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated untextured theme with the given font.
+     *
+     * Every part will be drawn as a solid rectangle with a default color.
+     * These colors can be changed with {@link setRegion}.
+     *
+     * @param font      The font for all widget text
+     *
+     * @return a newly allocated untextured theme with the given font.
+     */
+    static std::shared_ptr<UITheme> alloc(const std::shared_ptr<Font>& font) {
+        std::shared_ptr<UITheme> result = std::make_shared<UITheme>();
+        return (result->init(font) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated theme with the given atlas and font.
+     *
+     * Until a region is assigned to a part, that part will be drawn as a
+     * solid rectangle with a default color.  The atlas may be nullptr.
+     *
+     * @param texture   The texture atlas for all of the parts
+     * @param font      The font for all widget text
+     *
+     * @return a newly allocated theme with the given atlas and font.
+     */
+    static std::shared_ptr<UITheme> alloc(const std::shared_ptr<Texture>& texture,
+                                          const std::shared_ptr<Font>& font) {
+        std::shared_ptr<UITheme> result = std::make_shared<UITheme>();
+        return (result->init(texture,font) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated theme with the given JSON specificaton.
+     *
+     * This JSON format supports the following attributes:
+     *
+     *      "texture":  The name of a previously loaded texture asset
+     *      "font":     The name of a previously loaded font asset
+     *      "color":    A four-element integer array for the text color
+     *      "blank":    A two-element number array for a solid white pixel
+     *      "padding":  A number for the padding between widget edges and text
+     *      "parts":    An object mapping part names to regions
+     *
+     * Each region is an object with the following attributes:
+     *
+     *      "bounds":   A four-element number array (x,y,width,height)
+     *      "interior": A four-element number array (x,y,width,height)
+     *      "color":    A four-element integer array. Values should be 0..255
+     *
+     * The part names are the lower case names of {@link Part}, such as
+     * "button_hover" or "slider_knob".  The attribute 'font' is REQUIRED.
+     * All other attributes are optional.
+     *
+     * @param assets    The asset manager with the texture and font
+     * @param data      The JSON object specifying the theme
+     *
+     * @return a newly allocated theme with the given JSON specificaton.
+     */
+    static std::shared_ptr<UITheme> allocWithData(const AssetManager* assets,
+                                                  const std::shared_ptr<JsonValue>& data) {
+        std::shared_ptr<UITheme> result = std::make_shared<UITheme>();
+        return (result->initWithData(assets,data) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the texture atlas for all of the parts.
+     *
+     * If this value is nullptr, all parts are drawn as solid rectangles.
+     *
+     * @return the texture atlas for all of the parts.
+     */
+    const std::shared_ptr<Texture>& getTexture() const { return _texture; }
+
+    /**
+     * Returns the font for all widget text.
+     *
+     * @return the font for all widget text.
+     */
+    const std::shared_ptr<Font>& getFont() const { return _font; }
+
+    /**
+     * Returns the region for the given part.
+     *
+     * @param part  The widget part
+     *
+     * @return the region for the given part.
+     */
+    const Region& getRegion(Part part) const { return _regions[(int)part]; }
+
+    /**
+     * Sets the atlas region for the given part.
+     *
+     * The interior is specified relative to the origin of the bounds, exactly
+     * as in {@link NinePatch}.  If the interior is empty, the region is
+     * stretched to fit the widget.
+     *
+     * @param part      The widget part
+     * @param bounds    The region bounds in the atlas, in pixels
+     * @param interior  The nine-patch interior, relative to the region origin
+     * @param color     The color to tint this region
+     */
+    void setRegion(Part part, const Rect bounds, const Rect interior, Color4 color = Color4::WHITE);
+
+    /**
+     * Sets the given part to be a solid rectangle of the given color.
+     *
+     * @param part      The widget part
+     * @param color     The color of the part
+     */
+    void setRegion(Part part, Color4 color);
+
+    /**
+     * Returns true if the atlas has a solid white texel.
+     *
+     * If this is false, solid parts cannot be drawn with the atlas.
+     *
+     * @return true if the atlas has a solid white texel.
+     */
+    bool hasBlank() const { return _hasBlank; }
+
+    /**
+     * Returns the pixel position of a solid white texel in the atlas.
+     *
+     * This value is only meaningful if {@link hasBlank} is true.
+     *
+     * @return the pixel position of a solid white texel in the atlas.
+     */
+    const Vec2& getBlank() const { return _blank; }
+
+    /**
+     * Sets the pixel position of a solid white texel in the atlas.
+     *
+     * This texel allows solid parts to be drawn with the same texture as
+     * the textured ones, so that a frame is drawn in a single pass.  The
+     * position should be the center of the pixel (e.g. (0.5,0.5)) to avoid
+     * sampling its neighbors.
+     *
+     * @param pixel The pixel position of a solid white texel in the atlas.
+     */
+    void setBlank(const Vec2 pixel);
+
+    /**
+     * Returns the color of widget text.
+     *
+     * @return the color of widget text.
+     */
+    Color4 getTextColor() const { return _textColor; }
+
+    /**
+     * Sets the color of widget text.
+     *
+     * @param color The color of widget text.
+     */
+    void setTextColor(Color4 color) { _textColor = color; }
+
+    /**
+     * Returns the padding between a widget edge and its text.
+     *
+     * @return the padding between a widget edge and its text.
+     */
+    float getPadding() const { return _padding; }
+
+    /**
+     * Sets the padding between a widget edge and its text.
+     *
+     * @param padding   The padding between a widget edge and its text.
+     */
+    void setPadding(float padding) { _padding = padding; }
+};
+    }
+}
+
+#endif /* __CU_UI_THEME_H__ */
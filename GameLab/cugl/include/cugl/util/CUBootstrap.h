@@ -0,0 +1,363 @@
+//
+//  CUBootstrap.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a dependency graph for application start-up.  Most
+//  of the work done in Application#onStartup (opening the audio device,
+//  compiling shaders, attaching asset loaders, parsing JSON) is independent.
+//  Rather than doing it all serially, you register each piece as a named task
+//  with its dependencies, and this class runs independent tasks concurrently.
+//  Tasks that need the OpenGL context are run on the main thread, while the
+//  rest are farmed out to a small thread pool.
+//
+//  Tasks may also be lazy.  A lazy task is not run at start-up; instead it is
+//  run on the first call to require().  This is for subsystems that are
+//  rarely used, and should not delay the first animation frame.
+//
+//  Every task is timed, and the resulting timeline can be logged or exported
+//  in the Chrome trace event format for profiling.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/4/21
+//
+#ifndef __CU_BOOTSTRAP_H__
+#define __CU_BOOTSTRAP_H__
+#include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUTimestamp.h>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace cugl {
+
+/** Forward reference to the JSON tree */
+class JsonValue;
+
+/**
+ * This class is a dependency graph of start-up tasks.
+ *
+ * Each task has a unique name, and a (possibly empty) list of the tasks that
+ * must complete before it can start.  When the graph is run, every task whose
+ * dependencies are satisfied is started immediately.  Worker tasks run in a
+ * thread pool, while main tasks run on the thread that called {@link run}.
+ * Anything that touches OpenGL (shaders, textures, fonts that upload to an
+ * atlas) must be a main task.
+ *
+ * A task may also be lazy. Lazy tasks are skipped by {@link run}, and are only
+ * executed the first time that {@link require} is called with their name (or
+ * the name of a lazy task that depends on them).  A lazy task executes on the
+ * thread calling require, which must be the main thread if it uses OpenGL.
+ * Startup tasks may not depend on lazy ones.
+ *
+ * Every task records when it started and finished, relative to the call to
+ * {@link run}. This timeline can be logged or exported for profiling.
+ */
+class Bootstrap {
+private:
+    /**
+     * The execution state of a task
+     */
+    enum class State {
+        /** The task is waiting on its dependencies */
+        PENDING,
+        /** The task is currently running */
+        RUNNING,
+        /** The task has completed */
+        COMPLETE
+    };
+
+    /**
+     * A single node in the dependency graph
+     */
+    class Task {
+    public:
+        /** The task name */
+        std::string name;
+        /** The task body */
+        std::function<void()> work;
+        /** The names of the tasks this task depends on */
+        std::vector<std::string> depends;
+        /** The tasks that depend on this task (computed by run) */
+        std::vector<size_t> dependents;
+        /** The number of dependencies not yet complete */
+        size_t waiting;
+        /** Whether this task runs in the thread pool */
+        bool worker;
+        /** Whether this task is deferred until required */
+        bool lazy;
+        /** The current execution state */
+        State state;
+        /** The start time in microseconds, relative to the launch */
+        Uint64 begin;
+        /** The finish time in microseconds, relative to the launch */
+        Uint64 end;
+        /** The thread that executed this task */
+        Uint64 thread;
+    };
+
+    /** The tasks in registration order (a deque, so lazy additions never move them) */
+    std::deque<Task> _tasks;
+    /** The index of each task by name */
+    std::unordered_map<std::string, size_t> _index;
+    /** The number of threads to use for worker tasks */
+    Uint32 _threads;
+    /** The thread pool for worker tasks (only alive during run) */
+    std::shared_ptr<ThreadPool> _workers;
+    /** The main tasks that are ready to execute */
+    std::deque<size_t> _ready;
+    /** The number of startup tasks not yet complete */
+    size_t _remaining;
+    /** Whether this graph has been run */
+    bool _launched;
+    /** The thread that called run */
+    Uint64 _mainThread;
+    /** The time that run was called */
+    Timestamp _launch;
+    /** The time that the last startup task completed */
+    Uint64 _elapsed;
+
+    /** A mutex for the task states */
+    std::mutex _mutex;
+    /** A condition variable to signal task completion */
+    std::condition_variable _cond;
+
+#pragma mark Internal Helpers
+    /**
+     * Adds a task to this graph.
+     *
+     * Task names must be unique.
+     *
+     * @param name      The task name
+     * @param task      The task body
+     * @param depends   The names of the tasks this task depends on
+     * @param worker    Whether the task runs in the thread pool
+     * @param lazy      Whether the task is deferred until required
+     */
+    void addTask(const std::string& name, const std::function<void()>& task,
+                 const std::vector<std::string>& depends, bool worker, bool lazy);
+
+    /**
+     * Returns true if the dependency graph is well-formed.
+     *
+     * The graph is well-formed if every dependency exists, no startup task
+     * depends on a lazy task, and there are no cycles.  This method also
+     * computes the dependents of each task.
+     *
+     * @return true if the dependency graph is well-formed.
+     */
+    bool resolve();
+
+    /**
+     * Dispatches the given task, which has no more pending dependencies.
+     *
+     * Worker tasks are sent to the thread pool, and main tasks are added to
+     * the ready queue.  This method assumes that the mutex is held.
+     *
+     * @param index The task to dispatch
+     */
+    void dispatch(size_t index);
+
+    /**
+     * Executes the given task and records its timing.
+     *
+     * Once the task completes, any dependents are dispatched.
+     *
+     * @param index The task to execute
+     */
+    void execute(size_t index);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized start-up graph.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    Bootstrap() : _threads(0), _remaining(0), _launched(false), _mainThread(0), _elapsed(0) {}
+
+    /**
+     * Deletes this start-up graph, disposing all resources.
+     */
+    ~Bootstrap() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this start-up graph.
+     *
+     * A disposed graph can be safely reinitialized.  It is unsafe to call this
+     * method while the graph is running.
+     */
+    void dispose();
+
+    /**
+     * Initializes a start-up graph with the given number of worker threads.
+     *
+     * @param threads   The number of threads for worker tasks
+     *
+     * @return true if the graph is initialized properly, false otherwise.
+     */
+    bool init(Uint32 threads = 2);
+
+    /**
+     * Returns a newly allocated start-up graph with the given number of threads.
+     *
+     * @param threads   The number of threads for worker tasks
+     *
+     * @return a newly allocated start-up graph with the given number of threads.
+     */
+    static std::shared_ptr<Bootstrap> alloc(Uint32 threads = 2) {
+        std::shared_ptr<Bootstrap> result = std::make_shared<Bootstrap>();
+        return (result->init(threads) ? result : nullptr);
+    }
+
+#pragma mark Task Registration
+    /**
+     * Adds a startup task to run on the main thread.
+     *
+     * The task will not start until all of the named dependencies are
+     * complete.  Task names must be unique.  Tasks may be added in any order,
+     * but must all be added before the graph is run.
+     *
+     * @param name      The task name
+     * @param task      The task body
+     * @param depends   The names of the tasks this task depends on
+     */
+    void addMainTask(const std::string& name, const std::function<void()>& task,
+                     const std::vector<std::string>& depends = {});
+
+    /**
+     * Adds a startup task to run in the thread pool.
+     *
+     * The task will not start until all of the named dependencies are
+     * complete.  Task names must be unique.  Tasks may be added in any order,
+     * but must all be added before the graph is run.
+     *
+     * Worker tasks may not access the OpenGL context.
+     *
+     * @param name      The task name
+     * @param task      The task body
+     * @param depends   The names of the tasks this task depends on
+     */
+    void addWorkerTask(const std::string& name, const std::function<void()>& task,
+                       const std::vector<std::string>& depends = {});
+
+    /**
+     * Adds a lazy task that is deferred until required.
+     *
+     * This task is not run by {@link run}.  It is executed, at most once, by
+     * the first call to {@link require} for this task or any lazy task that
+     * depends on it.  It executes on the thread calling require.
+     *
+     * @param name      The task name
+     * @param task      The task body
+     * @param depends   The names of the tasks this task depends on
+     */
+    void addLazyTask(const std::string& name, const std::function<void()>& task,
+                     const std::vector<std::string>& depends = {});
+
+#pragma mark Execution
+    /**
+     * Runs all startup tasks, returning when they are complete.
+     *
+     * This method must be called on the main thread.  The calling thread
+     * executes the main tasks as they become ready, and blocks while it waits
+     * on worker tasks.  The thread pool is shut down when this method returns.
+     *
+     * If the graph is malformed (a missing dependency, a startup task depending
+     * on a lazy task, or a cycle), this method runs nothing and returns false.
+     *
+     * @return true if all startup tasks were run.
+     */
+    bool run();
+
+    /**
+     * Ensures the named task has completed, executing it if necessary.
+     *
+     * For a startup task, this blocks until the task is complete (it is an
+     * error to call this before {@link run}).  For a lazy task, this runs the
+     * task (and any lazy dependencies) on the first call, and does nothing
+     * on subsequent calls.
+     *
+     * @param name  The task name
+     *
+     * @return true if the task has completed.
+     */
+    bool require(const std::string& name);
+
+    /**
+     * Returns true if the named task has completed.
+     *
+     * @param name  The task name
+     *
+     * @return true if the named task has completed.
+     */
+    bool isComplete(const std::string& name);
+
+#pragma mark Profiling
+    /**
+     * Returns the time in microseconds to run all startup tasks.
+     *
+     * This value is 0 if the graph has not been run.
+     *
+     * @return the time in microseconds to run all startup tasks.
+     */
+    Uint64 getElapsedMicros() const { return _elapsed; }
+
+    /**
+     * Returns the timeline of all completed tasks in the Chrome trace format.
+     *
+     * The result is a JSON array of complete ("X") events, with times in
+     * microseconds relative to the call to {@link run}.  Write it to a file
+     * with {@link JsonWriter} and open it in chrome://tracing (or Perfetto)
+     * to see which tasks overlapped.
+     *
+     * @return the timeline of all completed tasks in the Chrome trace format.
+     */
+    std::shared_ptr<JsonValue> getTimeline();
+
+    /**
+     * Logs the timeline of all completed tasks.
+     *
+     * Tasks are listed in the order they started, with their start time,
+     * duration, and whether they ran on the main thread.
+     */
+    void logTimeline();
+
+};
+
+}
+#endif /* __CU_BOOTSTRAP_H__ */
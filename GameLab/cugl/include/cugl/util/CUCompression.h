@@ -0,0 +1,117 @@
+//
+//  CUCompression.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a fast block compression codec and a CRC32 checksum.
+//  The codec is a byte-oriented LZ77 variant in the style of LZ4.  It trades
+//  compression ratio for speed, and is intended for large save and replay
+//  files that are written during gameplay.  It is not compatible with LZ4
+//  or any other external format.
+//
+//  Like the filetool and strtool modules, this is a collection of namespaced
+//  functions.  All functions are thread safe.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_COMPRESSION_H__
+#define __CU_COMPRESSION_H__
+#include <SDL/SDL.h>
+#include <cstddef>
+
+namespace cugl {
+
+    /**
+     * Functions for block compression and checksums.
+     *
+     * The compressed format is a sequence of tokens.  Each token is a run of
+     * literal bytes followed by a match, which copies bytes from earlier in
+     * the output.  The final token has literals but no match.  Matches may
+     * only refer to data in the same block, so each block can be decoded on
+     * its own.
+     */
+    namespace packtool {
+
+        /**
+         * Returns the maximum size of the encoding of length bytes.
+         *
+         * Data that does not compress grows slightly when encoded.  An output
+         * buffer of this size is always large enough for {@link encode}.
+         *
+         * @param length    The number of bytes to encode
+         *
+         * @return the maximum size of the encoding of length bytes.
+         */
+        size_t bound(size_t length);
+
+        /**
+         * Returns the number of bytes written when encoding the input.
+         *
+         * The output buffer must have room for capacity bytes.  If the
+         * encoding does not fit, this function returns 0 and the contents
+         * of the output buffer are undefined.
+         *
+         * @param input     The data to encode
+         * @param length    The number of bytes to encode
+         * @param output    The buffer to store the encoding
+         * @param capacity  The capacity of the output buffer
+         *
+         * @return the number of bytes written when encoding the input.
+         */
+        size_t encode(const Uint8* input, size_t length, Uint8* output, size_t capacity);
+
+        /**
+         * Returns the number of bytes written when decoding the input.
+         *
+         * The output buffer must have room for capacity bytes.  This function
+         * checks every token against the bounds of both buffers.  If the
+         * input is corrupt or does not fit, this function returns 0 and the
+         * contents of the output buffer are undefined.
+         *
+         * @param input     The data to decode
+         * @param length    The number of bytes to decode
+         * @param output    The buffer to store the decoded data
+         * @param capacity  The capacity of the output buffer
+         *
+         * @return the number of bytes written when decoding the input.
+         */
+        size_t decode(const Uint8* input, size_t length, Uint8* output, size_t capacity);
+
+        /**
+         * Returns the CRC32 checksum of the given data.
+         *
+         * This is the standard (zlib) CRC32.  To checksum data in several
+         * pieces, pass the result for each piece as the initial value of
+         * the next one.
+         *
+         * @param data      The data to checksum
+         * @param length    The number of bytes to checksum
+         * @param crc       The checksum of any preceding data
+         *
+         * @return the CRC32 checksum of the given data.
+         */
+        Uint32 crc32(const Uint8* data, size_t length, Uint32 crc=0);
+
+    }
+}
+
+#endif /* __CU_COMPRESSION_H__ */
@@ -0,0 +1,358 @@
+//
+//  CUMemoryTracker.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides tagged memory accounting for the engine subsystems.
+//  When enabled it replaces the global operator new and delete, so that
+//  every heap allocation is charged to the tag active on the allocating
+//  thread.  Tags are set with scopes, and the engine tags its own rendering,
+//  geometry, JSON, audio and physics code.  The render classes also register
+//  estimates for the GPU storage of their textures and buffers.
+//
+//  Tracking is on in debug builds (those without NDEBUG) and compiled out
+//  of release builds.  Define CU_MEMORY_TRACKING to force it on in a release
+//  build, or CU_NO_MEMORY_TRACKING to turn it off in a debug build.  Either
+//  must be defined for the whole build (both the engine and the game).  When
+//  tracking is off, the methods of this class still exist, but they do
+//  nothing and all statistics are zero.
+//
+//  This class is a static class, as there is only one heap.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#ifndef __CU_MEMORY_TRACKER_H__
+#define __CU_MEMORY_TRACKER_H__
+#include <SDL/SDL.h>
+#include <memory>
+#include <string>
+
+// Track memory in debug builds unless it is turned off
+#if !defined (CU_MEMORY_TRACKING) && !defined (CU_NO_MEMORY_TRACKING) && !defined (NDEBUG)
+    #define CU_MEMORY_TRACKING 1
+#endif
+
+namespace cugl {
+
+/** Forward reference to the JSON value */
+class JsonValue;
+
+/**
+ * This class is a collection of static methods for memory accounting.
+ *
+ * Every heap allocation made with operator new is charged to a {@link Tag}.
+ * Each thread has an active tag, which is {@link Tag#GENERAL} unless it is
+ * changed by a {@link Scope}.  Memory is always credited back to the tag
+ * that allocated it, even if it is freed under another tag.
+ *
+ * The render classes also register estimates of the GPU memory used by
+ * their textures and buffers.  These estimates are kept apart from the heap
+ * statistics, as the driver may store the data in a different format.
+ *
+ * All statistics are updated with relaxed atomics, so they may be read
+ * from any thread.  However, a snapshot taken while other threads are
+ * allocating may not be consistent across tags.
+ */
+class MemoryTracker {
+public:
+    /**
+     * The subsystem tags for memory accounting.
+     */
+    enum class Tag : Uint32 {
+        /** Memory allocated outside of any scope */
+        GENERAL  = 0,
+        /** Memory allocated by application code */
+        GAME     = 1,
+        /** Sprite batches and their drawing contexts */
+        RENDER   = 2,
+        /** Polygons computed by the triangulators and extruders */
+        GEOMETRY = 3,
+        /** Parsed JSON trees */
+        JSON     = 4,
+        /** Decoded audio samples */
+        AUDIO    = 5,
+        /** The physics world and its Box2D allocations */
+        PHYSICS  = 6,
+        /** Texture storage (GPU estimates only) */
+        TEXTURE  = 7,
+        /** Vertex and uniform buffer storage (GPU estimates only) */
+        BUFFER   = 8
+    };
+
+    /** The number of memory tags */
+    static const Uint32 TAG_COUNT = 9;
+
+    /**
+     * The statistics for a single tag.
+     *
+     * The live values are the memory currently allocated.  The total values
+     * count every allocation since the program started.
+     */
+    struct Stats {
+        /** The number of bytes currently allocated */
+        Sint64 liveBytes;
+        /** The number of allocations not yet freed */
+        Sint64 liveCount;
+        /** The largest value of liveBytes since the last reset */
+        Sint64 peakBytes;
+        /** The number of allocations since the program started */
+        Uint64 totalCount;
+        /** The number of bytes allocated since the program started */
+        Uint64 totalBytes;
+        /** The number of allocations in the last complete frame */
+        Uint64 frameCount;
+        /** The largest value of frameCount since the last reset */
+        Uint64 peakFrame;
+        /** The estimated GPU storage in bytes */
+        Sint64 gpuBytes;
+        /** The number of GPU resources */
+        Sint64 gpuCount;
+    };
+
+    /**
+     * A scope that sets the active tag of the current thread.
+     *
+     * The previous tag is restored when the scope is destroyed.  Scopes
+     * may be nested.  You should use the macro CUMemoryScope instead of
+     * this class, so that the scope is compiled out when tracking is disabled.
+     */
+    class Scope {
+    private:
+        /** The tag active when this scope was created */
+        Tag _previous;
+
+    public:
+        /**
+         * Creates a scope that sets the active tag of the current thread.
+         *
+         * @param tag   The tag to make active
+         */
+        Scope(Tag tag) { _previous = MemoryTracker::setTag(tag); }
+
+        /**
+         * Restores the tag active when this scope was created.
+         */
+        ~Scope() { MemoryTracker::setTag(_previous); }
+
+        /** Scopes may not be copied */
+        Scope(const Scope& scope) = delete;
+        /** Scopes may not be copied */
+        Scope& operator=(const Scope& scope) = delete;
+    };
+
+private:
+    /**
+     * Default constructor (does nothing)
+     */
+    MemoryTracker() {}
+
+    /**
+     * Default destructor (does nothing)
+     */
+    ~MemoryTracker() {}
+
+public:
+#pragma mark Tags
+    /**
+     * Returns true if memory tracking is compiled into this build.
+     *
+     * @return true if memory tracking is compiled into this build.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns a string representation of the given tag.
+     *
+     * @param tag   The tag to name
+     *
+     * @return a string representation of the given tag.
+     */
+    static const char* getName(Tag tag);
+
+    /**
+     * Returns the active tag of the current thread.
+     *
+     * @return the active tag of the current thread.
+     */
+    static Tag getTag();
+
+    /**
+     * Sets the active tag of the current thread, returning the previous one.
+     *
+     * @param tag   The tag to make active
+     *
+     * @return the previously active tag
+     */
+    static Tag setTag(Tag tag);
+
+#pragma mark Statistics
+    /**
+     * Returns the statistics for the given tag.
+     *
+     * @param tag   The tag to query
+     *
+     * @return the statistics for the given tag.
+     */
+    static Stats getStats(Tag tag);
+
+    /**
+     * Returns the statistics summed over all tags.
+     *
+     * The peak values are the sums of the peaks for each tag.  Therefore,
+     * they are an upper bound on the true peaks.
+     *
+     * @return the statistics summed over all tags.
+     */
+    static Stats getTotals();
+
+    /**
+     * Returns the number of allocations made by the current thread.
+     *
+     * This value is intended for asserting that a loop does not allocate.
+     * Unlike the tag statistics, it is not affected by other threads.
+     *
+     * @return the number of allocations made by the current thread.
+     */
+    static Uint64 getThreadAllocations();
+
+    /**
+     * Returns the number of frames completed.
+     *
+     * @return the number of frames completed.
+     */
+    static Uint64 getFrames();
+
+    /**
+     * Marks the end of an animation frame.
+     *
+     * This method records the number of allocations for each tag since the
+     * last call.  It is called by {@link Application} once per frame.
+     */
+    static void endFrame();
+
+    /**
+     * Resets the peak values of every tag to the current values.
+     */
+    static void resetPeaks();
+
+#pragma mark GPU Resources
+    /**
+     * Registers a GPU resource of the given size.
+     *
+     * You should use the macro CUMemoryAddResource instead of this method,
+     * so that the call is compiled out when tracking is disabled.
+     *
+     * @param tag   The tag for the resource
+     * @param bytes The estimated size of the resource
+     */
+    static void addResource(Tag tag, size_t bytes);
+
+    /**
+     * Unregisters a GPU resource of the given size.
+     *
+     * You should use the macro CUMemoryRemoveResource instead of this method,
+     * so that the call is compiled out when tracking is disabled.
+     *
+     * @param tag   The tag for the resource
+     * @param bytes The estimated size of the resource
+     */
+    static void removeResource(Tag tag, size_t bytes);
+
+    /**
+     * Changes the size of a registered GPU resource.
+     *
+     * You should use the macro CUMemoryResizeResource instead of this method,
+     * so that the call is compiled out when tracking is disabled.
+     *
+     * @param tag       The tag for the resource
+     * @param oldbytes  The previous estimated size of the resource
+     * @param newbytes  The new estimated size of the resource
+     */
+    static void resizeResource(Tag tag, size_t oldbytes, size_t newbytes);
+
+#pragma mark Reporting
+    /**
+     * Returns a JSON representation of the current statistics.
+     *
+     * The JSON object has an entry for each tag, as well as the totals.
+     * Each entry is an object whose keys are the fields of {@link Stats}.
+     *
+     * @return a JSON representation of the current statistics.
+     */
+    static std::shared_ptr<JsonValue> toJson();
+
+    /**
+     * Returns true if the current statistics were written to the given file.
+     *
+     * The statistics are written with {@link JsonWriter}, so a relative path
+     * is placed in the application save directory.
+     *
+     * @param file  The path (absolute or relative) to the file
+     *
+     * @return true if the current statistics were written to the given file.
+     */
+    static bool dump(const std::string file);
+};
+
+}
+
+/**
+ * @def CUMemoryScope(tag)
+ *
+ * Charges all allocations on this thread to the given tag until the end of
+ * the enclosing block.  The tag is a value of MemoryTracker::Tag.
+ *
+ * @def CUMemoryAddResource(tag,bytes)
+ *
+ * Registers a GPU resource of the given size.
+ *
+ * @def CUMemoryRemoveResource(tag,bytes)
+ *
+ * Unregisters a GPU resource of the given size.
+ *
+ * @def CUMemoryResizeResource(tag,oldbytes,newbytes)
+ *
+ * Changes the size of a registered GPU resource.
+ *
+ * @def CUMemoryEndFrame()
+ *
+ * Marks the end of an animation frame.
+ */
+#if defined (CU_MEMORY_TRACKING)
+    #define CUMemoryScope(tag) \
+        cugl::MemoryTracker::Scope __cu_memory_scope__(cugl::MemoryTracker::Tag::tag)
+    #define CUMemoryAddResource(tag,bytes) \
+        cugl::MemoryTracker::addResource(cugl::MemoryTracker::Tag::tag,bytes)
+    #define CUMemoryRemoveResource(tag,bytes) \
+        cugl::MemoryTracker::removeResource(cugl::MemoryTracker::Tag::tag,bytes)
+    #define CUMemoryResizeResource(tag,oldbytes,newbytes) \
+        cugl::MemoryTracker::resizeResource(cugl::MemoryTracker::Tag::tag,oldbytes,newbytes)
+    #define CUMemoryEndFrame()  cugl::MemoryTracker::endFrame()
+#else
+    #define CUMemoryScope(tag)                              ((void)0)
+    #define CUMemoryAddResource(tag,bytes)                  ((void)(bytes))
+    #define CUMemoryRemoveResource(tag,bytes)               ((void)(bytes))
+    #define CUMemoryResizeResource(tag,oldbytes,newbytes)   ((void)(oldbytes),(void)(newbytes))
+    #define CUMemoryEndFrame()                              ((void)0)
+#endif
+
+#endif /* __CU_MEMORY_TRACKER_H__ */
@@ -6,6 +6,10 @@
 //  task is specified by a void function.  There are no guarantees about thread
 //  safety; that is responsibility of the author of each task.
 //
+//  Tasks may be given an optional priority.  Higher priority tasks are always
+//  assigned to a worker before lower priority ones, while tasks of the same
+//  priority are processed in the order they were added.
+//
 //  This code is largely inspired from the Cocos2d file AudioEngine.cpp, from
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
@@ -82,8 +86,40 @@ private:
     std::vector<std::thread> _workers;
 #endif
     
-    /** Tasks waiting to be assigned to a thread */
-    std::queue< std::function<void()> > _taskQueue;
+    /**
+     * A task waiting to be assigned to a thread.
+     *
+     * The order value breaks ties between tasks of equal priority, so that
+     * those tasks are processed in FIFO order.
+     */
+    class Task {
+    public:
+        /** The function to execute */
+        std::function<void()> work;
+        /** The task priority (higher tasks go first) */
+        int priority;
+        /** The insertion order of this task */
+        Uint64 order;
+
+        /**
+         * Returns true if this task should be processed after the given one.
+         *
+         * This comparison orders the task heap so that the front is the
+         * highest priority task that was added first.
+         *
+         * @param other The task to compare against
+         *
+         * @return true if this task should be processed after the given one.
+         */
+        bool operator<(const Task& other) const {
+            return (priority == other.priority ? order > other.order : priority < other.priority);
+        }
+    };
+
+    /** Tasks waiting to be assigned to a thread (stored as a max-heap) */
+    std::vector<Task> _taskQueue;
+    /** The number of tasks added to this pool (used to order the heap) */
+    Uint64 _taskCount;
     
     /** A mutex lock for the task queue */
     std::mutex _queueMutex;
@@ -104,6 +140,17 @@ private:
      */
     void threadFunc();
 
+    /**
+     * Returns true if there was a task to process from the queue.
+     *
+     * This function pulls the highest priority task from the queue and then
+     * executes it outside of the lock.  If the queue is empty, it waits on
+     * the task condition variable instead.
+     *
+     * @return true if there was a task to process from the queue.
+     */
+    bool processTask();
+
     /**
      * The body function of a single thread.
      *
@@ -125,7 +172,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a thread pool 
      * on the heap, use one of the static constructors instead.
      */
-    ThreadPool() :_stop(false), _complete(0) { }
+    ThreadPool() : _taskCount(0), _stop(false), _complete(0) { }
     
     /**
      * Deletes this thread pool, destroying all resources.
@@ -188,9 +235,41 @@ public:
      * will not be executed immediately, but must wait for the first available 
      * worker.
      *
+     * If this method is called from inside of a task currently executing in
+     * this thread pool, the new task inherits the priority of that task. This
+     * allows multi-stage jobs to keep their place in line.  Otherwise, the
+     * task has priority 0.
+     *
      * @param  task     the task function to add to the thread pool
      */
     void addTask(const std::function<void()> &task);
+
+    /**
+     * Adds a task to the thread pool with the given priority.
+     *
+     * A task is a void returning function with no parameters.  If you need
+     * state in the task, you should use a method call for the state.  The task
+     * will not be executed immediately, but must wait for the first available
+     * worker.
+     *
+     * Tasks with a higher priority are assigned to a worker before any tasks
+     * of lower priority.  Tasks with the same priority are processed in the
+     * order they were added. Priorities may be negative.
+     *
+     * @param  task     the task function to add to the thread pool
+     * @param  priority the task priority
+     */
+    void addTask(const std::function<void()> &task, int priority);
+
+    /**
+     * Returns the priority of the task executing on the current thread.
+     *
+     * If the current thread is not a worker of this thread pool, this method
+     * returns 0.
+     *
+     * @return the priority of the task executing on the current thread.
+     */
+    int getActivePriority() const;
     
     /**
      * Stop the thread pool, marking it for shut down.
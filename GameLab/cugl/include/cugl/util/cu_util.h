@@ -36,5 +36,8 @@
 #include "CUFreeList.h"
 #include "CUGreedyFreeList.h"
 #include "CUThreadPool.h"
+#include "CUCompression.h"
+#include "CUMemoryTracker.h"
+#include "CUBootstrap.h"
 
 #endif /* __CU_UTIL_PKG_H__ */
@@ -49,6 +49,77 @@
 
 using namespace cugl;
 
+/** The size estimate for an asset with no file (e.g. a scene graph) */
+#define DEFAULT_ASSET_BYTES 1024
+
+/**
+ * Returns the estimated size in bytes of the given directory entry.
+ *
+ * If the entry has a "bytes" attribute, that value is used.  Otherwise, if
+ * the entry has a "file" attribute (or is just a file name), the size of that
+ * file is used. If neither is available, this function returns
+ * DEFAULT_ASSET_BYTES.
+ *
+ * @param json  The directory entry for the asset
+ *
+ * @return the estimated size in bytes of the given directory entry.
+ */
+static size_t estimate_bytes(const std::shared_ptr<JsonValue>& json) {
+    if (json->isObject() && json->has("bytes")) {
+        long bytes = json->getLong("bytes",DEFAULT_ASSET_BYTES);
+        return bytes > 0 ? (size_t)bytes : 1;
+    }
+    
+    std::string file;
+    if (json->isString()) {
+        file = json->asString("");
+    } else if (json->isObject()) {
+        file = json->getString("file","");
+    }
+    if (!file.empty()) {
+        std::string path = Application::get()->getAssetDirectory();
+        path.append(file);
+        SDL_RWops* source = SDL_RWFromFile(path.c_str(), "rb");
+        if (source != nullptr) {
+            Sint64 size = SDL_RWsize(source);
+            SDL_RWclose(source);
+            if (size > 0) {
+                return (size_t)size;
+            }
+        }
+    }
+    return DEFAULT_ASSET_BYTES;
+}
+
+/**
+ * Returns true if the given directory entry is marked critical.
+ *
+ * Entries that are just a file name (e.g. JSON and widget assets) are
+ * never critical.
+ *
+ * @param json  The directory entry for the asset
+ *
+ * @return true if the given directory entry is marked critical.
+ */
+static bool entry_critical(const std::shared_ptr<JsonValue>& json) {
+    return json->isObject() && json->getBool("critical",false);
+}
+
+/**
+ * Returns the load priority of the given directory entry.
+ *
+ * Critical assets have a default priority of 1, while all other assets have
+ * a default priority of 0.
+ *
+ * @param json  The directory entry for the asset
+ *
+ * @return the load priority of the given directory entry.
+ */
+static int entry_priority(const std::shared_ptr<JsonValue>& json) {
+    int priority = entry_critical(json) ? 1 : 0;
+    return json->isObject() ? json->getInt("priority",priority) : priority;
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -65,6 +136,13 @@ using namespace cugl;
  */
 bool AssetManager::init() {
     _workers = ThreadPool::alloc(1);
+    _pending = 0;
+    _directoryWait = 0;
+    _totalBytes = 0;
+    _loadedBytes = 0;
+    _criticalBytes = 0;
+    _criticalLoaded = 0;
+    _criticalWait = 0;
     return true;
 }
 
@@ -76,6 +154,7 @@ bool AssetManager::init() {
  * threads) and reattach all loaders to use the asset manager again.
  */
 void AssetManager::dispose() {
+    cancelAll();
     detachAll();
     _workers = nullptr;
 }
@@ -154,14 +233,19 @@ bool AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& j
  * to load, the callback function will be given the asset category name
  * (e.g. "soundfx") as the asset key.
  *
+ * Each asset is queued with the priority specified in its JSON entry.
+ * Assets still in the queue are skipped if the cancel flag is set.
+ *
  * @param hash      The hash of the asset type
  * @param json      The child of asset directory with these assets
  * @param callback  An optional callback after each asset is loaded
+ * @param cancel    The cancellation flag for this directory
  */
 void AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& json,
-                                LoaderCallback callback) {
+                                LoaderCallback callback,
+                                const std::shared_ptr<std::atomic<bool>>& cancel) {
     auto it = _handlers.find(hash);
-    std::shared_ptr<BaseLoader> loader = it->second;
+    std::shared_ptr<BaseLoader> loader = (it == _handlers.end() ? nullptr : it->second);
     if (loader == nullptr) {
         if (callback) {
             Application::get()->schedule([=] {
@@ -172,9 +256,97 @@ void AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& j
         return;
     }
     
+    // Asset priorities are doubled to leave room for scene barriers
     for(int ii = 0; ii < json->size(); ii++) {
         std::shared_ptr<JsonValue> child = json->get(ii);
-        loader->loadAsync(child, callback);
+        queueAsset(loader, child, callback, cancel, 2*entry_priority(child));
+    }
+}
+
+/**
+ * Queues a single asset from an asset directory in the thread pool.
+ *
+ * The asset is not given to its loader until its turn in the thread pool.
+ * Until then, it may be cancelled by setting the cancel flag.  The size
+ * of the asset is estimated when it is queued, and is used to weight
+ * the loading progress.
+ *
+ * @param loader    The loader for this asset
+ * @param json      The JSON entry for this asset
+ * @param callback  An optional callback after the asset is loaded
+ * @param cancel    The cancellation flag for this directory
+ * @param priority  The thread pool priority of this asset
+ */
+void AssetManager::queueAsset(const std::shared_ptr<BaseLoader>& loader,
+                              const std::shared_ptr<JsonValue>& json,
+                              LoaderCallback callback,
+                              const std::shared_ptr<std::atomic<bool>>& cancel,
+                              int priority) {
+    bool critical = entry_critical(json);
+    size_t bytes  = estimate_bytes(json);
+    _totalBytes += bytes;
+    if (critical) {
+        _criticalBytes += bytes;
+        _criticalWait++;
+    }
+    
+    // Count the asset on both sides of the hand-off to its loader, so that
+    // progress never mistakes it for an asset outside of a directory
+    _directoryWait++;
+    _pending++;
+    _workers->addTask([=](void) {
+        bool cancelled = cancel->load();
+        if (cancelled || loader->contains(json->key())) {
+            // Skipped assets still report, so callers can count them
+            bool loaded = !cancelled;
+            this->finishAsset(bytes,critical,loaded);
+            if (callback) {
+                std::string key = json->key();
+                Application::get()->schedule([=] {
+                    callback(key,loaded);
+                    return false;
+                });
+            }
+        } else {
+            // Loader tasks inherit this priority from the thread pool
+            this->_directoryWait++;
+            loader->loadAsync(json, [=](const std::string& key, bool success) {
+                this->_directoryWait--;
+                this->finishAsset(bytes,critical,true);
+                if (callback) {
+                    callback(key,success);
+                }
+            });
+        }
+        this->_pending--;
+        this->_directoryWait--;
+    },priority);
+}
+
+/**
+ * Records that a directory asset is no longer waiting to load.
+ *
+ * If the asset was loaded, its bytes are added to the loaded total.
+ * Otherwise (e.g. it was cancelled), its bytes are removed from the
+ * total estimate.
+ *
+ * @param bytes     The estimated size of the asset in bytes
+ * @param critical  Whether the asset is critical
+ * @param loaded    Whether the asset was loaded
+ */
+void AssetManager::finishAsset(size_t bytes, bool critical, bool loaded) {
+    if (loaded) {
+        _loadedBytes += bytes;
+    } else {
+        _totalBytes -= bytes;
+    }
+    if (critical) {
+        if (loaded) {
+            _criticalLoaded += bytes;
+        } else {
+            _criticalBytes -= bytes;
+        }
+        _criticalWait--;
     }
 }
 
@@ -218,12 +390,17 @@ bool AssetManager::purgeCategory(size_t hash, const std::shared_ptr<JsonValue>&
  * previously loaded assets (e.g. scene graphs).  In the current architecture,
  * this method is only correct if the asset manager loads assets in a
  * single thread.
+ *
+ * The barrier is queued at the given thread pool priority.  Therefore it
+ * only waits for those assets with a higher priority.
+ *
+ * @param priority  The thread pool priority of the barrier
  */
-void AssetManager::sync() {
+void AssetManager::sync(int priority) {
     _workers->addTask([=](void) {
         this->block();
         this->block(); // Two blocks force one complete cycle
-    });
+    },priority);
 }
 
 /**
@@ -373,32 +550,83 @@ bool AssetManager::loadDirectory(const std::string& directory) {
  * to load, the callback function will be given the asset category name
  * (e.g. "soundfx") as the asset key.
  *
+ * Each asset may specify an integer "priority" (default 0), and assets of
+ * higher priority are loaded first.  An asset may also be marked "critical"
+ * (in which case its default priority is 1). See {@link criticalComplete}.
+ * Scene graphs are loaded after all assets of the same or higher priority.
+ * Finally, an asset may specify its size in "bytes" to override the size
+ * estimate used by {@link progress}.
+ *
  * @param json      The JSON asset directory
  * @param callback  An optional callback after each asset is loaded
  */
 void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, LoaderCallback callback) {
+    std::shared_ptr<std::atomic<bool>> cancel = _cancels[""];
+    if (cancel == nullptr) {
+        cancel = std::make_shared<std::atomic<bool>>(false);
+        _cancels[""] = cancel;
+    }
+    readDirectory(json,callback,cancel);
+}
+
+/**
+ * Asynchronously loads all assets in the given directory.
+ *
+ * This method is the implementation of {@link loadDirectoryAsync}. The
+ * cancel flag is shared by all of the assets in the directory.
+ *
+ * @param json      The JSON asset directory
+ * @param callback  An optional callback after each asset is loaded
+ * @param cancel    The cancellation flag for this directory
+ */
+void AssetManager::readDirectory(const std::shared_ptr<JsonValue>& json, LoaderCallback callback,
+                                 const std::shared_ptr<std::atomic<bool>>& cancel) {
     for(int ii = 0; ii < json->size(); ii++) {
         std::shared_ptr<JsonValue> child = json->get(ii);
         if (child->key() == "textures") {
-            readCategory(typeid(Texture).hash_code(),child,callback);
+            readCategory(typeid(Texture).hash_code(),child,callback,cancel);
         } else if (child->key() == "sounds") {
-            readCategory(typeid(Sound).hash_code(),child,callback);
+            readCategory(typeid(Sound).hash_code(),child,callback,cancel);
         } else if (child->key() == "fonts") {
-            readCategory(typeid(Font).hash_code(),child,callback);
+            readCategory(typeid(Font).hash_code(),child,callback,cancel);
         } else if (child->key() == "jsons") {
-            readCategory(typeid(JsonValue).hash_code(),child,callback);
+            readCategory(typeid(JsonValue).hash_code(),child,callback,cancel);
         } else if (child->key() == "widgets") {
-            readCategory(typeid(WidgetValue).hash_code(),child,callback);
+            readCategory(typeid(WidgetValue).hash_code(),child,callback,cancel);
         } else if (child->key() != "scene2s") {
             CULogError("Unknown asset category '%s'",child->key().c_str());
         }
     }
     
-    // Scenes are read after everything else.
+    // Scenes are read after everything of the same priority or higher.
     std::shared_ptr<JsonValue> child = json->get("scene2s");
-    sync();
-    if (child) {
-        readCategory(typeid(scene2::SceneNode).hash_code(),child,callback);
+    if (child == nullptr) {
+        return;
+    }
+
+    auto it = _handlers.find(typeid(scene2::SceneNode).hash_code());
+    std::shared_ptr<BaseLoader> loader = (it == _handlers.end() ? nullptr : it->second);
+    if (loader == nullptr) {
+        readCategory(typeid(scene2::SceneNode).hash_code(),child,callback,cancel);
+        return;
+    }
+    
+    // Barriers go between the asset priorities (which are doubled)
+    std::vector<int> levels;
+    for(int ii = 0; ii < child->size(); ii++) {
+        int level = entry_priority(child->get(ii));
+        if (std::find(levels.begin(),levels.end(),level) == levels.end()) {
+            levels.push_back(level);
+        }
+    }
+    for(auto jt = levels.begin(); jt != levels.end(); ++jt) {
+        sync(2*(*jt)-1);
+        for(int ii = 0; ii < child->size(); ii++) {
+            std::shared_ptr<JsonValue> scene = child->get(ii);
+            if (entry_priority(scene) == *jt) {
+                queueAsset(loader, scene, callback, cancel, 2*(*jt)-1);
+            }
+        }
     }
 }
 
@@ -431,23 +659,38 @@ void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, Lo
  * to load, the callback function will be given the asset category name
  * (e.g. "soundfx") as the asset key.
  *
+ * Each asset may specify an integer "priority" (default 0), and assets of
+ * higher priority are loaded first.  An asset may also be marked "critical"
+ * (in which case its default priority is 1). See {@link criticalComplete}.
+ * Scene graphs are loaded after all assets of the same or higher priority.
+ * Finally, an asset may specify its size in "bytes" to override the size
+ * estimate used by {@link progress}.
+ *
  * @param directory The path to the JSON asset directory
  * @param callback  An optional callback after each asset is loaded
  */
 void AssetManager::loadDirectoryAsync(const std::string& directory, LoaderCallback callback) {
-    _preload = true;
-    
     std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr && callback != nullptr) {
-        callback("",false);
+    if (reader == nullptr) {
+        if (callback != nullptr) {
+            callback("",false);
+        }
         return;
     }
     
+    std::shared_ptr<std::atomic<bool>> cancel = _cancels[directory];
+    if (cancel == nullptr || cancel->load()) {
+        cancel = std::make_shared<std::atomic<bool>>(false);
+        _cancels[directory] = cancel;
+    }
+    
+    _preload = true;
+    // Parse the directory before any queued assets
     _workers->addTask([=](void) {
         std::shared_ptr<JsonValue> json = reader->readJson();
-        loadDirectoryAsync(json,callback);
+        readDirectory(json,callback,cancel);
         _preload = false;
-    });
+    },INT_MAX);
 }
 
 /**
@@ -506,6 +749,40 @@ bool AssetManager::unloadDirectory(const std::string& directory) {
     return unloadDirectory(json);
 }
 
+/**
+ * Cancels all pending asynchronous loads for the given directory.
+ *
+ * Any asset in the directory that has not yet been handed to its loader
+ * will be skipped.  Assets that have already loaded (or are in the middle
+ * of loading) are unaffected; use {@link unloadDirectory} to remove them.
+ * Cancelled assets are removed from the progress estimates, and their
+ * callbacks are called with success set to false.
+ *
+ * @param directory The path to the JSON asset directory
+ */
+void AssetManager::cancelDirectory(const std::string& directory) {
+    auto it = _cancels.find(directory);
+    if (it != _cancels.end()) {
+        it->second->store(true);
+        _cancels.erase(it);
+    }
+}
+
+/**
+ * Cancels all pending asynchronous directory loads.
+ *
+ * This includes directories loaded from a {@link JsonValue}.  Assets that
+ * have already loaded (or are in the middle of loading) are unaffected.
+ * Cancelled assets are removed from the progress estimates, and their
+ * callbacks are called with success set to false.
+ */
+void AssetManager::cancelAll() {
+    for(auto it = _cancels.begin(); it != _cancels.end(); ++it) {
+        it->second->store(true);
+    }
+    _cancels.clear();
+}
+
 #pragma mark -
 #pragma mark Progress Monitoring
 /**
@@ -546,5 +823,57 @@ size_t AssetManager::waitCount() const {
     for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
         result += it->second->waitCount();
     }
+    result += _pending;
     return _preload ? result+1 : result;
 }
+
+/**
+ * Returns the loader progress as a percentage.
+ *
+ * This method returns a value between 0 and 1.  A value of 0 means no
+ * assets have been loaded.  A value of 1 means that all assets have been
+ * loaded.
+ *
+ * Anything in-between indicates that there are assets which have been
+ * loaded asynchronously and have not completed loading. It is not safe to
+ * use asynchronously loaded assets until all loading is complete.
+ *
+ * Assets queued by an asset directory are weighted by their estimated
+ * size in bytes.  If no directory is loading asynchronously, this method
+ * counts each asset equally.  It also counts each asset equally while an
+ * asset loaded outside of a directory is waiting, as that asset has no
+ * size estimate.
+ *
+ * @return the loader progress as a percentage.
+ */
+float AssetManager::progress() const {
+    size_t total = _totalBytes;
+    size_t waiting = waitCount();
+    if (total == 0 || _preload || waiting > _directoryWait) {
+        size_t loaded = loadCount();
+        size_t size = loaded+waiting;
+        return (size == 0 ? 0.0f : ((float)loaded)/size);
+    }
+    float result = ((float)_loadedBytes)/total;
+    return result > 1.0f ? 1.0f : result;
+}
+
+/**
+ * Returns the progress of the critical assets as a percentage.
+ *
+ * This method returns a value between 0 and 1, weighted by the estimated
+ * size of each critical asset.  A value of 1 means that all critical
+ * assets have been loaded (or that there are none).
+ *
+ * @return the progress of the critical assets as a percentage.
+ */
+float AssetManager::criticalProgress() const {
+    if (_preload) {
+        return 0.0f;
+    } else if (_criticalWait == 0) {
+        return 1.0f;
+    }
+    size_t total = _criticalBytes;
+    float result = (total == 0 ? 0.0f : ((float)_criticalLoaded)/total);
+    return result > 1.0f ? 1.0f : result;
+}
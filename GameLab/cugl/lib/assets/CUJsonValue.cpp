@@ -43,6 +43,7 @@
 //
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/util/CUStrings.h>
 
 using namespace cugl;
@@ -400,6 +401,7 @@ bool JsonValue::init(double value) {
  * @return  true if the JSON node is initialized properly, false otherwise.
  */
 bool JsonValue::initWithJson(const char* json) {
+    CUMemoryScope(JSON);
     const char *error = NULL;
     cJSON* node = cJSON_ParseWithOpts(json, &error, 0);
     if (node) {
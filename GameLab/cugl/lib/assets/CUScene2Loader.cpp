@@ -95,6 +95,10 @@ bool Scene2Loader::init(const std::shared_ptr<ThreadPool>& threads) {
     _types["slider"] = Widget::SLIDER;
     _types["textfield"] = Widget::TEXTFIELD;
     _types["text field"] = Widget::TEXTFIELD;
+    _types["scrolllist"] = Widget::SCROLLLIST;
+    _types["scroll list"] = Widget::SCROLLLIST;
+    _types["multiline"] = Widget::MULTILINE;
+    _types["multiline label"] = Widget::MULTILINE;
 	_types["widget"] = Widget::EXTERNAL_IMPORT;
 
     // Define the supported layouts
@@ -188,6 +192,12 @@ std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string& key,
     case Widget::TEXTFIELD:
         node = scene2::TextField::allocWithData(this,data);
         break;
+    case Widget::SCROLLLIST:
+        node = scene2::ScrollList::allocWithData(this,data);
+        break;
+    case Widget::MULTILINE:
+        node = scene2::MultilineLabel::allocWithData(this,data);
+        break;
 	case Widget::EXTERNAL_IMPORT: 
 	{
 		const std::shared_ptr<JsonValue> widgetJson = getWidgetJson(json);
@@ -38,6 +38,7 @@
 #include <cugl/audio/CUAudioSample.h>
 #include <cugl/audio/graph/CUAudioPlayer.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/util/CUFiletools.h>
 #include <cugl/audio/codecs/cu_codecs.h>
 
@@ -71,6 +72,7 @@ _buffer(nullptr) {
  * @return true if the sound source was initialized successfully
  */
 bool AudioSample::init(const char* file, bool stream) {
+    CUMemoryScope(AUDIO);
     CUAssertLog(filetool::file_exists(file), "Cannot find file %s",file);
     _file = file;
     _type = guessType(file);
@@ -107,6 +109,7 @@ bool AudioSample::init(const char* file, bool stream) {
  * @return true if the audio sample was initialized successfully
  */
 bool AudioSample::init(Uint8 channels, Uint32 rate, Uint32 frames) {
+    CUMemoryScope(AUDIO);
     _channels = channels;
     _frames = frames;
     _rate = rate;
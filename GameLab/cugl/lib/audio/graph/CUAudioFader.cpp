@@ -50,15 +50,18 @@ using namespace cugl::audio;
  * The player must be initialized to be used.
  */
 AudioFader::AudioFader() :
+_cmdhead(0),
+_cmdtail(0),
+_status(0),
+_inmark(-1),
 _fadein(0),
+_outmark(-1),
 _fadeout(0),
+_outdone(false),
+_outkeep(false),
 _fadedip(0),
-_inmark(-1),
-_outmark(-1),
 _dipmark(-1),
 _dipstop(0),
-_outdone(false),
-_outkeep(false),
 _diphalf(false) {
     _classname = "AudioFader";
 }
@@ -141,6 +144,10 @@ void AudioFader::dispose() {
         _dipmark = -1;
         _dipstop = 0;
         _diphalf = false;
+        _outdone = false;
+        _cmdhead = 0;
+        _cmdtail = 0;
+        _status  = 0;
     }
 }
 
@@ -206,13 +213,13 @@ std::shared_ptr<AudioNode> AudioFader::detach() {
  * @param duration  The fade-in time in seconds
  */
 void AudioFader::fadeIn(double duration) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (duration <= 0) {
-        _inmark = -1;
-        _fadein = 0;
-    } else {
-        _inmark = (Sint64)(duration*getRate());
-        _fadein = 0;
+    Sint64 frames = duration <= 0 ? -1 : (Sint64)(duration*getRate());
+    if (post(CommandType::FADE_IN,frames)) {
+        if (frames >= 0) {
+            _status.fetch_or(Status::FADING_IN,std::memory_order_release);
+        } else {
+            _status.fetch_and(~(Uint32)Status::FADING_IN,std::memory_order_release);
+        }
     }
 }
 
@@ -222,8 +229,7 @@ void AudioFader::fadeIn(double duration) {
  * @return true if this node is in an active fade-in.
  */
 bool AudioFader::isFadeIn() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _inmark >= 0;
+    return (_status.load(std::memory_order_acquire) & Status::FADING_IN) != 0;
 }
 
 /**
@@ -246,16 +252,13 @@ bool AudioFader::isFadeIn() {
  * @param wrap      Whether to support a fade-out after reset
  */
 void AudioFader::fadeOut(double duration, bool wrap) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (duration <= 0) {
-        _outmark = -1;
-        _fadeout = 0;
-    } else {
-        _outmark = (Sint64)(duration*getRate());
-        _fadeout = 0;
+    Sint64 frames = duration <= 0 ? -1 : (Sint64)(duration*getRate());
+    if (post(CommandType::FADE_OUT,frames,0,wrap)) {
+        Uint32 flags = (frames >= 0 ? (Uint32)Status::FADING_OUT : 0) | (wrap ? (Uint32)Status::OUT_KEEP : 0);
+        _status.fetch_and(~(Uint32)(Status::FADING_OUT | Status::OUT_DONE | Status::OUT_KEEP),
+                          std::memory_order_release);
+        _status.fetch_or(flags,std::memory_order_release);
     }
-    _outkeep = wrap;
-    _outdone = false;
 }
 
 /**
@@ -264,8 +267,7 @@ void AudioFader::fadeOut(double duration, bool wrap) {
  * @return true if this node is in an active fade-out.
  */
 bool AudioFader::isFadeOut() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _outmark >= 0;
+    return (_status.load(std::memory_order_acquire) & Status::FADING_OUT) != 0;
 }
 
 /**
@@ -310,24 +312,18 @@ void AudioFader::fadePause(double duration) {
  * @param fadein   The fade-in time in seconds
  */
 void AudioFader::fadePause(double fadeout, double fadein) {
-    std::lock_guard<std::mutex> lock(_mutex);
-
     // Do not pause twice
-    if (_dipmark >= 0) {
+    if (_status.load(std::memory_order_acquire) & Status::DIPPING) {
         return;
     }
     
     // Now pause
     if (fadein < 0 || fadeout < 0) {
-        _dipmark = -1;
-        _fadedip = 0;
-        _dipstop = 0;
-    } else {
-        _dipmark = (Sint64)(fadeout*getRate());
-        _dipstop = (Uint64)(fadein*getRate());
-        _fadedip = 0;
+        post(CommandType::FADE_DIP,-1,-1);
+    } else if (post(CommandType::FADE_DIP,(Sint64)(fadeout*getRate()),(Sint64)(fadein*getRate()))) {
+        _status.fetch_and(~(Uint32)Status::DIP_HALF,std::memory_order_release);
+        _status.fetch_or(Status::DIPPING,std::memory_order_release);
     }
-    _diphalf = false;
 }
 
 /**
@@ -339,8 +335,7 @@ void AudioFader::fadePause(double fadeout, double fadein) {
  * @return true if this node is in an active fade-pause.
  */
 bool AudioFader::isFadePause() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _dipmark >= 0;
+    return (_status.load(std::memory_order_acquire) & Status::DIPPING) != 0;
 }
 
 /**
@@ -366,12 +361,12 @@ Uint32 AudioFader::doFadeIn(float* buffer, Uint32 frames) {
     if (_inmark >= 0) {
         Uint32 left = std::min(frames,(Uint32)(_inmark-_fadein));
         float start = (float)_fadein/(float)_inmark;
-        float ends  = (float)(left+_fadein)/(float)_inmark;
-        dsp::DSPMath::slide(buffer,start,ends,buffer,left*_channels);
+        dsp::DSPMath::ramp(buffer,start,1.0f/_inmark,_channels,buffer,left);
         _fadein += left;
-        if (_fadein >= _inmark) {
+        if (_fadein >= (Uint64)_inmark) {
             _inmark = -1;
             _fadein = 0;
+            _status.fetch_and(~(Uint32)Status::FADING_IN,std::memory_order_release);
             if (_calling.load(std::memory_order_relaxed)) {
                 notify(shared_from_this(),Action::FADE_IN);
             }
@@ -404,14 +399,15 @@ Uint32 AudioFader::doFadeOut(float* buffer, Uint32 frames) {
     if (_outmark >= 0) {
         Sint32 left = std::max(std::min(amt,(Sint32)(_outmark-_fadeout)),0);
         float start = (float)(_outmark-_fadeout)/(float)_outmark;
-        float ends  = (float)(_outmark-left-_fadeout)/(float)_outmark;
-        dsp::DSPMath::slide(buffer,start,ends,buffer,left*_channels);
+        dsp::DSPMath::ramp(buffer,start,-1.0f/_outmark,_channels,buffer,left);
         _fadeout += left;
-        if (_fadeout >= _outmark) {
+        if (_fadeout >= (Uint64)_outmark) {
             _outmark = -1;
             _fadeout = 0;
             _outkeep = false;
             _outdone = true;
+            _status.fetch_and(~(Uint32)(Status::FADING_OUT | Status::OUT_KEEP),std::memory_order_release);
+            _status.fetch_or(Status::OUT_DONE,std::memory_order_release);
             if (_calling.load(std::memory_order_relaxed)) {
                 notify(shared_from_this(),Action::FADE_OUT);
             }
@@ -449,27 +445,41 @@ Uint32 AudioFader::doFadePause(float* buffer, Uint32 frames) {
         if (_diphalf) {
             Uint32 left = std::min(amt,(Uint32)std::max((Sint32)(_dipmark+_dipstop-_fadedip),(Sint32)0));
             float start = (float)(_fadedip-_dipmark)/(float)_dipstop;
-            float ends  = (float)(left+_fadedip-_dipmark)/(float)_dipstop;
-            dsp::DSPMath::slide(buffer,start,ends,buffer,left*_channels);
+            dsp::DSPMath::ramp(buffer,start,1.0f/_dipstop,_channels,buffer,left);
             _fadedip += left;
             if (_fadedip >= _dipmark+_dipstop) {
                 _dipmark = -1;
                 _dipstop = 0;
                 _fadedip = 0;
                 _diphalf = false;
+                _status.fetch_and(~(Uint32)(Status::DIPPING | Status::DIP_HALF),std::memory_order_release);
             }
         } else {
             Uint32 left = std::min(amt,(Uint32)std::max((Sint32)(_dipmark-_fadedip),(Sint32)0));
             float start = (float)(_dipmark-_fadedip)/(float)_dipmark;
-            float ends  = (float)(_dipmark-left-_fadedip)/(float)_dipmark;
-            dsp::DSPMath::slide(buffer,start,ends,buffer,left*_channels);
+            dsp::DSPMath::ramp(buffer,start,-1.0f/_dipmark,_channels,buffer,left);
             _fadedip += left;
-            if (_fadedip >= _dipmark) {
-                _paused.store(true,std::memory_order_relaxed);
+            if (_fadedip >= (Uint64)_dipmark) {
                 std::memset(buffer+left*_channels,0,(amt-left)*_channels*sizeof(float));
-                _diphalf = true;
-                if (_calling.load(std::memory_order_relaxed)) {
-                    notify(shared_from_this(),Action::FADE_DIP);
+                
+                // The main thread may have resumed during this read
+                Uint32 status = _status.load(std::memory_order_acquire);
+                bool halfway = false;
+                while (!halfway && (status & Status::DIPPING)) {
+                    halfway = _status.compare_exchange_weak(status,status | Status::DIP_HALF,
+                                                            std::memory_order_acq_rel);
+                }
+                
+                if (halfway) {
+                    _paused.store(true,std::memory_order_relaxed);
+                    _diphalf = true;
+                    if (_calling.load(std::memory_order_relaxed)) {
+                        notify(shared_from_this(),Action::FADE_DIP);
+                    }
+                } else {
+                    _dipmark = -1;
+                    _dipstop = 0;
+                    _fadedip = 0;
                 }
             }
         }
@@ -477,6 +487,149 @@ Uint32 AudioFader::doFadePause(float* buffer, Uint32 frames) {
     return amt;
 }
 
+/**
+ * Posts a command to the audio thread.
+ *
+ * This method returns false if the command queue is full.
+ *
+ * @param type      The command type
+ * @param first     The first duration in frames (-1 to cancel)
+ * @param second    The second duration in frames (fade-dip only)
+ * @param flag      The command flag
+ *
+ * @return true if the command was posted
+ */
+bool AudioFader::post(CommandType type, Sint64 first, Sint64 second, bool flag) {
+    Uint32 tail = _cmdtail.load(std::memory_order_relaxed);
+    if (tail-_cmdhead.load(std::memory_order_acquire) >= COMMAND_CAPACITY) {
+        CULogError("AudioFader command queue is full");
+        return false;
+    }
+    
+    Command& command = _commands[tail % COMMAND_CAPACITY];
+    command.type   = type;
+    command.first  = first;
+    command.second = second;
+    command.flag   = flag;
+    _cmdtail.store(tail+1,std::memory_order_release);
+    return true;
+}
+
+/**
+ * Applies all commands posted since the last read.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * The only exception is when the user needs to create a custom subclass
+ * of this AudioNode.
+ */
+void AudioFader::apply() {
+    Uint32 head = _cmdhead.load(std::memory_order_relaxed);
+    Uint32 tail = _cmdtail.load(std::memory_order_acquire);
+    while (head != tail) {
+        const Command& command = _commands[head % COMMAND_CAPACITY];
+        switch (command.type) {
+            case CommandType::FADE_IN:
+                _inmark = command.first;
+                _fadein = 0;
+                if (_inmark >= 0) {
+                    _status.fetch_or(Status::FADING_IN,std::memory_order_release);
+                } else {
+                    _status.fetch_and(~(Uint32)Status::FADING_IN,std::memory_order_release);
+                }
+                break;
+            case CommandType::FADE_OUT:
+            {
+                _outmark = command.first;
+                _fadeout = 0;
+                _outkeep = command.flag;
+                _outdone = false;
+                Uint32 flags = (_outmark >= 0 ? (Uint32)Status::FADING_OUT : 0) | (_outkeep ? (Uint32)Status::OUT_KEEP : 0);
+                _status.fetch_and(~(Uint32)(Status::FADING_OUT | Status::OUT_DONE | Status::OUT_KEEP),
+                                  std::memory_order_release);
+                _status.fetch_or(flags,std::memory_order_release);
+            }
+                break;
+            case CommandType::FADE_DIP:
+                if (_dipmark >= 0) {
+                    // Do not pause twice
+                    break;
+                } else if (command.first < 0 || command.second < 0) {
+                    _dipmark = -1;
+                    _fadedip = 0;
+                    _dipstop = 0;
+                } else {
+                    _dipmark = command.first;
+                    _dipstop = command.second;
+                    _fadedip = 0;
+                }
+                _diphalf = false;
+                break;
+            case CommandType::RESUME:
+                if (_dipmark >= 0 && !_diphalf) {
+                    _dipmark = -1;
+                    _fadedip = 0;
+                    _dipstop = 0;
+                }
+                break;
+            case CommandType::CLEAR:
+                cancel(command.flag);
+                break;
+        }
+        head++;
+    }
+    _cmdhead.store(head,std::memory_order_release);
+}
+
+/**
+ * Cancels all active fades.
+ *
+ * The fade-out is not cancelled if keep is true and the fade-out was
+ * created with the wrap option.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * The only exception is when the user needs to create a custom subclass
+ * of this AudioNode.
+ *
+ * @param keep  Whether to keep a wrapped fade-out
+ */
+void AudioFader::cancel(bool keep) {
+    _inmark = -1;
+    _fadein = 0;
+    if (!keep || !_outkeep) {
+        _outmark = -1;
+        _fadeout = 0;
+        _outkeep = false;
+    }
+    _outdone = false;
+    _dipmark = -1;
+    _fadedip = 0;
+    _dipstop = 0;
+    _diphalf = false;
+    
+    Uint32 flags = Status::FADING_IN | Status::DIPPING | Status::DIP_HALF | Status::OUT_DONE;
+    if (_outmark < 0) {
+        flags |= Status::FADING_OUT | Status::OUT_KEEP;
+    }
+    _status.fetch_and(~flags,std::memory_order_release);
+}
+
+/**
+ * Cancels all active fades from the main thread.
+ *
+ * This method posts a command for {@link cancel} and updates the fade
+ * state flags immediately.
+ *
+ * @param keep  Whether to keep a wrapped fade-out
+ */
+void AudioFader::interrupt(bool keep) {
+    post(CommandType::CLEAR,-1,0,keep);
+    Uint32 flags = Status::FADING_IN | Status::DIPPING | Status::DIP_HALF | Status::OUT_DONE;
+    if (!keep || !(_status.load(std::memory_order_acquire) & Status::OUT_KEEP)) {
+        flags |= Status::FADING_OUT | Status::OUT_KEEP;
+    }
+    _status.fetch_and(~flags,std::memory_order_release);
+}
+
 
 #pragma mark -
 #pragma mark Overriden Methods
@@ -486,8 +639,9 @@ Uint32 AudioFader::doFadePause(float* buffer, Uint32 frames) {
  * @return true if this node is currently paused
  */
 bool AudioFader::isPaused() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _paused.load(std::memory_order_relaxed) || (_dipmark >= 0 && !_diphalf);
+    Uint32 status = _status.load(std::memory_order_acquire);
+    return (_paused.load(std::memory_order_relaxed) ||
+            ((status & Status::DIPPING) && !(status & Status::DIP_HALF)));
 }
 
 /**
@@ -499,8 +653,8 @@ bool AudioFader::isPaused() {
  * @return true if the node was successfully paused
  */
 bool AudioFader::pause() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_dipmark < 0 || _diphalf) {
+    Uint32 status = _status.load(std::memory_order_acquire);
+    if (!(status & Status::DIPPING) || (status & Status::DIP_HALF)) {
         return !_paused.exchange(true);
     }
     return false;
@@ -514,13 +668,15 @@ bool AudioFader::pause() {
  * @return true if the node was successfully resumed
  */
 bool AudioFader::resume() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_dipmark >= 0 && !_diphalf) {
-        _dipmark = -1;
-        _fadedip = 0;
-        _dipstart = 0;
-        _paused.store(false,std::memory_order_relaxed);
-        return true;
+    // Cancel the first half of a fade-dip, unless the audio thread finishes first
+    Uint32 status = _status.load(std::memory_order_acquire);
+    while ((status & Status::DIPPING) && !(status & Status::DIP_HALF)) {
+        if (_status.compare_exchange_weak(status,status & ~(Uint32)Status::DIPPING,
+                                          std::memory_order_acq_rel)) {
+            post(CommandType::RESUME,-1);
+            _paused.store(false,std::memory_order_relaxed);
+            return true;
+        }
     }
     return _paused.exchange(false);
 }
@@ -544,23 +700,21 @@ bool AudioFader::resume() {
  * @return the actual number of frames read
  */
 Uint32 AudioFader::read(float* buffer, Uint32 frames) {
+    apply();
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*_channels*sizeof(float));
         return frames;
-    } else {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (!_outdone) {
-            Uint32 amt = input->read(buffer, frames);
-            float gain = _ndgain.load(std::memory_order_relaxed);
-            if (gain != 1) {
-                dsp::DSPMath::scale(buffer,gain,buffer,amt*_channels);
-            }
-            amt = doFadeIn(buffer,amt);
-            amt = doFadeOut(buffer,amt);
-            amt = doFadePause(buffer,amt);
-            return amt;
+    } else if (!_outdone) {
+        Uint32 amt = input->read(buffer, frames);
+        float gain = _ndgain.load(std::memory_order_relaxed);
+        if (gain != 1) {
+            dsp::DSPMath::scale(buffer,gain,buffer,amt*_channels);
         }
+        amt = doFadeIn(buffer,amt);
+        amt = doFadeOut(buffer,amt);
+        amt = doFadePause(buffer,amt);
+        return amt;
     }
     return 0;
 }
@@ -574,11 +728,7 @@ Uint32 AudioFader::read(float* buffer, Uint32 frames) {
  * @return true if this audio node has no more data.
  */
 bool AudioFader::completed() {
-    bool outdone = false;
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        outdone = _outdone;
-    }
+    bool outdone = (_status.load(std::memory_order_acquire) & Status::OUT_DONE) != 0;
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     return (input == nullptr || input->completed() || outdone);
 }
@@ -626,26 +776,7 @@ bool AudioFader::unmark() {
  * @return true if the read position was moved.
  */
 bool AudioFader::reset() {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            if (!_outkeep) {
-                _outmark = -1;
-                _fadeout = 0;
-            }
-        }
-        _outdone = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
+    interrupt(true);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input) {
         return input->reset();
@@ -666,25 +797,7 @@ bool AudioFader::reset() {
  * @return the actual number of frames advanced; -1 if not supported
  */
 Sint64 AudioFader::advance(Uint32 frames) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
+    interrupt(false);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input) {
         return input->advance(frames);
@@ -721,25 +834,7 @@ Sint64 AudioFader::getPosition() const {
  * @return the new frame position of this audio node.
  */
 Sint64 AudioFader::setPosition(Uint32 position)  {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
+    interrupt(false);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input) {
         return input->setPosition(position);
@@ -776,25 +871,7 @@ double AudioFader::getElapsed() const {
  * @return the new elapsed time in seconds.
  */
 double AudioFader::setElapsed(double time) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
+    interrupt(false);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input) {
         return input->setElapsed(time);
@@ -835,25 +912,7 @@ double AudioFader::getRemaining() const  {
  * @return the new remaining time in seconds.
  */
 double AudioFader::setRemaining(double time) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
+    interrupt(false);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     if (input) {
         return input->setRemaining(time);
@@ -35,9 +35,13 @@
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/util/CUDebug.h>
 #include <cmath>
+#include <cstring>
 
 using namespace cugl::audio;
 
+/** The bit marking the shared panning matrix as unread */
+#define MATRIX_DIRTY 4
+
 /**
  * Creates a degenerate audio panner
  *
@@ -49,7 +53,10 @@ using namespace cugl::audio;
  */
 AudioPanner::AudioPanner() : AudioNode(),
 _field(0),
-_mapper(nullptr) {
+_matrix(nullptr),
+_shared(2),
+_back(1),
+_front(3) {
     _input = nullptr;
     _classname = "AudioPanner";
 }
@@ -119,7 +126,8 @@ bool AudioPanner::init(Uint8 channels, Uint8 field, Uint32 rate) {
 void AudioPanner::dispose() {
     if (_booted) {
         AudioNode::dispose();
-        delete[] _mapper;
+        free(_matrix);
+        _matrix = nullptr;
         free(_buffer);
         _buffer = nullptr;
         _capacity = 0;
@@ -196,17 +204,21 @@ bool AudioPanner::setField(Uint8 field) {
         return false;
     }
     
+    size_t size = (size_t)field*_channels;
+    free(_matrix);
     _field  = field;
-    _mapper = new std::atomic<float>[field*_channels];
+    _matrix = (float*)malloc(std::max(4*size,(size_t)1)*sizeof(float));
     for(int ii = 0; ii < field; ii++) {
         for(int jj = 0; jj < _channels; jj++) {
-            if (ii == jj) {
-                _mapper[ii*_channels+jj] = 1;
-            } else {
-                _mapper[ii*_channels+jj] = 0;
-            }
+            _matrix[ii*_channels+jj] = (ii == jj ? 1 : 0);
         }
     }
+    for(int ii = 1; ii < 4; ii++) {
+        std::memcpy(_matrix+ii*size,_matrix,size*sizeof(float));
+    }
+    _back  = 1;
+    _front = 3;
+    _shared.store(2,std::memory_order_release);
     return true;
 }
 
@@ -220,7 +232,7 @@ bool AudioPanner::setField(Uint8 field) {
  * @return the matrix pan value for input field and output channel.
  */
 float AudioPanner::getPan(Uint32 field, Uint32 channel) const {
-    return _mapper[field*_channels+channel].load(std::memory_order_relaxed);
+    return _matrix[field*_channels+channel];
 }
 
 
@@ -231,6 +243,9 @@ float AudioPanner::getPan(Uint32 field, Uint32 channel) const {
  * that is sent to the given output channel.  Technically, this value
  * can be more than 1, but it cannot be negative.
  *
+ * The change is copied to a fresh matrix and published to the audio
+ * thread, which uses it at the start of its next read.
+ *
  * @param field     The input channel
  * @param channel   The output channel
  * @param value     The percentage gain
@@ -238,7 +253,10 @@ float AudioPanner::getPan(Uint32 field, Uint32 channel) const {
 void AudioPanner::setPan(Uint32 field, Uint32 channel, float value) {
     CUAssertLog(field < _field, "Field %d is out of range",field);
     CUAssertLog(channel < _channels, "Channel %d is out of range",channel);
-    _mapper[field*_channels+channel].store(value,std::memory_order_relaxed);
+    size_t size = (size_t)_field*_channels;
+    _matrix[field*_channels+channel] = value;
+    std::memcpy(_matrix+_back*size,_matrix,size*sizeof(float));
+    _back = _shared.exchange(_back | MATRIX_DIRTY,std::memory_order_acq_rel) & ~MATRIX_DIRTY;
 }
 
 
@@ -282,12 +300,18 @@ Uint32 AudioPanner::read(float* buffer, Uint32 frames) {
     if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*_channels*sizeof(float));
     } else {
+        // Pick up the latest matrix for this read
+        if (_shared.load(std::memory_order_relaxed) & MATRIX_DIRTY) {
+            _front = _shared.exchange(_front,std::memory_order_acq_rel) & ~MATRIX_DIRTY;
+        }
+        const float* matrix = _matrix+_front*_field*_channels;
+        
         frames = std::min(frames,_capacity);
         std::memset(buffer,0,frames*_channels*sizeof(float));
         Uint32 amt = input->read(_buffer, frames);
         for(int ii = 0; ii < _field; ii++) {
             for(int jj = 0; jj < _channels; jj++) {
-                float percent =  _mapper[ii*_channels+jj].load(std::memory_order_relaxed);
+                float percent = matrix[ii*_channels+jj];
                 if (percent > 0) {
                     float* output = buffer+jj;
                     float* input  = _buffer+ii;
@@ -41,14 +41,28 @@
 using namespace cugl::audio;
 
 #pragma mark Player Queue
+/** The number of removed entries retained for the consumer */
+#define QUEUE_RETAINED  2
+
 /**
- * Creates an empty player queue
+ * Creates an empty player queue with the given capacity
+ *
+ * The capacity is rounded up to the nearest power of two.  All of the
+ * memory for the queue is allocated at this time.
+ *
+ * @param capacity  The maximum number of entries in the queue
  */
-AudioNodeQueue::AudioNodeQueue() {
-    // Add dummy separator
-    _first = new Entry(std::shared_ptr<AudioNode>(),0);
-    _divide.store(_first, std::memory_order_relaxed);
-    _last.store(_first, std::memory_order_relaxed);
+AudioNodeQueue::AudioNodeQueue(Uint32 capacity) :
+_head(0),
+_tail(0),
+_purge(0),
+_reclaim(0) {
+    Uint32 size = 4;
+    while (size < capacity+QUEUE_RETAINED) {
+        size <<= 1;
+    }
+    _entries.resize(size);
+    _mask = size-1;
 }
 
 
@@ -56,11 +70,34 @@ AudioNodeQueue::AudioNodeQueue() {
  * Disposes of the player queue, releasing all resources
  */
 AudioNodeQueue::~AudioNodeQueue() {
-    while( _first != nullptr ) {
-        Entry* tmp = _first;
-        _first = tmp->next;
-        delete tmp;
-    }
+    _entries.clear();
+}
+
+/**
+ * Returns the index of the front of the queue, applying any purge.
+ *
+ * This is a consumer method.
+ *
+ * @return the index of the front of the queue, applying any purge.
+ */
+Uint32 AudioNodeQueue::front() const {
+    Uint32 head  = _head.load(std::memory_order_relaxed);
+    Uint32 purge = _purge.load(std::memory_order_acquire);
+    return ((Sint32)(purge-head) > 0) ? purge : head;
+}
+
+/**
+ * Returns the number of entries in this queue.
+ *
+ * This method is atomic and thread-safe.  However, the value is only a
+ * snapshot, and may be out of date if the other thread is active.
+ *
+ * @return the number of entries in this queue.
+ */
+Uint32 AudioNodeQueue::size() const {
+    Uint32 tail = _tail.load(std::memory_order_acquire);
+    Uint32 head = front();
+    return ((Sint32)(tail-head) > 0) ? tail-head : 0;
 }
 
 /**
@@ -71,24 +108,38 @@ AudioNodeQueue::~AudioNodeQueue() {
  * (additional) times.  If it is negative, the audio node will be
  * looped indefinitely until it is stopped.
  *
- * This method is thread-safe
+ * The start value is the frame at which the consumer should start the
+ * audio node.  It is -1 if the audio node should start as soon as the
+ * previous one has completed.
+ *
+ * This method is thread-safe, but it is a producer method.  It returns
+ * false if the queue is full.
  *
  * @param node  The node to be scheduled
- * @param loop  The number of times to loop the audio
+ * @param loops The number of times to loop the audio
+ * @param start The frame at which to start the audio
+ *
+ * @return true if the entry was added
  */
-void AudioNodeQueue::push(const std::shared_ptr<AudioNode>& node, Sint32 loops) {
-    Entry* last = _last.load(std::memory_order_relaxed);
-    
-    // Add the new item
-    last->next = new Entry(node,loops);
-    _last.store(last->next, std::memory_order_relaxed);
+bool AudioNodeQueue::push(const std::shared_ptr<AudioNode>& node, Sint32 loops, Sint64 start) {
+    // Release entries the consumer is done with
+    Uint32 head = _head.load(std::memory_order_acquire);
+    while ((Sint32)(head-_reclaim) > QUEUE_RETAINED) {
+        _entries[_reclaim & _mask].value = nullptr;
+        _reclaim++;
+    }
     
-    // Trim unused nodes
-    while( _first != _divide) {
-        Entry* tmp = _first;
-        _first = _first->next;
-        delete tmp;
+    Uint32 tail = _tail.load(std::memory_order_relaxed);
+    if (tail-_reclaim > _mask) {
+        return false;
     }
+    
+    Entry& entry = _entries[tail & _mask];
+    entry.value = node;
+    entry.loops = loops;
+    entry.start = start;
+    _tail.store(tail+1, std::memory_order_release);
+    return true;
 }
 
 /**
@@ -98,7 +149,7 @@ void AudioNodeQueue::push(const std::shared_ptr<AudioNode>& node, Sint32 loops)
  * is nothing to remove, the pointer will store null and the method will
  * return false.
  *
- * This method is thread-safe
+ * This method is thread-safe, but it is a consumer method.
  *
  * @param node  the pointer to store the audio node
  * @param loop  the pointer to store the number of loops
@@ -106,11 +157,33 @@ void AudioNodeQueue::push(const std::shared_ptr<AudioNode>& node, Sint32 loops)
  * @return true if the operation was successful
  */
 bool AudioNodeQueue::pop(std::shared_ptr<AudioNode>& node, Sint32& loop) {
-    if ( _divide != _last ) {
-        Entry* div = _divide.load(std::memory_order_relaxed);
-        node = div->next->value;
-        loop = div->next->loops;
-        _divide.store(div->next, std::memory_order_relaxed);
+    Entry entry;
+    if (pop(entry)) {
+        node = entry.value;
+        loop = entry.loops;
+        return true;
+    }
+    node = nullptr;
+    return false;
+}
+
+/**
+ * Removes an entry from the front of this queue.
+ *
+ * The element will be copied into the given entry.  If there is nothing
+ * to remove, the entry is not altered and the method will return false.
+ *
+ * This method is thread-safe, but it is a consumer method.
+ *
+ * @param entry the entry to store the result
+ *
+ * @return true if the operation was successful
+ */
+bool AudioNodeQueue::pop(Entry& entry) {
+    Uint32 head = front();
+    if (head != _tail.load(std::memory_order_acquire)) {
+        entry = _entries[head & _mask];
+        _head.store(head+1, std::memory_order_release);
         return true;
     }
     return false;
@@ -123,7 +196,7 @@ bool AudioNodeQueue::pop(std::shared_ptr<AudioNode>& node, Sint32& loop) {
  * is nothing to see, the pointer will store null and the method will
  * return false.
  *
- * This method is thread-safe
+ * This method is thread-safe, but it is a consumer method.
  *
  * @param node  the pointer to store the audio node
  * @param loop  the pointer to store the number of loops
@@ -131,13 +204,35 @@ bool AudioNodeQueue::pop(std::shared_ptr<AudioNode>& node, Sint32& loop) {
  * @return true if the operation was successful
  */
 bool AudioNodeQueue::peek(std::shared_ptr<AudioNode>& node, Sint32& loop) const {
-    if ( _divide != _last ) {
-        Entry* div = _divide.load(std::memory_order_relaxed);
-        node = div->next->value;
-        loop = div->next->loops;
+    Entry entry;
+    if (peek(entry)) {
+        node = entry.value;
+        loop = entry.loops;
         return true;
     }
-    return false;    
+    node = nullptr;
+    return false;
+}
+
+/**
+ * Looks at the front element this queue.
+ *
+ * The element will be copied into the given entry.  If there is nothing
+ * to see, the entry is not altered and the method will return false.
+ *
+ * This method is thread-safe, but it is a consumer method.
+ *
+ * @param entry the entry to store the result
+ *
+ * @return true if the operation was successful
+ */
+bool AudioNodeQueue::peek(Entry& entry) const {
+    Uint32 head = front();
+    if (head != _tail.load(std::memory_order_acquire)) {
+        entry = _entries[head & _mask];
+        return true;
+    }
+    return false;
 }
 
 /**
@@ -146,35 +241,39 @@ bool AudioNodeQueue::peek(std::shared_ptr<AudioNode>& node, Sint32& loop) const
  * This method only stores the values, not the loop settings. If the queue is
  * empty, the deque is not altered and this method returns false.
  *
- * This method is thread-safe ASSUMING that {@link push} is only ever called in
- * the same thread (e.g. this is a producer method).
+ * This method is thread-safe, but it is a producer method.
  *
  * @param container the container to store the values
  *
  * @return true if the operation was successful
  */
 bool AudioNodeQueue::fill(std::deque<std::shared_ptr<AudioNode>>& container) const {
-    if ( _divide != _last ) {
-        Entry* div = _divide.load(std::memory_order_relaxed);
-        while (div->next) {
-            div = div->next;
-            container.push_back(div->value);
-        }
-        return true;
+    Uint32 head = front();
+    Uint32 tail = _tail.load(std::memory_order_relaxed);
+    if ((Sint32)(tail-head) <= 0) {
+        return false;
     }
-    return false;
+    for(Uint32 ii = head; ii != tail; ii++) {
+        container.push_back(_entries[ii & _mask].value);
+    }
+    return true;
 }
 
 /**
- * Clears all elements in this queue.
+ * Removes all but the last size elements of this queue.
  *
- * This method is thread-safe
+ * The removed elements are only flagged.  They are skipped by the next
+ * consumer method, and released by a later call to {@link push}.
+ *
+ * This method is thread-safe, but it is a producer method.
+ *
+ * @param size  The number of elements to keep
  */
-void AudioNodeQueue::clear() {
-    // Defer clean up to push
-    while ( _divide != _last ) {
-        Entry* div = _divide.load(std::memory_order_relaxed);
-        _divide.store(div->next, std::memory_order_relaxed);
+void AudioNodeQueue::trim(Uint32 size) {
+    Uint32 tail = _tail.load(std::memory_order_relaxed);
+    Uint32 head = front();
+    if ((Sint32)(tail-head) > (Sint32)size) {
+        _purge.store(tail-size, std::memory_order_release);
     }
 }
 
@@ -188,11 +287,19 @@ void AudioNodeQueue::clear() {
  */
 AudioScheduler::AudioScheduler() : AudioNode(),
 _previous(nullptr),
-_buffer(nullptr),
 _loops(0),
-_qsize(0),
-_qskip(0),
 _overlap(0),
+_buffer(nullptr),
+_bufsize(0),
+_fade(0),
+_fadelen(0),
+_fadeact(Action::COMPLETE),
+_qskip(0),
+_clock(0),
+_command(0),
+_marked(false),
+_markclock(0),
+_memsize(0),
 _mempos(-1) {
     _classname = "AudioScheduler";
 }
@@ -218,8 +325,9 @@ AudioScheduler::~AudioScheduler() {
  */
 bool AudioScheduler::init() {
     if (AudioNode::init()) {
-        Uint32 size   = AudioDevices::get()->getReadSize();
-        _buffer  = (float*)malloc(size*_channels*sizeof(float));
+        _bufsize = AudioDevices::get()->getReadSize();
+        _buffer  = (float*)malloc(_bufsize*_channels*sizeof(float));
+        _memory.resize(MEMORY_CAPACITY);
         return true;
     }
     return false;
@@ -239,8 +347,9 @@ bool AudioScheduler::init() {
  */
 bool AudioScheduler::init(Uint8 channels, Uint32 rate) {
     if (AudioNode::init(channels,rate)) {
-        Uint32 size   = AudioDevices::get()->getReadSize();
-        _buffer  = (float*)malloc(size*channels*sizeof(float));
+        _bufsize = AudioDevices::get()->getReadSize();
+        _buffer  = (float*)malloc(_bufsize*channels*sizeof(float));
+        _memory.resize(MEMORY_CAPACITY);
         return true;
     }
     return false;
@@ -262,11 +371,18 @@ void AudioScheduler::dispose() {
         }
         AudioNode::dispose();
         _memory.clear();
+        _memsize = 0;
+        _mempos = -1;
         _loops = 0;
-        _qsize = 0;
         _qskip = 0;
         _overlap = 0;
-        _mempos = 0;
+        _bufsize = 0;
+        _fade = 0;
+        _fadelen = 0;
+        _clock = 0;
+        _command = 0;
+        _marked = false;
+        _markclock = 0;
         _current  = nullptr;
         _previous = nullptr;
     }
@@ -308,10 +424,11 @@ void AudioScheduler::play(const std::shared_ptr<AudioNode>& node, Sint32 loop) {
                      node->getRate());
         return;
     }
-    _queue.push(node,loop);
-    _qsize.exchange(_qsize.load(std::memory_order_relaxed)+1,std::memory_order_release);
-    _qskip.store(_qsize.load(std::memory_order_relaxed),std::memory_order_release);
-
+    if (!_queue.push(node,loop)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "AudioScheduler queue is full");
+        return;
+    }
+    _qskip.store(_queue.size(),std::memory_order_release);
 }
 
 /**
@@ -347,8 +464,72 @@ void AudioScheduler::append(const std::shared_ptr<AudioNode>& node, Sint32 loop)
         return;
     }
     
-    _queue.push(node,loop);
-    _qsize.store(_qsize.load(std::memory_order_relaxed)+1,std::memory_order_release);
+    if (!_queue.push(node,loop)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "AudioScheduler queue is full");
+    }
+}
+
+/**
+ * Schedules a new audio node to start at the given frame.
+ *
+ * This method appends to the node to the playback queue.  Unlike
+ * {@link #append}, the node does not start when the previous node has
+ * completed.  Instead, it starts on exactly the given frame of the
+ * scheduler clock (see {@link #getClock}).  If the previous node
+ * completes early, the scheduler is silent until that frame.  If the
+ * previous node is still playing, it is interrupted, cross-fading with
+ * the new node over the {@link #getOverlap} time.
+ *
+ * Scheduled nodes must be added in increasing order of their start
+ * frame.  A node scheduled for a frame that has already passed starts
+ * immediately once it reaches the front of the queue.
+ *
+ * The loop value is an integer.  If it is 0, the audio node will not
+ * be looped.  If it is positive, it will loop the audio that many
+ * (additional) times.  If it is negative, the audio node will be
+ * looped indefinitely until it is stopped or the next node starts.
+ *
+ * If the user has provided an optional callback function, this will be
+ * called when the node is removed, either because it completed (defined
+ * by {@link AudioNode#completed()}) or is interrupted.
+ *
+ * @param node  The audio node for playback
+ * @param frame The clock frame at which to start the node
+ * @param loop  The number of times to loop the audio
+ */
+void AudioScheduler::schedule(const std::shared_ptr<AudioNode>& node, Uint64 frame, Sint32 loop) {
+    if (node->getChannels() != _channels) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,
+                     "AudioNode has the wrong number of channels: %d",
+                     node->getChannels());
+        return;
+    } else if (node->getRate() != _sampling) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR,
+                     "AudioNode has the wrong frequency: %d",
+                     node->getRate());
+        return;
+    }
+    
+    if (!_queue.push(node,loop,(Sint64)frame)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "AudioScheduler queue is full");
+    }
+}
+
+/**
+ * Returns the current frame of the scheduler clock.
+ *
+ * The clock is the number of frames read from this scheduler since it
+ * was initialized.  It does not advance while the scheduler is paused,
+ * and it returns to the marked frame on a call to {@link #reset}.  It is
+ * the time line for {@link #schedule}.
+ *
+ * This method is thread safe, but the value may be out of date by as
+ * much as one read buffer.
+ *
+ * @return the current frame of the scheduler clock.
+ */
+Uint64 AudioScheduler::getClock() const {
+    return (Uint64)_clock.load(std::memory_order_acquire);
 }
 
 /**
@@ -382,11 +563,13 @@ std::shared_ptr<AudioNode> AudioScheduler::getCurrent() const {
  */
 void AudioScheduler::clear(bool force) {
     if (!force) {
-        _qskip.store(_qsize.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+        _qskip.store(_queue.size()+1,std::memory_order_relaxed);
     } else {
         bool orig = _paused.exchange(true,std::memory_order_relaxed);
         _queue.clear();
-        _current = nullptr;
+        _current  = nullptr;
+        _previous = nullptr;
+        _fade = 0;
         _paused.store(orig, std::memory_order_relaxed);
     }
 }
@@ -413,7 +596,7 @@ std::deque<std::shared_ptr<AudioNode>> AudioScheduler::getTail() const {
  * @return the number audio nodes waiting to be played.
  */
 Uint32 AudioScheduler::getTailSize() const {
-    return _qsize.load(std::memory_order_relaxed);
+    return _queue.size();
 }
 
 
@@ -438,22 +621,13 @@ void AudioScheduler::skip(Uint32 n) {
  * Empties the queue without stopping the current playback.
  *
  * This method is useful when we want to clear the queue, but to smoothly
- * fade-out the current playback.
+ * fade-out the current playback.  If size is non-negative, this method
+ * only removes the oldest entries, keeping the last size entries.
+ *
+ * @param size    The number of entries to keep (-1 for none)
  */
 void AudioScheduler::trim(Sint32 size) {
-    if (size < 0) {
-        _queue.clear();
-    } else {
-        Uint32 qsize = _qsize.load(std::memory_order_relaxed);
-        Sint32 actly = (Sint32)qsize-size;
-        actly = std::max(actly,0);
-        actly = _qsize.exchange(actly,std::memory_order_relaxed);
-        size -= (qsize-actly);
-        std::shared_ptr<AudioNode> result;
-        while(size--) {
-            _queue.pop(result,actly);
-        }
-    }
+    _queue.trim(size < 0 ? 0 : (Uint32)size);
 }
 
 /**
@@ -487,7 +661,6 @@ bool AudioScheduler::isPlaying() {
  * @param time  The overlap time in seconds.
  */
 void AudioScheduler::setOverlap(double time) {
-    _previous = nullptr;
     _overlap.store((Uint32)(time*_sampling),std::memory_order_release);
 }
 
@@ -577,87 +750,98 @@ Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
     Uint32 skip = _qskip.exchange(0);
     
     Sint32 loop;
-    std::shared_ptr<AudioNode> previous = _previous;
-    std::shared_ptr<AudioNode> current  = acquire(loop,skip,Action::INTERRUPT);
+    std::shared_ptr<AudioNode> current = acquire(loop,skip,Action::INTERRUPT);
+    command(current,loop);
     Uint32 overlap = _overlap.load(std::memory_order_acquire);
+    Sint64 clock = _clock.load(std::memory_order_relaxed);
+    bool looped = false;
     
     Uint32 amt = 0;
-    while (amt < frames && current != nullptr) {
+    while (amt < frames) {
+        Sint64 now = clock+amt;
+        Sint64 start = -1;
+        bool queued = pending(start);
+        if (queued && start >= 0 && start <= now) {
+            // Start a scheduled node on its frame
+            cue(current,loop,overlap);
+            looped = false;
+            continue;
+        }
+        
+        // Never read past the next scheduled node
         Uint32 need = frames-amt;
-        if (previous && current && overlap > 0) {
+        if (queued && start >= 0) {
+            need = (Uint32)std::min((Sint64)need,start-now);
+        }
+        
+        float* output = buffer+amt*_channels;
+        if (_fade > 0) {
             // Continue an existing overlap
-            float* output = buffer+amt*_channels;
-            float* input  = _buffer;
-            
-            Sint64 remain = previous->getRemaining()*_sampling;
-            Uint32 goal = std::min((Uint32)std::max(remain,(Sint64)0),need);
-            Uint32 real = current->read(output,goal);
-            goal = previous->read(input,real);
-            if (goal < real) {
+            Uint32 goal = std::min(std::min(need,_fade),_bufsize);
+            Uint32 real = current ? current->read(output,goal) : 0;
+            if (real < goal) {
+                std::memset(output+real*_channels,0,(goal-real)*_channels*sizeof(float));
+            }
+            Uint32 prev = _previous->read(_buffer,goal);
+            if (prev < goal) {
                 // Possible in rare cases with a fade-out in place
-                std::memset(input+goal*_channels,0,(real-goal)*_channels*sizeof(float));
-                goal = real;
+                std::memset(_buffer+prev*_channels,0,(goal-prev)*_channels*sizeof(float));
             }
+            blend(output,goal);
             amt += goal;
             
-            // Now mix
-            real = goal*_channels;
-            Uint32 step = std::min((Uint32)remain,overlap);
-            while (real--) {
-                float factor = (float)(step)/overlap;
-                *output = *input*factor+*output*(1-factor);
-                output++;
-                input++;
-                if (real % _channels == 0 && step > 0) {
-                    step--;
-                }
+            // Handle very short current
+            if (real > 0) {
+                looped = false;
             }
-\
-            // And shift if we are done.
-            if (goal >= remain) {
-                if (_calling.load(std::memory_order_relaxed)) {
-                    notify(previous,Action::COMPLETE);
-                }
-                previous  = nullptr;
-                _previous = nullptr;
+            if (current != nullptr && (real < goal || current->completed())) {
+                finish(current,loop,looped);
             }
-            
-            // Handle very short current
-            if (current->completed()) {
-                current = acquire(loop,1,Action::COMPLETE);
+            continue;
+        } else if (current == nullptr) {
+            if (!queued) {
+                break;
+            } else if (start < 0) {
+                current = next(loop);
+            } else {
+                // Silence until the next scheduled node
+                std::memset(output,0,need*_channels*sizeof(float));
+                amt += need;
             }
-        } else if (overlap > 0 && loop == 0 && _qsize.load(std::memory_order_acquire)) {
+            continue;
+        } else if (overlap > 0 && loop == 0 && queued && start < 0) {
             // Check whether we need to overlap
-            Sint64 remain = current->getRemaining()*_sampling;
-            if (remain >= 0 && remain-overlap <= need) {
+            double time  = current->getRemaining();
+            Sint64 remain = time < 0 ? -1 : (Sint64)std::round(time*_sampling);
+            if (remain >= 0 && remain <= (Sint64)need+overlap) {
                 if (remain > overlap) {
-                    amt += current->read(&(buffer[amt*_channels]),(Uint32)(remain-overlap));
+                    amt += current->read(output,(Uint32)(remain-overlap));
                 }
                 _previous = current;
-                previous = _previous;
-                _queue.pop(_current,loop);
-                current = _current;
-            } else {
-                amt += current->read(&(buffer[amt*_channels]),need);
-                if (amt < frames || current->completed()) {
-                    current = acquire(loop,1,Action::COMPLETE);
-                }
-            }
-        } else {
-            // Perform a normal read
-            amt += current->read(&(buffer[amt*_channels]),need);
-            if (loop && amt < frames) {
-                if (!current->reset()) {
-                    current = nullptr;
-                    _current = nullptr;
-                } else if (_calling.load(std::memory_order_acquire)) {
-                    notify(current,Action::LOOPBACK);
+                _fadeact  = Action::COMPLETE;
+                _fadelen  = overlap;
+                _fade = (Uint32)std::min(remain,(Sint64)overlap);
+                if (_fade == 0) {
+                    if (_calling.load(std::memory_order_relaxed)) {
+                        notify(_previous,_fadeact);
+                    }
+                    _previous = nullptr;
                 }
-                if (loop > 0) { loop--;}
-            } else if (amt < frames || (!loop && current->completed())) {
-                current = acquire(loop,1,Action::COMPLETE);
+                current = next(loop);
+                looped = false;
+                continue;
             }
         }
+        
+        // Perform a normal read
+        Uint32 real = current->read(output,need);
+        amt += real;
+        if (real > 0) {
+            looped = false;
+        }
+        if (real < need || current->completed()) {
+            finish(current,loop,looped);
+        }
     }
     
     dsp::DSPMath::scale(buffer,_ndgain.load(std::memory_order_relaxed),buffer,amt*_channels);
@@ -665,7 +849,9 @@ Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
         std::memset(buffer+amt*_channels,0,(frames-amt)*sizeof(float)*_channels);
     }
     
+    _current = current;
     _loops.store(loop,std::memory_order_relaxed);
+    _clock.store(clock+frames,std::memory_order_release);
     _polling.store(false);
     return frames;
 }
@@ -674,25 +860,33 @@ Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
  * Marks the current read position in the audio steam.
  *
  * DELEGATED METHOD: This method delegates its call to the current audio
- * node.  It returns false if there is no active node or if this method is
- * unsupported.
+ * node.  It returns false if the scheduler is not initialized.
  *
  * Once this method is called, the scheduler will mark the current audio
  * node and buffer all subsequent audio nodes. It will create a secondary
  * queue to prevent these nodes from being released. A call to the method
  * {@link reset()} will return to the marked position of the current audio
  * node and replay all subsequent audio nodes before returning to the audio
- * queue.
+ * queue.  The scheduler clock also returns to the marked frame, so that
+ * scheduled nodes replay on the same frames.
  *
  * This secondary queue will continue accumulating audio nodes until
- * {@link unmark()} is called.  It is not recommended for a marks to
- * remain indefinitely.
+ * {@link unmark()} is called, or until it holds {@link MEMORY_CAPACITY}
+ * nodes.  The secondary queue is allocated ahead of time, so the audio
+ * thread never allocates memory to retain a node.
+ *
+ * The mark is applied by the audio thread at the start of the next read,
+ * and so it may be as much as one read buffer after this call.
  *
  * @return true if the read position was marked.
  */
 bool AudioScheduler::mark() {
-    // TODO: FINISH ME
-    return false;
+    if (!_booted) {
+        return false;
+    }
+    _command.fetch_and(~(Uint32)Command::UNMARK,std::memory_order_relaxed);
+    _command.fetch_or(Command::MARK,std::memory_order_release);
+    return true;
 }
 
 /**
@@ -707,26 +901,39 @@ bool AudioScheduler::mark() {
  * @return true if the read position was cleared.
  */
 bool AudioScheduler::unmark() {
-    // TODO: FINISH ME
-    return false;
+    Uint32 prior = _command.fetch_and(~(Uint32)(Command::MARK | Command::RESET),
+                                      std::memory_order_relaxed);
+    if (!_marked.load(std::memory_order_relaxed) && !(prior & Command::MARK)) {
+        return false;
+    }
+    _command.fetch_or(Command::UNMARK,std::memory_order_release);
+    return true;
 }
 
 /**
  * Resets the read position to the marked position of the audio stream.
  *
  * DELEGATED METHOD: This method delegates its call to the current audio
- * node.  It returns false if there is no active node or if this method is
- * unsupported.
+ * node.  It returns false if there is no current mark.
  *
  * This method returns the playback to the audio node and position set
- * by a call to {@link mark()}.  If mark has not been called, this method
- * has no effect.
+ * by a call to {@link mark()}.  All nodes played since the mark are
+ * replayed, with the same loops and start frames, before returning to
+ * the audio queue.  If mark has not been called, this method has no
+ * effect.
+ *
+ * The reset is applied by the audio thread at the start of the next read.
+ * Any cross-fade in progress is cut short.
  *
  * @return true if the read position was moved.
  */
 bool AudioScheduler::reset() {
-    // TODO: FINISH ME
-    return false;
+    Uint32 prior = _command.load(std::memory_order_relaxed);
+    if (!_marked.load(std::memory_order_relaxed) && !(prior & Command::MARK)) {
+        return false;
+    }
+    _command.fetch_or(Command::RESET,std::memory_order_release);
+    return true;
 }
 
 /**
@@ -762,9 +969,8 @@ Sint64 AudioScheduler::advance(Uint32 frames) {
 /**
  * Returns the current frame position of this audio node.
  *
- * DELEGATED METHOD: This method delegates its call to the current audio
- * node.  It returns -1 if there is no active node or if this method is
- * unsupported.
+ * This method returns -1 unless {@link mark()} is called.  All frame
+ * positions are the frames read since the marked position.
  *
  * This method is thread safe, and may be called outside the audio thread.
  * However, the accuracy of the result on a non-paused audio source is
@@ -775,8 +981,10 @@ Sint64 AudioScheduler::advance(Uint32 frames) {
  * @return the current frame position of this audio node.
  */
 Sint64 AudioScheduler::getPosition() const  {
-    // TODO: FINISH ME
-    return -1;
+    if (!_marked.load(std::memory_order_acquire)) {
+        return -1;
+    }
+    return _clock.load(std::memory_order_relaxed)-_markclock.load(std::memory_order_relaxed);
 }
 
 /**
@@ -814,11 +1022,7 @@ Sint64 AudioScheduler::setPosition(Uint32 position)  {
 /**
  * Returns the elapsed time in seconds.
  *
- * DELEGATED METHOD: This method delegates its call to the current audio
- * node.  It returns -1 if there is no active node or if this method is
- * unsupported.
- *
- * This method has no effect unless {@link mark()} is called.  All time
+ * This method returns -1 unless {@link mark()} is called.  All time
  * is relative from the marked position.
  *
  * This method is thread safe, and may be called outside the audio thread.
@@ -830,8 +1034,8 @@ Sint64 AudioScheduler::setPosition(Uint32 position)  {
  * @return the elapsed time in seconds.
  */
 double AudioScheduler::getElapsed() const  {
-    // TODO: FINISH ME
-    return -1.0;
+    Sint64 position = getPosition();
+    return position < 0 ? -1.0 : (double)position/(double)_sampling;
 }
 
 
@@ -888,19 +1092,27 @@ std::shared_ptr<AudioNode> AudioScheduler::acquire(Sint32& loop, Uint32 skip, Au
     // Most compilers do not appear to support an atomic operation here
     // But getting a local variable is good enough.
     std::shared_ptr<AudioNode> result = _current;
-    Uint32 size = _qsize.load(std::memory_order_acquire);
     bool callback = _calling.load(std::memory_order_relaxed);
-    bool change = false;
-    
     loop = _loops.load(std::memory_order_relaxed);
-    while (skip && size) {
+    
+    Sint64 start;
+    if (skip) {
+        // Skips abandon any replay or overlap
+        _mempos = -1;
+        if (_previous != nullptr) {
+            if (callback) {
+                notify(_previous,action);
+            }
+            _previous = nullptr;
+            _fade = 0;
+        }
+    }
+    while (skip && pending(start)) {
         if (result != nullptr && callback) {
             notify(result,action);
         }
-        _queue.pop(result,loop);
-        size--;
+        result = next(loop);
         skip--;
-        change = true;
     }
     if (skip) {
         if (result != nullptr && callback) {
@@ -908,17 +1120,262 @@ std::shared_ptr<AudioNode> AudioScheduler::acquire(Sint32& loop, Uint32 skip, Au
         }
         result = nullptr;
         loop = 0;
-        change = true;
-    } else if (result == nullptr && size) {
-        _queue.pop(result,loop);
-        size--;
-        change = true;
+    } else if (result == nullptr && pending(start) && start < 0) {
+        result = next(loop);
+    }
+    return result;
+}
+
+/**
+ * Returns true if there is an audio node waiting to be played.
+ *
+ * Nodes waiting in the mark memory (during a replay) come before the
+ * nodes in the queue.  If there is a node, its start frame is stored in
+ * the reference variable.  This is -1 if the node is not scheduled.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param start     Reference variable to store the start frame
+ *
+ * @return true if there is an audio node waiting to be played.
+ */
+bool AudioScheduler::pending(Sint64& start) {
+    if (_mempos >= 0 && _mempos < _memsize) {
+        start = _memory[_mempos].start;
+        return true;
+    }
+    
+    AudioNodeQueue::Entry entry;
+    if (_queue.peek(entry)) {
+        start = entry.start;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Returns the next audio node waiting to be played.
+ *
+ * Nodes waiting in the mark memory (during a replay) come before the
+ * nodes in the queue.  A node taken from the queue while there is a mark
+ * is retained in the mark memory.  If there is no node, this method
+ * returns nullptr.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param loop      Reference variable to store the number of loops
+ *
+ * @return the next audio node waiting to be played.
+ */
+std::shared_ptr<AudioNode> AudioScheduler::next(Sint32& loop) {
+    if (_mempos >= 0 && _mempos < _memsize) {
+        Retained& item = _memory[_mempos++];
+        loop = item.loops;
+        item.node->reset();
+        return item.node;
+    }
+    _mempos = -1;
+    
+    AudioNodeQueue::Entry entry;
+    if (!_queue.pop(entry)) {
+        loop = 0;
+        return nullptr;
+    }
+    
+    // Retain the node for a replay (if there is room)
+    if (_marked.load(std::memory_order_relaxed) && _memsize < _memory.size()) {
+        entry.value->mark();
+        Retained& item = _memory[_memsize++];
+        item.node  = entry.value;
+        item.loops = entry.loops;
+        item.start = entry.start;
     }
+    loop = entry.loops;
+    return entry.value;
+}
 
-    if (change) {
-        _qsize.store(size,std::memory_order_release);
-        _loops.store(loop,std::memory_order_relaxed);
-        _current = result;
+/**
+ * Starts the next scheduled node, interrupting the current one.
+ *
+ * If the overlap is positive, the current node becomes the previous node,
+ * and fades out over the overlap.  Any fade in progress is cut short.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param current   Reference variable for the current node
+ * @param loop      Reference variable for the number of loops
+ * @param overlap   The overlap in frames
+ */
+void AudioScheduler::cue(std::shared_ptr<AudioNode>& current, Sint32& loop, Uint32 overlap) {
+    bool callback = _calling.load(std::memory_order_relaxed);
+    if (_previous != nullptr) {
+        if (callback) {
+            notify(_previous,_fadeact);
+        }
+        _previous = nullptr;
+        _fade = 0;
     }
-    return result;
+    
+    if (current != nullptr) {
+        if (overlap > 0) {
+            _previous = current;
+            _fadeact  = Action::INTERRUPT;
+            _fadelen  = overlap;
+            _fade     = overlap;
+        } else if (callback) {
+            notify(current,Action::INTERRUPT);
+        }
+    }
+    current = next(loop);
+    
+    // Nodes can never cross-fade with themselves
+    if (current != nullptr && current == _previous) {
+        _previous = nullptr;
+        _fade = 0;
+    }
+}
+
+/**
+ * Handles the completion of the current node.
+ *
+ * If the node has loops remaining, it is reset.  Otherwise, it is
+ * replaced by the next node, provided that node is not scheduled.  If
+ * the next node is scheduled, the current node is set to nullptr until
+ * the start frame.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param current   Reference variable for the current node
+ * @param loop      Reference variable for the number of loops
+ * @param looped    Whether the current node just looped back
+ */
+void AudioScheduler::finish(std::shared_ptr<AudioNode>& current, Sint32& loop, bool& looped) {
+    bool callback = _calling.load(std::memory_order_relaxed);
+    
+    // A node that is empty after a loop back cannot be looped
+    if (loop != 0 && !looped && current->reset()) {
+        if (callback) {
+            notify(current,Action::LOOPBACK);
+        }
+        if (loop > 0) {
+            loop--;
+        }
+        looped = true;
+        return;
+    }
+    
+    if (callback) {
+        notify(current,Action::COMPLETE);
+    }
+    looped = false;
+    
+    Sint64 start;
+    if (pending(start) && start < 0) {
+        current = next(loop);
+    } else {
+        current = nullptr;
+        loop = 0;
+    }
+}
+
+/**
+ * Mixes the previous node into the output for a cross-fade.
+ *
+ * The previous node must have been read into the overlap buffer.  The
+ * output is the current node faded in, mixed with the previous node
+ * faded out.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param output    The output buffer with the current node
+ * @param frames    The number of frames to mix
+ */
+void AudioScheduler::blend(float* output, Uint32 frames) {
+    float* input = _buffer;
+    for(Uint32 ii = 0; ii < frames; ii++) {
+        float factor = (float)(_fade-ii)/_fadelen;
+        for(Uint32 jj = 0; jj < _channels; jj++) {
+            *output = *input*factor+*output*(1-factor);
+            output++;
+            input++;
+        }
+    }
+    
+    _fade -= frames;
+    if (_fade == 0) {
+        if (_calling.load(std::memory_order_relaxed)) {
+            notify(_previous,_fadeact);
+        }
+        _previous = nullptr;
+    }
+}
+
+/**
+ * Processes the commands from {@link mark}, {@link unmark}, and {@link reset}.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ *
+ * @param current   Reference variable for the current node
+ * @param loop      Reference variable for the number of loops
+ */
+void AudioScheduler::command(std::shared_ptr<AudioNode>& current, Sint32& loop) {
+    Uint32 command = _command.exchange(0,std::memory_order_acquire);
+    if (!command) {
+        return;
+    }
+    
+    if (command & Command::UNMARK) {
+        forget();
+        _marked.store(false,std::memory_order_release);
+    }
+    
+    if (command & Command::MARK) {
+        forget();
+        Retained& item = _memory[0];
+        item.node  = current;
+        item.loops = loop;
+        item.start = -1;
+        if (current != nullptr) {
+            current->mark();
+        }
+        _memsize = 1;
+        _markclock.store(_clock.load(std::memory_order_relaxed),std::memory_order_relaxed);
+        _marked.store(true,std::memory_order_release);
+    }
+    
+    if ((command & Command::RESET) && _memsize > 0) {
+        bool callback = _calling.load(std::memory_order_relaxed);
+        if (_previous != nullptr) {
+            if (callback) {
+                notify(_previous,Action::INTERRUPT);
+            }
+            _previous = nullptr;
+            _fade = 0;
+        }
+        
+        Retained& item = _memory[0];
+        if (current != nullptr && current != item.node && callback) {
+            notify(current,Action::INTERRUPT);
+        }
+        current = item.node;
+        loop = item.loops;
+        if (current != nullptr) {
+            current->reset();
+        }
+        _mempos = 1;
+        _clock.store(_markclock.load(std::memory_order_relaxed),std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Releases all of the nodes in the mark memory.
+ *
+ * AUDIO THREAD ONLY: This is an internal method for queue management.
+ */
+void AudioScheduler::forget() {
+    for(Uint32 ii = 0; ii < _memsize; ii++) {
+        _memory[ii].node = nullptr;
+    }
+    _memsize = 0;
+    _mempos = -1;
 }
@@ -33,8 +33,10 @@
 #include <cugl/base/CUApplication.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CUGLState.h>
 #include <cugl/input/CUInput.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <algorithm>
 #include <vector>
 
@@ -67,6 +69,8 @@ _assetdir(""),
 _state(State::NONE),
 _fullscreen(false),
 _highdpi(true),
+_firstframe(0),
+_skipframe(false),
 _funcid(0),
 _clearColor(Color4f::CORNFLOWER) // Ah, XNA
 {
@@ -96,6 +100,8 @@ void Application::dispose() {
     _fullscreen = false;
     _highdpi = true;
     _fpswindow.clear();
+    _firstframe = 0;
+    _skipframe = false;
     _clearColor = Color4f::CORNFLOWER;
     setFPS(60.0f);
 }
@@ -114,6 +120,7 @@ void Application::dispose() {
  */
 bool Application::init() {
     _state = State::STARTUP;
+    _launch.mark();
 
 
     // Initializate the video
@@ -273,14 +280,24 @@ bool Application::step() {
         processCallbacks(((Uint32)micros)/1000);
         update(micros/1000000.0f);
 
-        glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
+        GLState::clearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
         glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        _skipframe = false;
         draw();
-        Display::get()->refresh();
+        if (!_skipframe) {
+            Display::get()->refresh();
+            if (!_firstframe) {
+                Timestamp presented;
+                _firstframe = presented.ellapsedMicros(_launch);
+                CULog("First frame presented after %.2f ms",_firstframe/1000.0);
+            }
+        }
     } else {
         running = _state == State::BACKGROUND;
     }
+    
+    CUMemoryEndFrame();
 
 	// Sleep the remainder
     // SDL ticks give smoother frame than realistic timestamp
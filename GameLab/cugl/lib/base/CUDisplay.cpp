@@ -37,6 +37,7 @@
 #include <cugl/base/CUBase.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/render/CUGLState.h>
 #include "platform/CUDisplay-impl.h"
 #include <SDL/SDL_ttf.h>
 
@@ -155,7 +156,7 @@ bool Display::init(std::string title, Rect bounds, Uint32 flags) {
 
 // The mobile devices have viewport problems
 #if CU_PLATFORM == CU_PLATFORM_ANDROID || CU_PLATFORM == CU_PLATFORM_IPHONE
-    glViewport(0, 0, (int)bounds.size.width, (int)bounds.size.height);
+    GLState::viewport(0, 0, (int)bounds.size.width, (int)bounds.size.height);
 #endif
 
     _initialOrientation = DisplayOrientation(true);
@@ -457,7 +458,7 @@ bool Display::removeOrientationListener() {
  * on iOS).
  */
 void Display::restoreRenderTarget() {
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, _rendbuffer);
 }
 
@@ -537,6 +538,9 @@ bool Display::initOpenGL(bool multisample) {
         return false;
     }
     
+    // A new context has none of the previous state
+    GLState::invalidate();
+    
     // Multisampling support
 #if CU_GL_PLATFORM != CU_GL_OPENGLES
     glEnable(GL_LINE_SMOOTH);
@@ -0,0 +1,267 @@
+//
+//  CUEndian.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module implements the array functions of the endian header.  These
+//  functions encode an entire array in place, using vector byte shuffles
+//  when vectorization is enabled.  The single value functions are all inline
+//  and are defined in the header.
+//
+//  All of the functions in this module are idempotent. To decode a previously
+//  encoded array, use the function again.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/base/CUEndian.h>
+#include <cugl/math/CUMathBase.h>
+#include <cstring>
+
+using namespace cugl;
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#pragma mark -
+#pragma mark Swap Kernels
+/**
+ * Reverses the bytes of each 16 bit word in the given data.
+ *
+ * @param data      The data to swap
+ * @param length    The number of words
+ */
+static void swap16(Uint8* data, size_t length) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128i shuffle = _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+    for(; ii+8 <= length; ii += 8) {
+        __m128i word = _mm_loadu_si128((__m128i*)(data+2*ii));
+        _mm_storeu_si128((__m128i*)(data+2*ii),_mm_shuffle_epi8(word,shuffle));
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    for(; ii+8 <= length; ii += 8) {
+        vst1q_u8(data+2*ii,vrev16q_u8(vld1q_u8(data+2*ii)));
+    }
+#endif
+    for(; ii < length; ii++) {
+        Uint16 word;
+        std::memcpy(&word,data+2*ii,2);
+        word = SDL_Swap16(word);
+        std::memcpy(data+2*ii,&word,2);
+    }
+}
+
+/**
+ * Reverses the bytes of each 32 bit word in the given data.
+ *
+ * @param data      The data to swap
+ * @param length    The number of words
+ */
+static void swap32(Uint8* data, size_t length) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128i shuffle = _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    for(; ii+4 <= length; ii += 4) {
+        __m128i word = _mm_loadu_si128((__m128i*)(data+4*ii));
+        _mm_storeu_si128((__m128i*)(data+4*ii),_mm_shuffle_epi8(word,shuffle));
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    for(; ii+4 <= length; ii += 4) {
+        vst1q_u8(data+4*ii,vrev32q_u8(vld1q_u8(data+4*ii)));
+    }
+#endif
+    for(; ii < length; ii++) {
+        Uint32 word;
+        std::memcpy(&word,data+4*ii,4);
+        word = SDL_Swap32(word);
+        std::memcpy(data+4*ii,&word,4);
+    }
+}
+
+/**
+ * Reverses the bytes of each 64 bit word in the given data.
+ *
+ * @param data      The data to swap
+ * @param length    The number of words
+ */
+static void swap64(Uint8* data, size_t length) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128i shuffle = _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+    for(; ii+2 <= length; ii += 2) {
+        __m128i word = _mm_loadu_si128((__m128i*)(data+8*ii));
+        _mm_storeu_si128((__m128i*)(data+8*ii),_mm_shuffle_epi8(word,shuffle));
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    for(; ii+2 <= length; ii += 2) {
+        vst1q_u8(data+8*ii,vrev64q_u8(vld1q_u8(data+8*ii)));
+    }
+#endif
+    for(; ii < length; ii++) {
+        Uint64 word;
+        std::memcpy(&word,data+8*ii,8);
+        word = SDL_Swap64(word);
+        std::memcpy(data+8*ii,&word,8);
+    }
+}
+#else
+/** Big-endian data is already in network order */
+#define swap16(data,length)
+#define swap32(data,length)
+#define swap64(data,length)
+#endif
+
+#pragma mark -
+#pragma mark Array Encoding
+/**
+ * Encodes the given array of 16 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Sint16* array, size_t length) {
+    swap16((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of 16 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Uint16* array, size_t length) {
+    swap16((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of 32 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Sint32* array, size_t length) {
+    swap32((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of 32 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Uint32* array, size_t length) {
+    swap32((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of 64 bit signed integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Sint64* array, size_t length) {
+    swap64((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of 64 bit unsigned integers in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(Uint64* array, size_t length) {
+    swap64((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of floats in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(float* array, size_t length) {
+    swap32((Uint8*)array,length);
+}
+
+/**
+ * Encodes the given array of doubles in network order
+ *
+ * The array is encoded in place.  On a big-endian system, this function has
+ * no effect.  On a little-endian system, it swaps the bytes of each element
+ * to put them in big-endian order.
+ *
+ * This function is idempotent. To decode an encoded array, call this function
+ * on the array again.
+ *
+ * @param array     The array to encode
+ * @param length    The number of elements in the array
+ */
+void cugl::marshall(double* array, size_t length) {
+    swap64((Uint8*)array,length);
+}
@@ -17,6 +17,9 @@
 //  have proper file systems.  You should confine all files to either the asset
 //  or the save directory.
 //
+//  This reader recognizes the compressed files of BinaryWriter, and decodes
+//  them automatically.  Each block is verified against its CRC32 checksum.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -55,10 +58,156 @@
 #include <cugl/base/CUApplication.h>
 #include <cugl/base/CUEndian.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUCompression.h>
+#include <cstring>
 
 using namespace cugl;
 
 #define BUFFSIZE 1024
+/** The magic number at the start of a compressed file */
+#define PACK_MAGIC  "CUBZ"
+/** The size of the header before each compressed block */
+#define PACK_HEADER 12
+/** The largest block size we accept from a file header */
+#define PACK_LIMIT  (64*1024*1024)
+
+#pragma mark -
+#pragma mark Internal Methods
+/**
+ * Returns true if the file stream is opened successfully.
+ *
+ * This method opens the file at the stored path and allocates the
+ * buffers.  It also reads the header of a compressed file.
+ *
+ * @return true if the file stream is opened successfully.
+ */
+bool BinaryReader::open() {
+    _stream = SDL_RWFromFile(_name.c_str(), "rb");
+    if (!_stream) {
+        return false;
+    }
+    
+    _ssize = SDL_RWsize(_stream);
+    _scursor = 0;
+    _bufsize = 0;
+    _bufoff  = 0;
+    _compressed = false;
+    _blocksize  = 0;
+    
+    char header[8];
+    if (_ssize >= 8 && SDL_RWread(_stream, header, 1, 8) == 8) {
+        if (std::memcmp(header, PACK_MAGIC, 4) == 0) {
+            Uint32 size;
+            std::memcpy(&size, header+4, 4);
+            _blocksize  = marshall(size);
+            _compressed = true;
+            _scursor = 8;
+        } else {
+            SDL_RWseek(_stream, 0, RW_SEEK_SET);
+        }
+    }
+    
+    if (_compressed && (_blocksize == 0 || _blocksize > PACK_LIMIT)) {
+        CULogError("Invalid block size %u in %s", _blocksize, _name.c_str());
+        SDL_RWclose(_stream);
+        _stream = nullptr;
+        return false;
+    }
+    
+    // A compressed reader needs room to decode a full block
+    _buffer = new char[_capacity+_blocksize];
+    if (_compressed) {
+        _packed = new Uint8[packtool::bound(_blocksize)];
+    }
+    fill();
+    return _ssize >= 0;
+}
+
+/**
+ * Reads a sequence of elements of the given size from the stream.
+ *
+ * The function will attempt to read up to maximum number of elements.
+ * It will return the actual number of elements read (which may be 0).
+ * Elements of more than one byte are marshalled from network order
+ * with a single pass over the array.
+ *
+ * @param buffer    The array to store the data when read
+ * @param maximum   The maximum number of elements to read from the stream
+ * @param bytes     The size of each element in bytes
+ *
+ * @return the number of elements read from the stream
+ */
+size_t BinaryReader::readArray(void* buffer, size_t maximum, unsigned int bytes) {
+    CUAssertLog(ready(), "Attempt to read a finished stream");
+    char* dest = (char*)buffer;
+    size_t count = 0;
+    while (count < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+            if (_bufoff+bytes > _bufsize) {
+                break;
+            }
+        }
+        size_t available = (_bufsize-_bufoff)/bytes;
+        size_t wanted = maximum-count;
+        wanted = wanted < available ? wanted : available;
+        std::memcpy(dest+count*bytes, _buffer+_bufoff, wanted*bytes);
+        _bufoff += (Sint32)(wanted*bytes);
+        count += wanted;
+    }
+    
+    switch (bytes) {
+        case 2:
+            marshall((Uint16*)buffer, count);
+            break;
+        case 4:
+            marshall((Uint32*)buffer, count);
+            break;
+        case 8:
+            marshall((Uint64*)buffer, count);
+            break;
+    }
+    return count;
+}
+
+/**
+ * Returns true if the next block of a compressed file was decoded.
+ *
+ * The block is appended to the storage buffer, which must have room
+ * for a full block.  If the block is corrupt, this method logs an error
+ * and returns false.
+ *
+ * @return true if the next block of a compressed file was decoded.
+ */
+bool BinaryReader::readBlock() {
+    Uint32 header[3];
+    size_t capacity = packtool::bound(_blocksize);
+    bool valid = SDL_RWread(_stream, header, 1, PACK_HEADER) == PACK_HEADER;
+    
+    Uint32 rawsize  = marshall(header[0]);
+    Uint32 packsize = marshall(header[1]);
+    Uint32 checksum = marshall(header[2]);
+    valid = valid && rawsize > 0 && rawsize <= _blocksize && packsize <= capacity;
+    valid = valid && SDL_RWread(_stream, _packed, 1, packsize) == packsize;
+    
+    Uint8* dest = (Uint8*)(_buffer+_bufsize);
+    if (valid && packsize == rawsize) {
+        std::memcpy(dest, _packed, rawsize);
+    } else if (valid) {
+        valid = packtool::decode(_packed, packsize, dest, rawsize) == rawsize;
+    }
+    valid = valid && packtool::crc32(dest, rawsize) == checksum;
+    
+    if (!valid) {
+        CULogError("Corrupt block at offset %lld in %s", (long long)_scursor, _name.c_str());
+        _scursor = _ssize;
+        return false;
+    }
+    
+    _scursor += PACK_HEADER+packsize;
+    _bufsize += rawsize;
+    return true;
+}
 
 #pragma mark -
 #pragma mark Constructors
@@ -98,19 +247,8 @@ bool BinaryReader::init(const std::string file) {
 bool BinaryReader::init(const std::string file, unsigned int capacity) {
     CUAssertLog(capacity, "The buffer capacity must be positive");
     _name = filetool::normalize_path(file);
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
-    if (!_stream) {
-        return false;
-    }
-    
-    _ssize = SDL_RWsize(_stream);
-    _scursor = 0;
     _capacity = capacity;
-    _buffer = new char[_capacity];
-    _bufsize = 0;
-    fill();
-    
-    return _ssize >= 0;
+    return open();
 }
 
 /**
@@ -151,20 +289,8 @@ bool BinaryReader::initWithAsset(const std::string file, unsigned int capacity)
     _name = Application::get()->getAssetDirectory();
     _name.append(file);
     _name = filetool::normalize_path(_name);
-    
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
-    if (!_stream) {
-        return false;
-    }
-    
-    _ssize = SDL_RWsize(_stream);
-    _scursor = 0;
     _capacity = capacity;
-    _buffer = new char[_capacity];
-    _bufsize = 0;
-    fill();
-    
-    return _ssize >= 0;
+    return open();
 }
 
 
@@ -177,15 +303,8 @@ bool BinaryReader::initWithAsset(const std::string file, unsigned int capacity)
  * if the stream has been closed.
  */
 void BinaryReader::reset() {
-    if (_stream) {
-        close();
-    }
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
-    _ssize  = SDL_RWsize(_stream);
-    _buffer = new char[_capacity];
-    _bufsize = 0;
-    _bufoff  = 0;
-    _scursor = 0;
+    close();
+    open();
 }
 
 /**
@@ -205,6 +324,10 @@ void BinaryReader::close() {
         _buffer  = nullptr;
         _bufsize = 0;
     }
+    if (_packed) {
+        delete[] _packed;
+        _packed = nullptr;
+    }
 }
 
 /**
@@ -218,9 +341,28 @@ void BinaryReader::close() {
  * @return true if there is enough data left to read
  */
 bool BinaryReader::ready(unsigned int bytes) const {
+    if (!_stream) {
+        return false;
+    }
     unsigned int remain = (unsigned int)(_bufsize-_bufoff);
     if (remain < bytes) {
-        remain += (unsigned int)(_ssize-_scursor);
+        if (!_compressed) {
+            remain += (unsigned int)(_ssize-_scursor);
+            return remain >= bytes;
+        }
+        
+        // Sum the decoded sizes in the headers of the blocks not yet read
+        Sint64 cursor = _scursor;
+        while (remain < bytes && cursor+PACK_HEADER <= _ssize) {
+            Uint32 header[3];
+            if (SDL_RWseek(_stream, cursor, RW_SEEK_SET) < 0 ||
+                SDL_RWread(_stream, header, 1, PACK_HEADER) != PACK_HEADER) {
+                break;
+            }
+            remain += marshall(header[0]);
+            cursor += PACK_HEADER+marshall(header[1]);
+        }
+        SDL_RWseek(_stream, _scursor, RW_SEEK_SET);
         return remain >= bytes;
     }
     return true;
@@ -230,28 +372,41 @@ bool BinaryReader::ready(unsigned int bytes) const {
  * Fills the storage buffer to capacity
  *
  * This cuts down on the number of reads to the file by allowing us
- * to read from the file in predefined chunks.
+ * to read from the file in predefined chunks.  It does nothing if the
+ * buffer already holds the given number of bytes.  Otherwise, it reads
+ * (or decodes whole blocks) until the buffer holds at least that many
+ * bytes, or the stream ends.
  *
  * @param bytes The minimum number of bytes to ensure in the stream
  */
 void BinaryReader::fill(unsigned int bytes) {
-    if (!_bufoff || !_stream || _scursor == _ssize) {
+    if (!_stream || _scursor == _ssize || _bufsize-_bufoff >= bytes) {
         return;
     }
     
-    if (_bufoff == -1 || _bufoff+bytes > _bufsize) {
-        if (_bufoff < _bufsize) {
-            memcpy(_buffer, &(_buffer[_bufoff]), _bufsize-_bufoff);
+    if (_bufoff > 0) {
+        if ((Uint32)_bufoff < _bufsize) {
+            std::memmove(_buffer, &(_buffer[_bufoff]), _bufsize-_bufoff);
             _bufsize -= _bufoff;
         } else {
             _bufsize = 0;
         }
-        _bufoff   = 0;
+        _bufoff = 0;
     }
     
-    size_t amt = SDL_RWread(_stream, &_buffer[_bufsize], 1, _capacity-_bufsize);
-    _bufsize += (Uint32)amt;
-    _scursor += amt;
+    if (!_compressed) {
+        size_t amt = SDL_RWread(_stream, &_buffer[_bufsize], 1, _capacity-_bufsize);
+        _bufsize += (Uint32)amt;
+        _scursor += amt;
+        return;
+    }
+    
+    // Decode whole blocks until the request is met and the buffer is full
+    while (_scursor < _ssize && (_bufsize < bytes || _bufsize <= _capacity)) {
+        if (!readBlock()) {
+            return;
+        }
+    }
 }
 
 #pragma mark -
@@ -454,17 +609,7 @@ double BinaryReader::readDouble()  {
  * @return the number of characters read from the stream
  */
 size_t BinaryReader::read(char* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    while (ready(1) && pos-offset < maximum) {
-        size_t available = _bufsize-_bufoff;
-        size_t wanted = maximum-(pos-offset);
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)wanted;
-    }
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 1);
 }
 
 /**
@@ -480,17 +625,7 @@ size_t BinaryReader::read(char* buffer, size_t maximum, size_t offset) {
  * @return the number of bytes read from the stream
  */
 size_t BinaryReader::read(Uint8* buffer, size_t maximum, size_t offset)  {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    while (ready(1) && pos-offset < maximum) {
-        size_t available = _bufsize-_bufoff;
-        size_t wanted = maximum-(pos-offset);
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)wanted;
-    }
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 1);
 }
 
 /**
@@ -509,22 +644,7 @@ size_t BinaryReader::read(Uint8* buffer, size_t maximum, size_t offset)  {
  * @return the number of 16 bit signed integers read from the stream
  */
 size_t BinaryReader::read(Sint16* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 2;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 2);
 }
 
 /**
@@ -543,22 +663,7 @@ size_t BinaryReader::read(Sint16* buffer, size_t maximum, size_t offset) {
  * @return the number of 16 bit unsigned integers read from the stream
  */
 size_t BinaryReader::read(Uint16* buffer, size_t maximum, size_t offset)  {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 2;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 2);
 }
 
 
@@ -578,22 +683,7 @@ size_t BinaryReader::read(Uint16* buffer, size_t maximum, size_t offset)  {
  * @return the number of 32 bit signed integers read from the stream
  */
 size_t BinaryReader::read(Sint32* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 4;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 4);
 }
 
 /**
@@ -612,22 +702,7 @@ size_t BinaryReader::read(Sint32* buffer, size_t maximum, size_t offset) {
  * @return the number of 32 bit unsigned integers read from the stream
  */
 size_t BinaryReader::read(Uint32* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 4;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 4);
 }
 
 /**
@@ -646,22 +721,7 @@ size_t BinaryReader::read(Uint32* buffer, size_t maximum, size_t offset) {
  * @return the number of 32 bit signed integers read from the stream
  */
 size_t BinaryReader::read(Sint64* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 8;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 8);
 }
 
 /**
@@ -680,22 +740,7 @@ size_t BinaryReader::read(Sint64* buffer, size_t maximum, size_t offset) {
  * @return the number of 32 bit unsigned integers read from the stream
  */
 size_t BinaryReader::read(Uint64* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 8;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 8);
 }
 
 /**
@@ -714,22 +759,7 @@ size_t BinaryReader::read(Uint64* buffer, size_t maximum, size_t offset) {
  * @return the number of floats read from the stream
  */
 size_t BinaryReader::read(float* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 4;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 4);
 }
 
 /**
@@ -748,21 +778,6 @@ size_t BinaryReader::read(float* buffer, size_t maximum, size_t offset) {
  * @return the number of doubles read from the stream
  */
 size_t BinaryReader::read(double* buffer, size_t maximum, size_t offset) {
-    CUAssertLog(ready(), "Attempt to read a finished stream");
-    unsigned int pos = (unsigned int)offset;
-    unsigned int bytes = 8;
-    while (ready(bytes) && pos-offset < maximum) {
-        size_t available = bytes*((_bufsize-_bufoff)/bytes);
-        size_t wanted = (maximum-(pos-offset))*bytes;
-        wanted = wanted < available ? wanted : available;
-        memcpy(&(buffer[pos]),&(_buffer[_bufoff]),wanted);
-        _bufoff += (Sint32)wanted;
-        pos += (unsigned int)(wanted/bytes);
-    }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
-    }
-    
-    return pos-offset;
+    return readArray(buffer+offset, maximum, 8);
 }
 
@@ -17,6 +17,11 @@
 //  have proper file systems.  You should confine all files to either the asset
 //  or the save directory.
 //
+//  A writer may optionally compress its output.  A compressed file is a
+//  sequence of independently compressed blocks, each with a CRC32 checksum.
+//  The block compression and file writes may also run on a worker thread,
+//  so that large save and replay files do not stall the main thread.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -55,11 +60,111 @@
 #include <cugl/base/CUEndian.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUCompression.h>
+#include <cugl/util/CUThreadPool.h>
 #include <cstring>
+#include <thread>
 
 using namespace cugl;
 
 #define BUFFSIZE 1024
+/** The magic number at the start of a compressed file */
+#define PACK_MAGIC  "CUBZ"
+/** The size of the header before each compressed block */
+#define PACK_HEADER 12
+/** The number of full blocks that may wait on the worker thread */
+#define MAX_PENDING 8
+
+#pragma mark -
+#pragma mark Internal Methods
+/**
+ * Writes an array of elements of the given size to the binary file.
+ *
+ * Elements of more than one byte are marshalled to network order with
+ * a single pass over each buffered chunk.
+ *
+ * @param array     the array of elements to write
+ * @param length    the number of elements to write
+ * @param bytes     the size of each element in bytes
+ */
+void BinaryWriter::writeArray(const void* array, size_t length, unsigned int bytes) {
+    CUAssertLog(_stream, "Attempt to write to a closed stream");
+    const char* source = (const char*)array;
+    size_t remain = length;
+    while (remain > 0) {
+        if (_bufoff+bytes > _capacity) {
+            flush();
+        }
+        size_t amount = (_capacity-_bufoff)/bytes;
+        amount = remain < amount ? remain : amount;
+        
+        char* dest = _cbuffer+_bufoff;
+        std::memcpy(dest, source, amount*bytes);
+        switch (bytes) {
+            case 2:
+                marshall((Uint16*)dest, amount);
+                break;
+            case 4:
+                marshall((Uint32*)dest, amount);
+                break;
+            case 8:
+                marshall((Uint64*)dest, amount);
+                break;
+        }
+        
+        source  += amount*bytes;
+        remain  -= amount;
+        _bufoff += (Sint32)(amount*bytes);
+    }
+}
+
+/**
+ * Returns true if the given block was written to the file.
+ *
+ * If the writer is compressed, this method compresses the block and
+ * writes it with its header.  Otherwise, it writes the raw bytes.  For
+ * an asynchronous writer, this method is only called by the worker.
+ *
+ * @param stream    the file stream to write to
+ * @param data      the block to write
+ * @param length    the number of bytes in the block
+ *
+ * @return true if the given block was written to the file.
+ */
+bool BinaryWriter::writeBlock(SDL_RWops* stream, const char* data, size_t length) {
+    if (length == 0) {
+        return true;
+    } else if (!_compressed) {
+        return SDL_RWwrite(stream, data, 1, length) == length;
+    }
+    
+    const Uint8* raw = (const Uint8*)data;
+    size_t capacity = packtool::bound(_capacity);
+    size_t packsize = packtool::encode(raw, length, _packed+PACK_HEADER, capacity);
+    if (packsize == 0 || packsize >= length) {
+        // Store data that does not compress as is
+        std::memcpy(_packed+PACK_HEADER, raw, length);
+        packsize = length;
+    }
+    
+    Uint32* header = (Uint32*)_packed;
+    header[0] = marshall((Uint32)length);
+    header[1] = marshall((Uint32)packsize);
+    header[2] = marshall(packtool::crc32(raw, length));
+    size_t total = PACK_HEADER+packsize;
+    return SDL_RWwrite(stream, _packed, 1, total) == total;
+}
+
+/**
+ * Blocks until the worker thread has written every queued block.
+ *
+ * This method does nothing for a synchronous writer.
+ */
+void BinaryWriter::drain() {
+    while (_pending.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+}
 
 #pragma mark -
 #pragma mark Constructors
@@ -99,6 +204,30 @@ bool BinaryWriter::init(const std::string file) {
  * @return true if the writer is initialized properly, false otherwise.
  */
 bool BinaryWriter::init(const std::string file, unsigned int capacity) {
+    return init(file,capacity,false,false);
+}
+
+/**
+ * Initializes a writer for the given file with the specified options.
+ *
+ * If compress is true, the file is written as a sequence of compressed
+ * blocks, each of the given capacity.  If async is true, the blocks are
+ * compressed and written on a worker thread.
+ *
+ * If the file is a relative path, this reader will look for the file in
+ * the application save directory {@see Application#getSaveDirectory()}.
+ * If you wish to write a file in any other directory, you must provide
+ * an absolute path. Be warned, however, that write priviledges are
+ * heavily restricted on mobile platforms.
+ *
+ * @param file      the path (absolute or relative) to the file
+ * @param capacity  the buffer capacity for writing chunks
+ * @param compress  whether to compress and checksum the file
+ * @param async     whether to write the file on a worker thread
+ *
+ * @return true if the writer is initialized properly, false otherwise.
+ */
+bool BinaryWriter::init(const std::string file, unsigned int capacity, bool compress, bool async) {
     CUAssertLog(capacity >= 8, "Buffer capacity is too small: %d", capacity);
     _name = filetool::normalize_path(file);
     _stream = SDL_RWFromFile(_name.c_str(), "w");
@@ -110,6 +239,27 @@ bool BinaryWriter::init(const std::string file, unsigned int capacity) {
     _capacity = capacity;
     _cbuffer = new char[_capacity];
     _bufoff = 0;
+    _compressed = compress;
+    _failed  = false;
+    _pending = 0;
+    
+    if (_compressed) {
+        _packed = new Uint8[PACK_HEADER+packtool::bound(_capacity)];
+        Uint32 size = marshall((Uint32)_capacity);
+        if (SDL_RWwrite(_stream, PACK_MAGIC, 1, 4) != 4 || SDL_RWwrite(_stream, &size, 1, 4) != 4) {
+            CULogError("Unable to write header to %s", _name.c_str());
+            close();
+            return false;
+        }
+    }
+    if (async) {
+        _worker = ThreadPool::alloc(1);
+        if (_worker == nullptr) {
+            CULogError("Unable to start the worker for %s", _name.c_str());
+            close();
+            return false;
+        }
+    }
     
     return (bool)_cbuffer;
 }
@@ -124,9 +274,36 @@ bool BinaryWriter::init(const std::string file, unsigned int capacity) {
  * when the buffer fills, or just before the file is closed.
  */
 void BinaryWriter::flush() {
-    size_t amt = SDL_RWwrite(_stream, _cbuffer, 1, _bufoff);
-    CUAssertLog(amt == _bufoff, "Unable to fully flush the writer");
-    _bufoff = 0;
+    if (_bufoff == 0) {
+        return;
+    } else if (_worker == nullptr) {
+        bool success = writeBlock(_stream, _cbuffer, _bufoff);
+        CUAssertLog(success, "Unable to fully flush the writer");
+        if (!success) {
+            _failed = true;
+        }
+        _bufoff = 0;
+        return;
+    }
+    
+    // Do not let the worker fall too far behind
+    while (_pending.load(std::memory_order_acquire) >= MAX_PENDING) {
+        std::this_thread::yield();
+    }
+    
+    char* block = _cbuffer;
+    size_t length = _bufoff;
+    SDL_RWops* stream = _stream;
+    _cbuffer = new char[_capacity];
+    _bufoff  = 0;
+    _pending.fetch_add(1, std::memory_order_acq_rel);
+    _worker->addTask([=](void) {
+        if (!writeBlock(stream, block, length)) {
+            _failed = true;
+        }
+        delete[] block;
+        _pending.fetch_sub(1, std::memory_order_acq_rel);
+    });
 }
 
 /**
@@ -139,13 +316,65 @@ void BinaryWriter::flush() {
 void BinaryWriter::close() {
     if (_stream) {
         flush();
+        drain();
         SDL_RWclose(_stream);
         _stream  = nullptr;
     }
+    drain();
+    _worker = nullptr;
     if (_cbuffer) {
         delete[] _cbuffer;
         _cbuffer = nullptr;
     }
+    if (_packed) {
+        delete[] _packed;
+        _packed = nullptr;
+    }
+}
+
+/**
+ * Closes the stream, calling the callback when the file is complete.
+ *
+ * The contents of the buffer are flushed before the file is closed.  Any
+ * attempts to write to a closed stream will fail.  For an asynchronous
+ * writer, this method returns immediately.  The callback is called on
+ * the main thread once the worker has written every block, with the
+ * argument true if every write succeeded.
+ *
+ * For a synchronous writer, this method is the same as {@link #close},
+ * except that it calls the callback immediately afterwards.
+ *
+ * The writer blocks on deletion until the file is complete.  Therefore,
+ * it should remain alive until the callback is called.
+ *
+ * @param callback  the callback to call when the file is complete
+ */
+void BinaryWriter::closeAsync(std::function<void(bool success)> callback) {
+    if (_worker == nullptr || _stream == nullptr) {
+        bool success = _stream != nullptr;
+        close();
+        success = success && !_failed;
+        if (callback) {
+            callback(success);
+        }
+        return;
+    }
+    
+    flush();
+    SDL_RWops* stream = _stream;
+    _stream = nullptr;
+    _pending.fetch_add(1, std::memory_order_acq_rel);
+    _worker->addTask([=](void) {
+        // Tasks run in order, so every block is already written
+        bool success = SDL_RWclose(stream) == 0 && !_failed;
+        if (callback) {
+            Application::get()->schedule([=](void) {
+                callback(success);
+                return false;
+            });
+        }
+        _pending.fetch_sub(1, std::memory_order_acq_rel);
+    });
 }
 
 
@@ -387,21 +616,7 @@ void BinaryWriter::writeDouble(double n) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const char* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    if (_bufoff+length > _capacity) {
-        flush();
-    }
-    while (length-pos > _capacity-_bufoff) {
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),_capacity-_bufoff);
-        pos += _capacity-_bufoff;
-        _bufoff = _capacity;
-        flush();
-    }
-    
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), length-pos);
-    _bufoff += (Sint32)(length-pos);
+    writeArray(array+offset, length, 1);
 }
 
 /**
@@ -416,21 +631,7 @@ void BinaryWriter::write(const char* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Uint8* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-        
-    if (_bufoff+length > _capacity) {
-        flush();
-    }
-    while (length-pos > _capacity-_bufoff) {
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),_capacity-_bufoff);
-        pos += _capacity-_bufoff;
-        _bufoff = _capacity;
-        flush();
-    }
-        
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), length-pos);
-    _bufoff += (Sint32)(length-pos);
+    writeArray(array+offset, length, 1);
 }
 
 /**
@@ -448,35 +649,7 @@ void BinaryWriter::write(const Uint8* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Sint16* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 2;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Sint16* ref = (Sint16*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Sint16* ref = (Sint16*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-
-    _bufoff += skip;
+    writeArray(array+offset, length, 2);
 }
 
 /**
@@ -494,35 +667,7 @@ void BinaryWriter::write(const Sint16* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Uint16* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 2;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Uint16* ref = (Uint16*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Uint16* ref = (Uint16*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 2);
 }
 
 /**
@@ -540,35 +685,7 @@ void BinaryWriter::write(const Uint16* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Sint32* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Sint32* ref = (Sint32*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Sint32* ref = (Sint32*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 4);
 }
 
 
@@ -587,35 +704,7 @@ void BinaryWriter::write(const Sint32* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Uint32* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Uint32* ref = (Uint32*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Uint32* ref = (Uint32*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 4);
 }
 
 
@@ -634,35 +723,7 @@ void BinaryWriter::write(const Uint32* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Sint64* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Sint64* ref = (Sint64*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Sint64* ref = (Sint64*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 8);
 }
 
 
@@ -681,35 +742,7 @@ void BinaryWriter::write(const Sint64* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const Uint64* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            Uint64* ref = (Uint64*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        Uint64* ref = (Uint64*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 8);
 }
 
 
@@ -728,35 +761,7 @@ void BinaryWriter::write(const Uint64* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const float* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            float* ref = (float*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        float* ref = (float*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 4);
 }
 
 /**
@@ -774,33 +779,5 @@ void BinaryWriter::write(const float* array, size_t length, size_t offset) {
  * @param offset the initial offset into the array
  */
 void BinaryWriter::write(const double* array, size_t length, size_t offset) {
-    CUAssertLog(_stream, "Attempt to write to a closed stream");
-    size_t pos = 0;
-    
-    unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
-        flush();
-    }
-    while ((length-pos)*bytes > _capacity-_bufoff) {
-        unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
-        
-        for(int ii = 0; ii < skip; ii += bytes) {
-            double* ref = (double*)(&_cbuffer[_bufoff+ii]);
-            *ref = marshall(*ref);
-        }
-        
-        pos += skip/bytes;
-        _bufoff += skip;
-        flush();
-    }
-    
-    unsigned int skip = (unsigned int)((length-pos)*bytes);
-    memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]), skip);
-    for(int ii = 0; ii < skip; ii += bytes) {
-        double* ref = (double*)(&_cbuffer[_bufoff+ii]);
-        *ref = marshall(*ref);
-    }
-    
-    _bufoff += skip;
+    writeArray(array+offset, length, 8);
 }
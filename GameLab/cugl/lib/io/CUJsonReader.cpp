@@ -48,6 +48,7 @@
 //
 #include <cugl/io/CUJsonReader.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 
 using namespace cugl;
 
@@ -110,6 +111,7 @@ std::string JsonReader::readJsonString() {
  * @return a newly allocated JsonValue for the next available JSON string.
  */
 std::shared_ptr<JsonValue> JsonReader::readJson() {
+    CUMemoryScope(JSON);
     std::string data = readJsonString();
     if (!data.empty()) {
         return JsonValue::allocWithJson(data);
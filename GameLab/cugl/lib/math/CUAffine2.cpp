@@ -40,11 +40,123 @@
 #include <cugl/util/CUStrings.h>
 #include <cugl/math/CUAffine2.h>
 #include <cugl/math/CUMat4.h>
+#include <cugl/math/CUCPUFeatures.h>
 
 using namespace cugl;
 
 #define MATRIX_SIZE ( sizeof(float) *  6)
 
+#pragma mark -
+#pragma mark Batch Kernels
+/**
+ * Transforms an array of 2-element points without vectorization.
+ *
+ * It is safe for output to be the same as input.
+ *
+ * @param aff       The affine transform.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The number of points.
+ */
+static void transform2_scalar(const Affine2& aff, float const* input, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        float x = aff.m[0]*input[2*ii]+aff.m[2]*input[2*ii+1]+aff.m[4];
+        float y = aff.m[1]*input[2*ii]+aff.m[3]*input[2*ii+1]+aff.m[5];
+        output[2*ii  ] = x;
+        output[2*ii+1] = y;
+    }
+}
+
+#if defined (CU_MATH_VECTOR_SSE) || defined (CU_MATH_VECTOR_NEON64)
+/**
+ * Transforms an array of 2-element points with 128-bit words.
+ *
+ * This function transforms two points at a time.  It is safe for output
+ * to be the same as input.
+ *
+ * @param aff       The affine transform.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The number of points.
+ */
+static void transform2_128(const Affine2& aff, float const* input, float* output, size_t size) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 cx = _mm_setr_ps(aff.m[0],aff.m[1],aff.m[0],aff.m[1]);
+    const __m128 cy = _mm_setr_ps(aff.m[2],aff.m[3],aff.m[2],aff.m[3]);
+    const __m128 ct = _mm_setr_ps(aff.m[4],aff.m[5],aff.m[4],aff.m[5]);
+    for(; ii+1 < size; ii += 2) {
+        __m128 unit = _mm_loadu_ps(input+ii*2);
+        __m128 result = _mm_add_ps(ct, _mm_mul_ps(_mm_moveldup_ps(unit), cx));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_movehdup_ps(unit), cy));
+        _mm_storeu_ps(output+ii*2,result);
+    }
+#else
+    const float32x4_t cx = { aff.m[0],aff.m[1],aff.m[0],aff.m[1] };
+    const float32x4_t cy = { aff.m[2],aff.m[3],aff.m[2],aff.m[3] };
+    const float32x4_t ct = { aff.m[4],aff.m[5],aff.m[4],aff.m[5] };
+    for(; ii+1 < size; ii += 2) {
+        float32x4_t unit = vld1q_f32(input+ii*2);
+        float32x4_t result = vfmaq_f32(ct, vtrn1q_f32(unit,unit), cx);
+        result = vfmaq_f32(result, vtrn2q_f32(unit,unit), cy);
+        vst1q_f32(output+ii*2,result);
+    }
+#endif
+    transform2_scalar(aff,input+ii*2,output+ii*2,size-ii);
+}
+#endif
+
+#if defined (CU_MATH_VECTOR_AVX)
+/**
+ * Transforms an array of 2-element points with 256-bit words.
+ *
+ * This function transforms four points at a time.  It is safe for output
+ * to be the same as input.
+ *
+ * @param aff       The affine transform.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The number of points.
+ */
+CU_TARGET_AVX2 static void transform2_256(const Affine2& aff, float const* input, float* output, size_t size) {
+    const __m256 cx = _mm256_setr_ps(aff.m[0],aff.m[1],aff.m[0],aff.m[1],aff.m[0],aff.m[1],aff.m[0],aff.m[1]);
+    const __m256 cy = _mm256_setr_ps(aff.m[2],aff.m[3],aff.m[2],aff.m[3],aff.m[2],aff.m[3],aff.m[2],aff.m[3]);
+    const __m256 ct = _mm256_setr_ps(aff.m[4],aff.m[5],aff.m[4],aff.m[5],aff.m[4],aff.m[5],aff.m[4],aff.m[5]);
+    size_t ii = 0;
+    for(; ii+3 < size; ii += 4) {
+        __m256 unit = _mm256_loadu_ps(input+ii*2);
+        __m256 result = _mm256_fmadd_ps(_mm256_moveldup_ps(unit), cx, ct);
+        result = _mm256_fmadd_ps(_mm256_movehdup_ps(unit), cy, result);
+        _mm256_storeu_ps(output+ii*2,result);
+    }
+    transform2_128(aff,input+ii*2,output+ii*2,size-ii);
+}
+
+/**
+ * Transforms an array of 2-element points with 512-bit words.
+ *
+ * This function transforms eight points at a time, masking off the unused
+ * points at the end.  It is safe for output to be the same as input.
+ *
+ * @param aff       The affine transform.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The number of points.
+ */
+CU_TARGET_AVX512 static void transform2_512(const Affine2& aff, float const* input, float* output, size_t size) {
+    const __m512 cx = _mm512_broadcast_f32x4(_mm_setr_ps(aff.m[0],aff.m[1],aff.m[0],aff.m[1]));
+    const __m512 cy = _mm512_broadcast_f32x4(_mm_setr_ps(aff.m[2],aff.m[3],aff.m[2],aff.m[3]));
+    const __m512 ct = _mm512_broadcast_f32x4(_mm_setr_ps(aff.m[4],aff.m[5],aff.m[4],aff.m[5]));
+    for(size_t ii = 0; ii < size; ii += 8) {
+        __mmask16 mask = size-ii >= 8 ? 0xffff : (__mmask16)((1u << (2*(size-ii)))-1);
+        __m512 unit = _mm512_maskz_loadu_ps(mask, input+ii*2);
+        __m512 result = _mm512_fmadd_ps(_mm512_moveldup_ps(unit), cx, ct);
+        result = _mm512_fmadd_ps(_mm512_movehdup_ps(unit), cy, result);
+        _mm512_mask_storeu_ps(output+ii*2, mask, result);
+    }
+}
+#endif
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -945,6 +1057,8 @@ Vec2* Affine2::transform(const Affine2& aff, const Vec2 point, Vec2* dst) {
  * The vector is array is treated as a list of 2 element vectors (@see Vec2).
  * The transform is applied in order and written to the output array.
  *
+ * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+ *
  * @param mat       The transform matrix.
  * @param input     The array of vectors to transform.
  * @param output    The array to store the transformed vectors.
@@ -953,12 +1067,24 @@ Vec2* Affine2::transform(const Affine2& aff, const Vec2 point, Vec2* dst) {
  * @return A reference to dst for chaining
  */
 float* Affine2::transform(const Affine2& aff, float const* input, float* output, size_t size) {
-    for(size_t ii = 0; ii < size; ii++) {
-        float x = aff.m[0]*input[2*ii]+aff.m[2]*input[2*ii+1]+aff.m[4];
-        float y = aff.m[1]*input[2*ii]+aff.m[3]*input[2*ii+1]+aff.m[5];
-        output[2*ii  ] = x;
-        output[2*ii+1] = y;
+    switch (CPUFeatures::getLevel()) {
+#if defined (CU_MATH_VECTOR_AVX)
+        case CPUFeatures::Level::AVX512:
+            transform2_512(aff,input,output,size);
+            return output;
+        case CPUFeatures::Level::AVX2:
+            transform2_256(aff,input,output,size);
+            return output;
+#endif
+#if defined (CU_MATH_VECTOR_SSE) || defined (CU_MATH_VECTOR_NEON64)
+        case CPUFeatures::Level::SIMD128:
+            transform2_128(aff,input,output,size);
+            return output;
+#endif
+        default:
+            break;
     }
+    transform2_scalar(aff,input,output,size);
     return output;
 }
 
@@ -0,0 +1,165 @@
+//
+//  CUCPUFeatures.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides runtime detection of the vector instruction sets
+//  supported by the current processor.  The vectorization flags in
+//  CUMathBase.h are chosen at compile time, and only select 128-bit words
+//  (SSE or Neon 64).  A binary built for a baseline processor would never
+//  use the wider words of a newer one.  The hot math and DSP kernels use
+//  this module to pick the best implementation at runtime instead.
+//
+//  The wider implementations are compiled with function-level target
+//  attributes, so they are only available on x86 processors with GCC or
+//  Clang.  On other platforms the best level is 128-bit vectorization.
+//
+//  This class is a static class, as the processor does not change.  The
+//  active level may be overridden to test each implementation.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/math/CUCPUFeatures.h>
+#include <atomic>
+
+using namespace cugl;
+
+/** The level override (negative for none) */
+static std::atomic<int> _override(-1);
+
+/**
+ * Returns the best level supported by this processor and build.
+ *
+ * This function queries the processor, and should only be called once.
+ *
+ * @return the best level supported by this processor and build.
+ */
+static CPUFeatures::Level detect() {
+#if defined (CU_MATH_VECTOR_AVX)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return CPUFeatures::Level::AVX512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return CPUFeatures::Level::AVX2;
+    }
+    return CPUFeatures::Level::SIMD128;
+#elif defined (CU_MATH_VECTOR_SSE)
+    return CPUFeatures::Level::SIMD128;
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    // Neon is mandatory on 64-bit ARM, but optional on 32-bit ARM
+    AndroidCpuFamily family = android_getCpuFamily();
+    if (family == ANDROID_CPU_FAMILY_ARM64 ||
+        (family == ANDROID_CPU_FAMILY_ARM &&
+         (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0)) {
+        return CPUFeatures::Level::SIMD128;
+    }
+    return CPUFeatures::Level::SCALAR;
+#else
+    return CPUFeatures::Level::SIMD128;
+#endif
+#else
+    return CPUFeatures::Level::SCALAR;
+#endif
+}
+
+#pragma mark -
+#pragma mark Detection
+/**
+ * Returns the best level supported by this processor and build.
+ *
+ * This value ignores any override.  A level is only supported if the
+ * build contains an implementation for it.  So a build without the
+ * CU_VECTORIZE flag always returns SCALAR.
+ *
+ * @return the best level supported by this processor and build.
+ */
+CPUFeatures::Level CPUFeatures::getDetected() {
+    static const Level detected = detect();
+    return detected;
+}
+
+/**
+ * Returns a string representation of the given level.
+ *
+ * @param level The level to name
+ *
+ * @return a string representation of the given level.
+ */
+const char* CPUFeatures::getName(Level level) {
+    switch (level) {
+        case Level::SCALAR:
+            return "scalar";
+        case Level::SIMD128:
+#if defined (CU_MATH_VECTOR_NEON64)
+            return "neon";
+#else
+            return "sse";
+#endif
+        case Level::AVX2:
+            return "avx2";
+        case Level::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+#pragma mark -
+#pragma mark Dispatch
+/**
+ * Returns the level used by the vectorized kernels.
+ *
+ * This is the detected level, unless it has been lowered with
+ * {@link #setLevel}.
+ *
+ * @return the level used by the vectorized kernels.
+ */
+CPUFeatures::Level CPUFeatures::getLevel() {
+    int level = _override.load(std::memory_order_relaxed);
+    return level < 0 ? getDetected() : (Level)level;
+}
+
+/**
+ * Overrides the level used by the vectorized kernels.
+ *
+ * This method is intended for testing each implementation.  If the
+ * level is not supported, the override is not changed and this method
+ * returns false.
+ *
+ * @param level The level to use
+ *
+ * @return true if the override was applied
+ */
+bool CPUFeatures::setLevel(Level level) {
+    if (!isSupported(level)) {
+        return false;
+    }
+    _override.store((int)level, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Restores the level used by the vectorized kernels to the detected one.
+ */
+void CPUFeatures::resetLevel() {
+    _override.store(-1, std::memory_order_relaxed);
+}
@@ -46,6 +46,7 @@
 #include <cugl/util/CUDebug.h>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/math/CUQuaternion.h>
 #include <cugl/math/CUAffine2.h>
 #include <cugl/math/CURect.h>
@@ -402,6 +403,171 @@ static inline void vmatinvq_f32(const Mat4& m, Mat4& out) {
 
 #endif
 
+#pragma mark -
+#pragma mark Batch Kernels
+/**
+ * Transforms an array of 4-element vectors without vectorization.
+ *
+ * The matrix is in column-major order.  It is safe for output to be the
+ * same as input, but it is not safe for output to be the matrix.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors.
+ */
+static void transform4_scalar(const float* mat, float const* input, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        // Handle case where v == dst.
+        float x = input[ii*4] * mat[0] + input[ii*4+1] * mat[4] + input[ii*4+2] * mat[8]  + input[ii*4+3] * mat[12];
+        float y = input[ii*4] * mat[1] + input[ii*4+1] * mat[5] + input[ii*4+2] * mat[9]  + input[ii*4+3] * mat[13];
+        float z = input[ii*4] * mat[2] + input[ii*4+1] * mat[6] + input[ii*4+2] * mat[10] + input[ii*4+3] * mat[14];
+        float w = input[ii*4] * mat[3] + input[ii*4+1] * mat[7] + input[ii*4+2] * mat[11] + input[ii*4+3] * mat[15];
+        
+        output[ii*4  ] = x;
+        output[ii*4+1] = y;
+        output[ii*4+2] = z;
+        output[ii*4+3] = w;
+    }
+}
+
+#if defined (CU_MATH_VECTOR_SSE) || defined (CU_MATH_VECTOR_NEON64)
+/**
+ * Transforms an array of 4-element vectors with 128-bit words.
+ *
+ * Each vector is a linear combination of the matrix columns.  The matrix
+ * is in column-major order.  It is safe for output to be the same as input,
+ * but it is not safe for output to be the matrix.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors.
+ */
+static void transform4_128(const float* mat, float const* input, float* output, size_t size) {
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 c0 = _mm_loadu_ps(mat);
+    const __m128 c1 = _mm_loadu_ps(mat+4);
+    const __m128 c2 = _mm_loadu_ps(mat+8);
+    const __m128 c3 = _mm_loadu_ps(mat+12);
+    for(size_t ii = 0; ii < size; ii++) {
+        __m128 unit = _mm_loadu_ps(input+ii*4);
+        __m128 result = _mm_mul_ps(_mm_shuffle_ps(unit, unit, 0x00), c0);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(unit, unit, 0x55), c1));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(unit, unit, 0xaa), c2));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(unit, unit, 0xff), c3));
+        _mm_storeu_ps(output+ii*4,result);
+    }
+#else
+    const float32x4_t c0 = vld1q_f32(mat);
+    const float32x4_t c1 = vld1q_f32(mat+4);
+    const float32x4_t c2 = vld1q_f32(mat+8);
+    const float32x4_t c3 = vld1q_f32(mat+12);
+    for(size_t ii = 0; ii < size; ii++) {
+        float32x4_t unit = vld1q_f32(input+ii*4);
+        float32x4_t result = vmulq_laneq_f32(c0, unit, 0);
+        result = vfmaq_laneq_f32(result, c1, unit, 1);
+        result = vfmaq_laneq_f32(result, c2, unit, 2);
+        result = vfmaq_laneq_f32(result, c3, unit, 3);
+        vst1q_f32(output+ii*4,result);
+    }
+#endif
+}
+#endif
+
+#if defined (CU_MATH_VECTOR_AVX)
+/**
+ * Transforms an array of 4-element vectors with 256-bit words.
+ *
+ * This function transforms two vectors at a time.  The matrix is in
+ * column-major order.  It is safe for output to be the same as input,
+ * but it is not safe for output to be the matrix.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors.
+ */
+CU_TARGET_AVX2 static void transform4_256(const float* mat, float const* input, float* output, size_t size) {
+    const __m256 c0 = _mm256_broadcast_ps((const __m128*)(mat));
+    const __m256 c1 = _mm256_broadcast_ps((const __m128*)(mat+4));
+    const __m256 c2 = _mm256_broadcast_ps((const __m128*)(mat+8));
+    const __m256 c3 = _mm256_broadcast_ps((const __m128*)(mat+12));
+    size_t ii = 0;
+    for(; ii+1 < size; ii += 2) {
+        __m256 unit = _mm256_loadu_ps(input+ii*4);
+        __m256 result = _mm256_mul_ps(_mm256_permute_ps(unit, 0x00), c0);
+        result = _mm256_fmadd_ps(_mm256_permute_ps(unit, 0x55), c1, result);
+        result = _mm256_fmadd_ps(_mm256_permute_ps(unit, 0xaa), c2, result);
+        result = _mm256_fmadd_ps(_mm256_permute_ps(unit, 0xff), c3, result);
+        _mm256_storeu_ps(output+ii*4,result);
+    }
+    transform4_128(mat,input+ii*4,output+ii*4,size-ii);
+}
+
+/**
+ * Transforms an array of 4-element vectors with 512-bit words.
+ *
+ * This function transforms four vectors at a time, masking off the unused
+ * vectors at the end.  The matrix is in column-major order.  It is safe
+ * for output to be the same as input, but it is not safe for output to be
+ * the matrix.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors.
+ */
+CU_TARGET_AVX512 static void transform4_512(const float* mat, float const* input, float* output, size_t size) {
+    const __m512 c0 = _mm512_broadcast_f32x4(_mm_loadu_ps(mat));
+    const __m512 c1 = _mm512_broadcast_f32x4(_mm_loadu_ps(mat+4));
+    const __m512 c2 = _mm512_broadcast_f32x4(_mm_loadu_ps(mat+8));
+    const __m512 c3 = _mm512_broadcast_f32x4(_mm_loadu_ps(mat+12));
+    for(size_t ii = 0; ii < size; ii += 4) {
+        __mmask16 mask = size-ii >= 4 ? 0xffff : (__mmask16)((1u << (4*(size-ii)))-1);
+        __m512 unit = _mm512_maskz_loadu_ps(mask, input+ii*4);
+        __m512 result = _mm512_mul_ps(_mm512_permute_ps(unit, 0x00), c0);
+        result = _mm512_fmadd_ps(_mm512_permute_ps(unit, 0x55), c1, result);
+        result = _mm512_fmadd_ps(_mm512_permute_ps(unit, 0xaa), c2, result);
+        result = _mm512_fmadd_ps(_mm512_permute_ps(unit, 0xff), c3, result);
+        _mm512_mask_storeu_ps(output+ii*4, mask, result);
+    }
+}
+#endif
+
+/**
+ * Transforms an array of 4-element vectors by the given matrix.
+ *
+ * The implementation is chosen by the level of {@link CPUFeatures}.  The
+ * matrix is in column-major order.  It is safe for output to be the same
+ * as input, but it is not safe for output to be the matrix.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors.
+ */
+static void transform4(const float* mat, float const* input, float* output, size_t size) {
+    switch (CPUFeatures::getLevel()) {
+#if defined (CU_MATH_VECTOR_AVX)
+        case CPUFeatures::Level::AVX512:
+            transform4_512(mat,input,output,size);
+            return;
+        case CPUFeatures::Level::AVX2:
+            transform4_256(mat,input,output,size);
+            return;
+#endif
+#if defined (CU_MATH_VECTOR_SSE) || defined (CU_MATH_VECTOR_NEON64)
+        case CPUFeatures::Level::SIMD128:
+            transform4_128(mat,input,output,size);
+            return;
+#endif
+        default:
+            break;
+    }
+    transform4_scalar(mat,input,output,size);
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -1950,48 +2116,10 @@ float* Mat4::multiply(const float* mat, float scalar, float* dst) {
  * @return A reference to dst for chaining
  */
 Mat4* Mat4::multiply(const Mat4& m1, const Mat4& m2, Mat4* dst) {
-#if defined CU_MATH_VECTOR_SSE
-    __m128 out0x = _mm_lincomb_ps(m1.col[0], m2);
-    __m128 out1x = _mm_lincomb_ps(m1.col[1], m2);
-    __m128 out2x = _mm_lincomb_ps(m1.col[2], m2);
-    __m128 out3x = _mm_lincomb_ps(m1.col[3], m2);
-    dst->col[0] = out0x;
-    dst->col[1] = out1x;
-    dst->col[2] = out2x;
-    dst->col[3] = out3x;
-#elif defined CU_MATH_VECTOR_NEON64
-    float32x4_t out0x = vlcombq_f32(m1.col[0], m2);
-    float32x4_t out1x = vlcombq_f32(m1.col[1], m2);
-    float32x4_t out2x = vlcombq_f32(m1.col[2], m2);
-    float32x4_t out3x = vlcombq_f32(m1.col[3], m2);
-    dst->col[0] = out0x;
-    dst->col[1] = out1x;
-    dst->col[2] = out2x;
-    dst->col[3] = out3x;
-#else
+    // Each column of the product is a column of m1 transformed by m2
     float product[16];
-    product[0]  = m2.m[0] * m1.m[0]  + m2.m[4] * m1.m[1] + m2.m[8]   * m1.m[2]  + m2.m[12] * m1.m[3];
-    product[1]  = m2.m[1] * m1.m[0]  + m2.m[5] * m1.m[1] + m2.m[9]   * m1.m[2]  + m2.m[13] * m1.m[3];
-    product[2]  = m2.m[2] * m1.m[0]  + m2.m[6] * m1.m[1] + m2.m[10]  * m1.m[2]  + m2.m[14] * m1.m[3];
-    product[3]  = m2.m[3] * m1.m[0]  + m2.m[7] * m1.m[1] + m2.m[11]  * m1.m[2]  + m2.m[15] * m1.m[3];
-    
-    product[4]  = m2.m[0] * m1.m[4]  + m2.m[4] * m1.m[5] + m2.m[8]   * m1.m[6]  + m2.m[12] * m1.m[7];
-    product[5]  = m2.m[1] * m1.m[4]  + m2.m[5] * m1.m[5] + m2.m[9]   * m1.m[6]  + m2.m[13] * m1.m[7];
-    product[6]  = m2.m[2] * m1.m[4]  + m2.m[6] * m1.m[5] + m2.m[10]  * m1.m[6]  + m2.m[14] * m1.m[7];
-    product[7]  = m2.m[3] * m1.m[4]  + m2.m[7] * m1.m[5] + m2.m[11]  * m1.m[6]  + m2.m[15] * m1.m[7];
-    
-    product[8]  = m2.m[0] * m1.m[8]  + m2.m[4] * m1.m[9] + m2.m[8]   * m1.m[10] + m2.m[12] * m1.m[11];
-    product[9]  = m2.m[1] * m1.m[8]  + m2.m[5] * m1.m[9] + m2.m[9]   * m1.m[10] + m2.m[13] * m1.m[11];
-    product[10] = m2.m[2] * m1.m[8]  + m2.m[6] * m1.m[9] + m2.m[10]  * m1.m[10] + m2.m[14] * m1.m[11];
-    product[11] = m2.m[3] * m1.m[8]  + m2.m[7] * m1.m[9] + m2.m[11]  * m1.m[10] + m2.m[15] * m1.m[11];
-    
-    product[12] = m2.m[0] * m1.m[12] + m2.m[4] * m1.m[13] + m2.m[8]  * m1.m[14] + m2.m[12] * m1.m[15];
-    product[13] = m2.m[1] * m1.m[12] + m2.m[5] * m1.m[13] + m2.m[9]  * m1.m[14] + m2.m[13] * m1.m[15];
-    product[14] = m2.m[2] * m1.m[12] + m2.m[6] * m1.m[13] + m2.m[10] * m1.m[14] + m2.m[14] * m1.m[15];
-    product[15] = m2.m[3] * m1.m[12] + m2.m[7] * m1.m[13] + m2.m[11] * m1.m[14] + m2.m[15] * m1.m[15];
-    
+    transform4(m2.m, m1.m, product, 4);
     std::memcpy(&(dst->m[0]), &(product[0]), MATRIX_SIZE);
-#endif
     return dst;
 }
 
@@ -2010,27 +2138,9 @@ Mat4* Mat4::multiply(const Mat4& m1, const Mat4& m2, Mat4* dst) {
  * @return A reference to dst for chaining
  */
 float* Mat4::multiply(const float* m1, const float* m2, float* dst) {
+    // Each column of the product is a column of m1 transformed by m2
     float product[16];
-    product[0]  = m2[0] * m1[0]  + m2[4] * m1[1] + m2[8]   * m1[2]  + m2[12] * m1[3];
-    product[1]  = m2[1] * m1[0]  + m2[5] * m1[1] + m2[9]   * m1[2]  + m2[13] * m1[3];
-    product[2]  = m2[2] * m1[0]  + m2[6] * m1[1] + m2[10]  * m1[2]  + m2[14] * m1[3];
-    product[3]  = m2[3] * m1[0]  + m2[7] * m1[1] + m2[11]  * m1[2]  + m2[15] * m1[3];
-    
-    product[4]  = m2[0] * m1[4]  + m2[4] * m1[5] + m2[8]   * m1[6]  + m2[12] * m1[7];
-    product[5]  = m2[1] * m1[4]  + m2[5] * m1[5] + m2[9]   * m1[6]  + m2[13] * m1[7];
-    product[6]  = m2[2] * m1[4]  + m2[6] * m1[5] + m2[10]  * m1[6]  + m2[14] * m1[7];
-    product[7]  = m2[3] * m1[4]  + m2[7] * m1[5] + m2[11]  * m1[6]  + m2[15] * m1[7];
-    
-    product[8]  = m2[0] * m1[8]  + m2[4] * m1[9] + m2[8]   * m1[10] + m2[12] * m1[11];
-    product[9]  = m2[1] * m1[8]  + m2[5] * m1[9] + m2[9]   * m1[10] + m2[13] * m1[11];
-    product[10] = m2[2] * m1[8]  + m2[6] * m1[9] + m2[10]  * m1[10] + m2[14] * m1[11];
-    product[11] = m2[3] * m1[8]  + m2[7] * m1[9] + m2[11]  * m1[10] + m2[15] * m1[11];
-    
-    product[12] = m2[0] * m1[12] + m2[4] * m1[13] + m2[8]  * m1[14] + m2[12] * m1[15];
-    product[13] = m2[1] * m1[12] + m2[5] * m1[13] + m2[9]  * m1[14] + m2[13] * m1[15];
-    product[14] = m2[2] * m1[12] + m2[6] * m1[13] + m2[10] * m1[14] + m2[14] * m1[15];
-    product[15] = m2[3] * m1[12] + m2[7] * m1[13] + m2[11] * m1[14] + m2[15] * m1[15];
-    
+    transform4(m2, m1, product, 4);
     std::memcpy(dst, &(product[0]), MATRIX_SIZE);
     return dst;
 }
@@ -2679,6 +2789,8 @@ Vec4* Mat4::transform(const Mat4& mat, const Vec4 vec, Vec4* dst) {
  * The vector is array is treated as a list of 4 element vectors (@see Vec4).
  * The transform is applied in order and written to the output array.
  *
+ * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+ *
  * @param mat       The transform matrix.
  * @param input     The array of vectors to transform.
  * @param output    The array to store the transformed vectors.
@@ -2688,36 +2800,7 @@ Vec4* Mat4::transform(const Mat4& mat, const Vec4 vec, Vec4* dst) {
  */
 float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_t size) {
     CUAssertLog(output, "Destination vector is null");
-#if defined CU_MATH_VECTOR_SSE
-    __m128 t0 = _mm_unpacklo_ps(mat.col[0], mat.col[1]);
-    __m128 t1 = _mm_unpacklo_ps(mat.col[2], mat.col[3]);
-    __m128 t2 = _mm_unpackhi_ps(mat.col[0], mat.col[1]);
-    __m128 t3 = _mm_unpackhi_ps(mat.col[2], mat.col[3]);
-    __m128 r0 = _mm_movelh_ps(t0, t1);
-    __m128 r1 = _mm_movehl_ps(t1, t0);
-    __m128 r2 = _mm_movelh_ps(t2, t3);
-    __m128 r3 = _mm_movehl_ps(t3, t2);
-
-    for(size_t ii = 0; ii < size; ii++) {
-        __m128 unit = _mm_loadu_ps(input+ii*4);
-        unit = _mm_add_ps(_mm_add_ps(_mm_dp_ps(unit,r0,0xF1),_mm_dp_ps(unit,r1,0xF2)),
-                          _mm_add_ps(_mm_dp_ps(unit,r2,0xF4),_mm_dp_ps(unit,r3,0xF8)));
-        _mm_storeu_ps(output+ii*4,unit);
-    }
-#else
-    for(size_t ii = 0; ii < size; ii++) {
-        // Handle case where v == dst.
-        float x = input[ii*4] * mat.m[0] + input[ii*4+1] * mat.m[4] + input[ii*4+2] * mat.m[8]  + input[ii*4+3] * mat.m[12];
-        float y = input[ii*4] * mat.m[1] + input[ii*4+1] * mat.m[5] + input[ii*4+2] * mat.m[9]  + input[ii*4+3] * mat.m[13];
-        float z = input[ii*4] * mat.m[2] + input[ii*4+1] * mat.m[6] + input[ii*4+2] * mat.m[10] + input[ii*4+3] * mat.m[14];
-        float w = input[ii*4] * mat.m[3] + input[ii*4+1] * mat.m[7] + input[ii*4+2] * mat.m[11] + input[ii*4+3] * mat.m[15];
-        
-        output[ii*4  ] = x;
-        output[ii*4+1] = y;
-        output[ii*4+2] = z;
-        output[ii*4+3] = w;
-    }
-#endif
+    transform4(mat.m, input, output, size);
     return output;
 }
 
@@ -2727,6 +2810,8 @@ float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_
  * The vector is array is treated as a list of 4 element vectors (@see Vec4).
  * The transform is applied in order and written to the output array.
  *
+ * This method uses the vectorized algorithm chosen by {@link CPUFeatures}.
+ *
  * @param mat       The transform matrix in column major order
  * @param input     The array of vectors to transform.
  * @param output    The array to store the transformed vectors.
@@ -2736,18 +2821,7 @@ float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_
  */
 float* Mat4::transform(const float* mat, float const* input, float* output, size_t size) {
     CUAssertLog(output, "Destination vector is null");
-    for(size_t ii = 0; ii < size; ii++) {
-        // Handle case where v == dst.
-        float x = input[ii*4] * mat[0] + input[ii*4+1] * mat[4] + input[ii*4+2] * mat[8]  + input[ii*4+3] * mat[12];
-        float y = input[ii*4] * mat[1] + input[ii*4+1] * mat[5] + input[ii*4+2] * mat[9]  + input[ii*4+3] * mat[13];
-        float z = input[ii*4] * mat[2] + input[ii*4+1] * mat[6] + input[ii*4+2] * mat[10] + input[ii*4+3] * mat[14];
-        float w = input[ii*4] * mat[3] + input[ii*4+1] * mat[7] + input[ii*4+2] * mat[11] + input[ii*4+3] * mat[15];
-        
-        output[ii*4  ] = x;
-        output[ii*4+1] = y;
-        output[ii*4+2] = z;
-        output[ii*4+3] = w;
-    }
+    transform4(mat, input, output, size);
     return output;
 }
 
@@ -386,10 +386,9 @@ Poly2& Poly2::operator*=(const Vec2 scale) {
  * @return This polygon with the vertices transformed
  */
 Poly2& Poly2::operator*=(const Affine2& transform) {
-    Vec2 tmp;
-    for(int ii = 0; ii < _vertices.size(); ii++) {
-        Affine2::transform(transform,_vertices[ii], &tmp);
-        _vertices[ii] = tmp;
+    if (!_vertices.empty()) {
+        float* data = reinterpret_cast<float*>(_vertices.data());
+        Affine2::transform(transform, data, data, _vertices.size());
     }
     
     computeBounds();
@@ -53,6 +53,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUBiquadIIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -215,12 +216,7 @@ void BiquadIIR::reset() {
     _mm_store_ps(_d2+8,     _mm_setr_ps(   0,    0,      1,           0 ));
     _mm_store_ps(_d2+12,    _mm_setr_ps(   0,    0,      0,           1 ));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    {
-#endif
+    if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
         float32x4_t temp;
         temp = {   1,   _c1[4], _c1[5],      _c1[6] };
         vst1q_f32(_d1   , temp);
@@ -750,7 +746,7 @@ size_t BiquadIIR::flush(float* output) {
  */
 void BiquadIIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout, pinn;
         __m128 tmp1, tmp2, tmp3;
         __m128 data, shuf;
@@ -797,12 +793,7 @@ void BiquadIIR::stride(float gain, float* input, float* output, size_t size, uns
         _inns[stride+channel] = pinn[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x2_t pout, pinn;
         float32x4_t tmp1, tmp2, tmp3;
@@ -896,7 +887,7 @@ void BiquadIIR::stride(float gain, float* input, float* output, size_t size, uns
  */
 void BiquadIIR::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout, pinn;
         __m128 tmp1, tmp2, tmp3;
         __m128 data, shuf;
@@ -940,12 +931,7 @@ void BiquadIIR::single(float gain, float* input, float* output, size_t size) {
         _inns[1] = pinn[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x2_t pout, pinn;
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t data, shuf;
@@ -1040,7 +1026,7 @@ void BiquadIIR::single(float gain, float* input, float* output, size_t size) {
  */
 void BiquadIIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout, pinn;
         __m128 tmp1, tmp2, tmp3;
         __m128 data, shuf;
@@ -1082,12 +1068,7 @@ void BiquadIIR::dual(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+0,pinn);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pout, pinn;
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t data, shuf;
@@ -1197,12 +1178,7 @@ void BiquadIIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void BiquadIIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t data, outr;
         float32x4_t tmp1, tmp2, tmp3, shuf;
     
@@ -1336,7 +1312,7 @@ void BiquadIIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void BiquadIIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout1,pout2;
         __m128 pinn1,pinn2;
         __m128 data, temp;
@@ -1371,12 +1347,7 @@ void BiquadIIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+4,pinn1);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pout1,pout2;
         float32x4_t pinn1,pinn2;
         float32x4_t data, temp;
@@ -1470,7 +1441,7 @@ void BiquadIIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void BiquadIIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout1a,pout2a,pout1b,pout2b;
         __m128 pinn1a,pinn2a,pinn1b,pinn2b;
         __m128 data, temp;
@@ -1521,12 +1492,7 @@ void BiquadIIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+12,pinn1b);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pout1a,pout2a,pout1b,pout2b;
         float32x4_t pinn1a,pinn2a,pinn1b,pinn2b;
         float32x4_t data, temp;
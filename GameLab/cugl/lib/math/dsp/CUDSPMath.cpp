@@ -5,9 +5,9 @@
 //  This class is represents a class of static methods for performing basic
 //  DSP calculations, like addition and multiplication.  As with the DSP
 //  filters, this class supports vector optimizations for SSE and Neon 64.
-//  Our implementation is limited to 128-bit words.  While 256-bit (e.g. AVX)
-//  are more performant, they are not better for DSP filters and so we keep
-//  the optimizations at the same level.
+//  Unlike the filters, these methods are not recursive, and so they also
+//  support 256-bit (AVX2) and 512-bit (AVX-512) words.  The word size is
+//  chosen at runtime with CPUFeatures.
 //
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -32,6 +32,7 @@
 //  Version: 10/11/18
 //
 #include <cugl/math/dsp/CUDSPMath.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -41,6 +42,444 @@ using namespace cugl::dsp;
 /** Whether to use a vectorization algorithm */
 bool DSPMath::VECTORIZE = true;
 
+#pragma mark -
+#pragma mark Kernels
+/**
+ * A dispatch table of the arithmetic kernels for a single vectorization level.
+ *
+ * Each kernel processes the entire buffer, including any elements left over
+ * from the vector width.
+ */
+typedef struct {
+    /** Adds two buffers together */
+    void (*add)(float* input1, float* input2, float* output, size_t size);
+    /** Multiplies two buffers together */
+    void (*multiply)(float* input1, float* input2, float* output, size_t size);
+    /** Scales a buffer */
+    void (*scale)(float* input, float scalar, float* output, size_t size);
+    /** Scales a buffer and adds it to another */
+    void (*scale_add)(float* input1, float* input2, float scalar, float* output, size_t size);
+    /** Hard clamps a buffer in place */
+    void (*clamp)(float* data, float min, float max, size_t size);
+    /** Scales an interleaved buffer by a per-frame linear ramp */
+    void (*ramp)(float* input, float start, float step, Uint32 channels, float* output, size_t frames);
+} DSPKernels;
+
+#pragma mark Scalar Kernels
+/** Adds two input signals together without vectorization */
+static void add_scalar(float* input1, float* input2, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        output[ii] = input1[ii]+input2[ii];
+    }
+}
+
+/** Multiplies two input signals together without vectorization */
+static void multiply_scalar(float* input1, float* input2, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        output[ii] = input1[ii]*input2[ii];
+    }
+}
+
+/** Scales an input signal without vectorization */
+static void scale_scalar(float* input, float scalar, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        output[ii] = input[ii]*scalar;
+    }
+}
+
+/** Scales an input signal and adds it to another without vectorization */
+static void scale_add_scalar(float* input1, float* input2, float scalar, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        output[ii] = input1[ii]*scalar+input2[ii];
+    }
+}
+
+/** Hard clamps the data stream without vectorization */
+static void clamp_scalar(float* data, float min, float max, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        data[ii] = std::min(std::max(data[ii],min),max);
+    }
+}
+
+/** Scales an interleaved signal by a per-frame ramp without vectorization */
+static void ramp_scalar(float* input, float start, float step, Uint32 channels, float* output, size_t frames) {
+    for(size_t ii = 0; ii < frames; ii++) {
+        float gain = start+ii*step;
+        for(Uint32 jj = 0; jj < channels; jj++) {
+            output[ii*channels+jj] = input[ii*channels+jj]*gain;
+        }
+    }
+}
+
+/** The kernels without vectorization */
+static const DSPKernels KERNELS_SCALAR = {
+    add_scalar, multiply_scalar, scale_scalar, scale_add_scalar, clamp_scalar, ramp_scalar
+};
+
+/**
+ * Stores the frame offset of each lane of a vector word in lanes.
+ *
+ * The ramp kernels require that the channels divide the vector width,
+ * so that every word starts on a frame boundary.
+ *
+ * @param lanes     The array to store the offsets
+ * @param width     The number of lanes in a vector word
+ * @param channels  The number of interleaved channels
+ */
+static inline void ramp_lanes(float* lanes, Uint32 width, Uint32 channels) {
+    for(Uint32 ii = 0; ii < width; ii++) {
+        lanes[ii] = (float)(ii/channels);
+    }
+}
+
+#if defined (CU_MATH_VECTOR_SSE) || defined (CU_MATH_VECTOR_NEON64)
+#pragma mark 128-bit Kernels
+/** Adds two input signals together with 128-bit words */
+static void add_128(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+3 < size; ii += 4) {
+#if defined (CU_MATH_VECTOR_SSE)
+        _mm_storeu_ps(output+ii, _mm_add_ps(_mm_loadu_ps(input1+ii),_mm_loadu_ps(input2+ii)));
+#else
+        vst1q_f32(output+ii, vaddq_f32(vld1q_f32(input1+ii),vld1q_f32(input2+ii)));
+#endif
+    }
+    add_scalar(input1+ii,input2+ii,output+ii,size-ii);
+}
+
+/** Multiplies two input signals together with 128-bit words */
+static void multiply_128(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+3 < size; ii += 4) {
+#if defined (CU_MATH_VECTOR_SSE)
+        _mm_storeu_ps(output+ii, _mm_mul_ps(_mm_loadu_ps(input1+ii),_mm_loadu_ps(input2+ii)));
+#else
+        vst1q_f32(output+ii, vmulq_f32(vld1q_f32(input1+ii),vld1q_f32(input2+ii)));
+#endif
+    }
+    multiply_scalar(input1+ii,input2+ii,output+ii,size-ii);
+}
+
+/** Scales an input signal with 128-bit words */
+static void scale_128(float* input, float scalar, float* output, size_t size) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 gain = _mm_set1_ps(scalar);
+    for(; ii+3 < size; ii += 4) {
+        _mm_storeu_ps(output+ii, _mm_mul_ps(_mm_loadu_ps(input+ii),gain));
+    }
+#else
+    const float32x4_t gain = vld1q_dup_f32(&scalar);
+    for(; ii+3 < size; ii += 4) {
+        vst1q_f32(output+ii, vmulq_f32(vld1q_f32(input+ii),gain));
+    }
+#endif
+    scale_scalar(input+ii,scalar,output+ii,size-ii);
+}
+
+/** Scales an input signal and adds it to another with 128-bit words */
+static void scale_add_128(float* input1, float* input2, float scalar, float* output, size_t size) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 gain = _mm_set1_ps(scalar);
+    for(; ii+3 < size; ii += 4) {
+        _mm_storeu_ps(output+ii,
+                      _mm_fmadd_ps(_mm_loadu_ps(input1+ii),gain,_mm_loadu_ps(input2+ii)));
+    }
+#else
+    const float32x4_t gain = vld1q_dup_f32(&scalar);
+    for(; ii+3 < size; ii += 4) {
+        vst1q_f32(output+ii,
+                  vmlaq_f32(vld1q_f32(input2+ii),vld1q_f32(input1+ii),gain));
+    }
+#endif
+    scale_add_scalar(input1+ii,input2+ii,scalar,output+ii,size-ii);
+}
+
+/** Hard clamps the data stream with 128-bit words */
+static void clamp_128(float* data, float min, float max, size_t size) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 vmin = _mm_set1_ps(min);
+    const __m128 vmax = _mm_set1_ps(max);
+    for(; ii+3 < size; ii += 4) {
+        _mm_storeu_ps(data+ii, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data+ii),vmin),vmax));
+    }
+#else
+    const float32x4_t vmin = vld1q_dup_f32(&min);
+    const float32x4_t vmax = vld1q_dup_f32(&max);
+    for(; ii+3 < size; ii += 4) {
+        vst1q_f32(data+ii, vminq_f32(vmaxq_f32(vld1q_f32(data+ii),vmin),vmax));
+    }
+#endif
+    clamp_scalar(data+ii,min,max,size-ii);
+}
+
+/** Scales an interleaved signal by a per-frame ramp with 128-bit words */
+static void ramp_128(float* input, float start, float step, Uint32 channels, float* output, size_t frames) {
+    if (channels == 0 || 4 % channels != 0) {
+        ramp_scalar(input,start,step,channels,output,frames);
+        return;
+    }
+    float lanes[4];
+    ramp_lanes(lanes,4,channels);
+    size_t size = frames*channels;
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 offset = _mm_loadu_ps(lanes);
+    const __m128 vstart = _mm_set1_ps(start);
+    const __m128 vstep  = _mm_set1_ps(step);
+    for(; ii+3 < size; ii += 4) {
+        __m128 frame = _mm_add_ps(_mm_set1_ps((float)(ii/channels)),offset);
+        __m128 gain  = _mm_fmadd_ps(frame,vstep,vstart);
+        _mm_storeu_ps(output+ii, _mm_mul_ps(_mm_loadu_ps(input+ii),gain));
+    }
+#else
+    const float32x4_t offset = vld1q_f32(lanes);
+    const float32x4_t vstart = vdupq_n_f32(start);
+    const float32x4_t vstep  = vdupq_n_f32(step);
+    for(; ii+3 < size; ii += 4) {
+        float32x4_t frame = vaddq_f32(vdupq_n_f32((float)(ii/channels)),offset);
+        float32x4_t gain  = vmlaq_f32(vstart,frame,vstep);
+        vst1q_f32(output+ii, vmulq_f32(vld1q_f32(input+ii),gain));
+    }
+#endif
+    size_t done = ii/channels;
+    ramp_scalar(input+ii,start+done*step,step,channels,output+ii,frames-done);
+}
+
+/** The kernels for 128-bit words */
+static const DSPKernels KERNELS_128 = {
+    add_128, multiply_128, scale_128, scale_add_128, clamp_128, ramp_128
+};
+#else
+/** The kernels for 128-bit words (unavailable in this build) */
+static const DSPKernels KERNELS_128 = KERNELS_SCALAR;
+#endif
+
+#if defined (CU_MATH_VECTOR_AVX)
+#pragma mark 256-bit Kernels
+/** Adds two input signals together with 256-bit words */
+CU_TARGET_AVX2 static void add_256(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        _mm256_storeu_ps(output+ii, _mm256_add_ps(_mm256_loadu_ps(input1+ii),_mm256_loadu_ps(input2+ii)));
+    }
+    add_128(input1+ii,input2+ii,output+ii,size-ii);
+}
+
+/** Multiplies two input signals together with 256-bit words */
+CU_TARGET_AVX2 static void multiply_256(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        _mm256_storeu_ps(output+ii, _mm256_mul_ps(_mm256_loadu_ps(input1+ii),_mm256_loadu_ps(input2+ii)));
+    }
+    multiply_128(input1+ii,input2+ii,output+ii,size-ii);
+}
+
+/** Scales an input signal with 256-bit words */
+CU_TARGET_AVX2 static void scale_256(float* input, float scalar, float* output, size_t size) {
+    const __m256 gain = _mm256_set1_ps(scalar);
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        _mm256_storeu_ps(output+ii, _mm256_mul_ps(_mm256_loadu_ps(input+ii),gain));
+    }
+    scale_128(input+ii,scalar,output+ii,size-ii);
+}
+
+/** Scales an input signal and adds it to another with 256-bit words */
+CU_TARGET_AVX2 static void scale_add_256(float* input1, float* input2, float scalar, float* output, size_t size) {
+    const __m256 gain = _mm256_set1_ps(scalar);
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        _mm256_storeu_ps(output+ii,
+                         _mm256_fmadd_ps(_mm256_loadu_ps(input1+ii),gain,_mm256_loadu_ps(input2+ii)));
+    }
+    scale_add_128(input1+ii,input2+ii,scalar,output+ii,size-ii);
+}
+
+/** Hard clamps the data stream with 256-bit words */
+CU_TARGET_AVX2 static void clamp_256(float* data, float min, float max, size_t size) {
+    const __m256 vmin = _mm256_set1_ps(min);
+    const __m256 vmax = _mm256_set1_ps(max);
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        _mm256_storeu_ps(data+ii, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(data+ii),vmin),vmax));
+    }
+    clamp_128(data+ii,min,max,size-ii);
+}
+
+/** Scales an interleaved signal by a per-frame ramp with 256-bit words */
+CU_TARGET_AVX2 static void ramp_256(float* input, float start, float step, Uint32 channels, float* output, size_t frames) {
+    if (channels == 0 || 8 % channels != 0) {
+        ramp_128(input,start,step,channels,output,frames);
+        return;
+    }
+    float lanes[8];
+    ramp_lanes(lanes,8,channels);
+    const __m256 offset = _mm256_loadu_ps(lanes);
+    const __m256 vstart = _mm256_set1_ps(start);
+    const __m256 vstep  = _mm256_set1_ps(step);
+    size_t size = frames*channels;
+    size_t ii = 0;
+    for(; ii+7 < size; ii += 8) {
+        __m256 frame = _mm256_add_ps(_mm256_set1_ps((float)(ii/channels)),offset);
+        __m256 gain  = _mm256_fmadd_ps(frame,vstep,vstart);
+        _mm256_storeu_ps(output+ii, _mm256_mul_ps(_mm256_loadu_ps(input+ii),gain));
+    }
+    size_t done = ii/channels;
+    ramp_128(input+ii,start+done*step,step,channels,output+ii,frames-done);
+}
+
+#pragma mark 512-bit Kernels
+/**
+ * Returns the mask for the first rem elements of a 512-bit word
+ *
+ * @param rem   The number of elements (less than 16)
+ *
+ * @return the mask for the first rem elements of a 512-bit word
+ */
+static inline __mmask16 mask_512(size_t rem) {
+    return (__mmask16)((1u << rem)-1);
+}
+
+/** Adds two input signals together with 512-bit words */
+CU_TARGET_AVX512 static void add_512(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        _mm512_storeu_ps(output+ii, _mm512_add_ps(_mm512_loadu_ps(input1+ii),_mm512_loadu_ps(input2+ii)));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        _mm512_mask_storeu_ps(output+ii, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask,input1+ii),
+                                                             _mm512_maskz_loadu_ps(mask,input2+ii)));
+    }
+}
+
+/** Multiplies two input signals together with 512-bit words */
+CU_TARGET_AVX512 static void multiply_512(float* input1, float* input2, float* output, size_t size) {
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        _mm512_storeu_ps(output+ii, _mm512_mul_ps(_mm512_loadu_ps(input1+ii),_mm512_loadu_ps(input2+ii)));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        _mm512_mask_storeu_ps(output+ii, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask,input1+ii),
+                                                             _mm512_maskz_loadu_ps(mask,input2+ii)));
+    }
+}
+
+/** Scales an input signal with 512-bit words */
+CU_TARGET_AVX512 static void scale_512(float* input, float scalar, float* output, size_t size) {
+    const __m512 gain = _mm512_set1_ps(scalar);
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        _mm512_storeu_ps(output+ii, _mm512_mul_ps(_mm512_loadu_ps(input+ii),gain));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        _mm512_mask_storeu_ps(output+ii, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask,input+ii),gain));
+    }
+}
+
+/** Scales an input signal and adds it to another with 512-bit words */
+CU_TARGET_AVX512 static void scale_add_512(float* input1, float* input2, float scalar, float* output, size_t size) {
+    const __m512 gain = _mm512_set1_ps(scalar);
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        _mm512_storeu_ps(output+ii,
+                         _mm512_fmadd_ps(_mm512_loadu_ps(input1+ii),gain,_mm512_loadu_ps(input2+ii)));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        _mm512_mask_storeu_ps(output+ii, mask,
+                              _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask,input1+ii),gain,
+                                              _mm512_maskz_loadu_ps(mask,input2+ii)));
+    }
+}
+
+/** Hard clamps the data stream with 512-bit words */
+CU_TARGET_AVX512 static void clamp_512(float* data, float min, float max, size_t size) {
+    const __m512 vmin = _mm512_set1_ps(min);
+    const __m512 vmax = _mm512_set1_ps(max);
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        _mm512_storeu_ps(data+ii, _mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(data+ii),vmin),vmax));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        _mm512_mask_storeu_ps(data+ii, mask,
+                              _mm512_min_ps(_mm512_max_ps(_mm512_maskz_loadu_ps(mask,data+ii),vmin),vmax));
+    }
+}
+
+/** Scales an interleaved signal by a per-frame ramp with 512-bit words */
+CU_TARGET_AVX512 static void ramp_512(float* input, float start, float step, Uint32 channels, float* output, size_t frames) {
+    if (channels == 0 || 16 % channels != 0) {
+        ramp_256(input,start,step,channels,output,frames);
+        return;
+    }
+    float lanes[16];
+    ramp_lanes(lanes,16,channels);
+    const __m512 offset = _mm512_loadu_ps(lanes);
+    const __m512 vstart = _mm512_set1_ps(start);
+    const __m512 vstep  = _mm512_set1_ps(step);
+    size_t size = frames*channels;
+    size_t ii = 0;
+    for(; ii+15 < size; ii += 16) {
+        __m512 frame = _mm512_add_ps(_mm512_set1_ps((float)(ii/channels)),offset);
+        __m512 gain  = _mm512_fmadd_ps(frame,vstep,vstart);
+        _mm512_storeu_ps(output+ii, _mm512_mul_ps(_mm512_loadu_ps(input+ii),gain));
+    }
+    if (ii < size) {
+        __mmask16 mask = mask_512(size-ii);
+        __m512 frame = _mm512_add_ps(_mm512_set1_ps((float)(ii/channels)),offset);
+        __m512 gain  = _mm512_fmadd_ps(frame,vstep,vstart);
+        _mm512_mask_storeu_ps(output+ii, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask,input+ii),gain));
+    }
+}
+
+/** The kernels for 256-bit words */
+static const DSPKernels KERNELS_256 = {
+    add_256, multiply_256, scale_256, scale_add_256, clamp_256, ramp_256
+};
+
+/** The kernels for 512-bit words */
+static const DSPKernels KERNELS_512 = {
+    add_512, multiply_512, scale_512, scale_add_512, clamp_512, ramp_512
+};
+#else
+/** The kernels for 256-bit words (unavailable in this build) */
+static const DSPKernels KERNELS_256 = KERNELS_128;
+
+/** The kernels for 512-bit words (unavailable in this build) */
+static const DSPKernels KERNELS_512 = KERNELS_128;
+#endif
+
+/**
+ * Returns the dispatch table for the active vectorization level.
+ *
+ * If {@link DSPMath#VECTORIZE} is false, this is always the scalar table.
+ *
+ * @return the dispatch table for the active vectorization level.
+ */
+static const DSPKernels& kernels() {
+    if (!DSPMath::VECTORIZE) {
+        return KERNELS_SCALAR;
+    }
+    switch (CPUFeatures::getLevel()) {
+        case CPUFeatures::Level::AVX512:
+            return KERNELS_512;
+        case CPUFeatures::Level::AVX2:
+            return KERNELS_256;
+        case CPUFeatures::Level::SIMD128:
+            return KERNELS_128;
+        default:
+            break;
+    }
+    return KERNELS_SCALAR;
+}
+
 #pragma mark -
 #pragma mark Arithmetic Methods
 /**
@@ -56,43 +495,7 @@ bool DSPMath::VECTORIZE = true;
  * @return the number of elements successfully added
  */
 size_t DSPMath::add(float* input1, float* input2, float* output, size_t size) {
-#if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            _mm_storeu_ps(output+ii, _mm_add_ps(_mm_loadu_ps(input1+ii),_mm_loadu_ps(input2+ii)));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(Uint32 ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]+input2[ii];
-            }
-        }
-    } else {
-#elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
-        int ii;
-        for(ii = 0; ii < (int)size-3; ii += 4) {
-            vst1q_f32(output+ii, vaddq_f32(vld1q_f32(input1+ii),vld1q_f32(input2+ii)));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(Uint32 ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]+input2[ii];
-            }
-        }
-    } else {
-#else
-    {
-#endif
-        for(int ii = 0; ii < size; ii++) {
-            output[ii] = input1[ii]+input2[ii];
-        }
-    }
+    kernels().add(input1,input2,output,size);
     return size;
 }
 
@@ -109,42 +512,7 @@ size_t DSPMath::add(float* input1, float* input2, float* output, size_t size) {
  * @return the number of elements successfully multiplied
  */
 size_t DSPMath::multiply(float* input1, float* input2, float* output, size_t size) {
-#if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            _mm_storeu_ps(output+ii, _mm_mul_ps(_mm_loadu_ps(input1+ii),_mm_loadu_ps(input2+ii)));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(Uint32 ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]*input2[ii];
-            }
-        }
-    } else {
-#elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            vst1q_f32(output+ii, vmulq_f32(vld1q_f32(input1+ii),vld1q_f32(input2+ii)));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]*input2[ii];
-            }
-        }
-    } else {
-#else
-    {
-#endif
-        for(int ii = 0; ii < size; ii++) {
-            output[ii] = input1[ii]*input2[ii];
-        }
-    }
+    kernels().multiply(input1,input2,output,size);
     return size;
 }
 
@@ -161,44 +529,7 @@ size_t DSPMath::multiply(float* input1, float* input2, float* output, size_t siz
  * @return the number of elements successfully multiplied
  */
 size_t DSPMath::scale(float* input, float scalar, float* output, size_t size) {
-#if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
-        const __m128 gain = _mm_set1_ps(scalar);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            _mm_storeu_ps(output+ii, _mm_mul_ps(_mm_loadu_ps(input+ii),gain));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input[ii]*scalar;
-            }
-        }
-    } else {
-#elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
-        const float32x4_t gain = vld1q_dup_f32(&scalar);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            vst1q_f32(output+ii, vmulq_f32(vld1q_f32(input+ii),gain));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input[ii]*scalar;
-            }
-        }
-    } else {
-#else
-    {
-#endif
-        for(int ii = 0; ii < size; ii++) {
-            output[ii] = input[ii]*scalar;
-        }
-    }
+    kernels().scale(input,scalar,output,size);
     return size;
 }
 
@@ -216,46 +547,7 @@ size_t DSPMath::scale(float* input, float scalar, float* output, size_t size) {
  * @return the number of elements successfully processed
  */
 size_t DSPMath::scale_add(float* input1, float* input2, float scalar, float* output, size_t size) {
-#if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
-        const __m128 gain = _mm_set1_ps(scalar);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            _mm_storeu_ps(output+ii,
-                          _mm_fmadd_ps(_mm_loadu_ps(input1+ii),gain,_mm_loadu_ps(input2+ii)));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]*scalar+input2[ii];
-            }
-        }
-    } else {
-#elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
-        const float32x4_t gain = vld1q_dup_f32(&scalar);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            vst1q_f32(output+ii,
-                      vmlaq_f32(vld1q_f32(input2+ii),vld1q_f32(input1+ii),gain));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                output[ii] = input1[ii]*scalar+input2[ii];
-            }
-        }
-    } else {
-#else
-    {
-#endif
-        for(int ii = 0; ii < size; ii++) {
-            output[ii] = input1[ii]*scalar+input2[ii];
-        }
-    }
+    kernels().scale_add(input1,input2,scalar,output,size);
     return size;
 }
         
@@ -283,7 +575,7 @@ size_t DSPMath::slide(float* input, float start, float end, float* output, size_
     float step = (end-start)/size;
     float curr = start;
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 left, rght;
         __m128 skip = _mm_setr_ps(0,step,2*step,3*step);
         for(int ii = 0; ii < (int)size-3; ii += 4) {
@@ -301,12 +593,7 @@ size_t DSPMath::slide(float* input, float start, float end, float* output, size_
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t left, rght;
         float32x4_t skip = {0,step,2*step,3*step};
         for(int ii = 0; ii < (int)size-3; ii += 4) {
@@ -356,7 +643,7 @@ size_t DSPMath::slide_add(float* input1, float* input2, float start, float end,
     float step = (end-start)/size;
     float curr = start;
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 left, rght, gain;
         __m128 skip = _mm_setr_ps(0,step,2*step,3*step);
         for(int ii = 0; ii < (int)size-3; ii += 4) {
@@ -375,12 +662,7 @@ size_t DSPMath::slide_add(float* input1, float* input2, float start, float end,
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t left, rght, gain;
         float32x4_t skip = {0,step,2*step,3*step};
         for(int ii = 0; ii < (int)size-3; ii += 4) {
@@ -409,6 +691,33 @@ size_t DSPMath::slide_add(float* input1, float* input2, float start, float end,
     return size;
 }
 
+/**
+ * Scales an interleaved signal by a linear ramp, storing the result in output
+ *
+ * The gain is constant across the channels of each frame.  It is start for
+ * the first frame, and increases by step for each subsequent frame.  Unlike
+ * {@link #slide}, the gain of each frame is computed directly from its
+ * index, so there is no accumulated rounding error and no branching within
+ * a vector word.  The vectorized implementations require that the number of
+ * channels divide the vector width (e.g. mono, stereo, or quadrophonic).
+ * Other channel layouts fall back to a narrower implementation.
+ *
+ * It is safe for output to be the same as the input buffer.
+ *
+ * @param input     The input buffer
+ * @param start     The gain of the first frame
+ * @param step      The change in gain per frame
+ * @param channels  The number of interleaved channels
+ * @param output    The output buffer
+ * @param frames    The number of frames to scale
+ *
+ * @return the number of frames successfully scaled
+ */
+size_t DSPMath::ramp(float* input, float start, float step, Uint32 channels, float* output, size_t frames) {
+    kernels().ramp(input,start,step,channels,output,frames);
+    return frames;
+}
+
         
 #pragma mark -
 #pragma mark Clamp Methods
@@ -423,48 +732,7 @@ size_t DSPMath::slide_add(float* input1, float* input2, float start, float end,
  * @return the number of elements successfully clamped
  */
 size_t DSPMath::clamp(float* data, float min, float max, size_t size) {
-#if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
-        const __m128 vmin = _mm_set1_ps(min);
-        const __m128 vmax = _mm_set1_ps(max);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            _mm_storeu_ps(data+ii, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data+ii),vmin),vmax));
-        }
-        if (size % 4 != 0) {
-            __m128 temp;
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                temp = _mm_min_ss(_mm_max_ss(_mm_set_ss(data[ii]),vmin),vmax);
-                data[ii] = temp[0];
-            }
-        }
-    } else {
-#elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
-        const float32x4_t vmin = vld1q_dup_f32(&min);
-        const float32x4_t vmax = vld1q_dup_f32(&max);
-        for(int ii = 0; ii < (int)size-3; ii += 4) {
-            vst1q_f32(data+ii, vminq_f32(vmaxq_f32(vld1q_f32(data+ii),vmin),vmax));
-        }
-        if (size % 4 != 0) {
-            Uint32 rem = size % 4;
-            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
-                data[ii] = std::min(std::max(data[ii],min),max);
-            }
-        }
-    } else {
-#else
-    {
-#endif
-        for(int ii = 0; ii < size; ii++) {
-            data[ii] = std::min(std::max(data[ii],min),max);
-        }
-    }
+    kernels().clamp(data,min,max,size);
     return size;
 }
 
@@ -487,7 +755,7 @@ size_t DSPMath::clamp(float* data, float min, float max, size_t size) {
 size_t DSPMath::ease(float* data, float bound, float knee, size_t size) {
     float factor = bound*knee-knee*knee;
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         const __m128 gain = _mm_set1_ps(bound);
         const __m128 uppr = _mm_set1_ps(knee);
         const __m128 lowr = _mm_set1_ps(-knee);
@@ -520,12 +788,7 @@ size_t DSPMath::ease(float* data, float bound, float knee, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float bknee = -knee;
         const float32x4_t gain = vld1q_dup_f32(&bound);
         const float32x4_t uppr = vld1q_dup_f32(&knee);
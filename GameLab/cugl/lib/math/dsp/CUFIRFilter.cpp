@@ -47,6 +47,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUFIRFilter.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -401,7 +402,7 @@ size_t FIRFilter::flush(float* output) {
  */
 void FIRFilter::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         size_t bsize = _bval.size();
 
@@ -439,12 +440,7 @@ void FIRFilter::stride(float gain, float* input, float* output, size_t size, uns
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         size_t bsize = _bval.size();
         
@@ -532,7 +528,7 @@ void FIRFilter::stride(float gain, float* input, float* output, size_t size, uns
  */
 void FIRFilter::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 temp, base;
         size_t bsize = _bval.size();
         
@@ -573,12 +569,7 @@ void FIRFilter::single(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         size_t bsize = _bval.size();
         
@@ -669,7 +660,7 @@ void FIRFilter::single(float gain, float* input, float* output, size_t size) {
  */
 void FIRFilter::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 temp, base;
         size_t bsize = _bval.size();
         
@@ -712,12 +703,7 @@ void FIRFilter::dual(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         size_t bsize = _bval.size();
         
@@ -823,12 +809,7 @@ void FIRFilter::dual(float gain, float* input, float* output, size_t size) {
  */
 void FIRFilter::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t temp, base;
         size_t bsize = _bval.size();
         
@@ -914,7 +895,7 @@ void FIRFilter::trio(float gain, float* input, float* output, size_t size) {
  */
 void FIRFilter::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
        __m128 temp;
         size_t bsize = _bval.size();
         
@@ -941,12 +922,7 @@ void FIRFilter::quad(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         size_t bsize = _bval.size();
         
@@ -1028,7 +1004,7 @@ void FIRFilter::quad(float gain, float* input, float* output, size_t size) {
  */
 void FIRFilter::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 temp;
         size_t bsize = _bval.size();
         
@@ -1054,12 +1030,7 @@ void FIRFilter::quart(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         size_t bsize = _bval.size();
         
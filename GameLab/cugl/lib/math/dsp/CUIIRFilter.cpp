@@ -52,6 +52,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUIIRFilter.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -279,12 +280,7 @@ void IIRFilter::reset() {
         _mm_store_ps(_d2+8,     _mm_setr_ps(0,    0,      1,               0));
         _mm_store_ps(_d2+12,    _mm_setr_ps(0,    0,      0,               1));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-        if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-            (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-        {
-#endif
+        if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
             float32x4_t temp;
             temp = {1, _c1[4*asize-4], _c1[4*asize-3], _c1[4*asize-2]};
             vst1q_f32(_d1,    temp);
@@ -332,12 +328,7 @@ void IIRFilter::reset() {
         _mm_store_ps(_d2+8,     _mm_setr_ps(0, 0, 1, 0));
         _mm_store_ps(_d2+12,    _mm_setr_ps(0, 0, 0, 1));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-        if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-            (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-        {
-#endif
+        if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
             float32x4_t temp;
             temp = { 1, 0, 0, 0 };
             vst1q_f32(_d1,    temp);
@@ -724,7 +715,7 @@ size_t IIRFilter::flush(float* output) {
  */
 void IIRFilter::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         __m128 tmp1, tmp2, tmp3;
         __m128 base = _mm_setzero_ps();
@@ -877,12 +868,7 @@ void IIRFilter::stride(float gain, float* input, float* output, size_t size, uns
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t base = {0,0,0,0};
@@ -1112,7 +1098,7 @@ void IIRFilter::stride(float gain, float* input, float* output, size_t size, uns
  */
 void IIRFilter::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 tmp1, tmp2, tmp3;
         __m128 base = _mm_setzero_ps();
         
@@ -1268,12 +1254,7 @@ void IIRFilter::single(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t base = {0,0,0,0};
         
@@ -1503,7 +1484,7 @@ void IIRFilter::single(float gain, float* input, float* output, size_t size) {
  */
 void IIRFilter::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 tmp1, tmp2, tmp3;
         __m128 base = _mm_setzero_ps();
         
@@ -1662,12 +1643,7 @@ void IIRFilter::dual(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t base = {0,0,0,0};
         
@@ -1933,12 +1909,7 @@ void IIRFilter::dual(float gain, float* input, float* output, size_t size) {
  */
 void IIRFilter::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         // This is REALLY complicated code for a negligible speed-up over strideOpt
         float32x4x3_t tmp1, tmp2, tmp3;
         float32x4x3_t base;
@@ -2188,7 +2159,7 @@ void IIRFilter::trio(float gain, float* input, float* output, size_t size) {
  */
 void IIRFilter::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 temp;
         
         size_t asize = _aval.size();
@@ -2243,12 +2214,7 @@ void IIRFilter::quad(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         
         size_t asize = _aval.size();
@@ -2384,7 +2350,7 @@ void IIRFilter::quad(float gain, float* input, float* output, size_t size) {
  */
 void IIRFilter::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
        __m128 temp;
         
         size_t asize = _aval.size();
@@ -2469,12 +2435,7 @@ void IIRFilter::quart(float gain, float* input, float* output, size_t size) {
         }
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t temp, base;
         
         size_t asize = _aval.size();
@@ -51,6 +51,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUOnePoleIIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -167,12 +168,7 @@ void OnePoleIIR::reset() {
     _mm_store_ps(_d2+8,  _mm_setr_ps(0.0f, 0.0f,  1.0f,  0.0f));
     _mm_store_ps(_d2+12, _mm_setr_ps(0.0f, 0.0f,  0.0f,  1.0f));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    {
-#endif
+    if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
         float32x4_t temp;
         temp = {   1,   _c1[0], _c1[1],      _c1[2] };
         vst1q_f32(_d1   , temp);
@@ -559,7 +555,7 @@ size_t OnePoleIIR::flush(float* output) {
  */
 void OnePoleIIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         __m128 data = _mm_setzero_ps();
@@ -592,12 +588,7 @@ void OnePoleIIR::stride(float gain, float* input, float* output, size_t size, un
         _outs[channel] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t tmp1, tmp2, tmp3;
         float prev = _outs[channel];
@@ -663,7 +654,7 @@ void OnePoleIIR::stride(float gain, float* input, float* output, size_t size, un
  */
 void OnePoleIIR::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         
@@ -692,12 +683,7 @@ void OnePoleIIR::single(float gain, float* input, float* output, size_t size) {
         _outs[0] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-         (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
          float32x4_t tmp1, tmp2, tmp3;
          float prev = _outs[0];
         
@@ -762,7 +748,7 @@ void OnePoleIIR::single(float gain, float* input, float* output, size_t size) {
  */
 void OnePoleIIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         prev = _mm_set_ps(_outs[1],_outs[0],0.0f,0.0f);
@@ -792,12 +778,7 @@ void OnePoleIIR::dual(float gain, float* input, float* output, size_t size) {
         _outs[1] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t tmp1, tmp2, tmp3;
         float32x4_t prev = { 0.0f, 0.0f, _outs[0], _outs[1] };
 
@@ -870,12 +851,7 @@ void OnePoleIIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void OnePoleIIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t data, outr;
         float32x4_t tmp1, tmp2, tmp3;
         
@@ -986,7 +962,7 @@ void OnePoleIIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void OnePoleIIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 temp;
         
@@ -1000,12 +976,7 @@ void OnePoleIIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs,prev);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev;
         float32x4_t temp;
         
@@ -1066,7 +1037,7 @@ void OnePoleIIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void OnePoleIIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prva,prvb;
         __m128 temp;
         
@@ -1087,12 +1058,7 @@ void OnePoleIIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs+4,prvb);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prva,prvb;
         float32x4_t temp;
         
@@ -43,6 +43,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUOneZeroFIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -409,7 +410,7 @@ size_t OneZeroFIR::flush(float* output) {
  */
 void OneZeroFIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         __m128 prev, shuf;
         __m128 temp;
@@ -437,12 +438,7 @@ void OneZeroFIR::stride(float gain, float* input, float* output, size_t size, un
         _inns[channel] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t prev = { 0.0f, 0.0f, 0.0f, _inns[channel]};
         float32x4_t temp, data, shuf;
@@ -498,7 +494,7 @@ void OneZeroFIR::stride(float gain, float* input, float* output, size_t size, un
  */
 void OneZeroFIR::single(float gain, float* input, float* output, size_t size) {
  #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev = _mm_set_ps(_inns[0],0,0,0);
         __m128 temp, data, shuf;
         
@@ -516,12 +512,7 @@ void OneZeroFIR::single(float gain, float* input, float* output, size_t size) {
         _inns[0] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = { 0.0f, 0.0f, 0.0f, _inns[0]};
         float32x4_t temp, data, shuf;
         
@@ -575,7 +566,7 @@ void OneZeroFIR::single(float gain, float* input, float* output, size_t size) {
  */
 void OneZeroFIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev = _mm_set_ps(_inns[1],_inns[0],0,0);
         __m128 temp, data, shuf;
         
@@ -591,12 +582,7 @@ void OneZeroFIR::dual(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns,_mm_movehl_ps(_mm_setzero_ps(),prev));
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = { 0.0f, 0.0f, _inns[0], _inns[1]};
         float32x4_t temp, data, shuf;
         
@@ -657,12 +643,7 @@ void OneZeroFIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void OneZeroFIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t prev;
         float32x4x3_t data, temp;
         float32x4_t shuf;
@@ -730,7 +711,7 @@ void OneZeroFIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void OneZeroFIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev = _mm_load_ps(_inns);
         __m128 data, temp;
         
@@ -746,12 +727,7 @@ void OneZeroFIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns,prev);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = vld1q_f32(_inns+0);
         float32x4_t data, temp;
         
@@ -809,7 +785,7 @@ void OneZeroFIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void OneZeroFIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev1 = _mm_load_ps(_inns);
         __m128 prev2 = _mm_load_ps(_inns+4);
         __m128 data, temp;
@@ -831,12 +807,7 @@ void OneZeroFIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+4,prev2);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev1 = vld1q_f32(_inns+0);
         float32x4_t prev2 = vld1q_f32(_inns+4);
         float32x4_t data, temp;
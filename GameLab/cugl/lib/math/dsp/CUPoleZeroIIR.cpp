@@ -44,6 +44,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUPoleZeroIIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -169,12 +170,7 @@ void PoleZeroFIR::reset() {
     _mm_store_ps(_d2+8,  _mm_setr_ps(0.0f, 0.0f,  1.0f,  0.0f));
     _mm_store_ps(_d2+12, _mm_setr_ps(0.0f, 0.0f,  0.0f,  1.0f));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    {
-#endif
+    if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
         float32x4_t temp;
         temp = {   1,   _c1[0], _c1[1],      _c1[2] };
         vst1q_f32(_d1   , temp);
@@ -523,7 +519,7 @@ size_t PoleZeroFIR::flush(float* output) {
  */
 void PoleZeroFIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         __m128 pout = _mm_set1_ps(_outs[channel]);
         __m128 pinn = _mm_set_ps(_inns[channel],0,0,0);
@@ -562,12 +558,7 @@ void PoleZeroFIR::stride(float gain, float* input, float* output, size_t size, u
         _inns[channel] = pinn[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t pinn = { 0, 0, 0, _inns[channel] };
         float pout = _outs[channel];
@@ -644,7 +635,7 @@ void PoleZeroFIR::stride(float gain, float* input, float* output, size_t size, u
  */
 void PoleZeroFIR::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout = _mm_set1_ps(_outs[0]);
         __m128 pinn = _mm_set_ps(_inns[0],0,0,0);
         __m128 tmp1, tmp2, tmp3;
@@ -682,12 +673,7 @@ void PoleZeroFIR::single(float gain, float* input, float* output, size_t size) {
         _inns[0] = pinn[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pinn = { 0, 0, 0, _inns[0] };
         float pout = _outs[0];
         
@@ -762,7 +748,7 @@ void PoleZeroFIR::single(float gain, float* input, float* output, size_t size) {
  */
 void PoleZeroFIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout = _mm_set_ps(_outs[1],_outs[0],0,0);
         __m128 pinn = _mm_set_ps(_inns[1],_inns[0],0,0);
         __m128 tmp1, tmp2, tmp3;
@@ -797,12 +783,7 @@ void PoleZeroFIR::dual(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns,_mm_movehl_ps(_mm_setzero_ps(),pinn));
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x2_t pout = vld1_f32(_outs);
         float32x2_t pinn = vld1_f32(_inns);
         float32x4_t tmp1, tmp2, tmp3;
@@ -882,12 +863,7 @@ void PoleZeroFIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void PoleZeroFIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t data, outr;
         float32x4_t tmp1, tmp2, tmp3, shuf;
         
@@ -1014,7 +990,7 @@ void PoleZeroFIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void PoleZeroFIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout = _mm_load_ps(_outs);
         __m128 pinn = _mm_load_ps(_inns);
         __m128 data, temp;
@@ -1034,12 +1010,7 @@ void PoleZeroFIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs,pout);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pout = vld1q_f32(_outs);
         float32x4_t pinn = vld1q_f32(_inns);
         float32x4_t data, temp;
@@ -1105,7 +1076,7 @@ void PoleZeroFIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void PoleZeroFIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 pout1 = _mm_load_ps(_outs);
         __m128 pout2 = _mm_load_ps(_outs+4);
         __m128 pinn1 = _mm_load_ps(_inns);
@@ -1136,12 +1107,7 @@ void PoleZeroFIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs+4,pout2);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t pout1 = vld1q_f32(_outs);
         float32x4_t pout2 = vld1q_f32(_outs+4);
         float32x4_t pinn1 = vld1q_f32(_inns);
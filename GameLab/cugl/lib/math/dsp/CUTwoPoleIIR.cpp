@@ -50,6 +50,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUTwoPoleIIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -181,12 +182,7 @@ void TwoPoleIIR::reset() {
     _mm_store_ps(_d2+8,     _mm_setr_ps(   0,    0,      1,           0 ));
     _mm_store_ps(_d2+12,    _mm_setr_ps(   0,    0,      0,           1 ));
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if ( android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    {
-#endif
+    if (CPUFeatures::isSupported(CPUFeatures::Level::SIMD128)) {
         float32x4_t temp;
         temp = {   1,   _c1[4], _c1[5],      _c1[6] };
         vst1q_f32(_d1   , temp);
@@ -608,7 +604,7 @@ size_t TwoPoleIIR::flush(float* output) {
  */
 void TwoPoleIIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         __m128 data = _mm_setzero_ps();
@@ -642,12 +638,7 @@ void TwoPoleIIR::stride(float gain, float* input, float* output, size_t size, un
         _outs[stride+channel] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t prev = { 0.0f, 0.0f, _outs[channel], _outs[channel+stride] };
         float32x4_t tmp1, tmp2, tmp3;
@@ -720,7 +711,7 @@ void TwoPoleIIR::stride(float gain, float* input, float* output, size_t size, un
  */
 void TwoPoleIIR::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         
@@ -751,12 +742,7 @@ void TwoPoleIIR::single(float gain, float* input, float* output, size_t size) {
         _outs[1] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = { 0.0f, 0.0f, _outs[0], _outs[1] };
         float32x4_t tmp1, tmp2, tmp3;
         
@@ -828,7 +814,7 @@ void TwoPoleIIR::single(float gain, float* input, float* output, size_t size) {
  */
 void TwoPoleIIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev;
         __m128 tmp1, tmp2, tmp3;
         
@@ -858,12 +844,7 @@ void TwoPoleIIR::dual(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs+0,prev);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = vld1q_f32(_outs+0);
         float32x4_t tmp1, tmp2, tmp3;
         
@@ -941,12 +922,7 @@ void TwoPoleIIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void TwoPoleIIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t prev, data;
         float32x4x3_t outr;
         float32x4_t tmp1, tmp2, tmp3;
@@ -1067,7 +1043,7 @@ void TwoPoleIIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void TwoPoleIIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev1,prev2;
         __m128 temp;
         
@@ -1085,12 +1061,7 @@ void TwoPoleIIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs+4,prev1);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev1,prev2;
         float32x4_t temp;
         
@@ -1162,7 +1133,7 @@ void TwoPoleIIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void TwoPoleIIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev1a,prev1b,prev2a,prev2b;
         __m128 temp;
         
@@ -1190,12 +1161,7 @@ void TwoPoleIIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_outs+12,prev1b);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev1a,prev1b,prev2a,prev2b;
         float32x4_t temp;
         
@@ -43,6 +43,7 @@
 //  Version: 6/11/18
 //
 #include <cugl/math/dsp/CUTwoZeroFIR.h>
+#include <cugl/math/CUCPUFeatures.h>
 #include <cugl/util/CUDebug.h>
 #include "cuDSP128.inl"
 
@@ -447,7 +448,7 @@ size_t TwoZeroFIR::flush(float* output) {
  */
 void TwoZeroFIR::stride(float gain, float* input, float* output, size_t size, unsigned channel) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         __m128 prev, shuf;
         __m128 temp;
@@ -472,12 +473,7 @@ void TwoZeroFIR::stride(float gain, float* input, float* output, size_t size, un
         _inns[stride+channel] = prev[3];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         unsigned stride = _channels;
         float32x4_t prev = { 0.0f, 0.0f, _inns[channel], _inns[channel+stride] };
         float32x4_t temp, data, shuf;
@@ -540,7 +536,7 @@ void TwoZeroFIR::stride(float gain, float* input, float* output, size_t size, un
  */
 void TwoZeroFIR::single(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev = _mm_set_ps(_inns[1], _inns[0],0,0);
         __m128 temp, data, shuf;
         
@@ -561,12 +557,7 @@ void TwoZeroFIR::single(float gain, float* input, float* output, size_t size) {
         _inns[0] = prev[2];
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = { 0.0f, 0.0f, _inns[0], _inns[1] };
         float32x4_t temp, data, shuf;
         
@@ -627,7 +618,7 @@ void TwoZeroFIR::single(float gain, float* input, float* output, size_t size) {
  */
 void TwoZeroFIR::dual(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev = _mm_load_ps(_inns+0);
         __m128 temp, data, shuf;
         
@@ -645,12 +636,7 @@ void TwoZeroFIR::dual(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+0,prev);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev = vld1q_f32(_inns+0);
         float32x4_t temp, data, shuf;
         
@@ -716,12 +702,7 @@ void TwoZeroFIR::dual(float gain, float* input, float* output, size_t size) {
  */
 void TwoZeroFIR::trio(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4x3_t prev;
         float32x4x3_t data, temp;
         float32x4_t shuf;
@@ -799,7 +780,7 @@ void TwoZeroFIR::trio(float gain, float* input, float* output, size_t size) {
  */
 void TwoZeroFIR::quad(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev1 = _mm_load_ps(_inns+4);
         __m128 prev2 = _mm_load_ps(_inns+0);
         __m128 data, temp;
@@ -820,12 +801,7 @@ void TwoZeroFIR::quad(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+4,prev1);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev1 = vld1q_f32(_inns+4);
         float32x4_t prev2 = vld1q_f32(_inns+0);
         float32x4_t data, temp;
@@ -891,7 +867,7 @@ void TwoZeroFIR::quad(float gain, float* input, float* output, size_t size) {
  */
 void TwoZeroFIR::quart(float gain, float* input, float* output, size_t size) {
 #if defined (CU_MATH_VECTOR_SSE)
-    if (VECTORIZE) {
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         __m128 prev1b = _mm_load_ps(_inns+12);
         __m128 prev1a = _mm_load_ps(_inns+8);
         __m128 prev2b = _mm_load_ps(_inns+4);
@@ -922,12 +898,7 @@ void TwoZeroFIR::quart(float gain, float* input, float* output, size_t size) {
         _mm_store_ps(_inns+12,prev1b);
     } else {
 #elif defined (CU_MATH_VECTOR_NEON64)
-#if defined (__ANDROID__)
-    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
-        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
-#else
-    if (VECTORIZE) {
-#endif
+    if (VECTORIZE && CPUFeatures::hasSIMD()) {
         float32x4_t prev1b = vld1q_f32(_inns+12);
         float32x4_t prev1a = vld1q_f32(_inns+8);
         float32x4_t prev2b = vld1q_f32(_inns+4);
@@ -37,6 +37,7 @@
 #include <cugl/math/polygon/CUComplexExtruder.h>
 #include <cugl/math/polygon/CUComplexTriangulator.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/util/CUTimestamp.h>
 #include <iterator>
 
@@ -269,6 +270,7 @@ void ComplexExtruder::clear() {
  * @param stroke    The stroke width of the extrusion
  */
 void ComplexExtruder::calculate(float stroke) {
+    CUMemoryScope(GEOMETRY);
     if (_input.size() == 0) {
         _calculated = true;
         return;
@@ -37,6 +37,7 @@
 //
 #include <cugl/math/polygon/CUComplexTriangulator.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <deque>
 
 using namespace cugl;
@@ -345,6 +346,7 @@ void ComplexTriangulator::clear() {
  * Voronoi dual.
  */
 void ComplexTriangulator::calculate() {
+    CUMemoryScope(GEOMETRY);
     reset();
 
     // Set up the triangulator
@@ -411,6 +413,7 @@ void ComplexTriangulator::calculate() {
  * missing triangles are interpolated.
  */
 void ComplexTriangulator::calculateDual() {
+    CUMemoryScope(GEOMETRY);
     if (!_calculated) {
         calculate();
     }
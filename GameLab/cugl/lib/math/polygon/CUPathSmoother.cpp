@@ -42,19 +42,25 @@
 //
 #include <cugl/math/polygon/CUPathSmoother.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
+#include <algorithm>
 
 using namespace cugl;
 
 /* This makes sense as default for touch coordinates */
 #define DEFAULT_EPSILON 1
+/* The maximum number of unstable points when streaming */
+#define DEFAULT_WINDOW  256
 
 #pragma mark Constructors
 /**
  * Creates a path smoother with no vertex data.
  */
 PathSmoother::PathSmoother() :
+_epsilon(DEFAULT_EPSILON),
 _calculated(false),
-_epsilon(DEFAULT_EPSILON) {
+_window(DEFAULT_WINDOW),
+_streaming(false) {
 }
 
 /**
@@ -66,8 +72,10 @@ _epsilon(DEFAULT_EPSILON) {
  * @param points    The vertices to triangulate
  */
 PathSmoother::PathSmoother(const std::vector<Vec2>& points) :
+_epsilon(DEFAULT_EPSILON),
 _calculated(false),
-_epsilon(DEFAULT_EPSILON) {
+_window(DEFAULT_WINDOW),
+_streaming(false) {
     set(points);
 }
 
@@ -78,7 +86,9 @@ _epsilon(DEFAULT_EPSILON) {
  */
 void PathSmoother::reset() {
     _output.clear();
+    _pending.clear();
     _calculated = false;
+    _streaming = false;
 }
 
 /**
@@ -96,13 +106,138 @@ void PathSmoother::clear() {
  * Performs a triangulation of the current vertex data.
  */
 void PathSmoother::calculate() {
-    douglasPeucker(0,_input.size()-1);
+    CUMemoryScope(GEOMETRY);
+    reset();
+    if (!_input.empty()) {
+        douglasPeucker(0,_input.size()-1);
+    }
+    _calculated = true;
 }
 
 /**
- * Recursively performs Douglas-Peuker on the given input segment
+ * Returns the index of the point farthest from the line through sp and ep.
  *
- * The results will be pulled from _input and placed in _output.
+ * The distance is the perpendicular distance to the (infinite) line. The
+ * points searched are points[0..count-1], and the result is relative to
+ * points. If no point has positive distance, this function returns count
+ * and dmax is 0.  Ties are resolved in favor of the first point, so the
+ * result is the same whether or not the search is vectorized.
+ *
+ * @param points    The points to search
+ * @param count     The number of points to search
+ * @param sp        The start of the line
+ * @param ep        The end of the line
+ * @param dmax      Pointer to store the maximum distance
+ *
+ * @return the index of the point farthest from the line through sp and ep.
+ */
+static size_t farthest_point(const Vec2* points, size_t count, const Vec2 sp, const Vec2 ep, float* dmax) {
+    Vec2 u = ep-sp;
+    float len = u.length();
+    float c1  = ep.x*sp.y;
+    float c2  = ep.y*sp.x;
+    
+    float best = 0;
+    size_t index = count;
+    size_t ii = 0;
+#if defined CU_MATH_VECTOR_SSE
+    if (count >= 8) {
+        // Each lane tracks its own (first) maximum
+        __m128 vbest = _mm_setzero_ps();
+        __m128i vindex = _mm_set1_epi32(-1);
+        __m128i vcurr  = _mm_set_epi32(3,2,1,0);
+        const __m128i four = _mm_set1_epi32(4);
+        const __m128 ux = _mm_set1_ps(u.x);
+        const __m128 uy = _mm_set1_ps(u.y);
+        const __m128 vc1 = _mm_set1_ps(c1);
+        const __m128 vc2 = _mm_set1_ps(c2);
+        const __m128 vlen = _mm_set1_ps(len);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const float* data = reinterpret_cast<const float*>(points);
+        size_t limit = std::min(count & ~(size_t)3, (size_t)0x7fffffff);
+        for(; ii < limit; ii += 4) {
+            __m128 lo = _mm_loadu_ps(data+2*ii);
+            __m128 hi = _mm_loadu_ps(data+2*ii+4);
+            __m128 vx = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2,0,2,0));
+            __m128 vy = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3,1,3,1));
+            __m128 num = _mm_sub_ps(_mm_mul_ps(uy,vx),_mm_mul_ps(ux,vy));
+            num = _mm_sub_ps(_mm_add_ps(num,vc1),vc2);
+            __m128 dist = _mm_andnot_ps(sign,_mm_div_ps(num,vlen));
+            __m128 mask = _mm_cmpgt_ps(dist,vbest);
+            vbest  = _mm_or_ps(_mm_and_ps(mask,dist),_mm_andnot_ps(mask,vbest));
+            __m128i imask = _mm_castps_si128(mask);
+            vindex = _mm_or_si128(_mm_and_si128(imask,vcurr),_mm_andnot_si128(imask,vindex));
+            vcurr  = _mm_add_epi32(vcurr,four);
+        }
+        
+        float lanes[4];
+        Sint32 lindex[4];
+        _mm_storeu_ps(lanes,vbest);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lindex),vindex);
+        for(int jj = 0; jj < 4; jj++) {
+            if (lindex[jj] >= 0 && (lanes[jj] > best || (lanes[jj] == best && (size_t)lindex[jj] < index))) {
+                best  = lanes[jj];
+                index = (size_t)lindex[jj];
+            }
+        }
+    }
+#elif defined CU_MATH_VECTOR_NEON64
+    if (count >= 8) {
+        // Each lane tracks its own (first) maximum
+        float32x4_t vbest = vdupq_n_f32(0);
+        uint32x4_t vindex = vdupq_n_u32(0xffffffff);
+        const uint32_t init[4] = {0,1,2,3};
+        uint32x4_t vcurr  = vld1q_u32(init);
+        const uint32x4_t four = vdupq_n_u32(4);
+        const float32x4_t ux = vdupq_n_f32(u.x);
+        const float32x4_t uy = vdupq_n_f32(u.y);
+        const float32x4_t vc1 = vdupq_n_f32(c1);
+        const float32x4_t vc2 = vdupq_n_f32(c2);
+        const float32x4_t vlen = vdupq_n_f32(len);
+        const float* data = reinterpret_cast<const float*>(points);
+        size_t limit = std::min(count & ~(size_t)3, (size_t)0x7fffffff);
+        for(; ii < limit; ii += 4) {
+            float32x4x2_t v = vld2q_f32(data+2*ii);
+            float32x4_t num = vsubq_f32(vmulq_f32(uy,v.val[0]),vmulq_f32(ux,v.val[1]));
+            num = vsubq_f32(vaddq_f32(num,vc1),vc2);
+            float32x4_t dist = vabsq_f32(vdivq_f32(num,vlen));
+            uint32x4_t mask = vcgtq_f32(dist,vbest);
+            vbest  = vbslq_f32(mask,dist,vbest);
+            vindex = vbslq_u32(mask,vcurr,vindex);
+            vcurr  = vaddq_u32(vcurr,four);
+        }
+        
+        float lanes[4];
+        uint32_t lindex[4];
+        vst1q_f32(lanes,vbest);
+        vst1q_u32(lindex,vindex);
+        for(int jj = 0; jj < 4; jj++) {
+            if (lindex[jj] != 0xffffffff && (lanes[jj] > best || (lanes[jj] == best && lindex[jj] < index))) {
+                best  = lanes[jj];
+                index = lindex[jj];
+            }
+        }
+    }
+#endif
+    for(; ii < count; ii++) {
+        Vec2 v = points[ii];
+        float dist = fabsf((u.y*v.x-u.x*v.y+c1-c2)/len);
+        if (dist > best) {
+            index = ii;
+            best = dist;
+        }
+    }
+    *dmax = best;
+    return index;
+}
+
+/**
+ * Performs Douglas-Peuker on the given input segment
+ *
+ * The results will be pulled from _input and placed in _output. This
+ * method uses an explicit stack, and so it is safe to use on very long
+ * paths. Each split point is only added once, as it is shared by the two
+ * halves of the split.
  *
  * @param start The first position in _input to process
  * @param end   The last position in _input to process
@@ -110,58 +245,151 @@ void PathSmoother::calculate() {
  * @return the number of points preserved in smoothing
  */
 size_t PathSmoother::douglasPeucker(size_t start, size_t end) {
-    const size_t OVER = (size_t)-1;
-    Vec2 sp = _input[start];
-    Vec2 ep = (end == OVER ? _input[0] : _input[end]);
-    if (end - start <= 1 || (end == OVER && start == _input.size()-1)) {
-        _output.push_back(sp);
-        _output.push_back(ep);
-        return 2;
-    } else if (sp == ep) {
-        _output.push_back(sp);
-        size_t index = OVER;
-        for(size_t ii = start+1; index == OVER && ii < end; ii++) {
-            Vec2 v = _input[ii];
-            if (v != sp) {
-                index = ii;
-            }
+    size_t before = _output.size();
+    if (start == end) {
+        _output.push_back(_input[start]);
+        return 1;
+    }
+
+    // Process segments left to right, tracking the last index added
+    const size_t NONE = (size_t)-1;
+    size_t last = NONE;
+    std::vector<std::pair<size_t,size_t>> stack;
+    stack.push_back(std::make_pair(start,end));
+    while (!stack.empty()) {
+        size_t first = stack.back().first;
+        size_t final = stack.back().second;
+        stack.pop_back();
+        
+        Vec2 sp = _input[first];
+        Vec2 ep = _input[final];
+        if (first != last) {
+            _output.push_back(sp);
+            last = first;
         }
-        if (index != OVER) {
-            return douglasPeucker( index, end)+1;
-        } else {
+        
+        if (final - first <= 1) {
             _output.push_back(ep);
-            return 2;
+            last = final;
+        } else if (sp == ep) {
+            // Closed loop: restart at the first distinct point
+            size_t index = NONE;
+            for(size_t ii = first+1; index == NONE && ii < final; ii++) {
+                if (_input[ii] != sp) {
+                    index = ii;
+                }
+            }
+            if (index != NONE) {
+                stack.push_back(std::make_pair(index,final));
+            } else {
+                _output.push_back(ep);
+                last = final;
+            }
+        } else {
+            float dmax = 0;
+            size_t index = farthest_point(_input.data()+first+1, final-first-1, sp, ep, &dmax);
+            if (dmax > _epsilon) {
+                index += first+1;
+                stack.push_back(std::make_pair(index,final));
+                stack.push_back(std::make_pair(first,index));
+            } else {
+                _output.push_back(ep);
+                last = final;
+            }
         }
     }
+    return _output.size()-before;
+}
 
-    float dMax = 0;
-    size_t index = 0;
-    for(size_t ii = start+1; ii < end; ii++) {
-        Vec2 v = _input[ii];
-        Vec2 u = ep-sp;
-        float dist = fabsf((u.y*v.x-u.x*v.y+ep.x*sp.y-ep.y*sp.x)/u.length());
-        if (dist > dMax) {
-            index = ii;
-            dMax = dist;
-        }
-    }
 
-    if (dMax > _epsilon) {
-        size_t result = 0;
-        result += douglasPeucker(start, index);
-        _output.pop_back();
-        result += douglasPeucker(index, end);
-        return result;
-    } else {
-        _output.push_back(sp);
-        _output.push_back(ep);
-        return 2;
+#pragma mark -
+#pragma mark Streaming
+/**
+ * Starts a streaming simplification, clearing all data.
+ *
+ * In streaming mode, points are added one at a time with {@link addPoint}.
+ * As soon as a vertex of the simplified path can no longer change, it is
+ * appended to the path returned by {@link getStablePath}.  This allows a
+ * game to simplify a stroke while it is being drawn, without storing every
+ * point of the stroke.
+ *
+ * Streaming uses a greedy variation of Douglas-Peucker.  Every input point
+ * is within epsilon of the simplified path, but the result may have a few
+ * more vertices than {@link calculate} would produce on the same input.
+ */
+void PathSmoother::beginStream() {
+    clear();
+    _pending.clear();
+    _streaming = true;
+}
+
+/**
+ * Adds a point to a streaming simplification.
+ *
+ * This method returns the number of vertices that became stable as a
+ * result of this point (typically 0 or 1).  Those vertices are at the end
+ * of {@link getStablePath}.  The last point added is never stable until
+ * {@link endStream} is called.
+ *
+ * @param point The point to add
+ *
+ * @return the number of vertices that became stable
+ */
+size_t PathSmoother::addPoint(const Vec2 point) {
+    CUAssertLog(_streaming, "Smoother is not in streaming mode");
+    if (_output.empty()) {
+        _output.push_back(point);
+        return 1;
+    } else if (point == (_pending.empty() ? _output.back() : _pending.back())) {
+        return 0;
     }
     
+    // Check the points since the anchor against the new segment
+    bool split = _pending.size() >= _window;
+    if (!split && !_pending.empty()) {
+        const Vec2 anchor = _output.back();
+        float dmax = 0;
+        if (anchor == point) {
+            for(auto it = _pending.begin(); !split && it != _pending.end(); ++it) {
+                split = it->distance(anchor) > _epsilon;
+            }
+        } else {
+            farthest_point(_pending.data(), _pending.size(), anchor, point, &dmax);
+            split = dmax > _epsilon;
+        }
+    }
+    
+    if (split) {
+        _output.push_back(_pending.back());
+        _pending.clear();
+        _pending.push_back(point);
+        return 1;
+    }
+    _pending.push_back(point);
     return 0;
 }
 
-
+/**
+ * Completes a streaming simplification.
+ *
+ * The last point added becomes stable, and the path may be accessed by
+ * any of the materialization methods.  This method returns the number of
+ * vertices that became stable (0 or 1).
+ *
+ * @return the number of vertices that became stable
+ */
+size_t PathSmoother::endStream() {
+    CUAssertLog(_streaming, "Smoother is not in streaming mode");
+    size_t result = 0;
+    if (!_pending.empty()) {
+        _output.push_back(_pending.back());
+        _pending.clear();
+        result = 1;
+    }
+    _streaming = false;
+    _calculated = true;
+    return result;
+}
 #pragma mark -
 #pragma mark Materialization
 /**
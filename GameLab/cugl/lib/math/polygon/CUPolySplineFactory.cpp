@@ -34,6 +34,7 @@
 //  Version: 6/22/16
 #include <cugl/math/polygon/CUPolySplineFactory.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <iterator>
 
 /** Tolerance to identify a point as "smooth" */
@@ -63,6 +64,7 @@ using namespace cugl;
  * @return a list of vertices approximating this spline
  */
 void PolySplineFactory::calculate(Criterion criterion, float tolerance) {
+    CUMemoryScope(GEOMETRY);
     reset();
     if (!_spline) { return; }
     
@@ -43,6 +43,7 @@
 //
 #include <cugl/math/polygon/CUSimpleExtruder.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <iterator>
 
 /** The number of segments to use in a rounded joint */
@@ -270,6 +271,7 @@ void SimpleExtruder::clear() {
  * @param stroke    The stroke width of the extrusion
  */
 void SimpleExtruder::calculate(float stroke) {
+    CUMemoryScope(GEOMETRY);
     if (_input.size() == 0) {
         _calculated = true;
         return;
@@ -304,7 +306,7 @@ void SimpleExtruder::calculate(float stroke) {
         // Initialize the data
         data.stroke = stroke;
         data.joint = _joint;
-        data.cap = _endcap;
+        data.cap = _truecap;
         
         // Iterate through the path
         data.angle = data.sangle = 0;
@@ -370,7 +372,7 @@ void SimpleExtruder::computeSize(Uint32 insize, Uint32* vcount, Uint32* icount)
             break;
     }
     
-    switch (_endcap) {
+    switch (_truecap) {
         case poly2::EndCap::SQUARE:
             *icount += 12;
             *vcount += 4;
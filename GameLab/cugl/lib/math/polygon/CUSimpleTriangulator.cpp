@@ -37,6 +37,7 @@
 
 #include <cugl/math/polygon/CUSimpleTriangulator.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <iterator>
 
 /** Computes the previous index in a vector, treating it as a circular queue */
@@ -82,6 +83,7 @@ void SimpleTriangulator::set(const Poly2& poly) {
  * Performs a triangulation of the current vertex data.
  */
 void SimpleTriangulator::calculate() {
+    CUMemoryScope(GEOMETRY);
     reset();
     int vcount = (int)_input.size();
     
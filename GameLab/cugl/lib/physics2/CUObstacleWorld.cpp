@@ -44,10 +44,15 @@
 //  Version: 11/1/16
 
 #include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <cugl/physics2/CUObstacleWorld.h>
 #include <cugl/physics2/CUObstacle.h>
+#include <cugl/util/CUMemoryTracker.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -56,6 +61,16 @@ using namespace cugl::physics2;
 
 /** The default value of gravity (going down) */
 #define DEFAULT_GRAVITY -9.8f
+/** The default contact buffer mask (all categories) */
+#define DEFAULT_EVENT_MASK  0xFFFF
+/** The default size of a level of detail cell */
+#define DEFAULT_CELL_SIZE   16.0f
+/** The default number of active cells around a focus point */
+#define DEFAULT_LOD_RANGE   2
+/** The default number of obstacles to thaw per update */
+#define DEFAULT_THAW_BUDGET 256
+/** The default number of obstacles to test for freezing per update */
+#define DEFAULT_FREEZE_BUDGET 1024
 
 #pragma mark -
 #pragma mark Proxy Classes
@@ -165,11 +180,20 @@ ObstacleWorld::ObstacleWorld() :
 _world(nullptr),
 _collide(false),
 _filters(false),
-_destroy(false) {
+_destroy(false),
+_buffered(false),
+_eventMask(DEFAULT_EVENT_MASK),
+_lod(false),
+_cellSize(DEFAULT_CELL_SIZE),
+_lodRange(DEFAULT_LOD_RANGE),
+_thawBudget(DEFAULT_THAW_BUDGET),
+_freezeBudget(DEFAULT_FREEZE_BUDGET),
+_lodCursor(0) {
     _lockstep   = false;
     _stepssize  = DEFAULT_WORLD_STEP;
     _itvelocity = DEFAULT_WORLD_VELOC;
     _itposition = DEFAULT_WORLD_POSIT;
+    _batched    = false;
     _gravity = Vec2(0,DEFAULT_GRAVITY);
     
     onBeginContact = nullptr;
@@ -190,6 +214,11 @@ void ObstacleWorld::dispose() {
         delete _world;
         _world  = nullptr;
     }
+    _buffered = false;
+    _eventMask = DEFAULT_EVENT_MASK;
+    _events.clear();
+    _lod = false;
+    _focus.clear();
     onBeginContact = nullptr;
     onEndContact   = nullptr;
     beforeSolve    = nullptr;
@@ -230,10 +259,13 @@ bool ObstacleWorld::init(const Rect bounds) {
  * @return  true if the controller is initialized properly, false otherwise.
  */
 bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity) {
+    CUMemoryScope(PHYSICS);
     CUAssertLog(!_world,"Attempt to reinitialize and active world");
     _bounds = bounds;
+    _gravity = gravity;
     _world = new b2World(b2Vec2(gravity.x,gravity.y));
     if (_world) {
+        _world->SetBatchedContacts(_batched);
         return true;
     }
     return false;
@@ -256,6 +288,7 @@ bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity) {
  * param obj The obstacle to add
  */
 void ObstacleWorld::addObstacle(const std::shared_ptr<Obstacle>& obj) {
+    CUMemoryScope(PHYSICS);
     CUAssertLog(inBounds(obj.get()), "Obstacle is not in bounds");
     _objects.push_back(obj);
     obj->activatePhysics(*_world);
@@ -278,6 +311,7 @@ void ObstacleWorld::addObstacle(const std::shared_ptr<Obstacle>& obj) {
 void ObstacleWorld::removeObstacle(Obstacle* obj) {
     for(auto it = _objects.begin(); it != _objects.end(); ++it) {
         if (it->get() == obj) {
+            forgetObstacle(obj);
             obj->deactivatePhysics(*_world);
             _objects.erase(it);
             return;
@@ -299,6 +333,7 @@ void ObstacleWorld::garbageCollect() {
     size_t pos = 0;
     for(size_t ii = 0; ii < _objects.size(); ii++) {
         if (_objects[ii]->isRemoved()) {
+            forgetObstacle(_objects[ii].get());
             _objects[ii]->deactivatePhysics(*_world);
             _objects[ii] = nullptr;
         } else {
@@ -325,6 +360,9 @@ void ObstacleWorld::clear() {
         obj->deactivatePhysics(*_world);
     }
     _objects.clear();
+    _cells.clear();
+    _frozen.clear();
+    _lodCursor = 0;
 }
 
 
@@ -345,6 +383,27 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
     }
 }
 
+/**
+ * Sets whether the contact solver uses SIMD batches.
+ *
+ * The batched solver groups contacts that share no dynamic bodies, and
+ * solves four of them at once (using SSE2 or NEON where available). The
+ * results differ from the sequential solver only in the order that the
+ * contacts are solved, so simulations are equivalent but not identical.
+ * It is most effective for large stacks and piles.  This is false by
+ * default.
+ *
+ * Any change will take effect at the time of the next call to update.
+ *
+ * @param  flag whether the contact solver uses SIMD batches.
+ */
+void ObstacleWorld::setBatchedSolver(bool flag) {
+    _batched = flag;
+    if (_world != nullptr) {
+        _world->SetBatchedContacts(flag);
+    }
+}
+
 /**
  * Executes a single step of the physics engine.
  *
@@ -360,7 +419,12 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
  * @param delta Number of seconds since last animation frame
  */
 void ObstacleWorld::update(float dt) {
+    CUMemoryScope(PHYSICS);
     // Turn the physics engine crank.
+    _events.clear();
+    if (_lod) {
+        updateLevelOfDetail();
+    }
     _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
     
     // Post process all objects after physics (this updates graphics)
@@ -387,6 +451,208 @@ bool ObstacleWorld::inBounds(Obstacle* obj) {
     return horiz && vert;
 }
 
+#pragma mark -
+#pragma mark Simulation Level of Detail
+
+/**
+ * Activates the simulation level of detail.
+ *
+ * When active, the world is partitioned into square cells, and dynamic
+ * obstacles that are far from every focus point are frozen.  A frozen
+ * obstacle is deactivated in Box2d, so it costs nothing to simulate, but
+ * it keeps its position, velocity, and all other state.  As the focus
+ * points move, frozen obstacles in range are thawed incrementally, with
+ * at most {@link getThawBudget} obstacles thawed per {@link update}.
+ *
+ * Only obstacles that are active when they are tested are frozen, so
+ * obstacles deactivated by the game are never thawed by this world.
+ * Disabling the level of detail thaws every frozen obstacle.
+ *
+ * @param  flag whether to activate the simulation level of detail.
+ */
+void ObstacleWorld::activateLevelOfDetail(bool flag) {
+    if (_lod == flag) {
+        return;
+    }
+    if (!flag) {
+        thawAll();
+    }
+    _lod = flag;
+    _lodCursor = 0;
+}
+
+/**
+ * Sets the width and height of a level of detail cell.
+ *
+ * This value is in Box2d coordinates.  Changing the cell size thaws every
+ * frozen obstacle, and so should be done before the level is populated.
+ *
+ * @param  size the width and height of a level of detail cell.
+ */
+void ObstacleWorld::setCellSize(float size) {
+    CUAssertLog(size > 0, "Cell size must be positive");
+    if (_cellSize == size) {
+        return;
+    }
+    thawAll();
+    _cellSize = size;
+}
+
+/**
+ * Returns the key of the cell containing the given position.
+ *
+ * @param  pos  the position in Box2d coordinates
+ *
+ * @return the key of the cell containing the given position.
+ */
+Uint64 ObstacleWorld::getCellKey(const Vec2 pos) const {
+    Sint32 x = (Sint32)std::floor(pos.x/_cellSize);
+    Sint32 y = (Sint32)std::floor(pos.y/_cellSize);
+    return ((Uint64)(Uint32)x << 32) | (Uint64)(Uint32)y;
+}
+
+/**
+ * Returns true if the given cell is out of range of every focus point.
+ *
+ * The distance is measured in cells, using the maximum of the horizontal
+ * and vertical distance.  The slack is added to the active range, and is
+ * used to keep obstacles on the boundary from toggling every frame.
+ *
+ * @param  key      the cell key
+ * @param  slack    the number of cells to add to the active range
+ *
+ * @return true if the given cell is out of range of every focus point.
+ */
+bool ObstacleWorld::isDistantCell(Uint64 key, Uint32 slack) const {
+    if (_focus.empty()) {
+        return false;
+    }
+    
+    Sint64 x = (Sint32)(Uint32)(key >> 32);
+    Sint64 y = (Sint32)(Uint32)(key & 0xFFFFFFFF);
+    Sint64 range = (Sint64)_lodRange+slack;
+    for(auto it = _focus.begin(); it != _focus.end(); ++it) {
+        Uint64 fkey = getCellKey(*it);
+        Sint64 fx = (Sint32)(Uint32)(fkey >> 32);
+        Sint64 fy = (Sint32)(Uint32)(fkey & 0xFFFFFFFF);
+        if (std::abs(x-fx) <= range && std::abs(y-fy) <= range) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Freezes and thaws obstacles according to the current focus points.
+ *
+ * This method is called at the start of every {@link update}.  It tests
+ * at most {@link getFreezeBudget} obstacles for freezing, and thaws at
+ * most {@link getThawBudget} obstacles near the focus points.
+ */
+void ObstacleWorld::updateLevelOfDetail() {
+    // Thaw the cells in range of a focus point
+    Uint32 thawed = 0;
+    auto thaw = [&](std::unordered_map<Uint64, std::vector<Obstacle*>>::iterator it) {
+        std::vector<Obstacle*>& cell = it->second;
+        while (!cell.empty() && thawed < _thawBudget) {
+            Obstacle* obj = cell.back();
+            cell.pop_back();
+            _frozen.erase(obj);
+            obj->setActive(true);
+            thawed++;
+        }
+        return cell.empty() ? _cells.erase(it) : std::next(it);
+    };
+    
+    if (_focus.empty()) {
+        // Everything is in range
+        for(auto it = _cells.begin(); it != _cells.end() && thawed < _thawBudget; ) {
+            it = thaw(it);
+        }
+    } else {
+        // Look up the neighboring cells rather than scanning them all
+        Sint64 range = _lodRange;
+        for(auto ft = _focus.begin(); ft != _focus.end() && !_cells.empty(); ++ft) {
+            Uint64 fkey = getCellKey(*ft);
+            Sint64 fx = (Sint32)(Uint32)(fkey >> 32);
+            Sint64 fy = (Sint32)(Uint32)(fkey & 0xFFFFFFFF);
+            for(Sint64 x = fx-range; x <= fx+range && thawed < _thawBudget; x++) {
+                for(Sint64 y = fy-range; y <= fy+range && thawed < _thawBudget; y++) {
+                    Uint64 key = ((Uint64)(Uint32)x << 32) | (Uint64)(Uint32)y;
+                    auto it = _cells.find(key);
+                    if (it != _cells.end()) {
+                        thaw(it);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Round-robin scan for obstacles to freeze
+    size_t total = _objects.size();
+    if (total == 0 || _focus.empty()) {
+        return;
+    }
+    
+    size_t tests = std::min((size_t)_freezeBudget,total);
+    for(size_t ii = 0; ii < tests; ii++) {
+        if (_lodCursor >= total) {
+            _lodCursor = 0;
+        }
+        Obstacle* obj = _objects[_lodCursor++].get();
+        if (obj->getBodyType() == b2_staticBody || !obj->isActive() || obj->isRemoved()) {
+            continue;
+        }
+        Uint64 key = getCellKey(obj->getPosition());
+        if (isDistantCell(key,1)) {
+            obj->setActive(false);
+            _cells[key].push_back(obj);
+            _frozen[obj] = key;
+        }
+    }
+}
+
+/**
+ * Removes the given obstacle from the level of detail bookkeeping.
+ *
+ * This method does not change whether the obstacle is active.  It is
+ * called whenever an obstacle is removed from the world.
+ *
+ * @param  obj  the obstacle to forget
+ */
+void ObstacleWorld::forgetObstacle(Obstacle* obj) {
+    auto jt = _frozen.find(obj);
+    if (jt == _frozen.end()) {
+        return;
+    }
+    
+    auto kt = _cells.find(jt->second);
+    if (kt != _cells.end()) {
+        std::vector<Obstacle*>& cell = kt->second;
+        auto pos = std::find(cell.begin(), cell.end(), obj);
+        if (pos != cell.end()) {
+            *pos = cell.back();
+            cell.pop_back();
+        }
+        if (cell.empty()) {
+            _cells.erase(kt);
+        }
+    }
+    _frozen.erase(jt);
+}
+
+/**
+ * Immediately thaws all of the frozen obstacles.
+ */
+void ObstacleWorld::thawAll() {
+    for(auto it = _frozen.begin(); it != _frozen.end(); ++it) {
+        it->first->setActive(true);
+    }
+    _frozen.clear();
+    _cells.clear();
+}
+
+
 #pragma mark -
 #pragma mark Callback Activation
 
@@ -403,10 +669,37 @@ void ObstacleWorld::activateCollisionCallbacks(bool flag) {
         return;
     }
     
-    _world->SetContactListener(flag ? this : nullptr);
+    _world->SetContactListener(flag || _buffered ? this : nullptr);
     _collide = flag;
 }
 
+/**
+ * Activates the contact event buffer.
+ *
+ * When the buffer is active, the begin contact, end contact, and post
+ * solve events are recorded in a {@link ContactBuffer} instead of calling
+ * {@link onBeginContact}, {@link onEndContact}, and {@link afterSolve}.
+ * This keeps the indirect calls out of the solver, and allows game code
+ * to safely modify the world while processing the events.  The events of
+ * the most recent call to {@link update} are available via
+ * {@link getContactEvents}.
+ *
+ * The {@link beforeSolve} callback is not buffered, as it is used to
+ * modify contacts before they are solved.  It is still called if the
+ * collision callbacks are active.
+ *
+ * @param  flag whether to activate the contact event buffer.
+ */
+void ObstacleWorld::activateContactBuffer(bool flag) {
+    if (_buffered == flag) {
+        return;
+    }
+    
+    _world->SetContactListener(flag || _collide ? this : nullptr);
+    _buffered = flag;
+    _events.clear();
+}
+
 /**
  * Activates the collision filter callbacks.
  *
@@ -443,6 +736,88 @@ void ObstacleWorld::activateDestructionCallbacks(bool flag) {
 }
 
 
+#pragma mark -
+#pragma mark Contact Buffer
+/**
+ * Removes all events from this buffer, preserving its capacity.
+ */
+void ContactBuffer::clear() {
+    type.clear();
+    obstacleA.clear();
+    obstacleB.clear();
+    fixtureA.clear();
+    fixtureB.clear();
+    point.clear();
+    normal.clear();
+    impulse.clear();
+}
+
+/**
+ * Reserves space for the given number of events.
+ *
+ * @param capacity  The number of events to reserve
+ */
+void ContactBuffer::reserve(size_t capacity) {
+    type.reserve(capacity);
+    obstacleA.reserve(capacity);
+    obstacleB.reserve(capacity);
+    fixtureA.reserve(capacity);
+    fixtureB.reserve(capacity);
+    point.reserve(capacity);
+    normal.reserve(capacity);
+    impulse.reserve(capacity);
+}
+
+/**
+ * Records a contact event in the buffer.
+ *
+ * The event is only recorded if the category bits of either fixture
+ * intersect the event mask.
+ *
+ * @param  type     the event type
+ * @param  contact  the contact information
+ * @param  impulse  the impulse produced by the solver (may be nullptr)
+ */
+void ObstacleWorld::recordContact(ContactEventType type, b2Contact* contact, const b2ContactImpulse* impulse) {
+    b2Fixture* fixA = contact->GetFixtureA();
+    b2Fixture* fixB = contact->GetFixtureB();
+    Uint16 bits = fixA->GetFilterData().categoryBits | fixB->GetFilterData().categoryBits;
+    if ((bits & _eventMask) == 0) {
+        return;
+    }
+    
+    Vec2 point;
+    Vec2 normal;
+    int count = contact->GetManifold()->pointCount;
+    if (count > 0) {
+        b2WorldManifold manifold;
+        contact->GetWorldManifold(&manifold);
+        normal.set(manifold.normal.x,manifold.normal.y);
+        for(int ii = 0; ii < count; ii++) {
+            point.x += manifold.points[ii].x;
+            point.y += manifold.points[ii].y;
+        }
+        point /= (float)count;
+    }
+    
+    float total = 0;
+    if (impulse != nullptr) {
+        for(int ii = 0; ii < impulse->count; ii++) {
+            total += impulse->normalImpulses[ii];
+        }
+    }
+    
+    _events.type.push_back(type);
+    _events.obstacleA.push_back((Obstacle*)fixA->GetBody()->GetUserData());
+    _events.obstacleB.push_back((Obstacle*)fixB->GetBody()->GetUserData());
+    _events.fixtureA.push_back(fixA);
+    _events.fixtureB.push_back(fixB);
+    _events.point.push_back(point);
+    _events.normal.push_back(normal);
+    _events.impulse.push_back(total);
+}
+
+
 #pragma mark -
 #pragma mark Query Functions
 
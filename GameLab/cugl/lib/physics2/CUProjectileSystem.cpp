@@ -0,0 +1,252 @@
+//
+//  CUProjectileSystem.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a simulator for large numbers of fast projectiles.
+//  A bullet in Box2D must be a body with continuous collision detection, and
+//  every such body is handled separately by the time of impact solver.  That
+//  does not scale to thousands of bullets.  Instead, the projectiles in this
+//  module are plain data records.  Each step, every projectile is advanced
+//  with a ray cast (against the broadphase of an ObstacleWorld) that sweeps
+//  the path it travels.  Projectiles never become bodies, but they can still
+//  push the bodies that they hit.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/8/21
+//
+#include <cugl/physics2/CUObstacle.h>
+#include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/physics2/CUProjectileSystem.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <algorithm>
+
+using namespace cugl;
+using namespace cugl::physics2;
+
+#pragma mark -
+#pragma mark Proxy Classes
+
+/**
+ * A b2RayCastCallback that finds the closest fixture hit by a projectile.
+ *
+ * Unlike the proxy in ObstacleWorld, this class does not use a closure.
+ * A single instance is reused for every projectile in a step.
+ */
+class ProjectileProxy : public b2RayCastCallback {
+public:
+    /** The category bits of the fixtures that can be hit */
+    Uint16 mask;
+    /** The closest fixture hit (or nullptr for none) */
+    b2Fixture* fixture;
+    /** The point of impact */
+    b2Vec2 point;
+    /** The surface normal at the point of impact */
+    b2Vec2 normal;
+    
+    /**
+     * Resets this proxy for a new projectile.
+     *
+     * @param  bits the category bits of the fixtures that can be hit
+     */
+    void reset(Uint16 bits) {
+        mask = bits;
+        fixture = nullptr;
+    }
+    
+    /**
+     * Called for each fixture found in the query.
+     *
+     * Sensors and fixtures outside of the mask are ignored.  Otherwise the
+     * ray is clipped at this fixture, so that the last fixture reported is
+     * the closest one.
+     *
+     * @param  fixture  the fixture hit by the ray
+     * @param  point    the point of initial intersection
+     * @param  normal   the normal vector at the point of intersection
+     * @param  fraction the fraction along the ray
+     *
+     * @return -1 to filter, or the fraction to clip the ray
+     */
+    float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction) override {
+        if (fixture->IsSensor() || (fixture->GetFilterData().categoryBits & mask) == 0) {
+            return -1;
+        }
+        this->fixture = fixture;
+        this->point  = point;
+        this->normal = normal;
+        return fraction;
+    }
+};
+
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Initializes a new projectile system for the given ObstacleWorld
+ *
+ * This world can never change.  If you want projectiles for a different
+ * ObstacleWorld, make a new instance.
+ *
+ * @param world     the physics controller
+ * @param capacity  the number of projectiles to reserve space for
+ *
+ * @return  true if the system is initialized properly, false otherwise.
+ */
+bool ProjectileSystem::init(const std::shared_ptr<ObstacleWorld>& world, size_t capacity) {
+    CUAssertLog(_controller == nullptr, "Attempt to reinitialize an active projectile system");
+    if (world == nullptr || world->getWorld() == nullptr) {
+        CUAssertLog(false, "Projectile system requires an initialized world");
+        return false;
+    }
+    _controller = world;
+    _projectiles.reserve(capacity);
+    _hits.reserve(capacity);
+    return true;
+}
+
+/**
+ * Disposes all of the resources used by this projectile system.
+ *
+ * A disposed system can be safely reinitialized.
+ */
+void ProjectileSystem::dispose() {
+    _controller = nullptr;
+    _projectiles.clear();
+    _hits.clear();
+    _gravityScale = 0.0f;
+    _drag = 0.0f;
+    _impulses = true;
+}
+
+
+#pragma mark -
+#pragma mark Projectile Management
+/**
+ * Adds a projectile to this system.
+ *
+ * The projectile will first move at the next call to {@link update}. It
+ * has the default mass and lifespan, and hits all fixtures.
+ *
+ * @param position  The initial position
+ * @param velocity  The initial velocity
+ * @param tag       A user-defined value to identify the projectile
+ */
+void ProjectileSystem::fire(const Vec2 position, const Vec2 velocity, Uint32 tag) {
+    Projectile projectile;
+    projectile.position = position;
+    projectile.velocity = velocity;
+    projectile.mass = DEFAULT_PROJECTILE_MASS;
+    projectile.life = DEFAULT_PROJECTILE_LIFE;
+    projectile.mask = 0xFFFF;
+    projectile.tag  = tag;
+    _projectiles.push_back(projectile);
+}
+
+/**
+ * Removes all projectiles from this system.
+ */
+void ProjectileSystem::clear() {
+    _projectiles.clear();
+    _hits.clear();
+}
+
+
+#pragma mark -
+#pragma mark Simulation
+/**
+ * Advances all projectiles by a single step.
+ *
+ * This method should be called immediately after {@link ObstacleWorld#update},
+ * with the same time step.  Each projectile sweeps a ray from its current
+ * position to its next position.  Projectiles that hit a fixture are removed
+ * and recorded as hits.  All impulses are applied after every projectile
+ * has moved, so the order of the projectiles does not matter.
+ *
+ * @param dt    Number of seconds since last step
+ */
+void ProjectileSystem::update(float dt) {
+    _hits.clear();
+    if (_controller == nullptr) {
+        return;
+    }
+    
+    b2World* world = _controller->getWorld();
+    Rect bounds = _controller->getBounds();
+    Vec2 accel  = _controller->getGravity()*(_gravityScale*dt);
+    float damp  = std::max(0.0f, 1.0f-_drag*dt);
+    
+    // Sweep every projectile, compacting the survivors in place
+    ProjectileProxy proxy;
+    size_t pos = 0;
+    for(size_t ii = 0; ii < _projectiles.size(); ii++) {
+        Projectile& shot = _projectiles[ii];
+        shot.life -= dt;
+        shot.velocity += accel;
+        shot.velocity *= damp;
+        Vec2 next = shot.position+shot.velocity*dt;
+        
+        proxy.reset(shot.mask);
+        if (next != shot.position) {
+            world->RayCast(&proxy, b2Vec2(shot.position.x,shot.position.y), b2Vec2(next.x,next.y));
+        }
+        
+        if (proxy.fixture != nullptr) {
+            ProjectileHit hit;
+            hit.tag = shot.tag;
+            hit.obstacle = (Obstacle*)proxy.fixture->GetBody()->GetUserData();
+            hit.fixture  = proxy.fixture;
+            hit.point.set(proxy.point.x,proxy.point.y);
+            hit.normal.set(proxy.normal.x,proxy.normal.y);
+            hit.impulse  = shot.velocity*shot.mass;
+            _hits.push_back(hit);
+        } else if (shot.life > 0 && bounds.contains(next)) {
+            shot.position = next;
+            if (pos != ii) {
+                _projectiles[pos] = shot;
+            }
+            pos++;
+        }
+    }
+    _projectiles.resize(pos);
+    
+    if (_impulses) {
+        for(auto it = _hits.begin(); it != _hits.end(); ++it) {
+            b2Body* body = it->fixture->GetBody();
+            if (body->GetType() == b2_dynamicBody) {
+                body->ApplyLinearImpulse(b2Vec2(it->impulse.x,it->impulse.y),
+                                         b2Vec2(it->point.x,it->point.y), true);
+            }
+        }
+    }
+}
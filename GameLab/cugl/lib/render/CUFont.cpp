@@ -45,6 +45,10 @@
 
 #include <deque>
 #include <algorithm>
+#include <climits>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include <utf8/utf8.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
@@ -55,6 +59,112 @@ using namespace cugl;
 
 /** The amount of border to put around a glyph to prevent bleeding. */
 #define GLYPH_BORDER    2
+/** The default spread of a distance field atlas in pixels */
+#define DEFAULT_SPREAD  4
+/** The maximum number of threads to rasterize an atlas */
+#define ATLAS_THREADS   8
+/** The minimum number of glyphs to give a rasterization thread */
+#define ATLAS_CHUNK     64
+/** The number of glyphs (Latin-1) stored by direct index */
+#define LATIN_GLYPHS    256
+/** The initial capacity of the kerning table */
+#define KERNING_CAPACITY 256
+/** The marker for an empty slot in the kerning table */
+#define KERNING_EMPTY   0xFFFFFFFFFFFFFFFFULL
+
+/**
+ * Returns the hash of a kerning pair.
+ *
+ * @param pair  The pair of characters
+ *
+ * @return the hash of a kerning pair.
+ */
+static inline size_t hash_pair(Uint64 pair) {
+    pair *= 0x9E3779B97F4A7C15ULL;
+    return (size_t)(pair ^ (pair >> 32));
+}
+
+/**
+ * A horizontal segment of the skyline when packing an atlas.
+ *
+ * The skyline is the upper envelope of all glyphs placed so far.  It is
+ * stored as a sequence of segments ordered left to right.
+ */
+typedef struct {
+    /** The left edge of the segment */
+    int x;
+    /** The first free row above the segment */
+    int y;
+    /** The width of the segment */
+    int width;
+} SkylineSegment;
+
+/**
+ * Computes the distance from every pixel to the nearest seed pixel.
+ *
+ * This is the dead reckoning algorithm of Grevera, which propagates the
+ * nearest seed (not just the distance) in two raster passes.  It is nearly
+ * exact Euclidean distance and linear in the number of pixels.  Pixels with
+ * no seed in the image receive a very large distance.
+ *
+ * @param seeds     The seed pixels (nonzero for a seed)
+ * @param width     The image width
+ * @param height    The image height
+ * @param dist      The vector to store the distances
+ */
+static void distance_transform(const std::vector<Uint8>& seeds, int width, int height,
+                               std::vector<float>& dist) {
+    const float diag = 1.41421356f;
+    size_t total = (size_t)width*height;
+    dist.assign(total, FLT_MAX);
+    std::vector<int> nearx(total,-1);
+    std::vector<int> neary(total,-1);
+    for(int yy = 0; yy < height; yy++) {
+        for(int xx = 0; xx < width; xx++) {
+            int pos = yy*width+xx;
+            if (seeds[pos]) {
+                dist[pos] = 0;
+                nearx[pos] = xx;
+                neary[pos] = yy;
+            }
+        }
+    }
+    
+    // Adopt the seed of a neighbor if it is closer
+    auto relax = [&](int xx, int yy, int dx, int dy, float step) {
+        int nx = xx+dx;
+        int ny = yy+dy;
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+            return;
+        }
+        int pos = yy*width+xx;
+        int npos = ny*width+nx;
+        if (dist[npos]+step < dist[pos]) {
+            nearx[pos] = nearx[npos];
+            neary[pos] = neary[npos];
+            float ex = (float)(xx-nearx[pos]);
+            float ey = (float)(yy-neary[pos]);
+            dist[pos] = sqrtf(ex*ex+ey*ey);
+        }
+    };
+    
+    for(int yy = 0; yy < height; yy++) {
+        for(int xx = 0; xx < width; xx++) {
+            relax(xx,yy,-1,-1,diag);
+            relax(xx,yy, 0,-1,1.0f);
+            relax(xx,yy, 1,-1,diag);
+            relax(xx,yy,-1, 0,1.0f);
+        }
+    }
+    for(int yy = height-1; yy >= 0; yy--) {
+        for(int xx = width-1; xx >= 0; xx--) {
+            relax(xx,yy, 1, 0,1.0f);
+            relax(xx,yy,-1, 1,diag);
+            relax(xx,yy, 0, 1,1.0f);
+            relax(xx,yy, 1, 1,diag);
+        }
+    }
+}
 
 #pragma mark -
 #pragma mark Constructors
@@ -67,6 +177,7 @@ using namespace cugl;
 Font::Font() :
 _name(""),
 _stylename(""),
+_source(""),
 _size(0),
 _data(nullptr),
 _fontHeight(0),
@@ -78,7 +189,10 @@ _useKerning(true),
 _style(Style::NORMAL),
 _hints(Hinting::NORMAL),
 _render(Resolution::BLENDED),
+_distanceField(false),
+_spread(DEFAULT_SPREAD),
 _hasAtlas(false),
+_kernsize(0),
 _surface(nullptr) { }
 
 /**
@@ -92,6 +206,7 @@ void Font::dispose() {
     
     _name = "";
     _stylename = "";
+    _source = "";
     _size = 0;
     _data = nullptr;
     _fontHeight = 0;
@@ -103,12 +218,15 @@ void Font::dispose() {
     _style  = Style::NORMAL;
     _hints  = Hinting::NORMAL;
     _render = Resolution::BLENDED;
+    _distanceField = false;
+    _spread = DEFAULT_SPREAD;
     _hasAtlas = false;
     _texture = nullptr;
     _glyphset.clear();
-    _glyphsize.clear();
-    _glyphmap.clear();
-    _kernmap.clear();
+    _latin.clear();
+    _extended.clear();
+    _kerning.clear();
+    _kernsize = 0;
 }
 
 /**
@@ -135,6 +253,7 @@ bool Font::init(const std::string file, int size) {
         return false;
     }
     _size = size;
+    _source = fullpath;
     char* strng = TTF_FontFaceFamilyName(_data);
     _name = std::string(strng);
 
@@ -171,7 +290,7 @@ bool Font::init(const std::string file, int size) {
  */
 bool Font::hasGlyph(Uint32 a) const {
     if (_hasAtlas) {
-        return _glyphmap.find(a) != _glyphmap.end();
+        return findGlyph(a) != nullptr;
     }
     
     return TTF_GlyphIsProvided(_data, (Uint16)a) != 0;
@@ -273,8 +392,9 @@ void Font::setHinting(Hinting hinting) {
  */
 const Font::Metrics Font::getMetrics(Uint32 thechar) const {
     if (_hasAtlas) {
-        CUAssertLog(_glyphmap.find(thechar) != _glyphmap.end(), "Character '%c' is not supported", thechar);
-        return _glyphsize.at(thechar);
+        const Glyph* glyph = findGlyph(thechar);
+        CUAssertLog(glyph, "Character '%c' is not supported", thechar);
+        return glyph->metrics;
     }
     
     CUAssertLog(TTF_GlyphIsProvided(_data, (Uint16)thechar), "Character '%c' is not supported", thechar);
@@ -299,9 +419,9 @@ const Font::Metrics Font::getMetrics(Uint32 thechar) const {
  */
 unsigned int Font::getKerning(Uint32 a, Uint32 b) const {
     if (_hasAtlas) {
-        CUAssertLog(_glyphmap.find(a) != _glyphmap.end(), "Character '%c' is not supported", a);
-        CUAssertLog(_glyphmap.find(b) != _glyphmap.end(), "Character '%c' is not supported", b);
-        return _kernmap.at(a).at(b);
+        CUAssertLog(findGlyph(a), "Character '%c' is not supported", a);
+        CUAssertLog(findGlyph(b), "Character '%c' is not supported", b);
+        return lookupKerning(a, b);
     }
     
     CUAssertLog(TTF_GlyphIsProvided(_data, (Uint16)a), "Character '%c' is not supported", a);
@@ -388,10 +508,11 @@ Rect Font::getInternalBounds(const std::string text, bool utf8) const {
 void Font::clearAtlas() {
     if (_surface != nullptr) { SDL_FreeSurface(_surface); _surface = nullptr;   }
     _texture = nullptr;
-    _glyphmap.clear();
     _glyphset.clear();
-    _glyphsize.clear();
-    _kernmap.clear();
+    _latin.clear();
+    _extended.clear();
+    _kerning.clear();
+    _kernsize = 0;
     _hasAtlas = false;
 }
 
@@ -415,7 +536,6 @@ void Font::clearAtlas() {
 bool Font::buildAtlasAsync() {
     int width = prepareAtlas();
     int height = _fontHeight;
-    prepareAtlasKerning();
     computeAtlasSize(&width,&height);
     _hasAtlas = generateSurface(width,height);
     return _hasAtlas;
@@ -443,7 +563,6 @@ bool Font::buildAtlasAsync() {
 bool Font::buildAtlasAsync(const std::string charset) {
     int width = prepareAtlas(charset);
     int height = _fontHeight;
-    prepareAtlasKerning();
     computeAtlasSize(&width,&height);
     _hasAtlas = generateSurface(width,height);
     return _hasAtlas;
@@ -800,7 +919,7 @@ void Font::getAtlasMesh(const std::string text, const Vec2 origin, const Rect re
     if (!utf8) {
         for(int ii = 0; ii < line.size(); ii++) {
             if (ii > 0) {
-                offset.x -= _kernmap[line[ii-1]][line[ii]];
+                offset.x -= lookupKerning(line[ii-1],line[ii]);
             }
             ii = (getAtlasQuad(line[ii],offset,rect,mesh) ? ii+1 : (int)line.size());
         }
@@ -814,7 +933,7 @@ void Font::getAtlasMesh(const std::string text, const Vec2 origin, const Rect re
     
     for(int ii = 0; ii < utf32.size();) {
         if (ii > 0) {
-            offset.x -= _kernmap[utf32[ii-1]][utf32[ii]];
+            offset.x -= lookupKerning(utf32[ii-1],utf32[ii]);
         }
         ii = (getAtlasQuad(utf32[ii],offset,rect,mesh) ? ii+1 : (int)utf32.size());
     }
@@ -957,9 +1076,10 @@ bool Font::getAtlasQuad(Uint32 thechar, Vec2& offset, const Rect rect, Mesh<Spri
     CUAssertLog(mesh.command == GL_TRIANGLES, "The mesh is not formatted for triangles");
 
     // Technically, this answer is correct
-    if (!hasGlyph(thechar)) { return true; }
+    const Glyph* glyph = findGlyph(thechar);
+    if (glyph == nullptr) { return true; }
     
-    Rect bounds = _glyphmap[thechar];
+    Rect bounds = glyph->bounds;
     Rect quad(offset,bounds.size);
     
     // Skip over glyph, but recognize we may have later glyphs
@@ -1163,7 +1283,7 @@ void Font::getAtlasMesh(const std::string text, const Vec2 origin, const Rect re
     if (!utf8) {
         for(int ii = 0; ii < line.size(); ii++) {
             if (ii > 0) {
-                offset.x -= _kernmap[line[ii-1]][line[ii]];
+                offset.x -= lookupKerning(line[ii-1],line[ii]);
             }
             ii = (getAtlasQuad(line[ii],offset,rect,mesh,z) ? ii+1 : (int)line.size());
         }
@@ -1177,7 +1297,7 @@ void Font::getAtlasMesh(const std::string text, const Vec2 origin, const Rect re
     
     for(int ii = 0; ii < utf32.size();) {
         if (ii > 0) {
-            offset.x -= _kernmap[utf32[ii-1]][utf32[ii]];
+            offset.x -= lookupKerning(utf32[ii-1],utf32[ii]);
         }
         ii = (getAtlasQuad(utf32[ii],offset,rect,mesh,z) ? ii+1 : (int)utf32.size());
     }
@@ -1328,9 +1448,10 @@ bool Font::getAtlasQuad(Uint32 thechar, Vec2& offset, const Rect rect, Mesh<Spri
     CUAssertLog(mesh.command == GL_TRIANGLES, "The mesh is not formatted for triangles");
 
     // Technically, this answer is correct
-    if (!hasGlyph(thechar)) { return true; }
+    const Glyph* glyph = findGlyph(thechar);
+    if (glyph == nullptr) { return true; }
     
-    Rect bounds = _glyphmap[thechar];
+    Rect bounds = glyph->bounds;
     Rect quad(offset,bounds.size);
     
     // Skip over glyph, but recognize we may have later glyphs
@@ -1542,11 +1663,12 @@ Size Font::getSizeASCII(const std::string text) const {
     // Atlas computation
     Size result(0, (float)_fontHeight);
     for(int ii = 0; ii < text.size(); ii++) {
-        if (hasGlyph(text[ii])) {
+        const Glyph* glyph = findGlyph((Uint32)text[ii]);
+        if (glyph != nullptr) {
             if (ii > 0) {
-                result.width -= _kernmap.at((Uint32)text[ii-1]).at((Uint32)text[ii]);
+                result.width -= lookupKerning((Uint32)text[ii-1],(Uint32)text[ii]);
             }
-            result.width += _glyphsize.at((Uint32)text[ii]).advance;
+            result.width += glyph->metrics.advance;
         }
     }
     return result;
@@ -1586,13 +1708,16 @@ Size Font::getSizeUTF8(const std::string text) const {
     
     // Atlas computation
     Size result(0, (float)_fontHeight);
+    const Glyph* prev = nullptr;
     for(int ii = 0; ii < utf32.size(); ii++) {
-        if (hasGlyph(utf32[ii])) {
-            if (ii > 0 && hasGlyph(utf32[ii-1])) {
-                result.width -= _kernmap.at(utf32[ii-1]).at(utf32[ii]);
+        const Glyph* glyph = findGlyph(utf32[ii]);
+        if (glyph != nullptr) {
+            if (ii > 0 && prev != nullptr) {
+                result.width -= lookupKerning(utf32[ii-1],utf32[ii]);
             }
-            result.width += _glyphsize.at(utf32[ii]).advance;
+            result.width += glyph->metrics.advance;
         }
+        prev = glyph;
     }
     return result;
 }
@@ -1643,7 +1768,7 @@ Rect Font::getInternalBoundsASCII(const std::string text) const {
     for(int ii = 0; first == 0 && ii < text.size(); ii++) {
         Uint32 ch = (Uint32)text[ii];
         if (hasGlyph(ch)) {
-            metrics = (_hasAtlas ? _glyphsize.at(ch) : computeMetrics(ch));
+            metrics = (_hasAtlas ? findGlyph(ch)->metrics : computeMetrics(ch));
             result.origin.x = (float)metrics.minx;
             result.size.width = (float)metrics.advance-metrics.minx;
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
@@ -1661,8 +1786,8 @@ Rect Font::getInternalBoundsASCII(const std::string text) const {
     for(int ii = first+1; ii < text.size(); ii++) {
         Uint32 ch = (Uint32)text[ii];
         if (hasGlyph(ch)) {
-            result.size.width -= _kernmap.at(last).at(ch);
-            metrics = (_hasAtlas ? _glyphsize.at(ch) : computeMetrics(ch));
+            result.size.width -= lookupKerning(last,ch);
+            metrics = (_hasAtlas ? findGlyph(ch)->metrics : computeMetrics(ch));
             result.size.width += metrics.advance;
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
             miny = (metrics.miny < miny ? metrics.miny : miny);
@@ -1731,7 +1856,7 @@ Rect Font::getInternalBoundsUTF8(const std::string text) const {
     for(int ii = 0; first == -1 && ii < utf32.size(); ii++) {
         Uint32 ch = utf32[ii];
         if (hasGlyph(ch)) {
-            metrics = (_hasAtlas ? _glyphsize.at(ch) : computeMetrics(ch));
+            metrics = (_hasAtlas ? findGlyph(ch)->metrics : computeMetrics(ch));
             result.origin.x = (float)metrics.minx;
             result.size.width = (float)(metrics.advance-metrics.minx);
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
@@ -1749,8 +1874,8 @@ Rect Font::getInternalBoundsUTF8(const std::string text) const {
     for(int ii = first+1; ii < utf32.size(); ii++) {
         Uint32 ch = utf32[ii];
         if (hasGlyph(ch)) {
-            result.size.width -= (_hasAtlas ? _kernmap.at(last).at(ch) : computeKerning(last, ch));
-            metrics = (_hasAtlas ? _glyphsize.at(ch) : computeMetrics(ch));
+            result.size.width -= (_hasAtlas ? lookupKerning(last, ch) : computeKerning(last, ch));
+            metrics = (_hasAtlas ? findGlyph(ch)->metrics : computeMetrics(ch));
             result.size.width += metrics.advance;
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
             miny = (metrics.miny < miny ? metrics.miny : miny);
@@ -1770,6 +1895,18 @@ Rect Font::getInternalBoundsUTF8(const std::string text) const {
 
 #pragma mark -
 #pragma mark Atlas Preparation
+/**
+ * Returns the amount of padding around each glyph in the atlas.
+ *
+ * The padding prevents bleeding between neighboring glyphs. A distance
+ * field atlas also needs room for the field outside of each glyph.
+ *
+ * @return the amount of padding around each glyph in the atlas.
+ */
+int Font::getGlyphBorder() const {
+    return GLYPH_BORDER + (_distanceField ? 2*(int)_spread : 0);
+}
+
 /**
  * Prepares an atlas of all of the ASCII glyphs in this font
  *
@@ -1785,8 +1922,7 @@ int Font::prepareAtlas() {
     for(unsigned int ii = 32; ii < 127; ii++) {
         if (TTF_GlyphIsProvided(_data, (Uint16)ii)) {
             Metrics metrics = computeMetrics(ii);
-            _glyphsize.emplace(ii,metrics);
-            _glyphmap.emplace(ii,Rect(0,0, (float)(metrics.advance+GLYPH_BORDER), (float)(_fontHeight+GLYPH_BORDER)));
+            addGlyph(ii,metrics);
             _glyphset.push_back(ii);
             if (metrics.advance > maxwidth) {
                 maxwidth = metrics.advance;
@@ -1796,7 +1932,7 @@ int Font::prepareAtlas() {
     
     // Sort them by width
     std::sort(_glyphset.begin(),_glyphset.end(),[&](Uint32 a, Uint32 b) {
-        int aad = _glyphsize[a].advance; int bad = _glyphsize[b].advance;
+        int aad = findGlyph(a)->metrics.advance; int bad = findGlyph(b)->metrics.advance;
         return (aad > bad || (aad == bad && a > b));
     });
     
@@ -1822,13 +1958,14 @@ int Font::prepareAtlas(std::string charset) {
     std::vector<Uint32> utf32;
     utf8::utf8to16(charset.begin(), charset.end(), back_inserter(utf32));
     
+    // Sorting the characters makes each insertion an append
+    std::sort(utf32.begin(),utf32.end());
     for(auto it = utf32.begin(); it != utf32.end(); ++it) {
         CUAssertLog(*it <= USHRT_MAX, "SDL_TTF does not currently support UCS4");
         Uint16 thechar = (Uint16)*it;
-        if (_glyphmap.find(thechar) == _glyphmap.end() && TTF_GlyphIsProvided(_data, (Uint16)thechar)) {
+        if (findGlyph(thechar) == nullptr && TTF_GlyphIsProvided(_data, (Uint16)thechar)) {
             Metrics metrics = computeMetrics(thechar);
-            _glyphsize.emplace(thechar,metrics);
-            _glyphmap.emplace(thechar,Rect(0,0, (float)(metrics.advance+GLYPH_BORDER), (float)(_fontHeight+GLYPH_BORDER)));
+            addGlyph(thechar,metrics);
             _glyphset.push_back(thechar);
             if (metrics.advance > maxwidth) {
                 maxwidth = metrics.advance;
@@ -1838,7 +1975,7 @@ int Font::prepareAtlas(std::string charset) {
     
     // Sort them by width
     std::sort(_glyphset.begin(),_glyphset.end(),[&](Uint32 a, Uint32 b) {
-        int aad = _glyphsize[a].advance; int bad = _glyphsize[b].advance;
+        int aad = findGlyph(a)->metrics.advance; int bad = findGlyph(b)->metrics.advance;
         return (aad > bad || (aad == bad && a > b));
     });
     
@@ -1846,15 +1983,120 @@ int Font::prepareAtlas(std::string charset) {
 }
 
 /**
- * Gathers the kerning information for the atlas.
+ * Returns the atlas glyph for the given character.
+ *
+ * Characters in the Latin-1 range are found by direct index.  All other
+ * characters are found by binary search.  This method returns nullptr
+ * if the character is not in the atlas.
+ *
+ * @param thechar   The Unicode character to find
+ *
+ * @return the atlas glyph for the given character.
  */
-void Font::prepareAtlasKerning() {
-    for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
-        _kernmap.emplace(*it, std::unordered_map<Uint32, Uint32>());
-        for(auto jt = _glyphset.begin(); jt != _glyphset.end(); ++jt) {
-            _kernmap[*it].emplace(*jt, computeKerning(*it, *jt));
+const Font::Glyph* Font::findGlyph(Uint32 thechar) const {
+    if (thechar < LATIN_GLYPHS) {
+        if (_latin.empty() || !_latin[thechar].valid) {
+            return nullptr;
         }
+        return &_latin[thechar];
     }
+    
+    auto it = std::lower_bound(_extended.begin(), _extended.end(), thechar,
+                               [](const Glyph& entry, Uint32 code) { return entry.code < code; });
+    return (it != _extended.end() && it->code == thechar) ? &(*it) : nullptr;
+}
+
+/**
+ * Adds a glyph to the atlas tables, returning the new record.
+ *
+ * The bounding rectangle of the glyph is sized (but not positioned) to
+ * include the glyph border.  Adding glyphs in increasing order is fast,
+ * as they are appended to the end of the tables.
+ *
+ * @param thechar   The Unicode character to add
+ * @param metrics   The metrics of the character
+ *
+ * @return the new glyph record
+ */
+Font::Glyph* Font::addGlyph(Uint32 thechar, const Metrics& metrics) {
+    int border = getGlyphBorder();
+    Glyph glyph;
+    glyph.metrics = metrics;
+    glyph.bounds  = Rect(0,0, (float)(metrics.advance+border), (float)(_fontHeight+border));
+    glyph.code  = thechar;
+    glyph.valid = true;
+    
+    if (thechar < LATIN_GLYPHS) {
+        if (_latin.empty()) {
+            _latin.resize(LATIN_GLYPHS);
+        }
+        _latin[thechar] = glyph;
+        return &_latin[thechar];
+    }
+    
+    auto it = std::lower_bound(_extended.begin(), _extended.end(), thechar,
+                               [](const Glyph& entry, Uint32 code) { return entry.code < code; });
+    if (it != _extended.end() && it->code == thechar) {
+        *it = glyph;
+        return &(*it);
+    }
+    return &(*_extended.insert(it,glyph));
+}
+
+/**
+ * Returns the kerning between two characters in the atlas.
+ *
+ * Kerning pairs are computed on demand and cached.  A text only uses a
+ * tiny fraction of the pairs in a large character set, so this is much
+ * faster than computing every pair when the atlas is built.  As this
+ * method updates the cache, it should only be called by the thread
+ * using the font.
+ *
+ * @param a     The first Unicode character in the pair
+ * @param b     The second Unicode character in the pair
+ *
+ * @return the kerning between two characters in the atlas.
+ */
+int Font::lookupKerning(Uint32 a, Uint32 b) const {
+    if (_kerning.empty()) {
+        _kerning.resize(KERNING_CAPACITY,{KERNING_EMPTY,0});
+    }
+    
+    Uint64 pair = ((Uint64)a << 32) | b;
+    size_t mask = _kerning.size()-1;
+    size_t pos  = hash_pair(pair) & mask;
+    while (_kerning[pos].pair != KERNING_EMPTY) {
+        if (_kerning[pos].pair == pair) {
+            return _kerning[pos].kern;
+        }
+        pos = (pos+1) & mask;
+    }
+    
+    int kern = computeKerning(a, b);
+    _kerning[pos].pair = pair;
+    _kerning[pos].kern = kern;
+    if (2*(++_kernsize) > _kerning.size()) {
+        growKerning();
+    }
+    return kern;
+}
+
+/**
+ * Doubles the capacity of the kerning table, rehashing all of the pairs.
+ */
+void Font::growKerning() const {
+    std::vector<KernPair> table(2*_kerning.size(),{KERNING_EMPTY,0});
+    size_t mask = table.size()-1;
+    for(auto it = _kerning.begin(); it != _kerning.end(); ++it) {
+        if (it->pair != KERNING_EMPTY) {
+            size_t pos = hash_pair(it->pair) & mask;
+            while (table[pos].pair != KERNING_EMPTY) {
+                pos = (pos+1) & mask;
+            }
+            table[pos] = *it;
+        }
+    }
+    _kerning.swap(table);
 }
 
 /**
@@ -1904,8 +2146,10 @@ int Font::computeKerning(Uint32 a, Uint32 b) const {
 
     int w1, w2;
     TTF_SizeUNICODE(_data, str, &w1, &w2);
-    w2 =  (!_glyphsize.empty() ? _glyphsize.at(a).advance : computeMetrics(a).advance);
-    w2 += (!_glyphsize.empty() ? _glyphsize.at(b).advance : computeMetrics(b).advance);
+    const Glyph* first  = findGlyph(a);
+    const Glyph* second = findGlyph(b);
+    w2 =  (first  != nullptr ? first->metrics.advance  : computeMetrics(a).advance);
+    w2 += (second != nullptr ? second->metrics.advance : computeMetrics(b).advance);
     return w2-w1;
 }
 
@@ -1919,173 +2163,284 @@ int Font::computeKerning(Uint32 a, Uint32 b) const {
  *
  * The dimensions are store in the provided pointers.  The width should
  * be a value > 1.  For best results, the width should be the size of the
- * maximum character width.
+ * maximum character width.  As a side effect, this method packs the glyphs
+ * with {@link planAtlas}, so the glyph positions are ready for layout.
  *
  * @param width     Integer to store the width in
  * @param height    Integer to store the height in
  */
 void Font::computeAtlasSize(int* width, int* height) {
     // Make enough room for largest glyph
-    *width  = nextPOT(*width+GLYPH_BORDER);
-    *height = nextPOT(_fontHeight+GLYPH_BORDER);
-    
-    // Copy the glyphs to make a visited set
-    int nrows  = 1;
-    std::deque< wchar_t > copied;
-    std::copy(_glyphset.begin(), _glyphset.end(), std::back_inserter(copied));
-    
-    std::vector<float> used;
-    used.push_back(2); // Give us a spot for a 2-patch
-    int line = 0;
-    while (!copied.empty()) {
-        
-        // We have finished the line
-        if (used[line] >= *width) {
-            // There is no more room
-            if (line+1 >= nrows) {
-                if (*width < *height) {
-                    *width *= 2; line = 0;
-                } else {
-                    int orows = nrows;
-                    *height *= 2; nrows *=2;
-                    used.reserve(nrows);
-                    for(int ii = 0; ii < orows; ii++) {
-                        used.push_back(0);
-                    }
-                    line++;
-                }
-            } else {
-                line++;
-            }
+    int border = getGlyphBorder();
+    *width  = nextPOT(*width+border);
+    *height = nextPOT(_fontHeight+border);
+    
+    // No packing can beat the total area, so start there
+    size_t area = 4; // Give us a spot for a 2-patch
+    for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
+        area += (size_t)(findGlyph(*it)->metrics.advance+border)*(_fontHeight+border);
+    }
+    while ((size_t)(*width)*(*height) < area) {
+        if (*width < *height) {
+            *width *= 2;
+        } else {
+            *height *= 2;
         }
-        
-        // Fit the largest glyph possible on this line
-        bool found = false;
-		auto pos = copied.begin();
-        for(auto it = copied.begin(); !found && it != copied.end(); ++it) {
-            if (_glyphsize[*it].advance < *width-used[line]) {
-                used[line] += _glyphsize[*it].advance+GLYPH_BORDER;
-				pos = it;
-                found = true;
-            }
+    }
+    
+    while (!planAtlas(*width,*height)) {
+        if (*width < *height) {
+            *width *= 2;
+        } else {
+            *height *= 2;
         }
-        
-        if (!found) {
-            used[line] = (float)*width;
-		} else {
-			copied.erase(pos);
-		}
     }
 }
 
 /**
- * Returns a plan for the atlas as a rectangular array of characters.
+ * Returns true if the glyphs were packed in a bounding box of this size.
  *
- * These characters are organized to fit in the size predicted by
- * computeSize.
+ * This method uses a bottom-left skyline packer, placing each glyph (widest
+ * first) at the lowest position along the skyline where it fits.  Unlike
+ * a shelf packer, this reclaims the space left at the end of each row. The
+ * glyph positions are stored in the glyph map.  If this method returns
+ * false, those positions are incomplete and should be ignored.
  *
  * @param width     The width of the bounding box
  * @param height    The height of the bounding box
  *
- * @return a plan for the atlas as a rectangular array of characters.
+ * @return true if the glyphs were packed in a bounding box of this size.
  */
-std::vector< std::vector<Uint32> > Font::planAtlas(int width, int height) {
-    // Time to order the glyphs
-    int line = 0;
-    int left = width-2; // Give us a spot for a 2-patch
-    
-    // Create a (inverse) visited set
-    std::deque< wchar_t > copied;
-    std::copy(_glyphset.begin(), _glyphset.end(), std::back_inserter(copied));
-    
-    // Create the return value
-    std::vector< std::vector<Uint32> > result;
-    result.push_back( std::vector<Uint32>() );
-    
-    while (!copied.empty()) {
-        // Go to the next line.
-        if (left == 0) {
-            left = width; line++;
-            result.push_back( std::vector<Uint32>() );
+bool Font::planAtlas(int width, int height) {
+    int border  = getGlyphBorder();
+    int fheight = _fontHeight+border;
+    
+    // Give us a spot for a 2-patch
+    std::vector<SkylineSegment> skyline;
+    skyline.push_back({0,2,2});
+    skyline.push_back({2,0,width-2});
+    
+    for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
+        Glyph* glyph = findGlyph(*it);
+        int glwidth = glyph->metrics.advance+border;
+        
+        // Find the segment giving the lowest (then leftmost) position
+        int bestpos = -1;
+        int besty = height;
+        for(size_t ii = 0; ii < skyline.size(); ii++) {
+            int left = skyline[ii].x;
+            if (left+glwidth > width) {
+                break;
+            }
+            
+            int top = 0;
+            int span = 0;
+            for(size_t jj = ii; span < glwidth; jj++) {
+                top = std::max(top,skyline[jj].y);
+                span += skyline[jj].width;
+            }
+            if (top+fheight <= height && top < besty) {
+                besty = top;
+                bestpos = (int)ii;
+            }
+        }
+        
+        if (bestpos == -1) {
+            return false;
         }
         
-        // Find the largest glyph that will fit on line.
-        bool found = false;
-        int fheight = _fontHeight+GLYPH_BORDER;
-		auto value = copied.begin();
-        for(auto it = copied.begin(); !found && it != copied.end(); ++it) {
-            wchar_t thechar = (wchar_t)(*it);
-            int glwidth = _glyphsize[*it].advance+GLYPH_BORDER;
-            if (glwidth < left) {
-                result[line].push_back(thechar);
-                _glyphmap[thechar].origin.x = (float)(width-left);
-                _glyphmap[thechar].origin.y = (float)(line*fheight);
-                left -= glwidth;
-				value = it;
-                found = true;
+        Rect& bounds = glyph->bounds;
+        bounds.origin.x = (float)skyline[bestpos].x;
+        bounds.origin.y = (float)besty;
+        
+        // Raise the skyline under the glyph
+        SkylineSegment segment = { skyline[bestpos].x, besty+fheight, glwidth };
+        skyline.insert(skyline.begin()+bestpos,segment);
+        int right = segment.x+segment.width;
+        size_t next = bestpos+1;
+        while (next < skyline.size() && skyline[next].x < right) {
+            int overlap = right-skyline[next].x;
+            if (overlap >= skyline[next].width) {
+                skyline.erase(skyline.begin()+next);
+            } else {
+                skyline[next].x += overlap;
+                skyline[next].width -= overlap;
+                break;
             }
         }
         
-        // Queue next line if not found.
-        if (!found) { 
-			left = 0; 
-		} else {
-			copied.erase(value);
-		}
+        // Merge segments of equal height
+        for(size_t ii = 1; ii < skyline.size(); ) {
+            if (skyline[ii-1].y == skyline[ii].y) {
+                skyline[ii-1].width += skyline[ii].width;
+                skyline.erase(skyline.begin()+ii);
+            } else {
+                ii++;
+            }
+        }
     }
     
-    return result;
+    return true;
 }
 
 /**
- * Takes the rectangular plan and arranges the glyphs in the SDL surface.
+ * Returns a new handle to the font file with the current settings.
  *
- * @param rectangle A plan for the atlas as a rectangular array of characters.
+ * SDL_ttf is not thread safe, so every rasterization thread needs its own
+ * handle.  This handle has the same size, style, hinting and kerning as
+ * this font.  The caller is responsible for closing it.  Handles should
+ * only be opened and closed on the thread building the atlas.
+ *
+ * @return a new handle to the font file with the current settings.
  */
-void Font::layoutAtlas(const std::vector< std::vector<Uint32> >& rectangle) {
-    SDL_Rect srcrect, dstrect;
-    
+TTF_Font* Font::openHandle() const {
+    TTF_Font* handle = TTF_OpenFont(_source.c_str(), _size);
+    if (handle != nullptr) {
+        TTF_SetFontStyle(handle, (int)_style);
+        TTF_SetFontHinting(handle, (int)_hints);
+        TTF_SetFontKerning(handle, _useKerning);
+    }
+    return handle;
+}
+
+/**
+ * Rasterizes a range of glyphs into their positions in the SDL surface.
+ *
+ * Each glyph is rendered to its own cell, and the cell rows are copied
+ * into the atlas.  As glyph positions never overlap, several threads may
+ * call this method at once on disjoint ranges, provided that each has its
+ * own font handle.
+ *
+ * @param handle    The font handle to render with
+ * @param begin     The index of the first glyph in the glyph set
+ * @param end       The index after the last glyph in the glyph set
+ */
+void Font::rasterizeGlyphs(TTF_Font* handle, size_t begin, size_t end) {
     SDL_Color color;
     color.r = color.g = color.b = color.a = 255;
-    SDL_Color bkgrd;
-    bkgrd.r = bkgrd.g = bkgrd.b = bkgrd.a = 0;
     
-    // Add a 2 patch at the beginning
-    srcrect.x = srcrect.y = 0;
-    srcrect.w = srcrect.h = 2;
-    SDL_FillRect(_surface,&srcrect,SDL_MapRGBA(_surface->format, 255, 255, 255, 255));
-    
-    for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
-		SDL_Surface* temp = nullptr;
-        switch (_render) {
+    // Distance fields need the true coverage
+    Resolution render = _distanceField ? Resolution::BLENDED : _render;
+    for(size_t ii = begin; ii < end; ii++) {
+        Uint32 thechar = _glyphset[ii];
+        SDL_Surface* temp = nullptr;
+        switch (render) {
             case Resolution::SOLID:
-                temp = TTF_RenderGlyph_Solid(_data, *it, color);
+                temp = TTF_RenderGlyph_Solid(handle, thechar, color);
                 break;
             case Resolution::SHADED:
             case Resolution::BLENDED:
-                temp = TTF_RenderGlyph_Blended(_data, *it, color);
+                temp = TTF_RenderGlyph_Blended(handle, thechar, color);
                 break;
         }
+        if (temp == nullptr) {
+            continue;
+        }
         
-        // Resize the boundary now that spacing is safe.
-        _glyphmap[*it].origin.x += GLYPH_BORDER/2;
-        _glyphmap[*it].origin.y += GLYPH_BORDER/2;
-        _glyphmap[*it].size.width  -= GLYPH_BORDER;
-        _glyphmap[*it].size.height -= GLYPH_BORDER;
-        
-        // Convert to SDL rects
-        dstrect.x = (int)_glyphmap[*it].origin.x;
-        dstrect.y = (int)_glyphmap[*it].origin.y;
+        const Rect& bounds = findGlyph(thechar)->bounds;
+        SDL_Rect srcrect;
         srcrect.x = srcrect.y = 0;
-        dstrect.w = srcrect.w = (int)_glyphmap[*it].size.width;
-        dstrect.h = srcrect.h = (int)_glyphmap[*it].size.height;
+        srcrect.w = (int)bounds.size.width;
+        srcrect.h = (int)bounds.size.height;
         
-        // Blit on to atlas
-        if (_render != Resolution::SHADED) {
+        // Blit on to a private cell
+        SDL_Surface* cell = allocSurface(srcrect.w,srcrect.h);
+        if (render != Resolution::SHADED) {
             SDL_SetSurfaceBlendMode(temp, SDL_BLENDMODE_NONE);
         }
-        SDL_BlitSurface(temp,&srcrect,_surface,&dstrect);
+        SDL_BlitSurface(temp,&srcrect,cell,nullptr);
         SDL_FreeSurface(temp);
+        
+        // Copy the cell into the atlas
+        int x = (int)bounds.origin.x;
+        int y = (int)bounds.origin.y;
+        size_t bytes = (size_t)srcrect.w*_surface->format->BytesPerPixel;
+        for(int row = 0; row < srcrect.h; row++) {
+            Uint8* dst = (Uint8*)_surface->pixels+(y+row)*_surface->pitch;
+            dst += x*_surface->format->BytesPerPixel;
+            Uint8* src = (Uint8*)cell->pixels+row*cell->pitch;
+            std::memcpy(dst, src, bytes);
+        }
+        SDL_FreeSurface(cell);
+    }
+}
+
+/**
+ * Executes a rasterization job in its own thread.
+ *
+ * @param data  The {@link GlyphJob} to execute
+ *
+ * @return 0 when the job is complete
+ */
+int SDLCALL Font::rasterizeJob(void* data) {
+    GlyphJob* job = (GlyphJob*)data;
+    job->font->rasterizeGlyphs(job->handle, job->begin, job->end);
+    return 0;
+}
+
+/**
+ * Arranges the glyphs in the SDL surface, using the planned positions.
+ *
+ * The glyphs are divided among several threads, each rasterizing with its
+ * own font handle.  Small atlases are rasterized on the calling thread.
+ */
+void Font::layoutAtlas() {
+    SDL_Rect srcrect;
+    
+    // Add a 2 patch at the beginning
+    srcrect.x = srcrect.y = 0;
+    srcrect.w = srcrect.h = 2;
+    SDL_FillRect(_surface,&srcrect,SDL_MapRGBA(_surface->format, 255, 255, 255, 255));
+    
+    // Resize the boundary now that spacing is safe.
+    int border = getGlyphBorder();
+    for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
+        Rect& bounds = findGlyph(*it)->bounds;
+        bounds.origin.x += border/2;
+        bounds.origin.y += border/2;
+        bounds.size.width  -= border;
+        bounds.size.height -= border;
+    }
+    
+    if (SDL_MUSTLOCK(_surface)) {
+        SDL_LockSurface(_surface);
+    }
+    
+    // Divide the glyphs into jobs
+    size_t total = _glyphset.size();
+    size_t count = std::min((size_t)std::max(SDL_GetCPUCount(),1),(size_t)ATLAS_THREADS);
+    count = std::max(std::min(count,total/ATLAS_CHUNK),(size_t)1);
+    
+    std::vector<GlyphJob> jobs(count);
+    size_t chunk = (total+count-1)/count;
+    for(size_t ii = 0; ii < count; ii++) {
+        jobs[ii].font   = this;
+        jobs[ii].begin  = std::min(ii*chunk,total);
+        jobs[ii].end    = std::min((ii+1)*chunk,total);
+        jobs[ii].handle = (ii == 0 ? _data : openHandle());
+    }
+    
+    // The calling thread takes the first job (and any without a thread)
+    std::vector<SDL_Thread*> threads(count,nullptr);
+    for(size_t ii = 1; ii < count; ii++) {
+        if (jobs[ii].handle != nullptr) {
+            threads[ii] = SDL_CreateThread(rasterizeJob, "CUFontAtlas", &jobs[ii]);
+        }
+    }
+    rasterizeGlyphs(_data, jobs[0].begin, jobs[0].end);
+    for(size_t ii = 1; ii < count; ii++) {
+        if (threads[ii] != nullptr) {
+            SDL_WaitThread(threads[ii], nullptr);
+        } else {
+            rasterizeGlyphs(_data, jobs[ii].begin, jobs[ii].end);
+        }
+        if (jobs[ii].handle != nullptr) {
+            TTF_CloseFont(jobs[ii].handle);
+        }
+    }
+    
+    if (SDL_MUSTLOCK(_surface)) {
+        SDL_UnlockSurface(_surface);
     }
 }
 
@@ -2101,10 +2456,79 @@ void Font::layoutAtlas(const std::vector< std::vector<Uint32> >& rectangle) {
  */
 bool Font::generateSurface(int width, int height) {
     _surface = allocSurface(width, height);
-    layoutAtlas(planAtlas(width,height));
+    if (_surface == nullptr) {
+        return false;
+    }
+    layoutAtlas();
+    if (_distanceField) {
+        generateDistanceField();
+    }
     return _surface != nullptr;
 }
 
+/**
+ * Converts the glyph coverage in the atlas surface to a distance field.
+ *
+ * Every pixel is assigned its signed distance to the nearest glyph edge,
+ * clamped to the spread and remapped so that the edge is at alpha 0.5.
+ * The color channels are set to white.
+ */
+void Font::generateDistanceField() {
+    int width  = _surface->w;
+    int height = _surface->h;
+    SDL_PixelFormat* format = _surface->format;
+    
+    if (SDL_MUSTLOCK(_surface)) {
+        SDL_LockSurface(_surface);
+    }
+    
+    // Extract the coverage
+    std::vector<Uint8> coverage(width*height);
+    std::vector<Uint8> inside(width*height);
+    std::vector<Uint8> outside(width*height);
+    for(int yy = 0; yy < height; yy++) {
+        Uint32* row = (Uint32*)((Uint8*)_surface->pixels+yy*_surface->pitch);
+        for(int xx = 0; xx < width; xx++) {
+            Uint8 alpha = (Uint8)((row[xx] & format->Amask) >> format->Ashift);
+            int pos = yy*width+xx;
+            coverage[pos] = alpha;
+            inside[pos]  = alpha >= 128;
+            outside[pos] = alpha <  128;
+        }
+    }
+    
+    // Distance to nearest inside (for outside pixels) and vice versa
+    std::vector<float> toInside;
+    std::vector<float> toOutside;
+    distance_transform(inside,  width, height, toInside);
+    distance_transform(outside, width, height, toOutside);
+    
+    Uint32 white = format->Rmask | format->Gmask | format->Bmask;
+    float scale  = 0.5f/(float)std::max(_spread,1u);
+    for(int yy = 0; yy < height; yy++) {
+        Uint32* row = (Uint32*)((Uint8*)_surface->pixels+yy*_surface->pitch);
+        for(int xx = 0; xx < width; xx++) {
+            int pos = yy*width+xx;
+            float dist; // Positive outside the glyph
+            if (coverage[pos] > 0 && coverage[pos] < 255) {
+                // Antialiased edge pixels know the subpixel edge position
+                dist = 0.5f-coverage[pos]/255.0f;
+            } else if (inside[pos]) {
+                dist = 0.5f-toOutside[pos];
+            } else {
+                dist = toInside[pos]-0.5f;
+            }
+            float value = 0.5f-dist*scale;
+            value = std::max(0.0f,std::min(value,1.0f));
+            row[xx] = white | ((Uint32)(value*255.0f+0.5f) << format->Ashift);
+        }
+    }
+    
+    if (SDL_MUSTLOCK(_surface)) {
+        SDL_UnlockSurface(_surface);
+    }
+}
+
 /**
  * Allocates a blank surface of the given size.
  *
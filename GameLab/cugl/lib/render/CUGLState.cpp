@@ -0,0 +1,1126 @@
+//
+//  CUGLState.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a shadow copy of the OpenGL state that the render
+//  classes touch.  OpenGL drivers do not filter redundant state changes, and
+//  on many mobile drivers even a no-op bind is a measurable cost.  All of the
+//  render classes (textures, shaders, buffers, render targets, and the sprite
+//  batch) route their state changes through this module, which skips any
+//  change to a value that is already current.
+//
+//  The shadow assumes that all state changes go through this module.  Code
+//  that calls OpenGL directly should either use these functions too, or call
+//  invalidate() afterwards so that the shadow is reloaded.  The verify mode
+//  checks the shadow against the driver on every call, which is useful for
+//  finding such code.
+//
+//  This class is a static class, as there is only one OpenGL context.  It
+//  may only be used on the main thread.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/render/CUGLState.h>
+#include <cugl/util/CUDebug.h>
+
+using namespace cugl;
+
+/** The value for an unknown name or enum */
+#define UNKNOWN_NAME    0xFFFFFFFF
+/** The value for an unknown boolean */
+#define UNKNOWN_FLAG    -1
+/** The number of tracked texture units */
+#define TEXTURE_UNITS   32
+/** The number of tracked uniform binding points */
+#define UNIFORM_POINTS  32
+
+#pragma mark Shadow State
+/**
+ * A uniform buffer binding point
+ */
+typedef struct {
+    /** The bound buffer */
+    GLuint buffer;
+    /** The offset of the bound range (0 for the whole buffer) */
+    GLintptr offset;
+    /** The size of the bound range (0 for the whole buffer) */
+    GLsizeiptr size;
+} UniformPoint;
+
+/**
+ * The shadow of the OpenGL state
+ */
+typedef struct {
+    /** The current program */
+    GLuint program;
+    /** The active texture unit, relative to GL_TEXTURE0 */
+    GLuint unit;
+    /** The 2d texture of each unit */
+    GLuint textures[TEXTURE_UNITS];
+    /** The vertex array */
+    GLuint vertexArray;
+    /** The array buffer */
+    GLuint arrayBuffer;
+    /** The element buffer of the current vertex array */
+    GLuint elementBuffer;
+    /** The generic uniform buffer */
+    GLuint uniformBuffer;
+    /** The indexed uniform buffers */
+    UniformPoint points[UNIFORM_POINTS];
+    /** The framebuffer (both draw and read) */
+    GLuint framebuffer;
+    /** The viewport */
+    GLint viewport[4];
+    /** Whether the viewport is known */
+    bool hasViewport;
+    /** The blend capability */
+    int blend;
+    /** The depth test capability */
+    int depthTest;
+    /** The cull face capability */
+    int cullFace;
+    /** The scissor test capability */
+    int scissorTest;
+    /** The blend source factor */
+    GLenum srcFactor;
+    /** The blend destination factor */
+    GLenum dstFactor;
+    /** The blend source factor for alpha */
+    GLenum srcAlpha;
+    /** The blend destination factor for alpha */
+    GLenum dstAlpha;
+    /** The blend equation */
+    GLenum equation;
+    /** The depth function */
+    GLenum depthFunc;
+    /** The depth mask */
+    int depthMask;
+    /** The clear color */
+    GLfloat clearColor[4];
+    /** Whether the clear color is known */
+    bool hasClearColor;
+} Shadow;
+
+/** The shadow of the OpenGL context */
+static Shadow _shadow;
+/** Whether the shadow has been initialized */
+static bool _started = false;
+/** Whether to check the shadow against OpenGL on every call */
+static bool _verify = false;
+/** The number of state changes passed to OpenGL */
+static Uint64 _issued = 0;
+/** The number of redundant state changes skipped */
+static Uint64 _skipped = 0;
+
+/**
+ * Marks all of the shadow state as unknown
+ */
+static void forget() {
+    _shadow.program = UNKNOWN_NAME;
+    _shadow.unit = UNKNOWN_NAME;
+    for(int ii = 0; ii < TEXTURE_UNITS; ii++) {
+        _shadow.textures[ii] = UNKNOWN_NAME;
+    }
+    _shadow.vertexArray = UNKNOWN_NAME;
+    _shadow.arrayBuffer = UNKNOWN_NAME;
+    _shadow.elementBuffer = UNKNOWN_NAME;
+    _shadow.uniformBuffer = UNKNOWN_NAME;
+    for(int ii = 0; ii < UNIFORM_POINTS; ii++) {
+        _shadow.points[ii].buffer = UNKNOWN_NAME;
+        _shadow.points[ii].offset = 0;
+        _shadow.points[ii].size = 0;
+    }
+    _shadow.framebuffer = UNKNOWN_NAME;
+    _shadow.hasViewport = false;
+    _shadow.blend = UNKNOWN_FLAG;
+    _shadow.depthTest = UNKNOWN_FLAG;
+    _shadow.cullFace = UNKNOWN_FLAG;
+    _shadow.scissorTest = UNKNOWN_FLAG;
+    _shadow.srcFactor = UNKNOWN_NAME;
+    _shadow.dstFactor = UNKNOWN_NAME;
+    _shadow.srcAlpha = UNKNOWN_NAME;
+    _shadow.dstAlpha = UNKNOWN_NAME;
+    _shadow.equation = UNKNOWN_NAME;
+    _shadow.depthFunc = UNKNOWN_NAME;
+    _shadow.depthMask = UNKNOWN_FLAG;
+    _shadow.hasClearColor = false;
+    _started = true;
+}
+
+/**
+ * Returns the shadow, initializing it if necessary
+ *
+ * @return the shadow, initializing it if necessary
+ */
+static Shadow& shadow() {
+    if (!_started) {
+        forget();
+    }
+    return _shadow;
+}
+
+/**
+ * Returns the integer value of the given OpenGL parameter
+ *
+ * @param pname The OpenGL parameter
+ *
+ * @return the integer value of the given OpenGL parameter
+ */
+static GLint query(GLenum pname) {
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    return value;
+}
+
+/**
+ * Returns true if a tracked value is current, checking it if necessary
+ *
+ * In verify mode, a known value is compared against OpenGL.  A difference
+ * is logged, and reported as not current.  Unknown values are never
+ * current.  This method updates the counters.
+ *
+ * @param shadow    The shadow value
+ * @param value     The requested value
+ * @param actual    The OpenGL parameter for the value
+ * @param name      The value name for logging
+ *
+ * @return true if a tracked value is current
+ */
+static bool current(GLuint shadow, GLuint value, GLenum actual, const char* name) {
+    if (_verify && shadow != UNKNOWN_NAME) {
+        GLuint real = (GLuint)query(actual);
+        if (real != shadow) {
+            CULogError("GLState: %s is %u, but the shadow is %u",name,real,shadow);
+            _issued++;
+            return false;
+        }
+    }
+    if (shadow == value) {
+        _skipped++;
+        return true;
+    }
+    _issued++;
+    return false;
+}
+
+/**
+ * Returns true if a uniform binding point agrees with OpenGL
+ *
+ * Ranges bound with glBindBufferBase report an offset and size of 0, as
+ * does the shadow.
+ *
+ * @param point     The shadow of the binding point
+ * @param index     The binding point
+ *
+ * @return true if a uniform binding point agrees with OpenGL
+ */
+static bool matches(const UniformPoint& point, GLuint index) {
+    GLint buffer = 0;
+    GLint64 offset = 0;
+    GLint64 size = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &buffer);
+    glGetInteger64i_v(GL_UNIFORM_BUFFER_START, index, &offset);
+    glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, index, &size);
+    return (GLuint)buffer == point.buffer && offset == point.offset && size == point.size;
+}
+
+/**
+ * Forgets a uniform binding point if it does not agree with OpenGL
+ *
+ * This method is only used in verify mode.  It checks both the indexed
+ * binding point and the generic uniform buffer target, as the indexed
+ * calls bind both.  Any difference is logged.
+ *
+ * @param state     The shadow state
+ * @param index     The binding point
+ */
+static void verifyPoint(Shadow& state, GLuint index) {
+    UniformPoint& point = state.points[index];
+    if (point.buffer != UNKNOWN_NAME && !matches(point, index)) {
+        CULogError("GLState: uniform binding point %u does not match the shadow",index);
+        point.buffer = UNKNOWN_NAME;
+    }
+    if (state.uniformBuffer != UNKNOWN_NAME &&
+        (GLuint)query(GL_UNIFORM_BUFFER_BINDING) != state.uniformBuffer) {
+        CULogError("GLState: uniform buffer does not match the shadow");
+        state.uniformBuffer = UNKNOWN_NAME;
+    }
+}
+
+/**
+ * Returns true if a tracked capability is current, checking it if necessary
+ *
+ * In verify mode, a known value is compared against OpenGL.  A difference
+ * is logged, and reported as not current.  Unknown values are never
+ * current.  This method updates the counters.
+ *
+ * @param shadow    The shadow value
+ * @param value     The requested value
+ * @param cap       The OpenGL capability
+ *
+ * @return true if a tracked capability is current
+ */
+static bool current(int shadow, int value, GLenum cap) {
+    if (_verify && shadow != UNKNOWN_FLAG) {
+        int real = glIsEnabled(cap) ? 1 : 0;
+        if (real != shadow) {
+            CULogError("GLState: capability 0x%04x is %d, but the shadow is %d",cap,real,shadow);
+            _issued++;
+            return false;
+        }
+    }
+    if (shadow == value) {
+        _skipped++;
+        return true;
+    }
+    _issued++;
+    return false;
+}
+
+/**
+ * Returns a pointer to the shadow capability, or nullptr if not tracked
+ *
+ * @param cap   The OpenGL capability
+ *
+ * @return a pointer to the shadow capability, or nullptr if not tracked
+ */
+static int* capability(GLenum cap) {
+    Shadow& state = shadow();
+    switch (cap) {
+        case GL_BLEND:
+            return &state.blend;
+        case GL_DEPTH_TEST:
+            return &state.depthTest;
+        case GL_CULL_FACE:
+            return &state.cullFace;
+        case GL_SCISSOR_TEST:
+            return &state.scissorTest;
+    }
+    return nullptr;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Forgets all of the tracked state.
+ *
+ * The next call to each method will reach the driver.  This method
+ * should be called after any code outside of this class changes the
+ * tracked state, or after the OpenGL context is recreated.
+ */
+void GLState::invalidate() {
+    forget();
+}
+
+/**
+ * Returns true if this class checks the shadow against OpenGL.
+ *
+ * In verify mode, every call compares the shadow to the actual OpenGL
+ * state before deciding whether to skip it.  Any difference is logged
+ * and the call is passed to OpenGL.
+ *
+ * @return true if this class checks the shadow against OpenGL.
+ */
+bool GLState::isVerify() {
+    return _verify;
+}
+
+/**
+ * Sets whether this class checks the shadow against OpenGL.
+ *
+ * In verify mode, every call compares the shadow to the actual OpenGL
+ * state before deciding whether to skip it.  Any difference is logged
+ * and the call is passed to OpenGL.  This mode is very slow, as every
+ * call stalls on a query, and should only be used for debugging.
+ *
+ * @param flag  Whether to check the shadow against OpenGL.
+ */
+void GLState::setVerify(bool flag) {
+    _verify = flag;
+}
+
+/**
+ * Returns true if the shadow agrees with all known OpenGL state.
+ *
+ * This method queries OpenGL for every value in the shadow, and logs
+ * each difference.  Unknown values are ignored.  It can be called
+ * whether or not verify mode is active.
+ *
+ * @return true if the shadow agrees with all known OpenGL state.
+ */
+bool GLState::verify() {
+    Shadow& state = shadow();
+    bool result = true;
+
+    // Check a single name, logging the difference
+    auto check = [&](GLuint value, GLenum pname, const char* name) {
+        if (value != UNKNOWN_NAME && value != (GLuint)query(pname)) {
+            CULogError("GLState: %s is %u, but the shadow is %u",name,(GLuint)query(pname),value);
+            result = false;
+        }
+    };
+    auto checkcap = [&](int value, GLenum cap) {
+        if (value != UNKNOWN_FLAG && value != (glIsEnabled(cap) ? 1 : 0)) {
+            CULogError("GLState: capability 0x%04x does not match the shadow",cap);
+            result = false;
+        }
+    };
+
+    check(state.program, GL_CURRENT_PROGRAM, "program");
+    check(state.vertexArray, GL_VERTEX_ARRAY_BINDING, "vertex array");
+    check(state.arrayBuffer, GL_ARRAY_BUFFER_BINDING, "array buffer");
+    check(state.elementBuffer, GL_ELEMENT_ARRAY_BUFFER_BINDING, "element buffer");
+    check(state.uniformBuffer, GL_UNIFORM_BUFFER_BINDING, "uniform buffer");
+    check(state.framebuffer, GL_DRAW_FRAMEBUFFER_BINDING, "framebuffer");
+    check(state.srcFactor, GL_BLEND_SRC_RGB, "blend source");
+    check(state.dstFactor, GL_BLEND_DST_RGB, "blend destination");
+    check(state.srcAlpha, GL_BLEND_SRC_ALPHA, "blend alpha source");
+    check(state.dstAlpha, GL_BLEND_DST_ALPHA, "blend alpha destination");
+    check(state.equation, GL_BLEND_EQUATION_RGB, "blend equation");
+    check(state.depthFunc, GL_DEPTH_FUNC, "depth function");
+    checkcap(state.blend, GL_BLEND);
+    checkcap(state.depthTest, GL_DEPTH_TEST);
+    checkcap(state.cullFace, GL_CULL_FACE);
+    checkcap(state.scissorTest, GL_SCISSOR_TEST);
+
+    if (state.depthMask != UNKNOWN_FLAG) {
+        GLboolean mask;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &mask);
+        if ((mask ? 1 : 0) != state.depthMask) {
+            CULogError("GLState: depth mask does not match the shadow");
+            result = false;
+        }
+    }
+    if (state.hasViewport) {
+        GLint real[4];
+        glGetIntegerv(GL_VIEWPORT, real);
+        for(int ii = 0; ii < 4; ii++) {
+            if (real[ii] != state.viewport[ii]) {
+                CULogError("GLState: viewport does not match the shadow");
+                result = false;
+                break;
+            }
+        }
+    }
+    if (state.hasClearColor) {
+        GLfloat real[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, real);
+        for(int ii = 0; ii < 4; ii++) {
+            if (real[ii] != state.clearColor[ii]) {
+                CULogError("GLState: clear color does not match the shadow");
+                result = false;
+                break;
+            }
+        }
+    }
+
+    // Texture units require switching the active unit
+    if (state.unit != UNKNOWN_NAME) {
+        check(state.unit+GL_TEXTURE0, GL_ACTIVE_TEXTURE, "texture unit");
+        for(GLuint ii = 0; ii < TEXTURE_UNITS; ii++) {
+            if (state.textures[ii] != UNKNOWN_NAME) {
+                glActiveTexture(GL_TEXTURE0+ii);
+                check(state.textures[ii], GL_TEXTURE_BINDING_2D, "texture");
+            }
+        }
+        glActiveTexture(GL_TEXTURE0+state.unit);
+    }
+
+    // Uniform binding points require indexed queries
+    for(GLuint ii = 0; ii < UNIFORM_POINTS; ii++) {
+        if (state.points[ii].buffer != UNKNOWN_NAME && !matches(state.points[ii], ii)) {
+            CULogError("GLState: uniform binding point %u does not match the shadow",ii);
+            result = false;
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the number of state changes passed to OpenGL.
+ *
+ * This value is the total since the last call to {@link #resetCounters}.
+ *
+ * @return the number of state changes passed to OpenGL.
+ */
+Uint64 GLState::getIssuedCount() {
+    return _issued;
+}
+
+/**
+ * Returns the number of redundant state changes skipped.
+ *
+ * This value is the total since the last call to {@link #resetCounters}.
+ *
+ * @return the number of redundant state changes skipped.
+ */
+Uint64 GLState::getSkippedCount() {
+    return _skipped;
+}
+
+/**
+ * Resets the counts of issued and skipped state changes to 0.
+ */
+void GLState::resetCounters() {
+    _issued = 0;
+    _skipped = 0;
+}
+
+#pragma mark -
+#pragma mark Programs and Textures
+/**
+ * Makes the given program current (glUseProgram).
+ *
+ * @param program   The program name, or 0 for none
+ */
+void GLState::useProgram(GLuint program) {
+    Shadow& state = shadow();
+    if (!current(state.program, program, GL_CURRENT_PROGRAM, "program")) {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+/**
+ * Returns the current program.
+ *
+ * @return the current program.
+ */
+GLuint GLState::getProgram() {
+    Shadow& state = shadow();
+    if (state.program == UNKNOWN_NAME) {
+        state.program = (GLuint)query(GL_CURRENT_PROGRAM);
+    }
+    return state.program;
+}
+
+/**
+ * Deletes the given program (glDeleteProgram).
+ *
+ * If the program is current, it remains so until another program is
+ * used, as in OpenGL.
+ *
+ * @param program   The program name
+ */
+void GLState::deleteProgram(GLuint program) {
+    glDeleteProgram(program);
+}
+
+/**
+ * Sets the active texture unit (glActiveTexture).
+ *
+ * @param unit  The texture unit (e.g. GL_TEXTURE0)
+ */
+void GLState::activeTexture(GLenum unit) {
+    Shadow& state = shadow();
+    GLuint index = unit-GL_TEXTURE0;
+    GLuint known = state.unit == UNKNOWN_NAME ? UNKNOWN_NAME : state.unit+GL_TEXTURE0;
+    if (!current(known, unit, GL_ACTIVE_TEXTURE, "texture unit")) {
+        glActiveTexture(unit);
+        state.unit = index;
+    }
+}
+
+/**
+ * Returns the active texture unit (e.g. GL_TEXTURE0).
+ *
+ * @return the active texture unit (e.g. GL_TEXTURE0).
+ */
+GLenum GLState::getActiveTexture() {
+    Shadow& state = shadow();
+    if (state.unit == UNKNOWN_NAME) {
+        state.unit = (GLuint)query(GL_ACTIVE_TEXTURE)-GL_TEXTURE0;
+    }
+    return state.unit+GL_TEXTURE0;
+}
+
+/**
+ * Binds a texture to the active unit (glBindTexture).
+ *
+ * Only GL_TEXTURE_2D is tracked.  Other targets are passed directly to
+ * OpenGL.
+ *
+ * @param target    The texture target
+ * @param texture   The texture name, or 0 for none
+ */
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    Shadow& state = shadow();
+    GLuint unit = getActiveTexture()-GL_TEXTURE0;
+    if (target != GL_TEXTURE_2D || unit >= TEXTURE_UNITS) {
+        glBindTexture(target, texture);
+        _issued++;
+        return;
+    }
+    if (!current(state.textures[unit], texture, GL_TEXTURE_BINDING_2D, "texture")) {
+        glBindTexture(target, texture);
+        state.textures[unit] = texture;
+    }
+}
+
+/**
+ * Returns the 2d texture bound to the given unit.
+ *
+ * @param unit  The texture unit (e.g. GL_TEXTURE0)
+ *
+ * @return the 2d texture bound to the given unit.
+ */
+GLuint GLState::getBoundTexture(GLenum unit) {
+    Shadow& state = shadow();
+    GLuint index = unit-GL_TEXTURE0;
+    if (index < TEXTURE_UNITS && state.textures[index] != UNKNOWN_NAME) {
+        return state.textures[index];
+    }
+
+    GLenum active = getActiveTexture();
+    if (active != unit) {
+        glActiveTexture(unit);
+    }
+    GLuint result = (GLuint)query(GL_TEXTURE_BINDING_2D);
+    if (active != unit) {
+        glActiveTexture(active);
+    }
+    if (index < TEXTURE_UNITS) {
+        state.textures[index] = result;
+    }
+    return result;
+}
+
+/**
+ * Deletes the given texture (glDeleteTextures).
+ *
+ * The texture is removed from every unit it is bound to.
+ *
+ * @param texture   The texture name
+ */
+void GLState::deleteTexture(GLuint texture) {
+    Shadow& state = shadow();
+    glDeleteTextures(1, &texture);
+    for(int ii = 0; ii < TEXTURE_UNITS; ii++) {
+        if (state.textures[ii] == texture) {
+            state.textures[ii] = 0;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Buffers
+/**
+ * Binds the given vertex array (glBindVertexArray).
+ *
+ * The element buffer binding is part of the vertex array, so changing
+ * the vertex array forgets the element buffer.
+ *
+ * @param array The vertex array name, or 0 for none
+ */
+void GLState::bindVertexArray(GLuint array) {
+    Shadow& state = shadow();
+    if (!current(state.vertexArray, array, GL_VERTEX_ARRAY_BINDING, "vertex array")) {
+        glBindVertexArray(array);
+        state.vertexArray = array;
+        state.elementBuffer = UNKNOWN_NAME;
+    }
+}
+
+/**
+ * Returns the bound vertex array.
+ *
+ * @return the bound vertex array.
+ */
+GLuint GLState::getVertexArray() {
+    Shadow& state = shadow();
+    if (state.vertexArray == UNKNOWN_NAME) {
+        state.vertexArray = (GLuint)query(GL_VERTEX_ARRAY_BINDING);
+    }
+    return state.vertexArray;
+}
+
+/**
+ * Deletes the given vertex array (glDeleteVertexArrays).
+ *
+ * @param array The vertex array name
+ */
+void GLState::deleteVertexArray(GLuint array) {
+    Shadow& state = shadow();
+    glDeleteVertexArrays(1, &array);
+    if (state.vertexArray == array) {
+        state.vertexArray = 0;
+        state.elementBuffer = UNKNOWN_NAME;
+    }
+}
+
+/**
+ * Binds a buffer to the given target (glBindBuffer).
+ *
+ * Only GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, and GL_UNIFORM_BUFFER
+ * are tracked.  Other targets are passed directly to OpenGL.
+ *
+ * @param target    The buffer target
+ * @param buffer    The buffer name, or 0 for none
+ */
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    Shadow& state = shadow();
+    GLuint* slot = nullptr;
+    GLenum pname = 0;
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            slot = &state.arrayBuffer;
+            pname = GL_ARRAY_BUFFER_BINDING;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            slot = &state.elementBuffer;
+            pname = GL_ELEMENT_ARRAY_BUFFER_BINDING;
+            break;
+        case GL_UNIFORM_BUFFER:
+            slot = &state.uniformBuffer;
+            pname = GL_UNIFORM_BUFFER_BINDING;
+            break;
+    }
+    if (slot == nullptr) {
+        glBindBuffer(target, buffer);
+        _issued++;
+    } else if (!current(*slot, buffer, pname, "buffer")) {
+        glBindBuffer(target, buffer);
+        *slot = buffer;
+    }
+}
+
+/**
+ * Returns the buffer bound to the given target.
+ *
+ * @param target    The buffer target
+ *
+ * @return the buffer bound to the given target.
+ */
+GLuint GLState::getBoundBuffer(GLenum target) {
+    Shadow& state = shadow();
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            if (state.arrayBuffer == UNKNOWN_NAME) {
+                state.arrayBuffer = (GLuint)query(GL_ARRAY_BUFFER_BINDING);
+            }
+            return state.arrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            if (state.elementBuffer == UNKNOWN_NAME) {
+                state.elementBuffer = (GLuint)query(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+            }
+            return state.elementBuffer;
+        case GL_UNIFORM_BUFFER:
+            if (state.uniformBuffer == UNKNOWN_NAME) {
+                state.uniformBuffer = (GLuint)query(GL_UNIFORM_BUFFER_BINDING);
+            }
+            return state.uniformBuffer;
+    }
+    CUAssertLog(false, "Buffer target 0x%04x is not tracked", target);
+    return 0;
+}
+
+/**
+ * Binds a buffer to an indexed binding point (glBindBufferBase).
+ *
+ * Only GL_UNIFORM_BUFFER is tracked.  As in OpenGL, this also binds the
+ * buffer to the generic target.
+ *
+ * @param target    The buffer target
+ * @param index     The binding point
+ * @param buffer    The buffer name, or 0 for none
+ */
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    Shadow& state = shadow();
+    if (target != GL_UNIFORM_BUFFER || index >= UNIFORM_POINTS) {
+        glBindBufferBase(target, index, buffer);
+        if (target == GL_UNIFORM_BUFFER) {
+            state.uniformBuffer = buffer;
+        }
+        _issued++;
+        return;
+    }
+
+    if (_verify) {
+        verifyPoint(state, index);
+    }
+    UniformPoint& point = state.points[index];
+    if (point.buffer == buffer && point.offset == 0 && point.size == 0 &&
+        state.uniformBuffer == buffer) {
+        _skipped++;
+        return;
+    }
+    glBindBufferBase(target, index, buffer);
+    point.buffer = buffer;
+    point.offset = 0;
+    point.size = 0;
+    state.uniformBuffer = buffer;
+    _issued++;
+}
+
+/**
+ * Binds a buffer range to an indexed binding point (glBindBufferRange).
+ *
+ * Only GL_UNIFORM_BUFFER is tracked.  As in OpenGL, this also binds the
+ * buffer to the generic target.
+ *
+ * @param target    The buffer target
+ * @param index     The binding point
+ * @param buffer    The buffer name
+ * @param offset    The offset of the range in bytes
+ * @param size      The size of the range in bytes
+ */
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                              GLintptr offset, GLsizeiptr size) {
+    Shadow& state = shadow();
+    if (target != GL_UNIFORM_BUFFER || index >= UNIFORM_POINTS) {
+        glBindBufferRange(target, index, buffer, offset, size);
+        if (target == GL_UNIFORM_BUFFER) {
+            state.uniformBuffer = buffer;
+        }
+        _issued++;
+        return;
+    }
+
+    if (_verify) {
+        verifyPoint(state, index);
+    }
+    UniformPoint& point = state.points[index];
+    if (point.buffer == buffer && point.offset == offset && point.size == size &&
+        state.uniformBuffer == buffer) {
+        _skipped++;
+        return;
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+    point.buffer = buffer;
+    point.offset = offset;
+    point.size = size;
+    state.uniformBuffer = buffer;
+    _issued++;
+}
+
+/**
+ * Returns the buffer bound to the given uniform binding point.
+ *
+ * @param index     The binding point
+ *
+ * @return the buffer bound to the given uniform binding point.
+ */
+GLuint GLState::getUniformBinding(GLuint index) {
+    Shadow& state = shadow();
+    if (index < UNIFORM_POINTS && state.points[index].buffer != UNKNOWN_NAME) {
+        return state.points[index].buffer;
+    }
+    GLint bound = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &bound);
+    return (GLuint)bound;
+}
+
+/**
+ * Deletes the given buffer (glDeleteBuffers).
+ *
+ * The buffer is removed from every target it is bound to.
+ *
+ * @param buffer    The buffer name
+ */
+void GLState::deleteBuffer(GLuint buffer) {
+    Shadow& state = shadow();
+    glDeleteBuffers(1, &buffer);
+    if (state.arrayBuffer == buffer) {
+        state.arrayBuffer = 0;
+    }
+    if (state.elementBuffer == buffer) {
+        state.elementBuffer = 0;
+    }
+    if (state.uniformBuffer == buffer) {
+        state.uniformBuffer = 0;
+    }
+    for(int ii = 0; ii < UNIFORM_POINTS; ii++) {
+        if (state.points[ii].buffer == buffer) {
+            state.points[ii].buffer = 0;
+            state.points[ii].offset = 0;
+            state.points[ii].size = 0;
+        }
+    }
+}
+
+/**
+ * Binds the given framebuffer (glBindFramebuffer).
+ *
+ * Only GL_FRAMEBUFFER is tracked.  Binding the draw or read framebuffer
+ * separately is passed directly to OpenGL, and forgets the shadow.
+ *
+ * @param target    The framebuffer target
+ * @param buffer    The framebuffer name
+ */
+void GLState::bindFramebuffer(GLenum target, GLuint buffer) {
+    Shadow& state = shadow();
+    if (target != GL_FRAMEBUFFER) {
+        // The draw and read framebuffers may now differ
+        glBindFramebuffer(target, buffer);
+        state.framebuffer = UNKNOWN_NAME;
+        _issued++;
+    } else if (!current(state.framebuffer, buffer, GL_DRAW_FRAMEBUFFER_BINDING, "framebuffer")) {
+        glBindFramebuffer(target, buffer);
+        state.framebuffer = buffer;
+    }
+}
+
+/**
+ * Returns the bound framebuffer.
+ *
+ * @return the bound framebuffer.
+ */
+GLuint GLState::getFramebuffer() {
+    Shadow& state = shadow();
+    if (state.framebuffer == UNKNOWN_NAME) {
+        state.framebuffer = (GLuint)query(GL_DRAW_FRAMEBUFFER_BINDING);
+    }
+    return state.framebuffer;
+}
+
+/**
+ * Deletes the given framebuffer (glDeleteFramebuffers).
+ *
+ * @param buffer    The framebuffer name
+ */
+void GLState::deleteFramebuffer(GLuint buffer) {
+    Shadow& state = shadow();
+    glDeleteFramebuffers(1, &buffer);
+    if (state.framebuffer == buffer) {
+        // OpenGL reverts to 0, which is not the display on every platform
+        state.framebuffer = UNKNOWN_NAME;
+    }
+}
+
+/**
+ * Sets the viewport (glViewport).
+ *
+ * @param x         The viewport x-coordinate
+ * @param y         The viewport y-coordinate
+ * @param width     The viewport width
+ * @param height    The viewport height
+ */
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    Shadow& state = shadow();
+    if (_verify && state.hasViewport) {
+        GLint real[4];
+        glGetIntegerv(GL_VIEWPORT, real);
+        for(int ii = 0; ii < 4; ii++) {
+            if (real[ii] != state.viewport[ii]) {
+                CULogError("GLState: viewport does not match the shadow");
+                state.hasViewport = false;
+                break;
+            }
+        }
+    }
+    if (state.hasViewport && state.viewport[0] == x && state.viewport[1] == y &&
+        state.viewport[2] == width && state.viewport[3] == height) {
+        _skipped++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    state.viewport[0] = x;
+    state.viewport[1] = y;
+    state.viewport[2] = width;
+    state.viewport[3] = height;
+    state.hasViewport = true;
+    _issued++;
+}
+
+/**
+ * Stores the current viewport in the given array.
+ *
+ * The array must have four elements: x, y, width, and height.
+ *
+ * @param viewport  The array to store the viewport
+ */
+void GLState::getViewport(GLint* viewport) {
+    Shadow& state = shadow();
+    if (!state.hasViewport) {
+        glGetIntegerv(GL_VIEWPORT, state.viewport);
+        state.hasViewport = true;
+    }
+    for(int ii = 0; ii < 4; ii++) {
+        viewport[ii] = state.viewport[ii];
+    }
+}
+
+#pragma mark -
+#pragma mark Fragment Operations
+/**
+ * Enables the given capability (glEnable).
+ *
+ * Only GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, and GL_SCISSOR_TEST are
+ * tracked.  Other capabilities are passed directly to OpenGL.
+ *
+ * @param cap   The capability to enable
+ */
+void GLState::enable(GLenum cap) {
+    int* flag = capability(cap);
+    if (flag == nullptr) {
+        glEnable(cap);
+        _issued++;
+    } else if (!current(*flag, 1, cap)) {
+        glEnable(cap);
+        *flag = 1;
+    }
+}
+
+/**
+ * Disables the given capability (glDisable).
+ *
+ * Only GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, and GL_SCISSOR_TEST are
+ * tracked.  Other capabilities are passed directly to OpenGL.
+ *
+ * @param cap   The capability to disable
+ */
+void GLState::disable(GLenum cap) {
+    int* flag = capability(cap);
+    if (flag == nullptr) {
+        glDisable(cap);
+        _issued++;
+    } else if (!current(*flag, 0, cap)) {
+        glDisable(cap);
+        *flag = 0;
+    }
+}
+
+/**
+ * Sets the blend function (glBlendFunc).
+ *
+ * @param srcFactor The source blend factor
+ * @param dstFactor The destination blend factor
+ */
+void GLState::blendFunc(GLenum srcFactor, GLenum dstFactor) {
+    blendFuncSeparate(srcFactor, dstFactor, srcFactor, dstFactor);
+}
+
+/**
+ * Sets the blend function with separate alpha factors (glBlendFuncSeparate).
+ *
+ * If the alpha factors are the same as the color factors, this issues
+ * glBlendFunc instead.
+ *
+ * @param srcFactor The source blend factor for color
+ * @param dstFactor The destination blend factor for color
+ * @param srcAlpha  The source blend factor for alpha
+ * @param dstAlpha  The destination blend factor for alpha
+ */
+void GLState::blendFuncSeparate(GLenum srcFactor, GLenum dstFactor, GLenum srcAlpha, GLenum dstAlpha) {
+    Shadow& state = shadow();
+    if (_verify && state.srcFactor != UNKNOWN_NAME) {
+        if ((GLuint)query(GL_BLEND_SRC_RGB) != state.srcFactor ||
+            (GLuint)query(GL_BLEND_DST_RGB) != state.dstFactor ||
+            (GLuint)query(GL_BLEND_SRC_ALPHA) != state.srcAlpha ||
+            (GLuint)query(GL_BLEND_DST_ALPHA) != state.dstAlpha) {
+            CULogError("GLState: blend function does not match the shadow");
+            state.srcFactor = state.dstFactor = UNKNOWN_NAME;
+            state.srcAlpha  = state.dstAlpha  = UNKNOWN_NAME;
+        }
+    }
+    if (state.srcFactor == srcFactor && state.dstFactor == dstFactor &&
+        state.srcAlpha  == srcAlpha  && state.dstAlpha  == dstAlpha) {
+        _skipped++;
+        return;
+    }
+    if (srcFactor == srcAlpha && dstFactor == dstAlpha) {
+        glBlendFunc(srcFactor, dstFactor);
+    } else {
+        glBlendFuncSeparate(srcFactor, dstFactor, srcAlpha, dstAlpha);
+    }
+    state.srcFactor = srcFactor;
+    state.dstFactor = dstFactor;
+    state.srcAlpha  = srcAlpha;
+    state.dstAlpha  = dstAlpha;
+    _issued++;
+}
+
+/**
+ * Sets the blend equation (glBlendEquation).
+ *
+ * @param equation  The blend equation
+ */
+void GLState::blendEquation(GLenum equation) {
+    Shadow& state = shadow();
+    if (!current(state.equation, equation, GL_BLEND_EQUATION_RGB, "blend equation")) {
+        glBlendEquation(equation);
+        state.equation = equation;
+    }
+}
+
+/**
+ * Sets the depth function (glDepthFunc).
+ *
+ * @param function  The depth function
+ */
+void GLState::depthFunc(GLenum function) {
+    Shadow& state = shadow();
+    if (!current(state.depthFunc, function, GL_DEPTH_FUNC, "depth function")) {
+        glDepthFunc(function);
+        state.depthFunc = function;
+    }
+}
+
+/**
+ * Sets whether to write to the depth buffer (glDepthMask).
+ *
+ * @param flag  Whether to write to the depth buffer
+ */
+void GLState::depthMask(GLboolean flag) {
+    Shadow& state = shadow();
+    int value = flag ? 1 : 0;
+    if (_verify && state.depthMask != UNKNOWN_FLAG) {
+        GLboolean real;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &real);
+        if ((real ? 1 : 0) != state.depthMask) {
+            CULogError("GLState: depth mask does not match the shadow");
+            state.depthMask = UNKNOWN_FLAG;
+        }
+    }
+    if (state.depthMask == value) {
+        _skipped++;
+        return;
+    }
+    glDepthMask(flag);
+    state.depthMask = value;
+    _issued++;
+}
+
+/**
+ * Sets the clear color (glClearColor).
+ *
+ * @param red   The red component
+ * @param green The green component
+ * @param blue  The blue component
+ * @param alpha The alpha component
+ */
+void GLState::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    Shadow& state = shadow();
+    if (state.hasClearColor && state.clearColor[0] == red && state.clearColor[1] == green &&
+        state.clearColor[2] == blue && state.clearColor[3] == alpha) {
+        _skipped++;
+        return;
+    }
+    glClearColor(red, green, blue, alpha);
+    state.clearColor[0] = red;
+    state.clearColor[1] = green;
+    state.clearColor[2] = blue;
+    state.clearColor[3] = alpha;
+    state.hasClearColor = true;
+    _issued++;
+}
@@ -42,6 +42,7 @@
 
 #include <cugl/render/CURenderTarget.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CUGLState.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/util/CUDebug.h>
 
@@ -61,7 +62,7 @@ using namespace cugl;
  * @return true if initialization was successful.
  */
 bool RenderTarget::prepareBuffer() {
-    glGetIntegerv(GL_VIEWPORT, _viewport);
+    GLState::getViewport(_viewport);
     
     GLenum error;
     glGenFramebuffers(1, &_framebo);
@@ -71,7 +72,7 @@ bool RenderTarget::prepareBuffer() {
         return false;
     }
     
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebo);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, _framebo);
 
     // Attach the depth buffer first
     _depthst = Texture::alloc(_width,_height,Texture::PixelFormat::DEPTH_STENCIL);
@@ -389,7 +390,7 @@ bool RenderTarget::init(int width, int height, Texture::PixelFormat* outputs, si
  */
 void RenderTarget::dispose() {
     if (_framebo) {
-        glDeleteFramebuffers(1, &_framebo);
+        GLState::deleteFramebuffer(_framebo);
         _framebo = 0;
     }
     if (_renderbo) {
@@ -435,15 +436,32 @@ const std::shared_ptr<Texture>& RenderTarget::getTexture(size_t index) const {
  * return control to the default render target (the screen) when done.
  */
 void RenderTarget::begin() {
-    glGetIntegerv(GL_VIEWPORT, _viewport);
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebo);
+    GLState::getViewport(_viewport);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, _framebo);
     //glBindRenderbuffer(GL_RENDERBUFFER, _renderbo);
 
-    glViewport(0, 0, _width, _height);
-    glClearColor(_clearcol.r, _clearcol.g, _clearcol.b, _clearcol.a);
+    GLState::viewport(0, 0, _width, _height);
+    GLState::clearColor(_clearcol.r, _clearcol.g, _clearcol.b, _clearcol.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
+/**
+ * Resumes sending draw commands to this render target.
+ *
+ * This method is the same as {@link #begin}, except that it does not
+ * clear the output textures.  It is used to draw on top of the previous
+ * contents of this render target, such as when redrawing part of a frame.
+ *
+ * It is NOT safe to call a resume/end pair of a render target inside of
+ * another render target.  Render targets do not keep a stack.  They alway
+ * return control to the default render target (the screen) when done.
+ */
+void RenderTarget::resume() {
+    GLState::getViewport(_viewport);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, _framebo);
+    GLState::viewport(0, 0, _width, _height);
+}
+
 /**
  * Stops sendinging draw commands to this render target.
  *
@@ -456,6 +474,6 @@ void RenderTarget::begin() {
  */
 void RenderTarget::end() {
     Display::get()->restoreRenderTarget();
-    glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+    GLState::viewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
 }
 
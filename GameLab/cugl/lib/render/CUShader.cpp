@@ -32,6 +32,8 @@
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/render/CUShader.h>
+#include <cugl/render/CUGLState.h>
+#include <cugl/render/CUShaderCache.h>
 #include <cugl/render/CUTexture.h>
 
 using namespace cugl;
@@ -59,6 +61,9 @@ std::string preprocess_shader(const std::string code) {
  * Compiles this shader from the given vertex and fragment shader sources.
  *
  * If compilation fails, it will display error messages on the log.
+ * If the {@link ShaderCache} is active, this method will first attempt to
+ * restore the program from the cache, and will store the program in the
+ * cache if it has to compile it.
  *
  * @return true if compilation was successful.
  */
@@ -73,6 +78,12 @@ bool Shader::compile() {
         return false;
     }
     
+    // Restore a previously linked binary if we can
+    ShaderCache* cache = ShaderCache::get();
+    if (cache != nullptr && cache->load(_vertSource,_fragSource,_program)) {
+        return true;
+    }
+    
     //Create vertex shader and compile it
     _vertShader = glCreateShader( GL_VERTEX_SHADER );
     const char* source = _vertSource.c_str();
@@ -100,6 +111,9 @@ bool Shader::compile() {
     // Now kiss
     glAttachShader( _program, _vertShader );
     glAttachShader( _program, _fragShader );
+    if (cache != nullptr) {
+        cache->prepare(_program);
+    }
     glLinkProgram( _program );
     
     //Check for errors
@@ -112,6 +126,9 @@ bool Shader::compile() {
         return false;
     }
     
+    if (cache != nullptr) {
+        cache->store(_vertSource,_fragSource,_program);
+    }
     return true;
 }
 
@@ -121,10 +138,10 @@ bool Shader::compile() {
  * You must reinitialize the shader to use it.
  */
 void Shader::dispose() {
-    glUseProgram(NULL);
+    GLState::useProgram(0);
     if (_fragShader) { glDeleteShader(_fragShader); _fragShader = 0;}
     if (_vertShader) { glDeleteShader(_vertShader); _vertShader = 0;}
-    if (_program) { glDeleteShader(_program); _program = 0;}
+    if (_program) { GLState::deleteProgram(_program); _program = 0;}
     _vertSource.clear();
     _fragSource.clear();
 
@@ -336,7 +353,7 @@ bool Shader::init(const std::string vsource, const std::string fsource) {
  */
 void Shader::bind() {
     CUAssertLog(_program, "Shader has not been initialized.");
-    glUseProgram( _program );
+    GLState::useProgram( _program );
 }
 
 /**
@@ -347,7 +364,7 @@ void Shader::bind() {
 void Shader::unbind() {
     CUAssertLog(_program, "Shader has not been initialized.");
     if (isBound()) {
-        glUseProgram( NULL );
+        GLState::useProgram( 0 );
     }
 }
 
@@ -359,9 +376,7 @@ void Shader::unbind() {
  * @return true if this shader is currently bound.
  */
 bool Shader::isBound() const {
-    GLint prog;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&prog);
-    return prog == _program;
+    return GLState::getProgram() == _program;
 }
  
 
@@ -0,0 +1,470 @@
+//
+//  CUShaderCache.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an on-disk cache of linked shader programs.  Compiling
+//  and linking GLSL is a large part of the start-up time on low-end devices.
+//  When the driver supports program binaries, this cache saves each linked
+//  program to the save directory, and restores it on the next launch instead
+//  of recompiling it.
+//
+//  Cache entries are keyed by a hash of the shader source together with the
+//  driver vendor, renderer, and version.  Therefore a driver update simply
+//  invalidates the cache.  If a cached binary is rejected for any reason, the
+//  shader falls back to ordinary compilation and the entry is replaced.
+//
+//  This class is a singleton, in the same way as the other CUGL subsystems.
+//  It must be started (after the OpenGL context exists) to be used. Once it
+//  is started, every call to Shader#init will use it automatically, and the
+//  built-in shaders of the engine are precompiled in the background.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/2/21
+#include <cugl/render/CUShaderCache.h>
+#include <cugl/render/CUShader.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/base/CUApplication.h>
+#include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUStrings.h>
+#include <cugl/util/CUDebug.h>
+
+using namespace cugl;
+
+/** The file prefix for cache files */
+#define CACHE_PREFIX    "shader_"
+/** The file suffix for cache files */
+#define CACHE_SUFFIX    ".bin"
+/** The magic number identifying a cache file ("CUSB") */
+#define CACHE_MAGIC     0x43555342
+/** The file format version (bump this if the layout changes) */
+#define CACHE_VERSION   1
+
+/** The FNV-1a offset basis */
+#define FNV_OFFSET  14695981039346656037ULL
+/** The FNV-1a prime */
+#define FNV_PRIME   1099511628211ULL
+
+/** The singleton shader cache */
+std::shared_ptr<ShaderCache> ShaderCache::_gCache = nullptr;
+
+/**
+ * Returns the given hash extended by the given string.
+ *
+ * This is the 64-bit FNV-1a hash.  It is not cryptographic, but it is fast
+ * and more than sufficient to key a local cache.
+ *
+ * @param hash  The hash so far
+ * @param data  The string to add to the hash
+ *
+ * @return the given hash extended by the given string.
+ */
+static Uint64 fnv_hash(Uint64 hash, const std::string& data) {
+    for(auto it = data.begin(); it != data.end(); ++it) {
+        hash ^= (Uint8)(*it);
+        hash *= FNV_PRIME;
+    }
+    // Separate the strings so that "ab"+"c" differs from "a"+"bc"
+    hash ^= 0xff;
+    hash *= FNV_PRIME;
+    return hash;
+}
+
+/**
+ * Returns the given OpenGL string, or the empty string if it is undefined.
+ *
+ * @param name  The string to query
+ *
+ * @return the given OpenGL string, or the empty string if it is undefined.
+ */
+static std::string gl_string(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value == nullptr ? "" : std::string((const char*)value);
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new, uninitialized shader cache.
+ *
+ * The cache is not usable until it is initialized.
+ */
+ShaderCache::ShaderCache() :
+_driver(0),
+_supported(false),
+_hits(0),
+_misses(0) {
+}
+
+/**
+ * Initializes this shader cache with the given directory.
+ *
+ * This method queries the driver for program binary support.  It must be
+ * called on the main thread after the OpenGL context is created.
+ *
+ * @param directory The directory to store the cache files
+ *
+ * @return true if initialization was successful
+ */
+bool ShaderCache::init(const std::string& directory) {
+    _directory = directory;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    _supported = formats > 0;
+
+    _driver = FNV_OFFSET;
+    _driver = fnv_hash(_driver,gl_string(GL_VENDOR));
+    _driver = fnv_hash(_driver,gl_string(GL_RENDERER));
+    _driver = fnv_hash(_driver,gl_string(GL_VERSION));
+
+    if (_supported) {
+        _loader = ThreadPool::alloc(1);
+    } else {
+        CULog("Shader program binaries are not supported by this driver");
+    }
+    return true;
+}
+
+/**
+ * Disposes all of the resources used by this cache.
+ *
+ * This does not delete any cache files on disk.
+ */
+void ShaderCache::dispose() {
+    _loader = nullptr;
+    _entries.clear();
+    _directory.clear();
+    _supported = false;
+    _driver = 0;
+    _hits = 0;
+    _misses = 0;
+}
+
+/**
+ * Starts the singleton shader cache, storing files in the given directory.
+ *
+ * Once this method is called, the method get() will no longer return
+ * nullptr, and all shaders will use the cache.  Calling the method
+ * multiple times (without calling stop) will have no effect. The directory
+ * is typically the {@link Application#getSaveDirectory}.
+ *
+ * This method must be called on the main thread after the OpenGL context
+ * has been created.  If the driver does not support program binaries, the
+ * cache will start, but will have no effect.  Otherwise, the built-in
+ * shaders of {@link SpriteBatch} are registered for precompilation.
+ *
+ * @param directory The directory to store the cache files
+ *
+ * @return true if the cache was successfully started
+ */
+bool ShaderCache::start(const std::string& directory) {
+    if (_gCache != nullptr) {
+        return false;
+    }
+    // The destructor is private, so the deleter must be defined here
+    _gCache = std::shared_ptr<ShaderCache>(new ShaderCache(),[](ShaderCache* cache) { delete cache; });
+    if (!_gCache->init(directory)) {
+        _gCache = nullptr;
+        CUAssertLog(false,"Shader cache failed to initialize");
+        return false;
+    }
+    SpriteBatch::precompileShaders();
+    return true;
+}
+
+/**
+ * Shuts down the singleton shader cache, releasing all resources.
+ *
+ * Once this method is called, the method get() will return nullptr.
+ * Calling the method multiple times (without calling start) will have
+ * no effect.  Cache files on disk are not removed.
+ *
+ * Any precompilation that is still queued is abandoned.
+ */
+void ShaderCache::stop() {
+    if (_gCache == nullptr) {
+        return;
+    }
+    // Queued work may hold the last reference, so join the loader here
+    std::shared_ptr<ShaderCache> cache = _gCache;
+    _gCache = nullptr;
+    cache->dispose();
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the cache key for the given shader sources.
+ *
+ * The key combines the source text with the driver identity.
+ *
+ * @param vsource   The source string for the vertex shader
+ * @param fsource   The source string for the fragment shader
+ *
+ * @return the cache key for the given shader sources.
+ */
+Uint64 ShaderCache::hash(const std::string& vsource, const std::string& fsource) const {
+    Uint64 result = _driver;
+    result = fnv_hash(result,vsource);
+    result = fnv_hash(result,fsource);
+    return result;
+}
+
+/**
+ * Returns the path of the cache file for the given key.
+ *
+ * @param key   The cache key
+ *
+ * @return the path of the cache file for the given key.
+ */
+std::string ShaderCache::getPath(Uint64 key) const {
+    char name[32];
+    snprintf(name, 32, CACHE_PREFIX "%016llx" CACHE_SUFFIX, (unsigned long long)key);
+    return filetool::join_path({_directory,std::string(name)});
+}
+
+/**
+ * Returns true if the cache file for the given key was read successfully.
+ *
+ * This method performs no OpenGL calls, and so it is safe to call from
+ * any thread.
+ *
+ * @param key   The cache key
+ * @param entry The entry to store the binary
+ *
+ * @return true if the cache file for the given key was read successfully.
+ */
+bool ShaderCache::readEntry(Uint64 key, Entry& entry) const {
+    std::string path = getPath(key);
+    SDL_RWops* source = SDL_RWFromFile(path.c_str(), "rb");
+    if (source == nullptr) {
+        return false;
+    }
+
+    bool success = false;
+    Uint32 magic   = SDL_ReadLE32(source);
+    Uint32 version = SDL_ReadLE32(source);
+    Uint64 check   = SDL_ReadLE64(source);
+    Uint32 format  = SDL_ReadLE32(source);
+    Uint32 length  = SDL_ReadLE32(source);
+    if (magic == CACHE_MAGIC && version == CACHE_VERSION && check == key && length > 0) {
+        entry.format = (GLenum)format;
+        entry.data.resize(length);
+        success = SDL_RWread(source, entry.data.data(), 1, length) == length;
+    }
+    SDL_RWclose(source);
+    return success;
+}
+
+/**
+ * Returns true if the binary was written to the cache file for the key.
+ *
+ * This method performs no OpenGL calls, and so it is safe to call from
+ * any thread.
+ *
+ * @param key   The cache key
+ * @param entry The binary to write
+ *
+ * @return true if the binary was written to the cache file for the key.
+ */
+bool ShaderCache::writeEntry(Uint64 key, const Entry& entry) const {
+    std::string path = getPath(key);
+    SDL_RWops* source = SDL_RWFromFile(path.c_str(), "wb");
+    if (source == nullptr) {
+        CULogError("Unable to write shader cache file '%s'",path.c_str());
+        return false;
+    }
+
+    Uint32 length = (Uint32)entry.data.size();
+    bool success = true;
+    success = SDL_WriteLE32(source, CACHE_MAGIC) && success;
+    success = SDL_WriteLE32(source, CACHE_VERSION) && success;
+    success = SDL_WriteLE64(source, key) && success;
+    success = SDL_WriteLE32(source, (Uint32)entry.format) && success;
+    success = SDL_WriteLE32(source, length) && success;
+    success = SDL_RWwrite(source, entry.data.data(), 1, length) == length && success;
+    SDL_RWclose(source);
+
+    if (!success) {
+        // Do not leave a truncated file behind
+        filetool::file_delete(path);
+    }
+    return success;
+}
+
+#pragma mark -
+#pragma mark Cache Access
+/**
+ * Returns true if the program was restored from the cache.
+ *
+ * The program should be freshly created by glCreateProgram, with no
+ * attached shaders.  If this method succeeds, the program is linked and
+ * ready to use.  Otherwise, the program is unchanged and the shader
+ * should be compiled normally.
+ *
+ * @param vsource   The source string for the vertex shader
+ * @param fsource   The source string for the fragment shader
+ * @param program   The program to restore
+ *
+ * @return true if the program was restored from the cache.
+ */
+bool ShaderCache::load(const std::string& vsource, const std::string& fsource, GLuint program) {
+    if (!_supported) {
+        return false;
+    }
+
+    Uint64 key = hash(vsource,fsource);
+    Entry entry;
+    bool found = false;
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        auto it = _entries.find(key);
+        if (it != _entries.end()) {
+            entry = std::move(it->second);
+            _entries.erase(it);
+            found = true;
+        }
+    }
+
+    if (!found && !readEntry(key,entry)) {
+        _misses++;
+        return false;
+    }
+
+    glProgramBinary(program, entry.format, entry.data.data(), (GLsizei)entry.data.size());
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        // The driver rejected the binary; it will be replaced on store
+        _misses++;
+        return false;
+    }
+    _hits++;
+    return true;
+}
+
+/**
+ * Prepares a program to be stored in the cache.
+ *
+ * This method must be called before the program is linked. It tells the
+ * driver that the binary will be retrieved after linking.
+ *
+ * @param program   The program to prepare
+ */
+void ShaderCache::prepare(GLuint program) {
+    if (_supported) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+/**
+ * Returns true if the linked program was stored in the cache.
+ *
+ * The program must have been prepared before linking.
+ *
+ * @param vsource   The source string for the vertex shader
+ * @param fsource   The source string for the fragment shader
+ * @param program   The linked program to store
+ *
+ * @return true if the linked program was stored in the cache.
+ */
+bool ShaderCache::store(const std::string& vsource, const std::string& fsource, GLuint program) {
+    if (!_supported) {
+        return false;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    Entry entry;
+    entry.data.resize(length);
+    GLsizei actual = 0;
+    glGetProgramBinary(program, length, &actual, &entry.format, entry.data.data());
+    if (actual <= 0) {
+        return false;
+    }
+    entry.data.resize(actual);
+    return writeEntry(hash(vsource,fsource),entry);
+}
+
+/**
+ * Registers the given shader for asynchronous precompilation.
+ *
+ * The cache file for this shader is read in a background thread.  If
+ * there is no valid cache file, the shader is compiled on the main thread
+ * at the next animation frame and stored in the cache.  Either way, the
+ * next {@link Shader} with this source will be restored from memory.
+ *
+ * The queued work holds a reference to this cache, so it is safe to stop
+ * the cache before it completes.  This method has no effect if the driver
+ * does not support program binaries.
+ *
+ * @param vsource   The source string for the vertex shader
+ * @param fsource   The source string for the fragment shader
+ */
+void ShaderCache::precompile(const std::string& vsource, const std::string& fsource) {
+    if (!_supported) {
+        return;
+    }
+
+    Uint64 key = hash(vsource,fsource);
+    std::shared_ptr<ShaderCache> self = shared_from_this();
+    _loader->addTask([=](void) {
+        Entry entry;
+        if (self->readEntry(key,entry)) {
+            std::unique_lock<std::mutex> lk(self->_mutex);
+            self->_entries[key] = std::move(entry);
+        } else {
+            // Compilation needs the OpenGL context
+            Application::get()->schedule([=](void) {
+                // Skip it if the cache stopped or a shader was stored first
+                if (ShaderCache::get() == self.get() && !filetool::file_exists(self->getPath(key))) {
+                    // Storing is a side effect of compilation
+                    Shader::alloc(vsource,fsource);
+                }
+                return false;
+            });
+        }
+    });
+}
+
+/**
+ * Deletes all files in this shader cache.
+ *
+ * This is useful for comparing cold and warm start-up times.
+ */
+void ShaderCache::clear() {
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        _entries.clear();
+    }
+    std::vector<std::string> files = filetool::dir_contents(_directory);
+    for(auto it = files.begin(); it != files.end(); ++it) {
+        std::string name = filetool::base_name(*it);
+        if (strtool::starts_with(name,CACHE_PREFIX) && strtool::ends_with(name,CACHE_SUFFIX)) {
+            filetool::file_delete(*it);
+        }
+    }
+}
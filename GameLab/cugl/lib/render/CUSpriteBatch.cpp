@@ -44,12 +44,15 @@
 //  Version: 2/10/20
 #include <cugl/math/cu_math.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUTexture.h>
 #include <cugl/render/CUShader.h>
+#include <cugl/render/CUShaderCache.h>
 #include <cugl/render/CUGradient.h>
 #include <cugl/render/CUScissor.h>
+#include <cugl/render/CUGLState.h>
 
 /**
  * Default fragment shader
@@ -75,6 +78,30 @@ const std::string oglShaderVert =
 #include "shaders/SpriteShader.vert"
 ;
 
+/**
+ * Stroke fragment shader
+ *
+ * This trick uses C++11 raw string literals to put the shader in a separate
+ * file without having to guarantee its presence in the asset directory.
+ * However, to work properly, the #include statement below MUST be on its
+ * own separate line.
+ */
+const std::string oglStrokeFrag =
+#include "shaders/StrokeShader.frag"
+;
+
+/**
+ * Stroke vertex shader
+ *
+ * This trick uses C++11 raw string literals to put the shader in a separate
+ * file without having to guarantee its presence in the asset directory.
+ * However, to work properly, the #include statement below MUST be on its
+ * own separate line.
+ */
+const std::string oglStrokeVert =
+#include "shaders/StrokeShader.vert"
+;
+
 using namespace cugl;
 
 
@@ -88,6 +115,8 @@ using namespace cugl;
 #define TYPE_SCISSOR    4
 /** The drawing type for a (simple) texture blur */
 #define TYPE_GAUSSBLUR  8
+/** The drawing type for a signed distance field texture */
+#define TYPE_DISTANCE   16
 
 /** The drawing command has changed */
 #define DIRTY_COMMAND       1
@@ -107,8 +136,21 @@ using namespace cugl;
 #define DIRTY_UNIBLOCK      128
 /** The blur step has changed */
 #define DIRTY_BLURSTEP      256
+/** The distance field effects have changed */
+#define DIRTY_DISTANCE      512
+/** The depth write mask has changed */
+#define DIRTY_DEPTHWRITE    1024
 /** All values have changed */
-#define DIRTY_ALL_VALS      511
+#define DIRTY_ALL_VALS      2047
+
+/** The number of triangles in a stroke joint or cap (MUST agree with StrokeShader.vert) */
+#define STROKE_PRECISION    10
+/** The number of template vertices in a stroke segment */
+#define STROKE_VERTICES     (2*STROKE_PRECISION+8)
+/** The number of template indices in a stroke segment */
+#define STROKE_INDICES      (6*STROKE_PRECISION+6)
+/** The smallest mitre cosine before falling back to a bevel (MUST agree with StrokeShader.vert) */
+#define STROKE_MITRE_EPSILON    0.00001f
 
 /**
  * Creates a context of the default uniforms.
@@ -120,11 +162,17 @@ SpriteBatch::Context::Context() {
     blendEquation = GL_FUNC_ADD;
     srcFactor = GL_SRC_ALPHA;
     dstFactor = GL_ONE_MINUS_SRC_ALPHA;
+    coverage  = false;
     depthFunc = GL_ALWAYS;
+    depthWrite = true;
     perspective = std::make_shared<Mat4>();
     perspective->setIdentity();
     texture  = nullptr;
     blurstep = 0;
+    outline  = 0;
+    glow     = 0;
+    outlineColor = Color4f::BLACK;
+    glowColor = Color4f::WHITE;
     blockptr = -1;
     type = 0;
 }
@@ -141,12 +189,18 @@ SpriteBatch::Context::Context(Context* copy) {
     command = copy->command;
     srcFactor = copy->srcFactor;
     dstFactor = copy->dstFactor;
+    coverage  = copy->coverage;
     depthFunc = copy->depthFunc;
+    depthWrite = copy->depthWrite;
     blendEquation = copy->blendEquation;
     perspective = copy->perspective;
     texture  = copy->texture;
     blockptr = copy->blockptr;
     blurstep = copy->blurstep;
+    outline  = copy->outline;
+    glow     = copy->glow;
+    outlineColor = copy->outlineColor;
+    glowColor = copy->glowColor;
     dirty = 0;
 }
 
@@ -160,7 +214,9 @@ SpriteBatch::Context::~Context() {
     blendEquation = GL_FALSE;
     srcFactor = GL_FALSE;
     dstFactor = GL_FALSE;
+    coverage  = false;
     depthFunc = GL_ALWAYS;
+    depthWrite = true;
     perspective = nullptr;
     texture  = nullptr;
     blockptr = -1;
@@ -194,6 +250,8 @@ _callTotal(0) {
     _unifbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
+    _strokeShader = nullptr;
+    _strokebuff = nullptr;
 }
 
 /**
@@ -216,6 +274,8 @@ void SpriteBatch::dispose() {
     _unifbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
+    _strokeShader = nullptr;
+    _strokebuff = nullptr;
     
     _vertMax  = 0;
     _vertSize = 0;
@@ -232,6 +292,22 @@ void SpriteBatch::dispose() {
     _active = false;
 }
 
+/**
+ * Registers the built-in sprite batch shaders with the {@link ShaderCache}.
+ *
+ * This registers both the default shader and the stroke shader, so that
+ * they are restored (or compiled) before the first sprite batch needs
+ * them.  It is called by {@link ShaderCache#start}, and does nothing if
+ * the shader cache is not running.
+ */
+void SpriteBatch::precompileShaders() {
+    ShaderCache* cache = ShaderCache::get();
+    if (cache != nullptr) {
+        cache->precompile(SHADER(oglShaderVert),SHADER(oglShaderFrag));
+        cache->precompile(SHADER(oglStrokeVert),SHADER(oglStrokeFrag));
+    }
+}
+
 /**
  * Initializes a sprite batch with the default vertex capacity.
  *
@@ -303,6 +379,7 @@ bool SpriteBatch::init(unsigned int capacity) {
  * @return true if initialization was successful.
  */
 bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& shader) {
+    CUMemoryScope(RENDER);
     if (_initialized) {
         CUAssertLog(false, "SpriteBatch is already initialized");
         return false; // If asserts are turned off.
@@ -604,6 +681,29 @@ void SpriteBatch::setBlendFunc(GLenum srcFactor, GLenum dstFactor) {
     }
 }
 
+/**
+ * Sets whether the alpha channel accumulates coverage.
+ *
+ * Normally the alpha channel is blended with the same factors as the
+ * color channels.  With the default blend function, that squares the alpha
+ * of anything drawn to a clear render target.  If this value is true, the
+ * alpha channel is blended with GL_ONE and GL_ONE_MINUS_SRC_ALPHA instead,
+ * whatever the blend function.  A render target drawn this way holds the
+ * premultiplied image of what was drawn, and can be composited with
+ * GL_ONE and GL_ONE_MINUS_SRC_ALPHA.  The initial value is false.
+ *
+ * Changing this value will cause the sprite batch to flush.
+ *
+ * @param flag  Whether the alpha channel accumulates coverage
+ */
+void SpriteBatch::setAlphaCoverage(bool flag) {
+    if (_context->coverage != flag) {
+        if (_inflight) { record(); }
+        _context->coverage = flag;
+        _context->dirty = _context->dirty | DIRTY_BLENDFACTOR;
+    }
+}
+
 /**
  * Sets the blending equation for this sprite batch
  *
@@ -666,6 +766,25 @@ void SpriteBatch::setDepthFunc(GLenum function) {
     }
 }
 
+/**
+ * Sets whether this sprite batch writes to the depth buffer.
+ *
+ * This value only matters if depth testing is enabled (see
+ * {@link #setDepthFunc}), as OpenGL never writes depth without a depth
+ * test.  Disabling writes allows transparent shapes to be depth tested
+ * against opaque ones without occluding each other.  The initial value
+ * is true.
+ *
+ * @param write Whether to write to the depth buffer
+ */
+void SpriteBatch::setDepthWrite(bool write) {
+    if (_context->depthWrite != write) {
+        if (_inflight) { record(); }
+        _context->depthWrite = write;
+        _context->dirty = _context->dirty | DIRTY_DEPTHWRITE;
+    }
+}
+
 /**
  * Sets the blur step in pixels (0 if there is no blurring).
  *
@@ -704,6 +823,105 @@ void SpriteBatch::setBlurStep(GLuint step) {
     _context->blurstep = step;
 }
 
+/**
+ * Sets whether the active texture is a signed distance field.
+ *
+ * A distance field texture (such as the atlas of a {@link Font} with
+ * distance field support) stores the distance to the nearest glyph edge
+ * in its alpha channel, with 0.5 on the edge itself.  When this value is
+ * true, the alpha channel is thresholded in the shader rather than used
+ * directly.  This produces crisp edges at any scale, and allows for the
+ * outline and glow effects.
+ *
+ * This value should be false for all other textures.  It is false by
+ * default.
+ *
+ * @param field Whether the active texture is a signed distance field
+ */
+void SpriteBatch::setDistanceField(bool field) {
+    if (isDistanceField() == field) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE;
+    if (field) {
+        _context->type = _context->type | TYPE_DISTANCE;
+    } else {
+        _context->type = _context->type & ~TYPE_DISTANCE;
+    }
+}
+
+/**
+ * Returns true if the active texture is a signed distance field.
+ *
+ * A distance field texture (such as the atlas of a {@link Font} with
+ * distance field support) stores the distance to the nearest glyph edge
+ * in its alpha channel, with 0.5 on the edge itself.  When this value is
+ * true, the alpha channel is thresholded in the shader rather than used
+ * directly.  This produces crisp edges at any scale, and allows for the
+ * outline and glow effects.
+ *
+ * This value should be false for all other textures.  It is false by
+ * default.
+ *
+ * @return true if the active texture is a signed distance field.
+ */
+bool SpriteBatch::isDistanceField() const {
+    return (_context->type & TYPE_DISTANCE) != 0;
+}
+
+/**
+ * Sets the outline for distance field textures.
+ *
+ * The outline is drawn just outside of the edge of the distance field.
+ * The width is measured in distance field units, where 0.5 is the full
+ * spread of the field (see {@link Font#getDistanceSpread}). So a width
+ * of 0.25 is an outline half the spread in pixels (at reference scale).
+ * A width of 0 disables the outline.
+ *
+ * This setting has no effect unless {@link #setDistanceField} is true.
+ *
+ * @param width The outline width in distance field units
+ * @param color The outline color
+ */
+void SpriteBatch::setDistanceOutline(float width, const Color4f color) {
+    width = std::max(0.0f,std::min(width,0.5f));
+    if (_context->outline == width && _context->outlineColor == color) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->outline = width;
+    _context->outlineColor = color;
+    _context->dirty = _context->dirty | DIRTY_DISTANCE;
+}
+
+/**
+ * Sets the glow for distance field textures.
+ *
+ * The glow fades out from the edge of the distance field (or the outline
+ * if there is one).  The width is measured in distance field units, where
+ * 0.5 is the full spread of the field (see {@link Font#getDistanceSpread}).
+ * A width of 0 disables the glow.
+ *
+ * This setting has no effect unless {@link #setDistanceField} is true.
+ *
+ * @param width The glow width in distance field units
+ * @param color The glow color
+ */
+void SpriteBatch::setDistanceGlow(float width, const Color4f color) {
+    width = std::max(0.0f,std::min(width,0.5f));
+    if (_context->glow == width && _context->glowColor == color) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->glow = width;
+    _context->glowColor = color;
+    _context->dirty = _context->dirty | DIRTY_DISTANCE;
+}
+
 
 #pragma mark -
 #pragma mark Rendering
@@ -716,15 +934,18 @@ void SpriteBatch::setBlurStep(GLuint step) {
  * Calling this method will reset the vertex and OpenGL call counters to 0.
  */
 void SpriteBatch::begin() {
-    glDisable(GL_CULL_FACE);
-    glDepthMask(true);
-    glEnable(GL_BLEND);
+    GLState::disable(GL_CULL_FACE);
+    GLState::depthMask(_context->depthWrite);
+    GLState::enable(GL_BLEND);
 
     // DO NOT CLEAR.  This responsibility lies elsewhere
     _shader->bind();
     _vertbuff->bind();
     _unifbuff->bind(false);
     _unifbuff->deactivate();
+    
+    // Textures and render targets created between passes change the bindings
+    _context->dirty = _context->dirty | DIRTY_TEXTURE | DIRTY_EQUATION | DIRTY_BLENDFACTOR | DIRTY_DEPTHTEST;
     _active = true;
     _callTotal = 0;
     _vertTotal = 0;
@@ -740,6 +961,8 @@ void SpriteBatch::end() {
     CUAssertLog(_active,"SpriteBatch is not active");
     flush();
     _shader->unbind();
+    // The depth buffer cannot be cleared without the mask
+    GLState::depthMask(true);
     _active = false;
 }
 
@@ -769,22 +992,22 @@ void SpriteBatch::flush() {
     for(auto it = _history.begin(); it != _history.end(); ++it) {
         Context* next = *it;
         if (next->dirty & DIRTY_EQUATION) {
-            glBlendEquation(next->blendEquation);
+            GLState::blendEquation(next->blendEquation);
         }
         if (next->dirty & DIRTY_BLENDFACTOR) {
-            glBlendFunc(next->srcFactor, next->dstFactor);
-        }
-        if (next->dirty & DIRTY_BLENDFACTOR) {
-            glBlendFunc(next->srcFactor, next->dstFactor);
+            applyBlendFunc(next);
         }
         if (next->dirty & DIRTY_DEPTHTEST) {
             if (next->depthFunc == GL_ALWAYS) {
-                glDisable(GL_DEPTH_TEST);
+                GLState::disable(GL_DEPTH_TEST);
             } else {
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(next->depthFunc);
+                GLState::enable(GL_DEPTH_TEST);
+                GLState::depthFunc(next->depthFunc);
             }
         }
+        if (next->dirty & DIRTY_DEPTHWRITE) {
+            GLState::depthMask(next->depthWrite);
+        }
         if (next->dirty & DIRTY_DRAWTYPE) {
              _shader->setUniform1i("uType", next->type);
         }
@@ -803,6 +1026,11 @@ void SpriteBatch::flush() {
         if (next->dirty & DIRTY_BLURSTEP) {
             blurTexture(next->texture,next->blurstep);
         }
+        if (next->dirty & DIRTY_DISTANCE) {
+            _shader->setUniform2f("uDistance", next->outline, next->glow);
+            _shader->setUniformColor4f("uOutline", next->outlineColor);
+            _shader->setUniformColor4f("uGlow", next->glowColor);
+        }
         GLuint amt = next->last-next->first;
         _vertbuff->draw(next->command, amt, next->first);
         _callTotal++;
@@ -2014,8 +2242,309 @@ void SpriteBatch::draw(const std::shared_ptr<Texture>& texture, const Color4f co
 }
 
 
+#pragma mark -
+#pragma mark GPU Strokes
+/**
+ * Draws the given stroke segments with the current color and texture.
+ *
+ * Each segment is expanded by a dedicated shader into a quad, together
+ * with its joint to the next segment (or its end caps). This is the GPU
+ * equivalent of a mesh from {@link SimpleExtruder}. Because the CPU only
+ * uploads one record per segment, it is much faster for long or animated
+ * paths. Use {@link #makeStroke} to create the segments.
+ *
+ * The segments are drawn immediately, using the current perspective,
+ * color, texture, blend settings, depth and scissor mask. Any shapes
+ * batched so far are flushed first, so draw order is preserved. This
+ * method does not support gradients.
+ *
+ * The segments are transformed by the given matrix. The texture map
+ * converts (untransformed) segment positions into texture coordinates.
+ *
+ * @param segments  The stroke segments
+ * @param count     The number of segments
+ * @param transform The coordinate transform
+ * @param texmap    The texture coordinate map
+ */
+void SpriteBatch::stroke(const StrokeSegment* segments, size_t count, const Mat4& transform,
+                         const Affine2& texmap) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    if (count == 0 || (_strokebuff == nullptr && !initStroke())) {
+        return;
+    }
+    flush();
+    
+    // The OpenGL state may lag behind an unused context
+    GLState::blendEquation(_context->blendEquation);
+    applyBlendFunc(_context);
+    if (_context->depthFunc == GL_ALWAYS) {
+        GLState::disable(GL_DEPTH_TEST);
+    } else {
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::depthFunc(_context->depthFunc);
+    }
+    GLState::depthMask(_context->depthWrite);
+
+    _strokebuff->bind();
+    _strokeShader->setUniformMat4("uPerspective",*(_context->perspective.get()));
+    _strokeShader->setUniformMat4("uTransform",transform);
+    _strokeShader->setUniformAffine2("uTexMap",texmap);
+    _strokeShader->setUniform1f("uDepth",_depth);
+    _strokeShader->setUniformColor4f("uColor",_color);
+    
+    GLint type = 0;
+    if (_context->texture != nullptr) {
+        _context->texture->bind();
+        type |= TYPE_TEXTURE;
+    }
+    if (_scissor != nullptr) {
+        float data[13];
+        _scissor->getComponents(data);
+        _strokeShader->setUniformMatrix3fv("uScMatrix",1,data);
+        _strokeShader->setUniform2f("uScExtent",data[9],data[10]);
+        _strokeShader->setUniform2f("uScScale",data[11],data[12]);
+        type |= TYPE_SCISSOR;
+    }
+    _strokeShader->setUniform1i("uType",type);
+    
+    _strokebuff->loadVertexData(segments, (GLsizei)count);
+    _strokebuff->drawInstanced(GL_TRIANGLES, STROKE_INDICES, (GLsizei)count);
+    _callTotal++;
+    _vertTotal += (unsigned int)(count*STROKE_INDICES);
+    
+    // Restore the sprite pipeline
+    _vertbuff->bind();
+}
+
+/**
+ * Appends the stroke segments for the given path to the vector.
+ *
+ * The path is a sequence of vertices, as in {@link SimpleExtruder#set}.
+ * A closed path with more than two vertices has no caps, and has a joint
+ * at every vertex. The stroke width is the distance from the path to
+ * either edge, as in {@link SimpleExtruder#calculate}.
+ *
+ * @param path      The path vertices
+ * @param closed    Whether the path is closed
+ * @param stroke    The stroke width
+ * @param joint     The joint type
+ * @param cap       The end cap type
+ * @param segments  The vector to store the segments
+ *
+ * @return the number of segments appended
+ */
+size_t SpriteBatch::makeStroke(const std::vector<Vec2>& path, bool closed, float stroke,
+                               poly2::Joint joint, poly2::EndCap cap,
+                               std::vector<StrokeSegment>& segments) {
+    size_t size = path.size();
+    if (size < 2) {
+        return 0;
+    }
+    
+    bool loop = closed && size > 2;
+    size_t count = loop ? size : size-1;
+    int style = ((int)joint << StrokeSegment::JOINT_SHIFT) | ((int)cap << StrokeSegment::CAP_SHIFT);
+    
+    size_t start = segments.size();
+    segments.resize(start+count);
+    StrokeSegment* segment = segments.data()+start;
+    for(size_t ii = 0; ii < count; ii++) {
+        bool prev = loop || ii > 0;
+        bool next = loop || ii+1 < count;
+        segment->p0 = path[ii];
+        segment->p1 = path[(ii+1) % size];
+        segment->prev = prev ? path[(ii+size-1) % size] : segment->p0;
+        segment->next = next ? path[(ii+2) % size] : segment->p1;
+        segment->stroke = stroke;
+        segment->flags  = (float)(style | (prev ? StrokeSegment::PREVIOUS : 0) | (next ? StrokeSegment::NEXT : 0));
+        segment++;
+    }
+    return count;
+}
+
+/**
+ * Appends the stroke segments for the given path to the vector.
+ *
+ * The path indices are treated as a list of line segments (so the
+ * geometry should be PATH or IMPLICIT). Consecutive segments that share
+ * a vertex are connected by a joint.  A connected run that returns to
+ * its start (with more than two segments) is closed and has no caps.
+ * The stroke width is the distance from the path to either edge, as in
+ * {@link SimpleExtruder#calculate}.
+ *
+ * @param path      The path polygon
+ * @param stroke    The stroke width
+ * @param joint     The joint type
+ * @param cap       The end cap type
+ * @param segments  The vector to store the segments
+ *
+ * @return the number of segments appended
+ */
+size_t SpriteBatch::makeStroke(const Poly2& path, float stroke,
+                               poly2::Joint joint, poly2::EndCap cap,
+                               std::vector<StrokeSegment>& segments) {
+    const std::vector<Vec2>& verts = path.vertices();
+    const std::vector<Uint32>& indx = path.indices();
+    size_t pairs = indx.size()/2;
+    int style = ((int)joint << StrokeSegment::JOINT_SHIFT) | ((int)cap << StrokeSegment::CAP_SHIFT);
+    
+    size_t start = segments.size();
+    segments.resize(start+pairs);
+    StrokeSegment* segment = segments.data()+start;
+    
+    size_t first = 0;
+    while (first < pairs) {
+        // Find the connected run [first,last)
+        size_t last = first+1;
+        while (last < pairs && indx[2*last] == indx[2*last-1]) {
+            last++;
+        }
+        bool loop = last-first > 2 && indx[2*last-1] == indx[2*first];
+        for(size_t ii = first; ii < last; ii++) {
+            bool prev = loop || ii > first;
+            bool next = loop || ii+1 < last;
+            size_t before = ii > first  ? ii-1 : last-1;
+            size_t after  = ii+1 < last ? ii+1 : first;
+            segment->p0 = verts[indx[2*ii  ]];
+            segment->p1 = verts[indx[2*ii+1]];
+            segment->prev = prev ? verts[indx[2*before]] : segment->p0;
+            segment->next = next ? verts[indx[2*after+1]] : segment->p1;
+            segment->stroke = stroke;
+            segment->flags  = (float)(style | (prev ? StrokeSegment::PREVIOUS : 0) | (next ? StrokeSegment::NEXT : 0));
+            segment++;
+        }
+        first = last;
+    }
+    return pairs;
+}
+
+/**
+ * Returns the bounding box of the given stroke segments.
+ *
+ * The box covers everything the stroke shader draws for these segments,
+ * including square caps and the tips of mitre joints.  It is empty if
+ * there are no segments.
+ *
+ * @param segments  The stroke segments
+ *
+ * @return the bounding box of the given stroke segments.
+ */
+Rect SpriteBatch::getStrokeBounds(const std::vector<StrokeSegment>& segments) {
+    if (segments.empty()) {
+        return Rect::ZERO;
+    }
+    
+    Vec2 lower = segments.front().p0;
+    Vec2 upper = lower;
+    auto merge = [&](const Vec2 point) {
+        lower.x = std::min(lower.x,point.x);
+        lower.y = std::min(lower.y,point.y);
+        upper.x = std::max(upper.x,point.x);
+        upper.y = std::max(upper.y,point.y);
+    };
+    
+    for(auto it = segments.begin(); it != segments.end(); ++it) {
+        int flags = (int)it->flags;
+        int joint = (flags >> StrokeSegment::JOINT_SHIFT) & 3;
+        int cap   = (flags >> StrokeSegment::CAP_SHIFT) & 3;
+        float w = it->stroke;
+        Vec2 dir = it->p1-it->p0;
+        dir.normalize();
+        Vec2 side = dir.getPerp()*w;
+        
+        // This box holds the quad, round caps and joints, and bevels
+        merge(it->p0-Vec2(w,w));
+        merge(it->p0+Vec2(w,w));
+        merge(it->p1-Vec2(w,w));
+        merge(it->p1+Vec2(w,w));
+        
+        // Square caps reach diagonally past it
+        if (cap == (int)poly2::EndCap::SQUARE) {
+            if (!(flags & StrokeSegment::PREVIOUS)) {
+                merge(it->p0-dir*w+side);
+                merge(it->p0-dir*w-side);
+            }
+            if (!(flags & StrokeSegment::NEXT)) {
+                merge(it->p1+dir*w+side);
+                merge(it->p1+dir*w-side);
+            }
+        }
+        
+        // Mitre tips can reach arbitrarily far (as in StrokeShader.vert)
+        if (joint == (int)poly2::Joint::MITRE && (flags & StrokeSegment::NEXT)) {
+            Vec2 out = it->next-it->p1;
+            out.normalize();
+            float turn = dir.cross(out) > 0 ? -1.0f : 1.0f;
+            Vec2 a = dir.getPerp()*turn;
+            Vec2 b = out.getPerp()*turn;
+            Vec2 m = a+b;
+            float len = m.length();
+            if (len > STROKE_MITRE_EPSILON) {
+                m /= len;
+                float cosine = m.dot(a);
+                if (cosine > STROKE_MITRE_EPSILON) {
+                    merge(it->p1+m*(w/cosine));
+                }
+            }
+        }
+    }
+    return Rect(lower,Size(upper.x-lower.x,upper.y-lower.y));
+}
+
+
 #pragma mark -
 #pragma mark Internal Helpers
+/**
+ * Allocates the shader and instance buffer for GPU strokes.
+ *
+ * This method is called the first time that a stroke is drawn, so that
+ * sprite batches that never draw strokes pay nothing for them.
+ *
+ * @return true if the stroke pipeline was successfully allocated
+ */
+bool SpriteBatch::initStroke() {
+    _strokeShader = Shader::alloc(SHADER(oglStrokeVert),SHADER(oglStrokeFrag));
+    if (_strokeShader == nullptr) {
+        CULogError("Could not compile the stroke shader");
+        return false;
+    }
+    
+    _strokebuff = VertexBuffer::alloc(sizeof(StrokeSegment));
+    if (_strokebuff == nullptr) {
+        _strokeShader = nullptr;
+        return false;
+    }
+    _strokebuff->setupAttribute("aSegment",   4, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::StrokeSegment,p0));
+    _strokebuff->setupAttribute("aNeighbors", 4, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::StrokeSegment,prev));
+    _strokebuff->setupAttribute("aStroke",    2, GL_FLOAT, GL_FALSE,
+                                offsetof(cugl::StrokeSegment,stroke));
+    _strokebuff->setAttributeDivisor("aSegment",   1);
+    _strokebuff->setAttributeDivisor("aNeighbors", 1);
+    _strokebuff->setAttributeDivisor("aStroke",    1);
+    _strokebuff->attach(_strokeShader);
+    
+    // The template is the quad, the end fan and the start fan
+    GLuint indices[STROKE_INDICES];
+    GLuint* pos = indices;
+    *pos++ = 0; *pos++ = 1; *pos++ = 2;
+    *pos++ = 2; *pos++ = 1; *pos++ = 3;
+    for(GLuint fan = 4; fan < STROKE_VERTICES; fan += STROKE_PRECISION+2) {
+        for(GLuint ii = 0; ii < STROKE_PRECISION; ii++) {
+            *pos++ = fan;
+            *pos++ = fan+ii+1;
+            *pos++ = fan+ii+2;
+        }
+    }
+    _strokebuff->loadIndexData(indices, STROKE_INDICES, GL_STATIC_DRAW);
+    
+    // Restore the sprite pipeline
+    if (_active) {
+        _vertbuff->bind();
+    }
+    return true;
+}
 /**
  * Records the current set of uniforms, freezing them.
  *
@@ -2024,6 +2553,7 @@ void SpriteBatch::draw(const std::shared_ptr<Texture>& texture, const Color4f co
  * will use the correct set of uniforms.
  */
 void SpriteBatch::record() {
+    CUMemoryScope(RENDER);
     Context* next = new Context(_context);
     _context->last = _indxSize;
     next->first = _indxSize;
@@ -2044,6 +2574,22 @@ void SpriteBatch::unwind() {
     _history.clear();
 }
 
+/**
+ * Sets the OpenGL blend function to agree with the given context.
+ *
+ * This method is called upon flushing.
+ *
+ * @param context   The uniform context to apply
+ */
+void SpriteBatch::applyBlendFunc(Context* context) {
+    if (context->coverage) {
+        GLState::blendFuncSeparate(context->srcFactor, context->dstFactor,
+                                   GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        GLState::blendFunc(context->srcFactor, context->dstFactor);
+    }
+}
+
 /**
  * Sets the active uniform block to agree with the gradient and stroke.
  *
@@ -2619,14 +3165,16 @@ unsigned int SpriteBatch::chunkify(const Mesh<SpriteVertex2>& mesh, const Mat4&
             if (search != offsets.end()) {
                 _indxData[_indxSize] = search->second;
             } else {
+                const SpriteVertex2& vertex = mesh.vertices[mesh.indices[ii+jj]];
                 _indxData[_indxSize] = _vertSize;
-                _vertData[_vertSize].position = Vec3(mesh.vertices[ii+jj].position,_depth);
-                _vertData[_vertSize].color = mesh.vertices[ii+jj].color;
-                _vertData[_vertSize].texcoord = mesh.vertices[ii+jj].texcoord;
+                _vertData[_vertSize].position = Vec3(vertex.position,_depth);
+                _vertData[_vertSize].color = vertex.color;
+                _vertData[_vertSize].texcoord = vertex.texcoord;
                 _vertData[_vertSize].position *= mat;
                 if (tint && _gradient == nullptr) {
                     _vertData[_vertSize].color *= _color;
                 }
+                offsets[mesh.indices[ii+jj]] = _vertSize;
                 _vertSize++;
             }
             _indxSize++;
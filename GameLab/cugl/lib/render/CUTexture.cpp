@@ -33,8 +33,10 @@
 #include <SDL/SDL_image.h>
 #include <sstream>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/util/CUFiletools.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CUGLState.h>
 
 using namespace cugl;
 
@@ -118,6 +120,45 @@ GLenum format_type(Texture::PixelFormat format) {
     return GL_UNSIGNED_BYTE;
 }
 
+/**
+ * Returns true if the given texture data has full alpha everywhere.
+ *
+ * Formats without an alpha channel are always opaque.  RGBA data without
+ * any pixels (e.g. a render target) is assumed to be transparent.
+ *
+ * @param data      The texture data (size width*height*format)
+ * @param width     The texture width in pixels
+ * @param height    The texture height in pixels
+ * @param format    The texture data format
+ *
+ * @return true if the given texture data has full alpha everywhere.
+ */
+static bool is_opaque(const void* data, int width, int height, Texture::PixelFormat format) {
+    switch (format) {
+        case Texture::PixelFormat::RGB:
+        case Texture::PixelFormat::RED:
+        case Texture::PixelFormat::RED_GREEN:
+            return true;
+        case Texture::PixelFormat::RGBA:
+            break;
+        default:
+            return false;
+    }
+    if (data == nullptr) {
+        return false;
+    }
+    
+    // The alpha is the last byte of each pixel in memory
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t total = 4*(size_t)width*(size_t)height;
+    for(size_t ii = 3; ii < total; ii += 4) {
+        if (bytes[ii] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Returns a copy of buffer expanded to RGBA representation.
  *
@@ -177,6 +218,7 @@ _magFilter(GL_LINEAR),
 _wrapS(GL_CLAMP_TO_EDGE),
 _wrapT(GL_CLAMP_TO_EDGE),
 _hasMipmaps(false),
+_opaque(false),
 _parent(nullptr),
 _bindpoint(0),
 _minS(0),
@@ -194,7 +236,8 @@ void Texture::dispose() {
     if (_buffer != 0) {
         // Do we own the texture?
         if (_parent == nullptr) {
-            glDeleteTextures(1, &_buffer);
+            GLState::deleteTexture(_buffer);
+            CUMemoryRemoveResource(TEXTURE,getGPUSize());
         }
         _buffer = 0;
         _width = 0; _height = 0;
@@ -206,6 +249,7 @@ void Texture::dispose() {
         _minS = _minT = 0;
         _maxS = _maxT = 1;
         _hasMipmaps = false;
+        _opaque = false;
         _bindpoint  = 0;
         _dirty = false;
     }
@@ -248,8 +292,8 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
     _width  = width;
     _height = height;
     _pixelFormat = format;
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _buffer);
+    GLState::activeTexture(GL_TEXTURE0);
+    GLState::bindTexture(GL_TEXTURE_2D, _buffer);
 
     GLint  internal = internal_format(format);
     GLenum datatype = format_type(format);
@@ -258,7 +302,7 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
     error = glGetError();
     if (error) {
         CULogError("Could not initialize texture. %s", gl_error_name(error).c_str());
-        glDeleteTextures(1, &_buffer);
+        GLState::deleteTexture(_buffer);
         _buffer = 0;
         return false;
     }
@@ -268,7 +312,9 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrapS);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _wrapT);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    CUMemoryAddResource(TEXTURE,getGPUSize());
+    _opaque = is_opaque(data, width, height, format);
     std::stringstream ss;
     ss << "@" << data;
     setName(ss.str());
@@ -370,9 +416,32 @@ const Texture& Texture::set(const void *data) {
 
     glTexImage2D(GL_TEXTURE_2D, 0, (GLenum)_pixelFormat, _width, _height, 0,
                  (GLenum)_pixelFormat, GL_UNSIGNED_BYTE, data);
+    if (_parent == nullptr) {
+        _opaque = is_opaque(data, _width, _height, _pixelFormat);
+    }
     return *this;
 }
 
+/**
+ * Sets whether every pixel of this texture has full alpha.
+ *
+ * This value is normally determined from the texture data.  This
+ * setter allows an application to override it, such as for a render
+ * target that is known to be opaque.  Marking a texture with partial
+ * alpha as opaque will produce rendering artifacts.
+ *
+ * This method will fail if this texture is a subtexture.  Only the
+ * parent can be marked opaque.
+ *
+ * @param opaque    Whether every pixel of this texture has full alpha
+ */
+void Texture::setOpaque(bool opaque) {
+    CUAssertLog(_parent == nullptr, "Cannot mark a subtexture as opaque");
+    if (_parent == nullptr) {
+        _opaque = opaque;
+    }
+}
+
 
 #pragma mark -
 #pragma mark Attributes
@@ -404,6 +473,24 @@ unsigned int Texture::getByteSize() const {
     return GL_RGBA8;
 }
 
+/**
+ * Returns the estimated size of this texture in GPU memory.
+ *
+ * This is the size of the pixel data, plus a third for the mipmaps if
+ * they are built.  The driver may pad the data or store it in another
+ * format, so this is only an estimate.  A subtexture returns the size
+ * of its parent.
+ *
+ * @return the estimated size of this texture in GPU memory.
+ */
+size_t Texture::getGPUSize() const {
+    if (_parent != nullptr) {
+        return _parent->getGPUSize();
+    }
+    size_t size = (size_t)_width*(size_t)_height*getByteSize();
+    return _hasMipmaps ? size+size/3 : size;
+}
+
 /**
  * Builds mipmaps for the current texture.
  *
@@ -419,7 +506,11 @@ void Texture::buildMipMaps() {
     CUAssertLog(_parent == nullptr, "Cannot build mipmaps for a subtexture");
     CUAssertLog(isActive(), "Texture is not active");
     glGenerateMipmap(GL_TEXTURE_2D);
-    _hasMipmaps = true;
+    if (!_hasMipmaps) {
+        size_t size = getGPUSize();
+        _hasMipmaps = true;
+        CUMemoryResizeResource(TEXTURE,size,getGPUSize());
+    }
 }
 
 /**
@@ -593,18 +684,11 @@ std::shared_ptr<Texture> Texture::getSubTexture(GLfloat minS, GLfloat maxS,
  * @param the texture location to associate with this texture.
  */
 void Texture::setBindPoint(GLuint point) {
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    if (bind == _buffer) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
+    if (GLState::getBoundTexture(GL_TEXTURE0+_bindpoint) == _buffer) {
+        GLenum orig = GLState::getActiveTexture();
+        GLState::activeTexture(GL_TEXTURE0+_bindpoint);
+        GLState::bindTexture(GL_TEXTURE_2D, 0);
+        GLState::activeTexture(orig);
     }
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "Texture: %s", gl_error_name(error).c_str());
@@ -633,8 +717,8 @@ void Texture::bind() {
         return;
     }
     
-    glActiveTexture(GL_TEXTURE0+_bindpoint);
-    glBindTexture(GL_TEXTURE_2D,_buffer);
+    GLState::activeTexture(GL_TEXTURE0+_bindpoint);
+    GLState::bindTexture(GL_TEXTURE_2D,_buffer);
     if (_dirty) {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _minFilter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _magFilter);
@@ -661,15 +745,10 @@ void Texture::unbind() {
         return;
     }
 
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
-    }
+    GLenum orig = GLState::getActiveTexture();
+    GLState::activeTexture(GL_TEXTURE0+_bindpoint);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    GLState::activeTexture(orig);
 }
 
 /**
@@ -690,18 +769,7 @@ bool Texture::isBound() const {
         return false;
     }
     
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    bool result = (bind == _buffer);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
-    }
-    return result;
+    return GLState::getBoundTexture(GL_TEXTURE0+_bindpoint) == _buffer;
 }
 
 /**
@@ -721,14 +789,10 @@ bool Texture::isActive() const {
     if (!_buffer) {
         return false;
     }
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
+    if (GLState::getActiveTexture() != _bindpoint+GL_TEXTURE0) {
         return false;
     }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    return (bind == _buffer);
+    return GLState::getBoundTexture(GL_TEXTURE0+_bindpoint) == _buffer;
 }
 
 
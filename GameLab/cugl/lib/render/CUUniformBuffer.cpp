@@ -43,7 +43,9 @@
 //  Author: Walker White
 //  Version: 2/29/20
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/render/CUUniformBuffer.h>
+#include <cugl/render/CUGLState.h>
 
 using namespace cugl;
 
@@ -140,18 +142,19 @@ bool UniformBuffer::init(GLsizei capacity, GLuint blocks) {
     }
 
     _bytebuffer = (char*)malloc(_blockstride*_blockcount);
-    glBindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
     glBufferData(GL_UNIFORM_BUFFER, _blockstride*_blockcount, NULL, _drawtype);
     error = glGetError();
     if (error) {
-        glDeleteBuffers(1, &_dataBuffer);
+        GLState::deleteBuffer(_dataBuffer);
         _dataBuffer = 0;
         CULogError("Could not allocate memory for uniform buffer. %s",
                    gl_error_name(error).c_str());
         return false;
     }
     
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
+    CUMemoryAddResource(BUFFER,_blockstride*_blockcount);
     return true;
 }
 
@@ -162,7 +165,8 @@ bool UniformBuffer::init(GLsizei capacity, GLuint blocks) {
  */
 void UniformBuffer::dispose() {
     if (_dataBuffer) {
-        glDeleteBuffers(1,&_dataBuffer);
+        GLState::deleteBuffer(_dataBuffer);
+        CUMemoryRemoveResource(BUFFER,_blockstride*_blockcount);
         _dataBuffer = 0;
     }
     if (_bytebuffer) {
@@ -198,10 +202,8 @@ void UniformBuffer::dispose() {
  * @param point The bind point for for this uniform buffer.
  */
 void UniformBuffer::setBindPoint(GLuint point) {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    if (bound == _dataBuffer) {
-        glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
+    if (GLState::getUniformBinding(_bindpoint) == _dataBuffer) {
+        GLState::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
     }
     _bindpoint = point;
 }
@@ -230,7 +232,7 @@ void UniformBuffer::bind(bool activate) {
     if (activate) {
         this->activate();
     }
-    glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, _dataBuffer);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, _dataBuffer);
 }
 
 /**
@@ -247,10 +249,8 @@ void UniformBuffer::bind(bool activate) {
  * This call is reentrant.  If can be safely called multiple times.
  */
 void UniformBuffer::unbind() {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    if (bound == _dataBuffer) {
-        glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
+    if (GLState::getUniformBinding(_bindpoint) == _dataBuffer) {
+        GLState::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
     }
 }
 
@@ -269,7 +269,7 @@ void UniformBuffer::unbind() {
  * This call is reentrant.  If can be safely called multiple times.
  */
 void UniformBuffer::activate() {
-    glBindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
     if (_autoflush && _dirty) {
         glBufferData(GL_UNIFORM_BUFFER,_blockstride*_blockcount,_bytebuffer,_drawtype);
         _dirty = false;
@@ -290,12 +290,10 @@ void UniformBuffer::activate() {
 void UniformBuffer::deactivate() {
 #if CU_PLATFORM == CU_PLATFORM_ANDROID
  	// There are problems with this query on emulator
- 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+ 	GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
 #else
-	GLint bound;
-    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING,&bound);
-    if (bound == _dataBuffer) {
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (GLState::getBoundBuffer(GL_UNIFORM_BUFFER) == _dataBuffer) {
+        GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 #endif
 }
@@ -310,9 +308,7 @@ void UniformBuffer::deactivate() {
  * @return true if this uniform block is currently bound.
  */
 bool UniformBuffer::isBound() const {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    return bound == _dataBuffer;
+    return GLState::getUniformBinding(_bindpoint) == _dataBuffer;
 }
     
 /**
@@ -329,9 +325,7 @@ bool UniformBuffer::isBound() const {
  * @return true if this uniform block is currently active.
  */
 bool UniformBuffer::isActive() const {
-    GLint bound;
-    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING,&bound);
-    return bound == _dataBuffer;
+    return GLState::getBoundBuffer(GL_UNIFORM_BUFFER) == _dataBuffer;
 }
 
 /**
@@ -347,7 +341,7 @@ void UniformBuffer::setBlock(GLuint block) {
     CUAssertLog(isBound(), "Buffer is not bound.");
     if (_blockpntr != block) {
         _blockpntr = block;
-        glBindBufferRange(GL_UNIFORM_BUFFER,_bindpoint,_dataBuffer,
+        GLState::bindBufferRange(GL_UNIFORM_BUFFER,_bindpoint,_dataBuffer,
                           block*_blockstride,_blocksize);
     }
 }
@@ -30,7 +30,9 @@
 //  Author: Walker White
 //  Version: 2/10/20
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUMemoryTracker.h>
 #include <cugl/render/CUVertexBuffer.h>
+#include <cugl/render/CUGLState.h>
 #include <cugl/render/CUShader.h>
 #include <cugl/render/CUTexture.h>
 
@@ -43,10 +45,12 @@ using namespace cugl;
  * You must initialize the vertex buffer to allocate buffer memory.
  */
 VertexBuffer::VertexBuffer() :
+_stride(0),
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
-_stride(0) {
+_vertBytes(0),
+_indxBytes(0) {
     _shader = nullptr;
 }
 
@@ -85,7 +89,7 @@ bool VertexBuffer::init(GLsizei stride) {
     glGenBuffers(1, &_vertBuffer);
     if (!_vertBuffer) {
         GLenum error = glGetError();
-        glDeleteVertexArrays(1,&_vertArray);
+        GLState::deleteVertexArray(_vertArray);
         CULogError("Could not create vertex buffer. %s", gl_error_name(error).c_str());
         return false;
     }
@@ -94,11 +98,12 @@ bool VertexBuffer::init(GLsizei stride) {
     if (!_indxBuffer) {
         GLenum error = glGetError();
         CULogError("Could not create index buffer. %s", gl_error_name(error).c_str());
-        glDeleteVertexArrays(1,&_vertArray);
-        glDeleteBuffers(1,&_vertBuffer);
+        GLState::deleteVertexArray(_vertArray);
+        GLState::deleteBuffer(_vertBuffer);
         return false;
     }
     
+    CUMemoryAddResource(BUFFER,0);
     return true;
 }
 
@@ -113,12 +118,15 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
-    glDeleteBuffers(1,&_indxBuffer);
-    glDeleteBuffers(1,&_vertBuffer);
-    glDeleteVertexArrays(1,&_vertArray);
+    GLState::deleteBuffer(_indxBuffer);
+    GLState::deleteBuffer(_vertBuffer);
+    GLState::deleteVertexArray(_vertArray);
+    CUMemoryRemoveResource(BUFFER,_vertBytes+_indxBytes);
     _indxBuffer = 0;
     _vertBuffer = 0;
     _vertArray  = 0;
+    _vertBytes  = 0;
+    _indxBytes  = 0;
     _shader = nullptr;
     _stride = 0;
 }
@@ -139,9 +147,9 @@ void VertexBuffer::dispose() {
  */
 void VertexBuffer::bind() {
     CUAssertLog(_vertBuffer, "VertexBuffer has not be initialized.");
-    glBindVertexArray(_vertArray);
-	glBindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
-	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indxBuffer );
+    GLState::bindVertexArray(_vertArray);
+	GLState::bindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
+	GLState::bindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indxBuffer );
     if (_shader != nullptr) {
         _shader->bind();
     }
@@ -160,9 +168,9 @@ void VertexBuffer::bind() {
  */
 void VertexBuffer::unbind() {
     if (isBound()) {
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
-        glBindBuffer( GL_ARRAY_BUFFER, 0 );
-        glBindVertexArray(0);
+        GLState::bindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+        GLState::bindBuffer( GL_ARRAY_BUFFER, 0 );
+        GLState::bindVertexArray(0);
     }
 }
 
@@ -193,6 +201,7 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
 				glVertexAttribPointer(pos,it->second.size,it->second.type,
 									  it->second.norm,_stride,
 									  reinterpret_cast<void*>(it->second.offset));
+				glVertexAttribDivisor(pos,it->second.divisor);
 			} else {
 				glDisableVertexAttribArray(pos);
 			}
@@ -225,9 +234,7 @@ std::shared_ptr<Shader> VertexBuffer::detach() {
  * @return true if this vertex is currently bound.
  */
 bool VertexBuffer::isBound() const {
-    GLint vao;
-    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
-    return vao == _vertArray;
+    return GLState::getVertexArray() == _vertArray;
 }
 
 
@@ -261,6 +268,8 @@ bool VertexBuffer::isBound() const {
 void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
     glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
+    CUMemoryResizeResource(BUFFER,_vertBytes,_stride * size);
+    _vertBytes = _stride * size;
     
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
@@ -295,6 +304,8 @@ void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage)
 void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
     glBufferData( GL_ELEMENT_ARRAY_BUFFER, size * sizeof(GLuint), data, usage );
+    CUMemoryResizeResource(BUFFER,_indxBytes,size * sizeof(GLuint));
+    _indxBytes = size * sizeof(GLuint);
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
 }
@@ -387,6 +398,7 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
     data.norm = norm;
     data.type = type;
     data.offset = offset;
+    data.divisor = 0;
     _attributes[name] = data;
     _enabled[name] = true;
     
@@ -399,6 +411,7 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
             glEnableVertexAttribArray(pos);
             glVertexAttribPointer(pos,data.size,data.type,data.norm,_stride,
                                   reinterpret_cast<void*>(data.offset));
+            glVertexAttribDivisor(pos,0);
         }
         
         GLenum error = glGetError();
@@ -449,3 +462,43 @@ void VertexBuffer::disableAttribute(const std::string name) {
 		}
 	}    
 }
+
+/**
+ * Sets the instance divisor of the given attribute
+ *
+ * By default, every attribute is a vertex attribute, advancing once per
+ * vertex.  An attribute with a positive divisor instead advances once
+ * every divisor instances in a call to {@link #drawInstanced}.  This
+ * allows a vertex buffer to store one record per instance (such as a
+ * line segment), which is then expanded by the vertex shader.
+ *
+ * A shader using only instanced attributes may use gl_VertexID to
+ * identify the vertex of each instance, with the index buffer providing
+ * the template.
+ *
+ * Like {@link #setupAttribute}, this value is cached and applied when a
+ * shader is attached. The attribute must be set up first.
+ *
+ * @param name      The attribute name
+ * @param divisor   The number of instances sharing each value
+ */
+void VertexBuffer::setAttributeDivisor(const std::string name, GLuint divisor) {
+    auto it = _attributes.find(name);
+    CUAssertLog(it != _attributes.end(), "Vertex buffer has no attribute %s", name.c_str());
+    if (it == _attributes.end()) {
+        return;
+    }
+    it->second.divisor = divisor;
+    
+    if (_shader != nullptr) {
+        _shader->bind();
+        GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+        if (pos != -1) {
+            GLState::bindVertexArray(_vertArray);
+            glVertexAttribDivisor(pos,divisor);
+        }
+        
+        GLenum error = glGetError();
+        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    }
+}
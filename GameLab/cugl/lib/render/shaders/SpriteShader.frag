@@ -6,8 +6,9 @@ R"(////////// SHADER BEGIN /////////
 //  It supports textures which can be tinted per vertex. It also supports gradients
 //  (which can be used simulataneously with textures, but not with colors), as
 //  well as a scissor mask.  Gradients use the color inputs as their texture
-//  coordinates. Finally, there is support for very simple blur effects, which
-//  are used for font labels.
+//  coordinates. There is support for very simple blur effects, which are used
+//  for font labels. Finally, there is support for signed distance field
+//  textures (such as distance field font atlases) with outline and glow.
 //
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -39,6 +40,12 @@ precision highp float;  // highp required for gradient precision
 uniform int  uType;
 // Blur offset for simple kernel blur
 uniform vec2 uBlur;
+// Outline and glow widths for distance fields
+uniform vec2 uDistance;
+// Outline color for distance fields
+uniform vec4 uOutline;
+// Glow color for distance fields
+uniform vec4 uGlow;
 
 //UNIFORM BOIIIIIII
 //TODO:
@@ -148,6 +155,35 @@ vec4 blursample(vec2 coord) {
     return result;
 }
 
+/**
+ * Returns the color of a signed distance field sample
+ *
+ * The alpha channel of the texture is the distance to the edge, with
+ * 0.5 on the edge itself. The edge is antialiased with the screen-space
+ * derivative, so it is crisp at any scale.  The outline (if any) sits
+ * just outside the edge, and the glow (if any) fades out beyond that.
+ *
+ * color:   The fill color (tint or gradient)
+ * coord:   The texture coordinate to sample
+ */
+vec4 distancesample(vec4 color, vec2 coord) {
+    float dist  = texture(uTexture, coord).a;
+    float width = max(fwidth(dist), 0.0001);
+    float fill  = smoothstep(0.5-width, 0.5+width, dist);
+    vec4 result = vec4(color.rgb, color.a*fill);
+    
+    float edge = 0.5-uDistance.x;
+    if (uDistance.x > 0.0) {
+        float line = smoothstep(edge-width, edge+width, dist);
+        result = mix(vec4(uOutline.rgb, uOutline.a*line), color, fill);
+    }
+    if (uDistance.y > 0.0) {
+        float glow = smoothstep(edge-uDistance.y, edge, dist)*uGlow.a;
+        result = mix(vec4(uGlow.rgb, glow), result, result.a);
+    }
+    return result;
+}
+
 /**
  * Performs the main fragment shading.
  */
@@ -181,7 +217,9 @@ void main(void) {
     
     if (mod(fType, 2.0) == 1.0) {
         // Include texture (tinted by color or gradient)
-        if (uType >= 8) {
+        if (mod(fType, 32.0) >= 16.0) {
+            result = distancesample(result, outTexCoord);
+        } else if (mod(fType, 16.0) >= 8.0) {
             result *= blursample(outTexCoord);
         } else {
             result *= texture(uTexture, outTexCoord);
@@ -0,0 +1,87 @@
+R"(////////// SHADER BEGIN /////////
+//  StrokeShader.frag
+//  Cornell University Game Library (CUGL)
+//
+//  This is the SpriteBatch stroke fragment shader for both OpenGL and OpenGL
+//  ES. It supports a tint color, an optional texture and a scissor mask. The
+//  scissor is passed as individual uniforms (not a block) since a stroke is
+//  always drawn with a single context.  Gradients are not supported.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+#ifdef CUGLES
+// This one line is all the difference
+precision highp float;
+#endif
+
+// Bit vector for texturing and scissoring
+uniform int  uType;
+// The stroke tint color
+uniform vec4 uColor;
+// The texture for sampling
+uniform sampler2D uTexture;
+
+// The scissor mask
+uniform mat3 uScMatrix;
+uniform vec2 uScExtent;
+uniform vec2 uScScale;
+
+// The output color
+out vec4 frag_color;
+
+// The inputs from the vertex shader
+in vec2 outPosition;
+in vec2 outTexCoord;
+
+/**
+ * Returns an alpha value for scissoring
+ *
+ * A pixel with value 0 is dropped, while one with value 1 is kept.
+ * The scale value sets the 0 to 1 transition (which should be quick).
+ *
+ * Adapted from nanovg by Mikko Mononen (memon@inside.org)
+ *
+ * pt:  The point to test
+ */
+float scissormask(vec2 pt) {
+    vec2 sc = (abs((uScMatrix * vec3(pt,1.0)).xy) - uScExtent);
+    sc = vec2(0.5,0.5) - sc * uScScale;
+    return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);
+}
+
+/**
+ * Performs the main fragment shading.
+ */
+void main(void) {
+    vec4 result = uColor;
+    float fType = float(uType);
+    if (mod(fType, 2.0) == 1.0) {
+        result *= texture(uTexture, outTexCoord);
+    }
+    if (mod(fType, 8.0) >= 4.0) {
+        result *= scissormask(outPosition);
+    }
+    frag_color = result;
+}
+
+/////////// SHADER END //////////)"
+
@@ -0,0 +1,191 @@
+R"(////////// SHADER BEGIN /////////
+//  StrokeShader.vert
+//  Cornell University Game Library (CUGL)
+//
+//  This is the SpriteBatch stroke vertex shader for both OpenGL and OpenGL ES.
+//  It expands each instanced path segment into a quad, plus a fan for either
+//  the joint to the next segment or the end cap.  Joints and caps follow the
+//  same rules as SimpleExtruder, so the results are comparable.  The shader
+//  has no per-vertex attributes; the vertex id picks the template position.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+// The segment end points (p0, p1)
+in vec4 aSegment;
+// The neighboring points (previous start, next end)
+in vec4 aNeighbors;
+// The stroke width and the flags
+in vec2 aStroke;
+
+// Untransformed position for scissor
+out vec2 outPosition;
+// Texture coordinates
+out vec2 outTexCoord;
+
+// Matrices
+uniform mat4 uPerspective;
+uniform mat4 uTransform;
+uniform mat3 uTexMap;
+uniform float uDepth;
+
+// The fan resolution (MUST agree with STROKE_PRECISION in SpriteBatch)
+const int PRECISION = 10;
+// The smallest mitre cosine before falling back to a bevel (SimpleExtruder has no mitre limit)
+const float MITRE_EPSILON = 0.00001;
+const float PI = 3.14159265358979;
+
+/**
+ * Returns the vector rotated counter-clockwise by 90 degrees
+ *
+ * v:   The vector to rotate
+ */
+vec2 perp(vec2 v) {
+    return vec2(-v.y, v.x);
+}
+
+/**
+ * Returns the unit direction from a to b
+ *
+ * Degenerate segments point along the x-axis.
+ *
+ * a:   The start point
+ * b:   The end point
+ */
+vec2 direction(vec2 a, vec2 b) {
+    vec2 d = b-a;
+    float len = length(d);
+    return len > 0.0 ? d/len : vec2(1.0,0.0);
+}
+
+/**
+ * Returns the position of a rim vertex in a joint fan
+ *
+ * The joint fills the gap on the outside of the turn from d0 to d1.
+ * Rim vertex 0 is on the edge of the incoming segment, and rim vertex
+ * PRECISION is on the edge of the outgoing segment.
+ *
+ * c:    The joint center
+ * d0:   The incoming direction
+ * d1:   The outgoing direction
+ * w:    The stroke width
+ * type: The joint type (NONE, MITRE, SQUARE, ROUND)
+ * k:    The rim vertex index
+ */
+vec2 joint(vec2 c, vec2 d0, vec2 d1, float w, int type, int k) {
+    if (type == 0) {
+        return c;
+    }
+    float side = (d0.x*d1.y-d0.y*d1.x) > 0.0 ? -1.0 : 1.0;
+    vec2 a = perp(d0)*side;
+    vec2 b = perp(d1)*side;
+    if (k == 0) {
+        return c+a*w;
+    } else if (k == PRECISION) {
+        return c+b*w;
+    } else if (type == 3) {
+        float angle = atan(a.x*b.y-a.y*b.x, dot(a,b))*float(k)/float(PRECISION);
+        return c+(a*cos(angle)+perp(a)*sin(angle))*w;
+    } else if (type == 1) {
+        vec2 m = a+b;
+        float len = length(m);
+        if (len > MITRE_EPSILON) {
+            m /= len;
+            float cosine = dot(m,a);
+            if (cosine > MITRE_EPSILON) {
+                return c+m*(w/cosine);
+            }
+        }
+    }
+    return c+b*w;
+}
+
+/**
+ * Returns the position of a rim vertex in an end cap fan
+ *
+ * Rim vertex 0 is on the left edge of the segment, and rim vertex
+ * PRECISION is on the right edge (looking along d).
+ *
+ * c:    The cap center
+ * d:    The outward direction of the cap
+ * w:    The stroke width
+ * type: The cap type (NONE, SQUARE, ROUND)
+ * k:    The rim vertex index
+ */
+vec2 cap(vec2 c, vec2 d, float w, int type, int k) {
+    vec2 n = perp(d);
+    if (type == 1) {
+        if (k == 0) {
+            return c+n*w;
+        } else if (k == PRECISION) {
+            return c-n*w;
+        }
+        return c+(d+(2*k <= PRECISION ? n : -n))*w;
+    } else if (type == 2) {
+        float angle = PI*float(k)/float(PRECISION);
+        return c+(n*cos(angle)+d*sin(angle))*w;
+    }
+    return c;
+}
+
+// Expand, transform and pass through
+void main(void) {
+    int flags = int(aStroke.y+0.5);
+    int jtype = (flags >> 2) & 3;
+    int ctype = (flags >> 4) & 3;
+    float w = aStroke.x;
+    vec2 p0 = aSegment.xy;
+    vec2 p1 = aSegment.zw;
+    vec2 d  = direction(p0,p1);
+    vec2 n  = perp(d);
+
+    // Vertices 0-3 are the quad, followed by the end fan and the start fan
+    vec2 pos;
+    int id = gl_VertexID;
+    if (id < 4) {
+        pos = (id < 2 ? p0 : p1)+((id & 1) == 0 ? n : -n)*w;
+    } else if (id < PRECISION+6) {
+        int k = id-5;
+        if (k < 0) {
+            pos = p1;
+        } else if ((flags & 2) != 0) {
+            pos = joint(p1,d,direction(p1,aNeighbors.zw),w,jtype,k);
+        } else {
+            pos = cap(p1,d,w,ctype,k);
+        }
+    } else {
+        int k = id-PRECISION-7;
+        if (k < 0 || (flags & 1) != 0) {
+            pos = p0; // Joint is drawn by the previous segment
+        } else {
+            pos = cap(p0,-d,w,ctype,k);
+        }
+    }
+
+    vec4 world = uTransform*vec4(pos,uDepth,1.0);
+    gl_Position = uPerspective*world;
+    outPosition = world.xy; // Need untransformed for scissor
+    outTexCoord = (uTexMap*vec3(pos,1.0)).xy;
+}
+
+/////////// SHADER END //////////)"
+
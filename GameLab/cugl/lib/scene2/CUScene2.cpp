@@ -40,12 +40,23 @@
 //  Version: 7/1/16
 
 #include <cugl/scene2/CUScene2.h>
+#include <cugl/base/CUApplication.h>
+#include <cugl/render/CUScissor.h>
+#include <cugl/render/CUGLState.h>
 #include <cugl/util/CUStrings.h>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
 
 using namespace cugl;
 
+/** The padding (in pixels) added to each damaged region for antialiasing */
+#define DAMAGE_PADDING  2
+/** The most separate regions redrawn in a frame before they are merged */
+#define DAMAGE_REGIONS  8
+/** The scissor fringe for damaged regions; tiny so the edges are sharp */
+#define DAMAGE_FRINGE   0.01f
+
 /**
  * Creates a new degenerate Scene on the stack.
  *
@@ -61,7 +72,12 @@ _color(Color4::WHITE),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
 _dstFactor(GL_ONE_MINUS_SRC_ALPHA),
-_active(false)
+_active(false),
+_damageTracking(false),
+_damageOverlay(false),
+_damageFull(true),
+_opaquePass(false),
+_opaqueCount(0)
 {}
 
 /**
@@ -72,10 +88,21 @@ _active(false)
  */
 void Scene2::dispose() {
     removeAllChildren();
+    _cache = nullptr;
     _camera = nullptr;
     _name = "";
     _color = Color4::WHITE;
     _active = false;
+    _frame = nullptr;
+    _damageTracking = false;
+    _damageOverlay = false;
+    _damageFull = true;
+    _damage.clear();
+    _redrawn.clear();
+    _damageCull = Rect::ZERO;
+    _opaquePass = false;
+    _opaqueCount = 0;
+    _drawlist.clear();
 }
 
 /**
@@ -95,7 +122,8 @@ void Scene2::dispose() {
  */
 bool Scene2::init(float x, float y, float width, float height) {
     _camera = OrthographicCamera::allocOffset(x, y, width, height);
-    _active = _camera != nullptr;
+    _cache  = Scene2Cache::alloc();
+    _active = _camera != nullptr && _cache != nullptr;
     return _active;
 }
 
@@ -218,6 +246,28 @@ std::shared_ptr<scene2::SceneNode> Scene2::getChildByName(const std::string name
     return nullptr;
 }
 
+/**
+ * Returns the descendant at the given path.
+ *
+ * A path is a sequence of node names separated by periods, such as
+ * "hud.panel.score".  The first name is a child of this scene, and the
+ * rest of the path is resolved by {@link scene2::SceneNode#getChildByPath}
+ * on that child (which caches the result).  This method returns nullptr
+ * if there is no descendant at the given path.
+ *
+ * @param path  The period-separated path to the descendant
+ *
+ * @return the descendant at the given path.
+ */
+std::shared_ptr<scene2::SceneNode> Scene2::getChildByPath(const std::string& path) const {
+    size_t end = path.find('.');
+    std::shared_ptr<scene2::SceneNode> child = getChildByName(path.substr(0,end));
+    if (child == nullptr || end == std::string::npos) {
+        return child;
+    }
+    return child->getChildByPath(path.substr(end+1));
+}
+
 /**
  * Adds a child to this node with the given z-order.
  *
@@ -398,6 +448,81 @@ void Scene2::sortZOrder() {
     }
 }
 
+#pragma mark -
+#pragma mark Damage Tracking
+/**
+ * Sets whether this scene only redraws its damaged regions.
+ *
+ * When damage tracking is active, the scene keeps the previous frame in
+ * a render target the size of the viewport.  Each {@link render} only
+ * redraws the regions of that frame that were damaged by a change to a
+ * node (its transform, content, or visibility), and then copies the
+ * frame to the screen.  If nothing changed, {@link hasDamage} is false,
+ * and the application may skip the frame entirely with
+ * {@link Application#skipFrame}.
+ *
+ * The damaged regions are redrawn with a scissor, so the result is the
+ * same as a full redraw.  However, nodes must call
+ * {@link scene2::SceneNode#invalidateRenderCache} whenever they change
+ * something that affects their appearance, as with render caching.  A
+ * node that draws outside of its content bounds must also override
+ * {@link scene2::SceneNode#getDrawBounds}.  The copy to the screen
+ * replaces the screen contents, so this mode is intended for a scene
+ * that covers the entire display.
+ *
+ * @param flag  Whether to only redraw the damaged regions of this scene
+ */
+void Scene2::setDamageTracking(bool flag) {
+    _damageTracking = flag;
+    _damageFull = true;
+    _damage.clear();
+    _redrawn.clear();
+    if (!flag) {
+        _frame = nullptr;
+    }
+}
+
+/**
+ * Returns true if the next render would change the frame.
+ *
+ * This is always true if damage tracking is not active.
+ *
+ * @return true if the next render would change the frame.
+ */
+bool Scene2::hasDamage() const {
+    if (!_damageTracking || _damageFull || _frame == nullptr || !_damage.empty()) {
+        return true;
+    } else if (_camera->getCombined() != _damageCamera) {
+        return true;
+    }
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        if ((*it)->_damagePending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Marks the given region (in scene coordinates) as damaged.
+ *
+ * The nodes of a scene report their own damage.  This method is for
+ * changes that the scene graph cannot see, such as a custom shader
+ * uniform.  It does nothing if the rectangle is empty.
+ *
+ * @param rect  The damaged region in scene coordinates
+ */
+void Scene2::addDamage(const Rect rect) {
+    if (!_damageTracking || rect.size.width <= 0 || rect.size.height <= 0) {
+        return;
+    }
+    // A subtree leaving the scene reports every node, so skip the nested ones
+    if (!_damage.empty() && _damage.back().contains(rect)) {
+        return;
+    }
+    _damage.push_back(rect);
+}
+
 #pragma mark -
 #pragma mark Rendering
 /**
@@ -414,13 +539,257 @@ void Scene2::sortZOrder() {
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2::render(const std::shared_ptr<SpriteBatch>& batch) {
+    refreshRenderCache(batch);
+    if (_damageTracking && renderDamage(batch)) {
+        return;
+    }
+    
     batch->begin(_camera->getCombined());
+    renderNodes(batch);
+    batch->end();
+}
+
+/**
+ * Draws the damaged regions of this scene with the given SpriteBatch.
+ *
+ * The damaged regions are redrawn into the saved frame, which is then
+ * copied to the screen.  This method assumes that the sprite batch is
+ * not actively drawing.
+ *
+ * If the saved frame cannot be allocated, this method turns off damage
+ * tracking and returns false, so that the scene falls back to a full
+ * redraw.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ *
+ * @return true if the scene was drawn
+ */
+bool Scene2::renderDamage(const std::shared_ptr<SpriteBatch>& batch) {
+    GLint viewport[4];
+    GLState::getViewport(viewport);
+    int width  = viewport[2];
+    int height = viewport[3];
+    if (_frame == nullptr || _frame->getWidth() != width || _frame->getHeight() != height) {
+        _frame = RenderTarget::alloc(width,height);
+        if (_frame == nullptr) {
+            CULogError("Could not allocate a %dx%d frame for damage tracking",width,height);
+            setDamageTracking(false);
+            return false;
+        }
+        _damageFull = true;
+    }
+    
+    const Mat4& camera = _camera->getCombined();
+    if (camera != _damageCamera) {
+        _damageCamera = camera;
+        _damageFull = true;
+    }
+
+    Mat4 screen = Mat4::createOrthographicOffCenter(0, width, 0, height, -1, 1);
+    Mat4 toPixels = camera * screen.getInverse();
+    Mat4 toScene  = toPixels.getInverse();
+    Rect bounds(0,0,width,height);
+    
+    _redrawn.clear();
+    if (_damageFull) {
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->updateDamageBounds(Mat4::IDENTITY);
+        }
+        _damage.clear();
+        _redrawn.push_back(toScene.transform(bounds));
+    } else {
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->collectDamage(Mat4::IDENTITY, _damage);
+        }
+        
+        // Snap to whole pixels and pad for antialiasing
+        std::vector<Rect> pixels;
+        for(auto it = _damage.begin(); it != _damage.end(); ++it) {
+            Rect rect = toPixels.transform(*it);
+            float left   = std::floor(rect.getMinX())-DAMAGE_PADDING;
+            float bottom = std::floor(rect.getMinY())-DAMAGE_PADDING;
+            float right  = std::ceil(rect.getMaxX())+DAMAGE_PADDING;
+            float top    = std::ceil(rect.getMaxY())+DAMAGE_PADDING;
+            rect.set(left,bottom,right-left,top-bottom);
+            rect.intersect(bounds);
+            if (rect.size.width <= 0 || rect.size.height <= 0) {
+                continue;
+            }
+            
+            // Coalesce with any region it touches, repeating as regions grow
+            bool merged = true;
+            while (merged) {
+                merged = false;
+                for(auto jt = pixels.begin(); jt != pixels.end(); ++jt) {
+                    if (jt->doesIntersect(rect)) {
+                        rect.merge(*jt);
+                        pixels.erase(jt);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+            pixels.push_back(rect);
+        }
+        _damage.clear();
+        
+        if (pixels.size() > DAMAGE_REGIONS) {
+            Rect total = pixels.front();
+            for(auto it = pixels.begin()+1; it != pixels.end(); ++it) {
+                total.merge(*it);
+            }
+            pixels.clear();
+            pixels.push_back(total);
+        }
+        for(auto it = pixels.begin(); it != pixels.end(); ++it) {
+            _redrawn.push_back(toScene.transform(*it));
+        }
+    }
+    
+    Color4 clear = Application::get()->getClearColor();
+    if (!_redrawn.empty()) {
+        _frame->setClearColor(clear);
+        if (_damageFull) {
+            _frame->begin();
+        } else {
+            _frame->resume();
+        }
+        
+        // The frame is not flipped, as that would change the rasterization
+        // of edges on pixel centers.  The copy is flipped instead.
+        batch->begin(camera);
+        for(auto it = _redrawn.begin(); it != _redrawn.end(); ++it) {
+            if (!_damageFull) {
+                batch->setScissor(Scissor::alloc(*it,DAMAGE_FRINGE));
+                batch->setBlendFunc(GL_ONE, GL_ZERO);
+                batch->setBlendEquation(GL_FUNC_ADD);
+                batch->setTexture(nullptr);
+                batch->setColor(clear);
+                batch->fill(*it);
+                _damageCull = *it;
+            }
+            renderNodes(batch);
+        }
+        _damageCull = Rect::ZERO;
+        batch->setScissor(nullptr);
+        batch->end();
+        _frame->end();
+    }
+    
+    // The sprite batch expects textures top down, so flip the quad
+    Mat4 flip = Mat4::IDENTITY;
+    flip.m[5]  = -1;
+    flip.m[13] = (float)height;
+    
+    batch->begin(screen);
+    batch->setBlendFunc(GL_ONE, GL_ZERO);
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->draw(_frame->getTexture(), Color4f::WHITE, bounds, Vec2::ZERO, flip);
+    if (_damageOverlay) {
+        batch->setPerspective(camera);
+        batch->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        batch->setTexture(nullptr);
+        batch->setColor(Color4::RED);
+        for(auto it = _redrawn.begin(); it != _redrawn.end(); ++it) {
+            batch->outline(*it);
+        }
+    }
+    batch->end();
+    
+    _damageFull = false;
+    return true;
+}
+
+/**
+ * Draws the children of this scene with an active SpriteBatch.
+ *
+ * This method sets the blend state of the scene and draws the children,
+ * using an opaque pass if it is enabled.  The sprite batch must already
+ * be drawing with the scene camera.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ */
+void Scene2::renderNodes(const std::shared_ptr<SpriteBatch>& batch) {
     batch->setBlendFunc(_srcFactor, _dstFactor);
     batch->setBlendEquation(_blendEquation);
-
+    
+    // A scissored redraw has soft edges, so nothing is opaque
+    if (!_opaquePass || batch->getScissor() != nullptr) {
+        _opaqueCount = 0;
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, Mat4::IDENTITY, _color);
+        }
+        return;
+    }
+    
+    _drawlist.clear();
     for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->render(batch, Mat4::IDENTITY, _color);
+        (*it)->flatten(Mat4::IDENTITY, _color, _drawlist);
     }
     
-    batch->end();
+    // Later draws are nearer, spaced evenly inside the clip volume.  The
+    // camera is orthographic, so depth only depends on the z coordinate.
+    const Mat4& camera = batch->getPerspective();
+    float zscale = camera.m[10] != 0 ? 1.0f/camera.m[10] : 0.0f;
+    float zstep  = 2.0f/(_drawlist.size()+1);
+    
+    // The depth buffer cannot be cleared mid-batch
+    batch->flush();
+    GLState::depthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    batch->setDepthFunc(GL_LEQUAL);
+    batch->setDepthWrite(true);
+    
+    _opaqueCount = 0;
+    for(size_t ii = _drawlist.size(); ii > 0; ii--) {
+        scene2::SceneNode::DrawItem& item = _drawlist[ii-1];
+        if (item.opaque) {
+            batch->setDepth((1.0f-ii*zstep-camera.m[14])*zscale);
+            item.node->draw(batch, item.matrix, item.color);
+            item.blendEquation = batch->getBlendEquation();
+            item.srcFactor = batch->getSourceBlendFactor();
+            item.dstFactor = batch->getDestinationBlendFactor();
+            _opaqueCount++;
+        }
+    }
+    
+    batch->setDepthWrite(false);
+    batch->setBlendFunc(_srcFactor, _dstFactor);
+    batch->setBlendEquation(_blendEquation);
+    for(size_t ii = 0; ii < _drawlist.size(); ii++) {
+        scene2::SceneNode::DrawItem& item = _drawlist[ii];
+        if (item.opaque) {
+            continue;
+        } else if (ii > 0 && _drawlist[ii-1].opaque) {
+            // Restore the blend state that the skipped node would have left
+            scene2::SceneNode::DrawItem& prev = _drawlist[ii-1];
+            batch->setBlendFunc(prev.srcFactor, prev.dstFactor);
+            batch->setBlendEquation(prev.blendEquation);
+        }
+        batch->setDepth((1.0f-(ii+1)*zstep-camera.m[14])*zscale);
+        if (item.subtree) {
+            item.node->render(batch, item.matrix, item.color);
+        } else {
+            item.node->draw(batch, item.matrix, item.color);
+        }
+    }
+    
+    batch->setDepth(0);
+    batch->setDepthWrite(true);
+    batch->setDepthFunc(GL_ALWAYS);
+}
+
+/**
+ * Redraws any out of date render caches in this scene.
+ *
+ * This method must be called before the sprite batch begins drawing (and
+ * before any render target is active), as render targets do not nest.
+ * It is very cheap if no cached subtree has changed.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ */
+void Scene2::refreshRenderCache(const std::shared_ptr<SpriteBatch>& batch) {
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->refreshRenderCache(batch);
+    }
 }
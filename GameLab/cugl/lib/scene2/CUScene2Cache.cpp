@@ -0,0 +1,227 @@
+//
+//  CUScene2Cache.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a pool of offscreen render targets for caching the
+//  output of scene graph subtrees.  A static but complex subtree (such as an
+//  ornate UI frame or a label with many glyphs) can be rendered once to a
+//  texture and then drawn as a single quad until it changes.  This pool owns
+//  those textures.  It enforces a memory limit, releasing the least recently
+//  drawn caches when the limit is exceeded.
+//
+//  Each Scene2 has its own cache pool.  You should never need to use this
+//  class directly.  Instead, call SceneNode#setRenderCached on the root of
+//  the static subtree.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/8/21
+//
+
+#include <cugl/scene2/CUScene2Cache.h>
+
+using namespace cugl;
+
+#pragma mark Constructors
+
+/**
+ * Disposes all of the resources used by this cache pool.
+ *
+ * A disposed pool can be safely reinitialized.
+ */
+void Scene2Cache::dispose() {
+    clear();
+    _limit = 0;
+}
+
+/**
+ * Initializes a cache pool with the given memory limit.
+ *
+ * @param limit The memory limit in bytes
+ *
+ * @return true if the pool is initialized properly, false otherwise.
+ */
+bool Scene2Cache::init(size_t limit) {
+    _limit = limit;
+    return true;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+
+/**
+ * Releases caches until the memory usage is at most the given amount.
+ *
+ * Spare caches are released first, followed by the least recently drawn
+ * caches in use.
+ *
+ * @param bytes The target memory usage
+ */
+void Scene2Cache::evict(size_t bytes) {
+    while (_usage > bytes && !_spares.empty()) {
+        _usage -= _spares.back().bytes;
+        _spares.pop_back();
+    }
+    while (_usage > bytes && !_entries.empty()) {
+        Entry& entry = _entries.back();
+        _usage -= entry.bytes;
+        _index.erase(entry.node);
+        _entries.pop_back();
+    }
+}
+
+#pragma mark -
+#pragma mark Attributes
+
+/**
+ * Sets the memory limit of this pool in bytes.
+ *
+ * If the current usage exceeds the new limit, the least recently drawn
+ * caches are released immediately.
+ *
+ * @param limit The memory limit in bytes
+ */
+void Scene2Cache::setLimit(size_t limit) {
+    _limit = limit;
+    evict(_limit);
+}
+
+#pragma mark -
+#pragma mark Cache Access
+
+/**
+ * Returns a render target of the given size for the given node.
+ *
+ * If the node already has a cache of this size, it is returned. Otherwise
+ * the node's old cache (if any) becomes a spare, and the node is given a
+ * spare of the right size or a newly allocated one.  The result is the
+ * most recently drawn cache.
+ *
+ * This method returns nullptr if the cache would exceed the memory limit
+ * on its own, or if the render target could not be allocated.
+ *
+ * @param node      The node owning the cache
+ * @param width     The cache width in pixels
+ * @param height    The cache height in pixels
+ *
+ * @return a render target of the given size for the given node.
+ */
+std::shared_ptr<RenderTarget> Scene2Cache::acquire(const scene2::SceneNode* node, Uint32 width, Uint32 height) {
+    auto it = _index.find(node);
+    if (it != _index.end()) {
+        const std::shared_ptr<RenderTarget>& target = it->second->target;
+        if ((Uint32)target->getWidth() == width && (Uint32)target->getHeight() == height) {
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return target;
+        }
+        release(node);
+    }
+    
+    size_t bytes = (size_t)width*height*4;
+    if (width == 0 || height == 0 || bytes > _limit) {
+        return nullptr;
+    }
+    
+    // Look for a spare of the right size
+    Entry entry;
+    entry.node = node;
+    entry.bytes = bytes;
+    for(auto jt = _spares.begin(); jt != _spares.end(); ++jt) {
+        if ((Uint32)jt->target->getWidth() == width && (Uint32)jt->target->getHeight() == height) {
+            entry.target = jt->target;
+            _usage -= jt->bytes;
+            _spares.erase(jt);
+            break;
+        }
+    }
+    
+    if (entry.target == nullptr) {
+        evict(_limit > bytes ? _limit-bytes : 0);
+        entry.target = RenderTarget::alloc(width, height);
+        if (entry.target == nullptr) {
+            return nullptr;
+        }
+        entry.target->setClearColor(Color4::CLEAR);
+    }
+    
+    _usage += bytes;
+    _entries.push_front(entry);
+    _index[node] = _entries.begin();
+    evict(_limit);
+    return entry.target;
+}
+
+/**
+ * Returns the render target for the given node, marking it as drawn.
+ *
+ * This method returns nullptr if the node has no cache, or if its cache
+ * was released to stay under the memory limit.
+ *
+ * @param node  The node owning the cache
+ *
+ * @return the render target for the given node, marking it as drawn.
+ */
+std::shared_ptr<RenderTarget> Scene2Cache::get(const scene2::SceneNode* node) {
+    auto it = _index.find(node);
+    if (it == _index.end()) {
+        return nullptr;
+    }
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->target;
+}
+
+/**
+ * Releases the cache for the given node.
+ *
+ * The cache becomes a spare, and may be reused by another node.
+ *
+ * @param node  The node owning the cache
+ */
+void Scene2Cache::release(const scene2::SceneNode* node) {
+    auto it = _index.find(node);
+    if (it == _index.end()) {
+        return;
+    }
+    it->second->node = nullptr;
+    _spares.splice(_spares.begin(), _entries, it->second);
+    _index.erase(it);
+}
+
+/**
+ * Releases all caches in this pool, including the spares.
+ */
+void Scene2Cache::clear() {
+    _entries.clear();
+    _spares.clear();
+    _index.clear();
+    _usage = 0;
+}
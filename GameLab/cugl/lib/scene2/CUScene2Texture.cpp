@@ -115,15 +115,11 @@ void Scene2Texture::render(const std::shared_ptr<SpriteBatch>& batch) {
     Mat4 matrix = _camera->getCombined();
     matrix.scale(1, -1, 1); // Flip the y axis for texture write
     
+    // Caches must be redrawn first, as render targets do not nest
+    refreshRenderCache(batch);
     _target->begin();
     batch->begin(matrix);
-    batch->setBlendFunc(_srcFactor, _dstFactor);
-    batch->setBlendEquation(_blendEquation);
-
-    for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->render(batch, Mat4::IDENTITY, _color);
-    }
-
+    renderNodes(batch);
     batch->end();
     _target->end();
 }
@@ -46,6 +46,7 @@
 #include <cugl/scene2/graph/CUPathNode.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/render/CUGradient.h>
+#include <cugl/render/CUSpriteBatch.h>
 
 using namespace cugl::scene2;
 
@@ -65,7 +66,8 @@ PathNode::PathNode() : TexturedNode(),
 _stroke(1.0f),
 _closed(true),
 _joint(poly2::Joint::NONE),
-_endcap(poly2::EndCap::NONE) {
+_endcap(poly2::EndCap::NONE),
+_hardware(false) {
     _classname = "PathNode";
 }
 
@@ -94,7 +96,7 @@ bool PathNode::initWithVertices(const std::vector<Vec2>& vertices, float stroke,
                                 poly2::Joint joint, poly2::EndCap cap, bool closed) {
     _joint  = joint;
     _endcap = cap;
-    _closed = true;
+    _closed = closed;
     _stroke = stroke;
     return init(vertices);
 }
@@ -144,6 +146,7 @@ bool PathNode::initWithPoly(const Poly2& poly, float stroke,
  *      'joint':    One of 'mitre', 'bevel', or 'round'.
  *      'cap':      One of 'square' or 'round'.
  *      'closed':   A boolean specifying if the path is closed.
+ *      'hardware': A boolean specifying if the stroke is expanded on the GPU.
  *
  * All attributes are optional.  However, it is generally a good idea to
  * specify EITHER the texture or the polygon.
@@ -204,7 +207,7 @@ bool PathNode::initWithData(const Scene2Loader* loader,
         _joint = poly2::Joint::MITRE;
     } else if (joint == "bevel") {
         _joint = poly2::Joint::SQUARE;
-    } else if (joint == "interior") {
+    } else if (joint == "round" || joint == "interior") {
         _joint = poly2::Joint::ROUND;
     } else {
         _joint = poly2::Joint::NONE;
@@ -218,6 +221,7 @@ bool PathNode::initWithData(const Scene2Loader* loader,
     } else {
         _endcap = poly2::EndCap::NONE;
     }
+    _hardware = data->getBool("hardware",false);
     
     if (data->has("closed")) {
         _closed = data->getBool("closed",false);
@@ -335,6 +339,34 @@ void PathNode::setCap(poly2::EndCap cap) {
     }
 }
 
+/**
+ * Sets whether the stroke is expanded on the GPU.
+ *
+ * By default, a path with a positive stroke is extruded on the CPU with
+ * {@link SimpleExtruder}. This must be redone every time the path, the
+ * stroke width, the joint or the cap changes. A hardware stroke instead
+ * uploads one small record per segment, which is expanded in a shader by
+ * {@link SpriteBatch#stroke}. This is much faster for long or animated
+ * paths, and the result is comparable to the extruded one.
+ *
+ * Hardware strokes do not support gradients. A path with a gradient is
+ * always extruded on the CPU. As there is no extruded polygon, the
+ * extruded bounds are an estimate (exact except for sharp mitre joints).
+ *
+ * @param hardware  Whether the stroke is expanded on the GPU
+ */
+void PathNode::setHardwareStroke(bool hardware) {
+    bool changed = (hardware != _hardware);
+    _hardware = hardware;
+    
+    if (changed && _stroke > 0) {
+        clearRenderData();
+        _extrusion.clear();
+        _segments.clear();
+        updateExtrusion();
+    }
+}
+
 
 #pragma mark -
 #pragma mark Polygons
@@ -428,7 +460,14 @@ void PathNode::setPolygon(const Rect rect) {
  * @param tint      The tint to blend with the Node color.
  */
 void PathNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) {
-    if (!_rendered) {
+    if (_hardware && _stroke > 0 && _gradient == nullptr) {
+        batch->setColor(tint);
+        batch->setTexture(_texture);
+        batch->setBlendEquation(_blendEquation);
+        batch->setBlendFunc(_srcFactor, _dstFactor);
+        drawHardwareStroke(batch, transform);
+        return;
+    } else if (!_rendered) {
         generateRenderData();
     }
     
@@ -499,6 +538,34 @@ void PathNode::generateRenderData() {
     _rendered = true;
 }
 
+/**
+ * Returns the region (in node space) that {@link draw} may touch.
+ *
+ * A path with a positive stroke draws its extruded path, which reaches
+ * past the content bounds.
+ *
+ * @return the region (in node space) that {@link draw} may touch.
+ */
+cugl::Rect PathNode::getDrawBounds() const {
+    if (_stroke <= 0) {
+        return TexturedNode::getDrawBounds();
+    }
+    
+    // The same shift and scale as generateRenderData
+    Rect bounds = _extrbounds;
+    if (_absolute) {
+        bounds.origin += _polygon.getBounds().origin;
+    }
+    Size nsize = getContentSize();
+    Size bsize = _polygon.getBounds().size;
+    if (nsize != bsize) {
+        float sx = (bsize.width > 0 ? nsize.width/bsize.width : 0);
+        float sy = (bsize.height > 0 ? nsize.height/bsize.height : 0);
+        bounds.set(bounds.origin.x*sx, bounds.origin.y*sy, bounds.size.width*sx, bounds.size.height*sy);
+    }
+    return bounds;
+}
+
 #pragma mark -
 #pragma mark Internal Methods
 /**
@@ -506,7 +573,16 @@ void PathNode::generateRenderData() {
  */
 void PathNode::updateExtrusion() {
     clearRenderData();
-    if (_stroke > 0) {
+    if (_stroke > 0 && _hardware) {
+        _segments.clear();
+        if (_polygon.getGeometry() == Geometry::IMPLICIT) {
+            SpriteBatch::makeStroke(_polygon.vertices(),_closed,_stroke,_joint,_endcap,_segments);
+        } else {
+            SpriteBatch::makeStroke(_polygon,_stroke,_joint,_endcap,_segments);
+        }
+        _extrbounds = SpriteBatch::getStrokeBounds(_segments);
+        _extrbounds.origin -= _polygon.getBounds().origin;
+    } else if (_stroke > 0) {
         SimpleExtruder extruder;
         if (_polygon.getGeometry() == Geometry::IMPLICIT) {
             extruder.set(_polygon.vertices(),_closed);
@@ -524,6 +600,50 @@ void PathNode::updateExtrusion() {
     }
 }
 
+/**
+ * Draws the hardware stroke of this node via the given SpriteBatch.
+ *
+ * This method computes the texture coordinate map on the fly, so that
+ * it agrees with the one from {@link #generateRenderData}.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ */
+void PathNode::drawHardwareStroke(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform) {
+    if (_texture == nullptr || _segments.empty()) {
+        return;
+    }
+    
+    Size nsize = getContentSize();
+    Size bsize = _polygon.getBounds().size;
+    Size tsize = _texture->getSize();
+    Vec2 scale = Vec2::ONE;
+    if (nsize != bsize) {
+        scale.x = (bsize.width > 0 ? nsize.width/bsize.width : 0);
+        scale.y = (bsize.height > 0 ? nsize.height/bsize.height : 0);
+    }
+    Vec2 offset = _absolute ? Vec2::ZERO : _polygon.getBounds().origin*scale;
+    
+    // The same shift as generateRenderData, but on the GPU
+    Mat4 matrix;
+    matrix.scale(scale.x, scale.y, 1);
+    matrix.translate(-offset.x, -offset.y, 0);
+    matrix *= transform;
+    
+    // Texture coordinates are linear in each axis
+    float sa = scale.x/tsize.width;
+    float sb = -offset.x/tsize.width;
+    float ta = scale.y/tsize.height;
+    float tb = -offset.y/tsize.height;
+    if (_flipHorizontal) { sa = -sa; sb = 1-sb; }
+    if (!_flipVertical)  { ta = -ta; tb = 1-tb; }
+    float sd = _texture->getMaxS()-_texture->getMinS();
+    float td = _texture->getMaxT()-_texture->getMinT();
+    Affine2 texmap(sa*sd, 0, 0, ta*td, _texture->getMinS()+sb*sd, _texture->getMinT()+tb*td);
+    
+    batch->stroke(_segments, matrix, texmap);
+}
+
 /**
  * Normalizes the source so that it is a closed curve with no gaps
  */
@@ -137,6 +137,26 @@ void PolygonNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& tr
     batch->setGradient(nullptr);
 }
 
+/**
+ * Returns true if {@link draw} covers every pixel it touches at full alpha.
+ *
+ * A polygon is opaque if its texture is opaque (or it has no texture),
+ * it has no gradient, and its blend function ignores the destination
+ * at full alpha.  The polygon tint is checked separately.
+ *
+ * @return true if {@link draw} covers every pixel it touches at full alpha.
+ */
+bool PolygonNode::isOpaque() const {
+    if (_gradient != nullptr || (_texture != nullptr && !_texture->isOpaque())) {
+        return false;
+    } else if (_blendEquation != GL_FUNC_ADD) {
+        return false;
+    } else if (_srcFactor != GL_SRC_ALPHA && _srcFactor != GL_ONE) {
+        return false;
+    }
+    return _dstFactor == GL_ONE_MINUS_SRC_ALPHA || _dstFactor == GL_ZERO;
+}
+
 /** A triangulator for those incomplete polygons */
 cugl::SimpleTriangulator PolygonNode::_triangulator;
 
@@ -56,21 +56,27 @@ using namespace cugl::scene2;
  * heap, use one of the static constructors instead.
  */
 SceneNode::SceneNode() :
-_tag(0),
-_name(""),
-_hashOfName(0),
+_anchor(Vec2::ANCHOR_BOTTOM_LEFT),
 _tintColor(Color4::WHITE),
 _hasParentColor(true),
 _isVisible(true),
-_anchor(Vec2::ANCHOR_BOTTOM_LEFT),
 _scale(Vec2::ONE),
 _angle(0),
 _useTransform(false),
 _parent(nullptr),
 _graph(nullptr),
+_childOffset(-2),
+_tag(0),
+_name(""),
+_hashOfName(0),
+_childIndexed(false),
 _zOrder(0),
 _zDirty(false),
-_childOffset(-2) {}
+_cacheEnabled(false),
+_cacheDirty(false),
+_cachePending(false),
+_damaged(false),
+_damagePending(false) {}
 
 /**
  * Initializes a node at the given position.
@@ -201,6 +207,8 @@ bool SceneNode::initWithData(const Scene2Loader* loader, const std::shared_ptr<J
     }
     
     _isVisible = data->getBool("visible",true);
+    _cacheEnabled = data->getBool("cached",false);
+    _cacheDirty = _cacheEnabled;
 
     bool transform = false;
     if (data->has("size")) {
@@ -250,6 +258,15 @@ void SceneNode::dispose() {
         removeFromParent();
     }
     removeAllChildren();
+    if (_cacheEnabled && _graph != nullptr && _graph->_cache) {
+        _graph->_cache->release(this);
+    }
+    _cacheEnabled = false;
+    _cacheDirty = false;
+    _cachePending = false;
+    _damaged = false;
+    _damagePending = false;
+    _damageBounds = Rect::ZERO;
     _position = Vec2::ZERO;
     _anchor   = Vec2::ANCHOR_CENTER;
     _contentSize = Size::ZERO;
@@ -267,6 +284,10 @@ void SceneNode::dispose() {
     _tag = 0;
     _name = "";
     _hashOfName = 0;
+    _childIndexed = false;
+    _nameIndex.clear();
+    _tagIndex.clear();
+    _pathCache.clear();
     _zOrder = 0;
     _zDirty = false;
     _json = nullptr;
@@ -295,15 +316,65 @@ SceneNode* SceneNode::copy(SceneNode* dst) {
     dst->_transform = _transform;
     dst->_useTransform = _useTransform;
     dst->_combined = _combined;
-    dst->_tag = _tag;
-    dst->_name = _name;
-    dst->_hashOfName = _hashOfName;
+    dst->setTag(_tag);
+    dst->setName(_name);
+    dst->setChildIndexed(_childIndexed);
     dst->_zOrder = _zOrder;
     dst->_zDirty = _zDirty;
     dst->_json = _json;
+    dst->setRenderCached(_cacheEnabled);
     return dst;
 }
 
+#pragma mark -
+#pragma mark Identifiers
+/**
+ * Sets a tag that is used to identify the node easily.
+ *
+ * This tag is used to quickly access a child node, since child position
+ * may change. To work properly, a tag should be unique within a scene
+ * graph.  It is 0 if undefined.
+ *
+ * If the parent of this node indexes its children, the index is updated.
+ *
+ * @param tag   A tag that is used to identify the node easily.
+ */
+void SceneNode::setTag(unsigned int tag) {
+    if (_parent != nullptr && _parent->_childIndexed) {
+        _parent->unindexChild(this);
+        _tag = tag;
+        _parent->indexChild(this);
+    } else {
+        _tag = tag;
+    }
+}
+
+/**
+ * Sets a string that is used to identify the node.
+ *
+ * This name is used to access a child node, since child position may
+ * change. In addition, the name is useful for debugging. To work properly,
+ * a name should be unique within a scene graph. It is empty if undefined.
+ *
+ * If the parent of this node indexes its children, the index is updated.
+ * Any cached paths through this node are invalidated.
+ *
+ * @param name  A string that is used to identify the node.
+ */
+void SceneNode::setName(const std::string& name) {
+    if (_parent != nullptr && _parent->_childIndexed) {
+        _parent->unindexChild(this);
+        _name = name;
+        _parent->indexChild(this);
+    } else {
+        _name = name;
+    }
+    _hashOfName = std::hash<std::string>()(_name);
+    if (_parent != nullptr) {
+        _parent->invalidatePathCache();
+    }
+}
+
 #pragma mark -
 #pragma mark Attributes
 
@@ -322,6 +393,7 @@ void SceneNode::setPosition(float x, float y) {
     _combined.m[12] += (x-_position.x);
     _combined.m[13] += (y-_position.y);
     _position.set(x,y);
+    invalidatePlacement();
 }
 
 /**
@@ -344,6 +416,7 @@ void SceneNode::setContentSize(const Size size) {
     if (_layout) {
         doLayout();
     }
+    invalidateRenderCache();
 }
 
 /**
@@ -497,6 +570,7 @@ void SceneNode::updateTransform() {
     }
     _combined.m[12] += _position.x-offset.x;
     _combined.m[13] += _position.y-offset.y;
+    invalidatePlacement();
 }
 
 
@@ -548,6 +622,17 @@ const std::shared_ptr<SceneNode>& SceneNode::getChild(unsigned int pos) const {
  * @return the (first) child with the given tag.
  */
 std::shared_ptr<SceneNode> SceneNode::getChildByTag(unsigned int tag) const {
+    if (_childIndexed) {
+        // Respect child order if the tag is not unique
+        int offset = -1;
+        auto range = _tagIndex.equal_range(tag);
+        for(auto it = range.first; it != range.second; ++it) {
+            if (offset == -1 || it->second->_childOffset < offset) {
+                offset = it->second->_childOffset;
+            }
+        }
+        return offset == -1 ? nullptr : _children[offset];
+    }
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         if ((*it)->getTag() == tag) {
             return *it;
@@ -570,6 +655,17 @@ std::shared_ptr<SceneNode> SceneNode::getChildByTag(unsigned int tag) const {
  * @return the (first) child with the given name.
  */
 std::shared_ptr<SceneNode> SceneNode::getChildByName(const std::string name) const {
+    if (_childIndexed) {
+        // Respect child order if the name is not unique
+        int offset = -1;
+        auto range = _nameIndex.equal_range(name);
+        for(auto it = range.first; it != range.second; ++it) {
+            if (offset == -1 || it->second->_childOffset < offset) {
+                offset = it->second->_childOffset;
+            }
+        }
+        return offset == -1 ? nullptr : _children[offset];
+    }
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         if ((*it)->getName() == name) {
             return *it;
@@ -578,6 +674,89 @@ std::shared_ptr<SceneNode> SceneNode::getChildByName(const std::string name) con
     return nullptr;
 }
 
+/**
+ * Returns the descendant at the given path.
+ *
+ * A path is a sequence of node names separated by periods, such as
+ * "hud.panel.score".  The first name is a child of this node, the second
+ * name is a child of that node, and so on.  If any name along the path is
+ * shared by more than one sibling, this method follows the first one (as
+ * in {@link getChildByName}).  Hence names containing a period cannot be
+ * reached by this method.
+ *
+ * Resolved paths are cached, so repeated look-ups are a single hash.  The
+ * cache is invalidated whenever a child is added, removed, or renamed
+ * anywhere below this node.  This method returns nullptr if there is no
+ * descendant at the given path, or if the path has an empty name (such as
+ * "hud." or "hud..score").
+ *
+ * @param path  The period-separated path to the descendant
+ *
+ * @return the descendant at the given path.
+ */
+std::shared_ptr<SceneNode> SceneNode::getChildByPath(const std::string& path) const {
+    if (path.empty()) {
+        return nullptr;
+    }
+    auto cached = _pathCache.find(path);
+    if (cached != _pathCache.end()) {
+        return cached->second;
+    }
+    
+    const SceneNode* node = this;
+    std::shared_ptr<SceneNode> result = nullptr;
+    size_t start = 0;
+    while (node != nullptr && start <= path.size()) {
+        size_t end = path.find('.',start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (end == start) {
+            // Unnamed nodes cannot be reached through a path
+            return nullptr;
+        }
+        result = node->getChildByName(path.substr(start,end-start));
+        node = result.get();
+        start = end+1;
+    }
+    
+    // Only successful look-ups are cached
+    if (result != nullptr) {
+        _pathCache[path] = result;
+    }
+    return result;
+}
+
+/**
+ * Sets whether this node indexes its children by name and tag.
+ *
+ * By default, {@link getChildByName} and {@link getChildByTag} are a
+ * linear search of the children.  That is fine for most nodes, but it is
+ * slow for wide nodes (such as a list with hundreds of entries) that are
+ * searched every frame.  An indexed node keeps a hash table of its
+ * children instead, making these look-ups constant time.
+ *
+ * The index is maintained by all of the methods that add or remove
+ * children, and by {@link setName} and {@link setTag} on the children.
+ *
+ * @param flag  Whether this node indexes its children by name and tag.
+ */
+void SceneNode::setChildIndexed(bool flag) {
+    if (_childIndexed == flag) {
+        return;
+    }
+    _nameIndex.clear();
+    _tagIndex.clear();
+    _childIndexed = flag;
+    if (flag) {
+        _nameIndex.reserve(_children.size());
+        _tagIndex.reserve(_children.size());
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            indexChild(it->get());
+        }
+    }
+}
+
 /**
  * Adds a child to this node with the given z-order.
  *
@@ -610,7 +789,10 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child, int zval) {
     _children.push_back(child);
     child->setParent(this);
     child->pushScene(_graph);
-    
+    indexChild(child.get());
+    invalidatePathCache();
+    _cachePending = _cachePending || child->_cachePending;
+    markPending();
 }
 
 /**
@@ -628,12 +810,15 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child, int zval) {
  */
 void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
                           const std::shared_ptr<SceneNode>& child2, bool inherit) {
+    unindexChild(child1.get());
     _children[child1->_childOffset] = child2;
     child2->_childOffset = child1->_childOffset;
     child2->setParent(this);
     child1->setParent(nullptr);
     child2->pushScene(_graph);
     child1->pushScene(nullptr);
+    indexChild(child2.get());
+    invalidatePathCache();
     
     // Check if we are dirty and/or inherit children
     bool childdirty = false;
@@ -646,6 +831,8 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
         childdirty = child2->isZDirty();
     }
     setZDirty(_zDirty || child1->_zOrder != child2->_zOrder || childdirty);
+    _cachePending = _cachePending || child2->_cachePending;
+    markPending();
 }
 
 /**
@@ -659,6 +846,7 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
 void SceneNode::removeChild(unsigned int pos) {
     CUAssertLog(pos < _children.size(), "Position index out of bounds");
     std::shared_ptr<SceneNode> child = _children[pos];
+    unindexChild(child.get());
     child->setParent(nullptr);
     child->pushScene(nullptr);
     child->_childOffset = -1;
@@ -667,6 +855,8 @@ void SceneNode::removeChild(unsigned int pos) {
         _children[ii]->_childOffset = ii;
     }
     _children.resize(_children.size()-1);
+    invalidatePathCache();
+    markPending();
 }
 
 /**
@@ -730,7 +920,11 @@ void SceneNode::removeAllChildren() {
         (*it)->pushScene(nullptr);
     }
     _children.clear();
+    _nameIndex.clear();
+    _tagIndex.clear();
     _zDirty = false;
+    invalidatePathCache();
+    markPending();
 }
 
 /**
@@ -742,9 +936,78 @@ void SceneNode::removeAllChildren() {
  * @param parent    A pointer to the scene graph.
  */
 void SceneNode::pushScene(Scene2* scene) {
+    if (_graph != scene) {
+        if (_cacheEnabled && _graph != nullptr && _graph->_cache) {
+            _graph->_cache->release(this);
+        }
+        _cacheDirty = _cacheEnabled;
+        _cachePending = _cacheEnabled;
+        
+        // Leaving a scene damages where we were; entering damages where we are
+        if (_graph != nullptr) {
+            _graph->addDamage(_damageBounds);
+        }
+        _damageBounds = Rect::ZERO;
+        _damaged = scene != nullptr;
+        _damagePending = _damaged;
+    }
     setScene(scene);
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->pushScene(scene);
+        _cachePending = _cachePending || (*it)->_cachePending;
+    }
+}
+
+/**
+ * Adds the given child to the name and tag indices of this node.
+ *
+ * This method does nothing if this node does not index its children.
+ *
+ * @param child The child to index
+ */
+void SceneNode::indexChild(SceneNode* child) {
+    if (_childIndexed) {
+        _nameIndex.emplace(child->_name,child);
+        _tagIndex.emplace(child->_tag,child);
+    }
+}
+
+/**
+ * Removes the given child from the name and tag indices of this node.
+ *
+ * This method does nothing if this node does not index its children.
+ *
+ * @param child The child to remove from the index
+ */
+void SceneNode::unindexChild(SceneNode* child) {
+    if (!_childIndexed) {
+        return;
+    }
+    auto names = _nameIndex.equal_range(child->_name);
+    for(auto it = names.first; it != names.second; ++it) {
+        if (it->second == child) {
+            _nameIndex.erase(it);
+            break;
+        }
+    }
+    auto tags = _tagIndex.equal_range(child->_tag);
+    for(auto it = tags.first; it != tags.second; ++it) {
+        if (it->second == child) {
+            _tagIndex.erase(it);
+            break;
+        }
+    }
+}
+
+/**
+ * Clears the path cache of this node and all of its ancestors.
+ *
+ * This method should be called whenever the structure of the scene graph
+ * changes below this node, as any cached path could now be stale.
+ */
+void SceneNode::invalidatePathCache() {
+    for(SceneNode* node = this; node != nullptr; node = node->_parent) {
+        node->_pathCache.clear();
     }
 }
 
@@ -782,6 +1045,7 @@ void SceneNode::doLayout() {
  */
 void SceneNode::setZOrder(int z) {
     _zOrder = z;
+    invalidatePlacement();
     
     // Notify the parent if we have a problem.
     if (_parent != nullptr && !_parent->_zDirty) {
@@ -875,6 +1139,331 @@ void SceneNode::sortZOrder() {
     }
 }
 
+#pragma mark -
+#pragma mark Render Caching
+
+/**
+ * Sets whether this subtree is rendered to a cached texture.
+ *
+ * A cached subtree is rendered once to an offscreen texture, and is then
+ * drawn as a single quad.  It is only rendered again when this node or one
+ * of its descendants changes its transform, color, visibility, children,
+ * or content.  This is ideal for static but complex subtrees, such as
+ * ornate UI frames or labels with many glyphs.  It is a poor choice for
+ * subtrees that animate every frame.
+ *
+ * The cache is rendered in node space at one pixel per unit, so it should
+ * not be used for nodes that are scaled up significantly on screen. In
+ * addition, the cache is composited as a premultiplied image, so
+ * overlapping translucent children may blend slightly differently.
+ *
+ * Caches are only used for nodes in a {@link Scene2}, which owns the
+ * textures. The scene releases the least recently drawn caches when its
+ * memory limit is exceeded (see {@link Scene2#setRenderCacheLimit}).
+ *
+ * @param flag  whether this subtree is rendered to a cached texture.
+ */
+void SceneNode::setRenderCached(bool flag) {
+    if (_cacheEnabled == flag) {
+        return;
+    }
+    if (!flag && _graph != nullptr && _graph->_cache) {
+        _graph->_cache->release(this);
+    }
+    _cacheEnabled = flag;
+    _cacheDirty = flag;
+    invalidateRenderCache();
+}
+
+/**
+ * Marks the render cache of this node and its ancestors as out of date.
+ *
+ * This method also marks this subtree as damaged, so that a scene that
+ * tracks damage (see {@link Scene2#setDamageTracking}) redraws it.
+ *
+ * All of the built-in nodes call this method whenever their content
+ * changes.  A custom node should call this method whenever it changes
+ * something that affects {@link draw}.  It is safe to call this method
+ * if there is no cache; it is very cheap.
+ */
+void SceneNode::invalidateRenderCache() {
+    _damaged = true;
+    markPending();
+}
+
+/**
+ * Marks the render caches of this node and its ancestors as out of date.
+ *
+ * Unlike {@link invalidateRenderCache}, this method does not damage this
+ * node. It only marks the path to the root as having a damaged descendant.
+ * It is used when a child is added or removed, as the child tracks its
+ * own damage.
+ */
+void SceneNode::markPending() {
+    bool below = _cachePending;
+    for(SceneNode* node = this; node != nullptr; node = node->_parent) {
+        if (node->_cacheEnabled) {
+            node->_cacheDirty = true;
+            below = true;
+        }
+        node->_cachePending = node->_cachePending || below;
+        node->_damagePending = true;
+    }
+}
+
+/**
+ * Marks this subtree as damaged after a change to its placement.
+ *
+ * A change to the transform or z-order of a node damages the node, but
+ * not its parent.  However, it does invalidate the render cache of the
+ * parent, as that cache is in the coordinate space of the parent.
+ */
+void SceneNode::invalidatePlacement() {
+    _damaged = true;
+    _damagePending = true;
+    if (_parent != nullptr) {
+        _parent->markPending();
+    }
+}
+
+/**
+ * Returns the drawn bounds of a node under the given transform.
+ *
+ * A node with degenerate bounds has empty bounds, so that a grouping node
+ * does not stretch the bounds of its subtree to its origin.
+ *
+ * @param matrix    The transform of the node
+ *
+ * @return the drawn bounds of a node under the given transform.
+ */
+Rect SceneNode::getContentBounds(const Mat4& matrix) const {
+    Rect bounds = getDrawBounds();
+    if (bounds.size.width <= 0 || bounds.size.height <= 0) {
+        return Rect::ZERO;
+    }
+    return matrix.transform(bounds);
+}
+
+/**
+ * Merges the given bounds into the accumulated bounds.
+ *
+ * Empty rectangles are ignored, rather than stretching the bounds to
+ * their origin.
+ *
+ * @param bounds    The accumulated bounds
+ * @param rect      The bounds to merge
+ */
+void SceneNode::mergeBounds(Rect& bounds, const Rect& rect) {
+    if (rect.size.width <= 0 || rect.size.height <= 0) {
+        return;
+    } else if (bounds.size.width <= 0 || bounds.size.height <= 0) {
+        bounds = rect;
+    } else {
+        bounds.merge(rect);
+    }
+}
+
+/**
+ * Adds the damaged regions of this subtree to the given list.
+ *
+ * A damaged subtree contributes both its bounds as of the last damaged
+ * frame and its current bounds.  This method only visits the nodes that
+ * have pending damage, and so is very cheap when nothing has changed.
+ *
+ * @param transform The transform of the parent of this node.
+ * @param damage    The list to store the damaged regions.
+ */
+void SceneNode::collectDamage(const Mat4& transform, std::vector<Rect>& damage) {
+    if (!_damagePending) {
+        return;
+    }
+    
+    if (_damaged) {
+        Rect previous = _damageBounds;
+        Rect current  = updateDamageBounds(transform);
+        if (previous.size.width > 0 && previous.size.height > 0) {
+            damage.push_back(previous);
+        }
+        if (current.size.width > 0 && current.size.height > 0) {
+            damage.push_back(current);
+        }
+        return;
+    }
+    
+    // Only descendants changed, but our recorded bounds must stay current
+    _damagePending = false;
+    Mat4 matrix;
+    Mat4::multiply(_combined,transform,&matrix);
+    Rect bounds = getContentBounds(matrix);
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->collectDamage(matrix, damage);
+        if (!_scissor) {
+            mergeBounds(bounds,(*it)->_damageBounds);
+        }
+    }
+    _damageBounds = _isVisible ? bounds : Rect::ZERO;
+}
+
+/**
+ * Returns the scene bounds of this subtree, recording it for all nodes.
+ *
+ * This method clears the damage of the entire subtree.  The bounds of a
+ * hidden node are empty.
+ *
+ * @param transform The transform of the parent of this node.
+ *
+ * @return the scene bounds of this subtree.
+ */
+Rect SceneNode::updateDamageBounds(const Mat4& transform) {
+    _damaged = false;
+    _damagePending = false;
+
+    Mat4 matrix;
+    Mat4::multiply(_combined,transform,&matrix);
+    Rect bounds = getContentBounds(matrix);
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        Rect child = (*it)->updateDamageBounds(matrix);
+        if (!_scissor) {
+            mergeBounds(bounds,child);
+        }
+    }
+    _damageBounds = _isVisible ? bounds : Rect::ZERO;
+    return _damageBounds;
+}
+
+/**
+ * Returns the bounding box of this subtree in node space.
+ *
+ * This box includes the drawn bounds of this node and every visible
+ * descendant.  If this node has a scissor, it is limited to the content
+ * bounds of this node.
+ *
+ * @return the bounding box of this subtree in node space.
+ */
+Rect SceneNode::getSubtreeBounds() const {
+    if (_scissor) {
+        return Rect(Vec2::ZERO, getContentSize());
+    }
+    Rect result = getDrawBounds();
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        if ((*it)->isVisible()) {
+            result.merge((*it)->getNodeToParentTransform().transform((*it)->getSubtreeBounds()));
+        }
+    }
+    return result;
+}
+
+/**
+ * Redraws any out of date render caches in this subtree.
+ *
+ * This method is called by {@link Scene2} before it begins drawing. It
+ * only visits the nodes that have a pending cache, and so is very cheap
+ * when nothing has changed.  The sprite batch must not be drawing.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ */
+void SceneNode::refreshRenderCache(const std::shared_ptr<SpriteBatch>& batch) {
+    // Hidden subtrees keep their pending flag until they are shown again
+    if (!_cachePending || !_isVisible) {
+        return;
+    }
+    
+    // Nested caches must be current before we draw them
+    _cachePending = false;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->refreshRenderCache(batch);
+    }
+    if (!_cacheEnabled || !_cacheDirty || _graph == nullptr || !_graph->_cache) {
+        return;
+    }
+    
+    // Snap the cache to whole pixels
+    _cacheDirty = false;
+    Rect bounds = getSubtreeBounds();
+    float right = ceilf(bounds.getMaxX());
+    float top   = ceilf(bounds.getMaxY());
+    bounds.origin.x = floorf(bounds.getMinX());
+    bounds.origin.y = floorf(bounds.getMinY());
+    bounds.size.width  = right-bounds.origin.x;
+    bounds.size.height = top-bounds.origin.y;
+    _cacheBounds = bounds;
+    
+    std::shared_ptr<RenderTarget> target;
+    target = _graph->_cache->acquire(this, (Uint32)bounds.size.width,
+                                                     (Uint32)bounds.size.height);
+    if (target == nullptr) {
+        return;
+    }
+    
+    Mat4 matrix = Mat4::createOrthographicOffCenter(bounds.getMinX(), bounds.getMaxX(),
+                                                    bounds.getMinY(), bounds.getMaxY(),
+                                                    -1, 1);
+    
+    // The cache is not flipped, as that would change the rasterization of
+    // edges on pixel centers.  The quad is flipped when drawn instead.
+    target->begin();
+    batch->begin(matrix);
+    batch->setBlendFunc(_graph->_srcFactor, _graph->_dstFactor);
+    batch->setBlendEquation(_graph->_blendEquation);
+    batch->setScissor(nullptr);
+    batch->setAlphaCoverage(true);  // Keep the cache premultiplied
+    renderSubtree(batch, Mat4::IDENTITY, _tintColor);
+    batch->setAlphaCoverage(false);
+    batch->end();
+    target->end();
+}
+
+/**
+ * Returns true if this node was drawn from its render cache.
+ *
+ * If the cache is out of date, or was released by the scene, this method
+ * does nothing and returns false.  The node should then be rendered
+ * normally.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param matrix    The transform of this node.
+ * @param tint      The tint of the parent of this node.
+ *
+ * @return true if this node was drawn from its render cache.
+ */
+bool SceneNode::drawRenderCache(const std::shared_ptr<SpriteBatch>& batch, const Mat4& matrix, Color4 tint) {
+    if (_cacheDirty || _graph == nullptr || !_graph->_cache) {
+        return false;
+    }
+    
+    Scene2Cache* pool = _graph->_cache.get();
+    std::shared_ptr<RenderTarget> target = pool->get(this);
+    if (target == nullptr) {
+        // Request a new cache, unless this one can never fit
+        size_t bytes = (size_t)(_cacheBounds.size.width*_cacheBounds.size.height*4);
+        if (bytes > 0 && bytes <= pool->getLimit()) {
+            invalidateRenderCache();
+        }
+        return false;
+    }
+
+    // The cache has premultiplied alpha
+    Color4f color(tint);
+    color.r *= color.a;
+    color.g *= color.a;
+    color.b *= color.a;
+    
+    // The sprite batch expects textures top down, so flip the quad
+    Mat4 flip = Mat4::IDENTITY;
+    flip.m[5]  = -1;
+    flip.m[13] = _cacheBounds.getMinY()+_cacheBounds.getMaxY();
+    Mat4::multiply(flip,matrix,&flip);
+    
+    GLenum srcFactor = batch->getSourceBlendFactor();
+    GLenum dstFactor = batch->getDestinationBlendFactor();
+    batch->setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    batch->draw(target->getTexture(), color, Rect(Vec2::ZERO,_cacheBounds.size),
+                -_cacheBounds.origin, flip);
+    batch->setBlendFunc(srcFactor, dstFactor);
+    return true;
+}
+
+
 #pragma mark -
 #pragma mark Rendering
 
@@ -895,13 +1484,37 @@ void SceneNode::sortZOrder() {
 void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) {
     if (!_isVisible) { return; }
     
+    // A damaged redraw skips the subtrees the scissor would discard
+    if (_graph != nullptr && _graph->_damageCull.size.width > 0 &&
+        !_graph->_damageCull.doesIntersect(_damageBounds)) {
+        return;
+    }
+    
     Mat4 matrix;
     Mat4::multiply(_combined,transform,&matrix);
+    if (_cacheEnabled && drawRenderCache(batch, matrix, _hasParentColor ? tint : Color4::WHITE)) {
+        return;
+    }
+    
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
     }
-    
+    renderSubtree(batch, matrix, color);
+}
+
+/**
+ * Draws this Node and all of its children, ignoring any render cache.
+ *
+ * Unlike {@link render}, the transform and tint are those of this node,
+ * and not its parent.  This method is used both by render and to redraw
+ * the render cache.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param matrix    The transform of this node.
+ * @param color     The color of this node.
+ */
+void SceneNode::renderSubtree(const std::shared_ptr<SpriteBatch>& batch, const Mat4& matrix, Color4 color) {
     std::shared_ptr<Scissor> active = batch->getScissor();
     if (_scissor) {
         std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
@@ -922,6 +1535,47 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Mat4& tr
     }
 }
 
+/**
+ * Appends the draws of this subtree to the given list.
+ *
+ * The draws are in the order that {@link render} would make them. A
+ * subtree with a render cache or a scissor is added as a single item,
+ * and is never opaque, as both have soft edges.
+ *
+ * @param transform The transform of the parent of this node.
+ * @param tint      The tint of the parent of this node.
+ * @param items     The list to store the draws.
+ */
+void SceneNode::flatten(const Mat4& transform, Color4 tint, std::vector<DrawItem>& items) {
+    if (!_isVisible) { return; }
+    
+    items.emplace_back();
+    DrawItem& item = items.back();
+    item.node = this;
+    item.opaque = false;
+    if (_cacheEnabled || _scissor) {
+        item.matrix = transform;
+        item.color = tint;
+        item.subtree = true;
+        return;
+    }
+    
+    Mat4::multiply(_combined,transform,&item.matrix);
+    item.color = _tintColor;
+    if (_hasParentColor) {
+        item.color *= tint;
+    }
+    item.subtree = false;
+    item.opaque  = item.color.a == 255 && isOpaque();
+    
+    // The item reference is not stable as the list grows
+    Mat4 matrix = item.matrix;
+    Color4 color = item.color;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->flatten(matrix, color, items);
+    }
+}
+
 /**
  * Returns the absolute color tinting this node.
  *
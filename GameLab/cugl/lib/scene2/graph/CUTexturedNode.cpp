@@ -386,6 +386,7 @@ void TexturedNode::shiftPolygon(float dx, float dy) {
         it->texcoord.x += dx/w;
         it->texcoord.y -= dy/h;
     }
+    invalidateRenderCache();
 }
 
 /**
@@ -504,7 +505,7 @@ void TexturedNode::generateRenderData() {
 void TexturedNode::clearRenderData() {
     _mesh.clear();
     _rendered = false;
-    
+    invalidateRenderCache();
 }
 
 /**
@@ -515,6 +516,7 @@ void TexturedNode::clearRenderData() {
  * of the texture.
  */
 void TexturedNode::updateTextureCoords() {
+    invalidateRenderCache();
     if (!_rendered) {
         return;
     }
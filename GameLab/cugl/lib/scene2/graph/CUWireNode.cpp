@@ -44,6 +44,7 @@
 #include <cugl/assets/CUScene2Loader.h>
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/render/CUGradient.h>
+#include <cugl/render/CUSpriteBatch.h>
 
 using namespace cugl;
 using namespace cugl::scene2;
@@ -112,6 +113,9 @@ bool WireNode::initWithTraversal(const std::vector<Vec2>& vertices, poly2::Trave
  *      "traveral": One of 'open', 'closed', or 'interior'
  *      "indices":  An array of unsigned ints defining triangles from the
  *                  the vertices. The array size should be a multiple of 3.
+ *      'stroke':   A number specifying the stroke width (0 for lines).
+ *      'joint':    One of 'mitre', 'bevel', or 'round'.
+ *      'cap':      One of 'square' or 'round'.
  *
  * All attributes are optional.  However, it is generally a good idea to
  * specify EITHER the texture or the polygon.  If you specify the indices,
@@ -179,6 +183,27 @@ bool WireNode::initWithData(const Scene2Loader* loader, const std::shared_ptr<Js
     }
     setTraversal(plan);
     
+    _stroke = data->getFloat("stroke", 0.0f);
+    std::string joint = data->getString("joint",UNKNOWN_STR);
+    if (joint == "mitre") {
+        _joint = poly2::Joint::MITRE;
+    } else if (joint == "bevel") {
+        _joint = poly2::Joint::SQUARE;
+    } else if (joint == "round") {
+        _joint = poly2::Joint::ROUND;
+    } else {
+        _joint = poly2::Joint::NONE;
+    }
+    
+    std::string cap = data->getString("cap",UNKNOWN_STR);
+    if (cap == "square") {
+        _endcap = poly2::EndCap::SQUARE;
+    } else if (cap == "round") {
+        _endcap = poly2::EndCap::ROUND;
+    } else {
+        _endcap = poly2::EndCap::NONE;
+    }
+    
     if (vertices.empty() && indices.empty()) {
         Rect bounds = Rect::ZERO;
         bounds.size = _texture->getSize();
@@ -248,6 +273,55 @@ void WireNode::setTraversal(poly2::Traversal traversal) {
         _polygon = factory.makeTraversal(_source,traversal);
         _mesh.command = _polygon.getGeometry().glCommand();
         TexturedNode::setPolygon(_polygon);
+        updateStroke();
+    }
+}
+
+/**
+ * Sets the stroke width of the wireframe.
+ *
+ * If the stroke width is 0, the wireframe is drawn with lines. Otherwise
+ * it is drawn as a stroke expanded on the GPU. As with {@link PathNode},
+ * the stroke width is the distance from the wireframe to either edge.
+ *
+ * @param stroke    The stroke width of the wireframe
+ */
+void WireNode::setStroke(float stroke) {
+    CUAssertLog(stroke >= 0, "Stroke width is invalid");
+    if (stroke != _stroke) {
+        _stroke = stroke;
+        updateStroke();
+        invalidateRenderCache();
+    }
+}
+
+/**
+ * Sets the joint type between wireframe segments.
+ *
+ * This value has no effect if the stroke width is 0.
+ *
+ * @param joint The joint type between wireframe segments
+ */
+void WireNode::setJoint(poly2::Joint joint) {
+    if (joint != _joint) {
+        _joint = joint;
+        updateStroke();
+        invalidateRenderCache();
+    }
+}
+
+/**
+ * Sets the cap shape at the ends of the wireframe.
+ *
+ * This value has no effect if the stroke width is 0.
+ *
+ * @param cap   The cap shape at the ends of the wireframe.
+ */
+void WireNode::setCap(poly2::EndCap cap) {
+    if (cap != _endcap) {
+        _endcap = cap;
+        updateStroke();
+        invalidateRenderCache();
     }
 }
 
@@ -276,6 +350,7 @@ void WireNode::setPolygon(const std::vector<Vec2>& vertices) {
     factory.makeTraversal(&_polygon,_source,_traversal);
     setContentSize(_polygon.getBounds().size);
     _mesh.command = _polygon.getGeometry().glCommand();
+    updateStroke();
 }
 
 /**
@@ -298,6 +373,7 @@ void WireNode::setPolygon(const Poly2& poly) {
     factory.makeTraversal(&_polygon,_source,_traversal);
     setContentSize(_polygon.getBounds().size);
     _mesh.command = _polygon.getGeometry().glCommand();
+    updateStroke();
 }
 
 /**
@@ -345,6 +421,7 @@ void WireNode::setPolygon(const Rect rect) {
     _polygon.setGeometry(Geometry::PATH);
     setContentSize(_polygon.getBounds().size);
     _mesh.command = _polygon.getGeometry().glCommand();
+    updateStroke();
 }
 
 #pragma mark -
@@ -387,7 +464,75 @@ void WireNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& trans
     }
     batch->setBlendEquation(_blendEquation);
     batch->setBlendFunc(_srcFactor, _dstFactor);
-    batch->outline(_mesh, transform);
+    if (_stroke > 0 && _gradient == nullptr && _texture != nullptr) {
+        Size tsize = _texture->getSize();
+        Mat4 matrix = getStrokeTransform();
+        matrix *= transform;
+        
+        // Texture coordinates are linear in each axis
+        float sa = 1/tsize.width;
+        float sb = 0;
+        float ta = 1/tsize.height;
+        float tb = 0;
+        if (_flipHorizontal) { sa = -sa; sb = 1; }
+        if (!_flipVertical)  { ta = -ta; tb = 1; }
+        float sd = _texture->getMaxS()-_texture->getMinS();
+        float td = _texture->getMaxT()-_texture->getMinT();
+        Affine2 texmap(sa*sd, 0, 0, ta*td, _texture->getMinS()+sb*sd, _texture->getMinT()+tb*td);
+        batch->stroke(_segments, matrix, texmap);
+    } else {
+        batch->outline(_mesh, transform);
+    }
     batch->setGradient(nullptr);
 
 }
+
+/**
+ * Returns the region (in node space) that {@link draw} may touch.
+ *
+ * A wireframe with a positive stroke reaches past the content bounds.
+ *
+ * @return the region (in node space) that {@link draw} may touch.
+ */
+Rect WireNode::getDrawBounds() const {
+    if (_stroke <= 0 || _gradient != nullptr || _texture == nullptr) {
+        return TexturedNode::getDrawBounds();
+    }
+    return getStrokeTransform().transform(SpriteBatch::getStrokeBounds(_segments));
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the transform from the stroke segments to node space.
+ *
+ * This is the same shift as generateRenderData, but on the GPU.
+ *
+ * @return the transform from the stroke segments to node space.
+ */
+Mat4 WireNode::getStrokeTransform() const {
+    Size nsize = getContentSize();
+    Size bsize = _polygon.getBounds().size;
+    Mat4 matrix;
+    if (nsize != bsize) {
+        matrix.scale((bsize.width > 0 ? nsize.width/bsize.width : 0),
+                     (bsize.height > 0 ? nsize.height/bsize.height : 0), 1);
+    }
+    if (!_absolute) {
+        const Vec2 offset = _polygon.getBounds().origin;
+        matrix.translate(-offset.x,-offset.y,0);
+    }
+    return matrix;
+}
+
+/**
+ * Updates the stroke segments, based on the current settings.
+ *
+ * This method does nothing if the stroke width is 0.
+ */
+void WireNode::updateStroke() {
+    _segments.clear();
+    if (_stroke > 0) {
+        SpriteBatch::makeStroke(_polygon,_stroke,_joint,_endcap,_segments);
+    }
+}
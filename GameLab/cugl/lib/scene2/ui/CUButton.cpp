@@ -503,6 +503,7 @@ void Button::setColor(Color4 color) {
     _upcolor = color;
     if (!_down || _downnode) {
         _tintColor = color;
+        invalidateRenderCache();
     }
 }
 
@@ -566,6 +567,7 @@ void Button::setDown(bool down) {
         _downnode->setVisible(true);
     } else if (down) {
         _tintColor = _downcolor;
+        invalidateRenderCache();
     }
     
     if (!down && _downnode && _upnode) {
@@ -573,6 +575,7 @@ void Button::setDown(bool down) {
         _downnode->setVisible(false);
     } else if (!down) {
         _tintColor = _upcolor;
+        invalidateRenderCache();
     }
     
     for(auto it = _listeners.begin(); it != _listeners.end(); ++it) {
@@ -0,0 +1,627 @@
+//
+//  CUImmediateUI.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a lightweight immediate-mode UI layer.  Unlike the
+//  widgets in the scene graph, these widgets are not objects.  They are
+//  declared every frame by calling a method (e.g. button), which draws the
+//  widget and returns its interaction in a single step.  The only state kept
+//  between frames is which widget is under the pointer and which is pressed,
+//  and this is keyed by a widget identifier.
+//
+//  All widgets are drawn with a UITheme, and their geometry is emitted into
+//  reusable meshes that are drawn in a single sprite batch pass at the end of
+//  the frame.  No heap objects are created for a widget.  This makes this
+//  layer ideal for debug panels, editors, and dense HUDs, where the retained
+//  overhead of a scene graph subtree per widget would dominate.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/scene2/ui/CUImmediateUI.h>
+#include <algorithm>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** The FNV-1a offset basis for hashing keys */
+#define FNV_OFFSET  14695981039346656037ULL
+/** The FNV-1a prime for hashing keys */
+#define FNV_PRIME   1099511628211ULL
+/** The fraction of the checkbox inset for the check mark */
+#define CHECK_INSET     0.2f
+/** The height of the slider track relative to the slider */
+#define TRACK_HEIGHT    0.33f
+/** The width of the slider knob relative to the slider height */
+#define KNOB_WIDTH      0.5f
+
+#pragma mark Constructors
+/**
+ * Creates an uninitialized UI layer.
+ *
+ * You must initialize this layer before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+ImmediateUI::ImmediateUI() :
+_hover(0),
+_active(0),
+_activeSeen(false),
+_capture(false),
+_down(false),
+_pressed(false),
+_released(false),
+_inframe(false) {
+    _mesh.command  = GL_TRIANGLES;
+    _solid.command = GL_TRIANGLES;
+    _text.command  = GL_TRIANGLES;
+}
+
+/**
+ * Disposes all of the resources used by this UI layer.
+ *
+ * A disposed layer can be safely reinitialized.
+ */
+void ImmediateUI::dispose() {
+    _theme = nullptr;
+    _mesh.clear();
+    _solid.clear();
+    _text.clear();
+    _hits.clear();
+    _scopes.clear();
+    _hover = 0;
+    _active = 0;
+    _activeSeen = false;
+    _capture = false;
+    _down = false;
+    _pressed = false;
+    _released = false;
+    _inframe = false;
+}
+
+/**
+ * Initializes a UI layer with the given theme.
+ *
+ * If the theme font does not have an atlas, this method will build one.
+ * Widget text is only drawn with a font atlas.
+ *
+ * @param theme The theme to draw the widgets
+ *
+ * @return true if initialization was successful.
+ */
+bool ImmediateUI::init(const std::shared_ptr<UITheme>& theme) {
+    if (_theme != nullptr) {
+        CUAssertLog(false, "ImmediateUI is already initialized");
+        return false;
+    } else if (theme == nullptr || theme->getFont() == nullptr) {
+        CUAssertLog(false, "The theme is undefined");
+        return false;
+    }
+
+    _theme = theme;
+    const std::shared_ptr<Font>& font = theme->getFont();
+    if (!font->hasAtlas() && !font->buildAtlas()) {
+        CULogError("Could not build an atlas for the UI font; text will not be drawn");
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Frame
+/**
+ * Starts a new UI frame with the given pointer state.
+ *
+ * The pointer position should be in the same coordinate space as the
+ * widget bounds.  Presses and releases are detected by comparing the
+ * pointer state to that of the previous frame.  The widget under the
+ * pointer is found in the layout of the previous frame, so a touch that
+ * lands on a widget presses it in the same frame.
+ *
+ * @param pointer   The pointer position
+ * @param down      Whether the pointer (button or touch) is down
+ */
+void ImmediateUI::begin(const Vec2 pointer, bool down) {
+    CUAssertLog(_theme != nullptr, "ImmediateUI is not initialized");
+    CUAssertLog(!_inframe, "ImmediateUI::end() was not called for the last frame");
+    _pressed  = down && !_down;
+    _released = !down && _down;
+    _down = down;
+    _pointer = pointer;
+
+    // Hover uses the new pointer, so a touch can press on the frame it lands.
+    // The widgets are not declared yet, so we test the last frame, topmost first
+    _hover = 0;
+    for(auto it = _hits.rbegin(); it != _hits.rend(); ++it) {
+        if (it->bounds.contains(_pointer)) {
+            _hover = it->key;
+            break;
+        }
+    }
+
+    // Clearing keeps the capacity, so steady frames do not allocate
+    _mesh.clear();
+    _solid.clear();
+    _text.clear();
+    _hits.clear();
+    _scopes.clear();
+    _activeSeen = false;
+    _inframe = true;
+}
+
+/**
+ * Ends the UI frame, drawing all of the widgets to the sprite batch.
+ *
+ * The sprite batch must be active (e.g. between calls to begin and end).
+ * The widgets are drawn with at most three textures: the theme atlas
+ * (plus the blank texture if the atlas has no blank texel) and the
+ * font atlas.
+ *
+ * @param batch     The sprite batch to draw with
+ * @param transform The transform from UI coordinates to the batch
+ */
+void ImmediateUI::end(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform) {
+    CUAssertLog(_inframe, "ImmediateUI::begin() was not called for this frame");
+    _inframe = false;
+
+    // Capture uses the widgets of this frame
+    _capture = false;
+    for(auto it = _hits.begin(); !_capture && it != _hits.end(); ++it) {
+        _capture = it->bounds.contains(_pointer);
+    }
+    if (_released || !_activeSeen) {
+        _active = 0;
+    }
+
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    batch->setColor(Color4::WHITE);
+    if (!_solid.indices.empty()) {
+        batch->setTexture(Texture::getBlank());
+        batch->fill(_solid, transform);
+    }
+    if (!_mesh.indices.empty()) {
+        const std::shared_ptr<Texture>& texture = _theme->getTexture();
+        batch->setTexture(texture == nullptr ? Texture::getBlank() : texture);
+        batch->fill(_mesh, transform);
+    }
+    if (!_text.indices.empty()) {
+        const std::shared_ptr<Font>& font = _theme->getFont();
+        batch->setTexture(font->getAtlas());
+        if (font->isDistanceField()) {
+            batch->setDistanceField(true);
+            batch->fill(_text, transform);
+            batch->setDistanceField(false);
+        } else {
+            batch->fill(_text, transform);
+        }
+    }
+}
+
+/**
+ * Pushes a key scope onto the scope stack.
+ *
+ * All widget keys declared until the matching {@link popKey} are hashed
+ * with this scope.  This allows repeated widgets, such as the rows of a
+ * list, to reuse the same key strings.
+ *
+ * @param scope The scope name
+ */
+void ImmediateUI::pushKey(const std::string& scope) {
+    _scopes.push_back(makeKey(scope));
+}
+
+/**
+ * Pushes a numbered key scope onto the scope stack.
+ *
+ * All widget keys declared until the matching {@link popKey} are hashed
+ * with this scope.  This allows repeated widgets, such as the rows of a
+ * list, to reuse the same key strings.
+ *
+ * @param index The scope number
+ */
+void ImmediateUI::pushKey(Uint64 index) {
+    Key hash = _scopes.empty() ? FNV_OFFSET : _scopes.back();
+    for(int ii = 0; ii < 8; ii++) {
+        hash ^= (index >> (8*ii)) & 0xff;
+        hash *= FNV_PRIME;
+    }
+    _scopes.push_back(hash);
+}
+
+/**
+ * Pops the last key scope from the scope stack.
+ */
+void ImmediateUI::popKey() {
+    CUAssertLog(!_scopes.empty(), "The key scope stack is empty");
+    _scopes.pop_back();
+}
+
+#pragma mark -
+#pragma mark Widgets
+/**
+ * Draws a panel with the given bounds.
+ *
+ * A panel is not interactive, but it does block the pointer from any
+ * widgets drawn beneath it.
+ *
+ * @param bounds    The panel bounds
+ */
+void ImmediateUI::panel(const Rect bounds) {
+    interact(0,bounds);
+    addPart(UITheme::Part::PANEL,bounds);
+}
+
+/**
+ * Draws a text label in the given bounds.
+ *
+ * The text is vertically centered and clipped to the bounds.  A label
+ * is not interactive and does not block the pointer.
+ *
+ * @param bounds    The label bounds
+ * @param text      The label text
+ * @param centered  Whether to center the text horizontally
+ */
+void ImmediateUI::label(const Rect bounds, const std::string& text, bool centered) {
+    addText(bounds,text,centered);
+}
+
+/**
+ * Draws a button, returning true if it was clicked.
+ *
+ * A button is clicked when the pointer is pressed and released over
+ * the button.
+ *
+ * @param key       The widget key
+ * @param bounds    The button bounds
+ * @param text      The button text
+ *
+ * @return true if the button was clicked.
+ */
+bool ImmediateUI::button(const std::string& key, const Rect bounds, const std::string& text) {
+    Key hash = makeKey(key);
+    bool hot = interact(hash,bounds);
+    bool held = _active == hash;
+
+    UITheme::Part part = UITheme::Part::BUTTON;
+    if (held && hot) {
+        part = UITheme::Part::BUTTON_DOWN;
+    } else if (hot && _active == 0) {
+        part = UITheme::Part::BUTTON_HOVER;
+    }
+    addPart(part,bounds);
+    addText(bounds,text,true);
+    return held && hot && _released;
+}
+
+/**
+ * Draws a checkbox, returning true if it changed value.
+ *
+ * The box is a square on the left of the bounds, and the text is drawn
+ * to its right.  The value is toggled when the checkbox is clicked.
+ *
+ * @param key       The widget key
+ * @param bounds    The checkbox bounds
+ * @param text      The checkbox text
+ * @param value     The checkbox value
+ *
+ * @return true if the checkbox changed value.
+ */
+bool ImmediateUI::checkbox(const std::string& key, const Rect bounds, const std::string& text, bool& value) {
+    Key hash = makeKey(key);
+    bool hot = interact(hash,bounds);
+    bool clicked = _active == hash && hot && _released;
+    if (clicked) {
+        value = !value;
+    }
+
+    float side = std::min(bounds.size.width,bounds.size.height);
+    Rect box(bounds.origin.x, bounds.origin.y+(bounds.size.height-side)/2, side, side);
+    addPart(UITheme::Part::CHECKBOX,box);
+    if (value) {
+        float inset = side*CHECK_INSET;
+        Rect mark(box.origin.x+inset,box.origin.y+inset,side-2*inset,side-2*inset);
+        addPart(UITheme::Part::CHECKMARK,mark);
+    }
+
+    Rect area(bounds.origin.x+side,bounds.origin.y,bounds.size.width-side,bounds.size.height);
+    addText(area,text,false);
+    return clicked;
+}
+
+/**
+ * Draws a horizontal slider, returning true if it changed value.
+ *
+ * While the slider is pressed, the value tracks the pointer.  The
+ * value is clamped to the range [min,max].
+ *
+ * @param key       The widget key
+ * @param bounds    The slider bounds
+ * @param value     The slider value
+ * @param min       The minimum slider value
+ * @param max       The maximum slider value
+ *
+ * @return true if the slider changed value.
+ */
+bool ImmediateUI::slider(const std::string& key, const Rect bounds, float& value, float min, float max) {
+    Key hash = makeKey(key);
+    interact(hash,bounds);
+
+    float knob  = std::min(bounds.size.height*KNOB_WIDTH,bounds.size.width);
+    float range = bounds.size.width-knob;
+    float start = bounds.origin.x+knob/2;
+
+    bool changed = false;
+    if (_active == hash && range > 0 && max > min) {
+        float t = std::max(0.0f,std::min(1.0f,(_pointer.x-start)/range));
+        float next = min+t*(max-min);
+        changed = next != value;
+        value = next;
+    }
+
+    float t = max > min ? (value-min)/(max-min) : 0.0f;
+    t = std::max(0.0f,std::min(1.0f,t));
+    float track = bounds.size.height*TRACK_HEIGHT;
+    addPart(UITheme::Part::SLIDER_TRACK,
+            Rect(bounds.origin.x,bounds.origin.y+(bounds.size.height-track)/2,bounds.size.width,track));
+    addPart(UITheme::Part::SLIDER_KNOB,
+            Rect(start+t*range-knob/2,bounds.origin.y,knob,bounds.size.height));
+    return changed;
+}
+
+/**
+ * Draws a progress bar with the given progress.
+ *
+ * The progress is clamped to [0,1].  A progress bar is not interactive
+ * and does not block the pointer.
+ *
+ * @param bounds    The progress bar bounds
+ * @param progress  The progress value in [0,1]
+ */
+void ImmediateUI::progress(const Rect bounds, float progress) {
+    progress = std::max(0.0f,std::min(1.0f,progress));
+    addPart(UITheme::Part::PROGRESS_BACK,bounds);
+    if (progress > 0) {
+        Rect fill = bounds;
+        fill.size.width *= progress;
+        addPart(UITheme::Part::PROGRESS_FILL,fill);
+    }
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the hashed key for the given string in the current scope.
+ *
+ * @param key   The widget key string
+ *
+ * @return the hashed key for the given string in the current scope.
+ */
+ImmediateUI::Key ImmediateUI::makeKey(const std::string& key) const {
+    Key hash = _scopes.empty() ? FNV_OFFSET : _scopes.back();
+    for(auto it = key.begin(); it != key.end(); ++it) {
+        hash ^= (Uint8)(*it);
+        hash *= FNV_PRIME;
+    }
+    // 0 is reserved for non-interactive widgets
+    return hash == 0 ? 1 : hash;
+}
+
+/**
+ * Registers a widget for hit testing, returning true if it is hovered.
+ *
+ * If the pointer is pressed over this widget, it becomes active.
+ *
+ * @param key       The widget key (0 for a non-interactive widget)
+ * @param bounds    The widget bounds
+ *
+ * @return true if the widget is under the pointer.
+ */
+bool ImmediateUI::interact(Key key, const Rect bounds) {
+    CUAssertLog(_inframe, "Widgets must be declared between begin() and end()");
+    Hit hit;
+    hit.bounds = bounds;
+    hit.key = key;
+    _hits.push_back(hit);
+    if (key == 0) {
+        return false;
+    }
+
+    bool hot = _hover == key;
+    if (hot && _pressed) {
+        _active = key;
+    }
+    if (_active == key) {
+        _activeSeen = true;
+    }
+    return hot;
+}
+
+/**
+ * Emits the geometry for a theme part in the given bounds.
+ *
+ * @param part      The theme part
+ * @param bounds    The bounds to draw the part
+ */
+void ImmediateUI::addPart(UITheme::Part part, const Rect bounds) {
+    const UITheme::Region& region = _theme->getRegion(part);
+    const std::shared_ptr<Texture>& texture = _theme->getTexture();
+    Vec4 color = region.color;
+    if (texture == nullptr) {
+        addQuad(_mesh,bounds,Rect(0.5f,0.5f,0,0),color);
+        return;
+    }
+
+    float width  = (float)texture->getWidth();
+    float height = (float)texture->getHeight();
+    if (!region.textured) {
+        if (_theme->hasBlank()) {
+            const Vec2& blank = _theme->getBlank();
+            addQuad(_mesh,bounds,Rect(blank.x/width,blank.y/height,0,0),color);
+        } else {
+            addQuad(_solid,bounds,Rect(0.5f,0.5f,0,0),color);
+        }
+        return;
+    }
+
+    const Rect& src = region.bounds;
+    const Rect& inner = region.interior;
+    if (inner.size.width <= 0 || inner.size.height <= 0) {
+        Rect coords(src.origin.x/width,src.origin.y/height,
+                    src.size.width/width,src.size.height/height);
+        addQuad(_mesh,bounds,coords,color);
+        return;
+    }
+
+    // The source stops of the nine-patch, in pixels
+    float sx[4] = { src.origin.x, src.origin.x+inner.origin.x,
+                    src.origin.x+inner.origin.x+inner.size.width, src.origin.x+src.size.width };
+    float sy[4] = { src.origin.y, src.origin.y+inner.origin.y,
+                    src.origin.y+inner.origin.y+inner.size.height, src.origin.y+src.size.height };
+
+    // The destination stops, shrinking the corners if the widget is too small
+    float left   = sx[1]-sx[0];
+    float right  = sx[3]-sx[2];
+    float bottom = sy[1]-sy[0];
+    float top    = sy[3]-sy[2];
+    if (left+right > bounds.size.width) {
+        float scale = bounds.size.width/(left+right);
+        left  *= scale;
+        right *= scale;
+    }
+    if (bottom+top > bounds.size.height) {
+        float scale = bounds.size.height/(bottom+top);
+        bottom *= scale;
+        top    *= scale;
+    }
+    float dx[4] = { bounds.origin.x, bounds.origin.x+left,
+                    bounds.getMaxX()-right, bounds.getMaxX() };
+    float dy[4] = { bounds.origin.y, bounds.origin.y+bottom,
+                    bounds.getMaxY()-top, bounds.getMaxY() };
+
+    for(int jj = 0; jj < 3; jj++) {
+        if (dy[jj+1] <= dy[jj]) {
+            continue;
+        }
+        for(int ii = 0; ii < 3; ii++) {
+            if (dx[ii+1] <= dx[ii]) {
+                continue;
+            }
+            Rect dst(dx[ii],dy[jj],dx[ii+1]-dx[ii],dy[jj+1]-dy[jj]);
+            Rect coords(sx[ii]/width,sy[jj]/height,
+                        (sx[ii+1]-sx[ii])/width,(sy[jj+1]-sy[jj])/height);
+            addQuad(_mesh,dst,coords,color);
+        }
+    }
+}
+
+/**
+ * Emits a single quad with the given texture coordinates and color.
+ *
+ * @param mesh  The mesh to store the quad
+ * @param dst   The quad bounds
+ * @param src   The texture coordinates (as a rectangle in [0,1])
+ * @param color The quad color
+ */
+void ImmediateUI::addQuad(Mesh<SpriteVertex2>& mesh, const Rect dst, const Rect src, const Vec4& color) {
+    Uint32 offset = (Uint32)mesh.vertices.size();
+    SpriteVertex2 temp;
+    temp.color = color;
+
+    // As with NinePatch, the pixel origin is the bottom-left corner
+    temp.position = dst.origin;
+    temp.texcoord.x = src.origin.x;
+    temp.texcoord.y = 1-src.origin.y;
+    mesh.vertices.push_back(temp);
+
+    temp.position.x = dst.origin.x;
+    temp.position.y = dst.origin.y+dst.size.height;
+    temp.texcoord.x = src.origin.x;
+    temp.texcoord.y = 1-(src.origin.y+src.size.height);
+    mesh.vertices.push_back(temp);
+
+    temp.position.x = dst.origin.x+dst.size.width;
+    temp.position.y = dst.origin.y+dst.size.height;
+    temp.texcoord.x = src.origin.x+src.size.width;
+    temp.texcoord.y = 1-(src.origin.y+src.size.height);
+    mesh.vertices.push_back(temp);
+
+    temp.position.x = dst.origin.x+dst.size.width;
+    temp.position.y = dst.origin.y;
+    temp.texcoord.x = src.origin.x+src.size.width;
+    temp.texcoord.y = 1-src.origin.y;
+    mesh.vertices.push_back(temp);
+
+    mesh.indices.push_back(offset);
+    mesh.indices.push_back(offset+1);
+    mesh.indices.push_back(offset+2);
+    mesh.indices.push_back(offset);
+    mesh.indices.push_back(offset+2);
+    mesh.indices.push_back(offset+3);
+}
+
+/**
+ * Emits the geometry for the text in the given bounds.
+ *
+ * The text is vertically centered and clipped to the bounds.
+ *
+ * @param bounds    The text bounds
+ * @param text      The text to draw
+ * @param centered  Whether to center the text horizontally
+ */
+void ImmediateUI::addText(const Rect bounds, const std::string& text, bool centered) {
+    CUAssertLog(_inframe, "Widgets must be declared between begin() and end()");
+    const std::shared_ptr<Font>& font = _theme->getFont();
+    if (text.empty() || !font->hasAtlas()) {
+        return;
+    }
+
+    float padding = _theme->getPadding();
+    Rect clip(bounds.origin.x+padding,bounds.origin.y,
+              bounds.size.width-2*padding,bounds.size.height);
+    if (clip.size.width <= 0 || clip.size.height <= 0) {
+        return;
+    }
+
+    Vec2 origin(clip.origin.x,bounds.origin.y+(bounds.size.height-font->getHeight())/2);
+    if (centered) {
+        origin.x = bounds.origin.x+(bounds.size.width-font->getSize(text).width)/2;
+    }
+
+    size_t start = _text.vertices.size();
+    font->getMesh(text, origin, clip, _text);
+    Vec4 color = _theme->getTextColor();
+    for(size_t ii = start; ii < _text.vertices.size(); ii++) {
+        _text.vertices[ii].color = color;
+    }
+}
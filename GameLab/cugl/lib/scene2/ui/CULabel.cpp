@@ -528,7 +528,13 @@ void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transfor
     }
     batch->setTexture(_texture);
     batch->setColor(tint);
-    batch->fill(_mesh, transform);
+    if (_font->isDistanceField() && _font->hasAtlas()) {
+        batch->setDistanceField(true);
+        batch->fill(_mesh, transform);
+        batch->setDistanceField(false);
+    } else {
+        batch->fill(_mesh, transform);
+    }
 }
 
 
@@ -576,6 +582,7 @@ void Label::clearRenderData() {
     _mesh.clear();
     _mesh.command = GL_TRIANGLES;
     _rendered = false;
+    invalidateRenderCache();
 }
 
 /**
@@ -591,5 +598,5 @@ void Label::updateColor() {
     
     for(auto it = _mesh.vertices.begin(); it != _mesh.vertices.end(); ++it) {
         it->color = _foreground;
-    }
+    }    invalidateRenderCache();
 }
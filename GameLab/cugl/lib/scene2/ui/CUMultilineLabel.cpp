@@ -0,0 +1,732 @@
+//
+//  CUMultilineLabel.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node that displays a paragraph of text.
+//  The text is broken into lines that fit the width of the node, using a
+//  greedy line breaking over cached glyph advances.  Unlike a single-line
+//  Label, this node is designed for text that grows or changes over time,
+//  such as a chat log.  Edits only reflow the lines from the first changed
+//  line, and the glyph mesh of each line is kept until that line changes.
+//  Only the lines that are visible are rendered.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/scene2/ui/CUMultilineLabel.h>
+#include <cugl/assets/CUScene2Loader.h>
+#include <cugl/assets/CUAssetManager.h>
+#include <utf8/utf8.h>
+#include <algorithm>
+#include <iterator>
+#include <cfloat>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** String for managing unknown JSON values */
+#define UNKNOWN_STR "<unknown>"
+
+#pragma mark Constructors
+/**
+ * Creates an uninitialized label with no text or font information.
+ *
+ * You must initialize this label before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+ * heap, use one of the static constructors instead.
+ */
+MultilineLabel::MultilineLabel() : SceneNode(),
+_padding(Vec2::ZERO),
+_halign(HAlign::LEFT),
+_spacing(1.0f),
+_foreground(Color4::BLACK),
+_background(Color4::CLEAR) {
+    _bytes.push_back(0);
+}
+
+/**
+ * Disposes all of the resources used by this label.
+ *
+ * A disposed label can be safely reinitialized. Any children owned by this
+ * node will be released.  They will be deleted if no other object owns them.
+ *
+ * It is unsafe to call this on a label that is still currently inside of
+ * a scene graph.
+ */
+void MultilineLabel::dispose() {
+    _lines.clear();
+    _text.clear();
+    _codes.clear();
+    _bytes.clear();
+    _bytes.push_back(0);
+    _advances.clear();
+    _kernings.clear();
+    _glyphs.clear();
+    _font = nullptr;
+    _padding = Vec2::ZERO;
+    _halign = HAlign::LEFT;
+    _spacing = 1.0f;
+    _foreground = Color4::BLACK;
+    _background = Color4::CLEAR;
+    SceneNode::dispose();
+}
+
+/**
+ * Initializes a label with the given size and font
+ *
+ * The width of the size is the width at which lines are broken.  The
+ * text is empty and may be set later with {@link setText}.
+ *
+ * @param size  The size of the label to display
+ * @param font  The font for this label
+ *
+ * @return true if initialization was successful.
+ */
+bool MultilineLabel::init(const Size size, const std::shared_ptr<Font>& font) {
+    if (font == nullptr) {
+        CUAssertLog(false, "The font is undefined");
+    } else if (_font != nullptr) {
+        CUAssertLog(false, "MultilineLabel is already initialized");
+    } else {
+        _font = font;
+        if (SceneNode::initWithBounds(size)) {
+            return true;
+        }
+        _font = nullptr;
+    }
+    return false;
+}
+
+/**
+ * Initializes a label with the given text, size and font
+ *
+ * The width of the size is the width at which lines are broken.  The
+ * string must be in either ASCII or UTF8 format.
+ *
+ * @param text  The text to display in the label
+ * @param size  The size of the label to display
+ * @param font  The font for this label
+ *
+ * @return true if initialization was successful.
+ */
+bool MultilineLabel::initWithText(const std::string& text, const Size size,
+                                  const std::shared_ptr<Font>& font) {
+    if (init(size,font)) {
+        setText(text);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Initializes a node with the given JSON specificaton.
+ *
+ * This initializer is designed to receive the "data" object from the
+ * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+ * of the attribute values of its parent class.  In addition, it supports
+ * the following additional attributes:
+ *
+ *      "font":         The name of a previously loaded font asset
+ *      "text":         The initial label text
+ *      "foreground":   A four-element integer array. Values should be 0..255
+ *      "background":   A four-element integer array. Values should be 0..255
+ *      "padding":      A two-element float array.
+ *      "halign":       One of 'left', 'center', and 'right'
+ *      "spacing":      A number representing the line spacing
+ *
+ * The attribute 'font' is REQUIRED.  All other attributes are optional.
+ *
+ * @param loader    The scene loader passing this JSON file
+ * @param data      The JSON object specifying the node
+ *
+ * @return true if initialization was successful.
+ */
+bool MultilineLabel::initWithData(const Scene2Loader* loader, const std::shared_ptr<JsonValue>& data) {
+    if (_font != nullptr) {
+        CUAssertLog(false, "MultilineLabel is already initialized");
+        return false;
+    } else if (!data) {
+        return init();
+    } else if (!SceneNode::initWithData(loader, data)) {
+        return false;
+    }
+
+    // Set the font
+    const AssetManager* assets = loader->getManager();
+    auto font = assets->get<Font>(data->getString("font",UNKNOWN_STR));
+    if (font == nullptr) {
+        CUAssertLog(false, "The font is undefined");
+        return false;
+    }
+    _font = font;
+
+    if (data->has("foreground")) {
+        JsonValue* col = data->get("foreground").get();
+        CUAssertLog(col->size() == 4, "'foreground' must be a 4-element array");
+        _foreground.r = col->get(0)->asInt(0);
+        _foreground.g = col->get(1)->asInt(0);
+        _foreground.b = col->get(2)->asInt(0);
+        _foreground.a = col->get(3)->asInt(0);
+    }
+
+    if (data->has("background")) {
+        JsonValue* col = data->get("background").get();
+        CUAssertLog(col->size() == 4, "'background' must be a 4-element array");
+        _background.r = col->get(0)->asInt(0);
+        _background.g = col->get(1)->asInt(0);
+        _background.b = col->get(2)->asInt(0);
+        _background.a = col->get(3)->asInt(0);
+    }
+
+    if (data->has("padding")) {
+        JsonValue* pad = data->get("padding").get();
+        CUAssertLog(pad->size() == 2, "'padding' must be a 2-element array");
+        _padding.x = pad->get(0)->asFloat(0.0f);
+        _padding.y = pad->get(1)->asFloat(0.0f);
+    }
+
+    if (data->has("halign")) {
+        std::string align = data->getString("halign",UNKNOWN_STR);
+        if (align == "center") {
+            _halign = HAlign::CENTER;
+        } else if (align == "right") {
+            _halign = HAlign::RIGHT;
+        } else {
+            _halign = HAlign::LEFT;
+        }
+    }
+
+    if (data->has("spacing")) {
+        setSpacing(data->getFloat("spacing",1.0f));
+    }
+
+    if (data->has("text")) {
+        setText(data->getString("text"));
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Text Editing
+/**
+ * Sets the text for this label.
+ *
+ * The string must be in either ASCII or UTF8 format.  Newlines start a
+ * new line, but all other unprintable characters will be replaced by
+ * spaces.
+ *
+ * This method reflows the entire text and discards all of the line
+ * meshes.  To add to the text, use {@link appendText} instead.
+ *
+ * @param text  The text for this label.
+ */
+void MultilineLabel::setText(const std::string& text) {
+    _lines.clear();
+    replaceText(0,_codes.size(),text);
+}
+
+/**
+ * Replaces a range of characters in this label with the given text.
+ *
+ * The position and length are measured in decoded characters, not in
+ * bytes.  A length of 0 inserts the text, while an empty string erases
+ * the range.  The string must be in either ASCII or UTF8 format.
+ *
+ * The lines are reflowed from the first changed line, and reflow stops
+ * as soon as the line breaks match the previous layout.  Lines after
+ * the edit keep their glyph meshes.
+ *
+ * @param pos   The position of the first character to replace
+ * @param len   The number of characters to replace
+ * @param text  The replacement text
+ */
+void MultilineLabel::replaceText(size_t pos, size_t len, const std::string& text) {
+    pos = std::min(pos,_codes.size());
+    len = std::min(len,_codes.size()-pos);
+
+    // Strip the non-printable characters first
+    std::string clean;
+    clean.reserve(text.size());
+    for(auto it = text.begin(); it != text.end(); ++it) {
+        Uint8 c = (Uint8)*it;
+        if ((c < 32 && c != '\n') || c == 127) {
+            clean.push_back(' ');
+        } else {
+            clean.push_back(*it);
+        }
+    }
+
+    auto invalid = utf8::find_invalid(clean.begin(), clean.end());
+    if (invalid != clean.end()) {
+        CULogError("String '%s' has an invalid UTF-8 encoding",clean.c_str());
+        clean.erase(invalid,clean.end());
+    }
+
+    // Decode the new characters
+    std::vector<Uint32> codes;
+    std::vector<size_t> bytes;
+    codes.reserve(clean.size());
+    bytes.reserve(clean.size());
+    for(auto it = clean.begin(); it != clean.end(); ) {
+        bytes.push_back(it-clean.begin());
+        codes.push_back(utf8::unchecked::next(it));
+    }
+
+    // Splice the text
+    size_t bytepos = _bytes[pos];
+    size_t bytelen = _bytes[pos+len]-bytepos;
+    _text.replace(bytepos,bytelen,clean);
+
+    _codes.erase(_codes.begin()+pos,_codes.begin()+pos+len);
+    _codes.insert(_codes.begin()+pos,codes.begin(),codes.end());
+
+    _bytes.erase(_bytes.begin()+pos,_bytes.begin()+pos+len);
+    for(size_t ii = pos; ii < _bytes.size(); ii++) {
+        _bytes[ii] = _bytes[ii]-bytelen+clean.size();
+    }
+    for(auto it = bytes.begin(); it != bytes.end(); ++it) {
+        *it += bytepos;
+    }
+    _bytes.insert(_bytes.begin()+pos,bytes.begin(),bytes.end());
+
+    _advances.erase(_advances.begin()+pos,_advances.begin()+pos+len);
+    _advances.insert(_advances.begin()+pos,codes.size(),0.0f);
+    _kernings.erase(_kernings.begin()+pos,_kernings.begin()+pos+len);
+    _kernings.insert(_kernings.begin()+pos,codes.size(),0.0f);
+
+    measure(pos,codes.size());
+    reflow(pos,len,codes.size());
+    invalidateRenderCache();
+}
+
+#pragma mark -
+#pragma mark Text Layout
+/**
+ * Returns the text of the given line.
+ *
+ * This text does not include any newline or the spaces at which the
+ * line was broken.
+ *
+ * @param line  The line index
+ *
+ * @return the text of the given line.
+ */
+std::string MultilineLabel::getLine(size_t line) const {
+    CUAssertLog(line < _lines.size(), "Line index %zu is out of bounds", line);
+    size_t begin = _bytes[_lines[line].begin];
+    return _text.substr(begin,_bytes[_lines[line].end]-begin);
+}
+
+/**
+ * Returns the height necessary to display all of the lines.
+ *
+ * This value does not include the padding.
+ *
+ * @return the height necessary to display all of the lines.
+ */
+float MultilineLabel::getTextHeight() const {
+    if (_lines.empty() || _font == nullptr) {
+        return 0;
+    }
+    return _font->getHeight()+(_lines.size()-1)*_font->getLineSkip()*_spacing;
+}
+
+/**
+ * Sets the padding of the rendered text.
+ *
+ * The x value is the padding on the left and right of the lines, while
+ * the y value is the padding on the top and bottom.  Changing the x
+ * padding reflows the entire text.
+ *
+ * @param padding   The padding of the rendered text.
+ */
+void MultilineLabel::setPadding(const Vec2 padding) {
+    bool wrap = padding.x != _padding.x;
+    _padding = padding;
+    if (wrap) {
+        _lines.clear();
+        reflow(0,0,_codes.size());
+    }
+    invalidateRenderCache();
+}
+
+/**
+ * Sets the line spacing, as a multiple of the font line skip.
+ *
+ * Changing this value does not reflow the text or regenerate any
+ * line meshes.
+ *
+ * @param spacing   The line spacing, as a multiple of the font line skip.
+ */
+void MultilineLabel::setSpacing(float spacing) {
+    CUAssertLog(spacing > 0, "The line spacing must be positive");
+    _spacing = spacing;
+    invalidateRenderCache();
+}
+
+/**
+ * Sets the untransformed size of the node.
+ *
+ * The width of the content size is the width at which lines are broken.
+ * Hence changing the width reflows the entire text.  Changing only the
+ * height does not reflow anything.
+ *
+ * @param size  The untransformed size of the node.
+ */
+void MultilineLabel::setContentSize(const Size size) {
+    bool wrap = size.width != getContentWidth();
+    SceneNode::setContentSize(size);
+    if (wrap && _font != nullptr) {
+        _lines.clear();
+        reflow(0,0,_codes.size());
+    }
+}
+
+#pragma mark -
+#pragma mark Other Attributes
+/**
+ * Sets the font to use this label
+ *
+ * Changing this value will remeasure the text and reflow all of the
+ * lines.  All of the line meshes are discarded.
+ *
+ * @param font  The font to use for this label
+ */
+void MultilineLabel::setFont(const std::shared_ptr<Font>& font) {
+    CUAssertLog(font != nullptr, "The font is undefined");
+    _font = font;
+    _glyphs.clear();
+    measure(0,_codes.size());
+    _lines.clear();
+    reflow(0,0,_codes.size());
+    invalidateRenderCache();
+}
+
+#pragma mark -
+#pragma mark Rendering
+/**
+ * Draws this Node via the given SpriteBatch.
+ *
+ * This method only worries about drawing the current node.  It does not
+ * attempt to render the children.
+ *
+ * Only the lines that are inside both the content bounds and the active
+ * scissor of the sprite batch are drawn.  The glyph mesh of a line is
+ * generated the first time it is drawn, and kept until it changes.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ */
+void MultilineLabel::draw(const std::shared_ptr<SpriteBatch>& batch, const Mat4& transform, Color4 tint) {
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (_background != Color4::CLEAR) {
+        batch->setTexture(Texture::getBlank());
+        batch->setColor(tint*_background);
+        batch->fill(Rect(Vec2::ZERO,getContentSize()),Vec2::ANCHOR_CENTER, transform);
+    }
+    if (_lines.empty() || _font == nullptr) {
+        return;
+    }
+
+    // Find the visible region in node space
+    float ymin = 0;
+    float ymax = getContentHeight();
+    std::shared_ptr<Scissor> active = batch->getScissor();
+    if (active) {
+        Rect bounds = active->getBounds();
+        Affine2 local = active->getTransform();
+        Mat4 inverse = transform.getInverse();
+        Vec2 corners[4] = {
+            bounds.origin, Vec2(bounds.getMaxX(),bounds.getMinY()),
+            Vec2(bounds.getMinX(),bounds.getMaxY()), Vec2(bounds.getMaxX(),bounds.getMaxY())
+        };
+        float lo = FLT_MAX;
+        float hi = -FLT_MAX;
+        for(int ii = 0; ii < 4; ii++) {
+            corners[ii] *= local;
+            corners[ii] *= inverse;
+            lo = std::min(lo,corners[ii].y);
+            hi = std::max(hi,corners[ii].y);
+        }
+        ymin = std::max(ymin,lo);
+        ymax = std::min(ymax,hi);
+    }
+    if (ymax <= ymin) {
+        return;
+    }
+
+    // Line ii occupies [base-ii*skip,base-ii*skip+height]
+    float height = (float)_font->getHeight();
+    float skip = _font->getLineSkip()*_spacing;
+    float base = getContentHeight()-_padding.y-height;
+    if (skip <= 0) {
+        skip = height;
+    }
+    double lo = std::floor((base-ymax)/skip);
+    double hi = std::ceil((base+height-ymin)/skip)+1;
+    size_t first = lo < 0 ? 0 : (size_t)lo;
+    size_t last  = hi < 0 ? 0 : std::min((size_t)hi,_lines.size());
+
+    bool field = _font->isDistanceField() && _font->hasAtlas();
+    batch->setColor(tint*_foreground);
+    if (field) {
+        batch->setDistanceField(true);
+    }
+    float width = getContentWidth();
+    for(size_t ii = first; ii < last; ii++) {
+        Line& line = _lines[ii];
+        if (line.end == line.begin) {
+            continue;
+        } else if (!line.rendered) {
+            generateLine(line);
+        }
+
+        float x = _padding.x;
+        switch (_halign) {
+            case HAlign::LEFT:
+                break;
+            case HAlign::CENTER:
+                x = (width-line.width)/2.0f;
+                break;
+            case HAlign::RIGHT:
+                x = width-_padding.x-line.width;
+                break;
+        }
+        Mat4 matrix = Mat4::createTranslation(Vec3(x,base-ii*skip,0));
+        matrix *= transform;
+        batch->setTexture(line.texture);
+        batch->fill(line.mesh,matrix);
+    }
+    if (field) {
+        batch->setDistanceField(false);
+    }
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the advance of the given character.
+ *
+ * The advance is cached, so the font is only queried once for each
+ * character.  Characters missing from the font have an advance of 0.
+ *
+ * @param code  The Unicode character
+ *
+ * @return the advance of the given character.
+ */
+float MultilineLabel::getAdvance(Uint32 code) {
+    auto it = _glyphs.find(code);
+    if (it != _glyphs.end()) {
+        return it->second;
+    }
+    float advance = 0;
+    if (code != '\n' && _font->hasGlyph(code)) {
+        advance = (float)_font->getMetrics(code).advance;
+    }
+    _glyphs[code] = advance;
+    return advance;
+}
+
+/**
+ * Measures the characters starting at the given position.
+ *
+ * This method computes the advance and kerning of each character
+ * from pos to the end of the text.  The kerning of the character at
+ * pos is recomputed, as the previous character may have changed.
+ *
+ * @param pos   The position of the first character to measure
+ * @param len   The number of characters to measure
+ */
+void MultilineLabel::measure(size_t pos, size_t len) {
+    if (_font == nullptr) {
+        return;
+    }
+
+    // Include the following character, as its kerning may have changed
+    size_t last = std::min(pos+len+1,_codes.size());
+    for(size_t ii = pos; ii < last; ii++) {
+        if (ii < pos+len) {
+            _advances[ii] = getAdvance(_codes[ii]);
+        }
+        _kernings[ii] = 0;
+        if (ii > 0 && _advances[ii] > 0 && _advances[ii-1] > 0) {
+            _kernings[ii] = (float)_font->getKerning(_codes[ii-1],_codes[ii]);
+        }
+    }
+}
+
+/**
+ * Computes the greedy line break for the line starting at the given position.
+ *
+ * @param start The position of the first character of the line
+ * @param line  The line to store the result
+ */
+void MultilineLabel::breakLine(size_t start, Line& line) const {
+    float limit = getWrapWidth();
+    float width = 0;
+    size_t brk = start;
+    float brkwidth = 0;
+
+    line.begin = start;
+    line.rendered = false;
+    size_t ii = start;
+    while (ii < _codes.size() && _codes[ii] != '\n') {
+        float advance = _advances[ii]-(ii > start ? _kernings[ii] : 0);
+        if (_codes[ii] == ' ') {
+            // Break at the first space of a run
+            if (ii > start && _codes[ii-1] != ' ') {
+                brk = ii;
+                brkwidth = width;
+            }
+        } else if (limit > 0 && ii > start && width+advance > limit) {
+            if (brk > start) {
+                line.end = brk;
+                line.width = brkwidth;
+                line.next = brk;
+            } else {
+                // No space, so break the word
+                line.end = ii;
+                line.width = width;
+                line.next = ii;
+            }
+            while (line.next < _codes.size() && _codes[line.next] == ' ') {
+                line.next++;
+            }
+            line.hard = false;
+            return;
+        }
+        width += advance;
+        ii++;
+    }
+
+    line.end = ii;
+    line.width = width;
+    line.hard = ii < _codes.size();
+    line.next = line.hard ? ii+1 : ii;
+}
+
+/**
+ * Reflows the lines after an edit.
+ *
+ * The edit replaced the given number of characters at pos (with respect
+ * to the old text) with the given number of characters.  Lines before
+ * the edit are kept.  Reflow stops as soon as a line break matches
+ * a line break of the old layout, and the remaining lines are kept
+ * with their glyph meshes.
+ *
+ * @param pos       The position of the edit
+ * @param removed   The number of characters removed
+ * @param added     The number of characters added
+ */
+void MultilineLabel::reflow(size_t pos, size_t removed, size_t added) {
+    if (_font == nullptr) {
+        return;
+    }
+
+    // Find the line containing the edit
+    size_t first = 0;
+    if (!_lines.empty()) {
+        auto it = std::upper_bound(_lines.begin(), _lines.end(), pos,
+                                   [](size_t p, const Line& line) { return p < line.begin; });
+        first = (it == _lines.begin() ? 0 : (it-_lines.begin())-1);
+        // The edit may let the previous line absorb a word
+        if (first > 0 && !_lines[first-1].hard) {
+            first--;
+        }
+    }
+
+    // Break lines until we match the old layout after the edit
+    size_t length = _codes.size();
+    size_t start = (first < _lines.size() ? _lines[first].begin : 0);
+    size_t tail = _lines.size();
+    size_t old = first;
+    std::vector<Line> fresh;
+    while (true) {
+        if (start >= pos+added && start < length) {
+            // An old line at the same (shifted) position has the same layout
+            while (old < _lines.size() && (_lines[old].begin < pos+removed ||
+                                           _lines[old].begin-removed+added < start)) {
+                old++;
+            }
+            if (old < _lines.size() && _lines[old].begin-removed+added == start) {
+                tail = old;
+                break;
+            }
+        }
+        if (start >= length) {
+            if (length > 0 && _codes[length-1] == '\n') {
+                // A trailing newline starts an empty line
+                Line line;
+                line.begin = line.end = line.next = length;
+                fresh.push_back(std::move(line));
+            }
+            break;
+        }
+        Line line;
+        breakLine(start,line);
+        start = line.next;
+        fresh.push_back(std::move(line));
+    }
+
+    // Shift the kept lines and splice in the new ones
+    for(size_t ii = tail; ii < _lines.size(); ii++) {
+        _lines[ii].begin = _lines[ii].begin-removed+added;
+        _lines[ii].end   = _lines[ii].end-removed+added;
+        _lines[ii].next  = _lines[ii].next-removed+added;
+    }
+    _lines.erase(_lines.begin()+first,_lines.begin()+tail);
+    _lines.insert(_lines.begin()+first,
+                  std::make_move_iterator(fresh.begin()),
+                  std::make_move_iterator(fresh.end()));
+}
+
+/**
+ * Generates the glyph mesh for the given line.
+ *
+ * @param line  The line to render
+ */
+void MultilineLabel::generateLine(Line& line) {
+    line.mesh.clear();
+    line.mesh.command = GL_TRIANGLES;
+    size_t begin = _bytes[line.begin];
+    std::string text = _text.substr(begin,_bytes[line.end]-begin);
+    line.texture = _font->getMesh(text, Vec2::ZERO, line.mesh);
+    for(auto it = line.mesh.vertices.begin(); it != line.mesh.vertices.end(); ++it) {
+        it->color = Color4::WHITE;
+    }
+    line.rendered = true;
+}
@@ -0,0 +1,700 @@
+//
+//  CUScrollList.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for a virtualized scroll list.  A scroll list
+//  displays a vertical list of items, each drawn by a row subtree.  However,
+//  it only instantiates the rows that are visible (plus a small margin). As
+//  the list scrolls, rows that leave the view are recycled for the items that
+//  enter it.  The data for each item is bound to its row by a callback.  This
+//  allows a list with millions of items to be built and drawn in the same
+//  time as a list with a dozen.
+//
+//  The scroll list can track its own state, scrolling (with inertia) in
+//  response to pan gestures. However, it can only do this when the list is
+//  part of a scene graph, as the scene graph maps screen coordinates to node
+//  coordinates.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/scene2/ui/CUScrollList.h>
+#include <cugl/input/CUInput.h>
+#include <cugl/input/gestures/CUPanInput.h>
+#include <cugl/assets/CUScene2Loader.h>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** The speed (in points per second) below which inertial scrolling stops */
+#define MIN_VELOCITY    1.0
+/** The pause (in microseconds) after which a released pan has no inertia */
+#define RELEASE_PAUSE   100000
+/** The weight of the newest pan sample in the velocity estimate */
+#define VELOCITY_WEIGHT 0.5
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an uninitialized scroll list. You must initialize it before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
+ * heap, use one of the static constructors instead.
+ */
+ScrollList::ScrollList() :
+_count(0),
+_rowHeight(0),
+_margin(DEFAULT_LIST_MARGIN),
+_offset(0),
+_first(0),
+_velocity(0),
+_friction(DEFAULT_LIST_FRICTION),
+_active(false),
+_dragging(false),
+_inputkey(0) {}
+
+/**
+ * Disposes all of the resources used.
+ *
+ * A disposed scroll list can be safely reinitialized. All rows will be
+ * released. They will be deleted if no other object owns them.
+ *
+ * It is unsafe to call this on a scroll list that is still currently
+ * inside of a scene graph.
+ */
+void ScrollList::dispose() {
+    if (_active) {
+        deactivate();
+    }
+    _rows.clear();
+    _spares.clear();
+    _factory = nullptr;
+    _binder = nullptr;
+    _count = 0;
+    _rowHeight = 0;
+    _margin = DEFAULT_LIST_MARGIN;
+    _offset = 0;
+    _first = 0;
+    _velocity = 0;
+    _friction = DEFAULT_LIST_FRICTION;
+    _dragging = false;
+    _inputkey = 0;
+    SceneNode::dispose();
+}
+
+/**
+ * Initializes a scroll list with the given size and row height.
+ *
+ * The list will have no items, and no row factory or binder.  You must
+ * set these before the list will display anything.
+ *
+ * @param size      The size of the visible region of the list
+ * @param height    The height of each row
+ *
+ * @return true if the scroll list is initialized properly, false otherwise.
+ */
+bool ScrollList::init(const Size size, float height) {
+    CUAssertLog(height > 0, "The row height must be positive");
+    if (!SceneNode::initWithBounds(size)) {
+        return false;
+    }
+    _rowHeight = height;
+    setScissor();
+    return true;
+}
+
+/**
+ * Initializes a scroll list with the given size, rows and items.
+ *
+ * The list will immediately create (and bind) the rows needed to fill
+ * the visible region.
+ *
+ * @param size      The size of the visible region of the list
+ * @param height    The height of each row
+ * @param count     The number of items in the list
+ * @param factory   The function to create a new row
+ * @param binder    The function to assign an item to a row
+ *
+ * @return true if the scroll list is initialized properly, false otherwise.
+ */
+bool ScrollList::init(const Size size, float height, size_t count,
+                      RowFactory factory, RowBinder binder) {
+    if (!init(size,height)) {
+        return false;
+    }
+    _count = count;
+    _factory = factory;
+    _binder  = binder;
+    refreshRows(false);
+    return true;
+}
+
+/**
+ * Initializes a node with the given JSON specificaton.
+ *
+ * This initializer is designed to receive the "data" object from the
+ * JSON passed to {@link Scene2Loader}.  This JSON format supports all
+ * of the attribute values of its parent class.  In addition, it supports
+ * the following additional attributes:
+ *
+ *      "row_height":   A number greater than 0, representing the row height
+ *      "count":        An integer representing the number of items
+ *      "margin":       An integer representing the extra rows on each side
+ *      "friction":     A number between 0 and 1 for the inertia decay
+ *      "row":          A JSON object defining the row prefab
+ *
+ * The attribute 'row_height' is REQUIRED.  All other attributes are
+ * optional. The row prefab is instantiated by the loader when the list
+ * is built, enough to fill the visible region.  These rows are recycled
+ * as the list scrolls. If the list is made larger afterwards, you must
+ * set a {@link RowFactory} to create the additional rows.  The items are
+ * not bound to rows until you set a {@link RowBinder}.
+ *
+ * @param loader    The scene loader passing this JSON file
+ * @param data      The JSON object specifying the node
+ *
+ * @return true if initialization was successful.
+ */
+bool ScrollList::initWithData(const Scene2Loader* loader, const std::shared_ptr<JsonValue>& data) {
+    if (!data) {
+        return init();
+    } else if (!SceneNode::initWithData(loader,data)) {
+        return false;
+    }
+
+    if (!data->has("row_height")) {
+        CUAssertLog(false, "JSON is missing a required 'row_height' value");
+        return false;
+    }
+    _rowHeight = data->getFloat("row_height",0.0f);
+    CUAssertLog(_rowHeight > 0, "Attribute 'row_height' must be positive");
+    _count  = data->getLong("count",0);
+    _margin = data->getInt("margin",DEFAULT_LIST_MARGIN);
+    setFriction(data->getFloat("friction",DEFAULT_LIST_FRICTION));
+    setScissor();
+
+    if (data->has("row")) {
+        // Instantiate enough of the prefab to fill the view
+        std::shared_ptr<JsonValue> prefab = data->get("row");
+        size_t amount = (size_t)std::ceil(getContentSize().height/_rowHeight)+1+2*_margin;
+        for(size_t ii = 0; ii < amount; ii++) {
+            std::shared_ptr<SceneNode> row = loader->build("row",prefab);
+            if (row == nullptr) {
+                CULogError("Could not build the row prefab for a scroll list");
+                return false;
+            }
+            row->doLayout();
+            addRow(row);
+        }
+    }
+    refreshRows(false);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Items
+/**
+ * Sets the number of items in this list.
+ *
+ * This method is constant time, regardless of the number of items. The
+ * scroll offset is clamped to the new list length, and all of the rows
+ * are rebound to their items.
+ *
+ * @param count The number of items in this list.
+ */
+void ScrollList::setItemCount(size_t count) {
+    _count = count;
+    _offset = std::min(_offset,getMaxScrollOffset());
+    refreshRows(true);
+}
+
+/**
+ * Reassigns all of the visible items to their rows.
+ *
+ * This method should be called whenever the item data changes.  It calls
+ * the {@link RowBinder} on every row currently assigned to an item.
+ */
+void ScrollList::invalidateItems() {
+    if (_binder) {
+        for(size_t ii = 0; ii < _rows.size(); ii++) {
+            _binder(_rows[ii],_first+ii);
+        }
+    }
+}
+
+/**
+ * Returns the row currently assigned to the given item.
+ *
+ * This method returns nullptr if the item is not visible (or in the
+ * margin about the view).
+ *
+ * @param index The item index
+ *
+ * @return the row currently assigned to the given item.
+ */
+std::shared_ptr<SceneNode> ScrollList::getRow(size_t index) const {
+    if (index < _first || index >= _first+_rows.size()) {
+        return nullptr;
+    }
+    return _rows[index-_first];
+}
+
+#pragma mark -
+#pragma mark Rows
+/**
+ * Sets the height of each row.
+ *
+ * All rows are repositioned, and the scroll offset is clamped to the new
+ * list length.  The rows themselves are not resized.
+ *
+ * @param height    The height of each row.
+ */
+void ScrollList::setRowHeight(float height) {
+    CUAssertLog(height > 0, "The row height must be positive");
+    _rowHeight = height;
+    _offset = std::min(_offset,getMaxScrollOffset());
+    refreshRows(false);
+}
+
+/**
+ * Sets the number of extra rows to keep above and below the view.
+ *
+ * These rows are assigned to items even though they are not visible.
+ * This prevents popping at the edge of the list, and hides the cost of
+ * binding rows when scrolling slowly.
+ *
+ * @param margin    The number of extra rows to keep above and below the view.
+ */
+void ScrollList::setMargin(Uint32 margin) {
+    _margin = margin;
+    refreshRows(false);
+}
+
+/**
+ * Sets the function to create a new row.
+ *
+ * Existing rows are kept, and are still recycled. The factory is only
+ * used when the list needs more rows than it has.  To replace the
+ * existing rows, call {@link clearRows} after setting the factory.
+ *
+ * @param factory   The function to create a new row.
+ */
+void ScrollList::setRowFactory(RowFactory factory) {
+    _factory = factory;
+    refreshRows(false);
+}
+
+/**
+ * Sets the function to assign an item to a row.
+ *
+ * All of the rows are immediately rebound with the new function.
+ *
+ * @param binder    The function to assign an item to a row.
+ */
+void ScrollList::setRowBinder(RowBinder binder) {
+    _binder = binder;
+    refreshRows(true);
+}
+
+/**
+ * Releases all of the rows of this list, creating new ones.
+ *
+ * The new rows are created with the current {@link RowFactory}. If there
+ * is no factory, the list will be empty.
+ */
+void ScrollList::clearRows() {
+    for(auto it = _rows.begin(); it != _rows.end(); ++it) {
+        removeChild(*it);
+    }
+    for(auto it = _spares.begin(); it != _spares.end(); ++it) {
+        removeChild(*it);
+    }
+    _rows.clear();
+    _spares.clear();
+    refreshRows(false);
+}
+
+/**
+ * Sets the untransformed size of the node.
+ *
+ * The content size is the size of the visible region of the list.  The
+ * scissor is resized to match, and rows are added or released to fill
+ * the new region.
+ *
+ * @param size  The untransformed size of the node.
+ */
+void ScrollList::setContentSize(const Size size) {
+    SceneNode::setContentSize(size);
+    if (_scissor) {
+        setScissor();
+    }
+    _offset = std::min(_offset,getMaxScrollOffset());
+    refreshRows(false);
+}
+
+#pragma mark -
+#pragma mark Scrolling
+/**
+ * Sets the distance from the top of the list to the top of the view.
+ *
+ * The value is clamped to the range [0,{@link getMaxScrollOffset}].
+ * This method does not affect the scroll velocity.
+ *
+ * @param offset    The distance from the top of the list to the top of the view.
+ */
+void ScrollList::setScrollOffset(double offset) {
+    offset = std::max(0.0,std::min(offset,getMaxScrollOffset()));
+    if (offset != _offset) {
+        _offset = offset;
+        refreshRows(false);
+    }
+}
+
+/**
+ * Returns the largest possible scroll offset.
+ *
+ * This is the offset at which the last item is at the bottom of the view.
+ * It is 0 if all of the items fit in the view.
+ *
+ * @return the largest possible scroll offset.
+ */
+double ScrollList::getMaxScrollOffset() const {
+    double length = (double)_count*_rowHeight;
+    return std::max(0.0,length-getContentSize().height);
+}
+
+/**
+ * Scrolls the list so that the given item is at the top of the view.
+ *
+ * The resulting offset is clamped to the length of the list, so the item
+ * may not be at the top if it is near the end of the list.  This method
+ * stops any inertial scrolling.
+ *
+ * @param index The item index
+ */
+void ScrollList::scrollToItem(size_t index) {
+    _velocity = 0;
+    setScrollOffset((double)index*_rowHeight);
+}
+
+/**
+ * Sets the fraction of the scroll velocity retained after one second.
+ *
+ * This value determines how quickly the list comes to rest after a pan
+ * gesture. A value of 0 means the list stops immediately, while a value
+ * of 1 means the list never stops.
+ *
+ * @param friction  The fraction of the scroll velocity retained after one second.
+ */
+void ScrollList::setFriction(float friction) {
+    CUAssertLog(friction >= 0 && friction <= 1, "The friction %f is out of range", friction);
+    _friction = friction;
+}
+
+/**
+ * Applies the inertial scrolling of this list.
+ *
+ * This method should be called every animation frame.  It has no effect
+ * while a pan gesture is scrolling the list, or if the list is at rest.
+ *
+ * @param timestep  The time elapsed since the last frame (in seconds)
+ */
+void ScrollList::update(float timestep) {
+    if (_dragging || _velocity == 0) {
+        return;
+    }
+
+    double goal = _offset+_velocity*timestep;
+    setScrollOffset(goal);
+    if (_offset != goal) {
+        // We hit the end of the list
+        _velocity = 0;
+        return;
+    }
+
+    _velocity *= std::pow((double)_friction,(double)timestep);
+    if (std::fabs(_velocity) < MIN_VELOCITY) {
+        _velocity = 0;
+    }
+}
+
+#pragma mark -
+#pragma mark Listeners
+/**
+ * Activates this scroll list to respond to pan gestures.
+ *
+ * The list will scroll in response to any pan that starts inside of it.
+ * If the pan input is a touch screen, the list follows the fingers
+ * exactly.  Otherwise (such as a trackpad), a pan across the whole
+ * device scrolls the list by its height.
+ *
+ * The {@link PanInput} device must be active before this method is called.
+ *
+ * @return true if the scroll list was successfully activated
+ */
+bool ScrollList::activate() {
+    if (_active) {
+        return false;
+    }
+
+    PanInput* pan = Input::get<PanInput>();
+    CUAssertLog(pan, "Pan input is not enabled");
+    if (!_inputkey) { _inputkey = pan->acquireKey(); }
+
+    bool down = pan->addBeginListener(_inputkey, [=](const PanEvent& event, bool) {
+        PanInput* input = Input::get<PanInput>();
+        if (input->isTouchScreen()) {
+            Vec2 local = screenToNodeCoords(event.position);
+            _dragging = Rect(Vec2::ZERO,getContentSize()).contains(local);
+        } else {
+            _dragging = true;
+        }
+        if (_dragging) {
+            _velocity = 0;
+            _lastpan = event.timestamp;
+        }
+    });
+
+    bool up = false;
+    if (down) {
+        up = pan->addEndListener(_inputkey, [=](const PanEvent&, bool) {
+            if (_dragging) {
+                // A pan that came to rest before release has no inertia
+                Timestamp now;
+                if (Timestamp::ellapsedMicros(_lastpan,now) > RELEASE_PAUSE) {
+                    _velocity = 0;
+                }
+                _dragging = false;
+            }
+        });
+        if (!up) {
+            pan->removeBeginListener(_inputkey);
+        }
+    }
+
+    bool drag = false;
+    if (up && down) {
+        drag = pan->addMotionListener(_inputkey, [=](const PanEvent& event, bool) {
+            if (!_dragging) {
+                return;
+            }
+            PanInput* input = Input::get<PanInput>();
+            float delta;
+            if (input->isTouchScreen()) {
+                Vec2 curr = screenToNodeCoords(event.position);
+                Vec2 prev = screenToNodeCoords(event.position-event.delta);
+                delta = curr.y-prev.y;
+            } else {
+                delta = -event.delta.y*getContentSize().height;
+            }
+            dragList(delta,event.timestamp);
+        });
+        if (!drag) {
+            pan->removeBeginListener(_inputkey);
+            pan->removeEndListener(_inputkey);
+        }
+    }
+
+    _active = up && down && drag;
+    return _active;
+}
+
+/**
+ * Deactivates this scroll list, ignoring pan gestures from then on.
+ *
+ * The list can still be scrolled with {@link setScrollOffset}, and any
+ * inertial scrolling will continue in {@link update}.
+ *
+ * @return true if the scroll list was successfully deactivated
+ */
+bool ScrollList::deactivate() {
+    if (!_active) {
+        return false;
+    }
+
+    PanInput* pan = Input::get<PanInput>();
+    CUAssertLog(pan, "Pan input is no longer enabled");
+    bool success = pan->removeBeginListener(_inputkey);
+    success = pan->removeEndListener(_inputkey) && success;
+    success = pan->removeMotionListener(_inputkey) && success;
+
+    _active = false;
+    _dragging = false;
+    return success;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Reassigns the rows to the items in (or near) the view.
+ *
+ * Rows that are still assigned to the same items are left alone, unless
+ * rebind is true.  Rows that are no longer needed are made invisible and
+ * kept as spares.
+ *
+ * @param rebind    Whether to rebind all of the rows to their items
+ */
+void ScrollList::refreshRows(bool rebind) {
+    // Compute the item range [first,last) that needs rows
+    size_t first = 0;
+    size_t last  = 0;
+    if (_count > 0 && _rowHeight > 0) {
+        double top = std::floor(_offset/_rowHeight)-_margin;
+        double bot = std::ceil((_offset+getContentSize().height)/_rowHeight)+_margin;
+        first = top < 0 ? 0 : (size_t)top;
+        last  = bot < 0 ? 0 : std::min((size_t)bot,_count);
+        last  = std::max(first,last);
+    }
+
+    // Release the rows outside of the range
+    if (rebind || last <= _first || first >= _first+_rows.size()) {
+        for(auto it = _rows.begin(); it != _rows.end(); ++it) {
+            releaseRow(*it);
+        }
+        _rows.clear();
+        _first = first;
+    } else {
+        while (_first < first) {
+            releaseRow(_rows.front());
+            _rows.pop_front();
+            _first++;
+        }
+        while (_first+_rows.size() > last) {
+            releaseRow(_rows.back());
+            _rows.pop_back();
+        }
+    }
+
+    // Fill in the rest of the range
+    while (_first > first) {
+        std::shared_ptr<SceneNode> row = acquireRow(_first-1);
+        if (row == nullptr) {
+            break;
+        }
+        _rows.push_front(row);
+        _first--;
+    }
+    while (_first+_rows.size() < last) {
+        std::shared_ptr<SceneNode> row = acquireRow(_first+_rows.size());
+        if (row == nullptr) {
+            break;
+        }
+        _rows.push_back(row);
+    }
+    positionRows();
+}
+
+/**
+ * Returns a row assigned to the given item.
+ *
+ * The row is a spare, if one is available.  Otherwise it is created
+ * with the {@link RowFactory} and added as a child of this list.  This
+ * method returns nullptr if there are no spares and no factory.
+ *
+ * @param index The item index
+ *
+ * @return a row assigned to the given item.
+ */
+std::shared_ptr<SceneNode> ScrollList::acquireRow(size_t index) {
+    if (_spares.empty()) {
+        if (!_factory) {
+            return nullptr;
+        }
+        std::shared_ptr<SceneNode> row = _factory();
+        if (row == nullptr) {
+            return nullptr;
+        }
+        addRow(row);
+    }
+
+    std::shared_ptr<SceneNode> row = _spares.back();
+    _spares.pop_back();
+    row->setVisible(true);
+    if (_binder) {
+        _binder(row,index);
+    }
+    return row;
+}
+
+/**
+ * Releases the given row, making it a spare.
+ *
+ * The row is made invisible, but remains a child of this list.
+ *
+ * @param row   The row to release
+ */
+void ScrollList::releaseRow(const std::shared_ptr<SceneNode>& row) {
+    row->setVisible(false);
+    _spares.push_back(row);
+}
+
+/**
+ * Adds the given row to this list as a spare.
+ *
+ * @param row   The row to add
+ */
+void ScrollList::addRow(const std::shared_ptr<SceneNode>& row) {
+    row->setAnchor(Vec2::ANCHOR_TOP_LEFT);
+    row->setVisible(false);
+    addChild(row);
+    _spares.push_back(row);
+}
+
+/**
+ * Positions the assigned rows according to the scroll offset.
+ */
+void ScrollList::positionRows() {
+    // Subtract in double precision, as the offset may be huge
+    double top = getContentSize().height+_offset;
+    for(size_t ii = 0; ii < _rows.size(); ii++) {
+        double y = top-(double)(_first+ii)*_rowHeight;
+        _rows[ii]->setPosition(0,(float)y);
+    }
+}
+
+/**
+ * Scrolls the list by the given pan delta, tracking the pan velocity.
+ *
+ * @param delta The scroll distance in node coordinates
+ * @param stamp The time of the pan motion
+ */
+void ScrollList::dragList(float delta, const Timestamp& stamp) {
+    Uint64 micros = Timestamp::ellapsedMicros(_lastpan,stamp);
+    if (micros > 0) {
+        double sample = delta*1000000.0/micros;
+        _velocity = VELOCITY_WEIGHT*sample+(1-VELOCITY_WEIGHT)*_velocity;
+    }
+    _lastpan = stamp;
+    scrollBy(delta);
+}
@@ -0,0 +1,295 @@
+//
+//  CUUITheme.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the visual theme for the immediate-mode UI layer.
+//  A theme maps each widget part (button, slider knob, panel, and so on) to a
+//  region of a single texture atlas, together with a nine-patch interior and
+//  a color.  Because every part comes from the same texture, an entire UI
+//  frame can be drawn in a single sprite batch pass.
+//
+//  A theme does not need a texture.  If there is no atlas, every part is
+//  drawn as a solid rectangle of its color.  This is useful for debug panels.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/scene2/ui/CUUITheme.h>
+#include <cugl/assets/CUAssetManager.h>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** String for managing unknown JSON values */
+#define UNKNOWN_STR "<unknown>"
+/** The default padding between a widget edge and its text */
+#define DEFAULT_PADDING 4.0f
+
+/** The JSON names of each part, in enum order */
+static const char* PART_NAMES[] = {
+    "panel", "button", "button_hover", "button_down", "checkbox", "checkmark",
+    "slider_track", "slider_knob", "progress_back", "progress_fill"
+};
+
+/** The default (solid) color of each part, in enum order */
+static const Color4 PART_COLORS[] = {
+    Color4(32,32,40,224),   Color4(72,72,88,255),    Color4(96,96,120,255),
+    Color4(48,48,64,255),   Color4(24,24,32,255),    Color4(120,180,255,255),
+    Color4(24,24,32,255),   Color4(120,180,255,255), Color4(24,24,32,255),
+    Color4(120,180,255,255)
+};
+
+/**
+ * Reads a four-element color array from the JSON value
+ *
+ * @param value The JSON array
+ * @param color The color to store the result
+ */
+static void readColor(const JsonValue* value, Color4& color) {
+    CUAssertLog(value->size() == 4, "'color' must be a 4-element array");
+    color.r = value->get(0)->asInt(0);
+    color.g = value->get(1)->asInt(0);
+    color.b = value->get(2)->asInt(0);
+    color.a = value->get(3)->asInt(0);
+}
+
+/**
+ * Reads a four-element rectangle array from the JSON value
+ *
+ * @param value The JSON array
+ * @param rect  The rectangle to store the result
+ */
+static void readRect(const JsonValue* value, Rect& rect) {
+    CUAssertLog(value->size() == 4, "A rectangle must be a 4-element array");
+    rect.origin.x = value->get(0)->asFloat(0.0f);
+    rect.origin.y = value->get(1)->asFloat(0.0f);
+    rect.size.width  = value->get(2)->asFloat(0.0f);
+    rect.size.height = value->get(3)->asFloat(0.0f);
+}
+
+#pragma mark Constructors
+/**
+ * Creates an uninitialized theme.
+ *
+ * You must initialize this theme before use.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+UITheme::UITheme() :
+_hasBlank(false),
+_textColor(Color4::WHITE),
+_padding(DEFAULT_PADDING),
+_initialized(false) {
+}
+
+/**
+ * Disposes all of the resources used by this theme.
+ *
+ * A disposed theme can be safely reinitialized.
+ */
+void UITheme::dispose() {
+    _texture = nullptr;
+    _font = nullptr;
+    for(int ii = 0; ii < (int)Part::COUNT; ii++) {
+        _regions[ii] = Region();
+    }
+    _blank = Vec2::ZERO;
+    _hasBlank = false;
+    _textColor = Color4::WHITE;
+    _padding = DEFAULT_PADDING;
+    _initialized = false;
+}
+
+/**
+ * Initializes a theme with the given atlas and font.
+ *
+ * Until a region is assigned to a part, that part will be drawn as a
+ * solid rectangle with a default color.  The atlas may be nullptr.
+ *
+ * @param texture   The texture atlas for all of the parts
+ * @param font      The font for all widget text
+ *
+ * @return true if initialization was successful.
+ */
+bool UITheme::init(const std::shared_ptr<Texture>& texture, const std::shared_ptr<Font>& font) {
+    if (_initialized) {
+        CUAssertLog(false, "UITheme is already initialized");
+        return false;
+    } else if (font == nullptr) {
+        CUAssertLog(false, "The font is undefined");
+        return false;
+    }
+
+    _texture = texture;
+    _font = font;
+    for(int ii = 0; ii < (int)Part::COUNT; ii++) {
+        _regions[ii].color = PART_COLORS[ii];
+    }
+    _initialized = true;
+    return true;
+}
+
+/**
+ * Initializes a theme with the given JSON specificaton.
+ *
+ * This JSON format supports the following attributes:
+ *
+ *      "texture":  The name of a previously loaded texture asset
+ *      "font":     The name of a previously loaded font asset
+ *      "color":    A four-element integer array for the text color
+ *      "blank":    A two-element number array for a solid white pixel
+ *      "padding":  A number for the padding between widget edges and text
+ *      "parts":    An object mapping part names to regions
+ *
+ * Each region is an object with the following attributes:
+ *
+ *      "bounds":   A four-element number array (x,y,width,height)
+ *      "interior": A four-element number array (x,y,width,height)
+ *      "color":    A four-element integer array. Values should be 0..255
+ *
+ * The part names are the lower case names of {@link Part}, such as
+ * "button_hover" or "slider_knob".  The attribute 'font' is REQUIRED.
+ * All other attributes are optional.
+ *
+ * @param assets    The asset manager with the texture and font
+ * @param data      The JSON object specifying the theme
+ *
+ * @return true if initialization was successful.
+ */
+bool UITheme::initWithData(const AssetManager* assets, const std::shared_ptr<JsonValue>& data) {
+    if (!data) {
+        CUAssertLog(false, "The theme data is undefined");
+        return false;
+    }
+
+    std::shared_ptr<Texture> texture = nullptr;
+    if (data->has("texture")) {
+        texture = assets->get<Texture>(data->getString("texture",UNKNOWN_STR));
+        if (texture == nullptr) {
+            CULogError("The theme texture '%s' is not loaded", data->getString("texture").c_str());
+        }
+    }
+    std::shared_ptr<Font> font = assets->get<Font>(data->getString("font",UNKNOWN_STR));
+    if (!init(texture,font)) {
+        return false;
+    }
+
+    if (data->has("color")) {
+        readColor(data->get("color").get(),_textColor);
+    }
+    if (data->has("blank") && _texture != nullptr) {
+        JsonValue* pixel = data->get("blank").get();
+        CUAssertLog(pixel->size() == 2, "'blank' must be a 2-element array");
+        setBlank(Vec2(pixel->get(0)->asFloat(0.0f),pixel->get(1)->asFloat(0.0f)));
+    }
+    _padding = data->getFloat("padding",DEFAULT_PADDING);
+
+    JsonValue* parts = data->get("parts").get();
+    if (parts == nullptr) {
+        return true;
+    }
+    for(int ii = 0; ii < (int)Part::COUNT; ii++) {
+        JsonValue* part = parts->get(PART_NAMES[ii]).get();
+        if (part == nullptr) {
+            continue;
+        }
+        Region& region = _regions[ii];
+        if (part->has("color")) {
+            readColor(part->get("color").get(),region.color);
+        }
+        if (part->has("bounds") && _texture != nullptr) {
+            readRect(part->get("bounds").get(),region.bounds);
+            region.textured = true;
+        }
+        if (part->has("interior")) {
+            readRect(part->get("interior").get(),region.interior);
+        }
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Sets the atlas region for the given part.
+ *
+ * The interior is specified relative to the origin of the bounds, exactly
+ * as in {@link NinePatch}.  If the interior is empty, the region is
+ * stretched to fit the widget.
+ *
+ * @param part      The widget part
+ * @param bounds    The region bounds in the atlas, in pixels
+ * @param interior  The nine-patch interior, relative to the region origin
+ * @param color     The color to tint this region
+ */
+void UITheme::setRegion(Part part, const Rect bounds, const Rect interior, Color4 color) {
+    CUAssertLog(part != Part::COUNT, "Part is not valid");
+    CUAssertLog(_texture != nullptr, "The theme has no texture atlas");
+    Region& region = _regions[(int)part];
+    region.bounds = bounds;
+    region.interior = interior;
+    region.color = color;
+    region.textured = _texture != nullptr;
+}
+
+/**
+ * Sets the pixel position of a solid white texel in the atlas.
+ *
+ * This texel allows solid parts to be drawn with the same texture as
+ * the textured ones, so that a frame is drawn in a single pass.  The
+ * position should be the center of the pixel (e.g. (0.5,0.5)) to avoid
+ * sampling its neighbors.
+ *
+ * @param pixel The pixel position of a solid white texel in the atlas.
+ */
+void UITheme::setBlank(const Vec2 pixel) {
+    CUAssertLog(_texture != nullptr, "The theme has no texture atlas");
+    _blank = pixel;
+    _hasBlank = _texture != nullptr;
+}
+
+/**
+ * Sets the given part to be a solid rectangle of the given color.
+ *
+ * @param part      The widget part
+ * @param color     The color of the part
+ */
+void UITheme::setRegion(Part part, Color4 color) {
+    CUAssertLog(part != Part::COUNT, "Part is not valid");
+    Region& region = _regions[(int)part];
+    region.bounds = Rect::ZERO;
+    region.interior = Rect::ZERO;
+    region.color = color;
+    region.textured = false;
+}
@@ -9312,6 +9312,299 @@ void cugl::testFilters() {
     CULog("Filter tests complete.\n");
 }
 
+#pragma mark -
+#pragma mark CPU Dispatch
+/**
+ * Unit test for the runtime dispatch of the vectorized kernels.
+ *
+ * This test forces each supported level in turn, and compares the results
+ * to the scalar implementation.  It also reports the time of each kernel
+ * at each level.
+ */
+void cugl::testCPUDispatch() {
+    CULog("Running tests for CPU dispatch.\n");
+    CULog("Detected level is %s",CPUFeatures::getName(CPUFeatures::getDetected()));
+    
+    // Odd size to exercise the remainder of every vector width
+    const size_t size = ARRAY_SIZE+13;
+    float* input1 = new float[size*4];
+    float* input2 = new float[size*4];
+    float* expect = new float[size*4];
+    float* output = new float[size*4];
+    for(int ii = 0; ii < size*4; ii++) {
+        input1[ii] = 2*sinf(ii * M_PI / 10.0f);
+        input2[ii] = cosf(ii * M_PI / 10.0f);
+    }
+    
+    Mat4 mat;
+    Mat4::createRotation(Vec3(1,2,3), M_PI/5.0f, &mat);
+    mat.translate(4, 5, 6);
+    Affine2 aff(1.5f,0.25f,-0.75f,2.0f,5.0f,-3.0f);
+
+    CUAssertAlwaysLog(CPUFeatures::isSupported(CPUFeatures::Level::SCALAR), "Method isSupported() failed");
+    CUAssertAlwaysLog(CPUFeatures::getLevel() == CPUFeatures::getDetected(), "Method getLevel() failed");
+
+    const int KERNELS = 8;
+    const char* names[KERNELS] = { "add", "scale", "scale_add", "clamp", "mat4", "affine2",
+                                   "ramp (mono)", "ramp (stereo)" };
+    
+    for(int kk = 0; kk < KERNELS; kk++) {
+        // Reference values use the scalar implementation
+        CPUFeatures::setLevel(CPUFeatures::Level::SCALAR);
+        size_t width = 1;
+        for(int pass = 0; pass <= (int)CPUFeatures::Level::AVX512; pass++) {
+            CPUFeatures::Level level = (CPUFeatures::Level)pass;
+            if (!CPUFeatures::setLevel(level)) {
+                continue;
+            }
+            
+            float* dst = pass == 0 ? expect : output;
+            cugl::Timestamp start, end;
+            start.mark();
+            for(int ii = 0; ii < LOOP_SIZE; ii++) {
+                switch (kk) {
+                    case 0:
+                        DSPMath::add(input1,input2,dst,size);
+                        width = 1;
+                        break;
+                    case 1:
+                        DSPMath::scale(input1,0.5f,dst,size);
+                        width = 1;
+                        break;
+                    case 2:
+                        DSPMath::scale_add(input1,input2,0.5f,dst,size);
+                        width = 1;
+                        break;
+                    case 3:
+                        std::memcpy(dst, input1, size*sizeof(float));
+                        DSPMath::clamp(dst,-1.0f,1.0f,size);
+                        width = 1;
+                        break;
+                    case 4:
+                        Mat4::transform(mat,input1,dst,size);
+                        width = 4;
+                        break;
+                    case 5:
+                        Affine2::transform(aff,input1,dst,size);
+                        width = 2;
+                        break;
+                    case 6:
+                        DSPMath::ramp(input1,1.0f,-1.0f/size,1,dst,size);
+                        width = 1;
+                        break;
+                    case 7:
+                        DSPMath::ramp(input1,0.0f,1.0f/size,2,dst,size);
+                        width = 2;
+                        break;
+                }
+            }
+            end.mark();
+            
+            int same = -1;
+            for(int ii = 0; pass > 0 && same == -1 && ii < size*width; ii++) {
+                if (fabsf(expect[ii] - output[ii]) >= CU_MATH_EPSILON) {
+                    same = ii;
+                }
+            }
+            CUAssertAlwaysLog(same == -1, "%s (%s) failed at position %d [%f vs %f]",
+                              names[kk],CPUFeatures::getName(level),same,expect[same],output[same]);
+            CULog("%s (%s) time: %llu micros",names[kk],CPUFeatures::getName(level),
+                  cugl::Timestamp::ellapsedMicros(start,end));
+        }
+    }
+    
+    // Matrix multiplication
+    Mat4 right;
+    Mat4::createLookAt(Vec3(1,2,3), Vec3::ZERO, Vec3::UNIT_Y, &right);
+    Mat4 product;
+    CPUFeatures::setLevel(CPUFeatures::Level::SCALAR);
+    Mat4::multiply(mat, right, &product);
+    for(int pass = 1; pass <= (int)CPUFeatures::Level::AVX512; pass++) {
+        CPUFeatures::Level level = (CPUFeatures::Level)pass;
+        if (CPUFeatures::setLevel(level)) {
+            Mat4 result;
+            Mat4::multiply(mat, right, &result);
+            CUAssertAlwaysLog(result.equals(product), "Mat4::multiply() (%s) failed",
+                              CPUFeatures::getName(level));
+            result = right;
+            Mat4::multiply(mat, result, &result);
+            CUAssertAlwaysLog(result.equals(product), "Mat4::multiply() (%s) failed in place",
+                              CPUFeatures::getName(level));
+        }
+    }
+    
+    // Overrides
+    CPUFeatures::resetLevel();
+    CUAssertAlwaysLog(CPUFeatures::getLevel() == CPUFeatures::getDetected(), "Method resetLevel() failed");
+    if (CPUFeatures::getDetected() != CPUFeatures::Level::AVX512) {
+        CUAssertAlwaysLog(!CPUFeatures::setLevel(CPUFeatures::Level::AVX512), "Method setLevel() failed");
+        CUAssertAlwaysLog(CPUFeatures::getLevel() == CPUFeatures::getDetected(), "Method setLevel() failed");
+    }
+    
+    delete[] input1;
+    delete[] input2;
+    delete[] expect;
+    delete[] output;
+    
+#pragma mark Complete
+    CULog("CPU dispatch tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Path Smoother
+/**
+ * Performs the original recursive Douglas-Peucker on the given segment
+ *
+ * This is the implementation that {@link PathSmoother} replaced. It is kept
+ * here as a reference, since the new implementation must produce the same
+ * vertices. The results are appended to output.
+ *
+ * @param input     The path to smooth
+ * @param epsilon   The smoothing tolerance
+ * @param start     The first position in input to process
+ * @param end       The last position in input to process
+ * @param output    The vector to store the smoothed path
+ *
+ * @return the number of points preserved in smoothing
+ */
+static size_t recursivePeucker(const std::vector<Vec2>& input, float epsilon,
+                               size_t start, size_t end, std::vector<Vec2>& output) {
+    const size_t OVER = (size_t)-1;
+    Vec2 sp = input[start];
+    Vec2 ep = (end == OVER ? input[0] : input[end]);
+    if (end - start <= 1 || (end == OVER && start == input.size()-1)) {
+        output.push_back(sp);
+        output.push_back(ep);
+        return 2;
+    } else if (sp == ep) {
+        output.push_back(sp);
+        size_t index = OVER;
+        for(size_t ii = start+1; index == OVER && ii < end; ii++) {
+            Vec2 v = input[ii];
+            if (v != sp) {
+                index = ii;
+            }
+        }
+        if (index != OVER) {
+            return recursivePeucker(input, epsilon, index, end, output)+1;
+        } else {
+            output.push_back(ep);
+            return 2;
+        }
+    }
+
+    float dMax = 0;
+    size_t index = 0;
+    for(size_t ii = start+1; ii < end; ii++) {
+        Vec2 v = input[ii];
+        Vec2 u = ep-sp;
+        float dist = fabsf((u.y*v.x-u.x*v.y+ep.x*sp.y-ep.y*sp.x)/u.length());
+        if (dist > dMax) {
+            index = ii;
+            dMax = dist;
+        }
+    }
+
+    if (dMax > epsilon) {
+        size_t result = 0;
+        result += recursivePeucker(input, epsilon, start, index, output);
+        output.pop_back();
+        result += recursivePeucker(input, epsilon, index, end, output);
+        return result;
+    } else {
+        output.push_back(sp);
+        output.push_back(ep);
+        return 2;
+    }
+    
+    return 0;
+}
+
+/**
+ * Returns a random walk of the given length.
+ *
+ * If grid is true, the points are rounded to integers, so that the walk
+ * has repeated points and closed loops.
+ *
+ * @param length    The number of points
+ * @param grid      Whether to round the points to integers
+ *
+ * @return a random walk of the given length.
+ */
+static std::vector<Vec2> randomWalk(size_t length, bool grid) {
+    std::vector<Vec2> result;
+    result.reserve(length);
+    Vec2 pos;
+    float angle = 0;
+    for(size_t ii = 0; ii < length; ii++) {
+        angle += ((rand() % 2001)-1000)/2000.0f;
+        pos += Vec2(cosf(angle),sinf(angle))*(grid ? 1.0f : (rand() % 100)/25.0f);
+        result.push_back(grid ? Vec2(roundf(pos.x),roundf(pos.y)) : pos);
+    }
+    return result;
+}
+
+/**
+ * Unit test for the path smoother.
+ *
+ * This test compares {@link PathSmoother} to the original recursive
+ * algorithm on random paths, and reports the time of both on a long path.
+ */
+void cugl::testPathSmoother() {
+    CULog("Running tests for PathSmoother.\n");
+    srand(1234);
+
+#pragma mark Equivalence Test
+    PathSmoother smoother;
+    for(int test = 0; test < 3000; test++) {
+        std::vector<Vec2> path = randomWalk(2+rand() % 400,test % 3 == 0);
+        if (test % 50 == 0) {
+            path.push_back(path.front());
+        }
+        float epsilon = (rand() % 40)/10.0f;
+        std::vector<Vec2> expect;
+        recursivePeucker(path,epsilon,0,path.size()-1,expect);
+
+        smoother.set(path);
+        smoother.setEpsilon(epsilon);
+        smoother.calculate();
+        std::vector<Vec2> actual = smoother.getPath();
+        CUAssertAlwaysLog(actual == expect, "Path %d has %zu vertices, not %zu",
+                          test, actual.size(), expect.size());
+    }
+
+    // A single point is not doubled
+    smoother.set(std::vector<Vec2>(1,Vec2(3,4)));
+    smoother.calculate();
+    CUAssertAlwaysLog(smoother.getPath() == std::vector<Vec2>(1,Vec2(3,4)), "Method calculate() failed");
+    smoother.set(std::vector<Vec2>());
+    smoother.calculate();
+    CUAssertAlwaysLog(smoother.getPath().empty(), "Method calculate() failed");
+
+#pragma mark Timing Test
+    std::vector<Vec2> path = randomWalk(1000000,false);
+    std::vector<Vec2> expect;
+    expect.reserve(path.size());
+
+    cugl::Timestamp start, end;
+    start.mark();
+    recursivePeucker(path,1,0,path.size()-1,expect);
+    end.mark();
+    Uint64 reference = cugl::Timestamp::ellapsedMicros(start,end);
+
+    smoother.set(path);
+    smoother.setEpsilon(1);
+    start.mark();
+    smoother.calculate();
+    end.mark();
+    CUAssertAlwaysLog(smoother.getPath() == expect, "Long path does not match");
+    CULog("Smoothed %zu points to %zu in %llu micros (recursive %llu micros)",
+          path.size(),expect.size(),cugl::Timestamp::ellapsedMicros(start,end),reference);
+
+#pragma mark Complete
+    CULog("PathSmoother tests complete.\n");
+}
+
 #pragma mark -
 #pragma mark Main
 
@@ -9336,6 +9629,8 @@ void cugl::mathUnitTest() {
     //testFrustum();
     testDSP();
     testFilters();
+    testCPUDispatch();
+    testPathSmoother();
     /*
     int i, count = SDL_GetNumAudioDevices(0);
     for (i = 0; i < count; ++i) {
@@ -122,6 +122,16 @@ void testDSP();
 
 void testFilters();
 
+/**
+ * Unit test for the runtime dispatch of the vectorized kernels
+ */
+void testCPUDispatch();
+
+/**
+ * Unit test for the path smoother
+ */
+void testPathSmoother();
+
 /**
  * Master unit test that invokes all others in this module.
  */
@@ -0,0 +1,584 @@
+//
+//  TCUPhysicsTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the physics classes.  It runs small
+//  Box2D scenes without any drawing, and compares the optional simulation
+//  features against the standard ones.  It also reports the time of the
+//  larger scenes, so that it can serve as a benchmark.
+//
+//  These test classes only use asserts and have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#include "TCUPhysicsTest.h"
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cugl/cugl.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+
+using namespace cugl;
+using namespace cugl::physics2;
+
+/** The simulation time step */
+#define STEP_SIZE       (1.0f/60.0f)
+/** The category bits for static obstacles */
+#define GROUND_BITS     0x0001
+/** The category bits for dynamic obstacles */
+#define BODY_BITS       0x0002
+
+#pragma mark -
+#pragma mark Scenes
+/**
+ * Returns a world with a ground box and columns of stacked boxes.
+ *
+ * The columns are spaced so that neighboring boxes do not touch.  The
+ * scene is deterministic, so two worlds built with the same arguments
+ * step identically.
+ *
+ * @param columns   The number of box columns
+ * @param rows      The height of each column
+ * @param sleep     Whether the boxes may fall asleep
+ */
+static std::shared_ptr<ObstacleWorld> buildStacks(int columns, int rows, bool sleep) {
+    float width = columns*1.5f+2;
+    std::shared_ptr<ObstacleWorld> world = ObstacleWorld::alloc(Rect(0,0,width,rows*2.0f+10));
+    b2Filter filter;
+    filter.categoryBits = GROUND_BITS;
+    std::shared_ptr<BoxObstacle> ground = BoxObstacle::alloc(Vec2(width/2,0.5f),Size(width,1));
+    ground->setBodyType(b2_staticBody);
+    ground->setFilterData(filter);
+    world->addObstacle(ground);
+
+    filter.categoryBits = BODY_BITS;
+    for(int ii = 0; ii < columns; ii++) {
+        for(int jj = 0; jj < rows; jj++) {
+            std::shared_ptr<BoxObstacle> box = BoxObstacle::alloc(Vec2(1.75f+1.5f*ii,1.5f+jj*1.05f),Size(1,1));
+            box->setDensity(1.0f);
+            box->setFriction(0.6f);
+            box->setSleepingAllowed(sleep);
+            box->setFilterData(filter);
+            world->addObstacle(box);
+        }
+    }
+    return world;
+}
+
+#pragma mark -
+#pragma mark Contact Buffer
+/**
+ * Unit test for the buffered contact events of an obstacle world
+ *
+ * This test steps a callback world and a buffered world in lockstep, and
+ * checks that the buffer holds the same events that the callbacks receive.
+ * It also reports the time to record a large number of contacts.
+ */
+void cugl::testContactBuffer() {
+    CULog("Running tests for the contact buffer.\n");
+
+    // Reference events from the callbacks
+    std::shared_ptr<ObstacleWorld> called = buildStacks(6,4,true);
+    int counts[3] = {0, 0, 0};
+    float impulses = 0;
+    called->onBeginContact = [&](b2Contact* contact) { counts[0]++; };
+    called->onEndContact = [&](b2Contact* contact) { counts[1]++; };
+    called->afterSolve = [&](b2Contact* contact, const b2ContactImpulse* impulse) {
+        counts[2]++;
+        for(int ii = 0; ii < impulse->count; ii++) {
+            impulses += impulse->normalImpulses[ii];
+        }
+    };
+    called->activateCollisionCallbacks(true);
+
+    // Callbacks are ignored while the buffer is active
+    std::shared_ptr<ObstacleWorld> buffered = buildStacks(6,4,true);
+    int ignored = 0;
+    buffered->onBeginContact = [&](b2Contact* contact) { ignored++; };
+    buffered->activateCollisionCallbacks(true);
+    buffered->activateContactBuffer(true);
+    CUAssertAlwaysLog(buffered->enabledContactBuffer(), "Method activateContactBuffer() failed");
+    buffered->reserveContactEvents(1024);
+    const ContactEventType* storage = buffered->getContactEvents().type.data();
+
+    int total[3] = {0, 0, 0};
+    for(int step = 0; step < 240; step++) {
+        counts[0] = counts[1] = counts[2] = 0;
+        impulses = 0;
+        if (step == 120) {
+            // Knock over a stack so that contacts end
+            called->getObstacles()[1]->setLinearVelocity(Vec2(20,0));
+            buffered->getObstacles()[1]->setLinearVelocity(Vec2(20,0));
+        }
+        called->update(STEP_SIZE);
+        buffered->update(STEP_SIZE);
+
+        const ContactBuffer& events = buffered->getContactEvents();
+        int found[3] = {0, 0, 0};
+        float sum = 0;
+        for(size_t ii = 0; ii < events.size(); ii++) {
+            found[(int)events.type[ii]]++;
+            CUAssertAlwaysLog(events.obstacleA[ii] != nullptr && events.obstacleB[ii] != nullptr,
+                              "Event %zu is missing an obstacle",ii);
+            CUAssertAlwaysLog(events.fixtureA[ii]->GetBody()->GetUserData() == events.obstacleA[ii],
+                              "Event %zu has the wrong fixture",ii);
+            if (events.type[ii] == ContactEventType::SOLVE) {
+                CUAssertAlwaysLog(fabsf(events.normal[ii].length()-1) < 0.001f,
+                                  "Event %zu has a bad normal",ii);
+                CUAssertAlwaysLog(events.impulse[ii] >= 0, "Event %zu has a negative impulse",ii);
+                sum += events.impulse[ii];
+            }
+        }
+        for(int kk = 0; kk < 3; kk++) {
+            CUAssertAlwaysLog(found[kk] == counts[kk], "Step %d has %d events of type %d, not %d",
+                              step,found[kk],kk,counts[kk]);
+            total[kk] += found[kk];
+        }
+        CUAssertAlwaysLog(fabsf(sum-impulses) <= 0.0001f*(1+impulses), "Step %d impulses differ",step);
+    }
+    CUAssertAlwaysLog(ignored == 0, "Callbacks were called while buffering");
+    CUAssertAlwaysLog(total[0] > 0 && total[1] > 0 && total[2] > 0, "Scene is missing event types");
+    CUAssertAlwaysLog(buffered->getContactEvents().type.data() == storage,
+                      "Contact buffer reallocated within its capacity");
+
+    // Masks filter at record time
+    buffered->getObstacles()[2]->setLinearVelocity(Vec2(0,5));
+    buffered->setContactBufferMask(0x0004);
+    buffered->update(STEP_SIZE);
+    CUAssertAlwaysLog(buffered->getContactEvents().empty(), "Method setContactBufferMask() failed");
+    buffered->setContactBufferMask(GROUND_BITS);
+    buffered->update(STEP_SIZE);
+    const ContactBuffer& events = buffered->getContactEvents();
+    CUAssertAlwaysLog(!events.empty(), "Ground contacts were not recorded");
+    for(size_t ii = 0; ii < events.size(); ii++) {
+        Uint16 bits = (events.fixtureA[ii]->GetFilterData().categoryBits |
+                       events.fixtureB[ii]->GetFilterData().categoryBits);
+        CUAssertAlwaysLog(bits & GROUND_BITS, "Event %zu does not touch the ground",ii);
+    }
+    buffered->activateContactBuffer(false);
+    CUAssertAlwaysLog(buffered->getContactEvents().empty(), "Method activateContactBuffer() failed");
+
+    // Time a scene with about 10k contacts per step
+    const int STEPS = 60;
+    for(int pass = 0; pass < 2; pass++) {
+        std::shared_ptr<ObstacleWorld> world = buildStacks(100,100,false);
+        size_t contacts = 0;
+        if (pass == 0) {
+            world->onBeginContact = [&](b2Contact* contact) { contacts++; };
+            world->onEndContact = [&](b2Contact* contact) { contacts++; };
+            world->afterSolve = [&](b2Contact* contact, const b2ContactImpulse* impulse) {
+                contacts++;
+            };
+            world->activateCollisionCallbacks(true);
+        } else {
+            world->activateContactBuffer(true);
+        }
+        for(int step = 0; step < 60; step++) {
+            world->update(STEP_SIZE);
+        }
+
+        contacts = 0;
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int step = 0; step < STEPS; step++) {
+            world->update(STEP_SIZE);
+            contacts += world->getContactEvents().size();
+        }
+        end.mark();
+        CULog("%s: %zu events per step, %llu micros per step",(pass == 0 ? "Callbacks" : "Buffer"),
+              contacts/STEPS,cugl::Timestamp::ellapsedMicros(start,end)/STEPS);
+    }
+
+#pragma mark Complete
+    CULog("Contact buffer tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Projectiles
+/**
+ * Returns a world with a thin wall and a free box behind it.
+ *
+ * The world has no gravity.  The wall is a static box at x = 50 that spans
+ * the height of the world, and the box is a dynamic 2x2 box at (70,5).
+ *
+ * @param wall  Pointer to store the wall obstacle
+ * @param box   Pointer to store the box obstacle
+ */
+static std::shared_ptr<ObstacleWorld> buildRange(std::shared_ptr<BoxObstacle>* wall,
+                                                 std::shared_ptr<BoxObstacle>* box) {
+    std::shared_ptr<ObstacleWorld> world = ObstacleWorld::alloc(Rect(0,0,100,20),Vec2::ZERO);
+    b2Filter filter;
+    filter.categoryBits = GROUND_BITS;
+    *wall = BoxObstacle::alloc(Vec2(50,10),Size(0.1f,20));
+    (*wall)->setBodyType(b2_staticBody);
+    (*wall)->setFilterData(filter);
+    world->addObstacle(*wall);
+
+    filter.categoryBits = BODY_BITS;
+    *box = BoxObstacle::alloc(Vec2(70,5),Size(2,2));
+    (*box)->setDensity(1.0f);
+    (*box)->setFilterData(filter);
+    world->addObstacle(*box);
+    return world;
+}
+
+/**
+ * Unit test for the ray-cast projectile system
+ *
+ * This test checks that fast projectiles stop at thin walls, that masks,
+ * lifespans and gravity are respected, and that hits push dynamic bodies.
+ * It also compares the time of a large volley against bullet bodies.
+ */
+void cugl::testProjectiles() {
+    CULog("Running tests for the projectile system.\n");
+    std::shared_ptr<BoxObstacle> wall, box;
+    std::shared_ptr<ObstacleWorld> world = buildRange(&wall,&box);
+    std::shared_ptr<ProjectileSystem> system = ProjectileSystem::alloc(world,16);
+    CUAssertAlwaysLog(system != nullptr, "Method alloc() failed");
+    CUAssertAlwaysLog(system->size() == 0, "Method alloc() failed");
+
+    // A single step crosses the wall, but must not tunnel through it
+    system->fire(Vec2(10,10),Vec2(3000,0),7);
+    CUAssertAlwaysLog(system->size() == 1, "Method fire() failed");
+    system->update(STEP_SIZE);
+    CUAssertAlwaysLog(system->size() == 0, "Projectile survived a hit");
+    CUAssertAlwaysLog(system->getHits().size() == 1, "Projectile tunneled through the wall");
+    const ProjectileHit& hit = system->getHits()[0];
+    CUAssertAlwaysLog(hit.tag == 7, "Hit has the wrong tag");
+    CUAssertAlwaysLog(hit.obstacle == wall.get(), "Hit has the wrong obstacle");
+    CUAssertAlwaysLog(fabsf(hit.point.x-49.95f) < 0.001f && fabsf(hit.point.y-10) < 0.001f,
+                      "Hit has the wrong point: %s",hit.point.toString().c_str());
+    CUAssertAlwaysLog(hit.normal.equals(Vec2(-1,0),0.0001f),
+                      "Hit has the wrong normal: %s",hit.normal.toString().c_str());
+    CUAssertAlwaysLog(hit.impulse.equals(Vec2(3000*DEFAULT_PROJECTILE_MASS,0)), "Hit has the wrong impulse");
+
+    // Masks pass through the wall, and the hit pushes the box
+    float mass = box->getMass();
+    system->setAppliesImpulses(false);
+    system->fire(Projectile{Vec2(10,5),Vec2(600,0),0.5f,5.0f,BODY_BITS,8});
+    int steps = 0;
+    while (system->size() > 0 && steps < 60) {
+        system->update(STEP_SIZE);
+        steps++;
+    }
+    CUAssertAlwaysLog(system->getHits().size() == 1, "Masked projectile missed the box");
+    CUAssertAlwaysLog(system->getHits()[0].obstacle == box.get(), "Masked projectile hit the wall");
+    CUAssertAlwaysLog(box->getBody()->GetLinearVelocity().x == 0, "Method setAppliesImpulses() failed");
+
+    system->setAppliesImpulses(true);
+    system->fire(Projectile{Vec2(10,5),Vec2(600,0),0.5f,5.0f,BODY_BITS,9});
+    while (system->size() > 0) {
+        system->update(STEP_SIZE);
+    }
+    CUAssertAlwaysLog(system->getHits().size() == 1, "Masked projectile missed the box");
+    float speed = box->getBody()->GetLinearVelocity().x;
+    CUAssertAlwaysLog(fabsf(speed*mass-300) < 0.01f, "Hit transferred %g momentum, not 300",speed*mass);
+
+    // Projectiles expire by age and by leaving the world
+    system->fire(Projectile{Vec2(10,15),Vec2(1,0),1.0f,0.5f,0xFFFF,10});
+    system->fire(Projectile{Vec2(10,19.5f),Vec2(0,60),1.0f,5.0f,0xFFFF,11});
+    system->update(STEP_SIZE);
+    CUAssertAlwaysLog(system->size() == 1, "Projectile did not leave the world");
+    for(int ii = 1; ii < 29; ii++) {
+        system->update(STEP_SIZE);
+    }
+    CUAssertAlwaysLog(system->size() == 1, "Projectile expired too early");
+    system->update(STEP_SIZE);
+    system->update(STEP_SIZE);
+    CUAssertAlwaysLog(system->size() == 0, "Projectile did not expire");
+    CUAssertAlwaysLog(system->getHits().empty(), "Expired projectile reported a hit");
+
+    // Gravity applies at the given scale
+    world = ObstacleWorld::alloc(Rect(0,0,100,100),Vec2(0,-10));
+    system = ProjectileSystem::alloc(world);
+    system->fire(Vec2(10,90),Vec2::ZERO,0);
+    system->fire(Vec2(20,90),Vec2::ZERO,1);
+    system->update(STEP_SIZE);
+    CUAssertAlwaysLog(system->getProjectiles()[0].velocity == Vec2::ZERO, "Gravity applied at scale 0");
+    system->setGravityScale(0.5f);
+    for(int ii = 0; ii < 60; ii++) {
+        system->update(STEP_SIZE);
+    }
+    for(auto it = system->getProjectiles().begin(); it != system->getProjectiles().end(); ++it) {
+        CUAssertAlwaysLog(it->velocity.equals(Vec2(0,-5),0.001f),
+                          "Projectile has the wrong velocity: %s",it->velocity.toString().c_str());
+    }
+
+    // Compare a volley against bullet bodies
+    const int VOLLEY = 20000;
+    const int STEPS  = 30;
+    for(int pass = 0; pass < 2; pass++) {
+        world = buildRange(&wall,&box);
+        system = ProjectileSystem::alloc(world,VOLLEY);
+        b2Filter filter;
+        filter.categoryBits = BODY_BITS;
+        filter.maskBits = GROUND_BITS;
+        for(int ii = 0; ii < VOLLEY; ii++) {
+            Vec2 pos(1+(ii % 40),0.5f+(ii/40)*19.0f/(VOLLEY/40));
+            if (pass == 0) {
+                system->fire(Projectile{pos,Vec2(120,0),0.01f,5.0f,GROUND_BITS,(Uint32)ii});
+            } else {
+                std::shared_ptr<WheelObstacle> shot = WheelObstacle::alloc(pos,0.05f);
+                shot->setBullet(true);
+                shot->setGravityScale(0);
+                shot->setFilterData(filter);
+                shot->setLinearVelocity(Vec2(120,0));
+                world->addObstacle(shot);
+            }
+        }
+
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int step = 0; step < STEPS; step++) {
+            world->update(STEP_SIZE);
+            system->update(STEP_SIZE);
+        }
+        end.mark();
+        if (pass == 0) {
+            CUAssertAlwaysLog(system->size() == 0, "Volley did not finish");
+        }
+        CULog("%s: %d shots, %llu micros per step",(pass == 0 ? "Projectiles" : "Bullets"),
+              VOLLEY,cugl::Timestamp::ellapsedMicros(start,end)/STEPS);
+    }
+
+#pragma mark Complete
+    CULog("Projectile system tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Batched Solver
+/**
+ * Returns a world with a pyramid of boxes on a ground box.
+ *
+ * The boxes never sleep, so that every step exercises the contact solver.
+ *
+ * @param base      The number of boxes in the bottom row
+ * @param batched   Whether to use the batched contact solver
+ */
+static std::shared_ptr<ObstacleWorld> buildPyramid(int base, bool batched) {
+    float width = base*1.2f+4;
+    std::shared_ptr<ObstacleWorld> world = ObstacleWorld::alloc(Rect(0,0,width,base*1.2f+10));
+    world->setBatchedSolver(batched);
+    std::shared_ptr<BoxObstacle> ground = BoxObstacle::alloc(Vec2(width/2,0.5f),Size(width,1));
+    ground->setBodyType(b2_staticBody);
+    world->addObstacle(ground);
+    for(int row = 0; row < base; row++) {
+        float left = 2.5f+row*0.55f;
+        for(int ii = 0; ii < base-row; ii++) {
+            std::shared_ptr<BoxObstacle> box = BoxObstacle::alloc(Vec2(left+ii*1.1f,1.5f+row*1.0f),Size(1,1));
+            box->setDensity(1.0f);
+            box->setFriction(0.6f);
+            box->setSleepingAllowed(false);
+            world->addObstacle(box);
+        }
+    }
+    return world;
+}
+
+/**
+ * Unit test for the batched contact solver
+ *
+ * This test settles the same pyramid with the sequential and the batched
+ * solver, and checks that the boxes end at the same place. The solvers only
+ * differ in contact order, so the positions agree to within a tenth of a box
+ * but are not identical. It also reports the time of a large pyramid.
+ */
+void cugl::testBatchedSolver() {
+    CULog("Running tests for the batched solver.\n");
+    std::shared_ptr<ObstacleWorld> scalar  = buildPyramid(20,false);
+    std::shared_ptr<ObstacleWorld> batched = buildPyramid(20,true);
+    CUAssertAlwaysLog(!scalar->isBatchedSolver(), "Method setBatchedSolver() failed");
+    CUAssertAlwaysLog(batched->isBatchedSolver(), "Method setBatchedSolver() failed");
+    for(int step = 0; step < 300; step++) {
+        scalar->update(STEP_SIZE);
+        batched->update(STEP_SIZE);
+    }
+
+    const std::vector<std::shared_ptr<Obstacle>>& expect = scalar->getObstacles();
+    const std::vector<std::shared_ptr<Obstacle>>& actual = batched->getObstacles();
+    CUAssertAlwaysLog(expect.size() == actual.size(), "Pyramids have different sizes");
+    float worst = 0;
+    for(size_t ii = 1; ii < expect.size(); ii++) {
+        float diff = expect[ii]->getPosition().distance(actual[ii]->getPosition());
+        worst = std::max(worst,diff);
+        CUAssertAlwaysLog(diff < 0.1f, "Box %zu drifted by %g",ii,diff);
+        CUAssertAlwaysLog(fabsf(expect[ii]->getAngle()-actual[ii]->getAngle()) < 0.05f,
+                          "Box %zu turned differently",ii);
+        CUAssertAlwaysLog(actual[ii]->getLinearVelocity().length() < 0.05f, "Box %zu did not settle",ii);
+    }
+    CULog("Pyramid of %zu boxes differs by at most %g",expect.size()-1,worst);
+
+    // Time a large pyramid
+    const int STEPS = 60;
+    for(int pass = 0; pass < 2; pass++) {
+        std::shared_ptr<ObstacleWorld> world = buildPyramid(60,pass == 1);
+        for(int step = 0; step < 30; step++) {
+            world->update(STEP_SIZE);
+        }
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int step = 0; step < STEPS; step++) {
+            world->update(STEP_SIZE);
+        }
+        end.mark();
+        CULog("%s: %zu boxes, %llu micros per step",(pass == 0 ? "Sequential" : "Batched"),
+              world->getObstacles().size()-1,cugl::Timestamp::ellapsedMicros(start,end)/STEPS);
+    }
+
+#pragma mark Complete
+    CULog("Batched solver tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Level of Detail
+/**
+ * Unit test for the simulation level of detail
+ *
+ * This test freezes and thaws a row of boxes as the focus moves, and checks
+ * the per-update budgets, the counts, and that frozen boxes keep their state.
+ * It also compares the time of a large scattered world with and without the
+ * level of detail.
+ */
+void cugl::testLevelOfDetail() {
+    CULog("Running tests for the level of detail.\n");
+
+    // One box per cell, at x = 5+10*ii
+    std::shared_ptr<ObstacleWorld> world = ObstacleWorld::alloc(Rect(0,0,1000,20),Vec2::ZERO);
+    std::vector<std::shared_ptr<BoxObstacle>> boxes;
+    for(int ii = 0; ii < 100; ii++) {
+        std::shared_ptr<BoxObstacle> box = BoxObstacle::alloc(Vec2(5+10*ii,10),Size(1,1));
+        box->setDensity(1.0f);
+        world->addObstacle(box);
+        boxes.push_back(box);
+    }
+    boxes[50]->setLinearVelocity(Vec2(1,0));
+
+    world->setCellSize(10);
+    world->setActiveRange(1);
+    world->setFreezeBudget(10);
+    world->setThawBudget(2);
+    world->setFocus(Vec2(5,10));
+    world->activateLevelOfDetail(true);
+    CUAssertAlwaysLog(world->enabledLevelOfDetail(), "Method activateLevelOfDetail() failed");
+
+    // Boxes more than two cells away freeze, ten tests per update
+    world->update(STEP_SIZE);
+    CUAssertAlwaysLog(world->getFrozenCount() == 7, "Froze %zu boxes, not 7",world->getFrozenCount());
+    CUAssertAlwaysLog(world->getActiveCount() == 93, "Method getActiveCount() failed");
+    for(int ii = 1; ii < 10; ii++) {
+        world->update(STEP_SIZE);
+    }
+    CUAssertAlwaysLog(world->getFrozenCount() == 97, "Froze %zu boxes, not 97",world->getFrozenCount());
+    for(int ii = 0; ii < 100; ii++) {
+        CUAssertAlwaysLog(world->isFrozen(boxes[ii].get()) == (ii > 2), "Box %d has the wrong state",ii);
+        CUAssertAlwaysLog(boxes[ii]->isActive() == (ii <= 2), "Box %d has the wrong activity",ii);
+    }
+    Vec2 frozen = boxes[50]->getPosition();
+    world->update(STEP_SIZE);
+    CUAssertAlwaysLog(boxes[50]->getPosition() == frozen, "Frozen box moved");
+
+    // Thaw two boxes per update within one cell of the new focus
+    world->setFocus(Vec2(505,10));
+    for(int step = 1; step <= 2; step++) {
+        world->update(STEP_SIZE);
+        int thawed = 0;
+        for(int ii = 48; ii <= 52; ii++) {
+            thawed += boxes[ii]->isActive() ? 1 : 0;
+        }
+        CUAssertAlwaysLog(thawed == std::min(2*step,3), "Thawed %d boxes at step %d",thawed,step);
+    }
+    CUAssertAlwaysLog(world->isFrozen(boxes[48].get()) && world->isFrozen(boxes[52].get()),
+                      "Thawed a box out of range");
+    CUAssertAlwaysLog(boxes[50]->getLinearVelocity() == Vec2(1,0), "Thawed box lost its velocity");
+    world->update(STEP_SIZE);
+    CUAssertAlwaysLog(boxes[50]->getX() > frozen.x, "Thawed box did not move");
+
+    // Removing a frozen box forgets it
+    CUAssertAlwaysLog(world->isFrozen(boxes[80].get()), "Box 80 is not frozen");
+    size_t count = world->getFrozenCount();
+    world->removeObstacle(boxes[80].get());
+    CUAssertAlwaysLog(!world->isFrozen(boxes[80].get()), "Method removeObstacle() failed");
+    CUAssertAlwaysLog(world->getFrozenCount() == count-1, "Method removeObstacle() failed");
+    CUAssertAlwaysLog(world->getObstacles().size() == 99, "Method removeObstacle() failed");
+    world->setFocus(Vec2(805,10));
+    for(int ii = 0; ii < 10; ii++) {
+        world->update(STEP_SIZE);
+    }
+    CUAssertAlwaysLog(!boxes[80]->isActive(), "Removed box was thawed");
+
+    // Deactivation thaws everything
+    world->activateLevelOfDetail(false);
+    CUAssertAlwaysLog(world->getFrozenCount() == 0, "Method activateLevelOfDetail() failed");
+    for(int ii = 0; ii < 100; ii++) {
+        CUAssertAlwaysLog(ii == 80 || boxes[ii]->isActive(), "Box %d is still frozen",ii);
+    }
+
+    // Time a scattered world with and without the level of detail
+    const int BODIES = 50000;
+    const int STEPS  = 30;
+    for(int pass = 0; pass < 2; pass++) {
+        world = ObstacleWorld::alloc(Rect(0,0,500,400),Vec2::ZERO);
+        for(int ii = 0; ii < BODIES; ii++) {
+            std::shared_ptr<WheelObstacle> ball = WheelObstacle::alloc(Vec2(1+(ii % 250)*2.0f,1+(ii/250)*2.0f),0.4f);
+            ball->setDensity(1.0f);
+            ball->setSleepingAllowed(false);
+            ball->setLinearVelocity(Vec2((ii % 7)-3.0f,(ii % 5)-2.0f));
+            world->addObstacle(ball);
+        }
+        if (pass == 1) {
+            world->setCellSize(10);
+            world->setActiveRange(2);
+            world->setFreezeBudget(BODIES);
+            world->setFocus(Vec2(250,200));
+            world->activateLevelOfDetail(true);
+        }
+        world->update(STEP_SIZE);
+        world->setFreezeBudget(1024);
+
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int step = 0; step < STEPS; step++) {
+            world->update(STEP_SIZE);
+        }
+        end.mark();
+        CULog("%s: %zu active bodies, %llu micros per step",(pass == 0 ? "Full" : "Level of detail"),
+              world->getActiveCount(),cugl::Timestamp::ellapsedMicros(start,end)/STEPS);
+    }
+
+#pragma mark Complete
+    CULog("Level of detail tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Main
+
+/**
+ * Master unit test that invokes all others in this module.
+ */
+void cugl::physicsUnitTest() {
+    testContactBuffer();
+    testProjectiles();
+    testBatchedSolver();
+    testLevelOfDetail();
+}
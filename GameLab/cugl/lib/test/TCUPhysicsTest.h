@@ -0,0 +1,66 @@
+//
+//  TCUPhysicsTest.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the physics classes.  It runs small
+//  Box2D scenes without any drawing, and compares the optional simulation
+//  features against the standard ones.  It also reports the time of the
+//  larger scenes, so that it can serve as a benchmark.
+//
+//  These test classes only use asserts and have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#ifndef __T_CU_PHYSICS_TEST_H__
+#define __T_CU_PHYSICS_TEST_H__
+
+namespace cugl {
+
+/**
+ * Unit test for the buffered contact events of an obstacle world
+ */
+void testContactBuffer();
+
+/**
+ * Unit test for the ray-cast projectile system
+ */
+void testProjectiles();
+
+/**
+ * Unit test for the batched contact solver
+ */
+void testBatchedSolver();
+
+/**
+ * Unit test for the simulation level of detail
+ */
+void testLevelOfDetail();
+
+/**
+ * Master unit test that invokes all others in this module.
+ */
+void physicsUnitTest();
+
+}
+
+#endif /* __T_CU_PHYSICS_TEST_H__ */
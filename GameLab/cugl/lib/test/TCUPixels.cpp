@@ -0,0 +1,163 @@
+//
+//  TCUPixels.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the pixel helpers shared by the render tests.  They
+//  draw a scene over a cleared screen, read back the pixels before the
+//  buffers are swapped, and compare two images up to a tolerance.
+//
+//  These helpers need the GL context of the test application.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#include "TCUPixels.h"
+#include <cmath>
+
+using namespace cugl;
+
+/** The clear color of the render tests, in bytes */
+static const int CLEAR_BYTES[3] = { 51, 76, 102 };
+
+/** The largest difference from the clear color of an undrawn pixel */
+static const int CLEAR_SLACK = 2;
+
+#pragma mark -
+#pragma mark Read Back
+/**
+ * Returns the size of the current viewport in pixels.
+ *
+ * The render tests use scenes of this size, so that one scene unit is one
+ * pixel and the scenes can be compared exactly.
+ *
+ * @return the size of the current viewport in pixels.
+ */
+Size cugl::viewportSize() {
+    GLint viewport[4];
+    GLState::getViewport(viewport);
+    return Size((float)viewport[2],(float)viewport[3]);
+}
+
+/**
+ * Returns a sprite batch for the render tests.
+ *
+ * The sprite shader draws a debug circle at a fixed position (uHuh in
+ * SpriteShader.frag).  Render caches draw in their own coordinates, so the
+ * circle would not line up, and it is turned off here.
+ *
+ * @return a sprite batch for the render tests.
+ */
+std::shared_ptr<SpriteBatch> cugl::allocBatch() {
+    std::shared_ptr<SpriteBatch> batch = SpriteBatch::alloc();
+    CUAssertAlwaysLog(batch != nullptr, "Method alloc() failed");
+    batch->getShader()->bind();
+    batch->getShader()->setUniform1f("uHuh", 0);
+    batch->getShader()->unbind();
+    return batch;
+}
+
+/**
+ * Draws one frame of the scene over a cleared screen.
+ *
+ * The screen is cleared to (0.2,0.3,0.4).  This method waits for the frame
+ * to finish, so that it can be timed.
+ *
+ * @param scene The scene to draw
+ * @param batch The sprite batch to draw with
+ */
+void cugl::renderFrame(const std::shared_ptr<Scene2>& scene, const std::shared_ptr<SpriteBatch>& batch) {
+    GLState::clearColor(CLEAR_BYTES[0]/255.0f, CLEAR_BYTES[1]/255.0f, CLEAR_BYTES[2]/255.0f, 1.0f);
+    GLState::depthMask(GL_TRUE);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    scene->render(batch);
+    glFinish();
+}
+
+/**
+ * Returns the pixels of the current viewport.
+ *
+ * The pixels are read back before the buffers are swapped, so nothing is
+ * shown.  The pixels are RGBA, one byte per channel.
+ *
+ * @return the pixels of the current viewport.
+ */
+std::vector<Uint8> cugl::readPixels() {
+    GLint viewport[4];
+    GLState::getViewport(viewport);
+    std::vector<Uint8> result((size_t)viewport[2]*(size_t)viewport[3]*4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3],
+                 GL_RGBA, GL_UNSIGNED_BYTE, result.data());
+    return result;
+}
+
+/**
+ * Returns the pixels of the scene drawn over a cleared screen.
+ *
+ * The pixels are read back before the buffers are swapped, so nothing is
+ * shown.  The pixels are RGBA, one byte per channel.
+ *
+ * @param scene The scene to draw
+ * @param batch The sprite batch to draw with
+ *
+ * @return the pixels of the scene drawn over a cleared screen.
+ */
+std::vector<Uint8> cugl::renderPixels(const std::shared_ptr<Scene2>& scene,
+                                      const std::shared_ptr<SpriteBatch>& batch) {
+    renderFrame(scene,batch);
+    return readPixels();
+}
+
+#pragma mark -
+#pragma mark Comparison
+/**
+ * Returns the fraction of drawn pixels that differ between two images.
+ *
+ * A pixel is drawn if it differs from the clear color in either image.
+ * Pixels differ if any color channel differs by more than the tolerance.
+ * The alpha channel of the screen is ignored.  Hence a tolerance of 0 and
+ * a result of 0 means the images agree exactly.
+ *
+ * @param a         The first image
+ * @param b         The second image
+ * @param tolerance The largest channel difference of matching pixels
+ *
+ * @return the fraction of drawn pixels that differ between two images.
+ */
+double cugl::pixelMismatch(const std::vector<Uint8>& a, const std::vector<Uint8>& b, int tolerance) {
+    CUAssertAlwaysLog(a.size() == b.size(), "Images have different sizes");
+    size_t drawn = 0;
+    size_t differ = 0;
+    for(size_t ii = 0; ii < a.size(); ii += 4) {
+        bool ink = false;
+        bool miss = false;
+        for(int jj = 0; jj < 3; jj++) {
+            ink  = ink  || std::abs(a[ii+jj]-CLEAR_BYTES[jj]) > CLEAR_SLACK
+                        || std::abs(b[ii+jj]-CLEAR_BYTES[jj]) > CLEAR_SLACK;
+            miss = miss || std::abs((int)a[ii+jj]-(int)b[ii+jj]) > tolerance;
+        }
+        // A differing pixel is always drawn, even when both are near the clear color
+        drawn  += (ink || miss) ? 1 : 0;
+        differ += miss ? 1 : 0;
+    }
+    return drawn == 0 ? 0 : (double)differ/drawn;
+}
@@ -0,0 +1,115 @@
+//
+//  TCUPixels.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the pixel helpers shared by the render tests.  They
+//  draw a scene over a cleared screen, read back the pixels before the
+//  buffers are swapped, and compare two images up to a tolerance.
+//
+//  These helpers need the GL context of the test application.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#ifndef __T_CU_PIXELS_H__
+#define __T_CU_PIXELS_H__
+#include <memory>
+#include <vector>
+#include <cugl/cugl.h>
+
+namespace cugl {
+
+/**
+ * Returns the size of the current viewport in pixels.
+ *
+ * The render tests use scenes of this size, so that one scene unit is one
+ * pixel and the scenes can be compared exactly.
+ *
+ * @return the size of the current viewport in pixels.
+ */
+Size viewportSize();
+
+/**
+ * Returns a sprite batch for the render tests.
+ *
+ * The sprite shader draws a debug circle at a fixed position (uHuh in
+ * SpriteShader.frag).  Render caches draw in their own coordinates, so the
+ * circle would not line up, and it is turned off here.
+ *
+ * @return a sprite batch for the render tests.
+ */
+std::shared_ptr<SpriteBatch> allocBatch();
+
+/**
+ * Draws one frame of the scene over a cleared screen.
+ *
+ * The screen is cleared to (0.2,0.3,0.4).  This method waits for the frame
+ * to finish, so that it can be timed.
+ *
+ * @param scene The scene to draw
+ * @param batch The sprite batch to draw with
+ */
+void renderFrame(const std::shared_ptr<Scene2>& scene, const std::shared_ptr<SpriteBatch>& batch);
+
+/**
+ * Returns the pixels of the current viewport.
+ *
+ * The pixels are read back before the buffers are swapped, so nothing is
+ * shown.  The pixels are RGBA, one byte per channel.
+ *
+ * @return the pixels of the current viewport.
+ */
+std::vector<Uint8> readPixels();
+
+/**
+ * Returns the pixels of the scene drawn over a cleared screen.
+ *
+ * The pixels are read back before the buffers are swapped, so nothing is
+ * shown.  The pixels are RGBA, one byte per channel.
+ *
+ * @param scene The scene to draw
+ * @param batch The sprite batch to draw with
+ *
+ * @return the pixels of the scene drawn over a cleared screen.
+ */
+std::vector<Uint8> renderPixels(const std::shared_ptr<Scene2>& scene,
+                                const std::shared_ptr<SpriteBatch>& batch);
+
+/**
+ * Returns the fraction of drawn pixels that differ between two images.
+ *
+ * A pixel is drawn if it differs from the clear color in either image.
+ * Pixels differ if any color channel differs by more than the tolerance.
+ * The alpha channel of the screen is ignored.  Hence a tolerance of 0 and
+ * a result of 0 means the images agree exactly.
+ *
+ * @param a         The first image
+ * @param b         The second image
+ * @param tolerance The largest channel difference of matching pixels
+ *
+ * @return the fraction of drawn pixels that differ between two images.
+ */
+double pixelMismatch(const std::vector<Uint8>& a, const std::vector<Uint8>& b, int tolerance);
+
+}
+
+#endif /* __T_CU_PIXELS_H__ */
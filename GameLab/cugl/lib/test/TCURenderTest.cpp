@@ -0,0 +1,623 @@
+//
+//  TCURenderTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the render classes.  It checks the
+//  shadow that GLState keeps of the OpenGL state against the driver, counts
+//  the driver calls of a sample scene with and without the shadow, and checks
+//  that the shader cache restores, rejects, and replaces program binaries.
+//  It also compares distance field text with coverage text.
+//
+//  These test classes only use asserts.  They need the GL context of the
+//  test application, but read back their state before the buffers are
+//  swapped, so they have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#include "TCURenderTest.h"
+#include "TCUPixels.h"
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cugl/cugl.h>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+#pragma mark -
+#pragma mark Helpers
+/**
+ * Asserts the number of calls issued and skipped since the last reset
+ *
+ * @param issued    The expected number of calls passed to OpenGL
+ * @param skipped   The expected number of calls skipped
+ * @param method    The method under test, for the error message
+ */
+static void checkCalls(Uint64 issued, Uint64 skipped, const char* method) {
+    CUAssertAlwaysLog(GLState::getIssuedCount() == issued && GLState::getSkippedCount() == skipped,
+                      "Method %s() issued %llu and skipped %llu calls, not %llu and %llu", method,
+                      (unsigned long long)GLState::getIssuedCount(),
+                      (unsigned long long)GLState::getSkippedCount(),
+                      (unsigned long long)issued, (unsigned long long)skipped);
+}
+
+/**
+ * Returns the integer value of an OpenGL parameter
+ *
+ * @param pname The parameter to query
+ *
+ * @return the integer value of an OpenGL parameter
+ */
+static GLint queryInt(GLenum pname) {
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    return value;
+}
+
+/**
+ * Returns the buffer bound to an indexed uniform binding point
+ *
+ * @param index The binding point
+ *
+ * @return the buffer bound to an indexed uniform binding point
+ */
+static GLuint queryUniformPoint(GLuint index) {
+    GLint value = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &value);
+    return (GLuint)value;
+}
+
+#pragma mark -
+#pragma mark State Shadow
+/**
+ * Unit test for the OpenGL state shadow
+ *
+ * This test checks that every tracked call reaches OpenGL exactly when it
+ * changes the state, and that the counters agree.  It checks that deleted
+ * objects are forgotten, that verify() notices changes made behind the
+ * back of GLState, and that verify mode repairs them.
+ *
+ * This test requires the GL context of the test application.  The
+ * verify() checks log the differences that they find, so the errors in
+ * the log of this test are expected.
+ */
+void cugl::testGLState() {
+    CULog("Running tests for GLState.\n");
+    GLState::setVerify(false);
+    GLState::invalidate();
+    GLState::resetCounters();
+    checkCalls(0, 0, "resetCounters");
+
+    // Capabilities
+    GLState::enable(GL_BLEND);
+    GLState::enable(GL_BLEND);
+    GLState::enable(GL_BLEND);
+    checkCalls(1, 2, "enable");
+    CUAssertAlwaysLog(glIsEnabled(GL_BLEND), "Method enable() failed");
+    GLState::disable(GL_SCISSOR_TEST);
+    GLState::disable(GL_SCISSOR_TEST);
+    checkCalls(2, 3, "disable");
+    CUAssertAlwaysLog(!glIsEnabled(GL_SCISSOR_TEST), "Method disable() failed");
+
+    // Blend functions
+    GLState::resetCounters();
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    checkCalls(1, 1, "blendFunc");
+    GLState::blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    checkCalls(2, 1, "blendFuncSeparate");
+    CUAssertAlwaysLog(queryInt(GL_BLEND_SRC_ALPHA) == GL_ONE, "Method blendFuncSeparate() failed");
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    checkCalls(3, 1, "blendFunc");
+    CUAssertAlwaysLog(queryInt(GL_BLEND_SRC_ALPHA) == GL_SRC_ALPHA, "Method blendFunc() failed");
+    GLState::blendEquation(GL_FUNC_ADD);
+    GLState::blendEquation(GL_FUNC_ADD);
+    checkCalls(4, 2, "blendEquation");
+
+    // Depth, viewport, and clear color
+    GLState::resetCounters();
+    GLState::depthFunc(GL_LEQUAL);
+    GLState::depthFunc(GL_LEQUAL);
+    GLState::depthMask(GL_FALSE);
+    GLState::depthMask(GL_FALSE);
+    checkCalls(2, 2, "depthMask");
+    GLint viewport[4];
+    GLState::getViewport(viewport);
+    GLState::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    checkCalls(2, 3, "viewport");
+    GLState::viewport(viewport[0], viewport[1], viewport[2]/2, viewport[3]/2);
+    GLState::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    checkCalls(4, 3, "viewport");
+    GLState::clearColor(0.2f, 0.3f, 0.4f, 1.0f);
+    GLState::clearColor(0.2f, 0.3f, 0.4f, 1.0f);
+    checkCalls(5, 4, "clearColor");
+    CUAssertAlwaysLog(GLState::verify(), "Method verify() failed");
+
+    // Texture units
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    GLState::resetCounters();
+    GLState::activeTexture(GL_TEXTURE1);
+    GLState::bindTexture(GL_TEXTURE_2D, textures[0]);
+    GLState::bindTexture(GL_TEXTURE_2D, textures[0]);
+    GLState::activeTexture(GL_TEXTURE0);
+    GLState::bindTexture(GL_TEXTURE_2D, textures[1]);
+    GLState::activeTexture(GL_TEXTURE0);
+    checkCalls(4, 2, "bindTexture");
+    CUAssertAlwaysLog(GLState::getBoundTexture(GL_TEXTURE1) == textures[0], "Method getBoundTexture() failed");
+    CUAssertAlwaysLog(GLState::getBoundTexture(GL_TEXTURE0) == textures[1], "Method getBoundTexture() failed");
+    CUAssertAlwaysLog(GLState::verify(), "Method verify() failed");
+    GLState::deleteTexture(textures[0]);
+    GLState::deleteTexture(textures[1]);
+    CUAssertAlwaysLog(GLState::getBoundTexture(GL_TEXTURE1) == 0, "Method deleteTexture() failed");
+    CUAssertAlwaysLog(GLState::getBoundTexture(GL_TEXTURE0) == 0, "Method deleteTexture() failed");
+    CUAssertAlwaysLog(GLState::verify(), "Method deleteTexture() failed");
+
+    // Buffers and uniform binding points
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, buffers[1]);
+    glBufferData(GL_UNIFORM_BUFFER, 1024, nullptr, GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, buffers[2]);
+    glBufferData(GL_UNIFORM_BUFFER, 1024, nullptr, GL_STATIC_DRAW);
+    GLState::resetCounters();
+    GLState::bindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    checkCalls(1, 1, "bindBuffer");
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, 3, buffers[1]);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, 3, buffers[1]);
+    checkCalls(2, 2, "bindBufferBase");
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, 3, buffers[1], 0, 256);
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, 3, buffers[1], 0, 256);
+    checkCalls(3, 3, "bindBufferRange");
+    CUAssertAlwaysLog(GLState::getUniformBinding(3) == buffers[1], "Method getUniformBinding() failed");
+    CUAssertAlwaysLog(GLState::getBoundBuffer(GL_UNIFORM_BUFFER) == buffers[1], "Method bindBufferRange() failed");
+    CUAssertAlwaysLog(GLState::verify(), "Method verify() failed");
+    GLState::deleteBuffer(buffers[0]);
+    CUAssertAlwaysLog(GLState::getBoundBuffer(GL_ARRAY_BUFFER) == 0, "Method deleteBuffer() failed");
+    CUAssertAlwaysLog(GLState::verify(), "Method deleteBuffer() failed");
+
+    // Changes behind the back of GLState
+    glDisable(GL_BLEND);
+    CUAssertAlwaysLog(!GLState::verify(), "Method verify() missed a capability");
+    GLState::resetCounters();
+    GLState::enable(GL_BLEND);
+    checkCalls(0, 1, "enable");
+    CUAssertAlwaysLog(!glIsEnabled(GL_BLEND), "Method enable() did not trust the shadow");
+    GLState::setVerify(true);
+    CUAssertAlwaysLog(GLState::isVerify(), "Method setVerify() failed");
+    GLState::enable(GL_BLEND);
+    checkCalls(1, 1, "enable");
+    CUAssertAlwaysLog(glIsEnabled(GL_BLEND), "Verify mode did not repair a capability");
+    CUAssertAlwaysLog(GLState::verify(), "Verify mode did not repair a capability");
+
+    glBlendFunc(GL_ONE, GL_ZERO);
+    CUAssertAlwaysLog(!GLState::verify(), "Method verify() missed a blend function");
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    CUAssertAlwaysLog(queryInt(GL_BLEND_SRC_RGB) == GL_SRC_ALPHA, "Verify mode did not repair a blend function");
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, 3, buffers[2]);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffers[1]);
+    CUAssertAlwaysLog(!GLState::verify(), "Method verify() missed a uniform binding point");
+    GLState::bindBufferRange(GL_UNIFORM_BUFFER, 3, buffers[1], 0, 256);
+    CUAssertAlwaysLog(queryUniformPoint(3) == buffers[1], "Verify mode did not repair a uniform binding point");
+    CUAssertAlwaysLog(GLState::verify(), "Verify mode did not repair a uniform binding point");
+    GLState::setVerify(false);
+
+    // Invalidation forgets everything
+    glBindBufferBase(GL_UNIFORM_BUFFER, 3, buffers[2]);
+    glDepthMask(GL_TRUE);
+    GLState::invalidate();
+    CUAssertAlwaysLog(GLState::verify(), "Method invalidate() failed");
+    GLState::resetCounters();
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, 3, buffers[1]);
+    GLState::depthMask(GL_FALSE);
+    checkCalls(2, 0, "invalidate");
+    CUAssertAlwaysLog(queryUniformPoint(3) == buffers[1], "Method invalidate() failed");
+
+    GLState::deleteBuffer(buffers[1]);
+    GLState::deleteBuffer(buffers[2]);
+    CUAssertAlwaysLog(GLState::getUniformBinding(3) == 0, "Method deleteBuffer() failed");
+    CUAssertAlwaysLog(GLState::verify(), "Method deleteBuffer() failed");
+    GLState::depthMask(GL_TRUE);
+    GLState::resetCounters();
+}
+
+#pragma mark -
+#pragma mark Call Count
+/**
+ * Returns a sample scene that exercises most of the render state
+ *
+ * The scene has sprites that alternate between two textures, translucent
+ * tiles and outlines, a scissored panel, and a render cached panel.
+ *
+ * @param size  The scene size
+ *
+ * @return a sample scene that exercises most of the render state
+ */
+static std::shared_ptr<Scene2> buildSampleScene(const Size size) {
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    CUAssertAlwaysLog(scene != nullptr, "Method alloc() failed");
+
+    Uint8 check[] = { 255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 255, 255 };
+    Uint8 faded[] = { 255, 255, 0, 128, 0, 255, 255, 128, 255, 0, 255, 128, 0, 0, 0, 128 };
+    std::shared_ptr<Texture> textures[2];
+    textures[0] = Texture::allocWithData(check,2,2);
+    textures[1] = Texture::allocWithData(faded,2,2);
+    for(int ii = 0; ii < 40; ii++) {
+        std::shared_ptr<PolygonNode> sprite = PolygonNode::allocWithTexture(textures[ii % 2],Rect(0,0,32,32));
+        sprite->setPosition(Vec2(20+(ii % 10)*60, 40+(ii / 10)*50));
+        sprite->setAngle(ii*0.1f);
+        scene->addChild(sprite);
+    }
+
+    for(int pp = 0; pp < 2; pp++) {
+        std::shared_ptr<SceneNode> panel = SceneNode::allocWithBounds(Rect(40+pp*300,260,260,180));
+        for(int ii = 0; ii < 12; ii++) {
+            Vec2 pos((ii % 4)*65, (ii / 4)*60);
+            std::shared_ptr<PolygonNode> tile = PolygonNode::alloc(Rect(0,0,63,58));
+            tile->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+            tile->setPosition(pos);
+            tile->setColor(Color4((ii*37) % 256, (ii*91) % 256, (ii*53) % 256, 128+(ii*29) % 128));
+            panel->addChild(tile);
+
+            std::shared_ptr<PathNode> line = PathNode::allocWithRect(Rect(0,0,59,54), 1.5f,
+                                                                     poly2::Joint::MITRE);
+            line->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+            line->setPosition(pos+Vec2(2,2));
+            line->setColor(Color4(255,255,255,192));
+            panel->addChild(line);
+        }
+        if (pp == 0) {
+            panel->setScissor();
+        } else {
+            panel->setRenderCached(true);
+        }
+        scene->addChild(panel);
+    }
+    return scene;
+}
+
+/**
+ * Unit test for the driver calls of a sample scene
+ *
+ * This test draws a sample scene and counts the state changes that reach
+ * OpenGL against the ones that were requested.  The requested changes are
+ * the calls that would reach OpenGL without the shadow.  It also draws the
+ * scene in verify mode, and checks that the shadow never disagreed with
+ * OpenGL, with or without damage tracking.
+ *
+ * This test requires the GL context of the test application.
+ */
+void cugl::testGLCallCount() {
+    CULog("Running tests for the GL call count.\n");
+    std::shared_ptr<SpriteBatch> batch = SpriteBatch::alloc();
+    CUAssertAlwaysLog(batch != nullptr, "Method alloc() failed");
+    std::shared_ptr<Scene2> scene = buildSampleScene(viewportSize());
+
+    // The first frames fill the render cache and settle the state
+    GLState::setVerify(false);
+    renderFrame(scene,batch);
+    renderFrame(scene,batch);
+
+    GLState::resetCounters();
+    renderFrame(scene,batch);
+    Uint64 issued  = GLState::getIssuedCount();
+    Uint64 skipped = GLState::getSkippedCount();
+    Uint64 requested = issued+skipped;
+    CUAssertAlwaysLog(issued > 0 && skipped > 0, "The sample scene skipped no calls");
+    CULog("Sample scene requested %llu state changes and issued %llu (%.1f%% skipped)",
+          (unsigned long long)requested, (unsigned long long)issued, 100.0*skipped/requested);
+
+    // A shadow that agrees with OpenGL issues the same calls in verify mode
+    GLState::setVerify(true);
+    GLState::resetCounters();
+    renderFrame(scene,batch);
+    CUAssertAlwaysLog(GLState::getIssuedCount() == issued && GLState::getSkippedCount() == skipped,
+                      "The shadow disagreed with OpenGL in verify mode");
+    CUAssertAlwaysLog(GLState::verify(), "The shadow disagreed with OpenGL after a frame");
+
+    // Redrawing the render cache and the damaged regions
+    scene->getChild(41)->getChild(0)->setColor(Color4::RED);
+    GLState::resetCounters();
+    renderFrame(scene,batch);
+    CUAssertAlwaysLog(GLState::verify(), "The shadow disagreed with OpenGL after a cache redraw");
+    scene->setDamageTracking(true);
+    for(int ii = 0; ii < 3; ii++) {
+        scene->getChild(ii)->setPosition(scene->getChild(ii)->getPosition()+Vec2(5,0));
+        renderFrame(scene,batch);
+        CUAssertAlwaysLog(GLState::verify(), "The shadow disagreed with OpenGL with damage tracking");
+    }
+    scene->setDamageTracking(false);
+    GLState::setVerify(false);
+    GLState::resetCounters();
+}
+
+#pragma mark -
+#pragma mark Shader Cache
+/** A minimal vertex shader for the shader cache test */
+static const std::string cacheTestVert = R"(
+in vec2 aPosition;
+void main(void) {
+    gl_Position = vec4(aPosition,0.0,1.0);
+}
+)";
+
+/** A minimal fragment shader for the shader cache test */
+static const std::string cacheTestFrag = R"(
+#ifdef CUGLES
+precision mediump float;
+#endif
+out vec4 frag_color;
+void main(void) {
+    frag_color = vec4(1.0,0.5,0.25,1.0);
+}
+)";
+
+/**
+ * Returns the shader cache files in the given directory
+ *
+ * @param directory The cache directory
+ *
+ * @return the shader cache files in the given directory
+ */
+static std::vector<std::string> listCacheFiles(const std::string& directory) {
+    std::vector<std::string> result;
+    std::vector<std::string> files = filetool::dir_contents(directory);
+    for(auto it = files.begin(); it != files.end(); ++it) {
+        std::string name = filetool::base_name(*it);
+        if (strtool::starts_with(name,"shader_") && strtool::ends_with(name,".bin")) {
+            result.push_back(*it);
+        }
+    }
+    return result;
+}
+
+/**
+ * Overwrites the program binary in a cache file, keeping its header
+ *
+ * The header still matches the cache key, so the cache hands the damaged
+ * binary to the driver, which must reject it.
+ *
+ * @param path  The cache file
+ */
+static void corruptCacheFile(const std::string& path) {
+    const Sint64 header = 24;
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "r+b");
+    CUAssertAlwaysLog(file != nullptr, "Could not open cache file '%s'", path.c_str());
+    Sint64 size = SDL_RWsize(file);
+    CUAssertAlwaysLog(size > header, "Cache file '%s' has no binary", path.c_str());
+    std::vector<Uint8> noise((size_t)(size-header));
+    for(size_t ii = 0; ii < noise.size(); ii++) {
+        noise[ii] = (Uint8)(ii*131+7);
+    }
+    SDL_RWseek(file, header, RW_SEEK_SET);
+    SDL_RWwrite(file, noise.data(), 1, noise.size());
+    SDL_RWclose(file);
+}
+
+/**
+ * Unit test for the shader program cache
+ *
+ * This test compiles a shader with an empty cache (a miss), restores it on
+ * a restart (a hit), and then damages the cached binary so the driver
+ * rejects it.  A rejected binary must fall back to compilation, and be
+ * replaced in the cache.  The cache runs in its own directory, which is
+ * cleared at the end of the test.
+ *
+ * This test requires the GL context of the test application.  It is skipped
+ * if the application has already started the cache, or if the driver does
+ * not support program binaries.
+ */
+void cugl::testShaderCache() {
+    CULog("Running tests for ShaderCache");
+    if (ShaderCache::get() != nullptr) {
+        CULog("Skipping ShaderCache tests as the cache is already running");
+        return;
+    }
+
+    std::string directory = filetool::join_path({Application::get()->getSaveDirectory(),"shadertest"});
+    if (!filetool::is_dir(directory)) {
+        CUAssertAlwaysLog(filetool::dir_create(directory), "Could not create '%s'", directory.c_str());
+    }
+    std::string vsource = SHADER(cacheTestVert);
+    std::string fsource = SHADER(cacheTestFrag);
+
+    CUAssertAlwaysLog(ShaderCache::start(directory), "Method start() failed");
+    ShaderCache* cache = ShaderCache::get();
+    cache->clear();
+    if (!cache->isSupported()) {
+        CULog("Skipping ShaderCache tests as program binaries are not supported");
+        ShaderCache::stop();
+        return;
+    }
+
+    // An empty cache compiles and stores the program
+    std::shared_ptr<Shader> shader = Shader::alloc(vsource,fsource);
+    CUAssertAlwaysLog(shader != nullptr, "Shader failed to compile");
+    CUAssertAlwaysLog(cache->getMisses() == 1 && cache->getHits() == 0,
+                      "Cold compile had %u hits and %u misses", cache->getHits(), cache->getMisses());
+    std::vector<std::string> files = listCacheFiles(directory);
+    CUAssertAlwaysLog(files.size() == 1, "Cold compile left %zu cache files", files.size());
+    shader = nullptr;
+
+    // A restart restores the program without compiling
+    ShaderCache::stop();
+    ShaderCache::start(directory);
+    cache = ShaderCache::get();
+    shader = Shader::alloc(vsource,fsource);
+    CUAssertAlwaysLog(shader != nullptr, "Shader failed to restore");
+    CUAssertAlwaysLog(cache->getHits() == 1 && cache->getMisses() == 0,
+                      "Warm compile had %u hits and %u misses", cache->getHits(), cache->getMisses());
+    CUAssertAlwaysLog(shader->getAttributeLocation("aPosition") >= 0,
+                      "Restored program is missing its attribute");
+    shader = nullptr;
+
+    // A rejected binary falls back to compilation and is replaced
+    corruptCacheFile(files[0]);
+    ShaderCache::stop();
+    ShaderCache::start(directory);
+    cache = ShaderCache::get();
+    shader = Shader::alloc(vsource,fsource);
+    CUAssertAlwaysLog(shader != nullptr, "Shader failed to compile after a rejected binary");
+    CUAssertAlwaysLog(cache->getMisses() == 1 && cache->getHits() == 0,
+                      "Rejected binary had %u hits and %u misses", cache->getHits(), cache->getMisses());
+    CUAssertAlwaysLog(shader->getAttributeLocation("aPosition") >= 0,
+                      "Recompiled program is missing its attribute");
+    shader = nullptr;
+
+    ShaderCache::stop();
+    ShaderCache::start(directory);
+    cache = ShaderCache::get();
+    shader = Shader::alloc(vsource,fsource);
+    CUAssertAlwaysLog(shader != nullptr && cache->getHits() == 1 && cache->getMisses() == 0,
+                      "Replaced binary had %u hits and %u misses", cache->getHits(), cache->getMisses());
+    shader = nullptr;
+
+    cache->clear();
+    ShaderCache::stop();
+}
+
+#pragma mark -
+#pragma mark Distance Fields
+/**
+ * Returns a scene with a line of text in the given font
+ *
+ * The text is white and centered in the scene.
+ *
+ * @param size  The scene size
+ * @param font  The font of the text
+ *
+ * @return a scene with a line of text in the given font
+ */
+static std::shared_ptr<Scene2> buildTextScene(const Size size, const std::shared_ptr<Font>& font) {
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    std::shared_ptr<Label> label = Label::alloc(std::string("Sphinx of black quartz, judge my vow"),font);
+    CUAssertAlwaysLog(label != nullptr, "Method alloc() failed");
+    label->setForeground(Color4::WHITE);
+    label->setAnchor(Vec2::ANCHOR_CENTER);
+    label->setPosition(size/2);
+    scene->addChild(label);
+    return scene;
+}
+
+/**
+ * Returns the size in bytes of the atlas of a font
+ *
+ * @param font  The font with an atlas
+ *
+ * @return the size in bytes of the atlas of a font
+ */
+static size_t atlasBytes(const std::shared_ptr<Font>& font) {
+    const std::shared_ptr<Texture>& atlas = font->getAtlas();
+    return atlas == nullptr ? 0 : (size_t)atlas->getWidth()*atlas->getHeight()*4;
+}
+
+/**
+ * Unit test for distance field font atlases
+ *
+ * This test draws the same text with a coverage atlas and a distance field
+ * atlas at their reference size, and checks that they cover the same pixels
+ * up to antialiasing at the edges.  It checks that the outline and glow
+ * change the distance field text only, and that turning them off restores
+ * it exactly.  It also logs the atlas memory of coverage fonts for a set of
+ * sizes against that of a single distance field font.
+ *
+ * This test requires the GL context of the test application.
+ *
+ * @param path  The path to a TrueType font file
+ */
+void cugl::testDistanceField(const std::string path) {
+    CULog("Running tests for distance field fonts.\n");
+    const int SIZE = 32;
+    const int EDGE = 64;
+    const double TOLERANCE = 0.05;
+    std::shared_ptr<Font> coverage = Font::alloc(path,SIZE);
+    CUAssertAlwaysLog(coverage != nullptr, "Could not load %s",path.c_str());
+    CUAssertAlwaysLog(coverage->buildAtlas(), "Could not build the coverage atlas");
+    std::shared_ptr<Font> field = Font::alloc(path,SIZE);
+    field->setDistanceField(true);
+    CUAssertAlwaysLog(field->isDistanceField(), "Method setDistanceField() failed");
+    CUAssertAlwaysLog(field->buildAtlas(), "Could not build the distance field atlas");
+
+#pragma mark Parity Test
+    Size size = viewportSize();
+    std::shared_ptr<SpriteBatch> batch = allocBatch();
+    std::shared_ptr<Scene2> plain = buildTextScene(size,coverage);
+    std::shared_ptr<Scene2> sdf   = buildTextScene(size,field);
+    std::vector<Uint8> expected = renderPixels(plain,batch);
+    std::vector<Uint8> actual = renderPixels(sdf,batch);
+    double mismatch = pixelMismatch(expected,actual,EDGE);
+    CUAssertAlwaysLog(mismatch <= TOLERANCE, "Distance field text differs in %.2f%% of pixels",100*mismatch);
+    CULog("Distance field text differs in %.2f%% of pixels at 1x",100*mismatch);
+
+#pragma mark Effect Test
+    batch->setDistanceOutline(0.25f,Color4f::RED);
+    CUAssertAlwaysLog(batch->getDistanceOutline() == 0.25f, "Method setDistanceOutline() failed");
+    std::vector<Uint8> outlined = renderPixels(sdf,batch);
+    CUAssertAlwaysLog(pixelMismatch(actual,outlined,EDGE) > TOLERANCE, "The outline was not drawn");
+    CUAssertAlwaysLog(pixelMismatch(expected,renderPixels(plain,batch),0) == 0,
+                      "The outline changed coverage text");
+    batch->setDistanceOutline(0,Color4f::RED);
+    CUAssertAlwaysLog(pixelMismatch(actual,renderPixels(sdf,batch),0) == 0,
+                      "The outline was not turned off");
+
+    batch->setDistanceGlow(0.4f,Color4f::YELLOW);
+    CUAssertAlwaysLog(batch->getDistanceGlow() == 0.4f, "Method setDistanceGlow() failed");
+    std::vector<Uint8> glowing = renderPixels(sdf,batch);
+    CUAssertAlwaysLog(pixelMismatch(actual,glowing,EDGE) > TOLERANCE, "The glow was not drawn");
+    CUAssertAlwaysLog(pixelMismatch(outlined,glowing,EDGE) > TOLERANCE, "The glow matches the outline");
+    CUAssertAlwaysLog(pixelMismatch(expected,renderPixels(plain,batch),0) == 0,
+                      "The glow changed coverage text");
+    batch->setDistanceGlow(0,Color4f::YELLOW);
+    CUAssertAlwaysLog(pixelMismatch(actual,renderPixels(sdf,batch),0) == 0,
+                      "The glow was not turned off");
+
+#pragma mark Memory Test
+    const int sizes[] = { 16, 24, 32, 48, 64 };
+    size_t total = 0;
+    for(int ii = 0; ii < 5; ii++) {
+        std::shared_ptr<Font> font = Font::alloc(path,sizes[ii]);
+        CUAssertAlwaysLog(font != nullptr && font->buildAtlas(), "Could not build the atlas at %d",sizes[ii]);
+        total += atlasBytes(font);
+    }
+    CULog("Coverage atlases for 5 sizes use %zu bytes, one distance field atlas uses %zu bytes",
+          total,atlasBytes(field));
+
+#pragma mark Complete
+    CULog("Distance field tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Master Test
+/**
+ * Master unit test that invokes all others in this module.
+ *
+ * These unit tests require the GL context of the test application.
+ */
+void cugl::renderUnitTest() {
+    testGLState();
+    testGLCallCount();
+    testShaderCache();
+    testDistanceField("fonts/Lato-Regular.ttf");
+}
@@ -0,0 +1,72 @@
+//
+//  TCURenderTest.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the render classes.  It checks the
+//  shadow that GLState keeps of the OpenGL state against the driver, counts
+//  the driver calls of a sample scene with and without the shadow, and checks
+//  that the shader cache restores, rejects, and replaces program binaries.
+//  It also compares distance field text with coverage text.
+//
+//  These test classes only use asserts.  They need the GL context of the
+//  test application, but read back their state before the buffers are
+//  swapped, so they have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#ifndef __T_CU_RENDER_TEST_H__
+#define __T_CU_RENDER_TEST_H__
+#include <string>
+
+namespace cugl {
+
+/**
+ * Unit test for the OpenGL state shadow
+ */
+void testGLState();
+
+/**
+ * Unit test for the driver calls of a sample scene
+ */
+void testGLCallCount();
+
+/**
+ * Unit test for the shader program cache
+ */
+void testShaderCache();
+
+/**
+ * Unit test for distance field font atlases
+ *
+ * @param path  The path to a TrueType font file
+ */
+void testDistanceField(const std::string path);
+
+/**
+ * Master unit test that invokes all others in this module.
+ */
+void renderUnitTest();
+
+}
+
+#endif /* __T_CU_RENDER_TEST_H__ */
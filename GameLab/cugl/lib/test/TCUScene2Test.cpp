@@ -0,0 +1,1248 @@
+//
+//  TCUScene2Test.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the scene graph classes.  Most tests
+//  build scene graphs without drawing them, and check the book-keeping that
+//  the nodes do on the CPU.  The render tests draw scenes in more than one
+//  way and compare the pixels.  They also report the time of the larger
+//  graphs, so that they can serve as a benchmark.
+//
+//  These test classes only use asserts.  The render tests need the GL
+//  context of the test application, but read back their pixels before the
+//  buffers are swapped, so they have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#include "TCUScene2Test.h"
+#include "TCUPixels.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cmath>
+#include <cugl/cugl.h>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+#pragma mark -
+#pragma mark Child Index
+/**
+ * Unit test for the child index and path look-up of a scene node
+ *
+ * This test checks that an indexed node finds its children by name and tag
+ * after every kind of change to the children, and that path look-ups track
+ * renames and removals. It also compares the time of indexed and linear
+ * look-ups on a wide node.
+ */
+void cugl::testChildIndex() {
+    CULog("Running tests for the child index.\n");
+
+#pragma mark Name and Tag Test
+    std::shared_ptr<SceneNode> root = SceneNode::alloc();
+    root->setChildIndexed(true);
+    CUAssertAlwaysLog(root->isChildIndexed(), "Method setChildIndexed() failed");
+    std::vector<std::shared_ptr<SceneNode>> items;
+    for(int ii = 0; ii < 100; ii++) {
+        std::shared_ptr<SceneNode> node = SceneNode::alloc();
+        root->addChildWithName(node,"item"+std::to_string(ii));
+        node->setTag(ii+1);
+        items.push_back(node);
+    }
+    for(int ii = 0; ii < 100; ii++) {
+        CUAssertAlwaysLog(root->getChildByName("item"+std::to_string(ii)) == items[ii],
+                          "Method getChildByName() failed for item %d",ii);
+        CUAssertAlwaysLog(root->getChildByTag(ii+1) == items[ii], "Method getChildByTag() failed for item %d",ii);
+    }
+    CUAssertAlwaysLog(root->getChildByName("item100") == nullptr, "Method getChildByName() failed");
+    CUAssertAlwaysLog(root->getChildByTag(101) == nullptr, "Method getChildByTag() failed");
+
+    // Duplicates resolve to the first child in order
+    std::shared_ptr<SceneNode> twin = SceneNode::alloc();
+    root->addChildWithName(twin,"item5");
+    twin->setTag(6);
+    CUAssertAlwaysLog(root->getChildByName("item5") == items[5], "Duplicate name found the wrong child");
+    CUAssertAlwaysLog(root->getChildByTag(6) == items[5], "Duplicate tag found the wrong child");
+    root->removeChild(items[5]);
+    CUAssertAlwaysLog(root->getChildByName("item5") == twin, "Removal did not update the name index");
+    CUAssertAlwaysLog(root->getChildByTag(6) == twin, "Removal did not update the tag index");
+    CUAssertAlwaysLog(root->getChildByName("item6") == items[6], "Removal broke the name index");
+
+    // Changes to the children update the index
+    items[7]->setName("renamed");
+    items[7]->setTag(1000);
+    CUAssertAlwaysLog(root->getChildByName("item7") == nullptr, "Method setName() failed");
+    CUAssertAlwaysLog(root->getChildByName("renamed") == items[7], "Method setName() failed");
+    CUAssertAlwaysLog(root->getChildByTag(8) == nullptr, "Method setTag() failed");
+    CUAssertAlwaysLog(root->getChildByTag(1000) == items[7], "Method setTag() failed");
+
+    std::shared_ptr<SceneNode> swap = SceneNode::allocWithPosition(Vec2::ZERO);
+    swap->setName("swap");
+    root->swapChild(items[9],swap);
+    CUAssertAlwaysLog(root->getChildByName("item9") == nullptr, "Method swapChild() failed");
+    CUAssertAlwaysLog(root->getChildByName("swap") == swap, "Method swapChild() failed");
+    CUAssertAlwaysLog(root->getChildByName("item10") == items[10], "Method swapChild() failed");
+
+    // The linear search gives the same answers
+    root->setChildIndexed(false);
+    CUAssertAlwaysLog(root->getChildByName("item5") == twin, "Unindexed look-up failed");
+    CUAssertAlwaysLog(root->getChildByName("renamed") == items[7], "Unindexed look-up failed");
+    root->setChildIndexed(true);
+    CUAssertAlwaysLog(root->getChildByName("item50") == items[50], "Re-indexed look-up failed");
+    root->removeAllChildren();
+    CUAssertAlwaysLog(root->getChildByName("item50") == nullptr, "Method removeAllChildren() failed");
+    CUAssertAlwaysLog(root->getChildByTag(51) == nullptr, "Method removeAllChildren() failed");
+
+#pragma mark Path Test
+    std::shared_ptr<SceneNode> hud   = SceneNode::alloc();
+    std::shared_ptr<SceneNode> panel = SceneNode::alloc();
+    std::shared_ptr<SceneNode> score = SceneNode::alloc();
+    std::shared_ptr<SceneNode> blank = SceneNode::alloc();
+    root->addChildWithName(hud,"hud");
+    hud->addChild(blank);
+    hud->addChildWithName(panel,"panel");
+    panel->addChildWithName(score,"score");
+    CUAssertAlwaysLog(root->getChildByPath("hud") == hud, "Method getChildByPath() failed");
+    CUAssertAlwaysLog(root->getChildByPath("hud.panel.score") == score, "Method getChildByPath() failed");
+    CUAssertAlwaysLog(root->getChildByPath("hud.panel.score") == score, "Cached path failed");
+    CUAssertAlwaysLog(root->getChildByPath<SceneNode>("hud.panel") == panel, "Method getChildByPath<T>() failed");
+    CUAssertAlwaysLog(hud->getChildByPath("panel.score") == score, "Method getChildByPath() failed");
+    CUAssertAlwaysLog(root->getChildByPath("hud.score") == nullptr, "Method getChildByPath() failed");
+
+    // Empty names never match, even though the blank node has one
+    CUAssertAlwaysLog(root->getChildByPath("") == nullptr, "Empty path was resolved");
+    CUAssertAlwaysLog(root->getChildByPath("hud.") == nullptr, "Trailing period was resolved");
+    CUAssertAlwaysLog(root->getChildByPath("hud..score") == nullptr, "Double period was resolved");
+    CUAssertAlwaysLog(root->getChildByPath(".hud") == nullptr, "Leading period was resolved");
+
+    // The cache follows changes below the node
+    panel->setName("board");
+    CUAssertAlwaysLog(root->getChildByPath("hud.panel.score") == nullptr, "Rename did not clear the cache");
+    CUAssertAlwaysLog(root->getChildByPath("hud.board.score") == score, "Rename did not clear the cache");
+    score->removeFromParent();
+    CUAssertAlwaysLog(root->getChildByPath("hud.board.score") == nullptr, "Removal did not clear the cache");
+    std::shared_ptr<SceneNode> other = SceneNode::alloc();
+    panel->addChildWithName(other,"score");
+    CUAssertAlwaysLog(root->getChildByPath("hud.board.score") == other, "Addition did not clear the cache");
+
+#pragma mark Timing Test
+    const int WIDTH = 10000;
+    const int LOOKUPS = 10000;
+    for(int pass = 0; pass < 2; pass++) {
+        std::shared_ptr<SceneNode> wide = SceneNode::alloc();
+        wide->setChildIndexed(pass == 1);
+        std::vector<std::string> names;
+        for(int ii = 0; ii < WIDTH; ii++) {
+            names.push_back("node"+std::to_string(ii));
+            wide->addChildWithName(SceneNode::alloc(),names.back());
+        }
+        size_t found = 0;
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int ii = 0; ii < LOOKUPS; ii++) {
+            found += wide->getChildByName(names[(ii*7919) % WIDTH]) != nullptr ? 1 : 0;
+        }
+        end.mark();
+        CUAssertAlwaysLog(found == LOOKUPS, "Look-ups failed on a wide node");
+        CULog("%s: %d look-ups among %d children in %llu micros",(pass == 0 ? "Linear" : "Indexed"),
+              LOOKUPS,WIDTH,cugl::Timestamp::ellapsedMicros(start,end));
+    }
+
+#pragma mark Complete
+    CULog("Child index tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Scroll List
+/**
+ * Unit test for the row recycling of a scroll list
+ *
+ * This test scrolls a list of a million items from end to end, and checks
+ * after every step that the rows cover the view, are bound to the right
+ * items, and are positioned exactly.  It also checks that the number of
+ * rows never grows with the number of items, and reports the time to scroll.
+ */
+void cugl::testScrollList() {
+    CULog("Running tests for ScrollList.\n");
+    const size_t ITEMS = 1000000;
+    const float  HEIGHT = 10;
+    const Size   VIEW(200,100);
+
+    size_t created = 0;
+    size_t bound = 0;
+    std::unordered_map<SceneNode*,size_t> binding;
+    ScrollList::RowFactory factory = [&]() {
+        created++;
+        return SceneNode::allocWithBounds(Size(VIEW.width,HEIGHT));
+    };
+    ScrollList::RowBinder binder = [&](const std::shared_ptr<SceneNode>& row, size_t index) {
+        bound++;
+        binding[row.get()] = index;
+    };
+
+    // Checks the rows against the current scroll offset
+    auto verify = [&](const std::shared_ptr<ScrollList>& list) {
+        double offset = list->getScrollOffset();
+        size_t first = (size_t)std::max(0.0,std::floor(offset/HEIGHT)-list->getMargin());
+        size_t last  = std::min((size_t)(std::ceil((offset+VIEW.height)/HEIGHT)+list->getMargin()),
+                                list->getItemCount());
+        CUAssertAlwaysLog(list->getFirstRow() == first, "Offset %f starts at row %zu, not %zu",
+                          offset,list->getFirstRow(),first);
+        CUAssertAlwaysLog(list->getRowCount() == last-first, "Offset %f has %zu rows, not %zu",
+                          offset,list->getRowCount(),last-first);
+        for(size_t ii = first; ii < last; ii++) {
+            std::shared_ptr<SceneNode> row = list->getRow(ii);
+            CUAssertAlwaysLog(row != nullptr && row->isVisible(), "Item %zu has no row",ii);
+            CUAssertAlwaysLog(binding[row.get()] == ii, "Item %zu is bound to the wrong row",ii);
+            double y = VIEW.height+offset-(double)ii*HEIGHT;
+            CUAssertAlwaysLog(row->getPosition().y == (float)y, "Item %zu is at the wrong position",ii);
+        }
+        CUAssertAlwaysLog(list->getRow(last) == nullptr, "Item %zu has a row",last);
+        CUAssertAlwaysLog(first == 0 || list->getRow(first-1) == nullptr, "Item %zu has a row",first-1);
+    };
+
+#pragma mark Recycle Test
+    std::shared_ptr<ScrollList> list = ScrollList::alloc(VIEW,HEIGHT,ITEMS,factory,binder);
+    CUAssertAlwaysLog(list != nullptr, "Method alloc() failed");
+    CUAssertAlwaysLog(list->getItemCount() == ITEMS, "Method alloc() failed");
+    CUAssertAlwaysLog(list->getMaxScrollOffset() == ITEMS*HEIGHT-VIEW.height, "Method getMaxScrollOffset() failed");
+    CUAssertAlwaysLog(list->getRowCount() == 12, "Method alloc() created %zu rows",list->getRowCount());
+    CUAssertAlwaysLog(created == 12 && bound == 12, "Method alloc() failed");
+    verify(list);
+
+    // Rows are recycled as they leave the view, so the children are bounded
+    const size_t LIMIT = 10+1+2*list->getMargin();
+    size_t steps = 0;
+    while (list->getScrollOffset() < list->getMaxScrollOffset()) {
+        list->scrollBy(37.3);
+        verify(list);
+        steps++;
+    }
+    CUAssertAlwaysLog(created <= LIMIT, "Scrolling created %zu rows",created);
+    CUAssertAlwaysLog(list->getChildCount() == created, "Rows were not kept as children");
+    CUAssertAlwaysLog(list->getRow(ITEMS-1) != nullptr, "Last item has no row");
+    CUAssertAlwaysLog(list->getRow(ITEMS-1)->getPosition().y == HEIGHT, "Last item is at the wrong position");
+    CUAssertAlwaysLog(bound < steps*5, "Scrolling rebound %zu rows in %zu steps",bound,steps);
+
+    // Jumps and resizes rebind without creating rows
+    list->scrollToItem(ITEMS/2);
+    verify(list);
+    CUAssertAlwaysLog(list->getFirstRow() == ITEMS/2-2, "Method scrollToItem() failed");
+    list->scrollBy(-1e12);
+    CUAssertAlwaysLog(list->getScrollOffset() == 0, "Method scrollBy() failed");
+    verify(list);
+    list->scrollToItem(ITEMS/2);
+    list->setItemCount(20);
+    CUAssertAlwaysLog(list->getScrollOffset() == 100, "Method setItemCount() failed");
+    verify(list);
+    size_t before = bound;
+    list->invalidateItems();
+    CUAssertAlwaysLog(bound-before == list->getRowCount(), "Method invalidateItems() failed");
+    list->setItemCount(0);
+    CUAssertAlwaysLog(list->getRowCount() == 0, "Method setItemCount() failed");
+    list->setItemCount(ITEMS);
+    verify(list);
+    CUAssertAlwaysLog(created <= LIMIT, "Resizing created %zu rows",created);
+
+#pragma mark Inertia Test
+    list->setFriction(0.5f);
+    list->setVelocity(1000);
+    list->update(0.1f);
+    CUAssertAlwaysLog(fabs(list->getScrollOffset()-100) < 0.001, "Method update() failed");
+    CUAssertAlwaysLog(fabs(list->getVelocity()-1000*pow(0.5,0.1)) < 0.001, "Method update() failed");
+    for(int ii = 0; ii < 1000 && list->getVelocity() != 0; ii++) {
+        list->update(0.1f);
+    }
+    CUAssertAlwaysLog(list->getVelocity() == 0, "List did not come to rest");
+    verify(list);
+    list->scrollToItem(ITEMS);
+    list->setVelocity(1000);
+    list->update(0.1f);
+    CUAssertAlwaysLog(list->getVelocity() == 0, "List did not stop at the end");
+
+#pragma mark Timing Test
+    cugl::Timestamp start, end;
+    list->scrollToItem(0);
+    start.mark();
+    for(int ii = 0; ii < 100000; ii++) {
+        list->scrollBy(ii % 2 == 0 ? 4321.5 : -4000);
+    }
+    end.mark();
+    CULog("Scrolled %zu items 100000 times in %llu micros",ITEMS,cugl::Timestamp::ellapsedMicros(start,end));
+    start.mark();
+    for(int ii = 0; ii < 1000; ii++) {
+        list->setItemCount(ITEMS+ii);
+    }
+    end.mark();
+    CULog("Resized %zu items 1000 times in %llu micros",ITEMS,cugl::Timestamp::ellapsedMicros(start,end));
+
+#pragma mark Complete
+    CULog("ScrollList tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Multiline Label
+/**
+ * A multiline label that exposes its line layout
+ */
+class LabelProbe : public MultilineLabel {
+public:
+    /**
+     * Returns a newly allocated probe with the given size and font.
+     *
+     * @param size  The size of the label
+     * @param font  The label font
+     *
+     * @return a newly allocated probe with the given size and font.
+     */
+    static std::shared_ptr<LabelProbe> alloc(const Size size, const std::shared_ptr<Font>& font) {
+        std::shared_ptr<LabelProbe> node = std::make_shared<LabelProbe>();
+        return (node->init(size,font) ? node : nullptr);
+    }
+
+    /**
+     * Returns true if this label has the same layout as the given one.
+     *
+     * @param other The label to compare
+     * @param line  Pointer to store the first line that differs
+     *
+     * @return true if this label has the same layout as the given one.
+     */
+    bool sameLayout(const std::shared_ptr<LabelProbe>& other, size_t* line) const {
+        *line = 0;
+        for(; *line < _lines.size() && *line < other->_lines.size(); (*line)++) {
+            const Line& a = _lines[*line];
+            const Line& b = other->_lines[*line];
+            if (a.begin != b.begin || a.end != b.end || a.next != b.next || a.hard != b.hard ||
+                fabsf(a.width-b.width) > 0.01f) {
+                return false;
+            }
+        }
+        return _lines.size() == other->_lines.size();
+    }
+};
+
+/**
+ * Returns a random run of words for a multiline label.
+ *
+ * The words include multibyte characters, newlines, runs of spaces, and
+ * words too long to fit on a single line.
+ *
+ * @param words The number of words
+ *
+ * @return a random run of words for a multiline label.
+ */
+static std::string randomWords(int words) {
+    static const char* VOCAB[] = { "the", "quick", "brown", "fox", "jumps", "over", "a", "lazy",
+        "dog", "caf\xc3\xa9", "na\xc3\xafve", "r\xc3\xa9sum\xc3\xa9", "I", "WAVE", "AVATAR", "to",
+        "supercalifragilisticexpialidocious-and-then-some-more", "\n", "\n\n", "  " };
+    const int SIZE = sizeof(VOCAB)/sizeof(VOCAB[0]);
+    std::string result;
+    for(int ii = 0; ii < words; ii++) {
+        result += VOCAB[rand() % SIZE];
+        if (rand() % 4) {
+            result += " ";
+        }
+    }
+    return result;
+}
+
+/**
+ * Unit test for the incremental reflow of a multiline label
+ *
+ * This test applies random appends, inserts, erasures and replacements to
+ * a label, and checks after each edit that the line layout is the same as
+ * a full reflow of the same text.  It also reports the time to append to a
+ * long chat log.
+ *
+ * This test requires a font, but no atlas, so it needs no GL.
+ *
+ * @param path  The path to a TrueType font
+ */
+void cugl::testMultilineLabel(const std::string& path) {
+    CULog("Running tests for MultilineLabel.\n");
+    std::shared_ptr<Font> font = Font::alloc(path,24);
+    CUAssertAlwaysLog(font != nullptr, "Could not load font %s",path.c_str());
+    srand(4321);
+
+#pragma mark Reflow Test
+    const Size SIZE(300,200);
+    std::shared_ptr<LabelProbe> label = LabelProbe::alloc(SIZE,font);
+    std::shared_ptr<LabelProbe> full  = LabelProbe::alloc(SIZE,font);
+    CUAssertAlwaysLog(label != nullptr && full != nullptr, "Method init() failed");
+    for(int test = 0; test < 1000; test++) {
+        size_t length = label->getLength();
+        size_t pos = length == 0 ? 0 : rand() % (length+1);
+        size_t len = std::min(length-pos,(size_t)(rand() % 30));
+        switch (test % 4) {
+            case 0:
+                label->appendText(randomWords(1+rand() % 20));
+                break;
+            case 1:
+                label->replaceText(pos,0,randomWords(1+rand() % 5));
+                break;
+            case 2:
+                label->replaceText(pos,len,"");
+                break;
+            case 3:
+                label->replaceText(pos,len,randomWords(rand() % 5));
+                break;
+        }
+        if (test == 500) {
+            label->setContentSize(Size(180,200));
+            full->setContentSize(Size(180,200));
+        }
+        full->setText(label->getText());
+        CUAssertAlwaysLog(full->getLength() == label->getLength(), "Edit %d has the wrong length",test);
+        size_t line;
+        CUAssertAlwaysLog(label->sameLayout(full,&line), "Edit %d differs at line %zu of %zu",
+                          test,line,full->getLineCount());
+        CUAssertAlwaysLog(label->getTextHeight() == full->getTextHeight(), "Edit %d has the wrong height",test);
+    }
+    for(size_t ii = 0; ii < label->getLineCount(); ii++) {
+        CUAssertAlwaysLog(label->getLine(ii) == full->getLine(ii), "Line %zu has the wrong text",ii);
+    }
+
+#pragma mark Timing Test
+    const int LINES = 100000;
+    std::shared_ptr<MultilineLabel> log = MultilineLabel::alloc(SIZE,font);
+    cugl::Timestamp start, end;
+    start.mark();
+    for(int ii = 0; ii < LINES; ii++) {
+        log->appendText("Player "+std::to_string(ii % 8)+": "+randomWords(1+ii % 10)+"\n");
+    }
+    end.mark();
+    Uint64 appends = cugl::Timestamp::ellapsedMicros(start,end);
+    std::string text = log->getText();
+    start.mark();
+    log->setText(text);
+    end.mark();
+    CULog("Appended %d messages (%zu lines) in %llu micros, one full reflow takes %llu micros",
+          LINES,log->getLineCount(),appends,cugl::Timestamp::ellapsedMicros(start,end));
+
+#pragma mark Complete
+    CULog("MultilineLabel tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Immediate UI
+/**
+ * Unit test for the pointer handling of the immediate-mode UI
+ *
+ * This test plays mouse and touch gestures against a button, and checks
+ * when the button is clicked.  A touch has no hover before it lands, so it
+ * must press the button on the same frame.  It also checks that panels
+ * block the widgets beneath them.
+ *
+ * This test requires the GL context of the test application, because the
+ * UI builds a font atlas and draws to a sprite batch.
+ *
+ * @param path  The path to a TrueType font
+ */
+void cugl::testImmediateUI(const std::string& path) {
+    CULog("Running tests for ImmediateUI.\n");
+    std::shared_ptr<Font> font = Font::alloc(path,16);
+    CUAssertAlwaysLog(font != nullptr, "Could not load font %s",path.c_str());
+    std::shared_ptr<ImmediateUI> ui = ImmediateUI::alloc(UITheme::alloc(font));
+    CUAssertAlwaysLog(ui != nullptr, "Method alloc() failed");
+    std::shared_ptr<SpriteBatch> batch = SpriteBatch::alloc();
+
+    // Declares a button (and an optional panel on top) for one frame
+    const Rect BUTTON(10,10,100,40);
+    auto frame = [&](const Vec2 pointer, bool down, bool covered) {
+        ui->begin(pointer,down);
+        bool clicked = ui->button("ok",BUTTON,"OK");
+        if (covered) {
+            ui->panel(Rect(0,0,200,200));
+        }
+        ui->end(batch);
+        return clicked;
+    };
+    const Vec2 INSIDE(50,30);
+    const Vec2 OUTSIDE(500,500);
+
+#pragma mark Mouse Test
+    CUAssertAlwaysLog(!frame(OUTSIDE,false,false), "Button clicked without a press");
+    CUAssertAlwaysLog(!ui->isCapturing(), "Method isCapturing() failed");
+    CUAssertAlwaysLog(!frame(INSIDE,false,false), "Button clicked on hover");
+    CUAssertAlwaysLog(ui->isCapturing(), "Method isCapturing() failed");
+    CUAssertAlwaysLog(!frame(INSIDE,true,false), "Button clicked on press");
+    CUAssertAlwaysLog(ui->isActive(), "Button was not pressed");
+    CUAssertAlwaysLog(frame(INSIDE,false,false), "Mouse click failed");
+    CUAssertAlwaysLog(!ui->isActive(), "Button was not released");
+
+#pragma mark Touch Test
+    // A touch moves and presses in the same frame
+    frame(OUTSIDE,false,false);
+    CUAssertAlwaysLog(!frame(INSIDE,true,false), "Button clicked on press");
+    CUAssertAlwaysLog(ui->isActive(), "Touch did not press the button");
+    CUAssertAlwaysLog(frame(INSIDE,false,false), "Touch tap failed");
+
+    // A touch that leaves before release does not click
+    frame(OUTSIDE,false,false);
+    frame(INSIDE,true,false);
+    CUAssertAlwaysLog(!frame(OUTSIDE,false,false), "Button clicked after leaving");
+    CUAssertAlwaysLog(!frame(OUTSIDE,true,false), "Button clicked on a distant press");
+    CUAssertAlwaysLog(!ui->isActive(), "Distant press activated the button");
+    CUAssertAlwaysLog(!frame(OUTSIDE,false,false), "Button clicked on a distant tap");
+
+#pragma mark Occlusion Test
+    frame(OUTSIDE,false,true);
+    CUAssertAlwaysLog(!frame(INSIDE,true,true), "Button clicked on press");
+    CUAssertAlwaysLog(!ui->isActive(), "Covered button was pressed");
+    CUAssertAlwaysLog(!frame(INSIDE,false,true), "Covered button was clicked");
+    CUAssertAlwaysLog(ui->isCapturing(), "Panel did not capture the pointer");
+
+    // Uncovering the button makes it respond on the next frame
+    frame(OUTSIDE,false,false);
+    frame(INSIDE,true,false);
+    CUAssertAlwaysLog(frame(INSIDE,false,false), "Uncovered button was not clicked");
+
+#pragma mark Complete
+    CULog("ImmediateUI tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Pixel Comparison
+/**
+ * Returns a panel of translucent tiles with outlines.
+ *
+ * This is a stand-in for an ornate UI frame, with many small nodes.
+ *
+ * @param bounds    The panel bounds in parent space
+ * @param cols      The number of tile columns
+ * @param rows      The number of tile rows
+ *
+ * @return a panel of translucent tiles with outlines.
+ */
+static std::shared_ptr<SceneNode> buildPanel(const Rect bounds, int cols, int rows) {
+    std::shared_ptr<SceneNode> panel = SceneNode::allocWithBounds(bounds);
+    float width  = bounds.size.width/cols;
+    float height = bounds.size.height/rows;
+    for(int ii = 0; ii < cols*rows; ii++) {
+        Vec2 pos((ii % cols)*width, (ii / cols)*height);
+        std::shared_ptr<PolygonNode> tile = PolygonNode::alloc(Rect(0,0,width-2,height-2));
+        tile->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+        tile->setPosition(pos+Vec2(1,1));
+        tile->setColor(Color4((ii*37) % 256, (ii*91) % 256, (ii*53) % 256, 128+(ii*29) % 128));
+        panel->addChild(tile);
+        
+        std::shared_ptr<PathNode> line = PathNode::allocWithRect(Rect(0,0,width-4,height-4),
+                                                                 1.5f, poly2::Joint::MITRE);
+        line->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+        line->setPosition(pos+Vec2(2,2));
+        line->setColor(Color4(255,255,255,192));
+        panel->addChild(line);
+    }
+    return panel;
+}
+
+#pragma mark -
+#pragma mark Render Cache
+/**
+ * Unit test for the render caching of scene graph subtrees
+ *
+ * This test draws translucent panels with and without render caches, and
+ * checks that the pixels agree.  It checks that changes inside a cached
+ * subtree redraw the cache, and that the cache pool stays within its limit
+ * when the caches do not fit.  It also compares the frame times of a scene
+ * with many panels.
+ *
+ * This test requires the GL context of the test application.  For frame
+ * times without a GPU, run the application on a software driver (for
+ * example, Mesa with LIBGL_ALWAYS_SOFTWARE=1).
+ */
+void cugl::testRenderCache() {
+    CULog("Running tests for the render cache.\n");
+    const int TOLERANCE = 2;
+    Size size = viewportSize();
+    std::shared_ptr<SpriteBatch> batch = allocBatch();
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    CUAssertAlwaysLog(scene != nullptr, "Method alloc() failed");
+    std::shared_ptr<Scene2Cache> pool = scene->getRenderCache();
+    CUAssertAlwaysLog(pool != nullptr && pool->size() == 0, "Method getRenderCache() failed");
+    
+    std::shared_ptr<SceneNode> left  = buildPanel(Rect(20,20,240,200),12,10);
+    std::shared_ptr<SceneNode> right = buildPanel(Rect(160,120,240,200),12,10);
+    scene->addChild(left);
+    scene->addChild(right);
+
+#pragma mark Equivalence Test
+    std::vector<Uint8> expected = renderPixels(scene,batch);
+    left->setRenderCached(true);
+    right->setRenderCached(true);
+    std::vector<Uint8> actual = renderPixels(scene,batch);
+    CUAssertAlwaysLog(pool->size() == 2, "Scene has %zu caches, not 2",pool->size());
+    CUAssertAlwaysLog(pool->getUsage() == 2*240*200*4, "Method getUsage() failed");
+    double diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Cached panels differ in %.2f%% of pixels",100*diff);
+    
+    // A second frame draws from the caches alone
+    actual = renderPixels(scene,batch);
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Cached panels differ in %.2f%% of pixels",100*diff);
+
+#pragma mark Eviction Test
+    // Only one panel fits, so the least recently drawn cache is released
+    size_t bytes = pool->getUsage()/2;
+    scene->setRenderCacheLimit(bytes+bytes/2);
+    CUAssertAlwaysLog(pool->size() == 1, "Method setRenderCacheLimit() failed");
+    for(int ii = 0; ii < 4; ii++) {
+        actual = renderPixels(scene,batch);
+        CUAssertAlwaysLog(pool->size() <= 1 && pool->getUsage() <= bytes+bytes/2,
+                          "Cache pool exceeded its limit");
+        diff = pixelMismatch(expected,actual,TOLERANCE);
+        CUAssertAlwaysLog(diff == 0, "Evicted panels differ in %.2f%% of pixels",100*diff);
+    }
+    
+    // A cache that can never fit is not requested
+    scene->setRenderCacheLimit(bytes/2);
+    actual = renderPixels(scene,batch);
+    CUAssertAlwaysLog(pool->size() == 0, "Cache pool exceeded its limit");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Uncacheable panels differ in %.2f%% of pixels",100*diff);
+    scene->setRenderCacheLimit(DEFAULT_RENDER_CACHE_LIMIT);
+
+#pragma mark Invalidation Test
+    // Changes deep in a cached subtree must redraw the cache
+    std::vector<std::function<void()>> changes = {
+        [&]() { left->getChild(10)->setColor(Color4::RED); },
+        [&]() { left->getChild(21)->setPosition(Vec2(100,100)); },
+        [&]() { right->getChild(30)->setVisible(false); },
+        [&]() { right->getChild(31)->setAngle(0.5f); },
+        [&]() { right->addChild(PolygonNode::alloc(Rect(0,0,50,50))); },
+        [&]() { left->removeChild(left->getChild(0)); },
+        [&]() { left->setColor(Color4(255,255,255,128)); },
+    };
+    for(size_t ii = 0; ii < changes.size(); ii++) {
+        changes[ii]();
+        actual = renderPixels(scene,batch);
+        left->setRenderCached(false);
+        right->setRenderCached(false);
+        expected = renderPixels(scene,batch);
+        diff = pixelMismatch(expected,actual,TOLERANCE);
+        CUAssertAlwaysLog(diff == 0, "Change %zu differs in %.2f%% of pixels",ii,100*diff);
+        CUAssertAlwaysLog(pool->size() == 0, "Uncached panels kept their caches");
+        left->setRenderCached(true);
+        right->setRenderCached(true);
+    }
+
+#pragma mark Timing Test
+    const int FRAMES = 50;
+    scene->removeAllChildren();
+    for(int ii = 0; ii < 12; ii++) {
+        Rect bounds(20+(ii % 4)*(size.width-40)/4, 20+(ii / 4)*(size.height-40)/3,
+                    (size.width-40)/4-10, (size.height-40)/3-10);
+        scene->addChild(buildPanel(bounds,16,16));
+    }
+    std::vector<std::shared_ptr<SceneNode>> panels = scene->getChildren();
+    for(int pass = 0; pass < 2; pass++) {
+        for(auto it = panels.begin(); it != panels.end(); ++it) {
+            (*it)->setRenderCached(pass == 1);
+        }
+        renderFrame(scene,batch);
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int ii = 0; ii < FRAMES; ii++) {
+            scene->render(batch);
+        }
+        glFinish();
+        end.mark();
+        CULog("%s: %d frames of %zu panels in %llu micros",(pass == 0 ? "Uncached" : "Cached"),
+              FRAMES,scene->getChildCount(),cugl::Timestamp::ellapsedMicros(start,end));
+    }
+
+#pragma mark Complete
+    CULog("Render cache tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Hardware Stroke
+/**
+ * Returns a random path that stays inside the given bounds.
+ *
+ * Each step turns by at most the given angle, and the path turns back
+ * when it reaches the edge of the bounds.
+ *
+ * @param points    The number of points
+ * @param bounds    The bounds of the path
+ * @param turn      The largest turn per step in radians
+ *
+ * @return a random path that stays inside the given bounds.
+ */
+static std::vector<Vec2> randomPath(int points, const Rect bounds, float turn) {
+    std::vector<Vec2> result;
+    Vec2 pos = bounds.origin+bounds.size/2;
+    float angle = (rand() % 628)/100.0f;
+    for(int ii = 0; ii < points; ii++) {
+        result.push_back(pos);
+        angle += turn*((rand() % 2001)/1000.0f-1);
+        Vec2 step = Vec2::forAngle(angle)*(20+rand() % 40);
+        if (!bounds.contains(pos+step)) {
+            angle += M_PI;
+            step = -step;
+        }
+        pos += step;
+    }
+    return result;
+}
+
+/**
+ * Unit test for the GPU stroke expansion of paths
+ *
+ * This test checks the stroke segments built from paths, and then draws
+ * random paths with every joint and cap, both with the CPU extruder and
+ * on the GPU.  It checks that the strokes cover the same pixels, up to
+ * antialiasing at the edges and the clipping of mitre spikes.  It also
+ * compares the frame times of an animated stroke of 100k segments.
+ *
+ * The segment checks run on the CPU, but the rest of this test requires
+ * the GL context of the test application.
+ */
+void cugl::testHardwareStroke() {
+    CULog("Running tests for hardware strokes.\n");
+    auto jointOf = [](const StrokeSegment& segment) {
+        return ((int)segment.flags >> StrokeSegment::JOINT_SHIFT) & 3;
+    };
+    auto capOf = [](const StrokeSegment& segment) {
+        return ((int)segment.flags >> StrokeSegment::CAP_SHIFT) & 3;
+    };
+    auto linksOf = [](const StrokeSegment& segment) {
+        return (int)segment.flags & (StrokeSegment::PREVIOUS | StrokeSegment::NEXT);
+    };
+
+#pragma mark Segment Test
+    const int BOTH = StrokeSegment::PREVIOUS | StrokeSegment::NEXT;
+    std::vector<Vec2> path = { Vec2(0,0), Vec2(10,0), Vec2(10,10), Vec2(0,10) };
+    std::vector<StrokeSegment> segments;
+    size_t count = SpriteBatch::makeStroke(path, false, 4, poly2::Joint::ROUND,
+                                           poly2::EndCap::SQUARE, segments);
+    CUAssertAlwaysLog(count == 3 && segments.size() == 3, "Method makeStroke() failed");
+    for(size_t ii = 0; ii < count; ii++) {
+        CUAssertAlwaysLog(segments[ii].p0 == path[ii] && segments[ii].p1 == path[ii+1],
+                          "Segment %zu has the wrong end points",ii);
+        CUAssertAlwaysLog(segments[ii].stroke == 4, "Segment %zu has the wrong width",ii);
+        CUAssertAlwaysLog(jointOf(segments[ii]) == (int)poly2::Joint::ROUND, "Segment %zu has the wrong joint",ii);
+        CUAssertAlwaysLog(capOf(segments[ii]) == (int)poly2::EndCap::SQUARE, "Segment %zu has the wrong cap",ii);
+    }
+    CUAssertAlwaysLog(linksOf(segments[0]) == StrokeSegment::NEXT, "Open path has a start joint");
+    CUAssertAlwaysLog(linksOf(segments[1]) == BOTH, "Interior segment is missing a joint");
+    CUAssertAlwaysLog(linksOf(segments[2]) == StrokeSegment::PREVIOUS, "Open path has an end joint");
+    CUAssertAlwaysLog(segments[0].prev == path[0] && segments[0].next == path[2], "Method makeStroke() failed");
+    CUAssertAlwaysLog(segments[1].prev == path[0] && segments[1].next == path[3], "Method makeStroke() failed");
+    CUAssertAlwaysLog(segments[2].prev == path[1] && segments[2].next == path[3], "Method makeStroke() failed");
+    
+    // Closed paths wrap around, and are appended to the existing segments
+    count = SpriteBatch::makeStroke(path, true, 2, poly2::Joint::MITRE, poly2::EndCap::NONE, segments);
+    CUAssertAlwaysLog(count == 4 && segments.size() == 7, "Method makeStroke() failed");
+    for(size_t ii = 3; ii < 7; ii++) {
+        CUAssertAlwaysLog(linksOf(segments[ii]) == BOTH, "Closed path is missing a joint");
+        CUAssertAlwaysLog(jointOf(segments[ii]) == (int)poly2::Joint::MITRE, "Segment %zu has the wrong joint",ii);
+    }
+    CUAssertAlwaysLog(segments[6].p1 == path[0] && segments[6].next == path[1], "Closed path does not wrap");
+    CUAssertAlwaysLog(segments[3].prev == path[3], "Closed path does not wrap");
+    
+    // A line with two points is never closed
+    segments.clear();
+    count = SpriteBatch::makeStroke({ Vec2(0,0), Vec2(5,5) }, true, 1, poly2::Joint::ROUND,
+                                    poly2::EndCap::ROUND, segments);
+    CUAssertAlwaysLog(count == 1 && linksOf(segments[0]) == 0, "Method makeStroke() failed");
+    
+    // Polygon paths split into connected runs
+    segments.clear();
+    Poly2 poly(Rect(0,0,10,10), false);
+    size_t first = poly.vertices().size();
+    poly.vertices().push_back(Vec2(20,0));
+    poly.vertices().push_back(Vec2(30,0));
+    poly.vertices().push_back(Vec2(30,10));
+    poly.indices().insert(poly.indices().end(), { (Uint32)first, (Uint32)first+1, (Uint32)first+1, (Uint32)first+2 });
+    count = SpriteBatch::makeStroke(poly, 3, poly2::Joint::SQUARE, poly2::EndCap::ROUND, segments);
+    CUAssertAlwaysLog(count == 6 && segments.size() == 6, "Method makeStroke() failed");
+    for(size_t ii = 0; ii < 4; ii++) {
+        CUAssertAlwaysLog(linksOf(segments[ii]) == BOTH, "Rectangle is missing a joint");
+    }
+    CUAssertAlwaysLog(linksOf(segments[4]) == StrokeSegment::NEXT, "Open run has a start joint");
+    CUAssertAlwaysLog(linksOf(segments[5]) == StrokeSegment::PREVIOUS, "Open run has an end joint");
+    CUAssertAlwaysLog(segments[4].next == Vec2(30,10) && segments[5].prev == Vec2(20,0), "Method makeStroke() failed");
+
+#pragma mark Parity Test
+    // The two strokes only differ in the rasterization of their edges, so
+    // pixels must differ by more than a quarter to count against them
+    const double TOLERANCE = 0.01;
+    const int EDGE = 64;
+    const int TRIALS = 96;
+    Size size = viewportSize();
+    std::shared_ptr<SpriteBatch> batch = allocBatch();
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    double worst[4] = { 0, 0, 0, 0 };
+    for(int ii = 0; ii < TRIALS; ii++) {
+        poly2::Joint  joint = (poly2::Joint)(ii % 4);
+        poly2::EndCap cap   = (poly2::EndCap)((ii / 4) % 3);
+        path = randomPath(4+ii % 8, Rect(Vec2::ZERO,size), 2.0f);
+        std::shared_ptr<PathNode> node = PathNode::allocWithVertices(path, 4.0f+ii % 12, joint,
+                                                                     cap, (ii / 12) % 2 == 1);
+        node->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+        node->setPosition(node->getPolygon().getBounds().origin);
+        scene->removeAllChildren();
+        scene->addChild(node);
+        
+        std::vector<Uint8> expected = renderPixels(scene,batch);
+        node->setHardwareStroke(true);
+        CUAssertAlwaysLog(node->isHardwareStroke(), "Method setHardwareStroke() failed");
+        std::vector<Uint8> actual = renderPixels(scene,batch);
+        double mismatch = pixelMismatch(expected,actual,EDGE);
+        worst[(int)joint] = std::max(worst[(int)joint],mismatch);
+        CUAssertAlwaysLog(mismatch <= TOLERANCE, "Stroke %d (joint %d, cap %d) differs in %.2f%% of pixels",
+                          ii,(int)joint,(int)cap,100*mismatch);
+    }
+    CULog("Worst mismatch by joint: none %.2f%%, mitre %.2f%%, square %.2f%%, round %.2f%%",
+          100*worst[0],100*worst[1],100*worst[2],100*worst[3]);
+
+#pragma mark Timing Test
+    const int SEGMENTS = 100000;
+    const int FRAMES = 10;
+    path.resize(SEGMENTS+1);
+    std::shared_ptr<PathNode> wave = PathNode::allocWithVertices(path, 2, poly2::Joint::MITRE,
+                                                                 poly2::EndCap::NONE, false);
+    scene->removeAllChildren();
+    scene->addChild(wave);
+    for(int pass = 0; pass < 2; pass++) {
+        wave->setHardwareStroke(pass == 1);
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int ii = 0; ii < FRAMES; ii++) {
+            for(int jj = 0; jj <= SEGMENTS; jj++) {
+                float x = jj*size.width/SEGMENTS;
+                path[jj].set(x, size.height/2*(1+0.8f*sinf(x/20+ii)));
+            }
+            wave->setPolygon(path);
+            scene->render(batch);
+        }
+        glFinish();
+        end.mark();
+        CULog("%s: %d frames of %d animated segments in %llu micros",(pass == 0 ? "CPU" : "GPU"),
+              FRAMES,SEGMENTS,cugl::Timestamp::ellapsedMicros(start,end));
+    }
+
+#pragma mark Complete
+    CULog("Hardware stroke tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Damage Tracking
+/**
+ * Returns a scene with panels, a loose sprite, and two paths.
+ *
+ * Two calls to this function build identical scenes, so that one can
+ * track damage while the other is fully redrawn.
+ *
+ * @param size  The scene size
+ *
+ * @return a scene with panels, a loose sprite, and two paths.
+ */
+static std::shared_ptr<Scene2> buildDamageScene(const Size size) {
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    scene->addChild(buildPanel(Rect(20,20,240,200),12,10));
+    scene->addChild(buildPanel(Rect(160,120,240,200),12,10));
+    
+    std::shared_ptr<PolygonNode> sprite = PolygonNode::alloc(Rect(0,0,40,30));
+    sprite->setColor(Color4(255,200,0,160));
+    sprite->setPosition(Vec2(size.width-80,size.height-60));
+    scene->addChild(sprite);
+    
+    std::vector<Vec2> path = { Vec2(0,0), Vec2(60,20), Vec2(90,80), Vec2(30,70) };
+    std::shared_ptr<PathNode> line = PathNode::allocWithVertices(path, 3.0f, poly2::Joint::ROUND,
+                                                                 poly2::EndCap::ROUND, false);
+    line->setPosition(Vec2(size.width-150,80));
+    scene->addChild(line);
+    
+    // A horizontal line has no content height, but its stroke does
+    std::vector<Vec2> flat = { Vec2(0,0), Vec2(120,0) };
+    std::shared_ptr<PathNode> rule = PathNode::allocWithVertices(flat, 4.0f, poly2::Joint::NONE,
+                                                                 poly2::EndCap::SQUARE, false);
+    rule->setPosition(Vec2(size.width-150,size.height-120));
+    scene->addChild(rule);
+    return scene;
+}
+
+/**
+ * Returns the total area of the given regions
+ *
+ * @param regions   The regions to measure
+ *
+ * @return the total area of the given regions
+ */
+static float regionArea(const std::vector<Rect>& regions) {
+    float result = 0;
+    for(auto it = regions.begin(); it != regions.end(); ++it) {
+        result += it->size.width*it->size.height;
+    }
+    return result;
+}
+
+/**
+ * Unit test for the damage-tracked partial redraw of scenes
+ *
+ * This test changes two identical scenes the same way each frame.  One
+ * scene only redraws its damaged regions, while the other is redrawn in
+ * full, and the test checks that the pixels agree.  It checks that an
+ * unchanged scene has no damage, that small changes redraw a small part
+ * of the screen, and that the debug overlay is not saved in the frame.
+ * It also compares the frame times of a mostly static scene.
+ *
+ * This test requires the GL context of the test application, as the
+ * saved frame is a render target.  It temporarily changes the clear color
+ * of the application, as damaged regions are cleared with that color.
+ */
+void cugl::testDamageTracking() {
+    CULog("Running tests for damage tracking.\n");
+    const int TOLERANCE = 2;
+    Size size = viewportSize();
+    float screen = size.width*size.height;
+    std::shared_ptr<SpriteBatch> batch = allocBatch();
+    Color4 clear = Application::get()->getClearColor();
+    Application::get()->setClearColor(Color4f(0.2f, 0.3f, 0.4f, 1.0f));
+    
+    std::shared_ptr<Scene2> tracked = buildDamageScene(size);
+    std::shared_ptr<Scene2> reference = buildDamageScene(size);
+    CUAssertAlwaysLog(!tracked->isDamageTracking(), "Scene tracks damage by default");
+    CUAssertAlwaysLog(tracked->hasDamage(), "Untracked scene has no damage");
+
+#pragma mark Frame Test
+    tracked->setDamageTracking(true);
+    CUAssertAlwaysLog(tracked->isDamageTracking(), "Method setDamageTracking() failed");
+    CUAssertAlwaysLog(tracked->hasDamage(), "First frame has no damage");
+    std::vector<Uint8> actual = renderPixels(tracked,batch);
+    std::vector<Uint8> expected = renderPixels(reference,batch);
+    double diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "First frame differs in %.2f%% of pixels",100*diff);
+    CUAssertAlwaysLog(tracked->getRedrawnRegions().size() == 1 &&
+                      std::abs(regionArea(tracked->getRedrawnRegions())-screen) < 1,
+                      "First frame was not fully redrawn");
+    
+    // An unchanged scene copies the saved frame
+    CUAssertAlwaysLog(!tracked->hasDamage(), "Unchanged scene has damage");
+    actual = renderPixels(tracked,batch);
+    CUAssertAlwaysLog(tracked->getRedrawnRegions().empty(), "Unchanged scene was redrawn");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Unchanged frame differs in %.2f%% of pixels",100*diff);
+
+#pragma mark Change Test
+    // Each change is small, and so should only redraw a small part of the screen
+    std::vector<std::function<void(Scene2*)>> changes = {
+        [&](Scene2* scene) { scene->getChild(0)->getChild(10)->setColor(Color4::RED); },
+        [&](Scene2* scene) { scene->getChild(0)->getChild(21)->setPosition(Vec2(100,100)); },
+        [&](Scene2* scene) { scene->getChild(1)->getChild(30)->setVisible(false); },
+        [&](Scene2* scene) { scene->getChild(1)->getChild(31)->setAngle(0.5f); },
+        [&](Scene2* scene) { scene->getChild(1)->addChild(PolygonNode::alloc(Rect(0,0,50,50))); },
+        [&](Scene2* scene) { scene->getChild(0)->removeChild(scene->getChild(0)->getChild(0)); },
+        [&](Scene2* scene) { scene->getChild(2)->setPosition(Vec2(300,250)); },
+        [&](Scene2* scene) { scene->getChild(2)->setScale(1.5f); },
+        [&](Scene2* scene) { std::dynamic_pointer_cast<PathNode>(scene->getChild(3))->setStroke(6.0f); },
+        [&](Scene2* scene) { scene->getChild(3)->setVisible(false); },
+        [&](Scene2* scene) { scene->getChild(3)->setVisible(true); },
+        [&](Scene2* scene) { std::dynamic_pointer_cast<PathNode>(scene->getChild(3))->setHardwareStroke(true); },
+        [&](Scene2* scene) { std::dynamic_pointer_cast<PathNode>(scene->getChild(3))->setJoint(poly2::Joint::MITRE); },
+        [&](Scene2* scene) { scene->getChild(4)->setPosition(Vec2(size.width-140,size.height-140)); },
+        [&](Scene2* scene) { scene->getChild(4)->setAngle(0.3f); },
+    };
+    for(size_t ii = 0; ii < changes.size(); ii++) {
+        changes[ii](tracked.get());
+        changes[ii](reference.get());
+        CUAssertAlwaysLog(tracked->hasDamage(), "Change %zu has no damage",ii);
+        actual = renderPixels(tracked,batch);
+        expected = renderPixels(reference,batch);
+        diff = pixelMismatch(expected,actual,TOLERANCE);
+        CUAssertAlwaysLog(diff == 0, "Change %zu differs in %.2f%% of pixels",ii,100*diff);
+        
+        float area = regionArea(tracked->getRedrawnRegions());
+        CUAssertAlwaysLog(area > 0 && area < screen/4, "Change %zu redrew %.0f%% of the screen",
+                          ii,100*area/screen);
+        CUAssertAlwaysLog(!tracked->hasDamage(), "Change %zu has leftover damage",ii);
+    }
+    
+    // Damage the scene graph cannot see
+    tracked->addDamage(Rect::ZERO);
+    CUAssertAlwaysLog(!tracked->hasDamage(), "Method addDamage() failed");
+    tracked->addDamage(Rect(50,50,20,20));
+    CUAssertAlwaysLog(tracked->hasDamage(), "Method addDamage() failed");
+    actual = renderPixels(tracked,batch);
+    CUAssertAlwaysLog(tracked->getRedrawnRegions().size() == 1 &&
+                      tracked->getRedrawnRegions()[0].contains(Rect(50,50,20,20)),
+                      "Method addDamage() failed");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Added damage differs in %.2f%% of pixels",100*diff);
+    
+    // Moving the camera redraws everything
+    tracked->getCamera()->translate(Vec2(10,5));
+    tracked->getCamera()->update();
+    reference->getCamera()->translate(Vec2(10,5));
+    reference->getCamera()->update();
+    CUAssertAlwaysLog(tracked->hasDamage(), "Camera change has no damage");
+    actual = renderPixels(tracked,batch);
+    expected = renderPixels(reference,batch);
+    CUAssertAlwaysLog(std::abs(regionArea(tracked->getRedrawnRegions())-screen) < 1,
+                      "Camera change was not fully redrawn");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Camera change differs in %.2f%% of pixels",100*diff);
+
+#pragma mark Overlay Test
+    // The outlines are on the screen, but not in the saved frame
+    tracked->setDamageOverlay(true);
+    CUAssertAlwaysLog(tracked->isDamageOverlay(), "Method setDamageOverlay() failed");
+    tracked->getChild(2)->setPosition(Vec2(200,300));
+    reference->getChild(2)->setPosition(Vec2(200,300));
+    actual = renderPixels(tracked,batch);
+    expected = renderPixels(reference,batch);
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff > 0, "Damage overlay was not drawn");
+    
+    tracked->setDamageOverlay(false);
+    actual = renderPixels(tracked,batch);
+    CUAssertAlwaysLog(tracked->getRedrawnRegions().empty(), "Unchanged scene was redrawn");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Damage overlay was saved in the frame");
+    
+    // Turning tracking off draws directly again
+    tracked->setDamageTracking(false);
+    CUAssertAlwaysLog(tracked->hasDamage(), "Untracked scene has no damage");
+    actual = renderPixels(tracked,batch);
+    CUAssertAlwaysLog(tracked->getRedrawnRegions().empty(), "Untracked scene has redrawn regions");
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Untracked scene differs in %.2f%% of pixels",100*diff);
+
+#pragma mark Timing Test
+    // A mostly static scene with one moving sprite
+    const int FRAMES = 50;
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    for(int ii = 0; ii < 12; ii++) {
+        Rect bounds(20+(ii % 4)*(size.width-40)/4, 20+(ii / 4)*(size.height-40)/3,
+                    (size.width-40)/4-10, (size.height-40)/3-10);
+        scene->addChild(buildPanel(bounds,16,16));
+    }
+    std::shared_ptr<PolygonNode> sprite = PolygonNode::alloc(Rect(0,0,20,20));
+    scene->addChild(sprite);
+    for(int pass = 0; pass < 2; pass++) {
+        scene->setDamageTracking(pass == 1);
+        renderFrame(scene,batch);
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int ii = 0; ii < FRAMES; ii++) {
+            sprite->setPosition(Vec2(20+ii*(size.width-40)/FRAMES,size.height/2));
+            scene->render(batch);
+        }
+        glFinish();
+        end.mark();
+        CULog("%s: %d frames with one moving sprite in %llu micros",(pass == 0 ? "Full" : "Damaged"),
+              FRAMES,cugl::Timestamp::ellapsedMicros(start,end));
+    }
+    
+    Application::get()->setClearColor(clear);
+
+#pragma mark Complete
+    CULog("Damage tracking tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Opaque Pass
+/**
+ * Unit test for the opaque pass of scenes
+ *
+ * This test draws a scene that mixes opaque and translucent nodes with
+ * and without an opaque pass, and checks that the pixels agree.  The
+ * scene includes the cases that must not be opaque: translucent tints
+ * (inherited or not), textures with alpha, additive blending, scissors,
+ * render caches, and antialiased paths.  It also compares the frame times
+ * of a scene with heavy overdraw.
+ *
+ * This test requires the GL context of the test application, and the
+ * display must have a depth buffer.
+ */
+void cugl::testOpaquePass() {
+    CULog("Running tests for the opaque pass.\n");
+    const int TOLERANCE = 2;
+    Size size = viewportSize();
+    std::shared_ptr<SpriteBatch> batch = allocBatch();
+    std::shared_ptr<Scene2> scene = Scene2::alloc(size);
+    CUAssertAlwaysLog(!scene->isOpaquePass(), "Scene has an opaque pass by default");
+    
+    // Each node is numbered as the opaque pass should see it
+    size_t opaque = 0;
+    std::shared_ptr<PolygonNode> ground = PolygonNode::alloc(Rect(Vec2::ZERO,size));
+    ground->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+    ground->setColor(Color4(40,60,80,255));
+    scene->addChild(ground);
+    opaque++;
+    for(int ii = 0; ii < 24; ii++) {
+        std::shared_ptr<PolygonNode> tile = PolygonNode::alloc(Rect(0,0,120,90));
+        tile->setPosition(Vec2(80+(ii % 6)*90, 80+(ii / 6)*90));
+        tile->setAngle(0.1f*(ii % 5));
+        bool clear = ii % 3 == 2;
+        tile->setColor(Color4((ii*37) % 256, (ii*91) % 256, (ii*53) % 256, clear ? 128 : 255));
+        scene->addChild(tile);
+        opaque += clear ? 0 : 1;
+    }
+    
+    // Opaque children of a translucent parent inherit its alpha
+    std::shared_ptr<PolygonNode> faded = PolygonNode::alloc(Rect(0,0,200,150));
+    faded->setPosition(Vec2(200,200));
+    faded->setColor(Color4(255,255,255,160));
+    for(int ii = 0; ii < 3; ii++) {
+        std::shared_ptr<PolygonNode> child = PolygonNode::alloc(Rect(0,0,60,60));
+        child->setPosition(Vec2(40+ii*60,75));
+        child->setColor(Color4::RED);
+        faded->addChild(child);
+    }
+    scene->addChild(faded);
+    
+    // Textures with alpha and additive blends are not opaque
+    Uint8 solid[] = { 255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 255, 255 };
+    Uint8 holes[] = { 255, 0, 0, 255, 0, 255, 0, 0, 0, 0, 255, 128, 255, 255, 255, 255 };
+    std::shared_ptr<Texture> texture = Texture::allocWithData(solid,2,2);
+    CUAssertAlwaysLog(texture != nullptr && texture->isOpaque(), "Opaque texture is not opaque");
+    std::shared_ptr<PolygonNode> image = PolygonNode::allocWithTexture(texture,Rect(0,0,100,100));
+    image->setPosition(Vec2(420,330));
+    scene->addChild(image);
+    opaque++;
+    texture = Texture::allocWithData(holes,2,2);
+    CUAssertAlwaysLog(texture != nullptr && !texture->isOpaque(), "Translucent texture is opaque");
+    image = PolygonNode::allocWithTexture(texture,Rect(0,0,100,100));
+    image->setPosition(Vec2(470,300));
+    scene->addChild(image);
+    std::shared_ptr<PolygonNode> glow = PolygonNode::alloc(Rect(0,0,100,100));
+    glow->setPosition(Vec2(150,380));
+    glow->setColor(Color4(80,80,0,255));
+    glow->setBlendFunc(GL_ONE, GL_ONE);
+    CUAssertAlwaysLog(!glow->isOpaque(), "Additive node is opaque");
+    scene->addChild(glow);
+    
+    // Scissored and cached subtrees are drawn in the second pass
+    std::shared_ptr<SceneNode> clipped = buildPanel(Rect(300,40,160,120),4,3);
+    clipped->setScissor();
+    scene->addChild(clipped);
+    std::shared_ptr<SceneNode> cached = buildPanel(Rect(40,300,160,120),4,3);
+    cached->setRenderCached(true);
+    scene->addChild(cached);
+    
+    // An opaque node drawn last must cover everything beneath it
+    std::shared_ptr<PolygonNode> top = PolygonNode::alloc(Rect(0,0,80,80));
+    top->setPosition(Vec2(size.width/2,size.height/2));
+    top->setColor(Color4::YELLOW);
+    scene->addChild(top);
+    opaque++;
+
+#pragma mark Equivalence Test
+    std::vector<Uint8> expected = renderPixels(scene,batch);
+    CUAssertAlwaysLog(scene->getOpaqueCount() == 0, "Method getOpaqueCount() failed");
+    scene->setOpaquePass(true);
+    CUAssertAlwaysLog(scene->isOpaquePass(), "Method setOpaquePass() failed");
+    std::vector<Uint8> actual = renderPixels(scene,batch);
+    CUAssertAlwaysLog(scene->getOpaqueCount() == opaque, "Opaque pass drew %zu nodes, not %zu",
+                      scene->getOpaqueCount(),opaque);
+    double diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Opaque pass differs in %.2f%% of pixels",100*diff);
+    
+    // Changes to opacity take effect on the next frame
+    std::vector<std::function<void()>> changes = {
+        [&]() { ground->setColor(Color4(40,60,80,200)); opaque--; },
+        [&]() { top->setVisible(false); opaque--; },
+        [&]() { faded->setColor(Color4::WHITE); opaque += 4; },
+        [&]() { top->setVisible(true); scene->getChild(1)->setZOrder(100); scene->sortZOrder(); opaque++; },
+        [&]() { glow->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); opaque++; },
+    };
+    for(size_t ii = 0; ii < changes.size(); ii++) {
+        changes[ii]();
+        actual = renderPixels(scene,batch);
+        CUAssertAlwaysLog(scene->getOpaqueCount() == opaque, "Change %zu drew %zu opaque nodes, not %zu",
+                          ii,scene->getOpaqueCount(),opaque);
+        scene->setOpaquePass(false);
+        expected = renderPixels(scene,batch);
+        CUAssertAlwaysLog(scene->getOpaqueCount() == 0, "Method setOpaquePass() failed");
+        diff = pixelMismatch(expected,actual,TOLERANCE);
+        CUAssertAlwaysLog(diff == 0, "Change %zu differs in %.2f%% of pixels",ii,100*diff);
+        scene->setOpaquePass(true);
+    }
+    
+    // A damaged redraw is scissored, so nothing is opaque
+    Color4 clear = Application::get()->getClearColor();
+    Application::get()->setClearColor(Color4f(0.2f, 0.3f, 0.4f, 1.0f));
+    scene->setDamageTracking(true);
+    renderFrame(scene,batch);
+    top->setPosition(Vec2(100,100));
+    actual = renderPixels(scene,batch);
+    CUAssertAlwaysLog(scene->getOpaqueCount() == 0, "Scissored redraw has an opaque pass");
+    scene->setDamageTracking(false);
+    expected = renderPixels(scene,batch);
+    diff = pixelMismatch(expected,actual,TOLERANCE);
+    CUAssertAlwaysLog(diff == 0, "Damaged opaque pass differs in %.2f%% of pixels",100*diff);
+    Application::get()->setClearColor(clear);
+
+#pragma mark Timing Test
+    // Full screen layers, as in a parallax background
+    const int FRAMES = 50;
+    const int LAYERS = 24;
+    scene->removeAllChildren();
+    for(int ii = 0; ii < LAYERS; ii++) {
+        std::shared_ptr<PolygonNode> layer = PolygonNode::alloc(Rect(Vec2::ZERO,size));
+        layer->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+        layer->setColor(Color4((ii*37) % 256, (ii*91) % 256, (ii*53) % 256, 255));
+        scene->addChild(layer);
+    }
+    for(int pass = 0; pass < 2; pass++) {
+        scene->setOpaquePass(pass == 1);
+        renderFrame(scene,batch);
+        cugl::Timestamp start, end;
+        start.mark();
+        for(int ii = 0; ii < FRAMES; ii++) {
+            GLState::depthMask(GL_TRUE);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            scene->render(batch);
+        }
+        glFinish();
+        end.mark();
+        CULog("%s: %d frames of %d full screen layers in %llu micros",(pass == 0 ? "Blended" : "Opaque pass"),
+              FRAMES,LAYERS,cugl::Timestamp::ellapsedMicros(start,end));
+    }
+
+#pragma mark Complete
+    CULog("Opaque pass tests complete.\n");
+}
+
+#pragma mark -
+#pragma mark Main
+
+/**
+ * Master unit test that invokes all others in this module.
+ */
+void cugl::scene2UnitTest() {
+    testChildIndex();
+    testScrollList();
+    testMultilineLabel("fonts/Lato-Regular.ttf");
+    testImmediateUI("fonts/Lato-Regular.ttf");
+    testRenderCache();
+    testHardwareStroke();
+    testDamageTracking();
+    testOpaquePass();
+}
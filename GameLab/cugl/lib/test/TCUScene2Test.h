@@ -0,0 +1,95 @@
+//
+//  TCUScene2Test.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the scene graph classes.  Most tests
+//  build scene graphs without drawing them, and check the book-keeping that
+//  the nodes do on the CPU.  The render tests draw scenes in more than one
+//  way and compare the pixels.  They also report the time of the larger
+//  graphs, so that they can serve as a benchmark.
+//
+//  These test classes only use asserts.  The render tests need the GL
+//  context of the test application, but read back their pixels before the
+//  buffers are swapped, so they have no graphical side-effects.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#ifndef __T_CU_SCENE2_TEST_H__
+#define __T_CU_SCENE2_TEST_H__
+
+#include <string>
+
+namespace cugl {
+
+/**
+ * Unit test for the child index and path look-up of a scene node
+ */
+void testChildIndex();
+
+/**
+ * Unit test for the row recycling of a scroll list
+ */
+void testScrollList();
+
+/**
+ * Unit test for the incremental reflow of a multiline label
+ *
+ * @param path  The path to a TrueType font
+ */
+void testMultilineLabel(const std::string& path);
+
+/**
+ * Unit test for the pointer handling of the immediate-mode UI
+ *
+ * @param path  The path to a TrueType font
+ */
+void testImmediateUI(const std::string& path);
+
+/**
+ * Unit test for the render caching of scene graph subtrees
+ */
+void testRenderCache();
+
+/**
+ * Unit test for the GPU stroke expansion of paths
+ */
+void testHardwareStroke();
+
+/**
+ * Unit test for the damage-tracked partial redraw of scenes
+ */
+void testDamageTracking();
+
+/**
+ * Unit test for the opaque pass of scenes
+ */
+void testOpaquePass();
+
+/**
+ * Master unit test that invokes all others in this module.
+ */
+void scene2UnitTest();
+
+}
+
+#endif /* __T_CU_SCENE2_TEST_H__ */
@@ -0,0 +1,271 @@
+//
+//  TCUUtilTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a unit test suite for the utility classes.  It checks that
+//  the start-up graph in Bootstrap respects dependencies, rejects malformed
+//  graphs, and runs lazy tasks on demand, even as new ones are added.
+//
+//  These test classes only use asserts and have no graphical side-effects.
+//  They do not need an OpenGL context.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+
+#include "TCUUtilTest.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cugl/cugl.h>
+
+using namespace cugl;
+
+#pragma mark -
+#pragma mark Helpers
+/**
+ * A thread-safe record of the order in which tasks completed
+ */
+class TaskTrace {
+private:
+    /** The task names in order of completion */
+    std::vector<std::string> _order;
+    /** The thread that ran each task */
+    std::vector<SDL_threadID> _threads;
+    /** A mutex for the record */
+    std::mutex _mutex;
+
+public:
+    /**
+     * Records that the named task has completed on the current thread
+     *
+     * @param name  The task name
+     */
+    void mark(const std::string& name) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        _order.push_back(name);
+        _threads.push_back(SDL_ThreadID());
+    }
+
+    /**
+     * Returns the number of times the named task completed
+     *
+     * @param name  The task name
+     *
+     * @return the number of times the named task completed
+     */
+    size_t count(const std::string& name) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        return std::count(_order.begin(), _order.end(), name);
+    }
+
+    /**
+     * Returns the completion position of the named task (-1 if it never ran)
+     *
+     * @param name  The task name
+     *
+     * @return the completion position of the named task
+     */
+    int position(const std::string& name) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        auto it = std::find(_order.begin(), _order.end(), name);
+        return it == _order.end() ? -1 : (int)(it-_order.begin());
+    }
+
+    /**
+     * Returns the thread that ran the named task (0 if it never ran)
+     *
+     * @param name  The task name
+     *
+     * @return the thread that ran the named task
+     */
+    SDL_threadID thread(const std::string& name) {
+        std::lock_guard<std::mutex> lk(_mutex);
+        auto it = std::find(_order.begin(), _order.end(), name);
+        return it == _order.end() ? 0 : _threads[it-_order.begin()];
+    }
+
+    /**
+     * Returns the total number of completed tasks
+     *
+     * @return the total number of completed tasks
+     */
+    size_t size() {
+        std::lock_guard<std::mutex> lk(_mutex);
+        return _order.size();
+    }
+};
+
+/**
+ * Asserts that the first task completed before the second one
+ *
+ * @param trace     The completion record
+ * @param first     The task that should finish first
+ * @param second    The task that should finish second
+ */
+static void checkBefore(TaskTrace& trace, const std::string& first, const std::string& second) {
+    int a = trace.position(first);
+    int b = trace.position(second);
+    CUAssertAlwaysLog(a >= 0 && b >= 0 && a < b, "Task '%s' (%d) did not finish before '%s' (%d)",
+                      first.c_str(), a, second.c_str(), b);
+}
+
+#pragma mark -
+#pragma mark Bootstrap
+/**
+ * Unit test for the start-up dependency graph
+ */
+void cugl::testBootstrap() {
+    CULog("Running tests for Bootstrap");
+    SDL_threadID main = SDL_ThreadID();
+
+    // Ordering of main and worker tasks
+    {
+        TaskTrace trace;
+        std::shared_ptr<Bootstrap> graph = Bootstrap::alloc(2);
+        graph->addMainTask("scene",  [&] { trace.mark("scene"); }, {"shaders","assets","audio"});
+        graph->addWorkerTask("config", [&] { SDL_Delay(5); trace.mark("config"); });
+        graph->addWorkerTask("audio",  [&] { trace.mark("audio"); });
+        graph->addMainTask("shaders",  [&] { trace.mark("shaders"); }, {"config"});
+        graph->addWorkerTask("assets", [&] { trace.mark("assets"); }, {"config"});
+        graph->addLazyTask("editor", [&] { trace.mark("editor"); }, {"scene"});
+        graph->addLazyTask("console", [&] { trace.mark("console"); }, {"editor"});
+
+        CUAssertAlwaysLog(graph->run(), "Bootstrap failed to run a well-formed graph");
+        CUAssertAlwaysLog(trace.size() == 5, "Bootstrap ran %zu startup tasks, not 5", trace.size());
+        checkBefore(trace, "config", "shaders");
+        checkBefore(trace, "config", "assets");
+        checkBefore(trace, "shaders", "scene");
+        checkBefore(trace, "assets", "scene");
+        checkBefore(trace, "audio", "scene");
+        CUAssertAlwaysLog(trace.thread("shaders") == main && trace.thread("scene") == main,
+                          "Main tasks did not run on the main thread");
+        CUAssertAlwaysLog(graph->isComplete("scene"), "Startup task 'scene' is not complete");
+        CUAssertAlwaysLog(graph->getElapsedMicros() > 0, "Bootstrap did not time the startup");
+
+        // Lazy tasks (and their lazy dependencies) run once, on demand
+        CUAssertAlwaysLog(!graph->isComplete("editor") && !graph->isComplete("console"),
+                          "Bootstrap ran a lazy task at startup");
+        CUAssertAlwaysLog(graph->require("console"), "Bootstrap failed to run a lazy task");
+        CUAssertAlwaysLog(graph->isComplete("editor") && graph->isComplete("console"),
+                          "Bootstrap did not complete the lazy tasks");
+        checkBefore(trace, "editor", "console");
+        CUAssertAlwaysLog(graph->require("console") && graph->require("editor"),
+                          "Bootstrap failed to require a completed task");
+        CUAssertAlwaysLog(trace.count("editor") == 1 && trace.count("console") == 1,
+                          "Bootstrap ran a lazy task more than once");
+        CUAssertAlwaysLog(graph->getTimeline()->size() == 7, "Bootstrap timeline is missing tasks");
+    }
+
+    // Malformed graphs run nothing
+    {
+        TaskTrace trace;
+        std::shared_ptr<Bootstrap> graph = Bootstrap::alloc(2);
+        graph->addWorkerTask("free", [&] { trace.mark("free"); });
+        graph->addMainTask("first",  [&] { trace.mark("first"); },  {"second"});
+        graph->addWorkerTask("second", [&] { trace.mark("second"); }, {"third"});
+        graph->addMainTask("third",  [&] { trace.mark("third"); },  {"first"});
+        CUAssertAlwaysLog(!graph->run(), "Bootstrap ran a graph with a cycle");
+        CUAssertAlwaysLog(trace.size() == 0, "Bootstrap ran tasks of a graph with a cycle");
+
+        graph = Bootstrap::alloc(2);
+        graph->addMainTask("orphan", [&] { trace.mark("orphan"); }, {"missing"});
+        CUAssertAlwaysLog(!graph->run(), "Bootstrap ran a graph with a missing dependency");
+
+        graph = Bootstrap::alloc(2);
+        graph->addLazyTask("lazy", [&] { trace.mark("lazy"); });
+        graph->addMainTask("eager", [&] { trace.mark("eager"); }, {"lazy"});
+        CUAssertAlwaysLog(!graph->run(), "Bootstrap ran a startup task depending on a lazy one");
+
+        graph = Bootstrap::alloc(2);
+        graph->addLazyTask("left",  [&] { trace.mark("left"); },  {"right"});
+        graph->addLazyTask("right", [&] { trace.mark("right"); }, {"left"});
+        CUAssertAlwaysLog(!graph->run(), "Bootstrap ran a graph with a lazy cycle");
+        CUAssertAlwaysLog(trace.size() == 0, "Bootstrap ran tasks of a malformed graph");
+    }
+
+    // Lazy tasks added (and required) while the startup tasks run
+    {
+        const int CHAIN = 256;
+        const int BUSY  = 64;
+        std::atomic<int> busy(0);
+        std::atomic<int> chained(0);
+        std::atomic<int> late(0);
+
+        std::shared_ptr<Bootstrap> graph = Bootstrap::alloc(3);
+        Bootstrap* ptr = graph.get();
+        for(int ii = 0; ii < BUSY; ii++) {
+            std::string name = "busy"+std::to_string(ii);
+            if (ii % 2) {
+                graph->addWorkerTask(name, [&] { busy++; });
+            } else {
+                graph->addMainTask(name, [&] { busy++; });
+            }
+        }
+
+        // Each lazy task depends on the one before it
+        graph->addWorkerTask("spawn", [&, ptr] {
+            for(int ii = 0; ii < CHAIN; ii++) {
+                std::vector<std::string> depends;
+                if (ii > 0) {
+                    depends.push_back("chain"+std::to_string(ii-1));
+                }
+                ptr->addLazyTask("chain"+std::to_string(ii), [&] { chained++; }, depends);
+            }
+        });
+
+        // Grows the graph while the main thread requires the chain
+        graph->addWorkerTask("grow", [&, ptr] {
+            for(int ii = 0; ii < CHAIN; ii++) {
+                ptr->addLazyTask("late"+std::to_string(ii), [&] { late++; });
+            }
+        }, {"spawn"});
+        graph->addMainTask("consume", [&, ptr] {
+            CUAssertAlwaysLog(ptr->require("chain"+std::to_string(CHAIN-1)),
+                              "Bootstrap failed to run a lazy chain during startup");
+        }, {"spawn"});
+
+        CUAssertAlwaysLog(graph->run(), "Bootstrap failed to run a growing graph");
+        CUAssertAlwaysLog(busy == BUSY, "Bootstrap ran %d of %d startup tasks", (int)busy, BUSY);
+        CUAssertAlwaysLog(chained == CHAIN, "Bootstrap ran %d of %d chained tasks", (int)chained, CHAIN);
+        CUAssertAlwaysLog(late == 0, "Bootstrap ran a lazy task that was not required");
+        for(int ii = 0; ii < CHAIN; ii++) {
+            CUAssertAlwaysLog(graph->require("late"+std::to_string(ii)),
+                              "Bootstrap failed to run late task %d", ii);
+        }
+        CUAssertAlwaysLog(late == CHAIN, "Bootstrap ran %d of %d late tasks", (int)late, CHAIN);
+        CUAssertAlwaysLog(chained == CHAIN, "Bootstrap reran a chained task");
+    }
+}
+
+#pragma mark -
+#pragma mark Master Test
+/**
+ * Master unit test that invokes all others in this module.
+ *
+ * These unit tests do not need an OpenGL context.
+ */
+void cugl::utilUnitTest() {
+    testBootstrap();
+}
@@ -9,11 +9,21 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string>
+#include <cstring>
 #include <sstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <cugl/cugl.h>
 
 #include "TCUMathTest.h"
 #include "TCU2DTest.h"
+#include "TCUPhysicsTest.h"
+#include "TCUScene2Test.h"
+#include "TCURenderTest.h"
+#include "TCUUtilTest.h"
 
 #include <Accelerate/Accelerate.h>
 
@@ -132,6 +142,76 @@ void testBinary() {
 
 }
 
+/**
+ * Round-trips typed arrays through raw, compressed, and asynchronous streams
+ *
+ * Each mode also writes a large float array to compare throughput.
+ */
+void testBinaryStream() {
+    CULog("Testing Binary Streams");
+    const size_t length = 100000;
+    std::vector<Sint16> shorts(length);
+    std::vector<Uint32> words(length);
+    std::vector<double> doubles(length);
+    for(size_t ii = 0; ii < length; ii++) {
+        shorts[ii]  = (Sint16)(ii % 301)-150;
+        words[ii]   = (Uint32)(ii*2654435761U) % 1024;
+        doubles[ii] = (ii % 17)*0.25;
+    }
+    
+    const char* names[3] = { "raw", "compressed", "async" };
+    for(int mode = 0; mode < 3; mode++) {
+        std::shared_ptr<cugl::BinaryWriter> writer;
+        writer = cugl::BinaryWriter::alloc("stream.b",65536,mode > 0,mode == 2);
+        CUAssertAlwaysLog(writer != nullptr, "Could not open stream.b");
+        writer->writeUint32(0xCAFEF00D);
+        writer->write(shorts.data(),length-1,1);
+        writer->write('x');
+        writer->write(words.data(),length);
+        writer->write(doubles.data(),length);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t ii = 0; ii < 16; ii++) {
+            writer->write(doubles.data(),length);
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        writer->close();
+        auto end = std::chrono::high_resolution_clock::now();
+        
+        std::shared_ptr<cugl::BinaryReader> reader = cugl::BinaryReader::alloc("stream.b",65536);
+        CUAssertAlwaysLog(reader->isCompressed() == (mode > 0), "Compression was not detected");
+        std::vector<Sint16> shorts2(length);
+        std::vector<Uint32> words2(length);
+        std::vector<double> doubles2(length);
+        CUAssertAlwaysLog(reader->readUint32() == 0xCAFEF00D, "Header mismatch in %s mode",names[mode]);
+        CUAssertAlwaysLog(reader->read(shorts2.data(),length-1) == length-1, "Short read in %s mode",names[mode]);
+        CUAssertAlwaysLog(reader->readChar() == 'x', "Char mismatch in %s mode",names[mode]);
+        CUAssertAlwaysLog(reader->read(words2.data(),length) == length, "Short read in %s mode",names[mode]);
+        CUAssertAlwaysLog(reader->read(doubles2.data(),length) == length, "Short read in %s mode",names[mode]);
+        for(size_t ii = 0; ii < length-1; ii++) {
+            CUAssertAlwaysLog(shorts2[ii] == shorts[ii+1], "Short %zu mismatch in %s mode",ii,names[mode]);
+        }
+        CUAssertAlwaysLog(words2 == words, "Word mismatch in %s mode",names[mode]);
+        CUAssertAlwaysLog(doubles2 == doubles, "Double mismatch in %s mode",names[mode]);
+        
+        unsigned int tail = (unsigned int)(16*length*sizeof(double));
+        CUAssertAlwaysLog(reader->ready(tail), "Too little data left in %s mode",names[mode]);
+        CUAssertAlwaysLog(!reader->ready(tail+1), "Too much data left in %s mode",names[mode]);
+        for(size_t ii = 0; ii < 16; ii++) {
+            CUAssertAlwaysLog(reader->read(doubles2.data(),length) == length, "Short read in %s mode",names[mode]);
+        }
+        CUAssertAlwaysLog(!reader->ready(), "Trailing data in %s mode",names[mode]);
+        auto finish = std::chrono::high_resolution_clock::now();
+        reader->close();
+        
+        double writes = std::chrono::duration<double, std::milli>(middle-start).count();
+        double closes = std::chrono::duration<double, std::milli>(end-middle).count();
+        double reads  = std::chrono::duration<double, std::milli>(finish-end).count();
+        CULog("Stream %s: writes %.2fms, close %.2fms, reads %.2fms",names[mode],writes,closes,reads);
+    }
+    CULog("Binary stream tests complete");
+}
+
 class Item {
 protected:
     int _value;
@@ -170,6 +250,509 @@ void testThread() {
     pool = nullptr;
 }
 
+void testThreadPriority() {
+    CULog("Testing Thread Priority");
+    std::shared_ptr<cugl::ThreadPool> pool = cugl::ThreadPool::alloc(1);
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<bool> gate(false);
+    std::atomic<bool> started(false);
+    std::atomic<int> done(0);
+    auto record = [&](int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(value);
+        done++;
+    };
+    
+    // Hold the only worker until everything is queued
+    pool->addTask([&] {
+        started = true;
+        while (!gate.load()) {
+            std::this_thread::yield();
+        }
+        done++;
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    pool->addTask([&] { record(1); });
+    pool->addTask([&] { record(2); }, 5);
+    pool->addTask([&] { record(3); }, -1);
+    pool->addTask([&] { record(4); }, 5);
+    pool->addTask([&] {
+        // Follow up tasks inherit the priority 3, and so beat record(5)
+        CUAssertAlwaysLog(pool->getActivePriority() == 3, "Active priority is wrong");
+        pool->addTask([&] { record(7); });
+        record(6);
+    }, 3);
+    pool->addTask([&] { record(5); });
+    gate = true;
+    while (done.load() < 8) {
+        std::this_thread::yield();
+    }
+    
+    std::vector<int> expected = {2,4,6,7,1,5,3};
+    CUAssertAlwaysLog(order == expected, "Tasks ran out of priority order");
+    CUAssertAlwaysLog(pool->getActivePriority() == 0, "Main thread has a task priority");
+    pool = nullptr;
+    CULog("Thread priority tests complete");
+}
+
+/**
+ * Returns an audio player for a mono sine wave segment
+ *
+ * @param frames    The length of the segment
+ * @param freq      The frequency of the sine wave
+ */
+std::shared_ptr<cugl::audio::AudioPlayer> sineSegment(Uint32 frames, float freq) {
+    std::shared_ptr<cugl::AudioSample> sample = cugl::AudioSample::alloc(1,48000,frames);
+    float* data = sample->getBuffer();
+    for(Uint32 ii = 0; ii < frames; ii++) {
+        data[ii] = sinf(2*M_PI*freq*ii/48000.0f);
+    }
+    return cugl::audio::AudioPlayer::alloc(sample);
+}
+
+void testScheduler() {
+    CULog("Testing Scheduler");
+    cugl::AudioDevices::start(512);
+    const Uint32 block = 512;
+    std::shared_ptr<cugl::audio::AudioScheduler> scheduler = cugl::audio::AudioScheduler::alloc(1,48000);
+
+    // Segments scheduled bar-by-bar, with a gap before the second
+    const Uint32 bar = 700;
+    std::shared_ptr<cugl::audio::AudioPlayer> stem1 = sineSegment(bar,440);
+    std::shared_ptr<cugl::audio::AudioPlayer> stem2 = sineSegment(bar-100,660);
+    std::shared_ptr<cugl::audio::AudioPlayer> stem3 = sineSegment(bar,880);
+    scheduler->schedule(stem1,37);
+    scheduler->schedule(stem2,37+bar);
+    scheduler->schedule(stem3,37+2*bar);
+    
+    std::vector<float> output(4*block);
+    for(Uint32 ii = 0; ii < 4; ii++) {
+        scheduler->read(output.data()+ii*block,block);
+    }
+    CUAssertAlwaysLog(scheduler->getClock() == 4*block, "Scheduler clock is wrong");
+    for(Uint32 ii = 0; ii < 37; ii++) {
+        CUAssertAlwaysLog(output[ii] == 0, "Frame %d is not silent",ii);
+    }
+    float* data = stem1->getSource()->getBuffer();
+    for(Uint32 ii = 0; ii < bar; ii++) {
+        CUAssertAlwaysLog(output[37+ii] == data[ii], "Frame %d of stem 1 is wrong",ii);
+    }
+    data = stem2->getSource()->getBuffer();
+    for(Uint32 ii = 0; ii < bar-100; ii++) {
+        CUAssertAlwaysLog(output[37+bar+ii] == data[ii], "Frame %d of stem 2 is wrong",ii);
+    }
+    for(Uint32 ii = bar-100; ii < bar; ii++) {
+        CUAssertAlwaysLog(output[37+bar+ii] == 0, "Gap frame %d is not silent",ii);
+    }
+    data = stem3->getSource()->getBuffer();
+    for(Uint32 ii = 0; ii+37+2*bar < 4*block; ii++) {
+        CUAssertAlwaysLog(output[37+2*bar+ii] == data[ii], "Frame %d of stem 3 is wrong",ii);
+    }
+    
+    // Mark and replay a queued sequence
+    scheduler->clear();
+    scheduler->read(output.data(),block);
+    Uint64 clock = scheduler->getClock();
+    scheduler->schedule(sineSegment(bar,440),clock+block+13);
+    scheduler->append(sineSegment(bar,550));
+    scheduler->mark();
+    for(Uint32 ii = 0; ii < 4; ii++) {
+        scheduler->read(output.data()+ii*block,block);
+    }
+    CUAssertAlwaysLog(scheduler->getPosition() == 4*block, "Mark position is wrong");
+    scheduler->reset();
+    std::vector<float> replay(4*block);
+    for(Uint32 ii = 0; ii < 4; ii++) {
+        scheduler->read(replay.data()+ii*block,block);
+    }
+    for(Uint32 ii = 0; ii < 4*block; ii++) {
+        CUAssertAlwaysLog(output[ii] == replay[ii], "Replay frame %d is wrong",ii);
+    }
+    scheduler->unmark();
+    
+    scheduler = nullptr;
+    cugl::AudioDevices::stop();
+    CULog("Scheduler tests complete");
+}
+
+void testAudioStress() {
+    CULog("Testing Audio Stress");
+    cugl::AudioDevices::start(512);
+    const Uint32 block = 512;
+    const Uint32 reads = 2000;
+    std::shared_ptr<cugl::audio::AudioPlayer> player = sineSegment(reads*block,440);
+    std::shared_ptr<cugl::audio::AudioFader> fader = cugl::audio::AudioFader::alloc(player);
+    std::shared_ptr<cugl::audio::AudioPanner> panner = cugl::audio::AudioPanner::alloc(2,1,48000);
+    panner->attach(fader);
+    
+    // Hammer the fade and pan settings from a second thread
+    std::atomic<bool> running(true);
+    std::thread hammer([&] {
+        Uint32 step = 0;
+        while (running.load()) {
+            switch (step++ % 6) {
+                case 0:
+                    fader->fadeIn(0.01);
+                    break;
+                case 1:
+                    fader->fadeOut(0.02,true);
+                    break;
+                case 2:
+                    fader->fadePause(0.005,0.005);
+                    break;
+                case 3:
+                    fader->resume();
+                    break;
+                case 4:
+                    fader->reset();
+                    break;
+                default:
+                    fader->isFadeIn();
+                    fader->isFadeOut();
+                    fader->completed();
+                    break;
+            }
+            float pan = (step % 100)/100.0f;
+            panner->setPan(0,0,1-pan);
+            panner->setPan(0,1,pan);
+            std::this_thread::yield();
+        }
+    });
+    
+    // Time each read as if it were an audio callback
+    std::vector<float> output(2*block);
+    double mintime = 1e9, maxtime = 0, total = 0, square = 0;
+    for(Uint32 ii = 0; ii < reads; ii++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        panner->read(output.data(),block);
+        auto end = std::chrono::high_resolution_clock::now();
+        double micros = std::chrono::duration<double, std::micro>(end-start).count();
+        mintime = std::min(mintime,micros);
+        maxtime = std::max(maxtime,micros);
+        total  += micros;
+        square += micros*micros;
+        for(Uint32 jj = 0; jj < 2*block; jj++) {
+            CUAssertAlwaysLog(std::isfinite(output[jj]) && std::fabs(output[jj]) <= 1.0f,
+                              "Read %d sample %d is out of range",ii,jj);
+        }
+    }
+    running.store(false);
+    hammer.join();
+    
+    double mean = total/reads;
+    double jitter = std::sqrt(std::max(square/reads-mean*mean,0.0));
+    CULog("Callback time: min %.2fus, max %.2fus, mean %.2fus, jitter %.2fus",
+          mintime,maxtime,mean,jitter);
+    
+    panner->detach();
+    panner = nullptr;
+    fader = nullptr;
+    player = nullptr;
+    cugl::AudioDevices::stop();
+    CULog("Audio stress tests complete");
+}
+
+
+/**
+ * Checks the memory accounting, and that steady-state loops do not allocate
+ *
+ * The statistics are written to memory.json in the save directory.
+ */
+void testMemory() {
+    CULog("Testing Memory Tracking");
+    if (!cugl::MemoryTracker::isEnabled()) {
+        CULog("Memory tracking is compiled out of release builds (define CU_MEMORY_TRACKING to enable it)");
+    }
+    
+    // Allocations are charged to the tag that made them
+    cugl::MemoryTracker::Stats before = cugl::MemoryTracker::getStats(cugl::MemoryTracker::Tag::JSON);
+    std::shared_ptr<cugl::JsonValue> json;
+    json = cugl::JsonValue::allocWithJson("{\"a\": [1, 2, 3], \"b\": {\"c\": \"text\"}}");
+    cugl::MemoryTracker::Stats after = cugl::MemoryTracker::getStats(cugl::MemoryTracker::Tag::JSON);
+    if (cugl::MemoryTracker::isEnabled()) {
+        CUAssertAlwaysLog(after.liveBytes > before.liveBytes, "JSON parsing was not tracked");
+        CUAssertAlwaysLog(after.totalCount > before.totalCount, "JSON parsing was not tracked");
+    }
+    json = nullptr;
+    
+    // Math kernels
+    Uint64 start = cugl::MemoryTracker::getThreadAllocations();
+    cugl::Mat4 matrix = cugl::Mat4::IDENTITY;
+    cugl::Vec3 point(1,2,3);
+    for(int ii = 0; ii < 10000; ii++) {
+        matrix.rotateZ(0.001f);
+        matrix.translate(0.5f,0.25f,0);
+        point = matrix.transform(point);
+        point.normalize();
+    }
+    CUAssertAlwaysLog(cugl::MemoryTracker::getThreadAllocations() == start,
+                      "Math loop allocated memory");
+    
+    // Compression and checksums into existing buffers
+    std::vector<Uint8> input(16384);
+    for(size_t ii = 0; ii < input.size(); ii++) {
+        input[ii] = (Uint8)(ii % 61);
+    }
+    std::vector<Uint8> packed(cugl::packtool::bound(input.size()));
+    std::vector<Uint8> output(input.size());
+    start = cugl::MemoryTracker::getThreadAllocations();
+    Uint32 checksum = 0;
+    for(int ii = 0; ii < 100; ii++) {
+        size_t size = cugl::packtool::encode(input.data(),input.size(),packed.data(),packed.size());
+        cugl::packtool::decode(packed.data(),size,output.data(),output.size());
+        checksum = cugl::packtool::crc32(output.data(),output.size(),checksum);
+    }
+    CUAssertAlwaysLog(cugl::MemoryTracker::getThreadAllocations() == start,
+                      "Compression loop allocated memory");
+    CUAssertAlwaysLog(output == input, "Compression round trip failed");
+    
+    // Audio graph reads once warmed up
+    cugl::AudioDevices::start(512);
+    const Uint32 block = 512;
+    std::shared_ptr<cugl::audio::AudioPlayer> player = sineSegment(200*block,440);
+    std::shared_ptr<cugl::audio::AudioFader> fader = cugl::audio::AudioFader::alloc(player);
+    std::shared_ptr<cugl::audio::AudioPanner> panner = cugl::audio::AudioPanner::alloc(2,1,48000);
+    panner->attach(fader);
+    std::vector<float> buffer(2*block);
+    for(int ii = 0; ii < 4; ii++) {
+        panner->read(buffer.data(),block);
+    }
+    fader->fadeIn(0.1);
+    start = cugl::MemoryTracker::getThreadAllocations();
+    for(int ii = 0; ii < 100; ii++) {
+        panner->read(buffer.data(),block);
+    }
+    CUAssertAlwaysLog(cugl::MemoryTracker::getThreadAllocations() == start,
+                      "Audio reads allocated memory");
+    panner->detach();
+    panner = nullptr;
+    fader = nullptr;
+    player = nullptr;
+    cugl::AudioDevices::stop();
+    
+    cugl::MemoryTracker::Stats totals = cugl::MemoryTracker::getTotals();
+    CULog("Live heap: %lld bytes in %lld allocations, GPU estimate: %lld bytes",
+          (long long)totals.liveBytes,(long long)totals.liveCount,(long long)totals.gpuBytes);
+    CUAssertAlwaysLog(cugl::MemoryTracker::dump("memory.json"), "Could not write memory.json");
+    CULog("Memory tracking tests complete");
+}
+
+
+/**
+ * A font that exposes its atlas internals to the tests
+ */
+class FontProbe : public cugl::Font {
+public:
+    /**
+     * Returns the atlas cell of each glyph, in rasterization order
+     *
+     * @return the atlas cell of each glyph, in rasterization order
+     */
+    std::vector<cugl::Rect> getCells() const {
+        std::vector<cugl::Rect> result;
+        for(auto it = _glyphset.begin(); it != _glyphset.end(); ++it) {
+            result.push_back(findGlyph(*it)->bounds);
+        }
+        return result;
+    }
+    
+    /**
+     * Returns the atlas surface, before it is converted to a texture
+     *
+     * @return the atlas surface, before it is converted to a texture
+     */
+    SDL_Surface* getSurface() const { return _surface; }
+    
+    /**
+     * Rasterizes every glyph again on the calling thread
+     */
+    void rasterizeSerial() {
+        rasterizeGlyphs(_data, 0, _glyphset.size());
+    }
+    
+    /**
+     * Returns the metrics of a glyph, measured by TrueType without any table
+     *
+     * @param thechar   The character to measure
+     *
+     * @return the metrics of a glyph, measured by TrueType without any table
+     */
+    Metrics referenceMetrics(Uint32 thechar) const {
+        return computeMetrics(thechar);
+    }
+    
+    /**
+     * Returns the kerning of a pair, measured by TrueType without any cache
+     *
+     * @param a The first character
+     * @param b The second character
+     *
+     * @return the kerning of a pair, measured by TrueType without any cache
+     */
+    int referenceKerning(Uint32 a, Uint32 b) const {
+        return computeKerning(a,b);
+    }
+};
+
+/**
+ * Returns the UTF8 encoding of every character in the font (up to 0xFFFF)
+ *
+ * @param font  The font to query (it should not have an atlas)
+ */
+std::string fontCharset(const std::shared_ptr<cugl::Font>& font) {
+    std::string result;
+    for(Uint32 ii = 32; ii < 0xFFFF; ii++) {
+        if ((ii >= 0xD800 && ii < 0xE000) || !font->hasGlyph(ii)) {
+            continue;
+        } else if (ii < 0x80) {
+            result.push_back((char)ii);
+        } else if (ii < 0x800) {
+            result.push_back((char)(0xC0 | (ii >> 6)));
+            result.push_back((char)(0x80 | (ii & 0x3F)));
+        } else {
+            result.push_back((char)(0xE0 | (ii >> 12)));
+            result.push_back((char)(0x80 | ((ii >> 6) & 0x3F)));
+            result.push_back((char)(0x80 | (ii & 0x3F)));
+        }
+    }
+    return result;
+}
+
+/**
+ * Checks the packing and parallel rasterization of a font atlas
+ *
+ * @param path  The path to a TrueType font file
+ */
+void testFontAtlas(const std::string path) {
+    CULog("Testing Font Atlas");
+    std::shared_ptr<FontProbe> font = std::make_shared<FontProbe>();
+    bool loaded = font->init(path,64);
+    CUAssertAlwaysLog(loaded, "Could not load %s",path.c_str());
+    std::string charset = fontCharset(font);
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    bool built = font->buildAtlasAsync(charset);
+    auto middle = std::chrono::high_resolution_clock::now();
+    
+    CUAssertAlwaysLog(built, "Could not build the atlas");
+    
+    // Every cell is inside the atlas, and clear of the 2-patch and each other
+    SDL_Surface* surface = font->getSurface();
+    std::vector<cugl::Rect> cells = font->getCells();
+    double area = 0;
+    for(size_t ii = 0; ii < cells.size(); ii++) {
+        const cugl::Rect& cell = cells[ii];
+        CUAssertAlwaysLog(cell.origin.x >= 0 && cell.origin.y >= 0 &&
+                          cell.getMaxX() <= surface->w && cell.getMaxY() <= surface->h,
+                          "Glyph cell %zu is outside the atlas",ii);
+        CUAssertAlwaysLog(cell.origin.x >= 2 || cell.origin.y >= 2,
+                          "Glyph cell %zu overlaps the 2-patch",ii);
+        for(size_t jj = 0; jj < ii; jj++) {
+            const cugl::Rect& other = cells[jj];
+            bool apart = (cell.getMaxX() <= other.origin.x || other.getMaxX() <= cell.origin.x ||
+                          cell.getMaxY() <= other.origin.y || other.getMaxY() <= cell.origin.y);
+            CUAssertAlwaysLog(apart, "Glyph cells %zu and %zu overlap",jj,ii);
+        }
+        area += cell.size.width*cell.size.height;
+    }
+    
+    // The threaded rasterization matches a serial one
+    size_t bytes = (size_t)surface->pitch*surface->h;
+    std::vector<Uint8> parallel((Uint8*)surface->pixels,(Uint8*)surface->pixels+bytes);
+    std::memset(surface->pixels, 0, bytes);
+    auto serial = std::chrono::high_resolution_clock::now();
+    font->rasterizeSerial();
+    auto end = std::chrono::high_resolution_clock::now();
+    int pixel = surface->format->BytesPerPixel;
+    for(size_t ii = 0; ii < cells.size(); ii++) {
+        int x = (int)cells[ii].origin.x;
+        int y = (int)cells[ii].origin.y;
+        size_t width = (size_t)cells[ii].size.width*pixel;
+        for(int row = 0; row < (int)cells[ii].size.height; row++) {
+            size_t offset = (size_t)(y+row)*surface->pitch+x*pixel;
+            CUAssertAlwaysLog(std::memcmp(parallel.data()+offset, (Uint8*)surface->pixels+offset, width) == 0,
+                              "Glyph cell %zu differs from the serial rasterization",ii);
+        }
+    }
+    
+    double build = std::chrono::duration<double, std::milli>(middle-start).count();
+    double single = std::chrono::duration<double, std::milli>(end-serial).count();
+    CULog("Packed %zu glyphs in a %dx%d atlas (%.0f%% occupied)",cells.size(),surface->w,surface->h,
+          100*area/((double)surface->w*surface->h));
+    CULog("Atlas build %.2fms, serial rasterization alone %.2fms",build,single);
+    font = nullptr;
+    CULog("Font atlas tests complete");
+}
+
+/**
+ * Compares text measurement against nested hash maps of the same data
+ *
+ * @param path  The path to a TrueType font file
+ */
+void testFontMeasure(const std::string path) {
+    CULog("Testing Font Measurement");
+    std::shared_ptr<FontProbe> font = std::make_shared<FontProbe>();
+    bool loaded = font->init(path,24);
+    CUAssertAlwaysLog(loaded, "Could not load %s",path.c_str());
+    bool built = font->buildAtlas();
+    CUAssertAlwaysLog(built, "Could not build the atlas");
+    
+    // The reference tables, as the font used to store them, measured directly
+    std::unordered_map<Uint32, cugl::Font::Metrics> sizes;
+    std::unordered_map<Uint32, std::unordered_map<Uint32, int> > kerning;
+    for(Uint32 ii = 32; ii < 127; ii++) {
+        if (font->hasGlyph(ii)) {
+            cugl::Font::Metrics expect = font->referenceMetrics(ii);
+            cugl::Font::Metrics actual = font->getMetrics(ii);
+            CUAssertAlwaysLog(actual.advance == expect.advance && actual.minx == expect.minx &&
+                              actual.maxx == expect.maxx && actual.miny == expect.miny &&
+                              actual.maxy == expect.maxy, "Glyph %u has the wrong metrics",ii);
+            sizes.emplace(ii,expect);
+        }
+    }
+    for(auto it = sizes.begin(); it != sizes.end(); ++it) {
+        for(auto jt = sizes.begin(); jt != sizes.end(); ++jt) {
+            int expect = font->referenceKerning(it->first,jt->first);
+            CUAssertAlwaysLog((int)font->getKerning(it->first,jt->first) == expect,
+                              "Pair (%u,%u) has the wrong kerning",it->first,jt->first);
+            kerning[it->first][jt->first] = expect;
+        }
+    }
+    
+    std::string text = "The quick brown fox jumps over the lazy dog. AVAWAY To, Ty; 0123456789";
+    const Uint32 rounds = 100000;
+    float expected = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(Uint32 ii = 0; ii < rounds; ii++) {
+        expected = 0;
+        for(size_t jj = 0; jj < text.size(); jj++) {
+            auto glyph = sizes.find((Uint32)text[jj]);
+            if (glyph != sizes.end()) {
+                if (jj > 0) {
+                    expected -= kerning[(Uint32)text[jj-1]][(Uint32)text[jj]];
+                }
+                expected += glyph->second.advance;
+            }
+        }
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    float actual = 0;
+    for(Uint32 ii = 0; ii < rounds; ii++) {
+        actual = font->getSize(text,false).width;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    CUAssertAlwaysLog(actual == expected, "Measured width %f does not match %f",actual,expected);
+    
+    double mapped = std::chrono::duration<double, std::milli>(middle-start).count();
+    double tabled = std::chrono::duration<double, std::milli>(end-middle).count();
+    CULog("Measured %u strings: hash maps %.2fms, glyph tables %.2fms",rounds,mapped,tabled);
+    font = nullptr;
+    CULog("Font measurement tests complete");
+}
+
 
 int main(int argc, char * argv[]) {
     cugl::Application app;
@@ -196,11 +779,22 @@ int main(int argc, char * argv[]) {
 #endif
     
     cugl::mathUnitTest();
+    cugl::physicsUnitTest();
+    cugl::utilUnitTest();
 
     //cugl::sceneUnitTest();
+    cugl::renderUnitTest();
+    cugl::scene2UnitTest();
     //testBinary();
+    testBinaryStream();
     //testFree();
     //testThread();
+    testThreadPriority();
+    testScheduler();
+    testAudioStress();
+    testMemory();
+    testFontAtlas("fonts/Lato-Regular.ttf");
+    testFontMeasure("fonts/Lato-Regular.ttf");
     
     app.quit();
     app.onShutdown();
@@ -0,0 +1,509 @@
+//
+//  CUBootstrap.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a dependency graph for application start-up.  Most
+//  of the work done in Application#onStartup (opening the audio device,
+//  compiling shaders, attaching asset loaders, parsing JSON) is independent.
+//  Rather than doing it all serially, you register each piece as a named task
+//  with its dependencies, and this class runs independent tasks concurrently.
+//  Tasks that need the OpenGL context are run on the main thread, while the
+//  rest are farmed out to a small thread pool.
+//
+//  Tasks may also be lazy.  A lazy task is not run at start-up; instead it is
+//  run on the first call to require().  This is for subsystems that are
+//  rarely used, and should not delay the first animation frame.
+//
+//  Every task is timed, and the resulting timeline can be logged or exported
+//  in the Chrome trace event format for profiling.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/4/21
+//
+#include <cugl/util/CUBootstrap.h>
+#include <cugl/assets/CUJsonValue.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+
+using namespace cugl;
+
+/**
+ * Returns the microseconds since the given timestamp
+ *
+ * @param launch    The reference timestamp
+ *
+ * @return the microseconds since the given timestamp
+ */
+static Uint64 micros_since(const Timestamp& launch) {
+    Timestamp now;
+    return now.ellapsedMicros(launch);
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this start-up graph.
+ *
+ * A disposed graph can be safely reinitialized.  It is unsafe to call this
+ * method while the graph is running.
+ */
+void Bootstrap::dispose() {
+    _workers = nullptr;
+    _tasks.clear();
+    _index.clear();
+    _ready.clear();
+    _threads = 0;
+    _remaining = 0;
+    _launched  = false;
+    _mainThread = 0;
+    _elapsed = 0;
+}
+
+/**
+ * Initializes a start-up graph with the given number of worker threads.
+ *
+ * @param threads   The number of threads for worker tasks
+ *
+ * @return true if the graph is initialized properly, false otherwise.
+ */
+bool Bootstrap::init(Uint32 threads) {
+    _threads = threads;
+    _launch.mark();
+    return true;
+}
+
+#pragma mark -
+#pragma mark Task Registration
+/**
+ * Adds a startup task to run on the main thread.
+ *
+ * The task will not start until all of the named dependencies are
+ * complete.  Task names must be unique.  Tasks may be added in any order,
+ * but must all be added before the graph is run.
+ *
+ * @param name      The task name
+ * @param task      The task body
+ * @param depends   The names of the tasks this task depends on
+ */
+void Bootstrap::addMainTask(const std::string& name, const std::function<void()>& task,
+                            const std::vector<std::string>& depends) {
+    addTask(name, task, depends, false, false);
+}
+
+/**
+ * Adds a startup task to run in the thread pool.
+ *
+ * The task will not start until all of the named dependencies are
+ * complete.  Task names must be unique.  Tasks may be added in any order,
+ * but must all be added before the graph is run.
+ *
+ * Worker tasks may not access the OpenGL context.
+ *
+ * @param name      The task name
+ * @param task      The task body
+ * @param depends   The names of the tasks this task depends on
+ */
+void Bootstrap::addWorkerTask(const std::string& name, const std::function<void()>& task,
+                              const std::vector<std::string>& depends) {
+    addTask(name, task, depends, true, false);
+}
+
+/**
+ * Adds a lazy task that is deferred until required.
+ *
+ * This task is not run by {@link run}.  It is executed, at most once, by
+ * the first call to {@link require} for this task or any lazy task that
+ * depends on it.  It executes on the thread calling require.
+ *
+ * @param name      The task name
+ * @param task      The task body
+ * @param depends   The names of the tasks this task depends on
+ */
+void Bootstrap::addLazyTask(const std::string& name, const std::function<void()>& task,
+                            const std::vector<std::string>& depends) {
+    addTask(name, task, depends, false, true);
+}
+
+/**
+ * Adds a task to this graph.
+ *
+ * Task names must be unique.
+ *
+ * @param name      The task name
+ * @param task      The task body
+ * @param depends   The names of the tasks this task depends on
+ * @param worker    Whether the task runs in the thread pool
+ * @param lazy      Whether the task is deferred until required
+ */
+void Bootstrap::addTask(const std::string& name, const std::function<void()>& task,
+                        const std::vector<std::string>& depends, bool worker, bool lazy) {
+    std::unique_lock<std::mutex> lk(_mutex);
+    CUAssertLog(!_launched || lazy, "Startup task '%s' added after launch", name.c_str());
+    if (_index.find(name) != _index.end()) {
+        CUAssertLog(false, "Task '%s' is already defined", name.c_str());
+        return;
+    }
+
+    Task node;
+    node.name  = name;
+    node.work  = task;
+    node.depends = depends;
+    node.waiting = 0;
+    node.worker = worker;
+    node.lazy   = lazy;
+    node.state  = State::PENDING;
+    node.begin  = 0;
+    node.end    = 0;
+    node.thread = 0;
+    _index[name] = _tasks.size();
+    _tasks.push_back(node);
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns true if the dependency graph is well-formed.
+ *
+ * The graph is well-formed if every dependency exists, no startup task
+ * depends on a lazy task, and there are no cycles.  This method also
+ * computes the dependents of each task.
+ *
+ * @return true if the dependency graph is well-formed.
+ */
+bool Bootstrap::resolve() {
+    for(auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+        it->dependents.clear();
+        it->waiting = 0;
+    }
+
+    for(size_t ii = 0; ii < _tasks.size(); ii++) {
+        Task* task = &_tasks[ii];
+        for(auto jt = task->depends.begin(); jt != task->depends.end(); ++jt) {
+            auto kt = _index.find(*jt);
+            if (kt == _index.end()) {
+                CULogError("Task '%s' depends on unknown task '%s'",
+                           task->name.c_str(), jt->c_str());
+                return false;
+            } else if (!task->lazy && _tasks[kt->second].lazy) {
+                CULogError("Startup task '%s' depends on lazy task '%s'",
+                           task->name.c_str(), jt->c_str());
+                return false;
+            }
+            _tasks[kt->second].dependents.push_back(ii);
+            task->waiting++;
+        }
+    }
+
+    // Kahn's algorithm to detect cycles
+    std::vector<size_t> counts;
+    std::vector<size_t> queue;
+    counts.reserve(_tasks.size());
+    for(size_t ii = 0; ii < _tasks.size(); ii++) {
+        counts.push_back(_tasks[ii].waiting);
+        if (counts.back() == 0) {
+            queue.push_back(ii);
+        }
+    }
+
+    size_t visited = 0;
+    while (visited < queue.size()) {
+        const Task& task = _tasks[queue[visited++]];
+        for(auto it = task.dependents.begin(); it != task.dependents.end(); ++it) {
+            if (--counts[*it] == 0) {
+                queue.push_back(*it);
+            }
+        }
+    }
+
+    if (visited < _tasks.size()) {
+        for(size_t ii = 0; ii < _tasks.size(); ii++) {
+            if (counts[ii] > 0) {
+                CULogError("Task '%s' is part of a dependency cycle", _tasks[ii].name.c_str());
+                break;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Dispatches the given task, which has no more pending dependencies.
+ *
+ * Worker tasks are sent to the thread pool, and main tasks are added to
+ * the ready queue.  This method assumes that the mutex is held.
+ *
+ * @param index The task to dispatch
+ */
+void Bootstrap::dispatch(size_t index) {
+    if (_tasks[index].worker && _workers != nullptr) {
+        _workers->addTask([=](void) { this->execute(index); });
+    } else {
+        _ready.push_back(index);
+        _cond.notify_all();
+    }
+}
+
+/**
+ * Executes the given task and records its timing.
+ *
+ * Once the task completes, any dependents are dispatched.
+ *
+ * @param index The task to execute
+ */
+void Bootstrap::execute(size_t index) {
+    // Lazy tasks may be added while this runs.  The deque does not move its
+    // elements when it grows, but the lookup itself must hold the lock.
+    Task* task = nullptr;
+    Uint64 thread = (Uint64)SDL_ThreadID();
+    {
+        std::unique_lock<std::mutex> lk(_mutex);
+        task = &_tasks[index];
+        task->state  = State::RUNNING;
+        task->thread = thread;
+    }
+
+    Uint64 begin = micros_since(_launch);
+    if (task->work) {
+        task->work();
+    }
+    Uint64 end = micros_since(_launch);
+
+    std::unique_lock<std::mutex> lk(_mutex);
+    task->begin = begin;
+    task->end   = end;
+    task->state = State::COMPLETE;
+    if (!task->lazy) {
+        _remaining--;
+        for(auto it = task->dependents.begin(); it != task->dependents.end(); ++it) {
+            Task* next = &_tasks[*it];
+            if (!next->lazy && --(next->waiting) == 0) {
+                dispatch(*it);
+            }
+        }
+    }
+    _cond.notify_all();
+}
+
+#pragma mark -
+#pragma mark Execution
+/**
+ * Runs all startup tasks, returning when they are complete.
+ *
+ * This method must be called on the main thread.  The calling thread
+ * executes the main tasks as they become ready, and blocks while it waits
+ * on worker tasks.  The thread pool is shut down when this method returns.
+ *
+ * If the graph is malformed (a missing dependency, a startup task depending
+ * on a lazy task, or a cycle), this method runs nothing and returns false.
+ *
+ * @return true if all startup tasks were run.
+ */
+bool Bootstrap::run() {
+    std::unique_lock<std::mutex> lk(_mutex);
+    if (_launched) {
+        CUAssertLog(false, "This start-up graph has already been run");
+        return false;
+    } else if (!resolve()) {
+        return false;
+    }
+
+    if (_threads > 0) {
+        _workers = ThreadPool::alloc(_threads);
+    }
+    _mainThread = (Uint64)SDL_ThreadID();
+    _launched = true;
+    _launch.mark();
+
+    _remaining = 0;
+    for(auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+        if (!it->lazy) {
+            _remaining++;
+        }
+    }
+    for(size_t ii = 0; ii < _tasks.size(); ii++) {
+        if (!_tasks[ii].lazy && _tasks[ii].waiting == 0) {
+            dispatch(ii);
+        }
+    }
+
+    // Work on the main thread until everything is done
+    while (_remaining > 0) {
+        if (_ready.empty()) {
+            _cond.wait(lk);
+        } else {
+            size_t index = _ready.front();
+            _ready.pop_front();
+            lk.unlock();
+            execute(index);
+            lk.lock();
+        }
+    }
+    _elapsed = micros_since(_launch);
+    lk.unlock();
+
+    // Joins the worker threads
+    _workers = nullptr;
+    return true;
+}
+
+/**
+ * Ensures the named task has completed, executing it if necessary.
+ *
+ * For a startup task, this blocks until the task is complete (it is an
+ * error to call this before {@link run}).  For a lazy task, this runs the
+ * task (and any lazy dependencies) on the first call, and does nothing
+ * on subsequent calls.
+ *
+ * @param name  The task name
+ *
+ * @return true if the task has completed.
+ */
+bool Bootstrap::require(const std::string& name) {
+    std::unique_lock<std::mutex> lk(_mutex);
+    auto it = _index.find(name);
+    if (it == _index.end()) {
+        CUAssertLog(false, "Task '%s' is not defined", name.c_str());
+        return false;
+    }
+
+    size_t index = it->second;
+    Task* task = &_tasks[index];
+    if (task->state == State::COMPLETE) {
+        return true;
+    } else if (!task->lazy) {
+        if (!_launched) {
+            CUAssertLog(false, "Startup task '%s' required before launch", name.c_str());
+            return false;
+        }
+        _cond.wait(lk, [&] { return _tasks[index].state == State::COMPLETE; });
+        return true;
+    } else if (task->state == State::RUNNING) {
+        if (task->thread == (Uint64)SDL_ThreadID()) {
+            CUAssertLog(false, "Task '%s' is part of a dependency cycle", name.c_str());
+            return false;
+        }
+        _cond.wait(lk, [&] { return _tasks[index].state != State::RUNNING; });
+        return _tasks[index].state == State::COMPLETE;
+    }
+
+    // Claim the task so no one else runs it
+    task->state  = State::RUNNING;
+    task->thread = (Uint64)SDL_ThreadID();
+    std::vector<std::string> depends = task->depends;
+    lk.unlock();
+
+    for(auto jt = depends.begin(); jt != depends.end(); ++jt) {
+        if (!require(*jt)) {
+            lk.lock();
+            _tasks[index].state = State::PENDING;
+            _cond.notify_all();
+            return false;
+        }
+    }
+
+    execute(index);
+    return true;
+}
+
+/**
+ * Returns true if the named task has completed.
+ *
+ * @param name  The task name
+ *
+ * @return true if the named task has completed.
+ */
+bool Bootstrap::isComplete(const std::string& name) {
+    std::unique_lock<std::mutex> lk(_mutex);
+    auto it = _index.find(name);
+    return it != _index.end() && _tasks[it->second].state == State::COMPLETE;
+}
+
+#pragma mark -
+#pragma mark Profiling
+/**
+ * Returns the timeline of all completed tasks in the Chrome trace format.
+ *
+ * The result is a JSON array of complete ("X") events, with times in
+ * microseconds relative to the call to {@link run}.  Write it to a file
+ * with {@link JsonWriter} and open it in chrome://tracing (or Perfetto)
+ * to see which tasks overlapped.
+ *
+ * @return the timeline of all completed tasks in the Chrome trace format.
+ */
+std::shared_ptr<JsonValue> Bootstrap::getTimeline() {
+    std::shared_ptr<JsonValue> result = JsonValue::allocArray();
+    std::unique_lock<std::mutex> lk(_mutex);
+    for(auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+        if (it->state != State::COMPLETE) {
+            continue;
+        }
+        std::shared_ptr<JsonValue> event = JsonValue::allocObject();
+        event->appendValue("name", it->name);
+        event->appendValue("cat",  it->lazy ? "lazy" : "startup");
+        event->appendValue("ph",   "X");
+        event->appendValue("ts",   (long)it->begin);
+        event->appendValue("dur",  (long)(it->end-it->begin));
+        event->appendValue("pid",  0L);
+        event->appendValue("tid",  (long)it->thread);
+        result->appendChild(event);
+    }
+    return result;
+}
+
+/**
+ * Logs the timeline of all completed tasks.
+ *
+ * Tasks are listed in the order they started, with their start time,
+ * duration, and whether they ran on the main thread.
+ */
+void Bootstrap::logTimeline() {
+    std::unique_lock<std::mutex> lk(_mutex);
+    std::vector<const Task*> order;
+    for(auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+        if (it->state == State::COMPLETE) {
+            order.push_back(&(*it));
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const Task* a, const Task* b) {
+        return a->begin < b->begin;
+    });
+
+    CULog("Startup completed in %.2f ms", _elapsed/1000.0);
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        const Task* task = *it;
+        CULog("  %-24s start %8.2f ms  duration %8.2f ms  (%s)", task->name.c_str(),
+              task->begin/1000.0, (task->end-task->begin)/1000.0,
+              task->lazy ? "lazy" : (task->thread == _mainThread ? "main" : "worker"));
+    }
+}
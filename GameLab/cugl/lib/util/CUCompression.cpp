@@ -0,0 +1,373 @@
+//
+//  CUCompression.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a fast block compression codec and a CRC32 checksum.
+//  The codec is a byte-oriented LZ77 variant in the style of LZ4.  It trades
+//  compression ratio for speed, and is intended for large save and replay
+//  files that are written during gameplay.  It is not compatible with LZ4
+//  or any other external format.
+//
+//  Like the filetool and strtool modules, this is a collection of namespaced
+//  functions.  All functions are thread safe.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/util/CUCompression.h>
+#include <cstring>
+
+/** The shortest match worth encoding */
+#define MIN_MATCH       4
+/** The largest distance a match may refer back */
+#define MAX_OFFSET      65535
+/** The log of the number of entries in the match finder */
+#define HASH_LOG        12
+/** The number of final bytes that are always literals */
+#define LAST_LITERALS   5
+/** The number of final bytes where no match may start */
+#define MATCH_MARGIN    12
+/** The shift that speeds up the search over data that does not compress */
+#define SKIP_TRIGGER    6
+
+namespace cugl {
+namespace packtool {
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the four bytes at the given position.
+ *
+ * @param data  The data to read
+ *
+ * @return the four bytes at the given position.
+ */
+static inline Uint32 read32(const Uint8* data) {
+    Uint32 result;
+    std::memcpy(&result, data, sizeof(Uint32));
+    return result;
+}
+
+/**
+ * Returns the match finder slot for the given four bytes.
+ *
+ * @param sequence  The four bytes to hash
+ *
+ * @return the match finder slot for the given four bytes.
+ */
+static inline Uint32 hash_slot(Uint32 sequence) {
+    return (sequence*2654435761U) >> (32-HASH_LOG);
+}
+
+/**
+ * Writes an extended length, returning false if it does not fit.
+ *
+ * Lengths of 15 or more are stored as 15 in the token, and the remainder
+ * as a sequence of bytes ending in one less than 255.
+ *
+ * @param length    The remainder of the length
+ * @param output    The output buffer
+ * @param pos       The position in the output buffer
+ * @param capacity  The capacity of the output buffer
+ *
+ * @return true if the length was written
+ */
+static inline bool write_length(size_t length, Uint8* output, size_t& pos, size_t capacity) {
+    while (length >= 255) {
+        if (pos >= capacity) {
+            return false;
+        }
+        output[pos++] = 255;
+        length -= 255;
+    }
+    if (pos >= capacity) {
+        return false;
+    }
+    output[pos++] = (Uint8)length;
+    return true;
+}
+
+/**
+ * Reads an extended length, returning false if the input ends first.
+ *
+ * @param input     The input buffer
+ * @param pos       The position in the input buffer
+ * @param length    The length of the input buffer
+ * @param value     The length to extend
+ *
+ * @return true if the length was read
+ */
+static inline bool read_length(const Uint8* input, size_t& pos, size_t length, size_t& value) {
+    Uint8 byte;
+    do {
+        if (pos >= length) {
+            return false;
+        }
+        byte = input[pos++];
+        value += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/**
+ * Writes a token, returning false if it does not fit.
+ *
+ * A token with a match length of 0 has no match, and is the final token.
+ *
+ * @param literals  The start of the literals
+ * @param litsize   The number of literals
+ * @param offset    The distance back to the match
+ * @param matchsize The number of matched bytes (0 for none)
+ * @param output    The output buffer
+ * @param pos       The position in the output buffer
+ * @param capacity  The capacity of the output buffer
+ *
+ * @return true if the token was written
+ */
+static bool write_token(const Uint8* literals, size_t litsize, size_t offset, size_t matchsize,
+                        Uint8* output, size_t& pos, size_t capacity) {
+    if (pos >= capacity) {
+        return false;
+    }
+
+    size_t extra = matchsize ? matchsize-MIN_MATCH : 0;
+    size_t token = pos++;
+    output[token] = (Uint8)((litsize < 15 ? litsize : 15) << 4);
+    output[token] |= (Uint8)(extra < 15 ? extra : 15);
+    if (litsize >= 15 && !write_length(litsize-15, output, pos, capacity)) {
+        return false;
+    }
+
+    if (pos+litsize > capacity) {
+        return false;
+    }
+    if (litsize > 0) {
+        std::memcpy(output+pos, literals, litsize);
+        pos += litsize;
+    }
+    if (matchsize == 0) {
+        return true;
+    }
+
+    if (pos+2 > capacity) {
+        return false;
+    }
+    output[pos++] = (Uint8)(offset & 0xff);
+    output[pos++] = (Uint8)(offset >> 8);
+    if (extra >= 15 && !write_length(extra-15, output, pos, capacity)) {
+        return false;
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Compression
+/**
+ * Returns the maximum size of the encoding of length bytes.
+ *
+ * Data that does not compress grows slightly when encoded.  An output
+ * buffer of this size is always large enough for {@link encode}.
+ *
+ * @param length    The number of bytes to encode
+ *
+ * @return the maximum size of the encoding of length bytes.
+ */
+size_t bound(size_t length) {
+    return length+length/255+16;
+}
+
+/**
+ * Returns the number of bytes written when encoding the input.
+ *
+ * The output buffer must have room for capacity bytes.  If the
+ * encoding does not fit, this function returns 0 and the contents
+ * of the output buffer are undefined.
+ *
+ * @param input     The data to encode
+ * @param length    The number of bytes to encode
+ * @param output    The buffer to store the encoding
+ * @param capacity  The capacity of the output buffer
+ *
+ * @return the number of bytes written when encoding the input.
+ */
+size_t encode(const Uint8* input, size_t length, Uint8* output, size_t capacity) {
+    size_t pos = 0;
+    size_t anchor = 0;
+
+    if (length > MATCH_MARGIN) {
+        Sint32 table[1 << HASH_LOG];
+        std::memset(table, -1, sizeof(table));
+
+        size_t limit = length-MATCH_MARGIN;
+        size_t stop  = length-LAST_LITERALS;
+        size_t ii = 0;
+        while (ii < limit) {
+            Uint32 sequence = read32(input+ii);
+            Uint32 slot = hash_slot(sequence);
+            Sint32 ref = table[slot];
+            table[slot] = (Sint32)ii;
+
+            if (ref < 0 || ii-ref > MAX_OFFSET || read32(input+ref) != sequence) {
+                // Search faster the longer we go without a match
+                ii += 1+((ii-anchor) >> SKIP_TRIGGER);
+                continue;
+            }
+
+            size_t match = MIN_MATCH;
+            while (ii+match < stop && input[ref+match] == input[ii+match]) {
+                match++;
+            }
+            if (!write_token(input+anchor, ii-anchor, ii-ref, match, output, pos, capacity)) {
+                return 0;
+            }
+            ii += match;
+            anchor = ii;
+
+            // Remember a position inside the match for the next search
+            if (ii < limit) {
+                table[hash_slot(read32(input+ii-2))] = (Sint32)(ii-2);
+            }
+        }
+    }
+
+    if (!write_token(input+anchor, length-anchor, 0, 0, output, pos, capacity)) {
+        return 0;
+    }
+    return pos;
+}
+
+/**
+ * Returns the number of bytes written when decoding the input.
+ *
+ * The output buffer must have room for capacity bytes.  This function
+ * checks every token against the bounds of both buffers.  If the
+ * input is corrupt or does not fit, this function returns 0 and the
+ * contents of the output buffer are undefined.
+ *
+ * @param input     The data to decode
+ * @param length    The number of bytes to decode
+ * @param output    The buffer to store the decoded data
+ * @param capacity  The capacity of the output buffer
+ *
+ * @return the number of bytes written when decoding the input.
+ */
+size_t decode(const Uint8* input, size_t length, Uint8* output, size_t capacity) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < length) {
+        Uint8 token = input[ip++];
+        size_t litsize = token >> 4;
+        if (litsize == 15 && !read_length(input, ip, length, litsize)) {
+            return 0;
+        }
+        if (ip+litsize > length || op+litsize > capacity) {
+            return 0;
+        }
+        std::memcpy(output+op, input+ip, litsize);
+        ip += litsize;
+        op += litsize;
+
+        // The final token has no match
+        if (ip == length) {
+            return op;
+        }
+
+        if (ip+2 > length) {
+            return 0;
+        }
+        size_t offset = input[ip] | (input[ip+1] << 8);
+        ip += 2;
+        size_t matchsize = token & 15;
+        if (matchsize == 15 && !read_length(input, ip, length, matchsize)) {
+            return 0;
+        }
+        matchsize += MIN_MATCH;
+        if (offset == 0 || offset > op || op+matchsize > capacity) {
+            return 0;
+        }
+
+        const Uint8* source = output+op-offset;
+        if (offset >= matchsize) {
+            std::memcpy(output+op, source, matchsize);
+        } else {
+            // Overlapping matches repeat a pattern
+            for(size_t jj = 0; jj < matchsize; jj++) {
+                output[op+jj] = source[jj];
+            }
+        }
+        op += matchsize;
+    }
+    return 0;
+}
+
+#pragma mark -
+#pragma mark Checksums
+/**
+ * Returns the CRC32 checksum of the given data.
+ *
+ * This is the standard (zlib) CRC32.  To checksum data in several
+ * pieces, pass the result for each piece as the initial value of
+ * the next one.
+ *
+ * @param data      The data to checksum
+ * @param length    The number of bytes to checksum
+ * @param crc       The checksum of any preceding data
+ *
+ * @return the CRC32 checksum of the given data.
+ */
+Uint32 crc32(const Uint8* data, size_t length, Uint32 crc) {
+    // Four tables let us process a word at a time
+    static Uint32 tables[4][256];
+    static bool initialized = [] {
+        for(Uint32 ii = 0; ii < 256; ii++) {
+            Uint32 value = ii;
+            for(int jj = 0; jj < 8; jj++) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320U : value >> 1;
+            }
+            tables[0][ii] = value;
+        }
+        for(Uint32 ii = 0; ii < 256; ii++) {
+            for(int jj = 1; jj < 4; jj++) {
+                Uint32 prev = tables[jj-1][ii];
+                tables[jj][ii] = (prev >> 8) ^ tables[0][prev & 0xff];
+            }
+        }
+        return true;
+    }();
+    (void)initialized;
+
+    crc = ~crc;
+    size_t ii = 0;
+    for(; ii+4 <= length; ii += 4) {
+        crc ^= (Uint32)data[ii] | ((Uint32)data[ii+1] << 8) |
+               ((Uint32)data[ii+2] << 16) | ((Uint32)data[ii+3] << 24);
+        crc = tables[3][crc & 0xff] ^ tables[2][(crc >> 8) & 0xff] ^
+              tables[1][(crc >> 16) & 0xff] ^ tables[0][crc >> 24];
+    }
+    for(; ii < length; ii++) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ data[ii]) & 0xff];
+    }
+    return ~crc;
+}
+
+}
+}
@@ -0,0 +1,563 @@
+//
+//  CUMemoryTracker.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides tagged memory accounting for the engine subsystems.
+//  When enabled it replaces the global operator new and delete, so that
+//  every heap allocation is charged to the tag active on the allocating
+//  thread.  Tags are set with scopes, and the engine tags its own rendering,
+//  geometry, JSON, audio and physics code.  The render classes also register
+//  estimates for the GPU storage of their textures and buffers.
+//
+//  Tracking is on in debug builds (those without NDEBUG) and compiled out
+//  of release builds.  Define CU_MEMORY_TRACKING to force it on in a release
+//  build, or CU_NO_MEMORY_TRACKING to turn it off in a debug build.  Either
+//  must be defined for the whole build (both the engine and the game).  When
+//  tracking is off, the methods of this class still exist, but they do
+//  nothing and all statistics are zero.
+//
+//  This class is a static class, as there is only one heap.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 3/9/21
+//
+#include <cugl/util/CUMemoryTracker.h>
+#include <cugl/assets/CUJsonValue.h>
+#include <cugl/io/CUJsonWriter.h>
+#include <cugl/util/CUDebug.h>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+using namespace cugl;
+
+/** The tag names, in the order of the enumeration */
+static const char* TAG_NAMES[MemoryTracker::TAG_COUNT] = {
+    "general", "game", "render", "geometry", "json",
+    "audio", "physics", "texture", "buffer"
+};
+
+#if defined (CU_MEMORY_TRACKING)
+
+/** A marker to detect frees of memory we did not allocate */
+#define ALLOC_MAGIC 0xC06A110C
+
+/**
+ * The header stored before every tracked allocation.
+ */
+typedef struct {
+    /** The size of the allocation requested */
+    size_t size;
+    /** The tag charged for the allocation */
+    Uint32 tag;
+    /** The marker for a live allocation */
+    Uint32 magic;
+} AllocHeader;
+
+/** The header size, padded to preserve the alignment of malloc */
+#define HEADER_SIZE (((sizeof(AllocHeader)+alignof(std::max_align_t)-1)/alignof(std::max_align_t))*alignof(std::max_align_t))
+
+/**
+ * The counters for a single tag.
+ *
+ * These are static, so they are zeroed before any allocation happens.
+ */
+typedef struct {
+    /** The number of bytes currently allocated */
+    std::atomic<Sint64> liveBytes;
+    /** The number of allocations not yet freed */
+    std::atomic<Sint64> liveCount;
+    /** The largest value of liveBytes since the last reset */
+    std::atomic<Sint64> peakBytes;
+    /** The number of allocations since the program started */
+    std::atomic<Uint64> totalCount;
+    /** The number of bytes allocated since the program started */
+    std::atomic<Uint64> totalBytes;
+    /** The value of totalCount at the end of the last frame */
+    std::atomic<Uint64> frameMark;
+    /** The number of allocations in the last complete frame */
+    std::atomic<Uint64> frameCount;
+    /** The largest value of frameCount since the last reset */
+    std::atomic<Uint64> peakFrame;
+    /** The estimated GPU storage in bytes */
+    std::atomic<Sint64> gpuBytes;
+    /** The number of GPU resources */
+    std::atomic<Sint64> gpuCount;
+} TagCounters;
+
+/** The counters for each tag */
+static TagCounters _counters[MemoryTracker::TAG_COUNT];
+/** The number of frames completed */
+static std::atomic<Uint64> _frames;
+/** The active tag of each thread */
+static thread_local Uint32 _active;
+/** The number of allocations made by each thread */
+static thread_local Uint64 _allocations;
+
+/**
+ * Raises the given peak to the given value if it is larger.
+ *
+ * @param peak  The peak to update
+ * @param value The candidate value
+ */
+template <typename T>
+static inline void raise_peak(std::atomic<T>& peak, T value) {
+    T current = peak.load(std::memory_order_relaxed);
+    while (value > current &&
+           !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Returns a tracked block of the given size, or nullptr on failure.
+ *
+ * The block is charged to the active tag of the current thread.
+ *
+ * @param size  The number of bytes requested
+ *
+ * @return a tracked block of the given size, or nullptr on failure.
+ */
+static void* track_alloc(size_t size) {
+    void* block = std::malloc(size+HEADER_SIZE);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    AllocHeader* header = (AllocHeader*)block;
+    header->size  = size;
+    header->tag   = _active;
+    header->magic = ALLOC_MAGIC;
+
+    TagCounters& counter = _counters[header->tag];
+    Sint64 live = counter.liveBytes.fetch_add((Sint64)size, std::memory_order_relaxed)+(Sint64)size;
+    counter.liveCount.fetch_add(1, std::memory_order_relaxed);
+    counter.totalCount.fetch_add(1, std::memory_order_relaxed);
+    counter.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    raise_peak(counter.peakBytes, live);
+    _allocations++;
+    return (Uint8*)block+HEADER_SIZE;
+}
+
+/**
+ * Frees a tracked block, crediting the tag that allocated it.
+ *
+ * @param ptr   The block to free
+ */
+static void track_free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    AllocHeader* header = (AllocHeader*)((Uint8*)ptr-HEADER_SIZE);
+    assert(header->magic == ALLOC_MAGIC && "Freeing memory that was not allocated by new");
+    TagCounters& counter = _counters[header->tag];
+    counter.liveBytes.fetch_sub((Sint64)header->size, std::memory_order_relaxed);
+    counter.liveCount.fetch_sub(1, std::memory_order_relaxed);
+    header->magic = 0;
+    std::free(header);
+}
+
+/**
+ * Returns a tracked block of the given size, following the rules of new.
+ *
+ * On failure this calls the new handler until it succeeds, and throws
+ * std::bad_alloc if there is no handler.
+ *
+ * @param size  The number of bytes requested
+ *
+ * @return a tracked block of the given size.
+ */
+static void* track_new(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    void* result;
+    while ((result = track_alloc(size)) == nullptr) {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark Global Allocators
+// Over-aligned allocations use the default aligned operators, and are not tracked
+void* operator new(size_t size) {
+    return track_new(size);
+}
+
+void* operator new[](size_t size) {
+    return track_new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return track_alloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return track_alloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept {
+    track_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    track_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    track_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    track_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    track_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    track_free(ptr);
+}
+
+#endif
+
+#pragma mark -
+#pragma mark Tags
+/**
+ * Returns true if memory tracking is compiled into this build.
+ *
+ * @return true if memory tracking is compiled into this build.
+ */
+bool MemoryTracker::isEnabled() {
+#if defined (CU_MEMORY_TRACKING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Returns a string representation of the given tag.
+ *
+ * @param tag   The tag to name
+ *
+ * @return a string representation of the given tag.
+ */
+const char* MemoryTracker::getName(Tag tag) {
+    Uint32 index = (Uint32)tag;
+    return index < TAG_COUNT ? TAG_NAMES[index] : "unknown";
+}
+
+/**
+ * Returns the active tag of the current thread.
+ *
+ * @return the active tag of the current thread.
+ */
+MemoryTracker::Tag MemoryTracker::getTag() {
+#if defined (CU_MEMORY_TRACKING)
+    return (Tag)_active;
+#else
+    return Tag::GENERAL;
+#endif
+}
+
+/**
+ * Sets the active tag of the current thread, returning the previous one.
+ *
+ * @param tag   The tag to make active
+ *
+ * @return the previously active tag
+ */
+MemoryTracker::Tag MemoryTracker::setTag(Tag tag) {
+#if defined (CU_MEMORY_TRACKING)
+    Uint32 previous = _active;
+    _active = (Uint32)tag < TAG_COUNT ? (Uint32)tag : 0;
+    return (Tag)previous;
+#else
+    (void)tag;
+    return Tag::GENERAL;
+#endif
+}
+
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Returns the statistics for the given tag.
+ *
+ * @param tag   The tag to query
+ *
+ * @return the statistics for the given tag.
+ */
+MemoryTracker::Stats MemoryTracker::getStats(Tag tag) {
+    Stats result = {};
+#if defined (CU_MEMORY_TRACKING)
+    Uint32 index = (Uint32)tag;
+    if (index >= TAG_COUNT) {
+        return result;
+    }
+    const TagCounters& counter = _counters[index];
+    result.liveBytes  = counter.liveBytes.load(std::memory_order_relaxed);
+    result.liveCount  = counter.liveCount.load(std::memory_order_relaxed);
+    result.peakBytes  = counter.peakBytes.load(std::memory_order_relaxed);
+    result.totalCount = counter.totalCount.load(std::memory_order_relaxed);
+    result.totalBytes = counter.totalBytes.load(std::memory_order_relaxed);
+    result.frameCount = counter.frameCount.load(std::memory_order_relaxed);
+    result.peakFrame  = counter.peakFrame.load(std::memory_order_relaxed);
+    result.gpuBytes   = counter.gpuBytes.load(std::memory_order_relaxed);
+    result.gpuCount   = counter.gpuCount.load(std::memory_order_relaxed);
+#else
+    (void)tag;
+#endif
+    return result;
+}
+
+/**
+ * Returns the statistics summed over all tags.
+ *
+ * The peak values are the sums of the peaks for each tag.  Therefore,
+ * they are an upper bound on the true peaks.
+ *
+ * @return the statistics summed over all tags.
+ */
+MemoryTracker::Stats MemoryTracker::getTotals() {
+    Stats result = {};
+    for(Uint32 ii = 0; ii < TAG_COUNT; ii++) {
+        Stats stats = getStats((Tag)ii);
+        result.liveBytes  += stats.liveBytes;
+        result.liveCount  += stats.liveCount;
+        result.peakBytes  += stats.peakBytes;
+        result.totalCount += stats.totalCount;
+        result.totalBytes += stats.totalBytes;
+        result.frameCount += stats.frameCount;
+        result.peakFrame  += stats.peakFrame;
+        result.gpuBytes   += stats.gpuBytes;
+        result.gpuCount   += stats.gpuCount;
+    }
+    return result;
+}
+
+/**
+ * Returns the number of allocations made by the current thread.
+ *
+ * This value is intended for asserting that a loop does not allocate.
+ * Unlike the tag statistics, it is not affected by other threads.
+ *
+ * @return the number of allocations made by the current thread.
+ */
+Uint64 MemoryTracker::getThreadAllocations() {
+#if defined (CU_MEMORY_TRACKING)
+    return _allocations;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Returns the number of frames completed.
+ *
+ * @return the number of frames completed.
+ */
+Uint64 MemoryTracker::getFrames() {
+#if defined (CU_MEMORY_TRACKING)
+    return _frames.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Marks the end of an animation frame.
+ *
+ * This method records the number of allocations for each tag since the
+ * last call.  It is called by {@link Application} once per frame.
+ */
+void MemoryTracker::endFrame() {
+#if defined (CU_MEMORY_TRACKING)
+    for(Uint32 ii = 0; ii < TAG_COUNT; ii++) {
+        TagCounters& counter = _counters[ii];
+        Uint64 total = counter.totalCount.load(std::memory_order_relaxed);
+        Uint64 count = total-counter.frameMark.exchange(total, std::memory_order_relaxed);
+        counter.frameCount.store(count, std::memory_order_relaxed);
+        raise_peak(counter.peakFrame, count);
+    }
+    _frames.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+/**
+ * Resets the peak values of every tag to the current values.
+ */
+void MemoryTracker::resetPeaks() {
+#if defined (CU_MEMORY_TRACKING)
+    for(Uint32 ii = 0; ii < TAG_COUNT; ii++) {
+        TagCounters& counter = _counters[ii];
+        counter.peakBytes.store(counter.liveBytes.load(std::memory_order_relaxed),
+                                std::memory_order_relaxed);
+        counter.peakFrame.store(counter.frameCount.load(std::memory_order_relaxed),
+                                std::memory_order_relaxed);
+    }
+#endif
+}
+
+#pragma mark -
+#pragma mark GPU Resources
+/**
+ * Registers a GPU resource of the given size.
+ *
+ * You should use the macro CUMemoryAddResource instead of this method,
+ * so that the call is compiled out when tracking is disabled.
+ *
+ * @param tag   The tag for the resource
+ * @param bytes The estimated size of the resource
+ */
+void MemoryTracker::addResource(Tag tag, size_t bytes) {
+#if defined (CU_MEMORY_TRACKING)
+    TagCounters& counter = _counters[(Uint32)tag];
+    counter.gpuBytes.fetch_add((Sint64)bytes, std::memory_order_relaxed);
+    counter.gpuCount.fetch_add(1, std::memory_order_relaxed);
+#else
+    (void)tag;
+    (void)bytes;
+#endif
+}
+
+/**
+ * Unregisters a GPU resource of the given size.
+ *
+ * You should use the macro CUMemoryRemoveResource instead of this method,
+ * so that the call is compiled out when tracking is disabled.
+ *
+ * @param tag   The tag for the resource
+ * @param bytes The estimated size of the resource
+ */
+void MemoryTracker::removeResource(Tag tag, size_t bytes) {
+#if defined (CU_MEMORY_TRACKING)
+    TagCounters& counter = _counters[(Uint32)tag];
+    counter.gpuBytes.fetch_sub((Sint64)bytes, std::memory_order_relaxed);
+    counter.gpuCount.fetch_sub(1, std::memory_order_relaxed);
+#else
+    (void)tag;
+    (void)bytes;
+#endif
+}
+
+/**
+ * Changes the size of a registered GPU resource.
+ *
+ * You should use the macro CUMemoryResizeResource instead of this method,
+ * so that the call is compiled out when tracking is disabled.
+ *
+ * @param tag       The tag for the resource
+ * @param oldbytes  The previous estimated size of the resource
+ * @param newbytes  The new estimated size of the resource
+ */
+void MemoryTracker::resizeResource(Tag tag, size_t oldbytes, size_t newbytes) {
+#if defined (CU_MEMORY_TRACKING)
+    TagCounters& counter = _counters[(Uint32)tag];
+    counter.gpuBytes.fetch_add((Sint64)newbytes-(Sint64)oldbytes, std::memory_order_relaxed);
+#else
+    (void)tag;
+    (void)oldbytes;
+    (void)newbytes;
+#endif
+}
+
+#pragma mark -
+#pragma mark Reporting
+/**
+ * Returns a JSON object for the given statistics.
+ *
+ * @param stats The statistics to convert
+ *
+ * @return a JSON object for the given statistics.
+ */
+static std::shared_ptr<JsonValue> stats_to_json(const MemoryTracker::Stats& stats) {
+    std::shared_ptr<JsonValue> result = JsonValue::allocObject();
+    result->appendValue("live_bytes",  (long)stats.liveBytes);
+    result->appendValue("live_count",  (long)stats.liveCount);
+    result->appendValue("peak_bytes",  (long)stats.peakBytes);
+    result->appendValue("total_count", (long)stats.totalCount);
+    result->appendValue("total_bytes", (long)stats.totalBytes);
+    result->appendValue("frame_count", (long)stats.frameCount);
+    result->appendValue("peak_frame",  (long)stats.peakFrame);
+    result->appendValue("gpu_bytes",   (long)stats.gpuBytes);
+    result->appendValue("gpu_count",   (long)stats.gpuCount);
+    return result;
+}
+
+/**
+ * Returns a JSON representation of the current statistics.
+ *
+ * The JSON object has an entry for each tag, as well as the totals.
+ * Each entry is an object whose keys are the fields of {@link Stats}.
+ *
+ * @return a JSON representation of the current statistics.
+ */
+std::shared_ptr<JsonValue> MemoryTracker::toJson() {
+    // Take the snapshot before building the JSON changes it
+    Stats stats[TAG_COUNT];
+    for(Uint32 ii = 0; ii < TAG_COUNT; ii++) {
+        stats[ii] = getStats((Tag)ii);
+    }
+    Stats totals = getTotals();
+    Uint64 frames = getFrames();
+
+    std::shared_ptr<JsonValue> result = JsonValue::allocObject();
+    result->appendValue("enabled", isEnabled());
+    result->appendValue("frames", (long)frames);
+    result->appendChild("totals", stats_to_json(totals));
+    std::shared_ptr<JsonValue> tags = JsonValue::allocObject();
+    for(Uint32 ii = 0; ii < TAG_COUNT; ii++) {
+        tags->appendChild(TAG_NAMES[ii], stats_to_json(stats[ii]));
+    }
+    result->appendChild("tags", tags);
+    return result;
+}
+
+/**
+ * Returns true if the current statistics were written to the given file.
+ *
+ * The statistics are written with {@link JsonWriter}, so a relative path
+ * is placed in the application save directory.
+ *
+ * @param file  The path (absolute or relative) to the file
+ *
+ * @return true if the current statistics were written to the given file.
+ */
+bool MemoryTracker::dump(const std::string file) {
+    std::shared_ptr<JsonValue> json = toJson();
+    std::shared_ptr<JsonWriter> writer = JsonWriter::alloc(file);
+    if (writer == nullptr) {
+        CULogError("Could not write memory statistics to %s", file.c_str());
+        return false;
+    }
+    writer->writeJson(json);
+    writer->close();
+    return true;
+}
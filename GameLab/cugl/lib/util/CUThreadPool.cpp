@@ -6,6 +6,10 @@
 //  task is specified by a void function.  There are no guarantees about thread
 //  safety; that is responsibility of the author of each task.
 //
+//  Tasks may be given an optional priority.  Higher priority tasks are always
+//  assigned to a worker before lower priority ones, while tasks of the same
+//  priority are processed in the order they were added.
+//
 //  This code is largely inspired from the Cocos2d file AudioEngine.cpp, from
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
@@ -33,9 +37,15 @@
 //  Version: 11/29/16
 //
 #include <cugl/util/CUThreadPool.h>
+#include <algorithm>
 
 using namespace cugl;
 
+/** The thread pool owning the task on this thread (if any) */
+static thread_local const ThreadPool* _activePool = nullptr;
+/** The priority of the task executing on this thread */
+static thread_local int _activePriority = 0;
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -86,23 +96,7 @@ bool ThreadPool::init(int threads) {
  */
 void ThreadPool::threadFunc() {
     while (!_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            if (_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!_taskQueue.empty()) {
-                task = std::move(_taskQueue.front());
-                _taskQueue.pop();
-            } else {
-                _taskCondition.wait(lk);
-                continue;
-            }
-        }
-        // Perform the current task
-        task();
+        processTask();
     }
     _complete++;
 }
@@ -118,28 +112,47 @@ void ThreadPool::threadFunc() {
 int ThreadPool::sdlThreadFunc(void* ptr) {
     ThreadPool* self = (ThreadPool*)ptr;
     while (!self->_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(self->_queueMutex);
-            if (self->_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!self->_taskQueue.empty()) {
-                task = std::move(self->_taskQueue.front());
-                self->_taskQueue.pop();
-            } else {
-                self->_taskCondition.wait(lk);
-                continue;
-            }
-        }
-        // Perform the current task
-        task();
+        self->processTask();
     }
     self->_complete++;
     return 0;
 }
 
+/**
+ * Returns true if there was a task to process from the queue.
+ *
+ * This function pulls the highest priority task from the queue and then
+ * executes it outside of the lock.  If the queue is empty, it waits on
+ * the task condition variable instead.
+ *
+ * @return true if there was a task to process from the queue.
+ */
+bool ThreadPool::processTask() {
+    Task task;
+    {   // Lock for save queue access
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        if (_stop) {
+            return false;
+        }
+        // Pull the next task off the queue
+        if (!_taskQueue.empty()) {
+            std::pop_heap(_taskQueue.begin(), _taskQueue.end());
+            task = std::move(_taskQueue.back());
+            _taskQueue.pop_back();
+        } else {
+            _taskCondition.wait(lk);
+            return false;
+        }
+    }
+    
+    // Perform the current task
+    _activePool = this;
+    _activePriority = task.priority;
+    task.work();
+    _activePool = nullptr;
+    _activePriority = 0;
+    return true;
+}
 
 
 #pragma mark -
@@ -155,11 +168,47 @@ int ThreadPool::sdlThreadFunc(void* ptr) {
  * @param  task     the task function to add to the thread pool
  */
 void ThreadPool::addTask(const std::function<void()> &task){
+    addTask(task,getActivePriority());
+}
+
+/**
+ * Adds a task to the thread pool with the given priority.
+ *
+ * A task is a void returning function with no parameters.  If you need
+ * state in the task, you should use a method call for the state.  The task
+ * will not be executed immediately, but must wait for the first available
+ * worker.
+ *
+ * Tasks with a higher priority are assigned to a worker before any tasks
+ * of lower priority.  Tasks with the same priority are processed in the
+ * order they were added. Priorities may be negative.
+ *
+ * @param  task     the task function to add to the thread pool
+ * @param  priority the task priority
+ */
+void ThreadPool::addTask(const std::function<void()> &task, int priority) {
     std::unique_lock<std::mutex> lk(_queueMutex);
-    _taskQueue.emplace(task);
+    Task entry;
+    entry.work = task;
+    entry.priority = priority;
+    entry.order = _taskCount++;
+    _taskQueue.push_back(std::move(entry));
+    std::push_heap(_taskQueue.begin(), _taskQueue.end());
     _taskCondition.notify_one();
 }
 
+/**
+ * Returns the priority of the task executing on the current thread.
+ *
+ * If the current thread is not a worker of this thread pool, this method
+ * returns 0.
+ *
+ * @return the priority of the task executing on the current thread.
+ */
+int ThreadPool::getActivePriority() const {
+    return _activePool == this ? _activePriority : 0;
+}
+
 /**
  * Stop the thread pool, marking it for shut down.
  *
@@ -28,32 +28,43 @@ using namespace cugl;
  * causing the application to run.
  */
 void LabApp::onStartup() {
-    _assets = AssetManager::alloc();
-    _batch  = SpriteBatch::alloc();
-    auto cam = OrthographicCamera::alloc(getDisplaySize());
-    
-    // Start-up basic input
+    // Independent start-up work runs concurrently; GL work stays on this thread
+    std::shared_ptr<Bootstrap> boot = Bootstrap::alloc();
+    boot->addMainTask("shaders", [this]() {
+        // Reuse linked shaders from the previous launch
+        ShaderCache::start(getSaveDirectory());
+        _batch = SpriteBatch::alloc();
+    });
+    boot->addMainTask("input", []() {
 #ifdef CU_MOBILE
-    Input::activate<Touchscreen>();
-    Input::activate<Accelerometer>();
+        Input::activate<Touchscreen>();
+        Input::activate<Accelerometer>();
 #else
-    Input::activate<Mouse>();
-    Input::get<Mouse>()->setPointerAwareness(Mouse::PointerAwareness::DRAG);
-    Input::activate<Keyboard>();
+        Input::activate<Mouse>();
+        Input::get<Mouse>()->setPointerAwareness(Mouse::PointerAwareness::DRAG);
+        Input::activate<Keyboard>();
 #endif
+    });
+    boot->addWorkerTask("audio", []() {
+        AudioEngine::start();
+    });
+    boot->addWorkerTask("loaders", [this]() {
+        _assets = AssetManager::alloc();
+        _assets->attach<Texture>(TextureLoader::alloc()->getHook());
+        _assets->attach<Sound>(SoundLoader::alloc()->getHook());
+        _assets->attach<scene2::SceneNode>(Scene2Loader::alloc()->getHook());
+    });
+    boot->addMainTask("loading", [this]() {
+        // Create a "loading" screen
+        _loaded = false;
+        _loading.init(_assets);
 
-    _assets->attach<Texture>(TextureLoader::alloc()->getHook());
-    _assets->attach<Sound>(SoundLoader::alloc()->getHook());
-    _assets->attach<scene2::SceneNode>(Scene2Loader::alloc()->getHook());
+        // Queue up the other assets
+        _assets->loadDirectoryAsync("json/assets.json",nullptr);
+    }, {"loaders", "shaders"});
+    boot->run();
+    boot->logTimeline();
 
-    // Create a "loading" screen
-    _loaded = false;
-    _loading.init(_assets);
-    
-    // Queue up the other assets
-    _assets->loadDirectoryAsync("json/assets.json",nullptr);
-    
-    AudioEngine::start();
     Application::onStartup(); // YOU MUST END with call to parent
 }
 
@@ -84,6 +95,7 @@ void LabApp::onShutdown() {
 #endif
 
     AudioEngine::stop();
+    ShaderCache::stop();
     Application::onShutdown();  // YOU MUST END with call to parent
 }
 
@@ -135,12 +135,20 @@ void GameScene::update(float timestep) {
     _redController.readInput();
     _blueController.readInput();
     
+    // Sounds are not critical assets, so they may still be streaming in.
+    if (_redSound == nullptr) {
+        _redSound = _assets->get<Sound>("fusion");
+    }
+    if (_blueSound == nullptr) {
+        _blueSound = _assets->get<Sound>("laser");
+    }
+    
     // Move the photons forward, and add new ones if necessary.
-    if (_redController.didPressFire() && firePhoton(_redShip)) {
+    if (_redController.didPressFire() && firePhoton(_redShip) && _redSound != nullptr) {
         // The last argument is force=true.  It makes sure only one instance plays.
         AudioEngine::get()->play("redfire", _redSound, false, 1.0f, true);
     }
-    if (_blueController.didPressFire() && firePhoton(_blueShip)) {
+    if (_blueController.didPressFire() && firePhoton(_blueShip) && _blueSound != nullptr) {
         // The last argument is force=true.  It makes sure only one instance plays.
         AudioEngine::get()->play("bluefire", _blueSound, false, 1.0f, true);
     }
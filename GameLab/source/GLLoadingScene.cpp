@@ -90,13 +90,15 @@ void LoadingScene::dispose() {
 /**
  * The method called to update the game mode.
  *
- * This method updates the progress bar amount.
+ * This method updates the progress bar amount.  The game may start as soon
+ * as the critical assets are loaded; the remaining assets stream in during
+ * gameplay.
  *
  * @param timestep  The amount of time (in seconds) since the last frame
  */
 void LoadingScene::update(float progress) {
     if (_progress < 1) {
-        _progress = _assets->progress();
+        _progress = _assets->criticalProgress();
         if (_progress >= 1) {
             _progress = 1.0f;
             _bar->setVisible(false);